@@ -24,6 +24,7 @@ package org.bluezoo.gumdrop;
 import java.io.IOException;
 import java.net.SocketAddress;
 import java.nio.ByteBuffer;
+import java.nio.channels.FileChannel;
 
 import org.bluezoo.gumdrop.telemetry.TelemetryConfig;
 import org.bluezoo.gumdrop.telemetry.Trace;
@@ -64,6 +65,39 @@ public interface Endpoint {
      */
     void send(ByteBuffer data);
 
+    /**
+     * Sends a byte range of a regular file after any data already sent,
+     * without copying it through Java buffers where the transport can.
+     *
+     * <p>If this returns {@code false} nothing has been sent, the
+     * channel is still the caller's, and the caller should read the file
+     * and {@link #send} it instead. Otherwise the endpoint owns the
+     * channel and closes it once the range is written; data sent
+     * afterwards follows it, and an {@link #onWriteReady} callback fires
+     * once it has all been written. Open the channel off the
+     * SelectorLoop, since opening a file may block.
+     *
+     * <p>TCP endpoints use {@code sendfile(2)} when the connection is
+     * plaintext or its TLS records are sealed by the kernel.
+     *
+     * @param file a channel open for reading on the file to send
+     * @param position the offset of the first byte to send
+     * @param count the number of bytes to send
+     * @return true if the transport accepted the range
+     */
+    default boolean sendFile(FileChannel file, long position, long count) {
+        return false;
+    }
+
+    /**
+     * Returns whether {@link #sendFile} would accept a range now.
+     *
+     * @return true if file ranges can be sent directly
+     */
+    default boolean canSendFile() {
+        return false;
+    }
+
     // -- Lifecycle --
 
     /**
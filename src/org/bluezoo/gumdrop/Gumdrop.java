@@ -22,6 +22,8 @@
 package org.bluezoo.gumdrop;
 
 import java.io.File;
+import java.io.IOException;
+import java.nio.file.Path;
 import java.text.MessageFormat;
 import java.util.ArrayList;
 import java.util.Collection;
@@ -39,6 +41,7 @@ import java.util.logging.Logger;
 
 import org.bluezoo.gumdrop.dns.client.DNSResolver;
 import org.bluezoo.gumdrop.dns.client.HostsFile;
+import org.bluezoo.gumdrop.quic.QuicHandoff;
 
 /**
  * Central configuration and lifecycle manager for the Gumdrop server.
@@ -148,6 +151,15 @@ public class Gumdrop {
     private volatile long drainTimeoutMs =
             Long.getLong("gumdrop.drainTimeoutMs", DEFAULT_DRAIN_TIMEOUT_MS);
 
+    /**
+     * UNIX domain socket for graceful upgrades, or null. Set via the
+     * {@code gumdrop.upgradeSocket} system property (and, from
+     * {@link #main}, the {@code GUMDROP_UPGRADE_SOCKET} environment
+     * variable).
+     */
+    private volatile String upgradeSocket =
+            System.getProperty("gumdrop.upgradeSocket");
+
     // ─────────────────────────────────────────────────────────────────────────
     // Singleton access
     // ─────────────────────────────────────────────────────────────────────────
@@ -586,6 +598,18 @@ public class Gumdrop {
             loop.start();
         }
 
+        // Graceful upgrade: take over the QUIC sockets of a running
+        // server before any listener binds
+        String upgradePath = upgradeSocket;
+        if (upgradePath != null) {
+            try {
+                QuicHandoff.inherit(Path.of(upgradePath));
+            } catch (IOException | LinkageError e) {
+                LOGGER.log(Level.WARNING,
+                        "Cannot inherit QUIC sockets from " + upgradePath, e);
+            }
+        }
+
         // Start all registered services and collect their TCP listeners
         for (int i = 0; i < services.size(); i++) {
             Service service = (Service) services.get(i);
@@ -604,6 +628,10 @@ public class Gumdrop {
             }
         }
 
+        if (upgradePath != null) {
+            listenForUpgrade(upgradePath);
+        }
+
         // Start AcceptSelectorLoop if we have TCP listeners
         boolean hasTcpListeners = false;
         for (TCPListener listener : serverListeners) {
@@ -726,6 +754,9 @@ public class Gumdrop {
                 new ArrayList<TCPListener>(serverListeners)) {
             server.closeServerChannels();
         }
+        // QUIC listeners keep their sockets open, since a replacement
+        // process may be sharing them; their connections drain below if
+        // they were handed over, and are closed in phase 3 otherwise
 
         // ── Phase 2: drain in-flight connections (bounded) ──
         long drainTimeout = drainTimeoutMs;
@@ -781,6 +812,12 @@ public class Gumdrop {
             configurator = null;
         }
 
+        // Last, so that a replacement forwards QUIC packets to us
+        // until our connections are closed
+        if (upgradeSocket != null) {
+            QuicHandoff.close();
+        }
+
         started = false;
         draining = false;
 
@@ -831,9 +868,55 @@ public class Gumdrop {
         this.drainTimeoutMs = drainTimeoutMs;
     }
 
+    /**
+     * Returns the UNIX domain socket used for graceful upgrades.
+     *
+     * @return the socket path, or null if upgrades are disabled
+     */
+    public String getUpgradeSocket() {
+        return upgradeSocket;
+    }
+
+    /**
+     * Sets the UNIX domain socket used for graceful upgrades. Must be set
+     * before {@link #start()}.
+     *
+     * <p>When set, a starting server first connects to the socket and, if
+     * another server is listening there, inherits its QUIC sockets; that
+     * server then drains its QUIC connections (HTTP/3 sends GOAWAY) and
+     * shuts down, while the new one accepts every new connection. Once
+     * started, the server listens on the socket for its own replacement.
+     * See {@link QuicHandoff}.
+     *
+     * @param upgradeSocket the socket path, or null to disable upgrades
+     */
+    public void setUpgradeSocket(String upgradeSocket) {
+        this.upgradeSocket = upgradeSocket;
+    }
+
+    /**
+     * Listens for a replacement process, which triggers a graceful
+     * shutdown once it has taken over our QUIC sockets.
+     */
+    private void listenForUpgrade(String path) {
+        try {
+            QuicHandoff.listen(Path.of(path), new Runnable() {
+                @Override
+                public void run() {
+                    LOGGER.info("Replacement process started; shutting down");
+                    shutdown();
+                }
+            });
+        } catch (IOException | LinkageError e) {
+            LOGGER.log(Level.WARNING,
+                    "Cannot listen for upgrades on " + path, e);
+        }
+    }
+
     /**
      * Returns the total number of in-flight connections currently open across
-     * all TCP server listeners.
+     * all TCP server listeners, plus the QUIC connections still draining
+     * after a graceful upgrade.
      */
     private int activeServerConnectionCount() {
         int total = 0;
@@ -841,6 +924,9 @@ public class Gumdrop {
                 new ArrayList<TCPListener>(serverListeners)) {
             total += listener.getActiveConnectionCount();
         }
+        if (upgradeSocket != null) {
+            total += QuicHandoff.getDrainingConnectionCount();
+        }
         return total;
     }
 
@@ -1033,6 +1119,11 @@ public class Gumdrop {
             }
         }
 
+        String upgradeEnv = System.getenv("GUMDROP_UPGRADE_SOCKET");
+        if (upgradeEnv != null && !upgradeEnv.isEmpty()) {
+            gumdrop.setUpgradeSocket(upgradeEnv);
+        }
+
         // Start
         gumdrop.start();
 
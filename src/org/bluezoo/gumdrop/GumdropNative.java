@@ -22,6 +22,9 @@
 package org.bluezoo.gumdrop;
 
 import java.nio.ByteBuffer;
+import java.nio.channels.DatagramChannel;
+import java.nio.channels.FileChannel;
+import java.nio.channels.SocketChannel;
 
 /**
  * JNI bridge to the native {@code libgumdrop} shared library.
@@ -94,6 +97,21 @@ public final class GumdropNative {
     /** Optimistic ACK attack detected. */
     public static final int QUICHE_ERR_OPTIMISTIC_ACK_DETECTED = -22;
 
+    // ── QUIC path event types ──
+
+    /** A packet arrived on a path not seen before. */
+    public static final int QUICHE_PATH_EVENT_NEW = 0;
+    /** A path passed validation (RFC 9000 section 8.2). */
+    public static final int QUICHE_PATH_EVENT_VALIDATED = 1;
+    /** A path failed validation. */
+    public static final int QUICHE_PATH_EVENT_FAILED_VALIDATION = 2;
+    /** A path was abandoned. */
+    public static final int QUICHE_PATH_EVENT_CLOSED = 3;
+    /** A connection ID moved to a different path. */
+    public static final int QUICHE_PATH_EVENT_REUSED_SOURCE_CONNECTION_ID = 4;
+    /** The peer migrated its active path (RFC 9000 section 9). */
+    public static final int QUICHE_PATH_EVENT_PEER_MIGRATED = 5;
+
     /**
      * Returns a human-readable description for a quiche error code.
      *
@@ -189,6 +207,149 @@ public final class GumdropNative {
     public static native void ssl_ctx_set_verify_peer(long sslCtx,
                                                        boolean verify);
 
+    /**
+     * Installs a client session cache on the SSL_CTX holding up to
+     * {@code maxEntries} resumable sessions, one per SNI name. Each
+     * NewSessionTicket is stored in the serialized form accepted by
+     * {@link #quiche_conn_set_session}.
+     *
+     * @return 0 on success, -1 on error
+     */
+    public static native int ssl_ctx_enable_session_cache(long sslCtx,
+                                                           int maxEntries);
+
+    /**
+     * Removes and returns the cached session for a server name, or null.
+     * TLS 1.3 tickets are single-use (RFC 8446 appendix C.4).
+     */
+    public static native byte[] ssl_ctx_take_session(long sslCtx,
+                                                     String serverName);
+
+    /**
+     * Enables 0-RTT early data on the SSL_CTX.
+     * Maps to SSL_CTX_set_early_data_enabled() in BoringSSL.
+     */
+    public static native void ssl_ctx_set_early_data_enabled(long sslCtx,
+                                                             boolean enabled);
+
+    /**
+     * Replaces the session ticket key ring, installing the ticket key
+     * callback on first use. Keys are 80 bytes each (16-byte name,
+     * 32-byte HMAC key, 32-byte AES key); the first encrypts new tickets
+     * and all are accepted for decryption. At most 4 keys.
+     *
+     * @return 0 on success, -1 on error
+     */
+    public static native int ssl_ctx_set_ticket_keys(long sslCtx,
+                                                     byte[] keys);
+
+    /**
+     * Registers certificate compression algorithms (RFC 8879) with
+     * SSL_CTX_add_cert_compression_alg(). The bitmask has bit
+     * {@code id - 1} set for each algorithm ID (1 zlib, 2 brotli).
+     *
+     * @return 0 on success, -1 on error
+     */
+    public static native int ssl_ctx_enable_cert_compression(long sslCtx,
+                                                             int algorithms);
+
+    /**
+     * Returns the RFC 8879 algorithm ID with which this connection's
+     * certificate was compressed or decompressed, or 0 if it was not.
+     */
+    public static native int ssl_get_cert_compression(long ssl);
+
+    /**
+     * Receives completions of asynchronous private key operations.
+     */
+    public interface PrivateKeyListener {
+
+        /**
+         * Called on a native worker thread when the signature for a
+         * handshake is ready. The handshake resumes on the next
+         * {@link #quiche_conn_send} for the connection.
+         *
+         * @param ssl the SSL handle whose operation completed
+         */
+        void privateKeyOperationComplete(long ssl);
+
+    }
+
+    /**
+     * Takes a hold on the process-wide pool of native signing threads,
+     * growing it to the given size if it is smaller. Each successful
+     * call must be paired with {@link #private_key_pool_stop}.
+     *
+     * @param threads the number of worker threads
+     * @return the number of worker threads, or -1 on error
+     */
+    public static native int private_key_pool_start(int threads);
+
+    /**
+     * Releases a hold on the signing pool. The last release stops the
+     * workers, once they have finished the queued operations, and waits
+     * for them to exit. Handshakes that need a signature afterwards sign
+     * on the calling thread.
+     */
+    public static native void private_key_pool_stop();
+
+    /**
+     * Moves the private keys of the SSL_CTX and its SNI hosts behind an
+     * SSL_PRIVATE_KEY_METHOD whose signatures are computed by the
+     * signing pool, which the caller must hold.
+     *
+     * @param listener notified when each operation completes
+     * @return 0 on success, -1 on error
+     */
+    public static native int ssl_ctx_enable_async_private_key(long sslCtx,
+            PrivateKeyListener listener);
+
+    /**
+     * Registers the certificate presented for a server name (RFC 6066
+     * section 3), or for every name directly under a parent with
+     * {@code *.parent}. The PEM files are loaded now.
+     *
+     * @param name the server name
+     * @param certPath the PEM certificate chain file
+     * @param keyPath the PEM private key file, or null if the key is in
+     *        the certificate file
+     * @return 0 on success, -1 if the name is invalid or already present,
+     *         -2 if the files cannot be read
+     */
+    public static native int ssl_ctx_add_sni_host(long sslCtx, String name,
+            String certPath, String keyPath);
+
+    /**
+     * Sets a directory of certificates for server names that were not
+     * registered: {@code <name>.pem} and {@code <name>-key.pem}, with
+     * {@code _wildcard.<parent>} for wildcard certificates. The
+     * certificates in it are loaded now. A name not found later is
+     * looked for again during the handshake at most once a minute.
+     *
+     * @return 0 on success, -1 on error
+     */
+    public static native int ssl_ctx_set_sni_directory(long sslCtx,
+                                                       String dir);
+
+    /**
+     * Prepares a server SSL_CTX to staple OCSP responses. Must be called
+     * while the SSL_CTX is built, before any connection uses it.
+     *
+     * @return 0 on success, -1 on error
+     */
+    public static native int ssl_ctx_enable_ocsp_stapling(long sslCtx);
+
+    /**
+     * Sets the DER OCSP response (RFC 6960) stapled to handshakes that
+     * present the SSL_CTX's own certificate (RFC 6066 section 8), or
+     * stops stapling if null. Stapling must have been
+     * {@link #ssl_ctx_enable_ocsp_stapling enabled}.
+     *
+     * @return 0 on success, -1 on error
+     */
+    public static native int ssl_ctx_set_ocsp_response(long sslCtx,
+                                                       byte[] response);
+
     /** Creates a new SSL object from the SSL_CTX (for one connection). */
     public static native long ssl_new(long sslCtx);
 
@@ -202,6 +363,151 @@ public final class GumdropNative {
     /** Frees an SSL_CTX. */
     public static native void ssl_ctx_free(long sslCtx);
 
+    // ── TLS over TCP ──
+
+    /** {@code TLS1_2_VERSION}, for {@link #ssl_ctx_set_proto_versions}. */
+    public static final int TLS1_2_VERSION = 0x0303;
+    /** {@code TLS1_3_VERSION}, for {@link #ssl_ctx_set_proto_versions}. */
+    public static final int TLS1_3_VERSION = 0x0304;
+
+    /** More ciphertext is needed from the peer. */
+    public static final int TLS_WANT_READ = -1;
+    /** The peer sent close_notify. */
+    public static final int TLS_CLOSED = -2;
+    /** A fatal alert was sent or received. */
+    public static final int TLS_ERROR = -3;
+
+    /**
+     * Sets the range of TLS versions an SSL_CTX negotiates.
+     *
+     * @return 0 on success, -1 on error
+     */
+    public static native int ssl_ctx_set_proto_versions(long sslCtx,
+                                                        int min, int max);
+
+    /**
+     * Sets an SSL_CTX's private key (PKCS#8 DER) and certificate chain
+     * (DER, leaf first).
+     *
+     * @return 0 on success, -1 on error
+     */
+    public static native int ssl_ctx_use_key_and_chain(long sslCtx,
+                                                       byte[] key,
+                                                       byte[][] chain);
+
+    /**
+     * Requests client certificates issued by one of the given DER
+     * trust anchors.
+     *
+     * @param require whether a client that sends no certificate is
+     *        refused
+     * @return 0 on success, -1 on error
+     */
+    public static native int ssl_ctx_set_client_auth(long sslCtx,
+                                                     byte[][] anchors,
+                                                     boolean require);
+
+    /**
+     * Creates an SSL for a TCP connection, reading and writing
+     * ciphertext through memory BIOs. Free with {@link #tls_free}.
+     */
+    public static native long tls_new(long sslCtx, boolean isServer);
+
+    /**
+     * Hands ciphertext received from the peer to the SSL. The SSL holds
+     * only a few records' worth; the rest must be fed again once it has
+     * been read.
+     *
+     * @return bytes consumed, possibly 0, or {@link #TLS_ERROR}
+     */
+    public static native int tls_feed(long ssl, ByteBuffer buf, int off,
+                                      int len);
+
+    /**
+     * Advances the handshake.
+     *
+     * @return 0 when complete, else {@link #TLS_WANT_READ} or another
+     *         {@code TLS_} code
+     */
+    public static native int tls_handshake(long ssl);
+
+    /**
+     * Decrypts application data into a direct buffer.
+     *
+     * @return bytes read, or a {@code TLS_} code
+     */
+    public static native int tls_read(long ssl, ByteBuffer buf, int off,
+                                      int len);
+
+    /**
+     * Encrypts application data from a direct buffer. Writes are never
+     * partial; the records wait in the SSL until {@link #tls_drain}.
+     *
+     * @return bytes written, or a {@code TLS_} code
+     */
+    public static native int tls_write(long ssl, ByteBuffer buf, int off,
+                                       int len);
+
+    /** Returns the number of ciphertext bytes waiting to be drained. */
+    public static native int tls_pending_output(long ssl);
+
+    /**
+     * Moves waiting ciphertext into a direct buffer.
+     *
+     * @return bytes moved
+     */
+    public static native int tls_drain(long ssl, ByteBuffer buf, int off,
+                                       int len);
+
+    /** Queues close_notify for {@link #tls_drain}. */
+    public static native void tls_shutdown(long ssl);
+
+    /** Returns the negotiated protocol version, e.g. "TLSv1.3". */
+    public static native String tls_get_version(long ssl);
+
+    /** Returns the IANA name of the negotiated cipher suite. */
+    public static native String tls_get_cipher_suite(long ssl);
+
+    /** Returns the negotiated cipher's key size in bits, or -1. */
+    public static native int tls_get_cipher_bits(long ssl);
+
+    /** Returns the ALPN protocol selected, or null. */
+    public static native String tls_get_alpn_selected(long ssl);
+
+    /** Returns the peer's DER certificate chain, leaf first, or null. */
+    public static native byte[][] tls_get_peer_certificates(long ssl);
+
+    /** Frees an SSL created by {@link #tls_new}. */
+    public static native void tls_free(long ssl);
+
+    // ── Kernel TLS (Linux) ──
+
+    /**
+     * Makes the SSL_CTX's TLS 1.3 connections keep their write traffic
+     * secret for {@link #tls_ktls_enable}.
+     *
+     * @return 0 on success, -1 if the platform has no kernel TLS
+     */
+    public static native int ssl_ctx_enable_ktls(long sslCtx);
+
+    /**
+     * Hands record encryption for data written to the channel to the
+     * kernel, continuing from the SSL's write sequence number. Call only
+     * when the SSL has no output waiting and all of it has been written
+     * to the socket; the SSL must not write afterwards.
+     *
+     * @return 0 on success, -1 if it cannot be offloaded
+     */
+    public static native int tls_ktls_enable(long ssl,
+                                             SocketChannel channel);
+
+    /**
+     * Sends close_notify on a channel with kernel TLS transmit.
+     *
+     * @return 0 on success, -1 on error
+     */
+    public static native int ktls_send_close_notify(SocketChannel channel);
+
     // ── quiche Config ──
 
     public static native long quiche_config_new(int version);
@@ -230,15 +536,58 @@ public final class GumdropNative {
     public static native void quiche_config_set_initial_max_streams_uni(
             long config, long count);
 
+    /**
+     * Sets the ceiling up to which quiche auto-tunes the connection
+     * receive window from the application's read rate and the RTT.
+     */
+    public static native void quiche_config_set_max_connection_window(
+            long config, long bytes);
+
+    /** Sets the ceiling for auto-tuning each stream's receive window. */
+    public static native void quiche_config_set_max_stream_window(
+            long config, long bytes);
+
     public static native void quiche_config_set_cc_algorithm(long config,
                                                               int algo);
 
+    /**
+     * Selects a congestion control algorithm by name ({@code reno},
+     * {@code cubic}, {@code bbr} or {@code bbr2}).
+     *
+     * @return 0 on success, negative if quiche does not know the name
+     */
+    public static native int quiche_config_set_cc_algorithm_name(
+            long config, String name);
+
+    /** Enables HyStart++ (RFC 9406) during slow start. */
+    public static native void quiche_config_enable_hystart(long config,
+                                                           boolean enabled);
+
+    /** Enables packet pacing (RFC 9002 section 7.7). */
+    public static native void quiche_config_enable_pacing(long config,
+                                                          boolean enabled);
+
+    /** Sets the initial congestion window (RFC 9002 section 7.2). */
+    public static native void quiche_config_set_initial_congestion_window_packets(
+            long config, int packets);
+
+    /** Caps the pacing rate, in bytes per second. */
+    public static native void quiche_config_set_max_pacing_rate(long config,
+                                                                long rate);
+
     public static native void quiche_config_set_max_recv_udp_payload_size(
             long config, long size);
 
     public static native void quiche_config_set_max_send_udp_payload_size(
             long config, long size);
 
+    /**
+     * Enables packetization layer path MTU discovery (RFC 8899), probing
+     * up to the configured maximum send UDP payload size.
+     */
+    public static native void quiche_config_discover_pmtu(long config,
+                                                          boolean enabled);
+
     public static native void quiche_config_free(long config);
 
     /**
@@ -265,8 +614,82 @@ public final class GumdropNative {
                                                int len, byte[] fromAddr,
                                                byte[] toAddr);
 
+    /**
+     * Writes the next outgoing packet and encodes the addresses of the
+     * path it belongs to, in the format of the connection lifecycle
+     * calls, into {@code toAddr} and (unless null) {@code fromAddr},
+     * each at least 19 bytes. Unless null, {@code delay[0]} receives
+     * the nanoseconds until the pacer releases the packet, 0 if it is
+     * due now (RFC 9002 section 7.7).
+     */
     public static native int quiche_conn_send(long conn, ByteBuffer buf,
-                                               int len);
+                                               int len, byte[] toAddr,
+                                               byte[] fromAddr,
+                                               long[] delay);
+
+    // ── Connection migration ──
+
+    /**
+     * Returns the type of the connection's next path event
+     * ({@code QUICHE_PATH_EVENT_*}), or -1 if there is none, encoding the
+     * local and peer addresses of the path into the arrays (at least 19
+     * bytes each).
+     */
+    public static native int quiche_conn_path_event_next(long conn,
+                                                          byte[] localAddr,
+                                                          byte[] peerAddr);
+
+    /**
+     * Starts validating a path with PATH_CHALLENGE (RFC 9000 section 8.2).
+     *
+     * @return 0 or a quiche error code
+     */
+    public static native int quiche_conn_probe_path(long conn,
+                                                     byte[] localAddr,
+                                                     byte[] peerAddr);
+
+    /**
+     * Returns how many more connection IDs the peer will accept
+     * (RFC 9000 section 5.1.1).
+     */
+    public static native long quiche_conn_scids_left(long conn);
+
+    /**
+     * Issues a connection ID to the peer in a NEW_CONNECTION_ID frame.
+     *
+     * @param resetToken the 16-byte stateless reset token
+     * @return the sequence number, or a negative quiche error code
+     */
+    public static native long quiche_conn_new_scid(long conn, byte[] scid,
+                                                   byte[] resetToken);
+
+    /**
+     * Returns the next connection ID the peer has retired, or null.
+     */
+    public static native byte[] quiche_conn_retired_scid_next(long conn);
+
+    // ── QUIC-LB connection IDs ──
+
+    /**
+     * Encrypts the server ID and nonce of a QUIC-LB connection ID in
+     * place, leaving the first octet in the clear
+     * (draft-ietf-quic-load-balancers section 5).
+     *
+     * @param key the 16-byte AES-128 key shared with the load balancer
+     * @param cid the connection ID, 6 to 20 bytes
+     * @return 0, or -1 if the key or connection ID length is invalid
+     */
+    public static native int quic_lb_encrypt(byte[] key, byte[] cid);
+
+    /**
+     * Decrypts a connection ID encrypted by {@link #quic_lb_encrypt} in
+     * place, recovering the server ID and nonce as a load balancer does.
+     *
+     * @param key the 16-byte AES-128 key shared with the load balancer
+     * @param cid the connection ID, 6 to 20 bytes
+     * @return 0, or -1 if the key or connection ID length is invalid
+     */
+    public static native int quic_lb_decrypt(byte[] key, byte[] cid);
 
     // ── Stream I/O (uses direct ByteBuffer) ──
 
@@ -298,6 +721,18 @@ public final class GumdropNative {
                                                           int direction,
                                                           long errorCode);
 
+    /**
+     * Sets the send scheduling priority of a stream.
+     * RFC 9218 section 4: urgency 0 (highest) to 7 (lowest); incremental
+     * streams of equal urgency are served round-robin.
+     *
+     * @return 0 on success, negative on error
+     */
+    public static native int quiche_conn_stream_priority(long conn,
+                                                          long streamId,
+                                                          int urgency,
+                                                          boolean incremental);
+
     // ── Polling and timers ──
 
     public static native long[] quiche_conn_readable(long conn);
@@ -310,6 +745,102 @@ public final class GumdropNative {
 
     public static native boolean quiche_conn_is_closed(long conn);
 
+    /**
+     * Returns whether the connection has 0-RTT keys but has not yet
+     * completed its handshake (RFC 9001 section 4.6.1).
+     */
+    public static native boolean quiche_conn_is_in_early_data(long conn);
+
+    /**
+     * Resumes a previous session on a client connection before its
+     * first packet is sent.
+     *
+     * @param session bytes from {@link #ssl_ctx_take_session}
+     * @return 0 on success, negative on error
+     */
+    public static native int quiche_conn_set_session(long conn,
+                                                     byte[] session);
+
+    /**
+     * Returns how many more bidirectional streams may be opened before
+     * the peer's MAX_STREAMS limit is reached (RFC 9000 section 4.6).
+     */
+    public static native long quiche_conn_peer_streams_left_bidi(long conn);
+
+    // ── Path MTU and statistics ──
+
+    /**
+     * Returns the largest UDP payload the connection may send now
+     * (RFC 9000 section 14): 1200 until the handshake completes, then
+     * bounded by the peer's limit and any discovered path MTU.
+     */
+    public static native long quiche_conn_max_send_udp_payload_size(
+            long conn);
+
+    /**
+     * Returns the statistics of the connection's active path as
+     * { rtt, min_rtt, rttvar (nanoseconds), cwnd, pmtu, delivery_rate,
+     * sent, recv, lost, retrans (packets), sent_bytes, recv_bytes,
+     * lost_bytes, max_send_udp_payload_size, peer_initial_max_data,
+     * peer_initial_max_stream_data_bidi_local,
+     * peer_initial_max_stream_data_bidi_remote, bytes_in_flight }, or
+     * null if it has none.
+     */
+    public static native long[] quiche_conn_path_stats(long conn);
+
+    /**
+     * Sends datagrams on a UDP socket with Don't Fragment set and
+     * without capping them at the kernel's cached path MTU, so path MTU
+     * probes are dropped rather than fragmented (Linux only).
+     *
+     * @return 0 on success, -1 if the option is unavailable
+     */
+    public static native int udp_set_pmtud_probe(DatagramChannel channel);
+
+    // ── Receive timestamps ──
+
+    /**
+     * Asks the kernel to timestamp datagrams received on a UDP socket
+     * (SO_TIMESTAMPING or SO_TIMESTAMPNS; Linux only).
+     *
+     * @return 0 on success, -1 if unsupported
+     */
+    public static native int udp_enable_rx_timestamps(DatagramChannel channel);
+
+    /**
+     * Receives a datagram into a direct buffer at offset 0, like
+     * {@link DatagramChannel#receive}, along with the time it waited
+     * since the kernel timestamped it.
+     *
+     * @param channel a non-blocking datagram channel
+     * @param buf the direct buffer to receive into
+     * @param len the capacity to use
+     * @param fromAddr receives the encoded sender address (19 bytes)
+     * @param delay receives the nanoseconds since the kernel stamped the
+     *        datagram, or -1 if it has no timestamp
+     * @return the datagram length, 0 if none was waiting, or -1 on error
+     */
+    public static native int udp_recv(DatagramChannel channel, ByteBuffer buf,
+                                      int len, byte[] fromAddr, long[] delay);
+
+    /** {@link #udp_send} result: the datagram exceeds the interface MTU. */
+    public static final int UDP_SEND_TOO_BIG = -2;
+
+    /**
+     * Sends a datagram from a direct buffer at offset 0, like
+     * {@link DatagramChannel#send}, telling a datagram larger than the
+     * interface allows (EMSGSIZE) apart from other errors.
+     *
+     * @param channel a non-blocking datagram channel
+     * @param buf the direct buffer to send from
+     * @param len the datagram length
+     * @param toAddr the encoded destination address
+     * @return len, 0 if the socket buffer is full,
+     *         {@link #UDP_SEND_TOO_BIG}, or -1 on any other error
+     */
+    public static native int udp_send(DatagramChannel channel, ByteBuffer buf,
+                                      int len, byte[] toAddr);
+
     // ── Debug logging ──
 
     public static native void quiche_enable_debug_logging();
@@ -327,8 +858,13 @@ public final class GumdropNative {
      *   [scid_len (1 byte)][scid ...]
      *   [token_len (1 byte)][token ...]
      * </pre>
+     *
+     * <p>{@code dcidLen} is the length of a short header's destination
+     * connection ID, which the header does not carry: the length of the
+     * connection IDs this endpoint issues.
      */
-    public static native byte[] quiche_header_info(ByteBuffer buf, int len);
+    public static native byte[] quiche_header_info(ByteBuffer buf, int len,
+                                                   int dcidLen);
 
     // ── Version negotiation ──
 
@@ -345,11 +881,46 @@ public final class GumdropNative {
                                                        ByteBuffer out,
                                                        int outLen);
 
+    /**
+     * Writes a Retry packet (RFC 9000 section 17.2.5) into the direct
+     * {@link ByteBuffer} {@code out}. {@code scid} and {@code dcid} are
+     * the connection IDs from the client's Initial; {@code newScid}
+     * becomes the server's connection ID if the client returns.
+     *
+     * @return the number of bytes written, or a negative error code.
+     */
+    public static native int quiche_retry(byte[] scid, byte[] dcid,
+                                          byte[] newScid, byte[] token,
+                                          int version, ByteBuffer out,
+                                          int outLen);
+
+    /**
+     * Writes a server Initial packet carrying only a CONNECTION_CLOSE
+     * frame with the given transport error code (RFC 9000 section 20.1)
+     * into the direct {@link ByteBuffer} {@code out}, refusing a
+     * connection without creating any state for it. {@code scid} and
+     * {@code dcid} are the connection IDs from the client's Initial.
+     *
+     * @return the number of bytes written, or -1 on error.
+     */
+    public static native int quic_refuse_connection(byte[] scid,
+                                                    byte[] dcid,
+                                                    int version,
+                                                    long errorCode,
+                                                    ByteBuffer out,
+                                                    int outLen);
+
     // ── Security info (post-handshake) ──
 
     /** Returns the negotiated cipher suite name from the SSL object. */
     public static native String ssl_get_cipher_name(long ssl);
 
+    /** Returns whether the handshake resumed a previous session. */
+    public static native boolean ssl_session_reused(long ssl);
+
+    /** Returns whether the server accepted 0-RTT early data. */
+    public static native boolean ssl_early_data_accepted(long ssl);
+
     /** Returns the peer certificate chain in DER format. */
     public static native byte[] quiche_conn_peer_cert(long conn);
 
@@ -371,6 +942,59 @@ public final class GumdropNative {
     public static native int quiche_conn_close(long conn, boolean app,
                                                long err, String reason);
 
+    // ── Socket handoff (graceful upgrade) ──
+
+    /**
+     * Sends data on a connected UNIX domain socket channel, with the
+     * sockets of the given channels attached as SCM_RIGHTS.
+     * The channel must be in blocking mode.
+     *
+     * @return the number of bytes sent, or -1 on error
+     */
+    public static native int handoff_send(SocketChannel channel, byte[] data,
+                                          DatagramChannel[] channels);
+
+    /**
+     * Receives data on a UNIX domain socket channel in blocking mode.
+     * Descriptors received with it are stored in fds, unused slots
+     * being set to -1.
+     *
+     * @return the number of bytes received, 0 at end of stream, or -1
+     *         on error
+     */
+    public static native int handoff_recv(SocketChannel channel, byte[] data,
+                                          int[] fds);
+
+    /**
+     * Replaces the socket underlying an open channel with a received
+     * descriptor of the same address family, and closes the descriptor.
+     *
+     * @return 0 on success, -1 on error
+     */
+    public static native int datagram_channel_adopt(DatagramChannel channel,
+                                                    int fd);
+
+    /**
+     * Closes a received descriptor that will not be adopted.
+     */
+    public static native void fd_close(int fd);
+
+    // ── Native memory accounting ──
+
+    /**
+     * Returns { jni_bytes, jni_allocations, heap_in_use }: the bytes and
+     * blocks the JNI layer currently holds, and the bytes in use on the
+     * process's native heap (including quiche and BoringSSL), or -1 if
+     * the allocator cannot report it.
+     */
+    public static native long[] native_memory_stats();
+
+    /**
+     * Returns the bytes the connection has sent but that are neither
+     * acknowledged nor declared lost.
+     */
+    public static native long quiche_conn_bytes_in_flight(long conn);
+
     // ── Cleanup ──
 
     public static native void quiche_conn_free(long conn);
@@ -383,10 +1007,29 @@ public final class GumdropNative {
     /** Frees an HTTP/3 config. */
     public static native void quiche_h3_config_free(long h3Config);
 
-    /** Sets the QPACK maximum dynamic table capacity. */
-    public static native void quiche_h3_config_set_max_dynamic_table_capacity(
+    /**
+     * Sets SETTINGS_MAX_FIELD_SECTION_SIZE (RFC 9114 section 4.2.2), the
+     * largest header section the peer may send, counted as the sum of
+     * name and value lengths plus 32 bytes per field.
+     */
+    public static native void quiche_h3_config_set_max_field_section_size(
+            long h3Config, long size);
+
+    /**
+     * Sets SETTINGS_QPACK_MAX_TABLE_CAPACITY (RFC 9204 section 5), the
+     * largest QPACK dynamic table the peer's encoder may use.
+     */
+    public static native void quiche_h3_config_set_qpack_max_table_capacity(
             long h3Config, long capacity);
 
+    /**
+     * Sets SETTINGS_QPACK_BLOCKED_STREAMS (RFC 9204 section 5), the
+     * number of streams that may be blocked awaiting dynamic table
+     * updates.
+     */
+    public static native void quiche_h3_config_set_qpack_blocked_streams(
+            long h3Config, long streams);
+
     /** RFC 9220 — enables or disables Extended CONNECT (SETTINGS_ENABLE_CONNECT_PROTOCOL). */
     public static native void quiche_h3_config_enable_extended_connect(
             long h3Config, boolean enabled);
@@ -411,6 +1054,7 @@ public final class GumdropNative {
      *   <li>2 = FINISHED</li>
      *   <li>3 = GOAWAY</li>
      *   <li>4 = RESET</li>
+     *   <li>5 = PRIORITY_UPDATE</li>
      * </ul>
      *
      * <p>After receiving a HEADERS event, call
@@ -454,6 +1098,20 @@ public final class GumdropNative {
                                                       String[] headers,
                                                       boolean fin);
 
+    /**
+     * Sends HTTP/3 response headers and sets the stream's extensible
+     * priority (RFC 9218) in one step.
+     *
+     * @param headers flat array of alternating name/value pairs
+     * @param urgency the urgency, 0 (highest) to 7 (lowest)
+     * @param incremental whether the response may be interleaved
+     * @param fin true to include FIN (no body will follow)
+     * @return 0 on success, negative error code on failure
+     */
+    public static native int quiche_h3_send_response_with_priority(
+            long h3Conn, long quicheConn, long streamId, String[] headers,
+            int urgency, boolean incremental, boolean fin);
+
     /**
      * Sends additional HEADERS frames on a stream that has already had
      * its initial HEADERS sent via {@link #quiche_h3_send_response}.
@@ -483,6 +1141,60 @@ public final class GumdropNative {
                                                   ByteBuffer data, int len,
                                                   boolean fin);
 
+    // ── HTTP/3 Priority (RFC 9218) ──
+
+    /**
+     * Returns the Priority Field Value carried by the last PRIORITY_UPDATE
+     * frame received for a request stream, or null if there is none.
+     * Called after {@link #quiche_h3_conn_poll} reports a PRIORITY_UPDATE
+     * event.
+     */
+    public static native String quiche_h3_take_last_priority_update(
+            long h3Conn, long streamId);
+
+    // ── HTTP/3 File Range Body ──
+
+    /** The file ended before the range did: it was truncated. */
+    public static final int H3_FILE_ERR_TRUNCATED = -1000;
+    /** Reading the file failed. */
+    public static final int H3_FILE_ERR_IO = -1001;
+
+    /**
+     * Prepares a byte range of a regular file for use as an HTTP/3
+     * response body. The range takes its own duplicate of the channel's
+     * descriptor, so the caller may close the channel at once; the file
+     * is read in chunks as the body is sent.
+     *
+     * @param channel a channel open for reading on the file
+     * @param offset the offset of the first byte of the range
+     * @param length the number of bytes in the range (must be positive)
+     * @return a range handle, or 0 if the range is not within the file
+     */
+    public static native long h3_file_range_open(FileChannel channel,
+                                                 long offset, long length);
+
+    /**
+     * Sends as much of the remaining file range as the stream's flow
+     * control allows, reading the file without copying it through Java.
+     * FIN is never sent.
+     *
+     * @return the number of bytes written by this call,
+     *         {@link #QUICHE_ERR_DONE} if the stream has no capacity,
+     *         {@link #H3_FILE_ERR_TRUNCATED} or {@link #H3_FILE_ERR_IO}
+     *         if the file cannot supply the range, or another negative
+     *         error code
+     */
+    public static native long quiche_h3_send_body_file(long h3Conn,
+                                                        long quicheConn,
+                                                        long streamId,
+                                                        long range);
+
+    /** Returns the number of bytes of the range not yet sent. */
+    public static native long h3_file_range_remaining(long range);
+
+    /** Closes and frees a file range. */
+    public static native void h3_file_range_free(long range);
+
     // ── HTTP/3 Request Sending (client-side) ──
 
     /**
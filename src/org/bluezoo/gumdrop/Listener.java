@@ -100,6 +100,13 @@ public abstract class Listener {
     protected TelemetryConfig telemetryConfig;
     private Map<String, String> sniHostnameToAlias;
     private String sniDefaultAlias;
+    private String tlsEngine;
+    private boolean kernelTls;
+    private boolean ocspStapling;
+    private String ocspResponder;
+    private Path ocspCacheDirectory;
+    private long ocspRefreshInterval =
+            TransportFactory.DEFAULT_OCSP_REFRESH_INTERVAL;
     private int maxNetInSize = DEFAULT_MAX_NET_IN_SIZE;
     private int maxNetOutSize = DEFAULT_MAX_NET_OUT_SIZE;
 
@@ -108,6 +115,7 @@ public abstract class Listener {
     private Set<InetAddress> addresses = null;
     private boolean wildcard = false;
     protected boolean needClientAuth = false;
+    protected boolean wantClientAuth = false;
     private long idleTimeoutMs = DEFAULT_IDLE_TIMEOUT_MS;
     private long readTimeoutMs = DEFAULT_READ_TIMEOUT_MS;
     private long connectionTimeoutMs = DEFAULT_CONNECTION_TIMEOUT_MS;
@@ -279,6 +287,57 @@ public abstract class Listener {
         return sniHostnameToAlias != null && !sniHostnameToAlias.isEmpty();
     }
 
+    /**
+     * XML: {@code tls-engine}. {@code jsse} (the default) or
+     * {@code native} to terminate TLS with BoringSSL, falling back to
+     * JSSE when the native library is not available.
+     *
+     * @see TCPTransportFactory#setTlsEngine
+     */
+    public void setTlsEngine(String engine) {
+        this.tlsEngine = engine;
+    }
+
+    /**
+     * XML: {@code kernel-tls}. With {@code tls-engine="native"} on
+     * Linux, hands record encryption to the kernel after each handshake
+     * so file responses are sent with {@code sendfile(2)}.
+     *
+     * @see TCPTransportFactory#setKernelTls
+     */
+    public void setKernelTls(boolean kernelTls) {
+        this.kernelTls = kernelTls;
+    }
+
+    /**
+     * XML: {@code ocsp-stapling}. Staples an OCSP response for the
+     * server certificate to handshakes (RFC 6066 section 8).
+     *
+     * @see TransportFactory#setOcspStapling
+     */
+    public void setOcspStapling(boolean enabled) {
+        this.ocspStapling = enabled;
+    }
+
+    /** XML: {@code ocsp-responder}. Overrides the certificate's responder URL. */
+    public void setOcspResponder(String url) {
+        this.ocspResponder = url;
+    }
+
+    /** XML: {@code ocsp-cache-directory}. Where to keep fetched responses. */
+    public void setOcspCacheDirectory(Path dir) {
+        this.ocspCacheDirectory = dir;
+    }
+
+    public void setOcspCacheDirectory(String dir) {
+        this.ocspCacheDirectory = Path.of(dir);
+    }
+
+    /** XML: {@code ocsp-refresh-interval} (milliseconds). */
+    public void setOcspRefreshInterval(long ms) {
+        this.ocspRefreshInterval = ms;
+    }
+
     protected boolean isMetricsEnabled() {
         return telemetryConfig != null && telemetryConfig.isMetricsEnabled();
     }
@@ -348,6 +407,16 @@ public abstract class Listener {
         needClientAuth = flag;
     }
 
+    /**
+     * XML: {@code want-client-auth}. Requests a client certificate
+     * without requiring one; ignored with {@code need-client-auth}.
+     *
+     * @param flag true to request client certificates
+     */
+    public void setWantClientAuth(boolean flag) {
+        wantClientAuth = flag;
+    }
+
     public long getIdleTimeoutMs() {
         return idleTimeoutMs;
     }
@@ -586,6 +655,12 @@ public abstract class Listener {
         }
         factory.setMaxNetInSize(maxNetInSize);
         factory.setMaxNetOutSize(maxNetOutSize);
+        if (ocspStapling) {
+            factory.setOcspStapling(true);
+            factory.setOcspResponder(ocspResponder);
+            factory.setOcspCacheDirectory(ocspCacheDirectory);
+            factory.setOcspRefreshInterval(ocspRefreshInterval);
+        }
 
         if (factory instanceof TCPTransportFactory) {
             TCPTransportFactory tcpFactory = (TCPTransportFactory) factory;
@@ -594,6 +669,8 @@ public abstract class Listener {
             }
             if (needClientAuth) {
                 tcpFactory.setNeedClientAuth(true);
+            } else if (wantClientAuth) {
+                tcpFactory.setWantClientAuth(true);
             }
             if (sniHostnameToAlias != null) {
                 tcpFactory.setSniHostnames(sniHostnameToAlias);
@@ -601,6 +678,12 @@ public abstract class Listener {
             if (sniDefaultAlias != null) {
                 tcpFactory.setSniDefaultAlias(sniDefaultAlias);
             }
+            if (tlsEngine != null) {
+                tcpFactory.setTlsEngine(tlsEngine);
+            }
+            if (kernelTls) {
+                tcpFactory.setKernelTls(true);
+            }
         }
     }
 
@@ -731,6 +814,16 @@ public abstract class Listener {
         return transportFactory;
     }
 
+    /**
+     * Returns the per-IP connection rate limiter, or null if neither
+     * {@code max-connections-per-ip} nor {@code rate-limit} is set.
+     *
+     * @return the connection rate limiter
+     */
+    public ConnectionRateLimiter getConnectionRateLimiter() {
+        return connectionRateLimiter;
+    }
+
     /**
      * Returns the authentication rate limiter, or null if not configured.
      *
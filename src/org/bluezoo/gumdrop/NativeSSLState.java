@@ -0,0 +1,565 @@
+/*
+ * NativeSSLState.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop;
+
+import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.security.cert.Certificate;
+import java.text.MessageFormat;
+import java.util.logging.Level;
+import java.util.logging.Logger;
+
+import org.bluezoo.gumdrop.util.DirectByteBufferPool;
+
+/**
+ * Manages TLS for a TCP connection with BoringSSL instead of JSSE.
+ *
+ * <p>The connection is a native SSL whose ciphertext passes through
+ * memory BIOs: {@link #unwrap} feeds the endpoint's direct
+ * {@code netIn} buffer into the SSL and decrypts into a direct
+ * {@code appIn} buffer, and {@link #wrap} encrypts application data and
+ * drains the records straight into the direct {@code netOut} buffer.
+ * The handshake runs inline on the SelectorLoop; there are no delegated
+ * tasks and no per-record objects.
+ *
+ * <p>A native SSL must not be used from two threads at once, while
+ * {@link #wrap} may be called from any thread. Every native call is
+ * therefore made under the endpoint's {@code netOutLock}, which also
+ * guards {@code netOut} and {@code appIn}; plaintext is delivered to the
+ * handler outside it.
+ *
+ * <p>The SSL takes only a few records of ciphertext at a time, and
+ * {@code appIn} stops growing at the transport's input ceiling while the
+ * handler leaves data in it. Unread ciphertext then stays in
+ * {@code netIn}, which is bounded as it is for JSSE.
+ *
+ * <p>With kernel TLS, once the handshake is over and its output is on
+ * the wire, the write key and sequence number are installed on the
+ * socket and {@link #wrap} appends plaintext to {@code netOut}. The SSL
+ * still opens inbound records, but may no longer write: output it
+ * produces after that point (a KeyUpdate response, for instance) cannot
+ * be sent under the kernel's sequence numbers, so the connection is
+ * closed instead.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ * @see TCPTransportFactory#setTlsEngine
+ */
+final class NativeSSLState implements TLSState {
+
+    private static final Logger LOGGER =
+            Logger.getLogger(NativeSSLState.class.getName());
+
+    /** Default buffer size */
+    private static final int DEFAULT_BUFFER_SIZE = 8192;
+
+    /** Largest plaintext in one TLS record (RFC 8446 section 5.1). */
+    private static final int MAX_RECORD = 16384;
+
+    /**
+     * Plaintext encrypted per native write, so that the ciphertext
+     * waiting in the write BIO stays small.
+     */
+    private static final int WRITE_CHUNK = 4 * MAX_RECORD;
+
+    private final TCPEndpoint tcpEndpoint;
+    private final Certificate[] localCertificates;
+    private final long handshakeStartTime;
+    private final boolean kernelTls;
+
+    // Guarded by netOutLock; 0 once released
+    private long ssl;
+
+    // Decrypted input for receive(), owned by this object; guarded by
+    // netOutLock except while delivering to the handler, when release()
+    // leaves it to be freed afterwards
+    private ByteBuffer appIn;
+    private boolean delivering;
+
+    private boolean handshakeStarted;
+    private boolean handshakeDone;
+    private volatile SecurityInfo securityInfo;
+    boolean closed;
+
+    // Kernel TLS transmit state, guarded by netOutLock
+    private volatile boolean txOffloaded;
+    private boolean txOffloadFailed;
+    private boolean closeNotifyPending;
+
+    /**
+     * Creates a new NativeSSLState for a TCPEndpoint.
+     *
+     * @param sslCtx the listener's native SSL_CTX
+     * @param server true for an accepted connection
+     * @param localCertificates the chain the SSL_CTX presents, or null
+     * @param endpoint the TCPEndpoint that owns the network buffers
+     * @param handshakeStartTime when the handshake started
+     * @param kernelTls whether to offload record encryption for
+     *        outbound data to the kernel after the handshake
+     * @throws IOException if the SSL cannot be created
+     */
+    NativeSSLState(long sslCtx, boolean server,
+                   Certificate[] localCertificates, TCPEndpoint endpoint,
+                   long handshakeStartTime, boolean kernelTls)
+            throws IOException {
+        this.ssl = GumdropNative.tls_new(sslCtx, server);
+        if (ssl == 0) {
+            throw new IOException("Failed to create native TLS connection");
+        }
+        this.tcpEndpoint = endpoint;
+        this.localCertificates = localCertificates;
+        this.handshakeStartTime = handshakeStartTime;
+        this.kernelTls = kernelTls;
+        this.appIn = DirectByteBufferPool.acquire(MAX_RECORD);
+    }
+
+    private ByteBuffer netIn() {
+        return tcpEndpoint.netIn;
+    }
+
+    private ByteBuffer netOut() {
+        return tcpEndpoint.netOut;
+    }
+
+    private Object netOutLock() {
+        return tcpEndpoint.netOutLock;
+    }
+
+    private SSLState.Callback callback() {
+        return tcpEndpoint;
+    }
+
+    private void requestWrite() {
+        SelectorLoop loop = tcpEndpoint.getSelectorLoop();
+        if (loop != null) {
+            loop.requestWrite(tcpEndpoint);
+        }
+    }
+
+    @Override
+    public int getBufferSize() {
+        return 32768;
+    }
+
+    @Override
+    public void startClientHandshake() {
+        if (closed) {
+            return;
+        }
+        int rc;
+        boolean flushed;
+        synchronized (netOutLock()) {
+            if (ssl == 0) {
+                return;
+            }
+            logBeginHandshake();
+            rc = GumdropNative.tls_handshake(ssl);
+            flushed = flush();
+        }
+        if (!flushed) {
+            handleOverflow("client-handshake-init");
+        } else if (rc != GumdropNative.TLS_WANT_READ) {
+            LOGGER.severe("Failed to initiate client TLS handshake");
+            handleClosed("client-handshake-init");
+        }
+    }
+
+    @Override
+    public void unwrap() {
+        if (closed) {
+            return;
+        }
+        try {
+            while (true) {
+                ByteBuffer in = netIn();
+                int n;
+                synchronized (netOutLock()) {
+                    if (ssl == 0 || in == null) {
+                        return;
+                    }
+                    logBeginHandshake();
+                    n = GumdropNative.tls_feed(ssl, in, in.position(),
+                            in.remaining());
+                    if (n > 0) {
+                        in.position(in.position() + n);
+                    }
+                }
+                if (n < 0) {
+                    handleClosed("feed");
+                    return;
+                }
+                processRecords();
+                // Feed the rest once the SSL has read what it took; if it
+                // took nothing, the handler is behind and the rest waits
+                if (closed || n == 0 || !in.hasRemaining()) {
+                    return;
+                }
+            }
+        } finally {
+            // netIn is null if the connection was closed during processing
+            ByteBuffer in = netIn();
+            if (in != null) {
+                in.compact();
+            }
+        }
+    }
+
+    /**
+     * Advances the handshake, then decrypts and delivers application
+     * data until the SSL needs more ciphertext.
+     */
+    private void processRecords() {
+        while (!closed) {
+            int rc;
+            boolean established = false;
+            boolean lost = false;
+            boolean flushed;
+            ByteBuffer data = null;
+            synchronized (netOutLock()) {
+                if (ssl == 0 || appIn == null) {
+                    return;
+                }
+                if (!handshakeDone) {
+                    rc = GumdropNative.tls_handshake(ssl);
+                    if (rc == 0) {
+                        handshakeDone = true;
+                        established = true;
+                        securityInfo = new NativeSecurityInfo(ssl,
+                                localCertificates, handshakeStartTime);
+                    }
+                } else {
+                    if (!appIn.hasRemaining()) {
+                        int cap = tcpEndpoint.getMaxNetInSize();
+                        if (cap > 0 && appIn.capacity() >= cap) {
+                            // Leave the records in the SSL until the
+                            // handler consumes what it has
+                            return;
+                        }
+                        growAppIn();
+                    }
+                    rc = GumdropNative.tls_read(ssl, appIn,
+                            appIn.position(), appIn.remaining());
+                }
+                if (txOffloaded
+                        && GumdropNative.tls_pending_output(ssl) > 0) {
+                    lost = true;
+                    flushed = true;
+                } else {
+                    // Handshake messages, session tickets and alerts
+                    flushed = flush();
+                }
+                if (rc > 0 && !lost && flushed) {
+                    appIn.position(appIn.position() + rc);
+                    appIn.flip();
+                    data = appIn;
+                    delivering = true;
+                }
+            }
+            if (lost) {
+                if (LOGGER.isLoggable(Level.FINE)) {
+                    LOGGER.fine("TLS output after kernel offload for "
+                            + callback().getRemoteAddress());
+                }
+                handleClosed("kernel-tls");
+                return;
+            } else if (!flushed) {
+                handleOverflow("unwrap");
+                return;
+            }
+
+            if (established) {
+                if (LOGGER.isLoggable(Level.FINEST)) {
+                    Object sa = callback().getRemoteAddress();
+                    String message = Gumdrop.L10N.getString(
+                            "info.ssl_handshake_finished");
+                    message = MessageFormat.format(message, sa);
+                    LOGGER.finest(message);
+                }
+                callback().onHandshakeComplete(
+                        securityInfo.getApplicationProtocol());
+            } else if (data != null) {
+                if (LOGGER.isLoggable(Level.FINEST)) {
+                    Object sa = callback().getRemoteAddress();
+                    String message = Gumdrop.L10N.getString(
+                            "info.received_decrypted");
+                    message = MessageFormat.format(message,
+                            data.remaining(), sa);
+                    LOGGER.finest(message);
+                }
+                try {
+                    callback().onApplicationData(data);
+                } finally {
+                    synchronized (netOutLock()) {
+                        delivering = false;
+                        if (ssl == 0) {
+                            // Released during delivery
+                            appIn = null;
+                            DirectByteBufferPool.release(data);
+                        } else {
+                            // Preserve any data the handler did not consume
+                            data.compact();
+                        }
+                    }
+                }
+                if (appIn == null) {
+                    return;
+                }
+            } else if (rc == GumdropNative.TLS_WANT_READ) {
+                return;
+            } else if (rc == GumdropNative.TLS_CLOSED) {
+                handleClosed("application-read");
+                return;
+            } else {
+                if (LOGGER.isLoggable(Level.FINE)) {
+                    LOGGER.fine("TLS " + (handshakeDone ? "read" : "handshake")
+                            + " failed for " + callback().getRemoteAddress());
+                }
+                handleClosed(handshakeDone ? "application-read" : "handshake");
+                return;
+            }
+        }
+    }
+
+    @Override
+    public void wrap(ByteBuffer data) {
+        if (closed) {
+            return;
+        }
+        boolean failed = false;
+        boolean flushed = true;
+        boolean plaintext = false;
+        ByteBuffer staging = null;
+        try {
+            synchronized (netOutLock()) {
+                if (ssl == 0 || netOut() == null || !handshakeDone) {
+                    // Closed concurrently, or nothing may be sent yet
+                    return;
+                }
+                // The kernel seals whatever reaches the socket
+                plaintext = txOffloaded;
+                while (!plaintext && flushed && data.hasRemaining()) {
+                    ByteBuffer src = data;
+                    int off = data.position();
+                    int len = Math.min(data.remaining(), WRITE_CHUNK);
+                    if (!data.isDirect()) {
+                        // The native side needs an address to read from
+                        if (staging == null) {
+                            staging = DirectByteBufferPool.acquire(len);
+                        }
+                        len = Math.min(len, staging.capacity());
+                        ByteBuffer chunk = data.duplicate();
+                        chunk.limit(off + len);
+                        staging.clear();
+                        staging.put(chunk);
+                        src = staging;
+                        off = 0;
+                    }
+                    int n = GumdropNative.tls_write(ssl, src, off, len);
+                    if (n < 0) {
+                        failed = true;
+                        break;
+                    }
+                    data.position(data.position() + n);
+                    flushed = flush();
+                }
+            }
+        } finally {
+            if (staging != null) {
+                DirectByteBufferPool.release(staging);
+            }
+        }
+        if (plaintext) {
+            tcpEndpoint.appendToNetOut(data);
+        } else if (!flushed) {
+            handleOverflow("wrap");
+        } else if (failed) {
+            LOGGER.severe("TLS write failed for "
+                    + callback().getRemoteAddress());
+            handleClosed("wrap");
+        }
+    }
+
+    @Override
+    public void closeOutbound() {
+        if (closed) {
+            return;
+        }
+        closed = true;
+        synchronized (netOutLock()) {
+            if (ssl == 0 || !handshakeDone) {
+                return;
+            }
+            if (txOffloaded) {
+                // Sent by release(), once netOut has been written
+                closeNotifyPending = true;
+                return;
+            }
+            GumdropNative.tls_shutdown(ssl);
+            if (!flush()) {
+                LOGGER.warning("Error sending close_notify: outbound buffer full");
+            }
+        }
+    }
+
+    @Override
+    public boolean canOffloadTx() {
+        return kernelTls && handshakeDone && !txOffloadFailed && !closed;
+    }
+
+    @Override
+    public boolean isTxOffloaded() {
+        return txOffloaded;
+    }
+
+    @Override
+    public boolean offloadTx() {
+        if (txOffloaded) {
+            return true;
+        }
+        if (!canOffloadTx() || ssl == 0
+                || GumdropNative.tls_pending_output(ssl) > 0) {
+            return false;
+        }
+        if (GumdropNative.tls_ktls_enable(ssl, tcpEndpoint.channel) != 0) {
+            // Cipher, version or kernel not supported: stay in BoringSSL
+            txOffloadFailed = true;
+            if (LOGGER.isLoggable(Level.FINE)) {
+                LOGGER.fine("Kernel TLS not available for "
+                        + callback().getRemoteAddress());
+            }
+            return false;
+        }
+        txOffloaded = true;
+        if (LOGGER.isLoggable(Level.FINEST)) {
+            LOGGER.finest("Kernel TLS transmit enabled for "
+                    + callback().getRemoteAddress());
+        }
+        return true;
+    }
+
+    @Override
+    public SecurityInfo getSecurityInfo(long handshakeStartTime) {
+        SecurityInfo info = securityInfo;
+        return info != null ? info : NullSecurityInfo.INSTANCE;
+    }
+
+    @Override
+    public void release() {
+        synchronized (netOutLock()) {
+            if (closeNotifyPending) {
+                closeNotifyPending = false;
+                ByteBuffer out = netOut();
+                if (out != null && out.position() == 0
+                        && !tcpEndpoint.hasDeferredOutput()
+                        && tcpEndpoint.channel.isOpen()) {
+                    GumdropNative.ktls_send_close_notify(tcpEndpoint.channel);
+                }
+            }
+            if (ssl != 0) {
+                GumdropNative.tls_free(ssl);
+                ssl = 0;
+            }
+            ByteBuffer buf = appIn;
+            if (buf != null && !delivering) {
+                appIn = null;
+                DirectByteBufferPool.release(buf);
+            }
+        }
+    }
+
+    /**
+     * Moves ciphertext waiting in the SSL into netOut, growing it up to
+     * the transport's outbound ceiling. Called under netOutLock.
+     *
+     * @return false if netOut would exceed its maximum size
+     */
+    private boolean flush() {
+        int pending = GumdropNative.tls_pending_output(ssl);
+        ByteBuffer out = netOut();
+        if (pending <= 0 || out == null) {
+            return true;
+        }
+        if (out.remaining() < pending) {
+            int newSize = out.position() + pending + DEFAULT_BUFFER_SIZE;
+            int cap = tcpEndpoint.getMaxNetOutSize();
+            if (cap > 0 && newSize > cap) {
+                return false;
+            }
+            ByteBuffer newBuf = DirectByteBufferPool.acquire(newSize);
+            out.flip();
+            newBuf.put(out);
+            DirectByteBufferPool.release(out);
+            tcpEndpoint.netOut = newBuf;
+            out = newBuf;
+        }
+        int n = GumdropNative.tls_drain(ssl, out, out.position(), pending);
+        out.position(out.position() + n);
+        requestWrite();
+        return true;
+    }
+
+    /**
+     * Grows appIn when the handler has left it full.
+     */
+    private void growAppIn() {
+        ByteBuffer newAppIn =
+                DirectByteBufferPool.acquire(appIn.capacity() + MAX_RECORD);
+        appIn.flip();
+        newAppIn.put(appIn);
+        DirectByteBufferPool.release(appIn);
+        appIn = newAppIn;
+    }
+
+    private void logBeginHandshake() {
+        if (handshakeStarted) {
+            return;
+        }
+        handshakeStarted = true;
+        if (LOGGER.isLoggable(Level.FINEST)) {
+            Object sa = callback().getRemoteAddress();
+            String message = Gumdrop.L10N.getString("info.ssl_begin_handshake");
+            message = MessageFormat.format(message, sa);
+            LOGGER.finest(message);
+        }
+    }
+
+    private void handleOverflow(String context) {
+        if (LOGGER.isLoggable(Level.WARNING)) {
+            LOGGER.warning("Outbound TLS buffer exceeded maximum size ("
+                    + tcpEndpoint.getMaxNetOutSize() + " bytes) for "
+                    + callback().getRemoteAddress() + "; peer not reading");
+        }
+        handleClosed(context);
+    }
+
+    void handleClosed(String context) {
+        if (closed) {
+            return;
+        }
+        closed = true;
+
+        if (LOGGER.isLoggable(Level.FINE)) {
+            LOGGER.fine("TLS closed during " + context);
+        }
+
+        callback().onClosed();
+    }
+}
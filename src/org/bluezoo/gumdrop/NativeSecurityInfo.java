@@ -0,0 +1,142 @@
+/*
+ * NativeSecurityInfo.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop;
+
+import java.io.ByteArrayInputStream;
+import java.security.cert.Certificate;
+import java.security.cert.CertificateException;
+import java.security.cert.CertificateFactory;
+
+/**
+ * SecurityInfo implementation backed by a BoringSSL connection.
+ *
+ * <p>Used for TCP endpoints on the native TLS engine. The values are
+ * read once when the handshake completes, since the SSL is freed when
+ * the connection closes.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ * @see NativeSSLState
+ */
+final class NativeSecurityInfo implements SecurityInfo {
+
+    private final String protocol;
+    private final String cipherSuite;
+    private final int keySize;
+    private final String applicationProtocol;
+    private final Certificate[] peerCertificates;
+    private final Certificate[] localCertificates;
+    private final long handshakeDurationMs;
+    private final boolean sessionResumed;
+
+    /**
+     * Reads the state of a connection whose handshake has completed.
+     *
+     * @param ssl the native SSL pointer
+     * @param localCertificates the chain the listener presents, or null
+     * @param handshakeStartTime the time when the handshake started
+     */
+    NativeSecurityInfo(long ssl, Certificate[] localCertificates,
+                       long handshakeStartTime) {
+        this.protocol = GumdropNative.tls_get_version(ssl);
+        this.cipherSuite = GumdropNative.tls_get_cipher_suite(ssl);
+        this.keySize = GumdropNative.tls_get_cipher_bits(ssl);
+        this.applicationProtocol = GumdropNative.tls_get_alpn_selected(ssl);
+        this.peerCertificates = parseCertificates(
+                GumdropNative.tls_get_peer_certificates(ssl));
+        this.localCertificates = localCertificates;
+        this.handshakeDurationMs = handshakeStartTime > 0
+                ? System.currentTimeMillis() - handshakeStartTime : -1;
+        this.sessionResumed = GumdropNative.ssl_session_reused(ssl);
+    }
+
+    @Override
+    public String getProtocol() {
+        return protocol;
+    }
+
+    @Override
+    public String getCipherSuite() {
+        return cipherSuite;
+    }
+
+    @Override
+    public int getKeySize() {
+        return keySize > 0 ? keySize : -1;
+    }
+
+    @Override
+    public Certificate[] getPeerCertificates() {
+        return peerCertificates;
+    }
+
+    @Override
+    public Certificate[] getLocalCertificates() {
+        return localCertificates;
+    }
+
+    @Override
+    public String getApplicationProtocol() {
+        return applicationProtocol;
+    }
+
+    @Override
+    public long getHandshakeDurationMs() {
+        return handshakeDurationMs;
+    }
+
+    @Override
+    public boolean isSessionResumed() {
+        return sessionResumed;
+    }
+
+    @Override
+    public String toString() {
+        StringBuilder sb = new StringBuilder();
+        sb.append("BoringSSL[");
+        sb.append(protocol);
+        sb.append(", ");
+        sb.append(cipherSuite);
+        if (applicationProtocol != null) {
+            sb.append(", ALPN=");
+            sb.append(applicationProtocol);
+        }
+        sb.append("]");
+        return sb.toString();
+    }
+
+    private static Certificate[] parseCertificates(byte[][] chain) {
+        if (chain == null) {
+            return null;
+        }
+        try {
+            CertificateFactory cf = CertificateFactory.getInstance("X.509");
+            Certificate[] certs = new Certificate[chain.length];
+            for (int i = 0; i < chain.length; i++) {
+                certs[i] = cf.generateCertificate(
+                        new ByteArrayInputStream(chain[i]));
+            }
+            return certs;
+        } catch (CertificateException e) {
+            return null;
+        }
+    }
+}
@@ -34,7 +34,7 @@ import javax.net.ssl.SSLSession;
 import org.bluezoo.gumdrop.util.DirectByteBufferPool;
 
 /**
- * Manages SSL wrap/unwrap operations for a TCP connection.
+ * Manages JSSE SSLEngine wrap/unwrap operations for a TCP connection.
  * All methods run on the SelectorLoop thread, no synchronization needed.
  *
  * <p>This class is tightly integrated with {@link TCPEndpoint} and handles
@@ -53,7 +53,7 @@ import org.bluezoo.gumdrop.util.DirectByteBufferPool;
  *
  * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
  */
-final class SSLState {
+final class SSLState implements TLSState {
 
     private static final Logger LOGGER = Logger.getLogger(SSLState.class.getName());
 
@@ -159,7 +159,8 @@ final class SSLState {
     /**
      * Returns the application buffer size for connection configuration.
      */
-    int getBufferSize() {
+    @Override
+    public int getBufferSize() {
         return Math.max(32768, session.getApplicationBufferSize());
     }
 
@@ -173,7 +174,8 @@ final class SSLState {
      * <p>Only call this for client connections - server connections wait for
      * the client's ClientHello to arrive via normal data flow.
      */
-    void startClientHandshake() {
+    @Override
+    public void startClientHandshake() {
         if (closed) {
             return;
         }
@@ -208,7 +210,8 @@ final class SSLState {
      * Called by TCPEndpoint processInbound() after data is appended.
      * The netIn buffer is in read mode (flipped).
      */
-    void unwrap() {
+    @Override
+    public void unwrap() {
         if (closed) {
             return;
         }
@@ -233,7 +236,8 @@ final class SSLState {
      * Encrypts and sends application data.
      * Writes encrypted output directly to tcpEndpoint.netOut.
      */
-    void wrap(ByteBuffer data) {
+    @Override
+    public void wrap(ByteBuffer data) {
         if (closed || engine.isOutboundDone()) {
             return;
         }
@@ -331,7 +335,8 @@ final class SSLState {
      * Initiates a graceful close with close_notify.
      * Writes close_notify to tcpEndpoint.netOut.
      */
-    void closeOutbound() {
+    @Override
+    public void closeOutbound() {
         if (closed) {
             return;
         }
@@ -356,6 +361,33 @@ final class SSLState {
         }
     }
 
+    // JSSE keeps its keys to itself, so records are always sealed here
+
+    @Override
+    public boolean canOffloadTx() {
+        return false;
+    }
+
+    @Override
+    public boolean isTxOffloaded() {
+        return false;
+    }
+
+    @Override
+    public boolean offloadTx() {
+        return false;
+    }
+
+    @Override
+    public SecurityInfo getSecurityInfo(long handshakeStartTime) {
+        return new JSSESecurityInfo(engine, handshakeStartTime);
+    }
+
+    @Override
+    public void release() {
+        // Nothing outside the heap: the engine is garbage collected
+    }
+
     private void processSSLEvents() throws SSLException {
         if (!handshakeStarted) {
             if (LOGGER.isLoggable(Level.FINEST)) {
@@ -29,7 +29,7 @@ import java.security.cert.Certificate;
  * <p>This interface provides a transport-agnostic view of the negotiated
  * security parameters, supporting all secure transports:
  * <ul>
- * <li>TCP with TLS (backed by JSSE SSLSession)</li>
+ * <li>TCP with TLS (backed by JSSE SSLSession, or BoringSSL via JNI)</li>
  * <li>UDP with DTLS (backed by JSSE SSLSession)</li>
  * <li>QUIC (backed by quiche/BoringSSL via JNI)</li>
  * </ul>
@@ -37,6 +37,8 @@ import java.security.cert.Certificate;
  * <p>Implementations:
  * <ul>
  * <li>JSSESecurityInfo -- wraps an SSLEngine's session (TCP TLS, UDP DTLS)</li>
+ * <li>NativeSecurityInfo -- reads a BoringSSL session (TCP TLS on the
+ * native engine)</li>
  * <li>QuicSecurityInfo -- reads security state from quiche via JNI</li>
  * <li>{@link NullSecurityInfo} -- singleton for plaintext endpoints</li>
  * </ul>
@@ -113,12 +115,22 @@ public interface SecurityInfo {
      * <p>Session resumption allows faster connection establishment by
      * reusing cryptographic parameters from a previous session.
      * For JSSE (TLS/DTLS), this delegates to the SSLSession.
-     * For QUIC, TLS 1.3 uses session tickets rather than traditional
-     * resumption, so this always returns false.
+     * For QUIC, this reports whether a TLS 1.3 session ticket was
+     * accepted (RFC 8446 section 2.2).
      * For plaintext endpoints, this returns false.
      *
      * @return true if the session was resumed
      */
     boolean isSessionResumed();
 
+    /**
+     * Returns whether the peer accepted 0-RTT early data
+     * (RFC 8446 section 2.3). Only QUIC endpoints send early data.
+     *
+     * @return true if early data was accepted
+     */
+    default boolean isEarlyDataAccepted() {
+        return false;
+    }
+
 }
@@ -340,6 +340,11 @@ public class SelectorLoop implements Runnable {
                 }
 
                 netOut.clear();
+
+                // File ranges and the data queued behind them follow
+                if (!endpoint.writeDeferred(sc)) {
+                    return;
+                }
             }
 
             if (endpoint.closeRequested) {
@@ -30,9 +30,12 @@ import java.io.IOException;
 import java.net.Socket;
 import java.net.SocketAddress;
 import java.nio.ByteBuffer;
+import java.nio.channels.FileChannel;
 import java.nio.channels.SelectionKey;
 import java.nio.channels.SocketChannel;
+import java.security.cert.Certificate;
 import java.text.MessageFormat;
+import java.util.ArrayDeque;
 import java.util.logging.Level;
 import java.util.logging.Logger;
 
@@ -42,18 +45,26 @@ import javax.net.ssl.SSLEngine;
  * TCP transport implementation of {@link Endpoint}.
  *
  * <p>This class provides TCP connection management with optional TLS
- * (via JSSE SSLEngine). It delegates all application events to an
+ * (via JSSE SSLEngine, or BoringSSL when the listener selects the native
+ * TLS engine). It delegates all application events to an
  * {@link ProtocolHandler} provided at construction time. Protocol
  * handlers never subclass this class.
  *
  * <p>Transparent TLS support:
  * <ul>
- * <li>{@link SSLState} intercepts inbound/outbound data automatically</li>
+ * <li>{@link SSLState} or {@link NativeSSLState} intercepts
+ * inbound/outbound data automatically</li>
  * <li>The protocol handler's {@code receive()} always gets plaintext</li>
  * <li>The protocol handler's {@code send()} always accepts plaintext</li>
  * <li>STARTTLS is available via {@link #startTLS()}</li>
  * </ul>
  *
+ * <p>{@link #sendFile} writes file ranges with
+ * {@link FileChannel#transferTo} ({@code sendfile(2)} on Linux) when the
+ * connection is plaintext, or when the native TLS engine has handed
+ * record encryption to the kernel. Data sent after a range is queued
+ * behind it until the range has been written.
+ *
  * <p>All I/O and SSL processing occurs on the assigned SelectorLoop thread.
  *
  * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
@@ -91,6 +102,11 @@ public class TCPEndpoint implements Endpoint, ChannelHandler, SSLState.Callback
     final Object netOutLock = new Object();
     boolean closeRequested;
 
+    // File ranges still to be written, and data sent after them, in
+    // order; guarded by netOutLock. Null until sendFile() is first used.
+    private ArrayDeque<Object> deferred;
+    private long deferredBytes;
+
     // Write-completion callback for backpressure support.
     // Invoked on the SelectorLoop thread after netOut has been fully drained.
     private Runnable writeCompleteCallback;
@@ -103,7 +119,10 @@ public class TCPEndpoint implements Endpoint, ChannelHandler, SSLState.Callback
 
     private boolean secure;
     private final SSLEngine engine;
-    private SSLState sslState;
+    private long nativeSslCtx;
+    private Certificate[] nativeCertificates;
+    private boolean nativeKernelTls;
+    private TLSState sslState;
     private long handshakeStartTime;
 
     // -- Transport-level establishment timeouts (server endpoints only) --
@@ -177,6 +196,21 @@ public class TCPEndpoint implements Endpoint, ChannelHandler, SSLState.Callback
         this.channel = channel;
     }
 
+    /**
+     * Selects the native TLS engine in place of an SSLEngine.
+     *
+     * @param sslCtx the listener's native SSL_CTX
+     * @param localCertificates the chain it presents, or null
+     * @param kernelTls whether to offload record encryption to the
+     *        kernel after the handshake
+     */
+    void setNativeTLS(long sslCtx, Certificate[] localCertificates,
+                      boolean kernelTls) {
+        this.nativeSslCtx = sslCtx;
+        this.nativeCertificates = localCertificates;
+        this.nativeKernelTls = kernelTls;
+    }
+
     /**
      * Sets whether this is a client-initiated endpoint.
      */
@@ -216,15 +250,15 @@ public class TCPEndpoint implements Endpoint, ChannelHandler, SSLState.Callback
         Socket socket = channel.socket();
         socket.setTcpNoDelay(true);
 
-        if (engine == null || !secure) {
+        if (!hasTLS() || !secure) {
             bufferSize = Math.max(DEFAULT_BUFFER_SIZE,
                     socket.getReceiveBufferSize());
             timestampConnected = System.currentTimeMillis();
         }
 
-        if (engine != null && secure) {
+        if (hasTLS() && secure) {
             handshakeStartTime = System.currentTimeMillis();
-            sslState = new SSLState(engine, this);
+            sslState = createTLSState();
             bufferSize = sslState.getBufferSize();
         }
 
@@ -235,6 +269,19 @@ public class TCPEndpoint implements Endpoint, ChannelHandler, SSLState.Callback
         updateLastActivity();
     }
 
+    private boolean hasTLS() {
+        return engine != null || nativeSslCtx != 0;
+    }
+
+    private TLSState createTLSState() throws IOException {
+        if (nativeSslCtx != 0) {
+            return new NativeSSLState(nativeSslCtx, !clientMode,
+                    nativeCertificates, this, handshakeStartTime,
+                    nativeKernelTls);
+        }
+        return new SSLState(engine, this);
+    }
+
     // -- Endpoint implementation --
 
     @Override
@@ -259,6 +306,46 @@ public class TCPEndpoint implements Endpoint, ChannelHandler, SSLState.Callback
         }
     }
 
+    @Override
+    public boolean canSendFile() {
+        if (channel == null || closing) {
+            return false;
+        }
+        if (sslState != null) {
+            return sslState.canOffloadTx() || sslState.isTxOffloaded();
+        }
+        return !secure;
+    }
+
+    @Override
+    public boolean sendFile(FileChannel file, long position, long count) {
+        if (count <= 0 || !canSendFile()) {
+            return false;
+        }
+        synchronized (netOutLock) {
+            if (netOut == null) {
+                return false;
+            }
+            if (sslState != null && !sslState.isTxOffloaded()) {
+                // Only the SelectorLoop writes the socket, so it offloads
+                // once netOut is drained; this range is sent by the caller
+                if (selectorLoop != null) {
+                    selectorLoop.requestWrite(this);
+                }
+                return false;
+            }
+            if (deferred == null) {
+                deferred = new ArrayDeque<Object>();
+            }
+            deferred.add(new FileRange(file, position, count));
+        }
+        updateLastActivity();
+        if (selectorLoop != null) {
+            selectorLoop.requestWrite(this);
+        }
+        return true;
+    }
+
     @Override
     public boolean isOpen() {
         return channel != null && channel.isOpen() && !closing;
@@ -307,15 +394,21 @@ public class TCPEndpoint implements Endpoint, ChannelHandler, SSLState.Callback
 
     @Override
     public SecurityInfo getSecurityInfo() {
-        if (!secure || engine == null) {
+        if (!secure) {
             return NullSecurityInfo.INSTANCE;
         }
-        return new JSSESecurityInfo(engine, handshakeStartTime);
+        if (sslState != null) {
+            return sslState.getSecurityInfo(handshakeStartTime);
+        }
+        if (engine != null) {
+            return new JSSESecurityInfo(engine, handshakeStartTime);
+        }
+        return NullSecurityInfo.INSTANCE;
     }
 
     @Override
     public void startTLS() throws IOException {
-        if (engine == null) {
+        if (!hasTLS()) {
             throw new IOException("No SSL engine available for STARTTLS");
         }
         if (sslState != null) {
@@ -326,7 +419,7 @@ public class TCPEndpoint implements Endpoint, ChannelHandler, SSLState.Callback
         }
         secure = true;
         handshakeStartTime = System.currentTimeMillis();
-        sslState = new SSLState(engine, this);
+        sslState = createTLSState();
         bufferSize = sslState.getBufferSize();
         // For an in-band upgrade (STARTTLS/STLS) the client must drive the
         // handshake by emitting the ClientHello. At OP_CONNECT time sslState
@@ -445,7 +538,88 @@ public class TCPEndpoint implements Endpoint, ChannelHandler, SSLState.Callback
     }
 
     boolean hasPendingWrite() {
-        return (netOut != null && netOut.position() > 0) || closeRequested;
+        return (netOut != null && netOut.position() > 0)
+                || hasDeferredOutput() || closeRequested;
+    }
+
+    /**
+     * Returns whether file ranges, or data queued behind them, are
+     * waiting to be written.
+     */
+    boolean hasDeferredOutput() {
+        synchronized (netOutLock) {
+            return deferred != null && !deferred.isEmpty();
+        }
+    }
+
+    /**
+     * Called by SelectorLoop under netOutLock once netOut has been
+     * written completely. Offloads TLS record encryption to the kernel
+     * if it is wanted and not yet done, then writes queued file ranges
+     * and moves data queued behind them into netOut.
+     *
+     * @param sc the socket channel
+     * @return true if nothing remains to be written
+     * @throws IOException if the socket or a file fails
+     */
+    boolean writeDeferred(SocketChannel sc) throws IOException {
+        if (sslState != null && !sslState.isTxOffloaded()
+                && sslState.canOffloadTx()) {
+            sslState.offloadTx();
+        }
+        while (deferred != null && !deferred.isEmpty()) {
+            Object head = deferred.peek();
+            if (head instanceof ByteBuffer) {
+                ByteBuffer buf = (ByteBuffer) head;
+                int n = Math.min(buf.remaining(), netOut.remaining());
+                ByteBuffer chunk = buf.duplicate();
+                chunk.limit(chunk.position() + n);
+                netOut.put(chunk);
+                buf.position(buf.position() + n);
+                deferredBytes -= n;
+                if (!buf.hasRemaining()) {
+                    deferred.poll();
+                }
+                // Let the selector write it before the next range
+                return false;
+            }
+            FileRange range = (FileRange) head;
+            long n = range.file.transferTo(range.position, range.remaining,
+                    sc);
+            if (n == 0 && range.position >= range.file.size()) {
+                throw new IOException("File truncated while being sent");
+            }
+            range.position += n;
+            range.remaining -= n;
+            if (range.remaining > 0) {
+                return false;
+            }
+            deferred.poll();
+            closeQuietly(range.file);
+        }
+        return true;
+    }
+
+    /** A range of a file waiting to be written. */
+    private static final class FileRange {
+
+        final FileChannel file;
+        long position;
+        long remaining;
+
+        FileRange(FileChannel file, long position, long remaining) {
+            this.file = file;
+            this.position = position;
+            this.remaining = remaining;
+        }
+    }
+
+    private static void closeQuietly(FileChannel fc) {
+        try {
+            fc.close();
+        } catch (IOException e) {
+            LOGGER.log(Level.FINE, "Error closing file", e);
+        }
     }
 
     /**
@@ -541,7 +715,19 @@ public class TCPEndpoint implements Endpoint, ChannelHandler, SSLState.Callback
             int needed = data.remaining();
             int available = netOut.remaining();
 
-            if (needed > available) {
+            if (deferred != null && !deferred.isEmpty()) {
+                // Keep it behind the file ranges not yet written
+                int cap = getMaxNetOutSize();
+                if (cap > 0 && deferredBytes + needed > cap) {
+                    overflow = true;
+                } else {
+                    ByteBuffer copy = ByteBuffer.allocate(needed);
+                    copy.put(data);
+                    copy.flip();
+                    deferred.add(copy);
+                    deferredBytes += needed;
+                }
+            } else if (needed > available) {
                 int required = netOut.position() + needed;
                 int cap = getMaxNetOutSize();
                 if (cap > 0 && required > cap) {
@@ -561,7 +747,7 @@ public class TCPEndpoint implements Endpoint, ChannelHandler, SSLState.Callback
                     netOut = newBuf;
                 }
             }
-            if (!overflow) {
+            if (!overflow && data.hasRemaining()) {
                 netOut.put(data);
             }
         }
@@ -583,6 +769,15 @@ public class TCPEndpoint implements Endpoint, ChannelHandler, SSLState.Callback
         return factory != null ? factory.getMaxNetOutSize() : 0;
     }
 
+    /**
+     * Returns the configured maximum inbound buffer size, or 0 if unlimited.
+     * Package-private so {@link NativeSSLState} can stop decrypting ahead
+     * of a handler that is not consuming.
+     */
+    int getMaxNetInSize() {
+        return factory != null ? factory.getMaxNetInSize() : 0;
+    }
+
     /**
      * Handles an outbound-buffer overflow: the peer is not reading fast enough
      * to keep the pending write buffer under its ceiling. Logs and closes the
@@ -791,6 +986,11 @@ public class TCPEndpoint implements Endpoint, ChannelHandler, SSLState.Callback
 
     void doClose() {
         endTrace();
+        // Before the channel closes: with kernel TLS, close_notify is
+        // written to the socket here
+        if (sslState != null) {
+            sslState.release();
+        }
         try {
             if (channel != null) {
                 channel.close();
@@ -852,6 +1052,15 @@ public class TCPEndpoint implements Endpoint, ChannelHandler, SSLState.Callback
                 netOut = null;
                 DirectByteBufferPool.release(out);
             }
+            if (deferred != null) {
+                for (Object o : deferred) {
+                    if (o instanceof FileRange) {
+                        closeQuietly(((FileRange) o).file);
+                    }
+                }
+                deferred.clear();
+                deferredBytes = 0;
+            }
         }
     }
 
@@ -884,7 +1093,7 @@ public class TCPEndpoint implements Endpoint, ChannelHandler, SSLState.Callback
         // first application data over the established secure channel.
         cancelHandshakeTimeout();
         armFirstByteTimeout();
-        SecurityInfo info = new JSSESecurityInfo(engine, handshakeStartTime);
+        SecurityInfo info = sslState.getSecurityInfo(handshakeStartTime);
         handler.securityEstablished(info);
     }
 
@@ -25,17 +25,25 @@ import org.bluezoo.gumdrop.util.PinnedCertTrustManager;
 import org.bluezoo.gumdrop.util.SNIKeyManager;
 import org.bluezoo.gumdrop.util.TLSUtils;
 
+import java.io.ByteArrayOutputStream;
 import java.io.IOException;
 import java.net.InetAddress;
 import java.net.InetSocketAddress;
 import java.nio.channels.SocketChannel;
+import java.nio.charset.StandardCharsets;
+import java.security.GeneralSecurityException;
+import java.security.Key;
 import java.security.KeyStore;
 import java.security.MessageDigest;
 import java.security.SecureRandom;
+import java.security.cert.Certificate;
 import java.security.cert.CertificateException;
 import java.security.cert.X509Certificate;
 import java.text.MessageFormat;
+import java.util.ArrayList;
+import java.util.Enumeration;
 import java.util.LinkedHashMap;
+import java.util.List;
 import java.util.Map;
 import java.util.logging.Level;
 import java.util.logging.Logger;
@@ -61,7 +69,8 @@ import javax.net.ssl.X509TrustManager;
  * <p>For TLS, this factory creates JSSE {@link SSLContext} and
  * {@link SSLEngine} instances. The {@link TransportFactory#setCipherSuites}
  * and {@link TransportFactory#setNamedGroups} configuration is mapped to
- * JSSE {@link SSLParameters}.
+ * JSSE {@link SSLParameters}. Server endpoints can instead use BoringSSL
+ * through the native library; see {@link #setTlsEngine}.
  *
  * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
  * @see TCPEndpoint
@@ -81,6 +90,7 @@ public class TCPTransportFactory extends TransportFactory {
 
     // Client authentication (defaults to false - no client cert required)
     protected boolean needClientAuth = false;
+    protected boolean wantClientAuth = false;
 
     // ALPN (Application-Layer Protocol Negotiation) protocols
     private String[] applicationProtocols;
@@ -88,6 +98,15 @@ public class TCPTransportFactory extends TransportFactory {
     // RFC 7413: TCP Fast Open for reduced connection latency
     private boolean tcpFastOpen;
 
+    // Native TLS engine for accepted connections (0 = JSSE)
+    private boolean nativeTls;
+    private long nativeSslCtx;
+    private Certificate[] nativeCertificates;
+
+    // Kernel TLS transmit offload for the native engine (Linux)
+    private boolean kernelTls;
+    private boolean kernelTlsActive;
+
     public TCPTransportFactory() {
     }
 
@@ -130,6 +149,16 @@ public class TCPTransportFactory extends TransportFactory {
         this.needClientAuth = needClientAuth;
     }
 
+    /**
+     * Sets whether client certificates are requested but optional.
+     * Ignored if they are required.
+     *
+     * @param wantClientAuth true to request client certificates
+     */
+    public void setWantClientAuth(boolean wantClientAuth) {
+        this.wantClientAuth = wantClientAuth;
+    }
+
     /**
      * Sets the ALPN (Application-Layer Protocol Negotiation) protocols
      * to advertise during TLS handshake. Used for HTTP/2 negotiation.
@@ -164,6 +193,69 @@ public class TCPTransportFactory extends TransportFactory {
         return tcpFastOpen;
     }
 
+    /**
+     * Selects the TLS implementation for accepted connections.
+     *
+     * <p>{@code "jsse"}, the default, uses an {@link SSLEngine} per
+     * connection. {@code "native"} uses BoringSSL through the native
+     * library, driving each connection over memory BIOs on the
+     * endpoint's direct network buffers. The native engine loads the
+     * key and certificate chain from the keystore and supports ALPN,
+     * cipher suites, named groups and client authentication. If the
+     * library is not available, or the listener uses an external
+     * SSLContext, SNI aliases or OCSP stapling, connections fall back
+     * to JSSE with a warning. Client connections always use JSSE.
+     *
+     * @param engine "jsse" or "native"
+     * @throws IllegalArgumentException for any other value
+     */
+    public void setTlsEngine(String engine) {
+        if ("native".equalsIgnoreCase(engine)) {
+            nativeTls = true;
+        } else if ("jsse".equalsIgnoreCase(engine)) {
+            nativeTls = false;
+        } else {
+            throw new IllegalArgumentException("Unknown TLS engine: "
+                    + engine);
+        }
+    }
+
+    /**
+     * Returns whether accepted connections use the native TLS engine.
+     * Only meaningful once the factory has started.
+     *
+     * @return true if the native engine is in use
+     */
+    public boolean isNativeTls() {
+        return nativeSslCtx != 0;
+    }
+
+    /**
+     * Sets whether the native TLS engine hands record encryption for
+     * outbound data to the kernel (Linux kTLS) once each handshake
+     * completes. Writes then go to the socket as plaintext and file
+     * bodies are sent with {@code sendfile(2)} straight from the page
+     * cache. Requires the native engine and an AES-GCM or
+     * ChaCha20-Poly1305 cipher suite; other connections, and platforms
+     * without kernel TLS, keep encrypting in BoringSSL.
+     *
+     * @param kernelTls true to offload record encryption
+     */
+    public void setKernelTls(boolean kernelTls) {
+        this.kernelTls = kernelTls;
+    }
+
+    /**
+     * Returns whether native TLS connections may offload record
+     * encryption to the kernel. Only meaningful once the factory has
+     * started.
+     *
+     * @return true if kernel TLS is in use
+     */
+    public boolean isKernelTls() {
+        return kernelTlsActive;
+    }
+
     /**
      * Sets an externally-configured SSLContext.
      *
@@ -201,6 +293,7 @@ public class TCPTransportFactory extends TransportFactory {
     @Override
     public void start() {
         super.start();
+        boolean externalContext = sslContext != null;
 
         if (secure && sslContext == null &&
                 (keystoreFile == null || keystorePass == null)) {
@@ -209,6 +302,10 @@ public class TCPTransportFactory extends TransportFactory {
                     "Secure TCP factory requires keystore: " + message);
         }
 
+        if (secure && ocspStapling) {
+            enableOcspStapling();
+        }
+
         if (sslContext == null && keystoreFile != null &&
                 keystorePass != null) {
             try {
@@ -239,6 +336,216 @@ public class TCPTransportFactory extends TransportFactory {
                 throw e2;
             }
         }
+
+        if (nativeTls && sslContext != null && nativeSslCtx == 0) {
+            startNativeTls(externalContext);
+        }
+        if (kernelTls && sslContext != null && nativeSslCtx == 0) {
+            LOGGER.warning("Kernel TLS requires the native TLS engine");
+        }
+    }
+
+    @Override
+    protected void stop() {
+        if (nativeSslCtx != 0) {
+            // Open connections hold their own reference to the SSL_CTX
+            GumdropNative.ssl_ctx_free(nativeSslCtx);
+            nativeSslCtx = 0;
+            kernelTlsActive = false;
+        }
+        super.stop();
+    }
+
+    /**
+     * Builds the BoringSSL context for the native TLS engine from the
+     * same keystore as the SSLContext. Leaves accepted connections on
+     * JSSE if the native library is missing or the configuration needs
+     * something only JSSE provides.
+     */
+    private void startNativeTls(boolean externalContext) {
+        String unsupported = null;
+        if (externalContext) {
+            unsupported = "an external SSLContext";
+        } else if (isSNIEnabled()) {
+            unsupported = "SNI certificate aliases";
+        } else if (ocspStapling) {
+            unsupported = "OCSP stapling";
+        }
+        if (unsupported != null) {
+            LOGGER.warning("Native TLS engine does not support "
+                    + unsupported + "; using JSSE");
+            return;
+        }
+        long ctx = 0;
+        try {
+            ctx = GumdropNative.ssl_ctx_new(true);
+            if (ctx == 0) {
+                throw new RuntimeException(
+                        "Failed to create BoringSSL SSL_CTX");
+            }
+            configureNativeSslCtx(ctx);
+            nativeSslCtx = ctx;
+            if (LOGGER.isLoggable(Level.INFO)) {
+                LOGGER.info("Using native TLS engine");
+            }
+        } catch (LinkageError e) {
+            // Library absent: ExceptionInInitializerError on first
+            // reference, NoClassDefFoundError thereafter
+            LOGGER.warning("Native TLS engine unavailable (" + e
+                    + "); using JSSE");
+        } catch (Exception e) {
+            LOGGER.log(Level.WARNING,
+                    "Failed to initialise native TLS engine; using JSSE", e);
+            if (ctx != 0) {
+                GumdropNative.ssl_ctx_free(ctx);
+            }
+        }
+    }
+
+    private void configureNativeSslCtx(long ctx) throws Exception {
+        KeyStore ks = TLSUtils.loadKeyStore(keystoreFile, keystorePass,
+                keystoreFormat);
+        String alias = sniDefaultAlias;
+        if (alias == null) {
+            for (Enumeration<String> e = ks.aliases();
+                    e.hasMoreElements(); ) {
+                String a = e.nextElement();
+                if (ks.isKeyEntry(a)) {
+                    alias = a;
+                    break;
+                }
+            }
+        }
+        Key key = alias != null
+                ? ks.getKey(alias, keystorePass.toCharArray()) : null;
+        Certificate[] chain = alias != null
+                ? ks.getCertificateChain(alias) : null;
+        if (key == null || chain == null || chain.length == 0
+                || !"PKCS#8".equals(key.getFormat())) {
+            throw new GeneralSecurityException(
+                    "No exportable private key in " + keystoreFile);
+        }
+        byte[][] der = new byte[chain.length][];
+        for (int i = 0; i < chain.length; i++) {
+            der[i] = chain[i].getEncoded();
+        }
+
+        // RFC 9113 section 9.2: TLS 1.2 or later, as for JSSE
+        if (GumdropNative.ssl_ctx_set_proto_versions(ctx,
+                GumdropNative.TLS1_2_VERSION,
+                GumdropNative.TLS1_3_VERSION) != 0) {
+            throw new RuntimeException("Failed to set TLS versions");
+        }
+        if (GumdropNative.ssl_ctx_use_key_and_chain(ctx, key.getEncoded(),
+                der) != 0) {
+            throw new RuntimeException("Failed to load key " + alias
+                    + " from " + keystoreFile);
+        }
+        nativeCertificates = chain;
+
+        if (cipherSuites != null
+                && GumdropNative.ssl_ctx_set_ciphersuites(ctx,
+                        cipherSuites) != 0) {
+            throw new RuntimeException("Failed to set cipher suites: "
+                    + cipherSuites);
+        }
+        if (namedGroups != null
+                && GumdropNative.ssl_ctx_set_groups(ctx, namedGroups) != 0) {
+            throw new RuntimeException("Failed to set named groups: "
+                    + namedGroups);
+        }
+        if (applicationProtocols != null
+                && GumdropNative.ssl_ctx_set_alpn_protos(ctx,
+                        encodeAlpn(applicationProtocols)) != 0) {
+            throw new RuntimeException("Failed to set ALPN protocols");
+        }
+        if ((needClientAuth || wantClientAuth)
+                && GumdropNative.ssl_ctx_set_client_auth(ctx,
+                        trustAnchors(), needClientAuth) != 0) {
+            throw new RuntimeException("Failed to load trust anchors");
+        }
+        if (kernelTls) {
+            kernelTlsActive = GumdropNative.ssl_ctx_enable_ktls(ctx) == 0;
+            if (!kernelTlsActive) {
+                LOGGER.warning("Kernel TLS is not available on this "
+                        + "platform; encrypting in BoringSSL");
+            }
+        }
+    }
+
+    /**
+     * Returns the DER certificates the configured trust managers accept
+     * as issuers of client certificates.
+     */
+    private byte[][] trustAnchors() throws Exception {
+        TrustManager[] tms = loadTrustManagers();
+        if (tms == null) {
+            TrustManagerFactory tmf = TrustManagerFactory.getInstance(
+                    TrustManagerFactory.getDefaultAlgorithm());
+            tmf.init((KeyStore) null);
+            tms = tmf.getTrustManagers();
+        }
+        List<byte[]> anchors = new ArrayList<byte[]>();
+        for (TrustManager tm : tms) {
+            if (tm instanceof X509TrustManager) {
+                for (X509Certificate cert
+                        : ((X509TrustManager) tm).getAcceptedIssuers()) {
+                    anchors.add(cert.getEncoded());
+                }
+            }
+        }
+        return anchors.toArray(new byte[anchors.size()][]);
+    }
+
+    /**
+     * Encodes ALPN protocol names as a ProtocolNameList (RFC 7301
+     * section 3.1).
+     */
+    private static byte[] encodeAlpn(String[] protocols) {
+        ByteArrayOutputStream out = new ByteArrayOutputStream();
+        for (String protocol : protocols) {
+            byte[] name = protocol.getBytes(StandardCharsets.US_ASCII);
+            out.write(name.length);
+            out.write(name, 0, name.length);
+        }
+        return out.toByteArray();
+    }
+
+    /**
+     * Turns on JSSE's server-side OCSP stapling (RFC 6066 section 8).
+     * JSSE has no API for supplying a response, so it fetches and
+     * caches responses itself, configured only through
+     * {@code jdk.tls.*} system properties.
+     *
+     * <p>These properties are global to the JVM and read once: the
+     * status_request switch when JSSE first initialises, the stapling
+     * settings when each SSLContext is created. Stapling therefore has
+     * to be configured on a listener started before any TLS is used,
+     * and every TCP listener in the JVM shares one responder and
+     * refresh interval. A setting that conflicts with one already made
+     * is not changed, and is logged.
+     */
+    private void enableOcspStapling() {
+        setJsseProperty("jdk.tls.server.enableStatusRequestExtension",
+                "true");
+        setJsseProperty("jdk.tls.stapling.cacheLifetime",
+                Long.toString(Math.max(1L, ocspRefreshInterval / 1000L)));
+        if (ocspResponder != null) {
+            setJsseProperty("jdk.tls.stapling.responderURI",
+                    ocspResponder);
+            setJsseProperty("jdk.tls.stapling.responderOverride", "true");
+        }
+    }
+
+    private static synchronized void setJsseProperty(String name,
+                                                     String value) {
+        String current = System.getProperty(name);
+        if (current == null) {
+            System.setProperty(name, value);
+        } else if (!current.equals(value)) {
+            LOGGER.warning("OCSP stapling: " + name + " is already "
+                    + current + " for this JVM; ignoring " + value);
+        }
     }
 
     /**
@@ -292,8 +599,15 @@ public class TCPTransportFactory extends TransportFactory {
     public TCPEndpoint createServerEndpoint(SocketChannel channel,
                                             ProtocolHandler handler)
             throws IOException {
-        SSLEngine engine = createServerSSLEngine(channel);
-        TCPEndpoint endpoint = new TCPEndpoint(handler, engine, secure);
+        TCPEndpoint endpoint;
+        if (nativeSslCtx != 0) {
+            endpoint = new TCPEndpoint(handler, null, secure);
+            endpoint.setNativeTLS(nativeSslCtx, nativeCertificates,
+                    kernelTlsActive);
+        } else {
+            SSLEngine engine = createServerSSLEngine(channel);
+            endpoint = new TCPEndpoint(handler, engine, secure);
+        }
         endpoint.setFactory(this);
         endpoint.setChannel(channel);
         endpoint.setClientMode(false);
@@ -404,6 +718,8 @@ public class TCPTransportFactory extends TransportFactory {
         engine.setUseClientMode(false);
         if (needClientAuth) {
             engine.setNeedClientAuth(true);
+        } else if (wantClientAuth) {
+            engine.setWantClientAuth(true);
         }
 
         SSLParameters params = engine.getSSLParameters();
@@ -430,7 +746,7 @@ public class TCPTransportFactory extends TransportFactory {
 
         // Configure ALPN protocols for HTTP/2 support
         if (applicationProtocols != null && applicationProtocols.length > 0) {
-            java.util.List<String> protocols =
+            List<String> protocols =
                     java.util.Arrays.asList(applicationProtocols);
             params.setApplicationProtocols(protocols.toArray(new String[0]));
         }
@@ -0,0 +1,99 @@
+/*
+ * TLSState.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop;
+
+import java.nio.ByteBuffer;
+
+/**
+ * The TLS engine behind a secure {@link TCPEndpoint}.
+ *
+ * <p>Implementations read ciphertext from the endpoint's {@code netIn}
+ * buffer, deliver plaintext through {@link SSLState.Callback}, and
+ * append ciphertext to its {@code netOut} buffer under
+ * {@code netOutLock}.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ * @see SSLState
+ * @see NativeSSLState
+ */
+interface TLSState {
+
+    /**
+     * Returns the network buffer size the endpoint should allocate.
+     */
+    int getBufferSize();
+
+    /**
+     * Sends the ClientHello. Only called for client endpoints.
+     */
+    void startClientHandshake();
+
+    /**
+     * Processes ciphertext in {@code netIn}, which is in read mode, and
+     * leaves it compacted.
+     */
+    void unwrap();
+
+    /**
+     * Encrypts application data into {@code netOut}.
+     */
+    void wrap(ByteBuffer data);
+
+    /**
+     * Queues close_notify in {@code netOut}.
+     */
+    void closeOutbound();
+
+    /**
+     * Returns whether record encryption for outbound data is, or could
+     * now be, done by the kernel, so that the endpoint may write
+     * plaintext and files straight to the socket.
+     */
+    boolean canOffloadTx();
+
+    /**
+     * Returns whether outbound records are encrypted by the kernel.
+     */
+    boolean isTxOffloaded();
+
+    /**
+     * Moves outbound record encryption into the kernel. Called on the
+     * SelectorLoop under {@code netOutLock} with {@code netOut} empty.
+     *
+     * @return true if outbound records are now encrypted by the kernel
+     */
+    boolean offloadTx();
+
+    /**
+     * Returns the negotiated security parameters.
+     *
+     * @param handshakeStartTime when the handshake started
+     */
+    SecurityInfo getSecurityInfo(long handshakeStartTime);
+
+    /**
+     * Releases any resources held outside the Java heap. Called once
+     * when the endpoint closes.
+     */
+    void release();
+
+}
@@ -61,6 +61,9 @@ public abstract class TransportFactory {
     /** Default maximum network output buffer size: 4 MB */
     public static final int DEFAULT_MAX_NET_OUT_SIZE = 4 * 1024 * 1024;
 
+    /** Default OCSP response refresh interval: 1 hour */
+    public static final long DEFAULT_OCSP_REFRESH_INTERVAL = 60 * 60 * 1000;
+
     // -- Security configuration --
 
     protected boolean secure;
@@ -119,6 +122,17 @@ public abstract class TransportFactory {
      */
     protected String pinnedCertFingerprint;
 
+    /**
+     * OCSP stapling (RFC 6066 section 8) for server certificates. The
+     * responder overrides the one named in the certificate; the cache
+     * directory and refresh interval (milliseconds) apply where the
+     * transport fetches responses itself.
+     */
+    protected boolean ocspStapling;
+    protected String ocspResponder;
+    protected Path ocspCacheDirectory;
+    protected long ocspRefreshInterval = DEFAULT_OCSP_REFRESH_INTERVAL;
+
     // -- Telemetry --
 
     protected TelemetryConfig telemetryConfig;
@@ -339,6 +353,49 @@ public abstract class TransportFactory {
         return pinnedCertFingerprint;
     }
 
+    /**
+     * Enables OCSP stapling (RFC 6066 section 8): the server fetches a
+     * signed statement that its certificate has not been revoked and
+     * sends it in the handshake to clients that ask, so they need not
+     * contact the certificate authority themselves.
+     *
+     * @param enabled true to staple OCSP responses
+     */
+    public void setOcspStapling(boolean enabled) {
+        this.ocspStapling = enabled;
+    }
+
+    /**
+     * Sets the OCSP responder URL, overriding the one in the
+     * certificate's Authority Information Access extension.
+     *
+     * @param url the responder URL
+     */
+    public void setOcspResponder(String url) {
+        this.ocspResponder = url;
+    }
+
+    /**
+     * Sets a directory in which to keep the latest OCSP response, so
+     * that after a restart it can be stapled before the responder has
+     * been contacted again.
+     *
+     * @param dir the cache directory
+     */
+    public void setOcspCacheDirectory(Path dir) {
+        this.ocspCacheDirectory = dir;
+    }
+
+    /**
+     * Sets how often a new OCSP response is fetched, in milliseconds.
+     * The default is one hour.
+     *
+     * @param ms the refresh interval in milliseconds
+     */
+    public void setOcspRefreshInterval(long ms) {
+        this.ocspRefreshInterval = ms;
+    }
+
     // -- Telemetry --
 
     /**
@@ -27,6 +27,7 @@ import java.nio.file.Path;
 import java.util.ArrayList;
 import java.util.Iterator;
 import java.util.List;
+import java.util.Map;
 import java.util.Set;
 import java.util.logging.Level;
 import java.util.logging.Logger;
@@ -38,8 +39,11 @@ import org.bluezoo.gumdrop.SelectorLoop;
 import org.bluezoo.gumdrop.StreamAcceptHandler;
 import org.bluezoo.gumdrop.TCPListener;
 import org.bluezoo.gumdrop.TransportFactory;
+import org.bluezoo.gumdrop.quic.CongestionProfile;
+import org.bluezoo.gumdrop.quic.ConnectionIdGenerator;
 import org.bluezoo.gumdrop.quic.QuicEngine;
 import org.bluezoo.gumdrop.quic.QuicTransportFactory;
+import org.bluezoo.gumdrop.quic.SessionTicketKeys;
 
 /**
  * QUIC transport listener for DNS-over-QUIC (DoQ) queries.
@@ -76,6 +80,16 @@ public class DoQListener extends TCPListener
 
     private Path certFile;
     private Path keyFile;
+    private SessionTicketKeys sessionTicketKeys;
+    private ConnectionIdGenerator connectionIdGenerator;
+    private long certificateCheckInterval;
+    private int maxHalfOpenHandshakes;
+    private int handshakeRate;
+    private int handshakeBurst;
+    private int maxUdpPayloadSize;
+    private boolean pmtuDiscovery;
+    private String congestionProfile;
+    private Map<String, String> congestionProfileNetworks;
 
     private SelectorLoop selectorLoop;
     private final List<QuicEngine> engines = new ArrayList<>();
@@ -143,6 +157,125 @@ public class DoQListener extends TCPListener
         this.keyFile = Path.of(path);
     }
 
+    /**
+     * XML: {@code session-ticket-keys}. Shares session ticket keys with
+     * other listeners and cluster nodes so that clients can resume on
+     * any of them.
+     *
+     * @param keys the shared ticket keys
+     */
+    public void setSessionTicketKeys(SessionTicketKeys keys) {
+        this.sessionTicketKeys = keys;
+    }
+
+    /**
+     * XML: {@code connection-id-generator}. Generates the connection IDs
+     * this listener issues, for example a
+     * {@link org.bluezoo.gumdrop.quic.QuicLbConnectionIdGenerator} so
+     * that a load balancer can route each connection to this node.
+     *
+     * @param generator the connection ID generator
+     */
+    public void setConnectionIdGenerator(ConnectionIdGenerator generator) {
+        this.connectionIdGenerator = generator;
+    }
+
+    /**
+     * XML: {@code certificate-check-interval} (milliseconds). How often
+     * to check the certificate and key files for changes and reload
+     * them without dropping connections. 0 (the default) disables the
+     * check.
+     *
+     * @param ms the check interval in milliseconds
+     */
+    public void setCertificateCheckInterval(long ms) {
+        this.certificateCheckInterval = ms;
+    }
+
+    /**
+     * XML: {@code max-half-open-handshakes}. The most connections that
+     * may be handshaking at once; clients are asked to validate their
+     * address beyond half of this and refused beyond it. 0 (the
+     * default) sets no limit.
+     */
+    public void setMaxHalfOpenHandshakes(int max) {
+        this.maxHalfOpenHandshakes = max;
+    }
+
+    /**
+     * XML: {@code handshake-rate}. The most handshakes started per
+     * second. 0 (the default) sets no limit.
+     */
+    public void setHandshakeRate(int perSecond) {
+        this.handshakeRate = perSecond;
+    }
+
+    /** XML: {@code handshake-burst}. Defaults to the handshake rate. */
+    public void setHandshakeBurst(int burst) {
+        this.handshakeBurst = burst;
+    }
+
+    /**
+     * XML: {@code max-udp-payload-size} (bytes). The largest UDP payload
+     * sent or accepted (default 1350). Raise it towards the link MTU
+     * less 48 bytes on networks with jumbo frames.
+     *
+     * @see QuicTransportFactory#setMaxUdpPayloadSize
+     */
+    public void setMaxUdpPayloadSize(int size) {
+        this.maxUdpPayloadSize = size;
+    }
+
+    /**
+     * XML: {@code pmtu-discovery}. Probes each path for the largest
+     * datagram it carries, up to {@code max-udp-payload-size}
+     * (RFC 8899). Off by default.
+     *
+     * @see QuicTransportFactory#setPmtuDiscovery
+     */
+    public void setPmtuDiscovery(boolean enabled) {
+        this.pmtuDiscovery = enabled;
+    }
+
+    /**
+     * XML: {@code congestion-profile}. The congestion control profile
+     * for connections: {@code bulk-bbr2}, {@code interactive-cubic} or
+     * {@code datacenter}. Unset, quiche's CUBIC defaults apply.
+     *
+     * @see CongestionProfile
+     */
+    public void setCongestionProfile(String name) {
+        CongestionProfile.forName(name); // fail at configuration time
+        this.congestionProfile = name;
+    }
+
+    /**
+     * XML: {@code congestion-profile-networks}. Congestion profile
+     * names by client CIDR block, overriding {@code congestion-profile}
+     * for clients in those networks; the first matching block applies.
+     *
+     * @see QuicTransportFactory#setCongestionProfileNetworks
+     */
+    public void setCongestionProfileNetworks(Map<String, String> networks) {
+        this.congestionProfileNetworks = networks;
+    }
+
+    /**
+     * Reloads the certificate and key files. New connections use the
+     * new certificates; established ones keep theirs.
+     *
+     * @throws IllegalStateException if the listener is not started
+     * @see QuicTransportFactory#reloadCertificates
+     */
+    public void reloadCertificates() {
+        QuicTransportFactory factory =
+                (QuicTransportFactory) getTransportFactory();
+        if (factory == null) {
+            throw new IllegalStateException("Listener not started");
+        }
+        factory.reloadCertificates();
+    }
+
     /**
      * Returns the SelectorLoop used for QUIC datagram I/O.
      *
@@ -179,6 +312,21 @@ public class DoQListener extends TCPListener
         if (keyFile != null) {
             factory.setKeyFile(keyFile);
         }
+        factory.setSessionTicketKeys(sessionTicketKeys);
+        factory.setConnectionIdGenerator(connectionIdGenerator);
+        factory.setCertificateCheckInterval(certificateCheckInterval);
+        factory.setMaxHalfOpenHandshakes(maxHalfOpenHandshakes);
+        factory.setHandshakeRate(handshakeRate);
+        factory.setHandshakeBurst(handshakeBurst);
+        if (maxUdpPayloadSize > 0) {
+            factory.setMaxUdpPayloadSize(maxUdpPayloadSize);
+        }
+        factory.setPmtuDiscovery(pmtuDiscovery);
+        if (congestionProfile != null) {
+            factory.setCongestionProfile(congestionProfile);
+        }
+        factory.setCongestionProfileNetworks(congestionProfileNetworks);
+        factory.setConnectionRateLimiter(getConnectionRateLimiter());
         return factory;
     }
 
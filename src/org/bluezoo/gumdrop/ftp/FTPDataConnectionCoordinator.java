@@ -28,6 +28,7 @@ import java.net.UnknownHostException;
 import java.nio.ByteBuffer;
 import java.nio.channels.AsynchronousFileChannel;
 import java.nio.channels.CompletionHandler;
+import java.nio.channels.FileChannel;
 import java.nio.channels.SocketChannel;
 import java.nio.file.Path;
 import java.nio.file.StandardOpenOption;
@@ -735,9 +736,9 @@ public class FTPDataConnectionCoordinator {
             return;
         }
 
-        exec.submit(controlEndpoint, new Callable<AsynchronousFileChannel>() {
+        exec.submit(controlEndpoint, new Callable<DownloadOpenResult>() {
             @Override
-            public AsynchronousFileChannel call() throws IOException {
+            public DownloadOpenResult call() throws IOException {
                 Path asyncPath = fs.resolvePathForAsyncRead(
                         transfer.getPath(),
                         transfer.getRestartOffset(),
@@ -747,18 +748,41 @@ public class FTPDataConnectionCoordinator {
                             "Asynchronous file open not supported: "
                                     + transfer.getPath());
                 }
-                return AsynchronousFileChannel.open(
+                AsynchronousFileChannel channel = AsynchronousFileChannel.open(
                         asyncPath, StandardOpenOption.READ);
+                // Image-type transfers may be sent straight from the file
+                FileChannel file = null;
+                if (!isAsciiType(transfer)) {
+                    try {
+                        file = FileChannel.open(asyncPath,
+                                StandardOpenOption.READ);
+                    } catch (IOException e) {
+                        LOGGER.log(Level.FINE,
+                                "Cannot open " + asyncPath + " for sendfile",
+                                e);
+                    }
+                }
+                return new DownloadOpenResult(channel, file);
             }
-        }, new StorageExecutor.Callback<AsynchronousFileChannel>() {
+        }, new StorageExecutor.Callback<DownloadOpenResult>() {
             @Override
-            public void completed(AsynchronousFileChannel asyncChannel) {
+            public void completed(DownloadOpenResult result) {
+                AsynchronousFileChannel asyncChannel = result.channel;
                 try {
                     registerDownloadHandler(controlEndpoint, asyncChannel,
-                            transfer, callback);
+                            result.file, transfer, callback);
                 } catch (IOException e) {
                     LOGGER.log(Level.WARNING,
                             "FTP download registration failed", e);
+                    if (result.file != null) {
+                        try {
+                            result.file.close();
+                        } catch (IOException closeEx) {
+                            LOGGER.log(Level.FINE,
+                                    "Error closing file channel after setup failure",
+                                    closeEx);
+                        }
+                    }
                     try {
                         asyncChannel.close();
                     } catch (IOException closeEx) {
@@ -784,8 +808,23 @@ public class FTPDataConnectionCoordinator {
         });
     }
 
+    /**
+     * Result of an offloaded download open: the channel to read the file
+     * in chunks, and for image-type transfers a second channel on it to
+     * offer to {@link Endpoint#sendFile}.
+     */
+    private static final class DownloadOpenResult {
+        final AsynchronousFileChannel channel;
+        final FileChannel file;
+
+        DownloadOpenResult(AsynchronousFileChannel channel, FileChannel file) {
+            this.channel = channel;
+            this.file = file;
+        }
+    }
+
     private void registerDownloadHandler(Endpoint controlEndpoint,
-            AsynchronousFileChannel asyncChannel,
+            AsynchronousFileChannel asyncChannel, FileChannel file,
             PendingTransfer transfer, TransferCallback callback)
             throws IOException {
         SelectorLoop loop = controlEndpoint.getSelectorLoop();
@@ -793,7 +832,8 @@ public class FTPDataConnectionCoordinator {
         dataSc.configureBlocking(false);
 
         DownloadTransferHandler downloadHandler =
-                new DownloadTransferHandler(asyncChannel, transfer, callback);
+                new DownloadTransferHandler(asyncChannel, file, transfer,
+                        callback);
         TCPEndpoint dataEndpoint = new TCPEndpoint(downloadHandler);
         dataEndpoint.setChannel(dataSc);
         dataEndpoint.init();
@@ -1169,22 +1209,28 @@ public class FTPDataConnectionCoordinator {
     /**
      * Event-driven download handler.  Reads chunks from a file via
      * AsynchronousFileChannel and sends them via the data endpoint,
-     * using onWriteReady to pace output.
+     * using onWriteReady to pace output.  Image-type transfers first
+     * offer the rest of the file to {@link Endpoint#sendFile}, which
+     * writes it with sendfile(2) where the data connection allows.
      */
     private class DownloadTransferHandler
             implements ProtocolHandler, Runnable {
 
         private final AsynchronousFileChannel asyncChannel;
+        private FileChannel file; // until handed to the endpoint
         private final PendingTransfer transfer;
         private final TransferCallback callback;
         private final FTPAsciiLineEndings asciiCodec;
         private long filePosition;
+        private boolean fileSent;
         private Endpoint dataEndpoint;
 
         DownloadTransferHandler(AsynchronousFileChannel asyncChannel,
+                FileChannel file,
                 PendingTransfer transfer,
                 TransferCallback callback) {
             this.asyncChannel = asyncChannel;
+            this.file = file;
             this.transfer = transfer;
             this.callback = callback;
             this.asciiCodec = isAsciiType(transfer)
@@ -1202,7 +1248,40 @@ public class FTPDataConnectionCoordinator {
         }
 
         void writeNextChunk() {
-            writeNextChunkAsync();
+            if (!sendRemainingFile()) {
+                writeNextChunkAsync();
+            }
+        }
+
+        /**
+         * Hands the rest of the file to the endpoint in one go.  Once it
+         * has been written the write-ready callback reads at end of
+         * file and finishes the transfer.
+         *
+         * @return false to read and send the file in chunks instead
+         */
+        private boolean sendRemainingFile() {
+            if (fileSent || asciiCodec != null || file == null) {
+                return false;
+            }
+            fileSent = true;
+            long count;
+            try {
+                count = asyncChannel.size() - filePosition;
+            } catch (IOException e) {
+                closeFile();
+                return false;
+            }
+            if (count <= 0
+                    || !dataEndpoint.sendFile(file, filePosition, count)) {
+                closeFile();
+                return false;
+            }
+            file = null; // the endpoint closes it
+            filePosition += count;
+            totalBytesTransferred += count;
+            dataEndpoint.onWriteReady(this);
+            return true;
         }
 
         private void writeNextChunkAsync() {
@@ -1272,6 +1351,7 @@ public class FTPDataConnectionCoordinator {
         }
 
         private void closeChannels() {
+            closeFile();
             if (asyncChannel != null) {
                 try {
                     asyncChannel.close();
@@ -1282,6 +1362,17 @@ public class FTPDataConnectionCoordinator {
             }
         }
 
+        private void closeFile() {
+            if (file != null) {
+                try {
+                    file.close();
+                } catch (IOException e) {
+                    LOGGER.log(Level.FINE, "Error closing file channel", e);
+                }
+                file = null;
+            }
+        }
+
         private void handleAsyncError(Throwable exc) {
             closeChannels();
             dataEndpoint.close();
@@ -213,6 +213,8 @@ public class FTPListener extends TCPListener {
         engine.setUseClientMode(false);
         if (needClientAuth) {
             engine.setNeedClientAuth(true);
+        } else if (wantClientAuth) {
+            engine.setWantClientAuth(true);
         }
         // Don't request client certificates unless explicitly configured
         return engine;
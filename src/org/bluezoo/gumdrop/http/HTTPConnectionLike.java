@@ -23,6 +23,7 @@ package org.bluezoo.gumdrop.http;
 
 import java.net.SocketAddress;
 import java.nio.ByteBuffer;
+import java.nio.channels.FileChannel;
 
 import org.bluezoo.gumdrop.SelectorLoop;
 import org.bluezoo.gumdrop.SecurityInfo;
@@ -48,6 +49,24 @@ interface HTTPConnectionLike {
     HTTPRequestHandlerFactory getHandlerFactory();
     void sendResponseHeaders(int streamId, int statusCode, Headers headers, boolean endStream);
     void sendResponseBody(int streamId, ByteBuffer buf, boolean endStream);
+
+    /**
+     * Sends a file range as HTTP/1.x response body straight from the
+     * file, if the transport allows.
+     *
+     * @return false, having sent nothing, if it does not
+     */
+    default boolean sendResponseFile(FileChannel file, long position,
+            long count) {
+        return false;
+    }
+
+    /**
+     * Returns whether {@link #sendResponseFile} would accept a range.
+     */
+    default boolean canSendResponseFile() {
+        return false;
+    }
     void send(ByteBuffer buf);
     void sendRstStream(int streamId, int errorCode);
     void sendGoaway(int errorCode);
@@ -27,6 +27,7 @@ import java.net.SocketAddress;
 import java.nio.BufferOverflowException;
 import java.nio.ByteBuffer;
 import java.nio.CharBuffer;
+import java.nio.channels.FileChannel;
 import java.nio.channels.WritableByteChannel;
 import java.nio.charset.Charset;
 import java.nio.charset.CharsetDecoder;
@@ -808,6 +809,21 @@ public class HTTPProtocolHandler
         }
     }
 
+    // HTTP/2 frames its DATA, so only HTTP/1.x can send a file as is
+
+    @Override
+    public boolean sendResponseFile(FileChannel file, long position,
+            long count) {
+        return canSendResponseFile()
+                && endpoint.sendFile(file, position, count);
+    }
+
+    @Override
+    public boolean canSendResponseFile() {
+        return endpoint != null && version != HTTPVersion.HTTP_2_0
+                && state != State.WEBSOCKET && endpoint.canSendFile();
+    }
+
     /**
      * Sends HTTP/2 DATA, respecting flow control windows
      * (RFC 9113 section 6.9).  If the send window is insufficient,
@@ -23,6 +23,7 @@ package org.bluezoo.gumdrop.http;
 
 import java.net.SocketAddress;
 import java.nio.ByteBuffer;
+import java.nio.channels.FileChannel;
 import java.security.Principal;
 
 import java.util.List;
@@ -240,6 +241,48 @@ public interface HTTPResponseState {
      */
     void responseBodyContent(ByteBuffer data);
 
+    /**
+     * Sends a byte range of a regular file as response body data, if the
+     * transport can do so without copying it through Java buffers.
+     *
+     * <p>The channel should be opened off the SelectorLoop, since opening
+     * a file may block. If this returns {@code true} the transport has
+     * taken responsibility for the whole range and for closing the
+     * channel; the handler must not send further body data until its
+     * {@link #onWritable} callback fires, but may call
+     * {@link #endResponseBody} and {@link #complete} immediately (they
+     * are queued behind the range). If this returns {@code false}
+     * nothing has been sent, the channel is still the caller's, and the
+     * handler should fall back to {@link #responseBodyContent}.
+     *
+     * <p>The HTTP/3 transport reads the range in native code and feeds
+     * it to quiche as stream flow control permits. HTTP/1.x hands it to
+     * the TCP endpoint, which writes it with {@code sendfile(2)} when the
+     * connection is plaintext or its TLS records are sealed by the
+     * kernel, provided the response has a Content-Length. HTTP/2
+     * returns {@code false}.
+     *
+     * @param file a channel open for reading on the file to send
+     * @param position the offset of the first byte to send
+     * @param count the number of bytes to send
+     * @return true if the transport accepted the range
+     */
+    default boolean responseBodyFile(FileChannel file, long position,
+            long count) {
+        return false;
+    }
+
+    /**
+     * Returns whether {@link #responseBodyFile} is expected to accept a
+     * range for this response, so that a handler can decide before
+     * committing the response whether to buffer the file.
+     *
+     * @return true if file bodies can be sent directly
+     */
+    default boolean isFileBodySupported() {
+        return false;
+    }
+
     /**
      * Signals the end of the response body.
      *
@@ -335,6 +378,33 @@ public interface HTTPResponseState {
      */
     void resumeRequestBody();
 
+    // ─────────────────────────────────────────────────────────────────────────
+    // Prioritisation
+    // ─────────────────────────────────────────────────────────────────────────
+
+    /**
+     * Sets the send priority of this response (RFC 9218 extensible
+     * priorities), overriding any priority signalled by the client.
+     *
+     * <p>Lower urgency is sent first: render-blocking resources such as
+     * CSS and scripts might use urgency 1 or 2, while large images use
+     * 5 with {@code incremental} set so that several can progress
+     * together. May be called before or during the response body.
+     *
+     * <p>For HTTP/3 this controls quiche's stream scheduler. Other
+     * transports currently ignore it.
+     *
+     * @param urgency the urgency, 0 (highest) to 7 (lowest)
+     * @param incremental whether the response may be interleaved with
+     *        other responses of the same urgency
+     * @throws IllegalArgumentException if urgency is not in 0-7
+     */
+    default void setPriority(int urgency, boolean incremental) {
+        if (urgency < 0 || urgency > 7) {
+            throw new IllegalArgumentException("urgency: " + urgency);
+        }
+    }
+
     // ─────────────────────────────────────────────────────────────────────────
     // Informational Responses (1xx)
     // ─────────────────────────────────────────────────────────────────────────
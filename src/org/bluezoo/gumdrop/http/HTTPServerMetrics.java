@@ -43,6 +43,14 @@ import org.bluezoo.gumdrop.telemetry.metrics.Meter;
  *   <li>{@code http.server.request.size} - Size of HTTP request bodies in bytes</li>
  *   <li>{@code http.server.response.size} - Size of HTTP response bodies in bytes</li>
  *   <li>{@code http.server.active_connections} - Number of active connections</li>
+ *   <li>{@code http.server.header.size} - Header section bytes, by
+ *       direction, counted before header compression ({@code decoded})
+ *       and as an estimate of the compressed size ({@code estimated})
+ *       (HTTP/3 only)</li>
+ *   <li>{@code http.server.receive.delay} - Time each received datagram
+ *       waited between its kernel timestamp and being read, in
+ *       milliseconds (HTTP/3 with receive timestamps only). This measures
+ *       event loop saturation directly</li>
  * </ul>
  *
  * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
@@ -56,11 +64,13 @@ public class HTTPServerMetrics {
     private final LongCounter requestCounter;
     private final LongUpDownCounter activeRequests;
     private final LongUpDownCounter activeConnections;
+    private final LongCounter headerSize;
 
     // Histograms
     private final DoubleHistogram requestDuration;
     private final DoubleHistogram requestSize;
     private final DoubleHistogram responseSize;
+    private final DoubleHistogram receiveDelay;
 
     /**
      * Creates HTTP server metrics using the given telemetry configuration.
@@ -88,6 +98,12 @@ public class HTTPServerMetrics {
                 .setUnit("connections")
                 .build();
 
+        // Header section bytes, decoded vs estimated encoded size
+        this.headerSize = meter.counterBuilder("http.server.header.size")
+                .setDescription("Size of HTTP header sections")
+                .setUnit("bytes")
+                .build();
+
         // Request duration histogram with bucket boundaries for latency
         this.requestDuration = meter.histogramBuilder("http.server.request.duration")
                 .setDescription("Duration of HTTP server requests")
@@ -108,6 +124,14 @@ public class HTTPServerMetrics {
                 .setUnit("bytes")
                 .setExplicitBuckets(100, 1000, 10000, 100000, 1000000, 10000000)
                 .build();
+
+        // Datagram receive delay: microseconds when idle, growing with
+        // SelectorLoop queueing
+        this.receiveDelay = meter.histogramBuilder("http.server.receive.delay")
+                .setDescription("Time from kernel receipt of a datagram to its processing")
+                .setUnit("ms")
+                .setExplicitBuckets(0.01, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 25, 50, 100)
+                .build();
     }
 
     /**
@@ -169,6 +193,41 @@ public class HTTPServerMetrics {
         activeConnections.add(-1);
     }
 
+    /**
+     * Records a received header section.
+     *
+     * @param decodedBytes the total name and value bytes
+     * @param estimatedBytes the estimated size after header compression
+     */
+    public void headersReceived(long decodedBytes, long estimatedBytes) {
+        headerSize.add(decodedBytes, Attributes.of(
+                "direction", "received", "encoding", "decoded"));
+        headerSize.add(estimatedBytes, Attributes.of(
+                "direction", "received", "encoding", "estimated"));
+    }
+
+    /**
+     * Records a sent header section.
+     *
+     * @param decodedBytes the total name and value bytes
+     * @param estimatedBytes the estimated size after header compression
+     */
+    public void headersSent(long decodedBytes, long estimatedBytes) {
+        headerSize.add(decodedBytes, Attributes.of(
+                "direction", "sent", "encoding", "decoded"));
+        headerSize.add(estimatedBytes, Attributes.of(
+                "direction", "sent", "encoding", "estimated"));
+    }
+
+    /**
+     * Records how long a received datagram waited before it was read.
+     *
+     * @param delayMs the delay in milliseconds
+     */
+    public void datagramReceived(double delayMs) {
+        receiveDelay.record(delayMs);
+    }
+
     /**
      * Records an HTTP error (request that did not complete normally).
      *
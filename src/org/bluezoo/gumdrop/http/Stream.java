@@ -24,6 +24,7 @@ package org.bluezoo.gumdrop.http;
 import java.io.IOException;
 import java.net.ProtocolException;
 import java.nio.ByteBuffer;
+import java.nio.channels.FileChannel;
 import java.nio.charset.StandardCharsets;
 import java.security.Principal;
 import java.text.MessageFormat;
@@ -1410,6 +1411,39 @@ class Stream implements HTTPResponseState {
         }
     }
 
+    /**
+     * Hands the range to the TCP endpoint for HTTP/1.x responses with a
+     * Content-Length, so that on a plaintext connection, or one whose
+     * TLS records are sealed by the kernel, it is written with
+     * sendfile(2) from the page cache.
+     */
+    @Override
+    public boolean responseBodyFile(FileChannel file, long position,
+            long count) {
+        if (responseState != ResponseState.IN_BODY || responseChunked
+                || count <= 0
+                || (state != State.HALF_CLOSED_REMOTE && state != State.OPEN)) {
+            return false;
+        }
+        // RFC 9110 section 9.3.2: no content for HEAD
+        if ("HEAD".equals(method)) {
+            try {
+                file.close();
+            } catch (IOException e) {
+                LOGGER.log(Level.FINE, "Error closing file channel", e);
+            }
+        } else if (!connection.sendResponseFile(file, position, count)) {
+            return false;
+        }
+        responseBodyBytes += count;
+        return true;
+    }
+
+    @Override
+    public boolean isFileBodySupported() {
+        return connection.canSendResponseFile();
+    }
+
     @Override
     public void endResponseBody() {
         if (responseState != ResponseState.IN_BODY) {
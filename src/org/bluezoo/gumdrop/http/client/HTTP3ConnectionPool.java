@@ -0,0 +1,509 @@
+/*
+ * HTTP3ConnectionPool.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.http.client;
+
+import java.io.IOException;
+import java.net.Inet6Address;
+import java.net.InetAddress;
+import java.net.InetSocketAddress;
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.Iterator;
+import java.util.List;
+import java.util.Map;
+import java.util.Objects;
+import java.util.logging.Level;
+import java.util.logging.Logger;
+
+import org.bluezoo.gumdrop.SelectorLoop;
+import org.bluezoo.gumdrop.http.h3.HTTP3ClientHandler;
+import org.bluezoo.gumdrop.quic.QuicConnection;
+import org.bluezoo.gumdrop.quic.QuicEngine;
+import org.bluezoo.gumdrop.quic.QuicTransportFactory;
+
+/**
+ * A pool of multiplexed HTTP/3 client connections.
+ *
+ * <p>Unlike {@link org.bluezoo.gumdrop.ClientEndpointPool}, which lends
+ * out one endpoint per request, every HTTP/3 connection carries many
+ * concurrent requests, one per bidirectional QUIC stream (RFC 9114
+ * section 4.1). The pool therefore hands out the same warm connection
+ * to every caller until the server's MAX_STREAMS limit
+ * (RFC 9000 section 4.6) is reached, and only then opens another, up
+ * to {@link #setMaxConnectionsPerTarget(int)} per target. When every
+ * connection to a target is saturated and the limit is reached,
+ * {@link #acquire} fails so that the caller can fall back to HTTP/2.
+ *
+ * <p>All connections opened on a given {@link SelectorLoop} share one
+ * client {@link QuicEngine} (and hence one UDP socket) per address
+ * family; the engine demultiplexes them by connection ID.
+ *
+ * <p>Targets include the SelectorLoop, so each I/O thread gets its own
+ * connections, as with {@code ClientEndpointPool}. Idle connections are
+ * closed by the QUIC idle timeout and dropped from the pool lazily.
+ *
+ * <p>{@link #select} and {@link #acquire} may be called from any thread.
+ * They never touch a connection's native state: the stream credit they
+ * compare is the value its SelectorLoop last published
+ * ({@link QuicConnection#getPeerStreamsLeftBidi}).
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ * @see HTTPClient#setH3ConnectionPool
+ */
+public class HTTP3ConnectionPool {
+
+    private static final Logger LOGGER =
+            Logger.getLogger(HTTP3ConnectionPool.class.getName());
+
+    /** Default maximum connections per target. */
+    public static final int DEFAULT_MAX_CONNECTIONS_PER_TARGET = 4;
+
+    private final QuicTransportFactory factory;
+    private int maxConnectionsPerTarget = DEFAULT_MAX_CONNECTIONS_PER_TARGET;
+
+    // All guarded by this
+    private final Map<Target, List<PooledConnection>> connections =
+            new HashMap<Target, List<PooledConnection>>();
+    private final Map<SelectorLoop, QuicEngine> ipv4Engines =
+            new HashMap<SelectorLoop, QuicEngine>();
+    private final Map<SelectorLoop, QuicEngine> ipv6Engines =
+            new HashMap<SelectorLoop, QuicEngine>();
+    private boolean closed;
+
+    /**
+     * Creates a pool whose connections use the given transport factory.
+     * The factory must be configured with ALPN "h3" and started.
+     *
+     * @param factory the QUIC transport factory
+     */
+    public HTTP3ConnectionPool(QuicTransportFactory factory) {
+        this.factory = factory;
+    }
+
+    /**
+     * Returns the maximum number of connections per target.
+     *
+     * @return the max connections per target
+     */
+    public int getMaxConnectionsPerTarget() {
+        return maxConnectionsPerTarget;
+    }
+
+    /**
+     * Sets the maximum number of connections per target. Further
+     * connections are opened only when all existing ones have used up
+     * their stream credit.
+     *
+     * @param max the maximum (must be at least 1)
+     * @throws IllegalArgumentException if max is less than 1
+     */
+    public void setMaxConnectionsPerTarget(int max) {
+        if (max < 1) {
+            throw new IllegalArgumentException(
+                    "maxConnectionsPerTarget must be at least 1");
+        }
+        this.maxConnectionsPerTarget = max;
+    }
+
+    /**
+     * Callback for {@link #acquire}. Invoked on the target's
+     * SelectorLoop.
+     */
+    public interface AcquireCallback {
+
+        /**
+         * Called with an established connection that has stream credit.
+         *
+         * @param handler the HTTP/3 handler for the connection
+         * @param connection the underlying QUIC connection
+         */
+        void acquired(HTTP3ClientHandler handler, QuicConnection connection);
+
+        /**
+         * Called if no connection could be provided: the handshake
+         * failed, or every connection is saturated and the per-target
+         * limit has been reached.
+         *
+         * @param cause the reason
+         */
+        void failed(IOException cause);
+    }
+
+    // ── Pool operations ──
+
+    /**
+     * Returns an established connection to the target that can take a
+     * new request right now, or null. Never opens a connection.
+     *
+     * @param loop the SelectorLoop the connection must belong to
+     * @param address the server address
+     * @param port the server port
+     * @param serverName the TLS SNI hostname, or null
+     * @return a handler with stream credit, or null
+     */
+    public HTTP3ClientHandler select(SelectorLoop loop, InetAddress address,
+                                     int port, String serverName) {
+        PooledConnection best =
+                select(new Target(loop, address, port, serverName));
+        return (best != null) ? best.handler : null;
+    }
+
+    synchronized PooledConnection select(Target target) {
+        List<PooledConnection> list = connections.get(target);
+        return (list != null) ? pickConnection(list) : null;
+    }
+
+    /**
+     * Returns the number of connections to the target, including those
+     * still in their handshake.
+     */
+    synchronized int getConnectionCount(Target target) {
+        List<PooledConnection> list = connections.get(target);
+        return (list != null) ? list.size() : 0;
+    }
+
+    /**
+     * Returns the number of targets the pool holds connection lists for.
+     */
+    synchronized int getTargetCount() {
+        return connections.size();
+    }
+
+    /**
+     * Acquires a connection to the target. A warm connection with
+     * stream credit is reused; otherwise a pending handshake to the
+     * target is joined, or a new connection is opened if the per-target
+     * limit allows.
+     *
+     * @param loop the SelectorLoop to run the connection on
+     * @param address the server address
+     * @param port the server port
+     * @param serverName the TLS SNI hostname, or null
+     * @param callback receives the connection or the failure
+     */
+    public void acquire(final SelectorLoop loop, InetAddress address,
+                        int port, String serverName,
+                        final AcquireCallback callback) {
+        Target target = new Target(loop, address, port, serverName);
+        PooledConnection ready = null;
+        PooledConnection opening = null;
+        IOException failure = null;
+        synchronized (this) {
+            if (closed) {
+                failure = new IOException("HTTP/3 pool is closed");
+            } else {
+                List<PooledConnection> list = connections.get(target);
+                if (list == null) {
+                    list = new ArrayList<PooledConnection>();
+                    connections.put(target, list);
+                }
+                if ((ready = pickConnection(list)) == null) {
+                    for (int i = 0; i < list.size(); i++) {
+                        PooledConnection pc = list.get(i);
+                        if (!pc.isEstablished()) {
+                            // Join the handshake already in progress
+                            pc.waiters.add(callback);
+                            return;
+                        }
+                    }
+                    if (list.size() >= maxConnectionsPerTarget) {
+                        failure = new IOException("All " + list.size()
+                                + " HTTP/3 connections to " + target
+                                + " are saturated");
+                    } else {
+                        opening = newConnection(target);
+                        opening.waiters.add(callback);
+                        list.add(opening);
+                    }
+                }
+            }
+        }
+        if (failure != null) {
+            callback.failed(failure);
+        } else if (ready != null) {
+            final PooledConnection pc = ready;
+            loop.invokeLater(new Runnable() {
+                @Override
+                public void run() {
+                    callback.acquired(pc.handler, pc.connection);
+                }
+            });
+        } else {
+            final PooledConnection pc = opening;
+            loop.invokeLater(new Runnable() {
+                @Override
+                public void run() {
+                    open(pc);
+                }
+            });
+        }
+    }
+
+    /**
+     * Closes every pooled connection and the shared engines.
+     */
+    public void close() {
+        List<PooledConnection> all = new ArrayList<PooledConnection>();
+        List<QuicEngine> engines = new ArrayList<QuicEngine>();
+        synchronized (this) {
+            closed = true;
+            for (List<PooledConnection> list : connections.values()) {
+                all.addAll(list);
+            }
+            connections.clear();
+            engines.addAll(ipv4Engines.values());
+            engines.addAll(ipv6Engines.values());
+            ipv4Engines.clear();
+            ipv6Engines.clear();
+        }
+        for (int i = 0; i < all.size(); i++) {
+            final PooledConnection pc = all.get(i);
+            if (pc.handler != null) {
+                // Frees native h3 state: must run on the connection's loop
+                pc.target.loop.invokeLater(new Runnable() {
+                    @Override
+                    public void run() {
+                        pc.handler.close();
+                    }
+                });
+            }
+            failWaiters(pc, new IOException("HTTP/3 pool closed"));
+        }
+        for (int i = 0; i < engines.size(); i++) {
+            engines.get(i).close();
+        }
+    }
+
+    // ── Internal ──
+
+    /**
+     * Creates the entry for a new connection to the target.
+     */
+    PooledConnection newConnection(Target target) {
+        return new PooledConnection(target);
+    }
+
+    /**
+     * Picks the established connection with the most stream credit,
+     * discarding dead ones. Caller holds the lock.
+     */
+    private PooledConnection pickConnection(List<PooledConnection> list) {
+        PooledConnection best = null;
+        long bestCredit = 0;
+        for (Iterator<PooledConnection> it = list.iterator();
+             it.hasNext(); ) {
+            PooledConnection pc = it.next();
+            if (!pc.isEstablished()) {
+                continue; // handshake in progress
+            }
+            if (pc.isDead()) {
+                it.remove();
+                continue;
+            }
+            if (!pc.canSendRequest()) {
+                continue;
+            }
+            long credit = pc.getStreamCredit();
+            if (credit > bestCredit) {
+                best = pc;
+                bestCredit = credit;
+            }
+        }
+        return best;
+    }
+
+    /**
+     * Opens a new connection on the target's loop. Runs on that loop.
+     */
+    private void open(final PooledConnection pc) {
+        Target target = pc.target;
+        QuicEngine engine;
+        try {
+            engine = engineFor(target.loop,
+                    target.address instanceof Inet6Address);
+            InetSocketAddress remote =
+                    new InetSocketAddress(target.address, target.port);
+            pc.connection = engine.connect(remote,
+                    new QuicEngine.ConnectionAcceptedHandler() {
+                        @Override
+                        public void connectionAccepted(
+                                QuicConnection connection) {
+                            established(pc);
+                        }
+
+                        @Override
+                        public void connectionFailed(
+                                QuicConnection connection) {
+                            failed(pc, new IOException(
+                                    "QUIC handshake with " + pc.target
+                                            + " failed"));
+                        }
+                    },
+                    target.serverName);
+        } catch (IOException e) {
+            failed(pc, e);
+            return;
+        }
+        if (LOGGER.isLoggable(Level.FINE)) {
+            LOGGER.fine("Opening HTTP/3 connection to " + target
+                    + " (" + engine.getConnectionCount()
+                    + " on engine)");
+        }
+    }
+
+    private synchronized QuicEngine engineFor(SelectorLoop loop,
+                                              boolean ipv6)
+            throws IOException {
+        Map<SelectorLoop, QuicEngine> engines =
+                ipv6 ? ipv6Engines : ipv4Engines;
+        QuicEngine engine = engines.get(loop);
+        if (engine == null || !engine.isOpen()) {
+            engine = factory.createClientEngine(ipv6, loop);
+            engines.put(loop, engine);
+        }
+        return engine;
+    }
+
+    void established(PooledConnection pc) {
+        List<AcquireCallback> waiters;
+        synchronized (this) {
+            pc.establish();
+            waiters = new ArrayList<AcquireCallback>(pc.waiters);
+            pc.waiters.clear();
+        }
+        for (int i = 0; i < waiters.size(); i++) {
+            waiters.get(i).acquired(pc.handler, pc.connection);
+        }
+    }
+
+    void failed(PooledConnection pc, IOException cause) {
+        synchronized (this) {
+            List<PooledConnection> list = connections.get(pc.target);
+            if (list != null) {
+                list.remove(pc);
+            }
+        }
+        failWaiters(pc, cause);
+    }
+
+    private void failWaiters(PooledConnection pc, IOException cause) {
+        List<AcquireCallback> waiters;
+        synchronized (this) {
+            waiters = new ArrayList<AcquireCallback>(pc.waiters);
+            pc.waiters.clear();
+        }
+        for (int i = 0; i < waiters.size(); i++) {
+            waiters.get(i).failed(cause);
+        }
+    }
+
+    /**
+     * Connection target: the pool key.
+     */
+    static final class Target {
+
+        final SelectorLoop loop;
+        final InetAddress address;
+        final int port;
+        final String serverName;
+
+        Target(SelectorLoop loop, InetAddress address, int port,
+               String serverName) {
+            this.loop = loop;
+            this.address = address;
+            this.port = port;
+            this.serverName = serverName;
+        }
+
+        @Override
+        public boolean equals(Object o) {
+            if (!(o instanceof Target)) {
+                return false;
+            }
+            Target t = (Target) o;
+            return loop == t.loop && port == t.port
+                    && address.equals(t.address)
+                    && Objects.equals(serverName, t.serverName);
+        }
+
+        @Override
+        public int hashCode() {
+            return Objects.hash(address, Integer.valueOf(port), serverName,
+                    Integer.valueOf(System.identityHashCode(loop)));
+        }
+
+        @Override
+        public String toString() {
+            String host = (serverName != null)
+                    ? serverName : address.getHostAddress();
+            return host + ":" + port;
+        }
+    }
+
+    /**
+     * A pooled connection; {@code handler} is null until the handshake
+     * completes. The state queries may be made from any thread.
+     */
+    static class PooledConnection {
+
+        final Target target;
+        final List<AcquireCallback> waiters =
+                new ArrayList<AcquireCallback>();
+        QuicConnection connection;
+        HTTP3ClientHandler handler;
+
+        PooledConnection(Target target) {
+            this.target = target;
+        }
+
+        /**
+         * Installs the HTTP/3 handler once the handshake has completed.
+         * Runs on the target's SelectorLoop.
+         */
+        void establish() {
+            handler = new HTTP3ClientHandler(connection);
+        }
+
+        boolean isEstablished() {
+            return handler != null;
+        }
+
+        /**
+         * Returns whether the connection is closed, or has received
+         * GOAWAY and finished its last request.
+         */
+        boolean isDead() {
+            return connection.isClosed()
+                    || (handler.isGoaway()
+                        && handler.getActiveStreamCount() == 0);
+        }
+
+        boolean canSendRequest() {
+            return handler.canSendRequest();
+        }
+
+        long getStreamCredit() {
+            return connection.getPeerStreamsLeftBidi();
+        }
+    }
+
+}
@@ -61,7 +61,6 @@ import org.bluezoo.gumdrop.http.HTTPVersion;
 import org.bluezoo.gumdrop.http.h3.HTTP3ClientHandler;
 import org.bluezoo.gumdrop.telemetry.Trace;
 import org.bluezoo.gumdrop.quic.QuicConnection;
-import org.bluezoo.gumdrop.quic.QuicEngine;
 import org.bluezoo.gumdrop.quic.QuicTransportFactory;
 
 /**
@@ -162,9 +161,13 @@ public class HTTPClient implements AltSvcListener {
     private HTTPClientProtocolHandler endpointHandler;
 
     // HTTP/3 transport components (created at connect time)
-    private QuicTransportFactory quicTransportFactory;
-    private QuicEngine quicEngine;
-    private HTTP3ClientHandler h3Handler;
+    private HTTP3ConnectionPool h3Pool;
+    private boolean ownsH3Pool;
+    private volatile HTTP3ClientHandler h3Handler;
+    private SelectorLoop h3Loop;
+    private InetAddress h3Address;
+    private int h3Port;
+    private String h3ServerName;
 
     // Alt-Svc upgrade state
     private volatile boolean h3UpgradeInProgress;
@@ -478,6 +481,29 @@ public class HTTPClient implements AltSvcListener {
         this.connectionPool = pool;
     }
 
+    /**
+     * Sets a shared HTTP/3 connection pool.
+     *
+     * <p>HTTP/3 connections are multiplexed: clients sharing a pool send
+     * concurrent requests over the same warm QUIC connections (and the
+     * same UDP socket per I/O thread), opening further connections only
+     * when the server's stream limit is reached. The pool's transport
+     * factory supplies the TLS configuration, so the certificate, key
+     * and peer verification settings of this client do not apply to
+     * pooled connections.
+     *
+     * <p>If no pool is set, the client creates a private one on first
+     * HTTP/3 connect and closes it in {@link #close()}. A shared pool is
+     * left open.
+     *
+     * @param pool the HTTP/3 connection pool, or null for a private one
+     * @see HTTP3ConnectionPool
+     */
+    public void setH3ConnectionPool(HTTP3ConnectionPool pool) {
+        this.h3Pool = pool;
+        this.ownsH3Pool = false;
+    }
+
     // ═══════════════════════════════════════════════════════════════════
     // Lifecycle
     // ═══════════════════════════════════════════════════════════════════
@@ -516,6 +542,13 @@ public class HTTPClient implements AltSvcListener {
             return;
         }
 
+        connectTCP(handler);
+    }
+
+    /**
+     * Connects over TCP, negotiating HTTP/2 or HTTP/1.1.
+     */
+    private void connectTCP(final HTTPClientHandler handler) {
         transportFactory = new TCPTransportFactory();
         transportFactory.setSecure(secure);
         if (sslContext != null) {
@@ -654,7 +687,8 @@ public class HTTPClient implements AltSvcListener {
     }
 
     /**
-     * Connects to a target host using HTTP/3 over QUIC.
+     * Connects to a target host using HTTP/3 over QUIC, reusing a warm
+     * connection from the HTTP/3 pool when one has stream credit.
      *
      * @param targetAddress the address to connect to (may differ from origin)
      * @param targetPort the port to connect to
@@ -675,41 +709,111 @@ public class HTTPClient implements AltSvcListener {
             return;
         }
 
-        quicTransportFactory = new QuicTransportFactory();
-        quicTransportFactory.setApplicationProtocols("h3");
-        if (certFile != null) {
-            quicTransportFactory.setCertFile(certFile);
-        }
-        if (keyFile != null) {
-            quicTransportFactory.setKeyFile(keyFile);
+        if (h3Pool == null) {
+            QuicTransportFactory factory = new QuicTransportFactory();
+            factory.setApplicationProtocols("h3");
+            if (certFile != null) {
+                factory.setCertFile(certFile);
+            }
+            if (keyFile != null) {
+                factory.setKeyFile(keyFile);
+            }
+            factory.setVerifyPeer(verifyPeer);
+
+            try {
+                factory.start();
+            } catch (RuntimeException e) {
+                h3Failed(handler, new IOException(
+                        "Failed to start QUIC transport: " + e.getMessage()));
+                return;
+            }
+            h3Pool = new HTTP3ConnectionPool(factory);
+            ownsH3Pool = true;
         }
-        quicTransportFactory.setVerifyPeer(verifyPeer);
 
-        try {
-            quicTransportFactory.start();
-        } catch (RuntimeException e) {
-            handler.onError(new IOException(
-                    "Failed to start QUIC transport: " + e.getMessage()));
+        final SelectorLoop connectLoop = loop;
+        h3Pool.acquire(loop, targetAddress, targetPort, serverName,
+                new HTTP3ConnectionPool.AcquireCallback() {
+                    @Override
+                    public void acquired(HTTP3ClientHandler h3,
+                                         QuicConnection connection) {
+                        h3Loop = connectLoop;
+                        h3Address = targetAddress;
+                        h3Port = targetPort;
+                        h3ServerName = serverName;
+                        h3Handler = h3;
+                        handler.onConnected(null);
+                        handler.onSecurityEstablished(
+                                connection.getSecurityInfo());
+                    }
+
+                    @Override
+                    public void failed(IOException cause) {
+                        h3Failed(handler, cause);
+                    }
+                });
+    }
+
+    /**
+     * Handles failure to obtain an HTTP/3 connection. An Alt-Svc
+     * upgrade simply keeps using the existing TCP connection; a direct
+     * HTTP/3 connect falls back to TLS over TCP, where ALPN negotiates
+     * HTTP/2, unless HTTP/2 is disabled.
+     */
+    private void h3Failed(HTTPClientHandler handler, IOException cause) {
+        if (endpointHandler != null) {
+            if (LOGGER.isLoggable(Level.FINE)) {
+                LOGGER.fine("HTTP/3 upgrade failed, staying on "
+                        + endpointHandler.getVersion() + ": " + cause);
+            }
             return;
         }
+        if (!h2Enabled) {
+            handler.onError(cause);
+            return;
+        }
+        if (LOGGER.isLoggable(Level.INFO)) {
+            LOGGER.info("HTTP/3 unavailable for " + host + ":" + port
+                    + ", falling back to TCP: " + cause.getMessage());
+        }
+        secure = true;
+        connectTCP(handler);
+    }
 
-        try {
-            quicEngine = quicTransportFactory.connect(
-                    targetAddress, targetPort,
-                    new QuicEngine.ConnectionAcceptedHandler() {
-                        @Override
-                        public void connectionAccepted(
-                                QuicConnection connection) {
-                            h3Handler = new HTTP3ClientHandler(connection);
-                            handler.onConnected(null);
-                            handler.onSecurityEstablished(
-                                    connection.getSecurityInfo());
-                        }
-                    },
-                    loop, serverName);
-        } catch (IOException e) {
-            handler.onError(e);
+    /**
+     * Returns an HTTP/3 connection that can take a new request now,
+     * preferring the current one. If every pooled connection is at the
+     * server's MAX_STREAMS limit, starts warming another connection
+     * for later requests and returns null.
+     */
+    private HTTP3ClientHandler selectH3Handler() {
+        HTTP3ClientHandler current = h3Handler;
+        if (current.canSendRequest()) {
+            return current;
+        }
+        HTTP3ClientHandler other = h3Pool.select(
+                h3Loop, h3Address, h3Port, h3ServerName);
+        if (other != null) {
+            h3Handler = other;
+            return other;
         }
+        h3Pool.acquire(h3Loop, h3Address, h3Port, h3ServerName,
+                new HTTP3ConnectionPool.AcquireCallback() {
+                    @Override
+                    public void acquired(HTTP3ClientHandler h3,
+                                         QuicConnection connection) {
+                        h3Handler = h3;
+                    }
+
+                    @Override
+                    public void failed(IOException cause) {
+                        if (LOGGER.isLoggable(Level.FINE)) {
+                            LOGGER.fine("No additional HTTP/3 connection: "
+                                    + cause.getMessage());
+                        }
+                    }
+                });
+        return null;
     }
 
     private void resolveAndConnectH3(final String targetHost,
@@ -766,11 +870,9 @@ public class HTTPClient implements AltSvcListener {
      * tracking.
      */
     public void close() {
-        if (h3Handler != null) {
-            h3Handler.close();
-        }
-        if (quicEngine != null) {
-            quicEngine.close();
+        // Connections in a shared pool stay open for other clients
+        if (ownsH3Pool) {
+            h3Pool.close();
         }
         if (poolEntry != null) {
             releaseToPool();
@@ -882,13 +984,25 @@ public class HTTPClient implements AltSvcListener {
      */
     public HTTPRequest request(String method, String path) {
         if (h3Handler != null) {
+            HTTP3ClientHandler h3 = selectH3Handler();
+            if (h3 == null) {
+                if (endpointHandler != null) {
+                    // Every HTTP/3 connection is at the server's stream
+                    // limit: send this one over the TCP connection
+                    return endpointHandler.request(method, path);
+                }
+                // No TCP connection: the request waits on this
+                // connection for the server to raise MAX_STREAMS, while
+                // selectH3Handler warms another for later requests
+                h3 = h3Handler;
+            }
             String scheme = "https";
             String authority = host;
             if (port != 443) {
                 authority = host + ":" + port;
             }
             return new org.bluezoo.gumdrop.http.h3.H3Request(
-                    h3Handler, method, path, authority, scheme, traceContext);
+                    h3, method, path, authority, scheme, traceContext);
         }
         return endpointHandler.request(method, path);
     }
@@ -0,0 +1,173 @@
+/*
+ * H3Priority.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.http.h3;
+
+/**
+ * Extensible priority parameters for an HTTP/3 response (RFC 9218).
+ *
+ * <p>The Priority Field Value is a Structured Fields dictionary
+ * (RFC 8941 section 3.2) carried in the {@code priority} request header
+ * or a PRIORITY_UPDATE frame. Two parameters are defined:
+ * <ul>
+ *   <li>{@code u} - urgency, an integer 0 (highest) to 7 (lowest),
+ *       default 3 (section 4.1)</li>
+ *   <li>{@code i} - incremental, a boolean, default false
+ *       (section 4.2)</li>
+ * </ul>
+ *
+ * <p>Unknown parameters, and known parameters with values of the wrong
+ * type or out of range, are ignored per section 4.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ */
+final class H3Priority {
+
+    /** RFC 9218 section 4.1: default urgency. */
+    static final int DEFAULT_URGENCY = 3;
+
+    /** Lowest urgency value. */
+    static final int MAX_URGENCY = 7;
+
+    /** The default priority (u=3, non-incremental). */
+    static final H3Priority DEFAULT =
+            new H3Priority(DEFAULT_URGENCY, false);
+
+    final int urgency;
+    final boolean incremental;
+
+    H3Priority(int urgency, boolean incremental) {
+        if (urgency < 0 || urgency > MAX_URGENCY) {
+            throw new IllegalArgumentException("urgency: " + urgency);
+        }
+        this.urgency = urgency;
+        this.incremental = incremental;
+    }
+
+    /**
+     * Parses a Priority Field Value. Parameters that are absent or
+     * invalid take their defaults.
+     *
+     * @param value the field value, may be null
+     * @return the parsed priority, never null
+     */
+    static H3Priority parse(String value) {
+        if (value == null) {
+            return DEFAULT;
+        }
+        int urgency = DEFAULT_URGENCY;
+        boolean incremental = false;
+        int len = value.length();
+        int start = 0;
+        while (start < len) {
+            int end = value.indexOf(',', start);
+            if (end < 0) {
+                end = len;
+            }
+            String member = value.substring(start, end).trim();
+            start = end + 1;
+            // Member parameters (";...") carry no meaning here
+            int semi = member.indexOf(';');
+            if (semi >= 0) {
+                member = member.substring(0, semi).trim();
+            }
+            int eq = member.indexOf('=');
+            String key = (eq < 0) ? member : member.substring(0, eq).trim();
+            String val = (eq < 0) ? null : member.substring(eq + 1).trim();
+            if ("u".equals(key)) {
+                if (val == null) {
+                    continue; // bare key is boolean true: wrong type
+                }
+                int u = parseUrgency(val);
+                if (u >= 0) {
+                    urgency = u;
+                }
+            } else if ("i".equals(key)) {
+                if (val == null || "?1".equals(val)) {
+                    incremental = true;
+                } else if ("?0".equals(val)) {
+                    incremental = false;
+                }
+            }
+        }
+        if (urgency == DEFAULT_URGENCY && !incremental) {
+            return DEFAULT;
+        }
+        return new H3Priority(urgency, incremental);
+    }
+
+    /**
+     * Parses an urgency value, which RFC 9218 section 4.1 defines as an
+     * sf-integer (RFC 8941 section 3.3.1): up to 15 digits with an
+     * optional minus sign, never a plus. A negative value is out of
+     * range, so only bare digits are accepted.
+     *
+     * @return the urgency, or -1 if the value is malformed or out of range
+     */
+    private static int parseUrgency(String val) {
+        int len = val.length();
+        if (len == 0 || len > 15) {
+            return -1;
+        }
+        for (int i = 0; i < len; i++) {
+            char c = val.charAt(i);
+            if (c < '0' || c > '9') {
+                return -1;
+            }
+        }
+        long u = Long.parseLong(val);
+        return (u <= MAX_URGENCY) ? (int) u : -1;
+    }
+
+    /**
+     * Returns the Priority Field Value for this priority, omitting
+     * parameters at their defaults.
+     */
+    @Override
+    public String toString() {
+        StringBuilder buf = new StringBuilder();
+        if (urgency != DEFAULT_URGENCY) {
+            buf.append("u=").append(urgency);
+        }
+        if (incremental) {
+            if (buf.length() > 0) {
+                buf.append(", ");
+            }
+            buf.append('i');
+        }
+        return buf.toString();
+    }
+
+    @Override
+    public boolean equals(Object other) {
+        if (!(other instanceof H3Priority)) {
+            return false;
+        }
+        H3Priority p = (H3Priority) other;
+        return urgency == p.urgency && incremental == p.incremental;
+    }
+
+    @Override
+    public int hashCode() {
+        return urgency * 2 + (incremental ? 1 : 0);
+    }
+
+}
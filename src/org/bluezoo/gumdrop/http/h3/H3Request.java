@@ -43,6 +43,11 @@ import org.bluezoo.gumdrop.telemetry.Trace;
  * <p>Pseudo-headers are constructed per RFC 9114 section 4.3.1:
  * {@code :method}, {@code :scheme}, {@code :authority}, {@code :path}.
  *
+ * <p>If the server's MAX_STREAMS limit (RFC 9000 section 4.6) leaves no
+ * room for another stream when the request is sent, it waits on the
+ * connection until the limit is raised; request body data written in
+ * the meantime is buffered.
+ *
  * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
  * @see HTTP3ClientHandler
  */
@@ -60,6 +65,11 @@ public class H3Request implements HTTPRequest {
     private HTTPResponseHandler responseHandler;
     private boolean cancelled;
 
+    // Set while waiting for stream credit
+    private boolean waiting;
+    private List<ByteBuffer> waitingBody;
+    private boolean waitingEnd;
+
     public H3Request(HTTP3ClientHandler h3Handler, String method,
                      String path, String authority, String scheme,
                      Trace traceContext) {
@@ -99,41 +109,87 @@ public class H3Request implements HTTPRequest {
 
     @Override
     public void send(HTTPResponseHandler handler) {
-        if (cancelled) {
-            handler.failed(new CancellationException("Request cancelled"));
-            return;
-        }
-
-        Headers h3Headers = buildHeaders();
-        streamId = h3Handler.sendRequest(h3Headers, handler, true);
-        responseHandler = handler;
+        open(handler, true);
     }
 
     @Override
     public void startRequestBody(HTTPResponseHandler handler) {
+        open(handler, false);
+    }
+
+    private void open(final HTTPResponseHandler handler, final boolean fin) {
         if (cancelled) {
             handler.failed(new CancellationException("Request cancelled"));
             return;
         }
+        responseHandler = handler;
+        if (!h3Handler.canSendRequest() && !h3Handler.isGoaway()) {
+            waiting = true;
+            h3Handler.awaitStreamCredit(new Runnable() {
+                @Override
+                public void run() {
+                    waiting = false;
+                    if (!cancelled) {
+                        sendHeaders(handler, fin);
+                    }
+                }
+            });
+            return;
+        }
+        sendHeaders(handler, fin);
+    }
 
+    private void sendHeaders(HTTPResponseHandler handler, boolean fin) {
         Headers h3Headers = buildHeaders();
-        streamId = h3Handler.sendRequest(h3Headers, handler, false);
-        responseHandler = handler;
+        streamId = h3Handler.sendRequest(h3Headers, handler, fin);
+        if (streamId < 0) {
+            return;
+        }
+        if (waitingBody != null) {
+            for (int i = 0; i < waitingBody.size(); i++) {
+                h3Handler.sendRequestBody(streamId, waitingBody.get(i),
+                        false);
+            }
+            waitingBody = null;
+        }
+        if (waitingEnd) {
+            endRequestBody();
+        }
     }
 
     @Override
     public int requestBodyContent(ByteBuffer data) {
-        if (streamId < 0 || cancelled) {
+        if (cancelled) {
             return 0;
         }
         int remaining = data.remaining();
+        if (waiting) {
+            ByteBuffer copy = ByteBuffer.allocate(remaining);
+            copy.put(data);
+            copy.flip();
+            if (waitingBody == null) {
+                waitingBody = new ArrayList<ByteBuffer>();
+            }
+            waitingBody.add(copy);
+            return remaining;
+        }
+        if (streamId < 0) {
+            return 0;
+        }
         h3Handler.sendRequestBody(streamId, data, false);
         return remaining;
     }
 
     @Override
     public void endRequestBody() {
-        if (streamId < 0 || cancelled) {
+        if (cancelled) {
+            return;
+        }
+        if (waiting) {
+            waitingEnd = true;
+            return;
+        }
+        if (streamId < 0) {
             return;
         }
         ByteBuffer empty = ByteBuffer.allocate(0);
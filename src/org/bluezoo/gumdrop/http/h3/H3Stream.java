@@ -22,6 +22,7 @@
 package org.bluezoo.gumdrop.http.h3;
 
 import java.nio.ByteBuffer;
+import java.nio.channels.FileChannel;
 import java.security.Principal;
 import java.text.MessageFormat;
 import java.util.ArrayList;
@@ -87,6 +88,9 @@ class H3Stream implements HTTPResponseState {
     private static final ByteBuffer EMPTY_BUFFER =
             ByteBuffer.allocate(0).asReadOnlyBuffer();
 
+    /** RFC 9114 section 8.1: H3_INTERNAL_ERROR. */
+    private static final long H3_INTERNAL_ERROR = 0x102;
+
     /**
      * Stream lifecycle states. Maps to the HTTP/3 request/response
      * lifecycle in RFC 9114 section 4.1: a client sends HEADERS
@@ -121,12 +125,19 @@ class H3Stream implements HTTPResponseState {
     private boolean responseBodyStarted;
     private List<Header> pendingResponseHeaders;
 
+    // RFC 9218: priority signalled by the client (header or
+    // PRIORITY_UPDATE), and any override set by the application
+    private H3Priority requestPriority;
+    private H3Priority responsePriority;
+
     private H3WebSocketConnectionAdapter webSocketAdapter;
 
     private boolean readPaused;
 
     private List<ByteBuffer> pendingWriteQueue;
     private boolean pendingFin;
+    private long pendingFileRange; // native h3_file_range, 0 if none
+    private boolean bodyReset; // stream reset after a file body failed
 
     private Span span;
     private long timestampStarted;
@@ -194,6 +205,11 @@ class H3Stream implements HTTPResponseState {
 
             HTTPVersion.stripHttp1FramingHeaders(headers);
 
+            String priority = headers.getValue("priority");
+            if (priority != null) {
+                requestPriority = H3Priority.parse(priority);
+            }
+
             HTTPAuthenticationProvider authProvider =
                     connection.getAuthenticationProvider();
             if (authProvider != null) {
@@ -258,6 +274,19 @@ class H3Stream implements HTTPResponseState {
         }
     }
 
+    /**
+     * Called when a PRIORITY_UPDATE frame reprioritises this request
+     * (RFC 9218 section 7). An application-set priority takes
+     * precedence; otherwise the new priority is applied at once if the
+     * response is already under way.
+     */
+    void onPriorityUpdate(H3Priority priority) {
+        requestPriority = priority;
+        if (responsePriority == null && responseStarted) {
+            applyPriority(priority);
+        }
+    }
+
     /**
      * Called when an h3 RESET event is received (stream aborted by peer).
      * Per RFC 9114 section 8, stream errors are signalled via QUIC
@@ -269,6 +298,7 @@ class H3Stream implements HTTPResponseState {
                     L10N.getString("telemetry.stream_closed_abnormally"));
             span.end();
         }
+        freeFileRange();
         state = State.CLOSED;
         handler = null;
     }
@@ -365,6 +395,8 @@ class H3Stream implements HTTPResponseState {
             LOGGER.log(Level.WARNING,
                     "h3 send informational failed: " + result
                             + " stream=" + streamId);
+        } else {
+            connection.headersSent(headerArray);
         }
         responseStarted = true;
         connection.flushQuic();
@@ -396,6 +428,56 @@ class H3Stream implements HTTPResponseState {
         sendBody(data, false);
     }
 
+    @Override
+    public boolean isFileBodySupported() {
+        return true;
+    }
+
+    /**
+     * Sends the file range by reading it in native code, avoiding the
+     * copy through a pooled buffer that {@link #responseBodyContent}
+     * would make. The reads are from the page cache in the common case;
+     * a file truncated while it is sent resets the stream.
+     */
+    @Override
+    public boolean responseBodyFile(FileChannel file, long position,
+            long count) {
+        if (count <= 0 || pendingFileRange != 0 || webSocketAdapter != null
+                || (pendingWriteQueue != null && !pendingWriteQueue.isEmpty())
+                || pendingFin || bodyReset) {
+            return false;
+        }
+        long range = GumdropNative.h3_file_range_open(file, position, count);
+        if (range == 0) {
+            return false;
+        }
+        // The range holds its own descriptor
+        try {
+            file.close();
+        } catch (IOException e) {
+            LOGGER.log(Level.FINE, "Error closing file channel", e);
+        }
+        if (!responseStarted) {
+            flushHeaders(false);
+            responseBodyStarted = true;
+        }
+        responseBodyBytes += count;
+        pendingFileRange = range;
+        if (!drainFileRange()) {
+            connection.registerPendingWrite(this);
+        }
+        return true;
+    }
+
+    @Override
+    public void setPriority(int urgency, boolean incremental) {
+        H3Priority priority = new H3Priority(urgency, incremental);
+        responsePriority = priority;
+        if (responseStarted && state != State.CLOSED) {
+            applyPriority(priority);
+        }
+    }
+
     @Override
     public void endResponseBody() {
         // Nothing to send here; FIN is sent with complete()
@@ -731,6 +813,7 @@ class H3Stream implements HTTPResponseState {
             span.recordError(ErrorCategory.INTERNAL_ERROR, "Request cancelled");
             span.end();
         }
+        freeFileRange();
         state = State.CLOSED;
         handler = null;
     }
@@ -913,7 +996,13 @@ class H3Stream implements HTTPResponseState {
         long h3Conn = connection.getH3Conn();
         long quicheConn = connection.getQuicheConn();
         int result;
-        if (!responseStarted) {
+        H3Priority priority = (responsePriority != null)
+                ? responsePriority : requestPriority;
+        if (!responseStarted && priority != null) {
+            result = GumdropNative.quiche_h3_send_response_with_priority(
+                    h3Conn, quicheConn, streamId, headerArray,
+                    priority.urgency, priority.incremental, fin);
+        } else if (!responseStarted) {
             result = GumdropNative.quiche_h3_send_response(
                     h3Conn, quicheConn, streamId, headerArray, fin);
         } else {
@@ -926,19 +1015,35 @@ class H3Stream implements HTTPResponseState {
             LOGGER.log(Level.WARNING,
                     "h3 send headers failed: " + result
                             + " stream=" + streamId);
+        } else {
+            connection.headersSent(headerArray);
         }
 
         responseStarted = true;
         connection.flushQuic();
     }
 
+    /**
+     * Changes the scheduling priority of a stream whose response
+     * headers have already been sent.
+     */
+    private void applyPriority(H3Priority priority) {
+        int result = GumdropNative.quiche_conn_stream_priority(
+                connection.getQuicheConn(), streamId,
+                priority.urgency, priority.incremental);
+        if (result < 0 && LOGGER.isLoggable(Level.FINE)) {
+            LOGGER.fine("h3 stream priority failed: " + result
+                    + " stream=" + streamId);
+        }
+    }
+
     /**
      * Returns true if this stream has buffered data waiting for the
      * congestion window to open.
      */
     boolean hasPendingWrites() {
         return (pendingWriteQueue != null && !pendingWriteQueue.isEmpty())
-                || pendingFin;
+                || pendingFileRange != 0 || pendingFin;
     }
 
     /**
@@ -979,6 +1084,10 @@ class H3Stream implements HTTPResponseState {
             ByteBufferPool.release(pendingWriteQueue.remove(0));
         }
 
+        if (pendingFileRange != 0 && !drainFileRange()) {
+            return false;
+        }
+
         if (pendingFin) {
             int result = GumdropNative.quiche_h3_send_body(
                     h3Conn, quicheConn, streamId,
@@ -1007,6 +1116,14 @@ class H3Stream implements HTTPResponseState {
      * will be drained by {@link #resumeWrite()} when ACKs arrive.
      */
     private void sendBody(ByteBuffer data, boolean fin) {
+        if (bodyReset) {
+            return;
+        }
+        if (pendingFileRange != 0 && data.hasRemaining()) {
+            throw new IllegalStateException(
+                    "Response body file range still pending on stream "
+                            + streamId);
+        }
         if (hasPendingWrites()) {
             enqueue(data, fin);
             return;
@@ -1044,6 +1161,70 @@ class H3Stream implements HTTPResponseState {
         connection.flushQuic();
     }
 
+    /**
+     * Feeds the pending file range to quiche until it is exhausted or
+     * the stream runs out of flow-control credit. The range is freed
+     * once fully sent or on an error. If the file can no longer supply
+     * the range the body cannot reach its Content-Length, so the stream
+     * is reset rather than finished (RFC 9114 section 4.1.2).
+     *
+     * @return true if the range is no longer pending
+     */
+    private boolean drainFileRange() {
+        long h3Conn = connection.getH3Conn();
+        long quicheConn = connection.getQuicheConn();
+        while (GumdropNative.h3_file_range_remaining(pendingFileRange) > 0) {
+            long result = GumdropNative.quiche_h3_send_body_file(
+                    h3Conn, quicheConn, streamId, pendingFileRange);
+            connection.flushQuic();
+            if (result == GumdropNative.QUICHE_ERR_DONE) {
+                return false;
+            } else if (result == GumdropNative.H3_FILE_ERR_TRUNCATED
+                    || result == GumdropNative.H3_FILE_ERR_IO) {
+                LOGGER.warning("h3 file body read failed: " + result
+                        + " stream=" + streamId);
+                resetBody();
+                break;
+            } else if (result < 0) {
+                LOGGER.warning("h3 send_body error: " + result
+                        + " stream=" + streamId);
+                break;
+            }
+        }
+        freeFileRange();
+        return true;
+    }
+
+    /**
+     * Abandons the response body with RESET_STREAM, discarding anything
+     * still queued behind it.
+     */
+    private void resetBody() {
+        bodyReset = true;
+        if (pendingWriteQueue != null) {
+            for (ByteBuffer b : pendingWriteQueue) {
+                ByteBufferPool.release(b);
+            }
+            pendingWriteQueue.clear();
+        }
+        pendingFin = false;
+        GumdropNative.quiche_conn_stream_shutdown(
+                connection.getQuicheConn(), streamId, 0, H3_INTERNAL_ERROR);
+        connection.flushQuic();
+        if (span != null && !span.isEnded()) {
+            span.recordError(ErrorCategory.INTERNAL_ERROR,
+                    "Response body file truncated");
+            span.end();
+        }
+    }
+
+    private void freeFileRange() {
+        if (pendingFileRange != 0) {
+            GumdropNative.h3_file_range_free(pendingFileRange);
+            pendingFileRange = 0;
+        }
+    }
+
     /**
      * Buffers remaining data for deferred sending and registers this
      * stream for write resumption.
@@ -36,6 +36,7 @@ import org.bluezoo.gumdrop.http.Headers;
 import org.bluezoo.gumdrop.http.client.HTTPResponseHandler;
 import org.bluezoo.gumdrop.quic.QuicConnection;
 import org.bluezoo.gumdrop.GumdropNative;
+import org.bluezoo.gumdrop.util.DirectByteBufferPool;
 
 /**
  * Client-side HTTP/3 handler built on top of quiche's h3 module.
@@ -68,24 +69,27 @@ public class HTTP3ClientHandler
     private static final Logger LOGGER =
             Logger.getLogger(HTTP3ClientHandler.class.getName());
 
-    /** Default QPACK max dynamic table capacity. */
-    private static final long DEFAULT_QPACK_MAX_TABLE_CAPACITY = 4096;
-
-    /** Buffer size for receiving h3 body data. */
+    /**
+     * Buffer size for receiving h3 body data, leased from
+     * {@link DirectByteBufferPool} only while a stream is being drained.
+     */
     private static final int BODY_BUFFER_SIZE = 65536;
 
     private final QuicConnection quicConnection;
 
-    private long h3Config;
-    private long h3Conn;
-    private final ByteBuffer bodyBuffer;
+    private volatile long h3Conn;
 
     private final Map<Long, H3ClientStream> streams =
             new HashMap<Long, H3ClientStream>();
     private final Map<Long, PendingWrite> pendingWrites =
             new LinkedHashMap<Long, PendingWrite>();
 
-    private boolean goaway;
+    // Requests waiting for the server to raise MAX_STREAMS
+    private final List<Runnable> streamWaiters = new ArrayList<Runnable>();
+
+    // Read off the SelectorLoop by connection pools
+    private volatile boolean goaway;
+    private volatile int activeStreamCount;
 
     /** Callback invoked when the h3 connection is ready for requests. */
     private Runnable readyCallback;
@@ -98,7 +102,6 @@ public class HTTP3ClientHandler
      */
     public HTTP3ClientHandler(QuicConnection quicConnection) {
         this.quicConnection = quicConnection;
-        this.bodyBuffer = ByteBuffer.allocateDirect(BODY_BUFFER_SIZE);
 
         initH3();
         quicConnection.setConnectionReadyHandler(this);
@@ -124,16 +127,56 @@ public class HTTP3ClientHandler
     }
 
     /**
-     * Initialises the quiche h3 config and creates the h3 connection.
+     * Returns whether a new request can be sent on this connection now:
+     * no GOAWAY has been received and the server's MAX_STREAMS limit
+     * (RFC 9000 section 4.6, RFC 9114 section 6.1) leaves room for
+     * another request stream. May be called from any thread.
+     *
+     * @return true if {@link #sendRequest} would get a stream
+     */
+    public boolean canSendRequest() {
+        return !goaway && h3Conn != 0
+                && quicConnection.getPeerStreamsLeftBidi() > 0;
+    }
+
+    /**
+     * Returns the number of requests in flight on this connection.
+     * May be called from any thread.
+     *
+     * @return the number of open request streams
+     */
+    public int getActiveStreamCount() {
+        return activeStreamCount;
+    }
+
+    /**
+     * Runs the given task once a request stream can be opened: as soon
+     * as the server's MAX_STREAMS frame raises the limit, or when the
+     * connection can no longer take requests at all (GOAWAY or close),
+     * in which case {@link #sendRequest} fails the request. Tasks run on
+     * the SelectorLoop, in the order they were queued.
+     *
+     * @param task the task that sends the request
+     */
+    public void awaitStreamCredit(Runnable task) {
+        streamWaiters.add(task);
+    }
+
+    /**
+     * Creates the h3 connection. quiche copies the SETTINGS out of the
+     * config, so the config is freed as soon as the connection exists.
      */
     private void initH3() {
-        h3Config = GumdropNative.quiche_h3_config_new();
-        GumdropNative.quiche_h3_config_set_max_dynamic_table_capacity(
-                h3Config, DEFAULT_QPACK_MAX_TABLE_CAPACITY);
+        long h3Config = GumdropNative.quiche_h3_config_new();
+        GumdropNative.quiche_h3_config_set_qpack_max_table_capacity(
+                h3Config, HTTP3ServerHandler.DEFAULT_QPACK_MAX_TABLE_CAPACITY);
+        GumdropNative.quiche_h3_config_set_max_field_section_size(
+                h3Config, HTTP3ServerHandler.DEFAULT_MAX_FIELD_SECTION_SIZE);
 
         long quicheConn = quicConnection.getConnPtr();
         h3Conn = GumdropNative.quiche_h3_conn_new_with_transport(
                 quicheConn, h3Config);
+        GumdropNative.quiche_h3_config_free(h3Config);
 
         if (h3Conn == 0) {
             LOGGER.severe("Failed to create h3 client connection");
@@ -178,6 +221,11 @@ public class HTTP3ClientHandler
                     "Connection received GOAWAY"));
             return -1;
         }
+        if (h3Conn == 0) {
+            handler.failed(new java.io.IOException(
+                    "HTTP/3 connection closed"));
+            return -1;
+        }
 
         String[] headerArray = new String[headers.size() * 2];
         for (int i = 0; i < headers.size(); i++) {
@@ -189,6 +237,7 @@ public class HTTP3ClientHandler
         long quicheConn = quicConnection.getConnPtr();
         long streamId = GumdropNative.quiche_h3_send_request(
                 h3Conn, quicheConn, headerArray, fin);
+        quicConnection.updatePeerStreamsLeftBidi();
 
         if (streamId < 0) {
             handler.failed(new java.io.IOException(
@@ -199,6 +248,7 @@ public class HTTP3ClientHandler
         H3ClientStream stream = new H3ClientStream(this, streamId,
                                                      handler);
         streams.put(Long.valueOf(streamId), stream);
+        activeStreamCount = streams.size();
 
         flushQuic();
         return streamId;
@@ -270,6 +320,21 @@ public class HTTP3ClientHandler
         }
         pollEvents();
         resumePendingWrites();
+        runStreamWaiters();
+    }
+
+    /**
+     * Sends queued requests while the server allows new streams, or
+     * all of them (to fail) once the connection cannot take any more.
+     */
+    private void runStreamWaiters() {
+        while (!streamWaiters.isEmpty()) {
+            boolean dead = goaway || h3Conn == 0;
+            if (!dead && quicConnection.getPeerStreamsLeftBidi() <= 0) {
+                return;
+            }
+            streamWaiters.remove(0).run();
+        }
     }
 
     // ── Event Polling ──
@@ -339,17 +404,22 @@ public class HTTP3ClientHandler
         }
 
         long quicheConn = quicConnection.getConnPtr();
+        ByteBuffer bodyBuffer = DirectByteBufferPool.acquire(BODY_BUFFER_SIZE);
 
-        while (true) {
-            bodyBuffer.clear();
-            int len = GumdropNative.quiche_h3_recv_body(
-                    h3Conn, quicheConn, streamId,
-                    bodyBuffer, bodyBuffer.capacity());
-            if (len <= 0) {
-                break;
+        try {
+            while (true) {
+                bodyBuffer.clear();
+                int len = GumdropNative.quiche_h3_recv_body(
+                        h3Conn, quicheConn, streamId,
+                        bodyBuffer, bodyBuffer.capacity());
+                if (len <= 0) {
+                    break;
+                }
+                bodyBuffer.limit(len);
+                stream.onData(bodyBuffer);
             }
-            bodyBuffer.limit(len);
-            stream.onData(bodyBuffer);
+        } finally {
+            DirectByteBufferPool.release(bodyBuffer);
         }
     }
 
@@ -358,6 +428,7 @@ public class HTTP3ClientHandler
         if (stream != null) {
             stream.onFinished();
             streams.remove(Long.valueOf(streamId));
+            activeStreamCount = streams.size();
         }
     }
 
@@ -384,6 +455,8 @@ public class HTTP3ClientHandler
                 it.remove();
             }
         }
+        activeStreamCount = streams.size();
+        runStreamWaiters();
     }
 
     private void onReset(long streamId) {
@@ -391,6 +464,7 @@ public class HTTP3ClientHandler
         if (stream != null) {
             stream.onReset();
             streams.remove(Long.valueOf(streamId));
+            activeStreamCount = streams.size();
         }
     }
 
@@ -501,15 +575,13 @@ public class HTTP3ClientHandler
             stream.onReset();
         }
         streams.clear();
+        activeStreamCount = 0;
 
         if (h3Conn != 0) {
             GumdropNative.quiche_h3_conn_free(h3Conn);
             h3Conn = 0;
         }
-        if (h3Config != 0) {
-            GumdropNative.quiche_h3_config_free(h3Config);
-            h3Config = 0;
-        }
+        runStreamWaiters();
     }
 
 }
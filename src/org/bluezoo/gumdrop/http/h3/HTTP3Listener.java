@@ -27,11 +27,13 @@ import java.nio.file.Path;
 import java.util.ArrayList;
 import java.util.Iterator;
 import java.util.List;
+import java.util.Map;
 import java.util.Set;
 import java.util.logging.Level;
 import java.util.logging.Logger;
 
 import org.bluezoo.gumdrop.Gumdrop;
+import org.bluezoo.gumdrop.GumdropNative;
 import org.bluezoo.gumdrop.ProtocolHandler;
 import org.bluezoo.gumdrop.SelectorLoop;
 import org.bluezoo.gumdrop.TCPListener;
@@ -39,9 +41,14 @@ import org.bluezoo.gumdrop.TransportFactory;
 import org.bluezoo.gumdrop.http.HTTPAuthenticationProvider;
 import org.bluezoo.gumdrop.http.HTTPRequestHandlerFactory;
 import org.bluezoo.gumdrop.http.HTTPServerMetrics;
+import org.bluezoo.gumdrop.quic.CongestionProfile;
+import org.bluezoo.gumdrop.quic.ConnectionIdGenerator;
+import org.bluezoo.gumdrop.quic.NativeMemory;
 import org.bluezoo.gumdrop.quic.QuicConnection;
 import org.bluezoo.gumdrop.quic.QuicEngine;
 import org.bluezoo.gumdrop.quic.QuicTransportFactory;
+import org.bluezoo.gumdrop.quic.ReceiveDelayListener;
+import org.bluezoo.gumdrop.quic.SessionTicketKeys;
 
 /**
  * QUIC transport listener for HTTP/3 connections.
@@ -79,6 +86,21 @@ public class HTTP3Listener extends TCPListener
 
     private Path certFile;
     private Path keyFile;
+    private Map<String, String> sniCertificates;
+    private Path sniCertificateDirectory;
+    private SessionTicketKeys sessionTicketKeys;
+    private ConnectionIdGenerator connectionIdGenerator;
+    private long certificateCheckInterval;
+    private int maxHalfOpenHandshakes;
+    private int handshakeRate;
+    private int handshakeBurst;
+    private int privateKeyThreads;
+    private int maxUdpPayloadSize;
+    private boolean pmtuDiscovery;
+    private boolean receiveTimestamps;
+    private long nativeMemoryLimit;
+    private String congestionProfile;
+    private Map<String, String> congestionProfileNetworks;
 
     // RFC 9000 section 18: configurable QUIC transport parameters
     private long quicMaxIdleTimeout = -1;
@@ -88,6 +110,20 @@ public class HTTP3Listener extends TCPListener
     private long quicMaxStreamDataUni = -1;
     private long quicMaxStreamsBidi = -1;
     private long quicMaxStreamsUni = -1;
+    private long quicMaxConnectionWindow = -1;
+    private long quicMaxStreamWindow = -1;
+    private String certificateCompression;
+
+    // RFC 9114 section 7.2.4.1 / RFC 9204 section 5: SETTINGS
+    private long qpackMaxTableCapacity =
+            HTTP3ServerHandler.DEFAULT_QPACK_MAX_TABLE_CAPACITY;
+    private long qpackBlockedStreams =
+            HTTP3ServerHandler.DEFAULT_QPACK_BLOCKED_STREAMS;
+    private long maxFieldSectionSize =
+            HTTP3ServerHandler.DEFAULT_MAX_FIELD_SECTION_SIZE;
+
+    // One h3 config shared by every connection on this listener
+    private long h3Config;
 
     private final List<QuicEngine> engines =
             new ArrayList<QuicEngine>();
@@ -137,6 +173,188 @@ public class HTTP3Listener extends TCPListener
         this.keyFile = Path.of(path);
     }
 
+    /**
+     * XML: {@code sni-certificates}. PEM certificate files by server
+     * name, for serving many domains from one listener. Each value is a
+     * file holding the chain and key, or the chain and key files
+     * separated by a comma.
+     *
+     * @param certificates the certificate files by server name
+     * @see QuicTransportFactory#setSniCertificates
+     */
+    public void setSniCertificates(Map<String, String> certificates) {
+        this.sniCertificates = certificates;
+    }
+
+    /**
+     * XML: {@code sni-certificate-directory}. A directory of
+     * {@code <name>.pem} and {@code <name>-key.pem} files for server
+     * names, loaded when the listener starts.
+     *
+     * @param dir the certificate directory
+     * @see QuicTransportFactory#setSniCertificateDirectory(Path)
+     */
+    public void setSniCertificateDirectory(Path dir) {
+        this.sniCertificateDirectory = dir;
+    }
+
+    public void setSniCertificateDirectory(String dir) {
+        this.sniCertificateDirectory = Path.of(dir);
+    }
+
+    /**
+     * XML: {@code session-ticket-keys}. Shares session ticket keys with
+     * other listeners and cluster nodes so that clients can resume on
+     * any of them.
+     *
+     * @param keys the shared ticket keys
+     */
+    public void setSessionTicketKeys(SessionTicketKeys keys) {
+        this.sessionTicketKeys = keys;
+    }
+
+    /**
+     * XML: {@code connection-id-generator}. Generates the connection IDs
+     * this listener issues, for example a
+     * {@link org.bluezoo.gumdrop.quic.QuicLbConnectionIdGenerator} so
+     * that a load balancer can route each connection to this node.
+     *
+     * @param generator the connection ID generator
+     */
+    public void setConnectionIdGenerator(ConnectionIdGenerator generator) {
+        this.connectionIdGenerator = generator;
+    }
+
+    /**
+     * XML: {@code certificate-check-interval} (milliseconds). How often
+     * to check the certificate and key files for changes and reload
+     * them without dropping connections. 0 (the default) disables the
+     * check.
+     *
+     * @param ms the check interval in milliseconds
+     */
+    public void setCertificateCheckInterval(long ms) {
+        this.certificateCheckInterval = ms;
+    }
+
+    /**
+     * XML: {@code max-half-open-handshakes}. The most connections that
+     * may be handshaking at once; clients are asked to validate their
+     * address beyond half of this and refused beyond it. 0 (the
+     * default) sets no limit.
+     */
+    public void setMaxHalfOpenHandshakes(int max) {
+        this.maxHalfOpenHandshakes = max;
+    }
+
+    /**
+     * XML: {@code handshake-rate}. The most handshakes started per
+     * second. 0 (the default) sets no limit.
+     */
+    public void setHandshakeRate(int perSecond) {
+        this.handshakeRate = perSecond;
+    }
+
+    /** XML: {@code handshake-burst}. Defaults to the handshake rate. */
+    public void setHandshakeBurst(int burst) {
+        this.handshakeBurst = burst;
+    }
+
+    /**
+     * XML: {@code private-key-threads}. The number of native threads
+     * that compute handshake signatures off the SelectorLoop. 0 (the
+     * default) signs on the loop.
+     *
+     * @see QuicTransportFactory#setPrivateKeyThreads
+     */
+    public void setPrivateKeyThreads(int threads) {
+        this.privateKeyThreads = threads;
+    }
+
+    /**
+     * XML: {@code max-udp-payload-size} (bytes). The largest UDP payload
+     * sent or accepted (default 1350). Raise it towards the link MTU
+     * less 48 bytes on networks with jumbo frames.
+     *
+     * @see QuicTransportFactory#setMaxUdpPayloadSize
+     */
+    public void setMaxUdpPayloadSize(int size) {
+        this.maxUdpPayloadSize = size;
+    }
+
+    /**
+     * XML: {@code pmtu-discovery}. Probes each path for the largest
+     * datagram it carries, up to {@code max-udp-payload-size}
+     * (RFC 8899). Off by default.
+     *
+     * @see QuicTransportFactory#setPmtuDiscovery
+     */
+    public void setPmtuDiscovery(boolean enabled) {
+        this.pmtuDiscovery = enabled;
+    }
+
+    /**
+     * XML: {@code receive-timestamps}. Has the kernel timestamp received
+     * datagrams (Linux) and records how long each waited to be read in
+     * the {@code http.server.receive.delay} metric. Off by default.
+     *
+     * @see QuicTransportFactory#setReceiveTimestamps
+     */
+    public void setReceiveTimestamps(boolean enabled) {
+        this.receiveTimestamps = enabled;
+    }
+
+    /**
+     * XML: {@code native-memory-limit}. A ceiling in bytes on the native
+     * memory used by quiche, BoringSSL and the JNI layer: near it new
+     * connections get reduced windows, and at it they are refused.
+     * 0, the default, sets no limit.
+     *
+     * @see QuicTransportFactory#setNativeMemoryLimit
+     */
+    public void setNativeMemoryLimit(long bytes) {
+        this.nativeMemoryLimit = bytes;
+    }
+
+    /**
+     * XML: {@code congestion-profile}. The congestion control profile
+     * for connections: {@code bulk-bbr2}, {@code interactive-cubic} or
+     * {@code datacenter}. Unset, quiche's CUBIC defaults apply.
+     *
+     * @see CongestionProfile
+     */
+    public void setCongestionProfile(String name) {
+        CongestionProfile.forName(name); // fail at configuration time
+        this.congestionProfile = name;
+    }
+
+    /**
+     * XML: {@code congestion-profile-networks}. Congestion profile
+     * names by client CIDR block, overriding {@code congestion-profile}
+     * for clients in those networks; the first matching block applies.
+     *
+     * @see QuicTransportFactory#setCongestionProfileNetworks
+     */
+    public void setCongestionProfileNetworks(Map<String, String> networks) {
+        this.congestionProfileNetworks = networks;
+    }
+
+    /**
+     * Reloads the certificate and key files. New connections use the
+     * new certificates; established ones keep theirs.
+     *
+     * @throws IllegalStateException if the listener is not started
+     * @see QuicTransportFactory#reloadCertificates
+     */
+    public void reloadCertificates() {
+        QuicTransportFactory factory =
+                (QuicTransportFactory) getTransportFactory();
+        if (factory == null) {
+            throw new IllegalStateException("Listener not started");
+        }
+        factory.reloadCertificates();
+    }
+
     /**
      * Sets the handler factory for this endpoint.
      *
@@ -233,6 +451,33 @@ public class HTTP3Listener extends TCPListener
     public void setQuicMaxStreamsBidi(long count) { this.quicMaxStreamsBidi = count; }
     /** XML: {@code quic-max-streams-uni} (count) */
     public void setQuicMaxStreamsUni(long count) { this.quicMaxStreamsUni = count; }
+    /** XML: {@code quic-max-connection-window} (bytes, auto-tuning ceiling) */
+    public void setQuicMaxConnectionWindow(long bytes) { this.quicMaxConnectionWindow = bytes; }
+    /** XML: {@code quic-max-stream-window} (bytes, auto-tuning ceiling) */
+    public void setQuicMaxStreamWindow(long bytes) { this.quicMaxStreamWindow = bytes; }
+    /**
+     * XML: {@code certificate-compression}. RFC 8879 algorithms, e.g.
+     * {@code brotli,zlib} (the default) or {@code none}.
+     */
+    public void setCertificateCompression(String algorithms) { this.certificateCompression = algorithms; }
+
+    // ── RFC 9114 / RFC 9204: HTTP/3 SETTINGS ──
+
+    /**
+     * XML: {@code qpack-max-table-capacity} (bytes). The QPACK dynamic
+     * table capacity the peer's encoder may use (default 0). quiche's
+     * QPACK decoder does not yet implement the dynamic table, so only
+     * raise this with a quiche build that does.
+     */
+    public void setQpackMaxTableCapacity(long bytes) { this.qpackMaxTableCapacity = bytes; }
+    /** XML: {@code qpack-blocked-streams} (count, default 0) */
+    public void setQpackBlockedStreams(long count) { this.qpackBlockedStreams = count; }
+    /**
+     * XML: {@code max-field-section-size} (bytes). The largest request
+     * header section accepted, counted per RFC 9114 section 4.2.2
+     * (default 16384).
+     */
+    public void setMaxFieldSectionSize(long bytes) { this.maxFieldSectionSize = bytes; }
 
     // ── Lifecycle ──
 
@@ -252,6 +497,30 @@ public class HTTP3Listener extends TCPListener
         if (keyFile != null) {
             factory.setKeyFile(keyFile);
         }
+        if (sniCertificates != null) {
+            factory.setSniCertificates(sniCertificates);
+        }
+        if (sniCertificateDirectory != null) {
+            factory.setSniCertificateDirectory(sniCertificateDirectory);
+        }
+        factory.setSessionTicketKeys(sessionTicketKeys);
+        factory.setConnectionIdGenerator(connectionIdGenerator);
+        factory.setCertificateCheckInterval(certificateCheckInterval);
+        factory.setMaxHalfOpenHandshakes(maxHalfOpenHandshakes);
+        factory.setHandshakeRate(handshakeRate);
+        factory.setHandshakeBurst(handshakeBurst);
+        factory.setPrivateKeyThreads(privateKeyThreads);
+        if (maxUdpPayloadSize > 0) {
+            factory.setMaxUdpPayloadSize(maxUdpPayloadSize);
+        }
+        factory.setPmtuDiscovery(pmtuDiscovery);
+        factory.setReceiveTimestamps(receiveTimestamps);
+        factory.setNativeMemoryLimit(nativeMemoryLimit);
+        if (congestionProfile != null) {
+            factory.setCongestionProfile(congestionProfile);
+        }
+        factory.setCongestionProfileNetworks(congestionProfileNetworks);
+        factory.setConnectionRateLimiter(getConnectionRateLimiter());
         // RFC 9000 section 18: apply configured transport parameters
         if (quicMaxIdleTimeout >= 0) { factory.setMaxIdleTimeout(quicMaxIdleTimeout); }
         if (quicMaxData >= 0) { factory.setMaxData(quicMaxData); }
@@ -260,6 +529,9 @@ public class HTTP3Listener extends TCPListener
         if (quicMaxStreamDataUni >= 0) { factory.setMaxStreamDataUni(quicMaxStreamDataUni); }
         if (quicMaxStreamsBidi >= 0) { factory.setMaxStreamsBidi(quicMaxStreamsBidi); }
         if (quicMaxStreamsUni >= 0) { factory.setMaxStreamsUni(quicMaxStreamsUni); }
+        if (quicMaxConnectionWindow >= 0) { factory.setMaxConnectionWindow(quicMaxConnectionWindow); }
+        if (quicMaxStreamWindow >= 0) { factory.setMaxStreamWindow(quicMaxStreamWindow); }
+        if (certificateCompression != null) { factory.setCertificateCompression(certificateCompression); }
         return factory;
     }
 
@@ -279,6 +551,18 @@ public class HTTP3Listener extends TCPListener
             super.start();
             if (isMetricsEnabled()) {
                 metrics = new HTTPServerMetrics(getTelemetryConfig());
+                NativeMemory.registerMetrics(getTelemetryConfig());
+                if (receiveTimestamps) {
+                    final HTTPServerMetrics m = metrics;
+                    QuicTransportFactory factory =
+                            (QuicTransportFactory) getTransportFactory();
+                    factory.setReceiveDelayListener(new ReceiveDelayListener() {
+                        @Override
+                        public void receiveDelay(long nanos) {
+                            m.datagramReceived(nanos / 1e6);
+                        }
+                    });
+                }
             }
             // Unlike TCP-accept listeners (which register with the accept
             // loop lazily and don't actually bind until Gumdrop.start()
@@ -317,6 +601,11 @@ public class HTTP3Listener extends TCPListener
     private void bindEngines() {
         QuicTransportFactory factory =
                 (QuicTransportFactory) getTransportFactory();
+        if (h3Config == 0) {
+            h3Config = HTTP3ServerHandler.createH3Config(
+                    qpackMaxTableCapacity, qpackBlockedStreams,
+                    maxFieldSectionSize);
+        }
 
         Set<InetAddress> addrs = getAddresses();
         for (Iterator<InetAddress> it = addrs.iterator();
@@ -345,15 +634,33 @@ public class HTTP3Listener extends TCPListener
             engines.get(i).close();
         }
         engines.clear();
+        if (h3Config != 0) {
+            GumdropNative.quiche_h3_config_free(h3Config);
+            h3Config = 0;
+        }
     }
 
     // ── ConnectionAcceptedHandler ──
 
     @Override
     public void connectionAccepted(QuicConnection connection) {
-        new HTTP3ServerHandler(connection, handlerFactory,
-                authenticationProvider, metrics,
+        createServerHandler(connection);
+    }
+
+    /**
+     * Creates the HTTP/3 handler for an accepted QUIC connection,
+     * configured with this listener's SETTINGS.
+     *
+     * @param connection the accepted connection
+     * @return the handler, already attached to the connection
+     */
+    protected HTTP3ServerHandler createServerHandler(
+            QuicConnection connection) {
+        HTTP3ServerHandler handler = new HTTP3ServerHandler(connection,
+                handlerFactory, authenticationProvider, metrics,
                 getTelemetryConfig(), addSecurityHeaders);
+        handler.setSharedH3Config(h3Config);
+        return handler;
     }
 
     /**
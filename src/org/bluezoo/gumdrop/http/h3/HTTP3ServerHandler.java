@@ -41,6 +41,7 @@ import org.bluezoo.gumdrop.quic.QuicConnection;
 import org.bluezoo.gumdrop.GumdropNative;
 import org.bluezoo.gumdrop.telemetry.TelemetryConfig;
 import org.bluezoo.gumdrop.telemetry.Trace;
+import org.bluezoo.gumdrop.util.DirectByteBufferPool;
 
 /**
  * Server-side HTTP/3 handler built on top of quiche's h3 module.
@@ -99,11 +100,28 @@ public class HTTP3ServerHandler
     static final int H3_EVENT_GOAWAY = 3;
     /** H3 event type: Stream reset. */
     static final int H3_EVENT_RESET = 4;
+    /** H3 event type: PRIORITY_UPDATE frame received (RFC 9218). */
+    static final int H3_EVENT_PRIORITY_UPDATE = 5;
 
-    /** Default QPACK max dynamic table capacity. */
-    private static final long DEFAULT_QPACK_MAX_TABLE_CAPACITY = 4096;
+    /**
+     * Default QPACK max dynamic table capacity (RFC 9204 section 5).
+     * quiche's QPACK decoder does not implement the dynamic table, so
+     * advertising a non-zero capacity would invite peers to send
+     * references it cannot decode.
+     */
+    static final long DEFAULT_QPACK_MAX_TABLE_CAPACITY = 0;
+
+    /** Default QPACK blocked streams (RFC 9204 section 5). */
+    static final long DEFAULT_QPACK_BLOCKED_STREAMS = 0;
 
-    /** Buffer size for receiving h3 body data. */
+    /** Default SETTINGS_MAX_FIELD_SECTION_SIZE (RFC 9114 section 4.2.2). */
+    static final long DEFAULT_MAX_FIELD_SECTION_SIZE = 16384;
+
+    /**
+     * Buffer size for receiving h3 body data. The buffer is leased from
+     * {@link DirectByteBufferPool} only while a stream is being drained,
+     * so idle connections hold no receive buffer.
+     */
     private static final int BODY_BUFFER_SIZE = 65536;
 
     private final QuicConnection quicConnection;
@@ -113,9 +131,16 @@ public class HTTP3ServerHandler
     private final TelemetryConfig telemetryConfig;
     private final boolean addSecurityHeaders;
 
-    private long h3Config;
+    // Shared h3 config owned by the listener; never freed here
+    private long sharedH3Config;
     private long h3Conn;
-    private final ByteBuffer bodyBuffer;
+
+    // Header compression accounting (field name + value bytes vs the
+    // QPACKFieldSize estimate of the HEADERS frame payload)
+    private long headerBytesReceived;
+    private long headerBytesReceivedEstimated;
+    private long headerBytesSent;
+    private long headerBytesSentEstimated;
 
     private final Map<Long, H3Stream> streams =
             new HashMap<Long, H3Stream>();
@@ -154,7 +179,6 @@ public class HTTP3ServerHandler
         this.metrics = metrics;
         this.telemetryConfig = telemetryConfig;
         this.addSecurityHeaders = addSecurityHeaders;
-        this.bodyBuffer = ByteBuffer.allocateDirect(BODY_BUFFER_SIZE);
 
         if (metrics != null) {
             metrics.connectionOpened();
@@ -164,23 +188,69 @@ public class HTTP3ServerHandler
     }
 
     /**
-     * Initialises the quiche h3 config and creates the h3 connection.
-     * Configures QPACK dynamic table capacity (RFC 9204 section 3.2.3)
-     * and exchanges the initial SETTINGS frame (RFC 9114 section 7.2.4).
+     * Creates a quiche h3 config carrying the given SETTINGS.
+     * Configures QPACK (RFC 9204 section 5) and the field section size
+     * limit (RFC 9114 section 4.2.2) advertised in the initial SETTINGS
+     * frame (RFC 9114 section 7.2.4).
+     *
+     * <p>quiche copies these values into each h3 connection when it is
+     * created, so one config can be shared by every connection on a
+     * listener. The caller owns the returned config and must free it
+     * with {@code quiche_h3_config_free}.
+     *
+     * @param qpackMaxTableCapacity SETTINGS_QPACK_MAX_TABLE_CAPACITY
+     * @param qpackBlockedStreams SETTINGS_QPACK_BLOCKED_STREAMS
+     * @param maxFieldSectionSize SETTINGS_MAX_FIELD_SECTION_SIZE
+     * @return the native config pointer
      */
-    private void initH3() {
-        h3Config = GumdropNative.quiche_h3_config_new();
-        // RFC 9204 section 3.2.3 — QPACK dynamic table capacity
-        GumdropNative.quiche_h3_config_set_max_dynamic_table_capacity(
-                h3Config, DEFAULT_QPACK_MAX_TABLE_CAPACITY);
+    static long createH3Config(long qpackMaxTableCapacity,
+                               long qpackBlockedStreams,
+                               long maxFieldSectionSize) {
+        long config = GumdropNative.quiche_h3_config_new();
+        GumdropNative.quiche_h3_config_set_qpack_max_table_capacity(
+                config, qpackMaxTableCapacity);
+        GumdropNative.quiche_h3_config_set_qpack_blocked_streams(
+                config, qpackBlockedStreams);
+        GumdropNative.quiche_h3_config_set_max_field_section_size(
+                config, maxFieldSectionSize);
         // RFC 9220 section 2 — advertise Extended CONNECT support
         GumdropNative.quiche_h3_config_enable_extended_connect(
-                h3Config, true);
+                config, true);
+        return config;
+    }
+
+    /**
+     * Uses a config shared with other connections (see
+     * {@link #createH3Config}) instead of a private one. The config
+     * remains owned by the caller and must stay valid until the
+     * connection becomes ready. Must be called before the connection
+     * becomes ready.
+     *
+     * @param h3Config the shared native config pointer
+     */
+    void setSharedH3Config(long h3Config) {
+        this.sharedH3Config = h3Config;
+    }
+
+    /**
+     * Creates the h3 connection from the shared config, or from a
+     * temporary config with default SETTINGS if none was supplied.
+     */
+    private void initH3() {
+        long h3Config = sharedH3Config;
+        if (h3Config == 0) {
+            h3Config = createH3Config(DEFAULT_QPACK_MAX_TABLE_CAPACITY,
+                    DEFAULT_QPACK_BLOCKED_STREAMS,
+                    DEFAULT_MAX_FIELD_SECTION_SIZE);
+        }
 
         long quicheConn = quicConnection.getConnPtr();
         h3Conn = GumdropNative.quiche_h3_conn_new_with_transport(
                 quicheConn, h3Config);
 
+        if (h3Config != sharedH3Config) {
+            GumdropNative.quiche_h3_config_free(h3Config);
+        }
         if (h3Conn == 0) {
             LOGGER.severe("Failed to create h3 connection");
         }
@@ -192,6 +262,9 @@ public class HTTP3ServerHandler
     public void onConnectionReady() {
         if (h3Conn == 0) {
             initH3();
+            if (h3Conn != 0 && quicConnection.isDraining()) {
+                sendDrainGoaway();
+            }
         }
         if (h3Conn != 0) {
             pollEvents();
@@ -237,6 +310,9 @@ public class HTTP3ServerHandler
                 case H3_EVENT_RESET:
                     onReset(streamId);
                     break;
+                case H3_EVENT_PRIORITY_UPDATE:
+                    onPriorityUpdate(streamId);
+                    break;
                 default:
                     if (LOGGER.isLoggable(Level.FINE)) {
                         LOGGER.fine("Unknown h3 event type: " +
@@ -254,6 +330,13 @@ public class HTTP3ServerHandler
         if (headerPairs == null) {
             return;
         }
+        long decoded = QPACKFieldSize.decodedSize(headerPairs);
+        long estimated = QPACKFieldSize.encodedSize(headerPairs);
+        headerBytesReceived += decoded;
+        headerBytesReceivedEstimated += estimated;
+        if (metrics != null) {
+            metrics.headersReceived(decoded, estimated);
+        }
 
         H3Stream stream = getOrCreateStream(streamId);
         if (stream == null) {
@@ -289,25 +372,30 @@ public class HTTP3ServerHandler
     private void drainBody(H3Stream stream, long streamId) {
         long quicheConn = quicConnection.getConnPtr();
         boolean wsMode = stream.isWebSocketUpgraded();
-
-        while (true) {
-            bodyBuffer.clear();
-            int len = GumdropNative.quiche_h3_recv_body(
-                    h3Conn, quicheConn, streamId,
-                    bodyBuffer, bodyBuffer.capacity());
-            if (len <= 0) {
-                break;
-            }
-            bodyBuffer.limit(len);
-            if (wsMode) {
-                stream.onWebSocketData(bodyBuffer);
-            } else {
-                stream.onData(bodyBuffer);
-            }
-            if (stream.isReadPaused()) {
-                deferredReadStreams.add(stream);
-                break;
+        ByteBuffer bodyBuffer = DirectByteBufferPool.acquire(BODY_BUFFER_SIZE);
+
+        try {
+            while (true) {
+                bodyBuffer.clear();
+                int len = GumdropNative.quiche_h3_recv_body(
+                        h3Conn, quicheConn, streamId,
+                        bodyBuffer, bodyBuffer.capacity());
+                if (len <= 0) {
+                    break;
+                }
+                bodyBuffer.limit(len);
+                if (wsMode) {
+                    stream.onWebSocketData(bodyBuffer);
+                } else {
+                    stream.onData(bodyBuffer);
+                }
+                if (stream.isReadPaused()) {
+                    deferredReadStreams.add(stream);
+                    break;
+                }
             }
+        } finally {
+            DirectByteBufferPool.release(bodyBuffer);
         }
     }
 
@@ -346,6 +434,29 @@ public class HTTP3ServerHandler
         }
     }
 
+    @Override
+    public void onDrain() {
+        if (h3Conn != 0) {
+            sendDrainGoaway();
+            flushQuic();
+        }
+    }
+
+    // RFC 9114 section 5.2: the server is going away. The GOAWAY names
+    // the first request stream we will not process, so every request
+    // already accepted completes and the client sends further ones on
+    // a new connection, which the replacement process accepts.
+    private void sendDrainGoaway() {
+        long streamId = (highestClientStreamId >= 0)
+                ? highestClientStreamId + 4 : 0;
+        int rc = GumdropNative.quiche_h3_send_goaway(
+                h3Conn, quicConnection.getConnPtr(), streamId);
+        if (LOGGER.isLoggable(Level.FINE)) {
+            LOGGER.fine("Draining: sent GOAWAY " + streamId
+                    + (rc < 0 ? " failed: " + rc : ""));
+        }
+    }
+
     // RFC 9114 section 8 — stream error via QUIC RESET_STREAM
     private void onReset(long streamId) {
         H3Stream stream = streams.get(Long.valueOf(streamId));
@@ -355,6 +466,35 @@ public class HTTP3ServerHandler
         }
     }
 
+    // RFC 9218 section 7 — client reprioritises a request. The stream
+    // leaves the map once the request FIN arrives, but its response may
+    // still be queued for writing; failing that, reprioritise the QUIC
+    // stream directly.
+    private void onPriorityUpdate(long streamId) {
+        String value = GumdropNative.quiche_h3_take_last_priority_update(
+                h3Conn, streamId);
+        if (value == null) {
+            return;
+        }
+        H3Priority priority = H3Priority.parse(value);
+        H3Stream stream = streams.get(Long.valueOf(streamId));
+        if (stream == null) {
+            for (H3Stream pending : pendingWriteStreams) {
+                if (pending.getStreamId() == streamId) {
+                    stream = pending;
+                    break;
+                }
+            }
+        }
+        if (stream != null) {
+            stream.onPriorityUpdate(priority);
+        } else {
+            GumdropNative.quiche_conn_stream_priority(
+                    quicConnection.getConnPtr(), streamId,
+                    priority.urgency, priority.incremental);
+        }
+    }
+
     /**
      * Returns the existing stream or creates a new one.
      */
@@ -396,6 +536,61 @@ public class HTTP3ServerHandler
         return quicConnection.getConnPtr();
     }
 
+    /**
+     * Accounts for a field section sent on this connection.
+     *
+     * @param headerPairs flat array of alternating name/value pairs
+     */
+    void headersSent(String[] headerPairs) {
+        long decoded = QPACKFieldSize.decodedSize(headerPairs);
+        long estimated = QPACKFieldSize.encodedSize(headerPairs);
+        headerBytesSent += decoded;
+        headerBytesSentEstimated += estimated;
+        if (metrics != null) {
+            metrics.headersSent(decoded, estimated);
+        }
+    }
+
+    /**
+     * Returns the total size (name and value bytes) of the request
+     * header and trailer sections received on this connection.
+     */
+    public long getHeaderBytesReceived() {
+        return headerBytesReceived;
+    }
+
+    /**
+     * Returns an estimate of the QPACK-encoded size of the request
+     * header and trailer sections received on this connection.
+     * quiche does not report the size of the HEADERS frames it decodes,
+     * so this is the size {@link QPACKFieldSize} computes for the decoded
+     * fields. While the advertised QPACK table capacity is 0 the peer is
+     * limited to the same static-table encodings; it may still choose
+     * not to Huffman-code, so the actual size can be larger.
+     */
+    public long getHeaderBytesReceivedEstimated() {
+        return headerBytesReceivedEstimated;
+    }
+
+    /**
+     * Returns the total size (name and value bytes) of the response
+     * header sections sent on this connection, before QPACK encoding.
+     */
+    public long getHeaderBytesSent() {
+        return headerBytesSent;
+    }
+
+    /**
+     * Returns an estimate of the QPACK-encoded size of the response
+     * header sections sent on this connection. quiche does not report
+     * what its encoder wrote, so this is computed by
+     * {@link QPACKFieldSize} from a model of that encoder. Compare with
+     * {@link #getHeaderBytesSent()} for the compression achieved.
+     */
+    public long getHeaderBytesSentEstimated() {
+        return headerBytesSentEstimated;
+    }
+
     /**
      * Creates an {@link HTTPRequestHandler} for a new stream.
      *
@@ -587,15 +782,17 @@ public class HTTP3ServerHandler
         if (metrics != null) {
             metrics.connectionClosed();
         }
+        if (LOGGER.isLoggable(Level.FINE) && headerBytesSent > 0) {
+            LOGGER.fine("h3 header bytes: received=" + headerBytesReceived
+                    + " receivedEstimated=" + headerBytesReceivedEstimated
+                    + " sent=" + headerBytesSent
+                    + " sentEstimated=" + headerBytesSentEstimated);
+        }
 
         if (h3Conn != 0) {
             GumdropNative.quiche_h3_conn_free(h3Conn);
             h3Conn = 0;
         }
-        if (h3Config != 0) {
-            GumdropNative.quiche_h3_config_free(h3Config);
-            h3Config = 0;
-        }
     }
 
 }
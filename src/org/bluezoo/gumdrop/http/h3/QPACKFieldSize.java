@@ -0,0 +1,258 @@
+/*
+ * QPACKFieldSize.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.http.h3;
+
+import java.nio.charset.StandardCharsets;
+import java.util.HashMap;
+import java.util.Locale;
+import java.util.Map;
+
+import org.bluezoo.gumdrop.http.hpack.Huffman;
+
+/**
+ * Computes the sizes of HTTP/3 field sections for header compression
+ * accounting.
+ *
+ * <p>quiche's QPACK encoder does not use the dynamic table: every field
+ * line is either an indexed static-table reference, a literal with a
+ * static name reference, or a literal with a literal name (RFC 9204
+ * section 4.5), with strings Huffman-coded whenever that is shorter.
+ * That makes the encoded size of a field section we send a pure function
+ * of its fields, which this class computes without encoding anything.
+ * quiche exposes neither the encoded bytes nor their size, so the result
+ * is an estimate: it tracks quiche's encoder, and is only a model of what
+ * a peer's encoder sent us.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ * @see <a href="https://www.rfc-editor.org/rfc/rfc9204#appendix-A">RFC 9204 Appendix A</a>
+ */
+final class QPACKFieldSize {
+
+    /** RFC 9204 Appendix A: the QPACK static table. */
+    private static final String[][] STATIC_TABLE = {
+        { ":authority", "" },
+        { ":path", "/" },
+        { "age", "0" },
+        { "content-disposition", "" },
+        { "content-length", "0" },
+        { "cookie", "" },
+        { "date", "" },
+        { "etag", "" },
+        { "if-modified-since", "" },
+        { "if-none-match", "" },
+        { "last-modified", "" },
+        { "link", "" },
+        { "location", "" },
+        { "referer", "" },
+        { "set-cookie", "" },
+        { ":method", "CONNECT" },
+        { ":method", "DELETE" },
+        { ":method", "GET" },
+        { ":method", "HEAD" },
+        { ":method", "OPTIONS" },
+        { ":method", "POST" },
+        { ":method", "PUT" },
+        { ":scheme", "http" },
+        { ":scheme", "https" },
+        { ":status", "103" },
+        { ":status", "200" },
+        { ":status", "304" },
+        { ":status", "404" },
+        { ":status", "503" },
+        { "accept", "*/*" },
+        { "accept", "application/dns-message" },
+        { "accept-encoding", "gzip, deflate, br" },
+        { "accept-ranges", "bytes" },
+        { "access-control-allow-headers", "cache-control" },
+        { "access-control-allow-headers", "content-type" },
+        { "access-control-allow-origin", "*" },
+        { "cache-control", "max-age=0" },
+        { "cache-control", "max-age=2592000" },
+        { "cache-control", "max-age=604800" },
+        { "cache-control", "no-cache" },
+        { "cache-control", "no-store" },
+        { "cache-control", "public, max-age=31536000" },
+        { "content-encoding", "br" },
+        { "content-encoding", "gzip" },
+        { "content-type", "application/dns-message" },
+        { "content-type", "application/javascript" },
+        { "content-type", "application/json" },
+        { "content-type", "application/x-www-form-urlencoded" },
+        { "content-type", "image/gif" },
+        { "content-type", "image/jpeg" },
+        { "content-type", "image/png" },
+        { "content-type", "text/css" },
+        { "content-type", "text/html; charset=utf-8" },
+        { "content-type", "text/plain" },
+        { "content-type", "text/plain;charset=utf-8" },
+        { "range", "bytes=0-" },
+        { "strict-transport-security", "max-age=31536000" },
+        { "strict-transport-security",
+          "max-age=31536000; includesubdomains" },
+        { "strict-transport-security",
+          "max-age=31536000; includesubdomains; preload" },
+        { "vary", "accept-encoding" },
+        { "vary", "origin" },
+        { "x-content-type-options", "nosniff" },
+        { "x-xss-protection", "1; mode=block" },
+        { ":status", "100" },
+        { ":status", "204" },
+        { ":status", "206" },
+        { ":status", "302" },
+        { ":status", "400" },
+        { ":status", "403" },
+        { ":status", "421" },
+        { ":status", "425" },
+        { ":status", "500" },
+        { "accept-language", "" },
+        { "access-control-allow-credentials", "FALSE" },
+        { "access-control-allow-credentials", "TRUE" },
+        { "access-control-allow-headers", "*" },
+        { "access-control-allow-methods", "get" },
+        { "access-control-allow-methods", "get, post, options" },
+        { "access-control-allow-methods", "options" },
+        { "access-control-expose-headers", "content-length" },
+        { "access-control-request-headers", "content-type" },
+        { "access-control-request-method", "get" },
+        { "access-control-request-method", "post" },
+        { "alt-svc", "clear" },
+        { "authorization", "" },
+        { "content-security-policy",
+          "script-src 'none'; object-src 'none'; base-uri 'none'" },
+        { "early-data", "1" },
+        { "expect-ct", "" },
+        { "forwarded", "" },
+        { "if-range", "" },
+        { "origin", "" },
+        { "purpose", "prefetch" },
+        { "server", "" },
+        { "timing-allow-origin", "*" },
+        { "upgrade-insecure-requests", "1" },
+        { "user-agent", "" },
+        { "x-forwarded-for", "" },
+        { "x-frame-options", "deny" },
+        { "x-frame-options", "sameorigin" },
+    };
+
+    // name -> index of first entry with that name
+    private static final Map<String, Integer> NAME_INDEX =
+            new HashMap<String, Integer>();
+    // name + '\0' + value -> index
+    private static final Map<String, Integer> FIELD_INDEX =
+            new HashMap<String, Integer>();
+
+    static {
+        for (int i = 0; i < STATIC_TABLE.length; i++) {
+            String name = STATIC_TABLE[i][0];
+            if (!NAME_INDEX.containsKey(name)) {
+                NAME_INDEX.put(name, Integer.valueOf(i));
+            }
+            FIELD_INDEX.put(name + '\0' + STATIC_TABLE[i][1],
+                    Integer.valueOf(i));
+        }
+    }
+
+    private QPACKFieldSize() {
+    }
+
+    /**
+     * Returns the uncompressed size of a field section: the sum of the
+     * name and value lengths in bytes.
+     *
+     * @param headerPairs flat array of alternating name/value pairs
+     */
+    static long decodedSize(String[] headerPairs) {
+        long size = 0;
+        for (int i = 0; i + 1 < headerPairs.length; i += 2) {
+            size += utf8Length(headerPairs[i]);
+            size += utf8Length(headerPairs[i + 1]);
+        }
+        return size;
+    }
+
+    /**
+     * Returns the estimated size of the QPACK-encoded field section (the
+     * HEADERS frame payload) that a static-table-only encoder produces
+     * for the given fields.
+     *
+     * @param headerPairs flat array of alternating name/value pairs
+     */
+    static long encodedSize(String[] headerPairs) {
+        // RFC 9204 section 4.5.1: Required Insert Count 0 and Base 0
+        long size = 2;
+        for (int i = 0; i + 1 < headerPairs.length; i += 2) {
+            String name = headerPairs[i].toLowerCase(Locale.ROOT);
+            String value = headerPairs[i + 1];
+            Integer exact = FIELD_INDEX.get(name + '\0' + value);
+            if (exact != null) {
+                // Section 4.5.2: indexed field line, 6-bit prefix
+                size += integerSize(exact.intValue(), 6);
+                continue;
+            }
+            Integer nameRef = NAME_INDEX.get(name);
+            if (nameRef != null) {
+                // Section 4.5.4: literal with name reference
+                size += integerSize(nameRef.intValue(), 4);
+            } else {
+                // Section 4.5.6: literal with literal name
+                size += stringSize(name, 3);
+            }
+            size += stringSize(value, 7);
+        }
+        return size;
+    }
+
+    /** RFC 9204 section 4.1.2: string literal, Huffman if shorter. */
+    private static int stringSize(String s, int prefix) {
+        byte[] bytes = s.getBytes(StandardCharsets.UTF_8);
+        int len = Math.min(bytes.length, Huffman.encodedLength(bytes));
+        return integerSize(len, prefix) + len;
+    }
+
+    /** RFC 9204 section 4.1.1 (RFC 7541 section 5.1): prefixed integer. */
+    static int integerSize(long value, int prefix) {
+        long max = (1L << prefix) - 1;
+        if (value < max) {
+            return 1;
+        }
+        int size = 1;
+        value -= max;
+        while (value >= 128) {
+            value >>>= 7;
+            size++;
+        }
+        return size + 1;
+    }
+
+    private static int utf8Length(String s) {
+        int len = s.length();
+        int bytes = len;
+        for (int i = 0; i < len; i++) {
+            char c = s.charAt(i);
+            if (c >= 0x80) {
+                bytes += (c >= 0x800 && !Character.isSurrogate(c)) ? 2 : 1;
+            }
+        }
+        return bytes;
+    }
+
+}
@@ -86,6 +86,9 @@ public class Huffman {
     // In a full implementation, the entire table would be used.
     private static final Map<Short, HuffmanCodeInfo> HPACK_HUFFMAN_CODES = new TreeMap<>();
 
+    // Code length in bits for each byte value, for encodedLength().
+    private static final byte[] CODE_LENGTHS = new byte[256];
+
     // Helper to convert binary string to int
     private static int binaryStringToInt(String binaryString) {
         return Integer.parseInt(binaryString, 2);
@@ -354,6 +357,10 @@ public class Huffman {
         // This is a sentinel value, not a decodable character.
         HPACK_HUFFMAN_CODES.put(EOS_VALUE_PLACEHOLDER, new HuffmanCodeInfo(0x3fffffff, (short) 30));
 
+        for (short i = 0; i < 256; i++) {
+            CODE_LENGTHS[i] = (byte) HPACK_HUFFMAN_CODES.get(i).numBits;
+        }
+
         buildHuffmanTree();
     }
 
@@ -519,6 +526,21 @@ public class Huffman {
         return bitBuffer.toByteArray();
     }
 
+    /**
+     * Returns the number of bytes {@link #encode} would produce for the
+     * given plaintext, without encoding it.
+     *
+     * @param plaintextBytes the plaintext data
+     * @return the Huffman-encoded length in bytes, including padding
+     */
+    public static int encodedLength(byte[] plaintextBytes) {
+        long bits = 0;
+        for (byte b : plaintextBytes) {
+            bits += CODE_LENGTHS[b & 0xFF];
+        }
+        return (int) ((bits + 7) / 8);
+    }
+
     /**
      * Helper class to build a sequence of bits and convert them to a byte array.
      */
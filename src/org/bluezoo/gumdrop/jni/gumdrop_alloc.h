@@ -0,0 +1,110 @@
+/*
+ * gumdrop_alloc.h
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Accounted allocation for the JNI layer.
+ *
+ * Memory the JNI code allocates for itself, and frees itself, goes
+ * through these wrappers, which keep a running total of bytes and
+ * blocks in gumdrop_native_bytes and gumdrop_native_allocations
+ * (defined in quiche_jni.c, read by native_memory_stats). Sizes come
+ * from the allocator (malloc_usable_size, or malloc_size on macOS), so
+ * blocks carry no header and may be freed by plain free() without
+ * harm, only skewing the totals. Where the allocator cannot report a
+ * block's size only blocks are counted.
+ *
+ * Memory allocated inside quiche and BoringSSL is not seen here; the
+ * Java side estimates it from the process heap (see NativeMemory).
+ */
+
+#ifndef GUMDROP_ALLOC_H
+#define GUMDROP_ALLOC_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#define GUMDROP_ALLOC_SIZE(p) malloc_size(p)
+#elif defined(__linux__)
+#include <malloc.h>
+#define GUMDROP_ALLOC_SIZE(p) malloc_usable_size(p)
+#else
+#define GUMDROP_ALLOC_SIZE(p) ((size_t)0)
+#endif
+
+extern int64_t gumdrop_native_bytes;
+extern int64_t gumdrop_native_allocations;
+
+static inline void gumdrop_alloc_count(void *p, int sign) {
+    if (p != NULL) {
+        __atomic_add_fetch(&gumdrop_native_bytes,
+                           sign * (int64_t)GUMDROP_ALLOC_SIZE(p),
+                           __ATOMIC_RELAXED);
+        __atomic_add_fetch(&gumdrop_native_allocations, sign,
+                           __ATOMIC_RELAXED);
+    }
+}
+
+static inline void *gumdrop_malloc(size_t size) {
+    void *p = malloc(size);
+    gumdrop_alloc_count(p, 1);
+    return p;
+}
+
+static inline void *gumdrop_calloc(size_t count, size_t size) {
+    void *p = calloc(count, size);
+    gumdrop_alloc_count(p, 1);
+    return p;
+}
+
+/* As realloc: on failure the original block is untouched */
+static inline void *gumdrop_realloc(void *ptr, size_t size) {
+    int64_t old_size = (ptr != NULL) ? (int64_t)GUMDROP_ALLOC_SIZE(ptr) : 0;
+    void *p = realloc(ptr, size);
+    if (p != NULL) {
+        __atomic_add_fetch(&gumdrop_native_bytes,
+                           (int64_t)GUMDROP_ALLOC_SIZE(p) - old_size,
+                           __ATOMIC_RELAXED);
+        if (ptr == NULL) {
+            __atomic_add_fetch(&gumdrop_native_allocations, 1,
+                               __ATOMIC_RELAXED);
+        }
+    }
+    return p;
+}
+
+static inline char *gumdrop_strdup(const char *s) {
+    size_t len = strlen(s) + 1;
+    char *p = (char *)gumdrop_malloc(len);
+    if (p != NULL) {
+        memcpy(p, s, len);
+    }
+    return p;
+}
+
+static inline void gumdrop_free(void *ptr) {
+    gumdrop_alloc_count(ptr, -1);
+    free(ptr);
+}
+
+#endif /* GUMDROP_ALLOC_H */
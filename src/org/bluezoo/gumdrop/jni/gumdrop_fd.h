@@ -0,0 +1,69 @@
+/*
+ * gumdrop_fd.h
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File descriptors behind NIO channels.
+ *
+ * The JDK gives no public way to reach the descriptor of a channel, but
+ * JNI field access is not subject to module encapsulation. Socket,
+ * datagram and server socket channels (sun.nio.ch) keep it in an int
+ * field fdVal; FileChannelImpl keeps a java.io.FileDescriptor in fd,
+ * whose own int fd field holds it.
+ *
+ * The descriptor remains owned by the channel: callers that need it
+ * beyond the channel's lifetime must dup() it.
+ */
+
+#ifndef GUMDROP_FD_H
+#define GUMDROP_FD_H
+
+#include <jni.h>
+
+/* Returns the descriptor of the channel, or -1 if it has none. */
+static inline int gumdrop_channel_fd(JNIEnv *env, jobject channel) {
+    if (channel == NULL) {
+        return -1;
+    }
+    jclass cls = (*env)->GetObjectClass(env, channel);
+    jfieldID fid = (*env)->GetFieldID(env, cls, "fdVal", "I");
+    if (fid != NULL) {
+        return (*env)->GetIntField(env, channel, fid);
+    }
+    (*env)->ExceptionClear(env);
+    fid = (*env)->GetFieldID(env, cls, "fd", "Ljava/io/FileDescriptor;");
+    if (fid == NULL) {
+        (*env)->ExceptionClear(env);
+        return -1;
+    }
+    jobject fdo = (*env)->GetObjectField(env, channel, fid);
+    if (fdo == NULL) {
+        return -1;
+    }
+    jclass fdcls = (*env)->GetObjectClass(env, fdo);
+    jfieldID ffid = (*env)->GetFieldID(env, fdcls, "fd", "I");
+    if (ffid == NULL) {
+        (*env)->ExceptionClear(env);
+        return -1;
+    }
+    return (*env)->GetIntField(env, fdo, ffid);
+}
+
+#endif /* GUMDROP_FD_H */
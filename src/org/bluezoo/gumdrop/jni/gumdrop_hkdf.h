@@ -0,0 +1,67 @@
+/*
+ * gumdrop_hkdf.h
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * TLS 1.3 key derivation shared by the QUIC and kernel TLS code.
+ *
+ * quiche_jni.c derives QUIC Initial packet keys (RFC 9001 section 5.2)
+ * and ssl_ctx_jni.c the traffic keys it hands to the kernel; both use
+ * HKDF-Expand-Label from here so that the label encoding is the same.
+ */
+
+#ifndef GUMDROP_HKDF_H
+#define GUMDROP_HKDF_H
+
+#include <stdint.h>
+#include <string.h>
+#include <openssl/digest.h>
+#include <openssl/hkdf.h>
+
+/* Longest label accepted, not counting the "tls13 " prefix. */
+#define GUMDROP_HKDF_MAX_LABEL 32
+
+/*
+ * HKDF-Expand-Label (RFC 8446 section 7.1) with an empty context.
+ * Returns 1 on success, 0 on failure or if the label is too long.
+ */
+static inline int gumdrop_hkdf_expand_label(uint8_t *out, size_t out_len,
+                                            const EVP_MD *md,
+                                            const uint8_t *secret,
+                                            size_t secret_len,
+                                            const char *label) {
+    uint8_t info[2 + 1 + 6 + GUMDROP_HKDF_MAX_LABEL + 1];
+    size_t label_len = strlen(label);
+    size_t n = 0;
+    if (label_len > GUMDROP_HKDF_MAX_LABEL) {
+        return 0;
+    }
+    info[n++] = (uint8_t)(out_len >> 8);
+    info[n++] = (uint8_t)out_len;
+    info[n++] = (uint8_t)(6 + label_len);
+    memcpy(info + n, "tls13 ", 6);
+    n += 6;
+    memcpy(info + n, label, label_len);
+    n += label_len;
+    info[n++] = 0;
+    return HKDF_expand(out, out_len, md, secret, secret_len, info, n);
+}
+
+#endif /* GUMDROP_HKDF_H */
@@ -0,0 +1,92 @@
+/*
+ * gumdrop_probes.h
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * USDT static tracepoints for the JNI layer (provider "gumdrop").
+ *
+ * On Linux, when <sys/sdt.h> is available (systemtap-sdt-dev or
+ * systemtap-sdt-devel), each GUMDROP_PROBEn expands to a single nop
+ * plus an ELF note describing where its arguments live. perf, bpftrace
+ * and SystemTap patch the nop into a breakpoint only while attached, so
+ * an idle probe costs one instruction. Arguments should be values the
+ * caller already holds, since they are evaluated either way.
+ *
+ * Elsewhere, or when built with -DGUMDROP_NO_PROBES, the probes compile
+ * to nothing. GUMDROP_PROBES is defined when they are present.
+ *
+ * A probe that needs setup beyond its arguments can test whether a
+ * tracer is attached with GUMDROP_PROBE_ENABLED(name), which reads the
+ * semaphore the tracer increments. A source file doing so defines
+ * GUMDROP_PROBE_SEMAPHORES before including this header and declares,
+ * with GUMDROP_PROBE_SEMAPHORE(name), a semaphore for every probe it
+ * contains.
+ *
+ * Probes are listed in BUILDING.md; etc/bpftrace has example scripts.
+ */
+
+#ifndef GUMDROP_PROBES_H
+#define GUMDROP_PROBES_H
+
+#if defined(__linux__) && !defined(GUMDROP_NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#ifdef GUMDROP_PROBE_SEMAPHORES
+#define _SDT_HAS_SEMAPHORES 1
+#endif
+#include <sys/sdt.h>
+#define GUMDROP_PROBES 1
+#endif
+#endif
+
+#ifdef GUMDROP_PROBES
+
+#define GUMDROP_PROBE1(name, a1) \
+        DTRACE_PROBE1(gumdrop, name, a1)
+#define GUMDROP_PROBE2(name, a1, a2) \
+        DTRACE_PROBE2(gumdrop, name, a1, a2)
+#define GUMDROP_PROBE3(name, a1, a2, a3) \
+        DTRACE_PROBE3(gumdrop, name, a1, a2, a3)
+#define GUMDROP_PROBE4(name, a1, a2, a3, a4) \
+        DTRACE_PROBE4(gumdrop, name, a1, a2, a3, a4)
+#define GUMDROP_PROBE5(name, a1, a2, a3, a4, a5) \
+        DTRACE_PROBE5(gumdrop, name, a1, a2, a3, a4, a5)
+
+#define GUMDROP_PROBE_SEMAPHORE(name) \
+        volatile unsigned short gumdrop_##name##_semaphore \
+        __attribute__((section(".probes"), used, \
+                       visibility("hidden")))
+#define GUMDROP_PROBE_ENABLED(name) \
+        __builtin_expect(gumdrop_##name##_semaphore != 0, 0)
+
+#else
+
+#define GUMDROP_PROBE1(name, a1) do { } while (0)
+#define GUMDROP_PROBE2(name, a1, a2) do { } while (0)
+#define GUMDROP_PROBE3(name, a1, a2, a3) do { } while (0)
+#define GUMDROP_PROBE4(name, a1, a2, a3, a4) do { } while (0)
+#define GUMDROP_PROBE5(name, a1, a2, a3, a4, a5) do { } while (0)
+
+#define GUMDROP_PROBE_SEMAPHORE(name) \
+        struct gumdrop_##name##_semaphore
+#define GUMDROP_PROBE_ENABLED(name) 0
+
+#endif
+
+#endif /* GUMDROP_PROBES_H */
@@ -35,6 +35,14 @@
 #include <quiche.h>
 #include <string.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#include "gumdrop_alloc.h"
+#include "gumdrop_fd.h"
+#include "gumdrop_probes.h"
 
 /*
  * Thread-local storage for the most recently polled h3 event.
@@ -60,12 +68,29 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1config_1free(
     quiche_h3_config_free(config);
 }
 
+/* RFC 9114 section 4.2.2: SETTINGS_MAX_FIELD_SECTION_SIZE */
+JNIEXPORT void JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1config_1set_1max_1field_1section_1size(
+        JNIEnv *env, jclass cls, jlong config_ptr, jlong size) {
+    quiche_h3_config *config = (quiche_h3_config *)(intptr_t)config_ptr;
+    quiche_h3_config_set_max_field_section_size(config, (uint64_t)size);
+}
+
+/* RFC 9204 section 5: SETTINGS_QPACK_MAX_TABLE_CAPACITY */
 JNIEXPORT void JNICALL
-Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1config_1set_1max_1dynamic_1table_1capacity(
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1config_1set_1qpack_1max_1table_1capacity(
         JNIEnv *env, jclass cls, jlong config_ptr, jlong capacity) {
     quiche_h3_config *config = (quiche_h3_config *)(intptr_t)config_ptr;
-    quiche_h3_config_set_max_field_section_size(config,
-                                                 (uint64_t)capacity);
+    quiche_h3_config_set_qpack_max_table_capacity(config,
+                                                  (uint64_t)capacity);
+}
+
+/* RFC 9204 section 5: SETTINGS_QPACK_BLOCKED_STREAMS */
+JNIEXPORT void JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1config_1set_1qpack_1blocked_1streams(
+        JNIEnv *env, jclass cls, jlong config_ptr, jlong streams) {
+    quiche_h3_config *config = (quiche_h3_config *)(intptr_t)config_ptr;
+    quiche_h3_config_set_qpack_blocked_streams(config, (uint64_t)streams);
 }
 
 JNIEXPORT void JNICALL
@@ -150,10 +175,14 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1conn_1poll(
         case QUICHE_H3_EVENT_RESET:
             event_type = 4;
             break;
+        case QUICHE_H3_EVENT_PRIORITY_UPDATE:
+            event_type = 5;
+            break;
         default:
             event_type = -1;
             break;
     }
+    GUMDROP_PROBE4(h3__event, conn, h3, stream_id, event_type);
 
     jlongArray result = (*env)->NewLongArray(env, 2);
     if (result == NULL) {
@@ -199,11 +228,13 @@ static int header_cb(uint8_t *name, size_t name_len,
 
     if (hc->count >= hc->capacity) {
         int new_cap = hc->capacity * 2;
-        char **new_names = realloc(hc->names, new_cap * sizeof(char *));
-        char **new_values = realloc(hc->values, new_cap * sizeof(char *));
+        char **new_names = gumdrop_realloc(hc->names,
+                                           new_cap * sizeof(char *));
+        char **new_values = gumdrop_realloc(hc->values,
+                                            new_cap * sizeof(char *));
         if (new_names == NULL || new_values == NULL) {
-            free(new_names);
-            free(new_values);
+            gumdrop_free(new_names);
+            gumdrop_free(new_values);
             return -1;
         }
         hc->names = new_names;
@@ -211,11 +242,11 @@ static int header_cb(uint8_t *name, size_t name_len,
         hc->capacity = new_cap;
     }
 
-    char *n = malloc(name_len + 1);
-    char *v = malloc(value_len + 1);
+    char *n = gumdrop_malloc(name_len + 1);
+    char *v = gumdrop_malloc(value_len + 1);
     if (n == NULL || v == NULL) {
-        free(n);
-        free(v);
+        gumdrop_free(n);
+        gumdrop_free(v);
         return -1;
     }
     memcpy(n, name, name_len);
@@ -240,24 +271,25 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1event_1headers(
     hc.env = env;
     hc.count = 0;
     hc.capacity = 32;
-    hc.names = malloc(hc.capacity * sizeof(char *));
-    hc.values = malloc(hc.capacity * sizeof(char *));
+    hc.names = gumdrop_malloc(hc.capacity * sizeof(char *));
+    hc.values = gumdrop_malloc(hc.capacity * sizeof(char *));
     if (hc.names == NULL || hc.values == NULL) {
-        free(hc.names);
-        free(hc.values);
+        gumdrop_free(hc.names);
+        gumdrop_free(hc.values);
         return NULL;
     }
 
     int rc = quiche_h3_event_for_each_header(current_event, header_cb,
                                               &hc);
+    GUMDROP_PROBE3(h3__headers__recv, h3_conn_ptr, hc.count, rc);
     if (rc != 0) {
         int i;
         for (i = 0; i < hc.count; i++) {
-            free(hc.names[i]);
-            free(hc.values[i]);
+            gumdrop_free(hc.names[i]);
+            gumdrop_free(hc.values[i]);
         }
-        free(hc.names);
-        free(hc.values);
+        gumdrop_free(hc.names);
+        gumdrop_free(hc.values);
         return NULL;
     }
 
@@ -280,11 +312,11 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1event_1headers(
 
     int i;
     for (i = 0; i < hc.count; i++) {
-        free(hc.names[i]);
-        free(hc.values[i]);
+        gumdrop_free(hc.names[i]);
+        gumdrop_free(hc.values[i]);
     }
-    free(hc.names);
-    free(hc.values);
+    gumdrop_free(hc.names);
+    gumdrop_free(hc.values);
 
     return result;
 }
@@ -309,23 +341,22 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1recv_1body(
     return (jint)recv_len;
 }
 
-/* ── Response Sending ── */
-
-JNIEXPORT jint JNICALL
-Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1send_1response(
-        JNIEnv *env, jclass cls, jlong h3_conn_ptr,
-        jlong quiche_conn_ptr, jlong stream_id,
-        jobjectArray headers, jboolean fin) {
-    quiche_h3_conn *h3 = (quiche_h3_conn *)(intptr_t)h3_conn_ptr;
-    quiche_conn *conn = (quiche_conn *)(intptr_t)quiche_conn_ptr;
-
-    jsize header_count = (*env)->GetArrayLength(env, headers);
-    jsize num_headers = header_count / 2;
+/* ── Header marshalling ── */
 
+/*
+ * Builds a quiche header list from a flat Java array of alternating
+ * names and values. The entries point into the strings' modified UTF-8
+ * chars, so the list must be handed back to h3_headers_release once
+ * quiche has copied it. Returns NULL if the list cannot be allocated.
+ */
+static quiche_h3_header *h3_headers_acquire(JNIEnv *env,
+                                            jobjectArray headers,
+                                            jsize *count) {
+    jsize num_headers = (*env)->GetArrayLength(env, headers) / 2;
     quiche_h3_header *h3_headers =
-            malloc(num_headers * sizeof(quiche_h3_header));
+            gumdrop_malloc(num_headers * sizeof(quiche_h3_header));
     if (h3_headers == NULL) {
-        return -1;
+        return NULL;
     }
 
     jsize i;
@@ -343,12 +374,15 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1send_1response(
         h3_headers[i].value = (const uint8_t *)value;
         h3_headers[i].value_len = strlen(value);
     }
+    *count = num_headers;
+    return h3_headers;
+}
 
-    int rc = quiche_h3_send_response(h3, conn, (uint64_t)stream_id,
-                                      h3_headers, num_headers,
-                                      fin == JNI_TRUE);
-
-    /* Release all string references */
+/* Releases the string references and frees a list from h3_headers_acquire. */
+static void h3_headers_release(JNIEnv *env, jobjectArray headers,
+                               quiche_h3_header *h3_headers,
+                               jsize num_headers) {
+    jsize i;
     for (i = 0; i < num_headers; i++) {
         jstring jname = (jstring)(*env)->GetObjectArrayElement(
                 env, headers, i * 2);
@@ -363,41 +397,83 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1send_1response(
         (*env)->DeleteLocalRef(env, jvalue);
     }
 
-    free(h3_headers);
-    return (jint)rc;
+    gumdrop_free(h3_headers);
 }
 
+/* ── Response Sending ── */
+
 JNIEXPORT jint JNICALL
-Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1send_1additional_1headers(
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1send_1response(
         JNIEnv *env, jclass cls, jlong h3_conn_ptr,
         jlong quiche_conn_ptr, jlong stream_id,
-        jobjectArray headers, jboolean is_trailer_section, jboolean fin) {
+        jobjectArray headers, jboolean fin) {
     quiche_h3_conn *h3 = (quiche_h3_conn *)(intptr_t)h3_conn_ptr;
     quiche_conn *conn = (quiche_conn *)(intptr_t)quiche_conn_ptr;
 
-    jsize header_count = (*env)->GetArrayLength(env, headers);
-    jsize num_headers = header_count / 2;
+    jsize num_headers;
+    quiche_h3_header *h3_headers =
+            h3_headers_acquire(env, headers, &num_headers);
+    if (h3_headers == NULL) {
+        return -1;
+    }
 
+    int rc = quiche_h3_send_response(h3, conn, (uint64_t)stream_id,
+                                      h3_headers, num_headers,
+                                      fin == JNI_TRUE);
+    GUMDROP_PROBE4(h3__headers__send, conn, stream_id, num_headers, rc);
+
+    h3_headers_release(env, headers, h3_headers, num_headers);
+    return (jint)rc;
+}
+
+/*
+ * RFC 9218: as send_response, but also sets the urgency and incremental
+ * parameters quiche's stream scheduler uses for this response.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1send_1response_1with_1priority(
+        JNIEnv *env, jclass cls, jlong h3_conn_ptr,
+        jlong quiche_conn_ptr, jlong stream_id,
+        jobjectArray headers, jint urgency, jboolean incremental,
+        jboolean fin) {
+    quiche_h3_conn *h3 = (quiche_h3_conn *)(intptr_t)h3_conn_ptr;
+    quiche_conn *conn = (quiche_conn *)(intptr_t)quiche_conn_ptr;
+
+    jsize num_headers;
     quiche_h3_header *h3_headers =
-            malloc(num_headers * sizeof(quiche_h3_header));
+            h3_headers_acquire(env, headers, &num_headers);
     if (h3_headers == NULL) {
         return -1;
     }
 
-    jsize i;
-    for (i = 0; i < num_headers; i++) {
-        jstring jname = (jstring)(*env)->GetObjectArrayElement(
-                env, headers, i * 2);
-        jstring jvalue = (jstring)(*env)->GetObjectArrayElement(
-                env, headers, i * 2 + 1);
+    quiche_h3_priority priority;
+    priority.urgency = (uint8_t)urgency;
+    priority.incremental = (incremental == JNI_TRUE);
 
-        const char *name = (*env)->GetStringUTFChars(env, jname, NULL);
-        const char *value = (*env)->GetStringUTFChars(env, jvalue, NULL);
+    int rc = quiche_h3_send_response_with_priority(h3, conn,
+                                                    (uint64_t)stream_id,
+                                                    h3_headers, num_headers,
+                                                    &priority,
+                                                    fin == JNI_TRUE);
+    GUMDROP_PROBE4(h3__headers__send, conn, stream_id, num_headers, rc);
 
-        h3_headers[i].name = (const uint8_t *)name;
-        h3_headers[i].name_len = strlen(name);
-        h3_headers[i].value = (const uint8_t *)value;
-        h3_headers[i].value_len = strlen(value);
+    h3_headers_release(env, headers, h3_headers, num_headers);
+    return (jint)rc;
+}
+
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1send_1additional_1headers(
+        JNIEnv *env, jclass cls, jlong h3_conn_ptr,
+        jlong quiche_conn_ptr, jlong stream_id,
+        jobjectArray headers, jboolean is_trailer_section, jboolean fin) {
+    quiche_h3_conn *h3 = (quiche_h3_conn *)(intptr_t)h3_conn_ptr;
+    quiche_conn *conn = (quiche_conn *)(intptr_t)quiche_conn_ptr;
+
+    jsize num_headers;
+    quiche_h3_header *h3_headers =
+            h3_headers_acquire(env, headers, &num_headers);
+    if (h3_headers == NULL) {
+        return -1;
     }
 
     int rc = quiche_h3_send_additional_headers(h3, conn,
@@ -405,23 +481,26 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1send_1additional_1headers(
                                                 h3_headers, num_headers,
                                                 is_trailer_section == JNI_TRUE,
                                                 fin == JNI_TRUE);
+    GUMDROP_PROBE4(h3__headers__send, conn, stream_id, num_headers, rc);
 
-    for (i = 0; i < num_headers; i++) {
-        jstring jname = (jstring)(*env)->GetObjectArrayElement(
-                env, headers, i * 2);
-        jstring jvalue = (jstring)(*env)->GetObjectArrayElement(
-                env, headers, i * 2 + 1);
+    h3_headers_release(env, headers, h3_headers, num_headers);
+    return (jint)rc;
+}
 
-        (*env)->ReleaseStringUTFChars(
-                env, jname, (const char *)h3_headers[i].name);
-        (*env)->ReleaseStringUTFChars(
-                env, jvalue, (const char *)h3_headers[i].value);
-        (*env)->DeleteLocalRef(env, jname);
-        (*env)->DeleteLocalRef(env, jvalue);
+/*
+ * quiche_h3_send_body, firing stream__blocked when the stream has no
+ * capacity for the body.
+ */
+static ssize_t h3_send_body(quiche_h3_conn *h3, quiche_conn *conn,
+                            uint64_t stream_id, uint8_t *data, size_t len,
+                            bool fin) {
+    ssize_t written = quiche_h3_send_body(h3, conn, stream_id, data, len,
+                                          fin);
+    if (written == QUICHE_H3_ERR_DONE
+            || written == QUICHE_H3_ERR_STREAM_BLOCKED) {
+        GUMDROP_PROBE3(stream__blocked, conn, stream_id, len);
     }
-
-    free(h3_headers);
-    return (jint)rc;
+    return written;
 }
 
 JNIEXPORT jint JNICALL
@@ -433,10 +512,10 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1send_1body(
     quiche_conn *conn = (quiche_conn *)(intptr_t)quiche_conn_ptr;
 
     if (len == 0) {
-        ssize_t written = quiche_h3_send_body(h3, conn,
-                                               (uint64_t)stream_id,
-                                               NULL, 0,
-                                               fin == JNI_TRUE);
+        ssize_t written = h3_send_body(h3, conn,
+                                       (uint64_t)stream_id,
+                                       NULL, 0,
+                                       fin == JNI_TRUE);
         return (jint)written;
     }
 
@@ -447,10 +526,10 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1send_1body(
     uint8_t *data = (uint8_t *)(*env)->GetDirectBufferAddress(env, buf);
     if (data != NULL) {
         data += pos;
-        ssize_t written = quiche_h3_send_body(h3, conn,
-                                               (uint64_t)stream_id,
-                                               data, (size_t)len,
-                                               fin == JNI_TRUE);
+        ssize_t written = h3_send_body(h3, conn,
+                                       (uint64_t)stream_id,
+                                       data, (size_t)len,
+                                       fin == JNI_TRUE);
         return (jint)written;
     }
 
@@ -476,11 +555,11 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1send_1body(
         return QUICHE_ERR_DONE;
     }
 
-    ssize_t written = quiche_h3_send_body(h3, conn,
-                                           (uint64_t)stream_id,
-                                           (uint8_t *)bytes + offset,
-                                           (size_t)len,
-                                           fin == JNI_TRUE);
+    ssize_t written = h3_send_body(h3, conn,
+                                   (uint64_t)stream_id,
+                                   (uint8_t *)bytes + offset,
+                                   (size_t)len,
+                                   fin == JNI_TRUE);
     (*env)->ReleaseByteArrayElements(env, arr, bytes, JNI_ABORT);
     return (jint)written;
 }
@@ -495,50 +574,217 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1send_1request(
     quiche_h3_conn *h3 = (quiche_h3_conn *)(intptr_t)h3_conn_ptr;
     quiche_conn *conn = (quiche_conn *)(intptr_t)quiche_conn_ptr;
 
-    jsize header_count = (*env)->GetArrayLength(env, headers);
-    jsize num_headers = header_count / 2;
-
+    jsize num_headers;
     quiche_h3_header *h3_headers =
-            malloc(num_headers * sizeof(quiche_h3_header));
+            h3_headers_acquire(env, headers, &num_headers);
     if (h3_headers == NULL) {
         return -1;
     }
 
-    jsize i;
-    for (i = 0; i < num_headers; i++) {
-        jstring jname = (jstring)(*env)->GetObjectArrayElement(
-                env, headers, i * 2);
-        jstring jvalue = (jstring)(*env)->GetObjectArrayElement(
-                env, headers, i * 2 + 1);
+    int64_t stream_id = quiche_h3_send_request(h3, conn,
+                                                h3_headers, num_headers,
+                                                fin == JNI_TRUE);
+    GUMDROP_PROBE4(h3__headers__send, conn, stream_id, num_headers,
+                   stream_id < 0 ? (int)stream_id : 0);
 
-        const char *name = (*env)->GetStringUTFChars(env, jname, NULL);
-        const char *value = (*env)->GetStringUTFChars(env, jvalue, NULL);
+    h3_headers_release(env, headers, h3_headers, num_headers);
+    return (jlong)stream_id;
+}
 
-        h3_headers[i].name = (const uint8_t *)name;
-        h3_headers[i].name_len = strlen(name);
-        h3_headers[i].value = (const uint8_t *)value;
-        h3_headers[i].value_len = strlen(value);
+/* ── Priority updates (RFC 9218 section 7) ── */
+
+typedef struct {
+    char value[256];
+    int found;
+} priority_field;
+
+static int priority_field_collector(uint8_t *value, uint64_t value_len,
+                                    void *argp) {
+    priority_field *field = (priority_field *)argp;
+    size_t len = (size_t)value_len;
+    if (len >= sizeof(field->value)) {
+        len = sizeof(field->value) - 1;
     }
+    memcpy(field->value, value, len);
+    field->value[len] = '\0';
+    field->found = 1;
+    return 0;
+}
 
-    int64_t stream_id = quiche_h3_send_request(h3, conn,
-                                                h3_headers, num_headers,
-                                                fin == JNI_TRUE);
+/*
+ * Returns the Priority Field Value of the most recent PRIORITY_UPDATE
+ * frame received for the given request stream, or NULL if there is none.
+ * Call after a PRIORITY_UPDATE event (type 5) from quiche_h3_conn_poll.
+ */
+JNIEXPORT jstring JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1take_1last_1priority_1update(
+        JNIEnv *env, jclass cls, jlong h3_conn_ptr, jlong stream_id) {
+    quiche_h3_conn *h3 = (quiche_h3_conn *)(intptr_t)h3_conn_ptr;
+    priority_field field;
+    field.found = 0;
+    int rc = quiche_h3_take_last_priority_update(h3, (uint64_t)stream_id,
+                                                  priority_field_collector,
+                                                  &field);
+    if (rc < 0 || !field.found) {
+        return NULL;
+    }
+    return (*env)->NewStringUTF(env, field.value);
+}
 
-    /* Release all string references */
-    for (i = 0; i < num_headers; i++) {
-        jstring jname = (jstring)(*env)->GetObjectArrayElement(
-                env, headers, i * 2);
-        jstring jvalue = (jstring)(*env)->GetObjectArrayElement(
-                env, headers, i * 2 + 1);
+/* ── File range body ── */
 
-        (*env)->ReleaseStringUTFChars(
-                env, jname, (const char *)h3_headers[i].name);
-        (*env)->ReleaseStringUTFChars(
-                env, jvalue, (const char *)h3_headers[i].value);
-        (*env)->DeleteLocalRef(env, jname);
-        (*env)->DeleteLocalRef(env, jvalue);
+/*
+ * A byte range of a regular file sent as a response body. Chunks are
+ * read with pread() into a buffer owned by the range and handed to
+ * quiche_h3_send_body() from there, so the bytes never pass through a
+ * Java heap or direct buffer. Reading rather than mapping the file
+ * means that a file truncated while it is being sent ends the body with
+ * an error instead of raising SIGBUS in the JVM.
+ */
+
+#define H3_FILE_CHUNK 65536
+
+typedef struct {
+    int fd;             /* our own dup of the channel's descriptor */
+    off_t next;         /* file offset of the next pread() */
+    size_t unread;      /* bytes of the range not yet read */
+    size_t unsent;      /* bytes of the range not yet accepted by quiche */
+    size_t buf_pos;     /* first unsent byte in buf */
+    size_t buf_len;     /* bytes read into buf */
+    uint8_t buf[H3_FILE_CHUNK];
+} h3_file_range;
+
+JNIEXPORT jlong JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_h3_1file_1range_1open(
+        JNIEnv *env, jclass cls, jobject channel, jlong offset,
+        jlong length) {
+    if (offset < 0 || length <= 0) {
+        return 0;
+    }
+    int channel_fd = gumdrop_channel_fd(env, channel);
+    if (channel_fd < 0) {
+        return 0;
+    }
+    int fd = fcntl(channel_fd, F_DUPFD_CLOEXEC, 0);
+    if (fd < 0) {
+        return 0;
     }
 
-    free(h3_headers);
-    return (jlong)stream_id;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)
+            || (uint64_t)offset + (uint64_t)length > (uint64_t)st.st_size) {
+        close(fd);
+        return 0;
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, (off_t)offset, (off_t)length, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    h3_file_range *range =
+            (h3_file_range *)gumdrop_malloc(sizeof(h3_file_range));
+    if (range == NULL) {
+        close(fd);
+        return 0;
+    }
+    range->fd = fd;
+    range->next = (off_t)offset;
+    range->unread = (size_t)length;
+    range->unsent = (size_t)length;
+    range->buf_pos = 0;
+    range->buf_len = 0;
+    return (jlong)(intptr_t)range;
+}
+
+/*
+ * Refills the range's buffer from the file. Returns 0, or
+ * H3_FILE_ERR_TRUNCATED if the file now ends before the range does, or
+ * H3_FILE_ERR_IO if the read fails.
+ */
+#define H3_FILE_ERR_TRUNCATED -1000
+#define H3_FILE_ERR_IO -1001
+
+static int h3_file_range_fill(h3_file_range *range) {
+    size_t want = range->unread < H3_FILE_CHUNK
+            ? range->unread : H3_FILE_CHUNK;
+    ssize_t n;
+    do {
+        n = pread(range->fd, range->buf, want, range->next);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        return H3_FILE_ERR_IO;
+    }
+    if (n == 0) {
+        return H3_FILE_ERR_TRUNCATED;
+    }
+    range->next += n;
+    range->unread -= (size_t)n;
+    range->buf_pos = 0;
+    range->buf_len = (size_t)n;
+    return 0;
+}
+
+/*
+ * Feeds as much of the range to the h3 stream as quiche will accept,
+ * reading the file a chunk at a time. Never sets FIN; the caller
+ * finishes the stream separately. Returns the number of bytes accepted
+ * by this call, QUICHE_ERR_DONE if the stream has no capacity, another
+ * negative quiche error, or H3_FILE_ERR_TRUNCATED/H3_FILE_ERR_IO if the
+ * file could not supply the range.
+ */
+JNIEXPORT jlong JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1h3_1send_1body_1file(
+        JNIEnv *env, jclass cls, jlong h3_conn_ptr,
+        jlong quiche_conn_ptr, jlong stream_id, jlong range_ptr) {
+    quiche_h3_conn *h3 = (quiche_h3_conn *)(intptr_t)h3_conn_ptr;
+    quiche_conn *conn = (quiche_conn *)(intptr_t)quiche_conn_ptr;
+    h3_file_range *range = (h3_file_range *)(intptr_t)range_ptr;
+
+    size_t total = 0;
+    while (range->unsent > 0) {
+        if (range->buf_pos == range->buf_len) {
+            int rc = h3_file_range_fill(range);
+            if (rc < 0) {
+                return rc;
+            }
+        }
+        ssize_t written = h3_send_body(h3, conn,
+                                       (uint64_t)stream_id,
+                                       range->buf + range->buf_pos,
+                                       range->buf_len - range->buf_pos,
+                                       false);
+        if (written < 0) {
+            if (total > 0) {
+                break;
+            }
+            return (jlong)written;
+        }
+        if (written == 0) {
+            break;
+        }
+        range->buf_pos += (size_t)written;
+        range->unsent -= (size_t)written;
+        total += (size_t)written;
+    }
+    if (total == 0 && range->unsent > 0) {
+        return QUICHE_ERR_DONE;
+    }
+    return (jlong)total;
+}
+
+JNIEXPORT jlong JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_h3_1file_1range_1remaining(
+        JNIEnv *env, jclass cls, jlong range_ptr) {
+    h3_file_range *range = (h3_file_range *)(intptr_t)range_ptr;
+    return (jlong)range->unsent;
+}
+
+JNIEXPORT void JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_h3_1file_1range_1free(
+        JNIEnv *env, jclass cls, jlong range_ptr) {
+    h3_file_range *range = (h3_file_range *)(intptr_t)range_ptr;
+    if (range == NULL) {
+        return;
+    }
+    close(range->fd);
+    gumdrop_free(range);
 }
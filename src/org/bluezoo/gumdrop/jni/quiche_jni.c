@@ -34,9 +34,35 @@
 #include <quiche.h>
 #include <string.h>
 #include <stdlib.h>
+#include <openssl/aead.h>
+#include <openssl/aes.h>
+#include <openssl/digest.h>
+#include <openssl/hkdf.h>
 #include <openssl/ssl.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/net_tstamp.h>
+#endif
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#elif defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "gumdrop_alloc.h"
+#include "gumdrop_fd.h"
+#include "gumdrop_hkdf.h"
+#include "gumdrop_probes.h"
+
+/* Running totals of the gumdrop_alloc.h wrappers, for every source file */
+int64_t gumdrop_native_bytes;
+int64_t gumdrop_native_allocations;
 
 /* Forward declarations for JNI method names */
 #define JNI_CLASS "org/bluezoo/gumdrop/GumdropNative"
@@ -111,6 +137,24 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1config_1set_1initial_1max_1stream
     quiche_config_set_initial_max_streams_uni(config, (uint64_t)count);
 }
 
+/*
+ * Receive window auto-tuning: quiche doubles a window, up to these
+ * ceilings, when the application drains it within two RTTs.
+ */
+JNIEXPORT void JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1config_1set_1max_1connection_1window(
+        JNIEnv *env, jclass cls, jlong config_ptr, jlong bytes) {
+    quiche_config *config = (quiche_config *)(intptr_t)config_ptr;
+    quiche_config_set_max_connection_window(config, (uint64_t)bytes);
+}
+
+JNIEXPORT void JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1config_1set_1max_1stream_1window(
+        JNIEnv *env, jclass cls, jlong config_ptr, jlong bytes) {
+    quiche_config *config = (quiche_config *)(intptr_t)config_ptr;
+    quiche_config_set_max_stream_window(config, (uint64_t)bytes);
+}
+
 JNIEXPORT void JNICALL
 Java_org_bluezoo_gumdrop_GumdropNative_quiche_1config_1set_1cc_1algorithm(
         JNIEnv *env, jclass cls, jlong config_ptr, jint algo) {
@@ -118,6 +162,57 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1config_1set_1cc_1algorithm(
     quiche_config_set_cc_algorithm(config, (enum quiche_cc_algorithm)algo);
 }
 
+/*
+ * RFC 9002 section 7: congestion control. Algorithms are selected by
+ * name ("reno", "cubic", "bbr", "bbr2") so that ones added to quiche
+ * need no new constants here; returns 0, or a negative error if the
+ * name is unknown.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1config_1set_1cc_1algorithm_1name(
+        JNIEnv *env, jclass cls, jlong config_ptr, jstring name) {
+    quiche_config *config = (quiche_config *)(intptr_t)config_ptr;
+    const char *algo = (*env)->GetStringUTFChars(env, name, NULL);
+    if (algo == NULL) {
+        return -1;
+    }
+    int rc = quiche_config_set_cc_algorithm_name(config, algo);
+    (*env)->ReleaseStringUTFChars(env, name, algo);
+    return (jint)rc;
+}
+
+/* RFC 9406: HyStart++ exits slow start on rising RTT */
+JNIEXPORT void JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1config_1enable_1hystart(
+        JNIEnv *env, jclass cls, jlong config_ptr, jboolean enabled) {
+    quiche_config *config = (quiche_config *)(intptr_t)config_ptr;
+    quiche_config_enable_hystart(config, enabled == JNI_TRUE);
+}
+
+/* RFC 9002 section 7.7: pacing */
+JNIEXPORT void JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1config_1enable_1pacing(
+        JNIEnv *env, jclass cls, jlong config_ptr, jboolean enabled) {
+    quiche_config *config = (quiche_config *)(intptr_t)config_ptr;
+    quiche_config_enable_pacing(config, enabled == JNI_TRUE);
+}
+
+/* RFC 9002 section 7.2: initial congestion window */
+JNIEXPORT void JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1config_1set_1initial_1congestion_1window_1packets(
+        JNIEnv *env, jclass cls, jlong config_ptr, jint packets) {
+    quiche_config *config = (quiche_config *)(intptr_t)config_ptr;
+    quiche_config_set_initial_congestion_window_packets(config,
+                                                        (size_t)packets);
+}
+
+JNIEXPORT void JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1config_1set_1max_1pacing_1rate(
+        JNIEnv *env, jclass cls, jlong config_ptr, jlong rate) {
+    quiche_config *config = (quiche_config *)(intptr_t)config_ptr;
+    quiche_config_set_max_pacing_rate(config, (uint64_t)rate);
+}
+
 JNIEXPORT void JNICALL
 Java_org_bluezoo_gumdrop_GumdropNative_quiche_1config_1set_1max_1recv_1udp_1payload_1size(
         JNIEnv *env, jclass cls, jlong config_ptr, jlong size) {
@@ -132,6 +227,17 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1config_1set_1max_1send_1udp_1payl
     quiche_config_set_max_send_udp_payload_size(config, (size_t)size);
 }
 
+/*
+ * RFC 8899: packetization layer path MTU discovery. quiche probes
+ * upwards from 1200 bytes to the configured max_send_udp_payload_size.
+ */
+JNIEXPORT void JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1config_1discover_1pmtu(
+        JNIEnv *env, jclass cls, jlong config_ptr, jboolean enabled) {
+    quiche_config *config = (quiche_config *)(intptr_t)config_ptr;
+    quiche_config_discover_pmtu(config, enabled == JNI_TRUE);
+}
+
 /* RFC 9250 section 4.5: enable 0-RTT early data */
 JNIEXPORT void JNICALL
 Java_org_bluezoo_gumdrop_GumdropNative_quiche_1config_1enable_1early_1data(
@@ -186,6 +292,40 @@ static socklen_t decode_address(JNIEnv *env, jbyteArray addr_arr,
     return sa_len;
 }
 
+/*
+ * Encodes a struct sockaddr_storage into a Java address byte array of at
+ * least 19 bytes, in the format read by decode_address.
+ * Returns the number of bytes written, or 0 for an unknown family.
+ */
+static jsize encode_address(JNIEnv *env, const struct sockaddr_storage *ss,
+                            jbyteArray addr_arr) {
+    jbyte bytes[19];
+    jsize len = 0;
+
+    if (ss->ss_family == AF_INET) {
+        const struct sockaddr_in *sin = (const struct sockaddr_in *)ss;
+        uint16_t port = ntohs(sin->sin_port);
+        bytes[0] = 4;
+        bytes[1] = (jbyte)(port >> 8);
+        bytes[2] = (jbyte)(port & 0xff);
+        memcpy(bytes + 3, &sin->sin_addr, 4);
+        len = 7;
+    } else if (ss->ss_family == AF_INET6) {
+        const struct sockaddr_in6 *sin6 = (const struct sockaddr_in6 *)ss;
+        uint16_t port = ntohs(sin6->sin6_port);
+        bytes[0] = 6;
+        bytes[1] = (jbyte)(port >> 8);
+        bytes[2] = (jbyte)(port & 0xff);
+        memcpy(bytes + 3, &sin6->sin6_addr, 16);
+        len = 19;
+    }
+
+    if (len > 0) {
+        (*env)->SetByteArrayRegion(env, addr_arr, 0, len, bytes);
+    }
+    return len;
+}
+
 JNIEXPORT jlong JNICALL
 Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1new_1with_1tls(
         JNIEnv *env, jclass cls,
@@ -217,6 +357,10 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1new_1with_1tls(
             (struct sockaddr *)&peer_ss, peer_len,
             config, ssl, is_server == JNI_TRUE);
 
+    /* The SSL pointer ties the connection to handshake__done */
+    GUMDROP_PROBE5(conn__new, conn, ssl, scid_buf, scid_len,
+                   is_server == JNI_TRUE);
+
     (*env)->ReleaseByteArrayElements(env, scid, scid_buf, JNI_ABORT);
     if (odcid_buf != NULL) {
         (*env)->ReleaseByteArrayElements(env, odcid, odcid_buf, JNI_ABORT);
@@ -248,15 +392,37 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1recv(
     recv_info.to = (struct sockaddr *)&to_ss;
     recv_info.to_len = to_len;
 
+    /* Before quiche decrypts the packet in place: the header, including
+     * the destination connection ID, is still readable */
+    GUMDROP_PROBE3(packet__recv, conn, data, len);
+
     ssize_t recv_len = quiche_conn_recv(conn, data, (size_t)len,
                                          &recv_info);
     return (jint)recv_len;
 }
 
+/*
+ * RFC 9002 section 7.7: nanoseconds until the pacer releases a packet,
+ * or 0 if it is due. quiche stamps send_info.at from Rust's Instant,
+ * which reads the monotonic clock.
+ */
+static jlong send_delay(const struct timespec *at) {
+    struct timespec now;
+#if defined(__APPLE__)
+    clock_gettime(CLOCK_UPTIME_RAW, &now);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &now);
+#endif
+    jlong delay = (jlong)(at->tv_sec - now.tv_sec) * 1000000000LL
+            + (at->tv_nsec - now.tv_nsec);
+    return delay > 0 ? delay : 0;
+}
+
 JNIEXPORT jint JNICALL
 Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1send(
         JNIEnv *env, jclass cls, jlong conn_ptr,
-        jobject buf, jint len) {
+        jobject buf, jint len,
+        jbyteArray to_addr, jbyteArray from_addr, jlongArray delay) {
     quiche_conn *conn = (quiche_conn *)(intptr_t)conn_ptr;
     uint8_t *data = (uint8_t *)(*env)->GetDirectBufferAddress(env, buf);
     if (data == NULL) {
@@ -266,9 +432,312 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1send(
     quiche_send_info send_info;
     ssize_t written = quiche_conn_send(conn, data, (size_t)len,
                                         &send_info);
+    if (written > 0) {
+        GUMDROP_PROBE3(packet__send, conn, data, written);
+        /* RFC 9000 section 9: the packet belongs to the path quiche
+         * chose, which is not the original peer once it has migrated
+         * or while a new path is being validated */
+        encode_address(env, &send_info.to, to_addr);
+        if (from_addr != NULL) {
+            encode_address(env, &send_info.from, from_addr);
+        }
+        if (delay != NULL) {
+            jlong ns = send_delay(&send_info.at);
+            (*env)->SetLongArrayRegion(env, delay, 0, 1, &ns);
+        }
+    }
     return (jint)written;
 }
 
+/* ── Connection migration ── */
+
+/*
+ * RFC 9000 section 9: a peer may move to a new address, whether
+ * deliberately or because a NAT rebinding changed its port. quiche
+ * reports each path change as an event; the application probes new
+ * paths and sends to whichever path quiche selects.
+ */
+
+/*
+ * Returns the type of the next path event (QUICHE_PATH_EVENT_*), or -1
+ * if there is none, and encodes the local and peer addresses of the
+ * path concerned. For REUSED_SOURCE_CONNECTION_ID these are the new
+ * path's addresses.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1path_1event_1next(
+        JNIEnv *env, jclass cls, jlong conn_ptr,
+        jbyteArray local_addr, jbyteArray peer_addr) {
+    quiche_conn *conn = (quiche_conn *)(intptr_t)conn_ptr;
+    quiche_path_event *ev = quiche_conn_path_event_next(conn);
+    if (ev == NULL) {
+        return -1;
+    }
+
+    struct sockaddr_storage local_ss, peer_ss;
+    socklen_t local_len = sizeof(local_ss);
+    socklen_t peer_len = sizeof(peer_ss);
+    memset(&local_ss, 0, sizeof(local_ss));
+    memset(&peer_ss, 0, sizeof(peer_ss));
+
+    enum quiche_path_event_type type = quiche_path_event_type(ev);
+    switch (type) {
+        case QUICHE_PATH_EVENT_NEW:
+            quiche_path_event_new(ev, &local_ss, &local_len,
+                                  &peer_ss, &peer_len);
+            break;
+        case QUICHE_PATH_EVENT_VALIDATED:
+            quiche_path_event_validated(ev, &local_ss, &local_len,
+                                        &peer_ss, &peer_len);
+            break;
+        case QUICHE_PATH_EVENT_FAILED_VALIDATION:
+            quiche_path_event_failed_validation(ev, &local_ss, &local_len,
+                                                &peer_ss, &peer_len);
+            break;
+        case QUICHE_PATH_EVENT_CLOSED:
+            quiche_path_event_closed(ev, &local_ss, &local_len,
+                                     &peer_ss, &peer_len);
+            break;
+        case QUICHE_PATH_EVENT_REUSED_SOURCE_CONNECTION_ID: {
+            uint64_t seq;
+            struct sockaddr_storage old_local_ss, old_peer_ss;
+            socklen_t old_local_len = sizeof(old_local_ss);
+            socklen_t old_peer_len = sizeof(old_peer_ss);
+            quiche_path_event_reused_source_connection_id(ev, &seq,
+                    &old_local_ss, &old_local_len,
+                    &old_peer_ss, &old_peer_len,
+                    &local_ss, &local_len, &peer_ss, &peer_len);
+            break;
+        }
+        case QUICHE_PATH_EVENT_PEER_MIGRATED:
+            quiche_path_event_peer_migrated(ev, &local_ss, &local_len,
+                                            &peer_ss, &peer_len);
+            break;
+    }
+    quiche_path_event_free(ev);
+
+    encode_address(env, &local_ss, local_addr);
+    encode_address(env, &peer_ss, peer_addr);
+    return (jint)type;
+}
+
+/*
+ * RFC 9000 section 8.2: sends PATH_CHALLENGE on the path, which needs an
+ * unused peer connection ID. Returns 0 or a quiche error code.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1probe_1path(
+        JNIEnv *env, jclass cls, jlong conn_ptr,
+        jbyteArray local_addr, jbyteArray peer_addr) {
+    quiche_conn *conn = (quiche_conn *)(intptr_t)conn_ptr;
+    struct sockaddr_storage local_ss, peer_ss;
+    socklen_t local_len = decode_address(env, local_addr, &local_ss);
+    socklen_t peer_len = decode_address(env, peer_addr, &peer_ss);
+    if (local_len == 0 || peer_len == 0) {
+        return QUICHE_ERR_INVALID_STATE;
+    }
+    uint64_t seq;
+    return (jint)quiche_conn_probe_path(conn,
+            (struct sockaddr *)&local_ss, (size_t)local_len,
+            (struct sockaddr *)&peer_ss, (size_t)peer_len, &seq);
+}
+
+/*
+ * RFC 9000 section 5.1.1: how many more connection IDs the peer will
+ * accept, per its active_connection_id_limit.
+ */
+JNIEXPORT jlong JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1scids_1left(
+        JNIEnv *env, jclass cls, jlong conn_ptr) {
+    quiche_conn *conn = (quiche_conn *)(intptr_t)conn_ptr;
+    return (jlong)quiche_conn_scids_left(conn);
+}
+
+/*
+ * Issues a connection ID in NEW_CONNECTION_ID, with its 16-byte stateless
+ * reset token. Returns the sequence number or a negative quiche error.
+ */
+JNIEXPORT jlong JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1new_1scid(
+        JNIEnv *env, jclass cls, jlong conn_ptr,
+        jbyteArray scid, jbyteArray reset_token) {
+    quiche_conn *conn = (quiche_conn *)(intptr_t)conn_ptr;
+    jbyte scid_buf[QUICHE_MAX_CONN_ID_LEN];
+    jbyte token_buf[16];
+    jsize scid_len = (*env)->GetArrayLength(env, scid);
+    if (scid_len > QUICHE_MAX_CONN_ID_LEN
+            || (*env)->GetArrayLength(env, reset_token) != 16) {
+        return QUICHE_ERR_INVALID_STATE;
+    }
+    (*env)->GetByteArrayRegion(env, scid, 0, scid_len, scid_buf);
+    (*env)->GetByteArrayRegion(env, reset_token, 0, 16, token_buf);
+
+    uint64_t seq;
+    int rc = quiche_conn_new_scid(conn,
+            (const uint8_t *)scid_buf, (size_t)scid_len,
+            (const uint8_t *)token_buf, false, &seq);
+    return (rc < 0) ? (jlong)rc : (jlong)seq;
+}
+
+/*
+ * Returns the next connection ID the peer has retired (RETIRE_CONNECTION_ID),
+ * or null if there are none.
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1retired_1scid_1next(
+        JNIEnv *env, jclass cls, jlong conn_ptr) {
+    quiche_conn *conn = (quiche_conn *)(intptr_t)conn_ptr;
+    const uint8_t *id;
+    size_t id_len;
+    if (!quiche_conn_retired_scid_next(conn, &id, &id_len)) {
+        return NULL;
+    }
+    jbyteArray result = (*env)->NewByteArray(env, (jsize)id_len);
+    if (result != NULL) {
+        (*env)->SetByteArrayRegion(env, result, 0, (jsize)id_len,
+                                   (const jbyte *)id);
+    }
+    return result;
+}
+
+/* ── QUIC-LB connection IDs ── */
+
+/*
+ * draft-ietf-quic-load-balancers section 5: a load balancer holding the
+ * same key recovers the server ID from the connection ID of any packet.
+ * The first octet (config rotation bits and length) stays in the clear.
+ * The server ID and nonce after it are encrypted as one AES-128-ECB
+ * block when together they are exactly 16 bytes, and otherwise with a
+ * four-pass Feistel network that uses AES-128-ECB as its round function.
+ * With an odd plaintext length the middle byte is split between the
+ * halves: the left half keeps its high nibble, the right its low one.
+ */
+
+/*
+ * One Feistel pass: expands the half `in` into an AES block
+ * (half || zeros || plaintext_len || pass), encrypts it and XORs the
+ * leading half_len bytes of the result into the other half.
+ */
+static void quic_lb_pass(const AES_KEY *aes, const uint8_t *in,
+                         uint8_t *target, size_t half_len,
+                         size_t plaintext_len, uint8_t pass,
+                         int target_is_right) {
+    uint8_t block[16];
+    uint8_t out[16];
+    size_t i;
+
+    memset(block, 0, sizeof(block));
+    memcpy(block, in, half_len);
+    block[14] = (uint8_t)plaintext_len;
+    block[15] = pass;
+    AES_encrypt(block, out, aes);
+
+    for (i = 0; i < half_len; i++) {
+        target[i] ^= out[i];
+    }
+    if (plaintext_len & 1) {
+        if (target_is_right) {
+            target[0] &= 0x0f;
+        } else {
+            target[half_len - 1] &= 0xf0;
+        }
+    }
+}
+
+/*
+ * Runs the four-pass Feistel network over plaintext in place, forwards
+ * to encrypt or backwards to decrypt. Every pass encrypts with AES, so
+ * both directions use the encryption key schedule.
+ */
+static void quic_lb_feistel(const AES_KEY *aes, uint8_t *plaintext,
+                            size_t len, int decrypt) {
+    size_t half_len = (len + 1) / 2;
+    uint8_t left[10];
+    uint8_t right[10];
+
+    memcpy(left, plaintext, half_len);
+    memcpy(right, plaintext + len - half_len, half_len);
+    if (len & 1) {
+        left[half_len - 1] &= 0xf0;
+        right[0] &= 0x0f;
+    }
+    if (decrypt) {
+        quic_lb_pass(aes, right, left, half_len, len, 4, 0);
+        quic_lb_pass(aes, left, right, half_len, len, 3, 1);
+        quic_lb_pass(aes, right, left, half_len, len, 2, 0);
+        quic_lb_pass(aes, left, right, half_len, len, 1, 1);
+    } else {
+        quic_lb_pass(aes, left, right, half_len, len, 1, 1);
+        quic_lb_pass(aes, right, left, half_len, len, 2, 0);
+        quic_lb_pass(aes, left, right, half_len, len, 3, 1);
+        quic_lb_pass(aes, right, left, half_len, len, 4, 0);
+    }
+    memcpy(plaintext, left, half_len);
+    if (len & 1) {
+        plaintext[half_len - 1] |= right[0];
+        memcpy(plaintext + half_len, right + 1, half_len - 1);
+    } else {
+        memcpy(plaintext + half_len, right, half_len);
+    }
+    OPENSSL_cleanse(left, sizeof(left));
+    OPENSSL_cleanse(right, sizeof(right));
+}
+
+/*
+ * Encrypts or decrypts a QUIC-LB connection ID in place under a 16-byte
+ * key. Returns 0, or -1 if the key or connection ID length is invalid.
+ */
+static jint quic_lb_crypt(JNIEnv *env, jbyteArray key_arr,
+                          jbyteArray cid_arr, int decrypt) {
+    uint8_t key[16];
+    uint8_t cid[QUICHE_MAX_CONN_ID_LEN];
+    jsize cid_len = (*env)->GetArrayLength(env, cid_arr);
+    /* a 1-byte server ID and a 4-byte nonce at least */
+    if ((*env)->GetArrayLength(env, key_arr) != (jsize)sizeof(key)
+            || cid_len < 6 || cid_len > QUICHE_MAX_CONN_ID_LEN) {
+        return -1;
+    }
+    (*env)->GetByteArrayRegion(env, key_arr, 0, sizeof(key), (jbyte *)key);
+    (*env)->GetByteArrayRegion(env, cid_arr, 0, cid_len, (jbyte *)cid);
+
+    AES_KEY aes;
+    uint8_t *plaintext = cid + 1;
+    size_t len = (size_t)cid_len - 1;
+
+    if (len == 16) {
+        uint8_t out[16];
+        if (decrypt) {
+            AES_set_decrypt_key(key, 128, &aes);
+            AES_decrypt(plaintext, out, &aes);
+        } else {
+            AES_set_encrypt_key(key, 128, &aes);
+            AES_encrypt(plaintext, out, &aes);
+        }
+        memcpy(plaintext, out, sizeof(out));
+    } else {
+        AES_set_encrypt_key(key, 128, &aes);
+        quic_lb_feistel(&aes, plaintext, len, decrypt);
+    }
+    OPENSSL_cleanse(&aes, sizeof(aes));
+    OPENSSL_cleanse(key, sizeof(key));
+
+    (*env)->SetByteArrayRegion(env, cid_arr, 0, cid_len, (jbyte *)cid);
+    OPENSSL_cleanse(cid, sizeof(cid));
+    return 0;
+}
+
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quic_1lb_1encrypt(
+        JNIEnv *env, jclass cls, jbyteArray key_arr, jbyteArray cid_arr) {
+    return quic_lb_crypt(env, key_arr, cid_arr, 0);
+}
+
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quic_1lb_1decrypt(
+        JNIEnv *env, jclass cls, jbyteArray key_arr, jbyteArray cid_arr) {
+    return quic_lb_crypt(env, key_arr, cid_arr, 1);
+}
+
 /* ── Stream I/O (zero-copy via direct ByteBuffer) ── */
 
 JNIEXPORT jint JNICALL
@@ -308,6 +777,9 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1stream_1send(
                                             data, (size_t)len,
                                             fin == JNI_TRUE,
                                             &error_code);
+    if (sent == QUICHE_ERR_DONE) {
+        GUMDROP_PROBE3(stream__blocked, conn, stream_id, len);
+    }
     return (jint)sent;
 }
 
@@ -325,6 +797,20 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1stream_1shutdown(
     return (jint)rc;
 }
 
+/*
+ * Sets the scheduling priority of a stream (RFC 9218 urgency 0-7 and
+ * incremental flag). Lower urgency is served first.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1stream_1priority(
+        JNIEnv *env, jclass cls, jlong conn_ptr, jlong stream_id,
+        jint urgency, jboolean incremental) {
+    quiche_conn *conn = (quiche_conn *)(intptr_t)conn_ptr;
+    return (jint)quiche_conn_stream_priority(conn, (uint64_t)stream_id,
+                                             (uint8_t)urgency,
+                                             incremental == JNI_TRUE);
+}
+
 /* ── Polling and timers ── */
 
 JNIEXPORT jlongArray JNICALL
@@ -385,11 +871,158 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1is_1closed(
     return quiche_conn_is_closed(conn) ? JNI_TRUE : JNI_FALSE;
 }
 
+/* RFC 9001 section 4.6.1: 0-RTT keys are available to the client */
+JNIEXPORT jboolean JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1is_1in_1early_1data(
+        JNIEnv *env, jclass cls, jlong conn_ptr) {
+    quiche_conn *conn = (quiche_conn *)(intptr_t)conn_ptr;
+    return quiche_conn_is_in_early_data(conn) ? JNI_TRUE : JNI_FALSE;
+}
+
+/* Resumes a session serialized by ssl_ctx_take_session() */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1set_1session(
+        JNIEnv *env, jclass cls, jlong conn_ptr, jbyteArray session) {
+    quiche_conn *conn = (quiche_conn *)(intptr_t)conn_ptr;
+    jsize len = (*env)->GetArrayLength(env, session);
+    jbyte *buf = (*env)->GetByteArrayElements(env, session, NULL);
+    if (buf == NULL) {
+        return -1;
+    }
+    int rc = quiche_conn_set_session(conn, (const uint8_t *)buf,
+                                     (size_t)len);
+    (*env)->ReleaseByteArrayElements(env, session, buf, JNI_ABORT);
+    return (jint)rc;
+}
+
+/* RFC 9000 section 4.6: remaining credit under the peer's MAX_STREAMS */
+JNIEXPORT jlong JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1peer_1streams_1left_1bidi(
+        JNIEnv *env, jclass cls, jlong conn_ptr) {
+    quiche_conn *conn = (quiche_conn *)(intptr_t)conn_ptr;
+    return (jlong)quiche_conn_peer_streams_left_bidi(conn);
+}
+
+/* ── Path MTU and statistics ── */
+
+/*
+ * The largest UDP payload the connection may currently send: 1200 bytes
+ * until the handshake completes, then bounded by the peer's
+ * max_udp_payload_size and, with discovery enabled, by the path MTU
+ * confirmed so far (RFC 9000 section 14, RFC 8899).
+ */
+JNIEXPORT jlong JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1max_1send_1udp_1payload_1size(
+        JNIEnv *env, jclass cls, jlong conn_ptr) {
+    quiche_conn *conn = (quiche_conn *)(intptr_t)conn_ptr;
+    return (jlong)quiche_conn_max_send_udp_payload_size(conn);
+}
+
+#define PATH_STATS_LEN 18
+
+/*
+ * Bytes sent on the connection but neither acknowledged nor declared
+ * lost, which quiche holds for retransmission.
+ */
+static jlong conn_bytes_in_flight(const quiche_stats *stats) {
+    uint64_t settled = stats->acked_bytes + stats->lost_bytes;
+    return stats->sent_bytes > settled
+            ? (jlong)(stats->sent_bytes - settled) : 0;
+}
+
+/*
+ * Returns the statistics of the connection's active path as
+ * { rtt, min_rtt, rttvar (nanoseconds), cwnd, pmtu, delivery_rate,
+ *   sent, recv, lost, retrans (packets), sent_bytes, recv_bytes,
+ *   lost_bytes, max_send_udp_payload_size, the peer's initial
+ *   max_data, max_stream_data_bidi_local and _bidi_remote, and the
+ *   connection's bytes in flight }, or NULL if there is none. The
+ * peer's values are 0 before its transport parameters arrive.
+ */
+JNIEXPORT jlongArray JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1path_1stats(
+        JNIEnv *env, jclass cls, jlong conn_ptr) {
+    quiche_conn *conn = (quiche_conn *)(intptr_t)conn_ptr;
+    quiche_stats stats;
+    quiche_path_stats ps;
+    quiche_transport_params tp;
+    size_t i;
+
+    quiche_conn_stats(conn, &stats);
+    for (i = 0; i < stats.paths_count; i++) {
+        if (quiche_conn_path_stats(conn, i, &ps) == 0 && ps.active) {
+            break;
+        }
+    }
+    if (i == stats.paths_count) {
+        return NULL;
+    }
+    if (!quiche_conn_peer_transport_params(conn, &tp)) {
+        memset(&tp, 0, sizeof(tp));
+    }
+
+    jlong values[PATH_STATS_LEN] = {
+        (jlong)ps.rtt, (jlong)ps.min_rtt, (jlong)ps.rttvar,
+        (jlong)ps.cwnd, (jlong)ps.pmtu, (jlong)ps.delivery_rate,
+        (jlong)ps.sent, (jlong)ps.recv, (jlong)ps.lost,
+        (jlong)ps.retrans, (jlong)ps.sent_bytes, (jlong)ps.recv_bytes,
+        (jlong)ps.lost_bytes,
+        (jlong)quiche_conn_max_send_udp_payload_size(conn),
+        (jlong)tp.peer_initial_max_data,
+        (jlong)tp.peer_initial_max_stream_data_bidi_local,
+        (jlong)tp.peer_initial_max_stream_data_bidi_remote,
+        conn_bytes_in_flight(&stats)
+    };
+    jlongArray result = (*env)->NewLongArray(env, PATH_STATS_LEN);
+    if (result != NULL) {
+        (*env)->SetLongArrayRegion(env, result, 0, PATH_STATS_LEN, values);
+    }
+    return result;
+}
+
+/*
+ * Sets the Don't Fragment bit on a UDP socket without letting the
+ * kernel's cached path MTU cap what it sends, so that a datagram
+ * larger than the path is lost rather than fragmented and quiche's
+ * probes measure the path itself (RFC 8899 section 3, RFC 9000
+ * section 14). Returns 0 on success, -1 if unsupported.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_udp_1set_1pmtud_1probe(
+        JNIEnv *env, jclass cls, jobject channel) {
+#if defined(__linux__) && defined(IP_PMTUDISC_PROBE)
+    int fd = gumdrop_channel_fd(env, channel);
+    if (fd < 0) {
+        return -1;
+    }
+    struct sockaddr_storage ss;
+    socklen_t ss_len = sizeof(ss);
+    int probe = IP_PMTUDISC_PROBE;
+    if (getsockname(fd, (struct sockaddr *)&ss, &ss_len) != 0) {
+        return -1;
+    }
+    if (ss.ss_family == AF_INET6) {
+        int probe6 = IPV6_PMTUDISC_PROBE;
+        if (setsockopt(fd, IPPROTO_IPV6, IPV6_MTU_DISCOVER,
+                       &probe6, sizeof(probe6)) != 0) {
+            return -1;
+        }
+        /* IPv4-mapped peers on a dual-stack socket */
+        setsockopt(fd, IPPROTO_IP, IP_MTU_DISCOVER, &probe, sizeof(probe));
+        return 0;
+    }
+    return setsockopt(fd, IPPROTO_IP, IP_MTU_DISCOVER,
+                      &probe, sizeof(probe)) == 0 ? 0 : -1;
+#else
+    return -1;
+#endif
+}
+
 /* ── Header parsing ── */
 
 JNIEXPORT jbyteArray JNICALL
 Java_org_bluezoo_gumdrop_GumdropNative_quiche_1header_1info(
-        JNIEnv *env, jclass cls, jobject buf, jint len) {
+        JNIEnv *env, jclass cls, jobject buf, jint len, jint dcid_len_hint) {
     uint8_t *data = (uint8_t *)(*env)->GetDirectBufferAddress(env, buf);
     if (data == NULL) {
         return NULL;
@@ -404,8 +1037,13 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1header_1info(
     uint8_t token[64];
     size_t token_len = sizeof(token);
 
+    /* short headers do not carry the DCID length: it is the length of
+     * the connection IDs this endpoint issues */
+    if (dcid_len_hint <= 0 || dcid_len_hint > QUICHE_MAX_CONN_ID_LEN) {
+        dcid_len_hint = QUICHE_MAX_CONN_ID_LEN;
+    }
     int rc = quiche_header_info(data, (size_t)len,
-                                 QUICHE_MAX_CONN_ID_LEN,
+                                 (size_t)dcid_len_hint,
                                  &version, &type,
                                  scid, &scid_len,
                                  dcid, &dcid_len,
@@ -504,6 +1142,200 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1negotiate_1version(
     return (jint)written;
 }
 
+/* ── Stateless Retry and refusal ── */
+
+/*
+ * Both answer a client's Initial without creating an SSL or a
+ * quiche_conn. A Retry (RFC 9000 section 8.1.2) asks the client to
+ * prove its address by echoing a token; a refusal closes the attempt
+ * with CONNECTION_CLOSE (RFC 9000 section 10.2.3).
+ *
+ * quiche only builds Retry packets statelessly, so the refusal is
+ * protected here with the Initial keys of RFC 9001 section 5.2, which
+ * anyone can derive from the client's Destination Connection ID.
+ */
+
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1retry(
+        JNIEnv *env, jclass cls,
+        jbyteArray scid, jbyteArray dcid, jbyteArray new_scid,
+        jbyteArray token, jint version,
+        jobject out, jint out_len) {
+    uint8_t *out_data =
+            (uint8_t *)(*env)->GetDirectBufferAddress(env, out);
+    if (out_data == NULL) {
+        return -1;
+    }
+    jbyte *scid_buf = (*env)->GetByteArrayElements(env, scid, NULL);
+    jsize scid_len = (*env)->GetArrayLength(env, scid);
+    jbyte *dcid_buf = (*env)->GetByteArrayElements(env, dcid, NULL);
+    jsize dcid_len = (*env)->GetArrayLength(env, dcid);
+    jbyte *new_scid_buf = (*env)->GetByteArrayElements(env, new_scid, NULL);
+    jsize new_scid_len = (*env)->GetArrayLength(env, new_scid);
+    jbyte *token_buf = (*env)->GetByteArrayElements(env, token, NULL);
+    jsize token_len = (*env)->GetArrayLength(env, token);
+
+    ssize_t written = quiche_retry(
+            (const uint8_t *)scid_buf, (size_t)scid_len,
+            (const uint8_t *)dcid_buf, (size_t)dcid_len,
+            (const uint8_t *)new_scid_buf, (size_t)new_scid_len,
+            (const uint8_t *)token_buf, (size_t)token_len,
+            (uint32_t)version, out_data, (size_t)out_len);
+
+    (*env)->ReleaseByteArrayElements(env, scid, scid_buf, JNI_ABORT);
+    (*env)->ReleaseByteArrayElements(env, dcid, dcid_buf, JNI_ABORT);
+    (*env)->ReleaseByteArrayElements(env, new_scid, new_scid_buf, JNI_ABORT);
+    (*env)->ReleaseByteArrayElements(env, token, token_buf, JNI_ABORT);
+    return (jint)written;
+}
+
+#define QUIC_VERSION_2 0x6b3343cf
+
+/* RFC 9001 section 5.2 and RFC 9369 section 3.3.1 */
+static const uint8_t initial_salt_v1[20] = {
+    0x38, 0x76, 0x2c, 0xf7, 0xf5, 0x59, 0x34, 0xb3, 0x4d, 0x17,
+    0x9a, 0xe6, 0xa4, 0xc8, 0x0c, 0xad, 0xcc, 0xbb, 0x7f, 0x0a
+};
+static const uint8_t initial_salt_v2[20] = {
+    0x0d, 0xed, 0xe3, 0xde, 0xf7, 0x00, 0xa6, 0xdb, 0x81, 0x93,
+    0x81, 0xbe, 0x6e, 0x26, 0x9d, 0xcb, 0xf9, 0xbd, 0x2e, 0xd9
+};
+
+/* RFC 9000 section 16: variable-length integer */
+static size_t put_varint(uint8_t *p, uint64_t v) {
+    if (v < 0x40) {
+        p[0] = (uint8_t)v;
+        return 1;
+    }
+    if (v < 0x4000) {
+        p[0] = (uint8_t)(0x40 | (v >> 8));
+        p[1] = (uint8_t)v;
+        return 2;
+    }
+    if (v < 0x40000000) {
+        p[0] = (uint8_t)(0x80 | (v >> 24));
+        p[1] = (uint8_t)(v >> 16);
+        p[2] = (uint8_t)(v >> 8);
+        p[3] = (uint8_t)v;
+        return 4;
+    }
+    p[0] = (uint8_t)(0xc0 | (v >> 56));
+    for (int i = 1; i < 8; i++) {
+        p[i] = (uint8_t)(v >> (8 * (7 - i)));
+    }
+    return 8;
+}
+
+/*
+ * Writes a server Initial packet, packet number 0, whose only frame is
+ * a CONNECTION_CLOSE with the given transport error code. scid and dcid
+ * are as received from the client: the reply is addressed to scid and
+ * sent from dcid, whose Initial keys the client already holds.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quic_1refuse_1connection(
+        JNIEnv *env, jclass cls,
+        jbyteArray scid, jbyteArray dcid, jint version, jlong error_code,
+        jobject out, jint out_len) {
+    uint8_t *p = (uint8_t *)(*env)->GetDirectBufferAddress(env, out);
+    jsize scid_len = (*env)->GetArrayLength(env, scid);
+    jsize dcid_len = (*env)->GetArrayLength(env, dcid);
+    if (p == NULL || scid_len > QUICHE_MAX_CONN_ID_LEN
+            || dcid_len > QUICHE_MAX_CONN_ID_LEN) {
+        return -1;
+    }
+    uint8_t scid_buf[QUICHE_MAX_CONN_ID_LEN];
+    uint8_t dcid_buf[QUICHE_MAX_CONN_ID_LEN];
+    (*env)->GetByteArrayRegion(env, scid, 0, scid_len, (jbyte *)scid_buf);
+    (*env)->GetByteArrayRegion(env, dcid, 0, dcid_len, (jbyte *)dcid_buf);
+
+    int v2 = ((uint32_t)version == QUIC_VERSION_2);
+    uint8_t initial_secret[32];
+    size_t initial_secret_len;
+    uint8_t secret[32];
+    uint8_t key[16];
+    uint8_t iv[12];
+    uint8_t hp[16];
+    if (!HKDF_extract(initial_secret, &initial_secret_len, EVP_sha256(),
+                      dcid_buf, (size_t)dcid_len,
+                      v2 ? initial_salt_v2 : initial_salt_v1, 20)
+            || !gumdrop_hkdf_expand_label(secret, sizeof(secret),
+                                          EVP_sha256(), initial_secret,
+                                          initial_secret_len, "server in")
+            || !gumdrop_hkdf_expand_label(key, sizeof(key), EVP_sha256(),
+                                          secret, sizeof(secret),
+                                          v2 ? "quicv2 key" : "quic key")
+            || !gumdrop_hkdf_expand_label(iv, sizeof(iv), EVP_sha256(),
+                                          secret, sizeof(secret),
+                                          v2 ? "quicv2 iv" : "quic iv")
+            || !gumdrop_hkdf_expand_label(hp, sizeof(hp), EVP_sha256(),
+                                          secret, sizeof(secret),
+                                          v2 ? "quicv2 hp" : "quic hp")) {
+        return -1;
+    }
+
+    /* CONNECTION_CLOSE: type, error code, frame type 0, empty reason */
+    uint8_t frame[1 + 8 + 1 + 1];
+    size_t frame_len = 0;
+    frame[frame_len++] = 0x1c;
+    frame_len += put_varint(frame + frame_len, (uint64_t)error_code);
+    frame[frame_len++] = 0;
+    frame[frame_len++] = 0;
+
+    size_t tag_len = EVP_AEAD_max_overhead(EVP_aead_aes_128_gcm());
+    size_t header_len = 1 + 4 + 1 + (size_t)scid_len + 1
+            + (size_t)dcid_len + 1 + 2 + 1;
+    if (header_len + frame_len + tag_len > (size_t)out_len) {
+        return -1;
+    }
+
+    /* Long header, Initial type (0b00 in v1, 0b01 in v2), 1-byte PN */
+    size_t n = 0;
+    p[n++] = (uint8_t)(0xc0 | ((v2 ? 0x01 : 0x00) << 4));
+    p[n++] = (uint8_t)((uint32_t)version >> 24);
+    p[n++] = (uint8_t)((uint32_t)version >> 16);
+    p[n++] = (uint8_t)((uint32_t)version >> 8);
+    p[n++] = (uint8_t)version;
+    p[n++] = (uint8_t)scid_len;
+    memcpy(p + n, scid_buf, (size_t)scid_len);
+    n += (size_t)scid_len;
+    p[n++] = (uint8_t)dcid_len;
+    memcpy(p + n, dcid_buf, (size_t)dcid_len);
+    n += (size_t)dcid_len;
+    p[n++] = 0; /* token length */
+    size_t length = 1 + frame_len + tag_len;
+    p[n++] = (uint8_t)(0x40 | (length >> 8));
+    p[n++] = (uint8_t)length;
+    size_t pn_offset = n;
+    p[n++] = 0; /* packet number 0, so the nonce is the IV */
+    memcpy(p + n, frame, frame_len);
+
+    EVP_AEAD_CTX aead;
+    size_t sealed_len;
+    if (!EVP_AEAD_CTX_init(&aead, EVP_aead_aes_128_gcm(), key, sizeof(key),
+                           tag_len, NULL)) {
+        return -1;
+    }
+    int ok = EVP_AEAD_CTX_seal(&aead, p + n, &sealed_len,
+                               (size_t)out_len - n, iv, sizeof(iv),
+                               p + n, frame_len, p, n);
+    EVP_AEAD_CTX_cleanup(&aead);
+    if (!ok) {
+        return -1;
+    }
+
+    /* RFC 9001 section 5.4: header protection, sampled 4 bytes past
+     * the start of the packet number */
+    AES_KEY hp_key;
+    uint8_t mask[16];
+    AES_set_encrypt_key(hp, 128, &hp_key);
+    AES_encrypt(p + pn_offset + 4, mask, &hp_key);
+    p[0] ^= mask[0] & 0x0f;
+    p[pn_offset] ^= mask[1];
+
+    return (jint)(n + sealed_len);
+}
+
 /* ── Security info ── */
 
 JNIEXPORT jstring JNICALL
@@ -552,14 +1384,14 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1application_1proto(
     }
 
     /* ALPN protocol bytes need null-termination for NewStringUTF */
-    char *proto_str = (char *)malloc(proto_len + 1);
+    char *proto_str = (char *)gumdrop_malloc(proto_len + 1);
     if (proto_str == NULL) {
         return NULL;
     }
     memcpy(proto_str, proto, proto_len);
     proto_str[proto_len] = '\0';
     jstring result = (*env)->NewStringUTF(env, proto_str);
-    free(proto_str);
+    gumdrop_free(proto_str);
     return result;
 }
 
@@ -588,6 +1420,7 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1close(
         reason_str = (*env)->GetStringUTFChars(env, reason, NULL);
         reason_len = strlen(reason_str);
     }
+    GUMDROP_PROBE3(conn__close, conn, app == JNI_TRUE, err);
     int rc = quiche_conn_close(conn, app == JNI_TRUE,
                                (uint64_t)err,
                                (const uint8_t *)reason_str, reason_len);
@@ -597,11 +1430,434 @@ Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1close(
     return (jint)rc;
 }
 
+/* ── Socket handoff ── */
+
+/*
+ * A graceful upgrade passes the bound UDP sockets of the running
+ * process to its replacement over a UNIX domain socket as SCM_RIGHTS
+ * ancillary data, so that the new process receives on the same ports
+ * without ever unbinding them and no datagram is refused in between.
+ * The JDK cannot wrap a received descriptor in a channel, so the new
+ * process opens a channel of the same family and has the received
+ * socket dup2()ed over it.
+ */
+
+#define HANDOFF_MAX_FDS 64
+
+/*
+ * Sends data on a connected UNIX stream socket channel in blocking
+ * mode, with the descriptors of the given channels attached.
+ * Returns the number of bytes sent, or -1 on error.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_handoff_1send(
+        JNIEnv *env, jclass cls, jobject channel, jbyteArray data,
+        jobjectArray channels) {
+    int sock = gumdrop_channel_fd(env, channel);
+    jsize len = (*env)->GetArrayLength(env, data);
+    jsize n = (channels != NULL) ? (*env)->GetArrayLength(env, channels) : 0;
+    int fds[HANDOFF_MAX_FDS];
+    union {
+        char buf[CMSG_SPACE(sizeof(int) * HANDOFF_MAX_FDS)];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg;
+    struct iovec iov;
+    ssize_t sent;
+    jsize i;
+
+    if (sock < 0 || len == 0 || n > HANDOFF_MAX_FDS) {
+        return -1;
+    }
+    for (i = 0; i < n; i++) {
+        jobject ch = (*env)->GetObjectArrayElement(env, channels, i);
+        fds[i] = gumdrop_channel_fd(env, ch);
+        (*env)->DeleteLocalRef(env, ch);
+        if (fds[i] < 0) {
+            return -1;
+        }
+    }
+    jbyte *bytes = (*env)->GetByteArrayElements(env, data, NULL);
+    if (bytes == NULL) {
+        return -1;
+    }
+    iov.iov_base = bytes;
+    iov.iov_len = (size_t)len;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (n > 0) {
+        struct cmsghdr *cmsg;
+        memset(&control, 0, sizeof(control));
+        msg.msg_control = control.buf;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * n);
+        cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * n);
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * n);
+    }
+    do {
+        sent = sendmsg(sock, &msg, 0);
+    } while (sent < 0 && errno == EINTR);
+    (*env)->ReleaseByteArrayElements(env, data, bytes, JNI_ABORT);
+    return (jint)sent;
+}
+
+/*
+ * Receives data from a UNIX stream socket channel in blocking mode,
+ * storing any descriptors that came with it in fds and -1 in the
+ * remaining slots. Descriptors that do not fit are closed.
+ * Returns the number of bytes received, 0 at end of stream, or -1 on
+ * error.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_handoff_1recv(
+        JNIEnv *env, jclass cls, jobject channel, jbyteArray data,
+        jintArray fds_arr) {
+    int sock = gumdrop_channel_fd(env, channel);
+    jsize len = (*env)->GetArrayLength(env, data);
+    jsize max_fds = (*env)->GetArrayLength(env, fds_arr);
+    jint fds[HANDOFF_MAX_FDS];
+    union {
+        char buf[CMSG_SPACE(sizeof(int) * HANDOFF_MAX_FDS)];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    ssize_t received;
+    jsize count = 0;
+    int flags = 0;
+    jsize i;
+
+    if (sock < 0 || len == 0) {
+        return -1;
+    }
+    if (max_fds > HANDOFF_MAX_FDS) {
+        max_fds = HANDOFF_MAX_FDS;
+    }
+    jbyte *bytes = (*env)->GetByteArrayElements(env, data, NULL);
+    if (bytes == NULL) {
+        return -1;
+    }
+    iov.iov_base = bytes;
+    iov.iov_len = (size_t)len;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+#ifdef MSG_CMSG_CLOEXEC
+    flags |= MSG_CMSG_CLOEXEC;
+#endif
+    do {
+        received = recvmsg(sock, &msg, flags);
+    } while (received < 0 && errno == EINTR);
+    if (received > 0) {
+        for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
+             cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET
+                    || cmsg->cmsg_type != SCM_RIGHTS) {
+                continue;
+            }
+            size_t n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            int *p = (int *)CMSG_DATA(cmsg);
+            size_t j;
+            for (j = 0; j < n; j++) {
+                if (count < max_fds) {
+                    fds[count++] = p[j];
+                } else {
+                    close(p[j]);
+                }
+            }
+        }
+    }
+    for (i = count; i < max_fds; i++) {
+        fds[i] = -1;
+    }
+    (*env)->ReleaseByteArrayElements(env, data, bytes,
+                                     received > 0 ? 0 : JNI_ABORT);
+    if (max_fds > 0) {
+        (*env)->SetIntArrayRegion(env, fds_arr, 0, max_fds, fds);
+    }
+    return (jint)received;
+}
+
+/*
+ * Replaces the socket of an open DatagramChannel with a received
+ * descriptor of the same address family, in non-blocking mode.
+ * The received descriptor is closed in any case.
+ * Returns 0 on success, -1 on error.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_datagram_1channel_1adopt(
+        JNIEnv *env, jclass cls, jobject channel, jint fd) {
+    int target = gumdrop_channel_fd(env, channel);
+    struct sockaddr_storage a, b;
+    socklen_t a_len = sizeof(a), b_len = sizeof(b);
+    int rc = -1;
+    int flags;
+
+    if (target >= 0
+            && getsockname(fd, (struct sockaddr *)&a, &a_len) == 0
+            && getsockname(target, (struct sockaddr *)&b, &b_len) == 0
+            && a.ss_family == b.ss_family
+            && (flags = fcntl(fd, F_GETFL)) >= 0
+            && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0
+            && dup2(fd, target) >= 0) {
+        rc = 0;
+    }
+    close(fd);
+    return rc;
+}
+
+/*
+ * Closes a received descriptor that will not be adopted.
+ */
+JNIEXPORT void JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_fd_1close(
+        JNIEnv *env, jclass cls, jint fd) {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+/* ── Receive timestamps ── */
+
+/*
+ * The kernel can stamp each datagram as it arrives (SO_TIMESTAMPING
+ * with software receive stamps, or SO_TIMESTAMPNS), which measures how
+ * long a packet waited in the socket buffer for the event loop to read
+ * it. quiche's recv_info has no receive time, since quiche reads the
+ * clock itself when a packet is passed to it, so the delay is reported
+ * to the application rather than to quiche.
+ */
+
+/*
+ * Asks the kernel to timestamp datagrams received on a UDP socket.
+ * Returns 0 on success, -1 if unsupported.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_udp_1enable_1rx_1timestamps(
+        JNIEnv *env, jclass cls, jobject channel) {
+#ifdef __linux__
+    int fd = gumdrop_channel_fd(env, channel);
+    int on = 1;
+    if (fd < 0) {
+        return -1;
+    }
+#ifdef SO_TIMESTAMPING
+    int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING,
+                   &flags, sizeof(flags)) == 0) {
+        return 0;
+    }
+#endif
+    return setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS,
+                      &on, sizeof(on)) == 0 ? 0 : -1;
+#else
+    return -1;
+#endif
+}
+
+/*
+ * Receives a datagram into a direct buffer at offset 0, in the same way
+ * as DatagramChannel.receive, and stores the sender's address in
+ * from_addr and in delay[0] the nanoseconds since the kernel stamped
+ * it, or -1 if it carried no timestamp.
+ * Returns the datagram length, 0 if none was waiting (or it was
+ * empty), or -1 on error.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_udp_1recv(
+        JNIEnv *env, jclass cls, jobject channel, jobject buf, jint len,
+        jbyteArray from_addr, jlongArray delay) {
+    int fd = gumdrop_channel_fd(env, channel);
+    uint8_t *data = (uint8_t *)(*env)->GetDirectBufferAddress(env, buf);
+    struct sockaddr_storage from;
+    union {
+        char buf[CMSG_SPACE(sizeof(struct timespec) * 3)];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    ssize_t n;
+    jlong elapsed = -1;
+
+    if (fd < 0 || data == NULL) {
+        return -1;
+    }
+    iov.iov_base = data;
+    iov.iov_len = (size_t)len;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &from;
+    msg.msg_namelen = sizeof(from);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    do {
+        n = recvmsg(fd, &msg, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+    encode_address(env, &from, from_addr);
+
+#ifdef __linux__
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        struct timespec ts[3];
+        struct timespec now;
+        if (cmsg->cmsg_level != SOL_SOCKET) {
+            continue;
+        }
+        memset(ts, 0, sizeof(ts));
+        if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            memcpy(ts, CMSG_DATA(cmsg), sizeof(struct timespec));
+#ifdef SCM_TIMESTAMPING
+        } else if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+            /* ts[0] is the software stamp */
+            memcpy(ts, CMSG_DATA(cmsg), sizeof(ts));
+#endif
+        } else {
+            continue;
+        }
+        if (ts[0].tv_sec == 0 && ts[0].tv_nsec == 0) {
+            continue;
+        }
+        clock_gettime(CLOCK_REALTIME, &now);
+        elapsed = (jlong)(now.tv_sec - ts[0].tv_sec) * 1000000000LL
+                + (now.tv_nsec - ts[0].tv_nsec);
+        if (elapsed < 0) {
+            elapsed = 0;
+        }
+        break;
+    }
+#else
+    (void)cmsg;
+#endif
+    (*env)->SetLongArrayRegion(env, delay, 0, 1, &elapsed);
+    return (jint)n;
+}
+
+/*
+ * Rewrites an IPv4 address as IPv4-mapped IPv6, for a dual-stack
+ * socket that does not take AF_INET addresses.
+ */
+static socklen_t map_ipv4_address(struct sockaddr_storage *ss) {
+    struct sockaddr_in sin;
+    struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)ss;
+
+    memcpy(&sin, ss, sizeof(sin));
+    memset(ss, 0, sizeof(*ss));
+    sin6->sin6_family = AF_INET6;
+    sin6->sin6_port = sin.sin_port;
+    sin6->sin6_addr.s6_addr[10] = 0xff;
+    sin6->sin6_addr.s6_addr[11] = 0xff;
+    memcpy(&sin6->sin6_addr.s6_addr[12], &sin.sin_addr, 4);
+    return sizeof(*sin6);
+}
+
+/*
+ * Sends len bytes of a direct buffer, from offset 0, to to_addr, in the
+ * same way as DatagramChannel.send, but tells apart a datagram larger
+ * than the interface allows (EMSGSIZE), which a path MTU probe expects
+ * to lose (RFC 8899 section 4.4), from other errors.
+ * Returns len, 0 if the socket buffer is full, -2 for EMSGSIZE or -1
+ * on any other error.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_udp_1send(
+        JNIEnv *env, jclass cls, jobject channel, jobject buf, jint len,
+        jbyteArray to_addr) {
+    int fd = gumdrop_channel_fd(env, channel);
+    uint8_t *data = (uint8_t *)(*env)->GetDirectBufferAddress(env, buf);
+    struct sockaddr_storage to;
+    socklen_t to_len;
+    ssize_t n;
+
+    if (fd < 0 || data == NULL) {
+        return -1;
+    }
+    to_len = decode_address(env, to_addr, &to);
+    if (to_len == 0) {
+        return -1;
+    }
+    do {
+        n = sendto(fd, data, (size_t)len, 0, (struct sockaddr *)&to,
+                   to_len);
+        if (n < 0 && (errno == EAFNOSUPPORT || errno == EINVAL)
+                && to.ss_family == AF_INET) {
+            to_len = map_ipv4_address(&to);
+            errno = EINTR;
+        }
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+        return (errno == EMSGSIZE) ? -2 : -1;
+    }
+    return (jint)n;
+}
+
+/* ── Native memory accounting ── */
+
+/*
+ * Returns { bytes, blocks } currently allocated by the JNI layer through
+ * gumdrop_alloc.h, and the bytes in use on the process's native heap,
+ * which also covers quiche and BoringSSL, or -1 where the allocator
+ * cannot say. Memory the allocator maps directly (large blocks) is
+ * included.
+ */
+JNIEXPORT jlongArray JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_native_1memory_1stats(
+        JNIEnv *env, jclass cls) {
+    jlong heap = -1;
+#if defined(__APPLE__)
+    malloc_statistics_t ms;
+    malloc_zone_statistics(NULL, &ms);
+    heap = (jlong)ms.size_in_use;
+#elif defined(__GLIBC__)
+#if __GLIBC_PREREQ(2, 33)
+    struct mallinfo2 mi = mallinfo2();
+    heap = (jlong)(mi.uordblks + mi.hblkhd);
+#endif
+#endif
+    jlong values[3] = {
+        (jlong)__atomic_load_n(&gumdrop_native_bytes, __ATOMIC_RELAXED),
+        (jlong)__atomic_load_n(&gumdrop_native_allocations, __ATOMIC_RELAXED),
+        heap
+    };
+    jlongArray result = (*env)->NewLongArray(env, 3);
+    if (result != NULL) {
+        (*env)->SetLongArrayRegion(env, result, 0, 3, values);
+    }
+    return result;
+}
+
+/*
+ * Returns the bytes the connection has in flight, a cheaper probe than
+ * quiche_conn_path_stats for periodic polling.
+ */
+JNIEXPORT jlong JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1bytes_1in_1flight(
+        JNIEnv *env, jclass cls, jlong conn_ptr) {
+    quiche_conn *conn = (quiche_conn *)(intptr_t)conn_ptr;
+    quiche_stats stats;
+    quiche_conn_stats(conn, &stats);
+    return conn_bytes_in_flight(&stats);
+}
+
 /* ── Cleanup ── */
 
 JNIEXPORT void JNICALL
 Java_org_bluezoo_gumdrop_GumdropNative_quiche_1conn_1free(
         JNIEnv *env, jclass cls, jlong conn_ptr) {
     quiche_conn *conn = (quiche_conn *)(intptr_t)conn_ptr;
+    GUMDROP_PROBE1(conn__free, conn);
     quiche_conn_free(conn);
 }
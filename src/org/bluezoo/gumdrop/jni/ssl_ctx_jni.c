@@ -26,16 +26,68 @@
  * cipher suites and key exchange groups (including PQC groups such as
  * X25519MLKEM768). The configured SSL_CTX produces SSL objects that are
  * passed to quiche_conn_new_with_tls() for full control over the TLS 1.3
- * parameters used by QUIC connections.
+ * parameters used by QUIC connections, or driven directly over memory
+ * BIOs as the native TLS engine for TCP endpoints.
  *
  * Build: see the project README for compilation instructions.
  */
 
 #include <jni.h>
 #include <openssl/ssl.h>
+#include <openssl/bytestring.h>
 #include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/pem.h>
+#include <openssl/pool.h>
+#include <openssl/rand.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <zlib.h>
+#include <brotli/decode.h>
+#include <brotli/encode.h>
+#include <dirent.h>
+#include <time.h>
+
+#include "gumdrop_alloc.h"
+#include "gumdrop_fd.h"
+#include "gumdrop_hkdf.h"
+#define GUMDROP_PROBE_SEMAPHORES
+#include "gumdrop_probes.h"
+
+/* ── Tracing ── */
+
+GUMDROP_PROBE_SEMAPHORE(handshake__done);
+
+#ifdef GUMDROP_PROBES
+/* Fires handshake__done for QUIC and TCP connections alike */
+static void probe_info_cb(const SSL *ssl, int where, int ret) {
+    if (where & SSL_CB_HANDSHAKE_DONE) {
+        GUMDROP_PROBE3(handshake__done, ssl, SSL_is_server(ssl),
+                       SSL_session_reused(ssl));
+    }
+}
+#endif
+
+/*
+ * BoringSSL calls the info callback at every handshake state change, so
+ * it is only set on connections created while a tracer is attached to
+ * handshake__done.
+ */
+static void probe_ssl_new(SSL *ssl) {
+#ifdef GUMDROP_PROBES
+    if (GUMDROP_PROBE_ENABLED(handshake__done)) {
+        SSL_set_info_callback(ssl, probe_info_cb);
+    }
+#else
+    (void)ssl;
+#endif
+}
 
 /* ── SSL_CTX management ── */
 
@@ -114,16 +166,22 @@ typedef struct {
 } alpn_protos_t;
 
 static int ssl_ctx_ex_data_index = -1;
+static pthread_once_t alpn_once = PTHREAD_ONCE_INIT;
 
 static void alpn_protos_free(void *parent, void *ptr, CRYPTO_EX_DATA *ad,
                              int index, long argl, void *argp) {
     alpn_protos_t *protos = (alpn_protos_t *)ptr;
     if (protos != NULL) {
-        free(protos->data);
-        free(protos);
+        gumdrop_free(protos->data);
+        gumdrop_free(protos);
     }
 }
 
+static void alpn_init(void) {
+    ssl_ctx_ex_data_index = SSL_CTX_get_ex_new_index(
+            0, NULL, NULL, NULL, alpn_protos_free);
+}
+
 static int alpn_select_cb(SSL *ssl, const unsigned char **out,
                           unsigned char *outlen,
                           const unsigned char *in, unsigned int inlen,
@@ -156,13 +214,10 @@ Java_org_bluezoo_gumdrop_GumdropNative_ssl_1ctx_1set_1alpn_1protos(
                                        (unsigned int)len);
 
     /* Server-side: install selection callback with the same protocols */
-    if (ssl_ctx_ex_data_index < 0) {
-        ssl_ctx_ex_data_index = SSL_CTX_get_ex_new_index(
-                0, NULL, NULL, NULL, alpn_protos_free);
-    }
+    pthread_once(&alpn_once, alpn_init);
 
-    alpn_protos_t *ap = (alpn_protos_t *)malloc(sizeof(alpn_protos_t));
-    ap->data = (unsigned char *)malloc(len);
+    alpn_protos_t *ap = (alpn_protos_t *)gumdrop_malloc(sizeof(alpn_protos_t));
+    ap->data = (unsigned char *)gumdrop_malloc(len);
     memcpy(ap->data, buf, len);
     ap->len = (unsigned int)len;
     SSL_CTX_set_ex_data(ctx, ssl_ctx_ex_data_index, ap);
@@ -180,11 +235,2527 @@ Java_org_bluezoo_gumdrop_GumdropNative_ssl_1ctx_1set_1verify_1peer(
     SSL_CTX_set_verify(ctx, mode, NULL);
 }
 
-JNIEXPORT jlong JNICALL
-Java_org_bluezoo_gumdrop_GumdropNative_ssl_1new(
-        JNIEnv *env, jclass cls, jlong ctx_ptr) {
+/* ── Client session cache (RFC 8446 section 4.6.1, RFC 9001 section 4.5) ──
+ *
+ * quiche installs its own new-session callback only on the SSL_CTX it
+ * creates internally; connections created with quiche_conn_new_with_tls()
+ * on our SSL_CTX never see tickets. This cache captures each
+ * NewSessionTicket, serializes it in the format quiche_conn_set_session()
+ * expects, and keys it by SNI name:
+ *
+ *   [u64 BE session length][SSL_SESSION bytes]
+ *   [u64 BE params length][peer QUIC transport parameters]
+ *
+ * The peer's transport parameters are remembered so that 0-RTT data
+ * respects the limits the server advertised (RFC 9000 section 7.4.1).
+ * TLS 1.3 tickets should be used only once (RFC 8446 appendix C.4), so
+ * a lookup removes the entry. Sessions arrive on any SelectorLoop
+ * sharing the SSL_CTX, hence the mutex.
+ */
+
+typedef struct session_entry {
+    char *server_name;
+    uint8_t *data;
+    size_t len;
+    struct session_entry *next;
+} session_entry_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    session_entry_t *head;      /* most recently stored first */
+    int count;
+    int max_entries;
+} session_cache_t;
+
+static int session_cache_ex_data_index = -1;
+static pthread_once_t session_cache_once = PTHREAD_ONCE_INIT;
+
+static void session_entry_free(session_entry_t *e) {
+    gumdrop_free(e->server_name);
+    gumdrop_free(e->data);
+    gumdrop_free(e);
+}
+
+static void session_cache_free(void *parent, void *ptr, CRYPTO_EX_DATA *ad,
+                               int index, long argl, void *argp) {
+    session_cache_t *cache = (session_cache_t *)ptr;
+    if (cache == NULL) {
+        return;
+    }
+    session_entry_t *e = cache->head;
+    while (e != NULL) {
+        session_entry_t *next = e->next;
+        session_entry_free(e);
+        e = next;
+    }
+    pthread_mutex_destroy(&cache->lock);
+    gumdrop_free(cache);
+}
+
+static void session_cache_init(void) {
+    session_cache_ex_data_index = SSL_CTX_get_ex_new_index(
+            0, NULL, NULL, NULL, session_cache_free);
+}
+
+/* Unlinks and returns the entry for name, or NULL. Caller holds lock. */
+static session_entry_t *session_cache_unlink(session_cache_t *cache,
+                                             const char *name) {
+    session_entry_t **pp = &cache->head;
+    while (*pp != NULL) {
+        session_entry_t *e = *pp;
+        if (strcmp(e->server_name, name) == 0) {
+            *pp = e->next;
+            cache->count--;
+            return e;
+        }
+        pp = &e->next;
+    }
+    return NULL;
+}
+
+static void put_u64_be(uint8_t *p, uint64_t v) {
+    int i;
+    for (i = 7; i >= 0; i--) {
+        p[i] = (uint8_t)(v & 0xff);
+        v >>= 8;
+    }
+}
+
+static int new_session_cb(SSL *ssl, SSL_SESSION *session) {
+    SSL_CTX *ctx = SSL_get_SSL_CTX(ssl);
+    session_cache_t *cache = (session_cache_t *)SSL_CTX_get_ex_data(
+            ctx, session_cache_ex_data_index);
+    const char *name = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+    if (cache == NULL || name == NULL || SSL_is_server(ssl)) {
+        return 0;
+    }
+
+    uint8_t *sess_bytes = NULL;
+    size_t sess_len = 0;
+    if (!SSL_SESSION_to_bytes(session, &sess_bytes, &sess_len)) {
+        return 0;
+    }
+    const uint8_t *params = NULL;
+    size_t params_len = 0;
+    SSL_get_peer_quic_transport_params(ssl, &params, &params_len);
+
+    session_entry_t *e =
+            (session_entry_t *)gumdrop_malloc(sizeof(session_entry_t));
+    size_t len = 8 + sess_len + 8 + params_len;
+    uint8_t *data = (uint8_t *)gumdrop_malloc(len);
+    char *server_name = gumdrop_strdup(name);
+    if (e == NULL || data == NULL || server_name == NULL) {
+        gumdrop_free(e);
+        gumdrop_free(data);
+        gumdrop_free(server_name);
+        OPENSSL_free(sess_bytes);
+        return 0;
+    }
+    put_u64_be(data, (uint64_t)sess_len);
+    memcpy(data + 8, sess_bytes, sess_len);
+    put_u64_be(data + 8 + sess_len, (uint64_t)params_len);
+    if (params_len > 0) {
+        memcpy(data + 16 + sess_len, params, params_len);
+    }
+    OPENSSL_free(sess_bytes);
+    e->server_name = server_name;
+    e->data = data;
+    e->len = len;
+
+    pthread_mutex_lock(&cache->lock);
+    /* Keep only the newest ticket per server */
+    session_entry_t *old = session_cache_unlink(cache, name);
+    if (old != NULL) {
+        session_entry_free(old);
+    }
+    e->next = cache->head;
+    cache->head = e;
+    cache->count++;
+    if (cache->count > cache->max_entries) {
+        /* Evict the oldest */
+        session_entry_t **pp = &cache->head;
+        while ((*pp)->next != NULL) {
+            pp = &(*pp)->next;
+        }
+        session_entry_free(*pp);
+        *pp = NULL;
+        cache->count--;
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    /* 0: we did not take a reference to session */
+    return 0;
+}
+
+/*
+ * Caches the sessions servers send this client SSL_CTX, keyed by server
+ * name, for ssl_ctx_take_session. Only for client contexts: a server's
+ * own sessions must not end up here.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_ssl_1ctx_1enable_1session_1cache(
+        JNIEnv *env, jclass cls, jlong ctx_ptr, jint max_entries) {
     SSL_CTX *ctx = (SSL_CTX *)(intptr_t)ctx_ptr;
-    SSL *ssl = SSL_new(ctx);
+    pthread_once(&session_cache_once, session_cache_init);
+    if (SSL_CTX_get_ex_data(ctx, session_cache_ex_data_index) != NULL) {
+        return 0;
+    }
+    session_cache_t *cache =
+            (session_cache_t *)gumdrop_calloc(1, sizeof(session_cache_t));
+    if (cache == NULL) {
+        return -1;
+    }
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->max_entries = max_entries > 0 ? max_entries : 1;
+    SSL_CTX_set_ex_data(ctx, session_cache_ex_data_index, cache);
+
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT);
+    SSL_CTX_sess_set_new_cb(ctx, new_session_cb);
+    return 0;
+}
+
+JNIEXPORT jbyteArray JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_ssl_1ctx_1take_1session(
+        JNIEnv *env, jclass cls, jlong ctx_ptr, jstring server_name) {
+    SSL_CTX *ctx = (SSL_CTX *)(intptr_t)ctx_ptr;
+    pthread_once(&session_cache_once, session_cache_init);
+    session_cache_t *cache = (session_cache_t *)SSL_CTX_get_ex_data(
+            ctx, session_cache_ex_data_index);
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    const char *name = (*env)->GetStringUTFChars(env, server_name, NULL);
+    pthread_mutex_lock(&cache->lock);
+    session_entry_t *e = session_cache_unlink(cache, name);
+    pthread_mutex_unlock(&cache->lock);
+    (*env)->ReleaseStringUTFChars(env, server_name, name);
+    if (e == NULL) {
+        return NULL;
+    }
+
+    jbyteArray result = (*env)->NewByteArray(env, (jsize)e->len);
+    if (result != NULL) {
+        (*env)->SetByteArrayRegion(env, result, 0, (jsize)e->len,
+                                   (const jbyte *)e->data);
+    }
+    session_entry_free(e);
+    return result;
+}
+
+/* RFC 8446 section 4.2.10: permit 0-RTT on connections from this SSL_CTX */
+JNIEXPORT void JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_ssl_1ctx_1set_1early_1data_1enabled(
+        JNIEnv *env, jclass cls, jlong ctx_ptr, jboolean enabled) {
+    SSL_CTX *ctx = (SSL_CTX *)(intptr_t)ctx_ptr;
+    SSL_CTX_set_early_data_enabled(ctx, enabled == JNI_TRUE);
+}
+
+/* ── Server session ticket keys (RFC 8446 section 4.6.1, RFC 5077) ──
+ *
+ * By default every SSL_CTX encrypts tickets under its own random key, so
+ * a ticket issued by one process cannot be redeemed by another. This
+ * ring holds keys supplied from Java instead: the first key encrypts new
+ * tickets and every key in the ring is accepted for decryption. Each key
+ * is 80 bytes, laid out as nginx and HAProxy store them:
+ *
+ *   [16 bytes key name][32 bytes HMAC-SHA256 key][32 bytes AES-256 key]
+ *
+ * The ring is replaced while handshakes run on other SelectorLoops, so
+ * the callback copies the key it needs under a read lock.
+ */
+
+#define TICKET_KEY_NAME_LEN 16
+#define TICKET_KEY_SECRET_LEN 32
+#define TICKET_KEY_LEN (TICKET_KEY_NAME_LEN + 2 * TICKET_KEY_SECRET_LEN)
+#define TICKET_KEY_MAX 4
+
+typedef struct {
+    pthread_rwlock_t lock;
+    uint8_t keys[TICKET_KEY_MAX][TICKET_KEY_LEN];
+    int count;
+} ticket_keys_t;
+
+static int ticket_keys_ex_data_index = -1;
+static pthread_once_t ticket_keys_once = PTHREAD_ONCE_INIT;
+
+static void ticket_keys_free(void *parent, void *ptr, CRYPTO_EX_DATA *ad,
+                             int index, long argl, void *argp) {
+    ticket_keys_t *ring = (ticket_keys_t *)ptr;
+    if (ring == NULL) {
+        return;
+    }
+    OPENSSL_cleanse(ring->keys, sizeof(ring->keys));
+    pthread_rwlock_destroy(&ring->lock);
+    gumdrop_free(ring);
+}
+
+static void ticket_keys_init(void) {
+    ticket_keys_ex_data_index = SSL_CTX_get_ex_new_index(
+            0, NULL, NULL, NULL, ticket_keys_free);
+}
+
+static int ticket_key_cb(SSL *ssl, uint8_t *key_name, uint8_t *iv,
+                         EVP_CIPHER_CTX *cipher_ctx, HMAC_CTX *hmac_ctx,
+                         int encrypt) {
+    SSL_CTX *ctx = SSL_get_SSL_CTX(ssl);
+    ticket_keys_t *ring = (ticket_keys_t *)SSL_CTX_get_ex_data(
+            ctx, ticket_keys_ex_data_index);
+    if (ring == NULL) {
+        return -1;
+    }
+
+    uint8_t key[TICKET_KEY_LEN];
+    int index = -1;
+    pthread_rwlock_rdlock(&ring->lock);
+    if (encrypt) {
+        if (ring->count > 0) {
+            index = 0;
+        }
+    } else {
+        int i;
+        for (i = 0; i < ring->count; i++) {
+            if (CRYPTO_memcmp(ring->keys[i], key_name,
+                              TICKET_KEY_NAME_LEN) == 0) {
+                index = i;
+                break;
+            }
+        }
+    }
+    if (index >= 0) {
+        memcpy(key, ring->keys[index], TICKET_KEY_LEN);
+    }
+    pthread_rwlock_unlock(&ring->lock);
+
+    /* Every path below leaves through the cleanse at the end */
+    int ret;
+    const uint8_t *hmac_key = key + TICKET_KEY_NAME_LEN;
+    const uint8_t *aes_key = hmac_key + TICKET_KEY_SECRET_LEN;
+    if (index < 0) {
+        /* Decrypting with an unknown or retired key: full handshake */
+        ret = encrypt ? -1 : 0;
+    } else if (encrypt) {
+        memcpy(key_name, key, TICKET_KEY_NAME_LEN);
+        if (!RAND_bytes(iv, EVP_MAX_IV_LENGTH)
+                || !EVP_EncryptInit_ex(cipher_ctx, EVP_aes_256_cbc(), NULL,
+                                       aes_key, iv)
+                || !HMAC_Init_ex(hmac_ctx, hmac_key, TICKET_KEY_SECRET_LEN,
+                                 EVP_sha256(), NULL)) {
+            ret = -1;
+        } else {
+            ret = 1;
+        }
+    } else if (!HMAC_Init_ex(hmac_ctx, hmac_key, TICKET_KEY_SECRET_LEN,
+                             EVP_sha256(), NULL)
+            || !EVP_DecryptInit_ex(cipher_ctx, EVP_aes_256_cbc(), NULL,
+                                   aes_key, iv)) {
+        ret = -1;
+    } else {
+        /* 2: accepted under an older key, issue a fresh ticket */
+        ret = index == 0 ? 1 : 2;
+    }
+    OPENSSL_cleanse(key, sizeof(key));
+    return ret;
+}
+
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_ssl_1ctx_1set_1ticket_1keys(
+        JNIEnv *env, jclass cls, jlong ctx_ptr, jbyteArray keys) {
+    SSL_CTX *ctx = (SSL_CTX *)(intptr_t)ctx_ptr;
+    jsize len = (*env)->GetArrayLength(env, keys);
+    if (len == 0 || len % TICKET_KEY_LEN != 0
+            || len / TICKET_KEY_LEN > TICKET_KEY_MAX) {
+        return -1;
+    }
+    pthread_once(&ticket_keys_once, ticket_keys_init);
+    ticket_keys_t *ring = (ticket_keys_t *)SSL_CTX_get_ex_data(
+            ctx, ticket_keys_ex_data_index);
+    if (ring == NULL) {
+        ring = (ticket_keys_t *)gumdrop_calloc(1, sizeof(ticket_keys_t));
+        if (ring == NULL) {
+            return -1;
+        }
+        pthread_rwlock_init(&ring->lock, NULL);
+        SSL_CTX_set_ex_data(ctx, ticket_keys_ex_data_index, ring);
+        SSL_CTX_set_tlsext_ticket_key_cb(ctx, ticket_key_cb);
+    }
+
+    pthread_rwlock_wrlock(&ring->lock);
+    OPENSSL_cleanse(ring->keys, sizeof(ring->keys));
+    (*env)->GetByteArrayRegion(env, keys, 0, len, (jbyte *)ring->keys);
+    ring->count = len / TICKET_KEY_LEN;
+    pthread_rwlock_unlock(&ring->lock);
+    return 0;
+}
+
+/* ── Certificate compression (RFC 8879) ──
+ *
+ * A compressed Certificate message keeps the server's first flight under
+ * the QUIC anti-amplification limit (RFC 9000 section 8.1) for larger
+ * chains. BoringSSL calls the compressor on every full handshake, but
+ * the input only changes when the chain does, so each SSL_CTX remembers
+ * its last input and output per algorithm. The algorithm used on each
+ * connection is recorded in SSL ex_data for statistics.
+ */
+
+#define CERT_COMPRESSION_ZLIB 1     /* RFC 8879 section 7.3 */
+#define CERT_COMPRESSION_BROTLI 2
+
+typedef struct {
+    uint8_t *in;
+    size_t in_len;
+    uint8_t *out;
+    size_t out_len;
+} cert_compression_entry_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    cert_compression_entry_t zlib;
+    cert_compression_entry_t brotli;
+} cert_compression_cache_t;
+
+static int cert_compression_ex_data_index = -1;
+static int cert_compression_ssl_ex_data_index = -1;
+static pthread_once_t cert_compression_once = PTHREAD_ONCE_INIT;
+
+/* The SNI-selected host's cache, if any (see SNI certificate selection) */
+static cert_compression_cache_t *sni_compression_cache(SSL *ssl);
+
+static void cert_compression_entry_clear(cert_compression_entry_t *e) {
+    gumdrop_free(e->in);
+    gumdrop_free(e->out);
+    e->in = NULL;
+    e->out = NULL;
+    e->in_len = 0;
+    e->out_len = 0;
+}
+
+static void cert_compression_cache_free(void *parent, void *ptr,
+                                        CRYPTO_EX_DATA *ad, int index,
+                                        long argl, void *argp) {
+    cert_compression_cache_t *cache = (cert_compression_cache_t *)ptr;
+    if (cache == NULL) {
+        return;
+    }
+    cert_compression_entry_clear(&cache->zlib);
+    cert_compression_entry_clear(&cache->brotli);
+    pthread_mutex_destroy(&cache->lock);
+    gumdrop_free(cache);
+}
+
+static void cert_compression_init(void) {
+    cert_compression_ex_data_index = SSL_CTX_get_ex_new_index(
+            0, NULL, NULL, NULL, cert_compression_cache_free);
+    cert_compression_ssl_ex_data_index = SSL_get_ex_new_index(
+            0, NULL, NULL, NULL, NULL);
+}
+
+static void cert_compression_record(SSL *ssl, int alg) {
+    SSL_set_ex_data(ssl, cert_compression_ssl_ex_data_index,
+                    (void *)(intptr_t)alg);
+}
+
+typedef int (*cert_compress_fn)(const uint8_t *in, size_t in_len,
+                                uint8_t **out, size_t *out_len);
+
+/*
+ * Writes the compressed form of in to out, reusing the cached result if
+ * the input is unchanged. Returns 1 on success.
+ */
+static int cert_compress_cached(SSL *ssl, int alg, CBB *out,
+                                const uint8_t *in, size_t in_len,
+                                cert_compress_fn compress) {
+    cert_compression_cache_t *cache = sni_compression_cache(ssl);
+    if (cache == NULL) {
+        cache = (cert_compression_cache_t *)SSL_CTX_get_ex_data(
+                SSL_get_SSL_CTX(ssl), cert_compression_ex_data_index);
+    }
+    if (cache == NULL) {
+        return 0;
+    }
+    cert_compression_entry_t *e = alg == CERT_COMPRESSION_ZLIB
+            ? &cache->zlib : &cache->brotli;
+    int ok = 0;
+    pthread_mutex_lock(&cache->lock);
+    if (e->in == NULL || e->in_len != in_len
+            || memcmp(e->in, in, in_len) != 0) {
+        cert_compression_entry_clear(e);
+        uint8_t *copy = (uint8_t *)gumdrop_malloc(in_len);
+        uint8_t *compressed = NULL;
+        size_t compressed_len = 0;
+        if (copy != NULL
+                && compress(in, in_len, &compressed, &compressed_len)) {
+            memcpy(copy, in, in_len);
+            e->in = copy;
+            e->in_len = in_len;
+            e->out = compressed;
+            e->out_len = compressed_len;
+        } else {
+            gumdrop_free(copy);
+        }
+    }
+    if (e->out != NULL) {
+        ok = CBB_add_bytes(out, e->out, e->out_len);
+    }
+    pthread_mutex_unlock(&cache->lock);
+    if (ok) {
+        cert_compression_record(ssl, alg);
+    }
+    return ok;
+}
+
+static int zlib_compress(const uint8_t *in, size_t in_len,
+                         uint8_t **out, size_t *out_len) {
+    uLongf len = compressBound((uLong)in_len);
+    uint8_t *buf = (uint8_t *)gumdrop_malloc(len);
+    if (buf == NULL) {
+        return 0;
+    }
+    if (compress2(buf, &len, in, (uLong)in_len, Z_BEST_COMPRESSION) != Z_OK) {
+        gumdrop_free(buf);
+        return 0;
+    }
+    *out = buf;
+    *out_len = len;
+    return 1;
+}
+
+static int brotli_compress(const uint8_t *in, size_t in_len,
+                           uint8_t **out, size_t *out_len) {
+    size_t len = BrotliEncoderMaxCompressedSize(in_len);
+    uint8_t *buf = (uint8_t *)gumdrop_malloc(len);
+    if (buf == NULL) {
+        return 0;
+    }
+    if (!BrotliEncoderCompress(BROTLI_MAX_QUALITY, BROTLI_DEFAULT_WINDOW,
+                               BROTLI_MODE_GENERIC, in_len, in, &len, buf)) {
+        gumdrop_free(buf);
+        return 0;
+    }
+    *out = buf;
+    *out_len = len;
+    return 1;
+}
+
+static int zlib_compress_cb(SSL *ssl, CBB *out, const uint8_t *in,
+                            size_t in_len) {
+    return cert_compress_cached(ssl, CERT_COMPRESSION_ZLIB, out,
+                                in, in_len, zlib_compress);
+}
+
+static int brotli_compress_cb(SSL *ssl, CBB *out, const uint8_t *in,
+                              size_t in_len) {
+    return cert_compress_cached(ssl, CERT_COMPRESSION_BROTLI, out,
+                                in, in_len, brotli_compress);
+}
+
+/* RFC 8879 section 4: the result must be exactly uncompressed_len bytes */
+static int zlib_decompress_cb(SSL *ssl, CRYPTO_BUFFER **out,
+                              size_t uncompressed_len,
+                              const uint8_t *in, size_t in_len) {
+    uint8_t *data;
+    CRYPTO_BUFFER *buf = CRYPTO_BUFFER_alloc(&data, uncompressed_len);
+    if (buf == NULL) {
+        return 0;
+    }
+    uLongf len = (uLongf)uncompressed_len;
+    if (uncompress(data, &len, in, (uLong)in_len) != Z_OK
+            || len != uncompressed_len) {
+        CRYPTO_BUFFER_free(buf);
+        return 0;
+    }
+    *out = buf;
+    cert_compression_record(ssl, CERT_COMPRESSION_ZLIB);
+    return 1;
+}
+
+static int brotli_decompress_cb(SSL *ssl, CRYPTO_BUFFER **out,
+                                size_t uncompressed_len,
+                                const uint8_t *in, size_t in_len) {
+    uint8_t *data;
+    CRYPTO_BUFFER *buf = CRYPTO_BUFFER_alloc(&data, uncompressed_len);
+    if (buf == NULL) {
+        return 0;
+    }
+    size_t len = uncompressed_len;
+    if (BrotliDecoderDecompress(in_len, in, &len, data)
+            != BROTLI_DECODER_RESULT_SUCCESS
+            || len != uncompressed_len) {
+        CRYPTO_BUFFER_free(buf);
+        return 0;
+    }
+    *out = buf;
+    cert_compression_record(ssl, CERT_COMPRESSION_BROTLI);
+    return 1;
+}
+
+/*
+ * Registers the algorithms in the bitmask (1 << (id - 1) for each RFC 8879
+ * algorithm id). Algorithms added first are preferred, so brotli, which
+ * compresses certificates better, goes first.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_ssl_1ctx_1enable_1cert_1compression(
+        JNIEnv *env, jclass cls, jlong ctx_ptr, jint algorithms) {
+    SSL_CTX *ctx = (SSL_CTX *)(intptr_t)ctx_ptr;
+    pthread_once(&cert_compression_once, cert_compression_init);
+    if (SSL_CTX_get_ex_data(ctx, cert_compression_ex_data_index) != NULL) {
+        return -1;
+    }
+    cert_compression_cache_t *cache =
+            (cert_compression_cache_t *)gumdrop_calloc(
+                    1, sizeof(cert_compression_cache_t));
+    if (cache == NULL) {
+        return -1;
+    }
+    pthread_mutex_init(&cache->lock, NULL);
+    SSL_CTX_set_ex_data(ctx, cert_compression_ex_data_index, cache);
+
+    if ((algorithms & (1 << (CERT_COMPRESSION_BROTLI - 1)))
+            && !SSL_CTX_add_cert_compression_alg(ctx,
+                    CERT_COMPRESSION_BROTLI, brotli_compress_cb,
+                    brotli_decompress_cb)) {
+        return -1;
+    }
+    if ((algorithms & (1 << (CERT_COMPRESSION_ZLIB - 1)))
+            && !SSL_CTX_add_cert_compression_alg(ctx,
+                    CERT_COMPRESSION_ZLIB, zlib_compress_cb,
+                    zlib_decompress_cb)) {
+        return -1;
+    }
+    return 0;
+}
+
+/* Returns the RFC 8879 algorithm the certificate used, or 0 for none */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_ssl_1get_1cert_1compression(
+        JNIEnv *env, jclass cls, jlong ssl_ptr) {
+    SSL *ssl = (SSL *)(intptr_t)ssl_ptr;
+    pthread_once(&cert_compression_once, cert_compression_init);
+    return (jint)(intptr_t)SSL_get_ex_data(ssl,
+            cert_compression_ssl_ex_data_index);
+}
+
+/* ── Asynchronous private key operations ──
+ *
+ * The server's CertificateVerify signature (RFC 8446 section 4.4.3) is
+ * otherwise computed inside quiche_conn_recv() on the SelectorLoop
+ * thread, where an RSA signature stalls every other connection on that
+ * loop. With this SSL_PRIVATE_KEY_METHOD the signature is queued to a
+ * pool of native worker threads and BoringSSL is told to retry; quiche
+ * treats SSL_ERROR_WANT_PRIVATE_KEY_OPERATION like WANT_READ. When the
+ * worker finishes it calls the SSL_CTX's Java listener with the SSL
+ * handle, which schedules quiche_conn_send() on the connection's loop;
+ * that re-enters the handshake and collects the signature through the
+ * complete callback.
+ *
+ * A job is shared by the SSL (via ex_data) and the worker, and freed by
+ * whichever lets go last, so a connection may be closed mid-operation.
+ *
+ * Each factory that uses the pool holds it from private_key_pool_start()
+ * to private_key_pool_stop(); the last to let go stops the workers,
+ * which finish the jobs already queued, and joins them. A handshake
+ * that needs a signature while no workers run signs inline.
+ */
+
+#define PK_PENDING 0
+#define PK_DONE 1
+#define PK_FAILED 2
+
+typedef struct pk_job {
+    struct pk_job *next;
+    int refs;                   /* guarded by pk_lock */
+    int state;                  /* guarded by pk_lock */
+    EVP_PKEY *pkey;
+    uint16_t sigalg;
+    uint8_t *in;
+    size_t in_len;
+    uint8_t *out;
+    size_t out_len;
+    jobject listener;           /* global ref, released by the worker */
+    jlong ssl;
+} pk_job_t;
+
+typedef struct {
+    EVP_PKEY *pkey;
+    jobject listener;           /* global ref */
+} async_key_t;
+
+static JavaVM *pk_vm;
+static jmethodID pk_complete_method;
+static pthread_mutex_t pk_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pk_cond = PTHREAD_COND_INITIALIZER;
+static pk_job_t *pk_head;
+static pk_job_t *pk_tail;
+#define PK_MAX_WORKERS 64
+static pthread_t pk_threads[PK_MAX_WORKERS];
+static int pk_workers;
+static int pk_users;            /* factories holding the pool */
+static int pk_stopping;
+static int async_key_ex_data_index = -1;
+static int pk_job_ex_data_index = -1;
+
+/* The SNI-selected host's key, if any (see SNI certificate selection) */
+static EVP_PKEY *sni_private_key(SSL *ssl);
+static int sni_enabled(SSL_CTX *ctx);
+
+/* Drops one reference. Caller holds pk_lock. */
+static void pk_job_release(pk_job_t *job) {
+    if (--job->refs > 0) {
+        return;
+    }
+    EVP_PKEY_free(job->pkey);
+    gumdrop_free(job->in);
+    if (job->out != NULL) {
+        OPENSSL_cleanse(job->out, job->out_len);
+        gumdrop_free(job->out);
+    }
+    gumdrop_free(job);
+}
+
+static void pk_job_ssl_free(void *parent, void *ptr, CRYPTO_EX_DATA *ad,
+                            int index, long argl, void *argp) {
+    pk_job_t *job = (pk_job_t *)ptr;
+    if (job != NULL) {
+        pthread_mutex_lock(&pk_lock);
+        pk_job_release(job);
+        pthread_mutex_unlock(&pk_lock);
+    }
+}
+
+static void async_key_free(void *parent, void *ptr, CRYPTO_EX_DATA *ad,
+                           int index, long argl, void *argp) {
+    async_key_t *key = (async_key_t *)ptr;
+    JNIEnv *env;
+    if (key == NULL) {
+        return;
+    }
+    EVP_PKEY_free(key->pkey);
+    if ((*pk_vm)->GetEnv(pk_vm, (void **)&env, JNI_VERSION_1_8) == JNI_OK) {
+        (*env)->DeleteGlobalRef(env, key->listener);
+    }
+    gumdrop_free(key);
+}
+
+static int pk_sign(pk_job_t *job) {
+    const EVP_MD *md = SSL_get_signature_algorithm_digest(job->sigalg);
+    EVP_MD_CTX *mctx = EVP_MD_CTX_new();
+    EVP_PKEY_CTX *pctx;
+    size_t len = EVP_PKEY_size(job->pkey);
+    job->out = (uint8_t *)gumdrop_malloc(len);
+    if (mctx == NULL || job->out == NULL) {
+        EVP_MD_CTX_free(mctx);
+        return 0;
+    }
+    int ok = EVP_DigestSignInit(mctx, &pctx, md, NULL, job->pkey)
+            && (!SSL_is_signature_algorithm_rsa_pss(job->sigalg)
+                || (EVP_PKEY_CTX_set_rsa_padding(pctx,
+                                                 RSA_PKCS1_PSS_PADDING)
+                    && EVP_PKEY_CTX_set_rsa_pss_saltlen(pctx, -1)))
+            && EVP_DigestSign(mctx, job->out, &len, job->in, job->in_len);
+    EVP_MD_CTX_free(mctx);
+    job->out_len = len;
+    return ok;
+}
+
+static void *pk_worker(void *arg) {
+    JNIEnv *env;
+    if ((*pk_vm)->AttachCurrentThreadAsDaemon(pk_vm, (void **)&env,
+                                              NULL) != JNI_OK) {
+        return NULL;
+    }
+    for (;;) {
+        pthread_mutex_lock(&pk_lock);
+        while (pk_head == NULL && !pk_stopping) {
+            pthread_cond_wait(&pk_cond, &pk_lock);
+        }
+        if (pk_head == NULL) {
+            pthread_mutex_unlock(&pk_lock);
+            break;
+        }
+        pk_job_t *job = pk_head;
+        pk_head = job->next;
+        if (pk_head == NULL) {
+            pk_tail = NULL;
+        }
+        pthread_mutex_unlock(&pk_lock);
+
+        int ok = pk_sign(job);
+
+        pthread_mutex_lock(&pk_lock);
+        job->state = ok ? PK_DONE : PK_FAILED;
+        pthread_mutex_unlock(&pk_lock);
+
+        (*env)->CallVoidMethod(env, job->listener, pk_complete_method,
+                               job->ssl);
+        if ((*env)->ExceptionCheck(env)) {
+            (*env)->ExceptionClear(env);
+        }
+        (*env)->DeleteGlobalRef(env, job->listener);
+
+        pthread_mutex_lock(&pk_lock);
+        pk_job_release(job);
+        pthread_mutex_unlock(&pk_lock);
+    }
+    (*pk_vm)->DetachCurrentThread(pk_vm);
+    return NULL;
+}
+
+static enum ssl_private_key_result_t async_key_sign(
+        SSL *ssl, uint8_t *out, size_t *out_len, size_t max_out,
+        uint16_t signature_algorithm, const uint8_t *in, size_t in_len) {
+    async_key_t *key = (async_key_t *)SSL_CTX_get_ex_data(
+            SSL_get_SSL_CTX(ssl), async_key_ex_data_index);
+    EVP_PKEY *pkey = sni_private_key(ssl);
+    JNIEnv *env;
+    if (key == NULL) {
+        return ssl_private_key_failure;
+    }
+    if (pkey == NULL) {
+        pkey = key->pkey;
+    }
+    if (pkey == NULL
+            || (*pk_vm)->GetEnv(pk_vm, (void **)&env,
+                                JNI_VERSION_1_8) != JNI_OK) {
+        return ssl_private_key_failure;
+    }
+    pk_job_t *job = (pk_job_t *)gumdrop_calloc(1, sizeof(pk_job_t));
+    uint8_t *copy = (uint8_t *)gumdrop_malloc(in_len);
+    if (job == NULL || copy == NULL) {
+        gumdrop_free(job);
+        gumdrop_free(copy);
+        return ssl_private_key_failure;
+    }
+    memcpy(copy, in, in_len);
+    job->in = copy;
+    job->in_len = in_len;
+    job->sigalg = signature_algorithm;
+    job->pkey = pkey;
+    EVP_PKEY_up_ref(pkey);
+    job->ssl = (jlong)(intptr_t)ssl;
+
+    pthread_mutex_lock(&pk_lock);
+    if (pk_workers == 0 || pk_stopping) {
+        /* The pool has been stopped: sign on this thread */
+        pthread_mutex_unlock(&pk_lock);
+        enum ssl_private_key_result_t result = ssl_private_key_failure;
+        if (pk_sign(job) && job->out_len <= max_out) {
+            memcpy(out, job->out, job->out_len);
+            *out_len = job->out_len;
+            result = ssl_private_key_success;
+        }
+        job->refs = 1;
+        pthread_mutex_lock(&pk_lock);
+        pk_job_release(job);
+        pthread_mutex_unlock(&pk_lock);
+        return result;
+    }
+    job->listener = (*env)->NewGlobalRef(env, key->listener);
+    job->refs = 2;              /* the SSL and the worker */
+    job->state = PK_PENDING;
+    SSL_set_ex_data(ssl, pk_job_ex_data_index, job);
+    if (pk_tail == NULL) {
+        pk_head = job;
+    } else {
+        pk_tail->next = job;
+    }
+    pk_tail = job;
+    pthread_cond_signal(&pk_cond);
+    pthread_mutex_unlock(&pk_lock);
+    return ssl_private_key_retry;
+}
+
+/* RSA key exchange does not exist in TLS 1.3 */
+static enum ssl_private_key_result_t async_key_decrypt(
+        SSL *ssl, uint8_t *out, size_t *out_len, size_t max_out,
+        const uint8_t *in, size_t in_len) {
+    return ssl_private_key_failure;
+}
+
+static enum ssl_private_key_result_t async_key_complete(
+        SSL *ssl, uint8_t *out, size_t *out_len, size_t max_out) {
+    pk_job_t *job = (pk_job_t *)SSL_get_ex_data(ssl, pk_job_ex_data_index);
+    if (job == NULL) {
+        return ssl_private_key_failure;
+    }
+    pthread_mutex_lock(&pk_lock);
+    int state = job->state;
+    pthread_mutex_unlock(&pk_lock);
+    if (state == PK_PENDING) {
+        return ssl_private_key_retry;
+    }
+
+    enum ssl_private_key_result_t result = ssl_private_key_failure;
+    if (state == PK_DONE && job->out_len <= max_out) {
+        memcpy(out, job->out, job->out_len);
+        *out_len = job->out_len;
+        result = ssl_private_key_success;
+    }
+    SSL_set_ex_data(ssl, pk_job_ex_data_index, NULL);
+    pthread_mutex_lock(&pk_lock);
+    pk_job_release(job);
+    pthread_mutex_unlock(&pk_lock);
+    return result;
+}
+
+static const SSL_PRIVATE_KEY_METHOD async_key_method = {
+    async_key_sign,
+    async_key_decrypt,
+    async_key_complete,
+};
+
+/*
+ * Takes a hold on the worker pool, growing it to the given number of
+ * threads if it is smaller. Returns the number of workers, or -1 if none
+ * could be started.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_private_1key_1pool_1start(
+        JNIEnv *env, jclass cls, jint threads) {
+    if (threads < 1) {
+        return -1;
+    }
+    if (threads > PK_MAX_WORKERS) {
+        threads = PK_MAX_WORKERS;
+    }
+    pthread_mutex_lock(&pk_lock);
+    if (pk_vm == NULL) {
+        jclass listener_cls = (*env)->FindClass(env,
+                "org/bluezoo/gumdrop/GumdropNative$PrivateKeyListener");
+        if (listener_cls == NULL
+                || (*env)->GetJavaVM(env, &pk_vm) != JNI_OK) {
+            pk_vm = NULL;
+            pthread_mutex_unlock(&pk_lock);
+            return -1;
+        }
+        pk_complete_method = (*env)->GetMethodID(env, listener_cls,
+                "privateKeyOperationComplete", "(J)V");
+        async_key_ex_data_index = SSL_CTX_get_ex_new_index(
+                0, NULL, NULL, NULL, async_key_free);
+        pk_job_ex_data_index = SSL_get_ex_new_index(
+                0, NULL, NULL, NULL, pk_job_ssl_free);
+    }
+    if (pk_stopping) {
+        /* Another factory is joining the workers */
+        pthread_mutex_unlock(&pk_lock);
+        return -1;
+    }
+    while (pk_workers < threads) {
+        if (pthread_create(&pk_threads[pk_workers], NULL, pk_worker,
+                           NULL) != 0) {
+            break;
+        }
+        pk_workers++;
+    }
+    int workers = pk_workers;
+    if (workers > 0) {
+        pk_users++;
+    }
+    pthread_mutex_unlock(&pk_lock);
+    return workers > 0 ? workers : -1;
+}
+
+/*
+ * Releases a hold taken by private_key_pool_start(). The last release
+ * stops the workers once the queue is empty and waits for them to exit.
+ */
+JNIEXPORT void JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_private_1key_1pool_1stop(
+        JNIEnv *env, jclass cls) {
+    pthread_mutex_lock(&pk_lock);
+    if (pk_users == 0 || --pk_users > 0) {
+        pthread_mutex_unlock(&pk_lock);
+        return;
+    }
+    int workers = pk_workers;
+    pk_stopping = 1;
+    pthread_cond_broadcast(&pk_cond);
+    pthread_mutex_unlock(&pk_lock);
+
+    int i;
+    for (i = 0; i < workers; i++) {
+        pthread_join(pk_threads[i], NULL);
+    }
+
+    pthread_mutex_lock(&pk_lock);
+    pk_workers = 0;
+    pk_stopping = 0;
+    pthread_mutex_unlock(&pk_lock);
+}
+
+/*
+ * Moves the SSL_CTX's loaded private key, and those of its SNI hosts,
+ * behind the asynchronous key method. The caller must hold the worker
+ * pool (private_key_pool_start). The listener's
+ * privateKeyOperationComplete(long) is called from a worker thread.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_ssl_1ctx_1enable_1async_1private_1key(
+        JNIEnv *env, jclass cls, jlong ctx_ptr, jobject listener) {
+    SSL_CTX *ctx = (SSL_CTX *)(intptr_t)ctx_ptr;
+    EVP_PKEY *pkey = SSL_CTX_get0_privatekey(ctx);
+    if (pkey == NULL && !sni_enabled(ctx)) {
+        return -1;
+    }
+    pthread_mutex_lock(&pk_lock);
+    int workers = pk_workers;
+    pthread_mutex_unlock(&pk_lock);
+    if (workers == 0
+            || SSL_CTX_get_ex_data(ctx, async_key_ex_data_index) != NULL) {
+        return -1;
+    }
+
+    async_key_t *key = (async_key_t *)gumdrop_malloc(sizeof(async_key_t));
+    if (key == NULL) {
+        return -1;
+    }
+    if (pkey != NULL) {
+        EVP_PKEY_up_ref(pkey);
+    }
+    key->pkey = pkey;
+    key->listener = (*env)->NewGlobalRef(env, listener);
+    SSL_CTX_set_ex_data(ctx, async_key_ex_data_index, key);
+    SSL_CTX_set_private_key_method(ctx, &async_key_method);
+    return 0;
+}
+
+/* ── SNI certificate selection (RFC 6066 section 3) ──
+ *
+ * One listener can serve many names. A certificate callback looks up
+ * the client's server_name in a per-SSL_CTX hash table and installs that
+ * host's chain and key on the SSL alone; ALPN, ticket keys, compression
+ * and everything else stay on the shared SSL_CTX. A directory may also
+ * hold <name>.pem and <name>-key.pem (the layout mkcert writes, with
+ * "_wildcard.example.com" for "*.example.com"). Exact names take
+ * precedence over wildcards; a name with no certificate gets the
+ * SSL_CTX's own.
+ *
+ * Registered hosts and the directory's certificates are loaded when
+ * they are registered, which happens off the SelectorLoop, so the
+ * certificate callback normally only looks in the table. A name that
+ * is not there is looked for in the directory, so that tenants added
+ * since are found without reconfiguring the listener. A miss is
+ * remembered for SNI_MISSING_TTL seconds. At most SNI_MISSING_MAX misses
+ * are remembered; beyond that, unknown names get the default
+ * certificate without touching the disk until some expire.
+ *
+ * Loaded chains are kept as CRYPTO_BUFFERs, so selecting one costs no
+ * parsing, and each host has its own certificate compression cache.
+ * Loaded entries live as long as the SSL_CTX, which every SSL
+ * references; entries for misses are never handed to an SSL and may be
+ * freed at any time under the table lock.
+ */
+
+#define SNI_LOADED 1
+#define SNI_MISSING 2
+#define SNI_MAX_NAME 253            /* RFC 1035 section 2.3.4 */
+#define SNI_INITIAL_BUCKETS 64
+#define SNI_MISSING_TTL 60          /* seconds */
+#define SNI_MISSING_MAX 1024
+
+typedef struct sni_host {
+    struct sni_host *next;
+    char *name;                 /* lower case; "*.example.com" */
+    char *cert_path;            /* NULL for a miss */
+    char *key_path;             /* NULL: the key is in cert_path */
+    int state;                  /* immutable once in the table */
+    time_t expires;             /* a miss: when to look again */
+    CRYPTO_BUFFER **chain;      /* immutable once loaded */
+    size_t chain_len;
+    EVP_PKEY *pkey;
+    cert_compression_cache_t compression;
+} sni_host_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    sni_host_t **buckets;
+    size_t bucket_count;        /* power of two */
+    size_t count;
+    size_t missing;             /* entries for misses */
+    char *dir;
+} sni_table_t;
+
+static int sni_ex_data_index = -1;
+static int sni_ssl_ex_data_index = -1;
+static pthread_mutex_t sni_init_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Selects the certificate, then its OCSP response (see OCSP stapling) */
+static int cert_cb(SSL *ssl, void *arg);
+
+/* FNV-1a */
+static size_t sni_hash(const char *name) {
+    uint32_t h = 2166136261u;
+    for (; *name != '\0'; name++) {
+        h ^= (uint8_t)*name;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void sni_chain_free(CRYPTO_BUFFER **chain, size_t chain_len) {
+    size_t i;
+    for (i = 0; i < chain_len; i++) {
+        CRYPTO_BUFFER_free(chain[i]);
+    }
+    gumdrop_free(chain);
+}
+
+static void sni_host_free(sni_host_t *h) {
+    sni_chain_free(h->chain, h->chain_len);
+    EVP_PKEY_free(h->pkey);
+    cert_compression_entry_clear(&h->compression.zlib);
+    cert_compression_entry_clear(&h->compression.brotli);
+    pthread_mutex_destroy(&h->compression.lock);
+    gumdrop_free(h->name);
+    gumdrop_free(h->cert_path);
+    gumdrop_free(h->key_path);
+    gumdrop_free(h);
+}
+
+static sni_host_t *sni_host_new(const char *name, const char *cert_path,
+                                const char *key_path) {
+    sni_host_t *h = (sni_host_t *)gumdrop_calloc(1, sizeof(sni_host_t));
+    if (h == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&h->compression.lock, NULL);
+    h->name = gumdrop_strdup(name);
+    h->cert_path = cert_path != NULL ? gumdrop_strdup(cert_path) : NULL;
+    h->key_path = key_path != NULL ? gumdrop_strdup(key_path) : NULL;
+    if (h->name == NULL || (cert_path != NULL && h->cert_path == NULL)
+            || (key_path != NULL && h->key_path == NULL)) {
+        sni_host_free(h);
+        return NULL;
+    }
+    return h;
+}
+
+static void sni_table_free(void *parent, void *ptr, CRYPTO_EX_DATA *ad,
+                           int index, long argl, void *argp) {
+    sni_table_t *t = (sni_table_t *)ptr;
+    size_t i;
+    if (t == NULL) {
+        return;
+    }
+    for (i = 0; i < t->bucket_count; i++) {
+        sni_host_t *h = t->buckets[i];
+        while (h != NULL) {
+            sni_host_t *next = h->next;
+            sni_host_free(h);
+            h = next;
+        }
+    }
+    gumdrop_free(t->buckets);
+    gumdrop_free(t->dir);
+    pthread_mutex_destroy(&t->lock);
+    gumdrop_free(t);
+}
+
+/* Caller holds the table lock. */
+static sni_host_t *sni_find(sni_table_t *t, const char *name) {
+    sni_host_t *h = t->buckets[sni_hash(name) & (t->bucket_count - 1)];
+    while (h != NULL && strcmp(h->name, name) != 0) {
+        h = h->next;
+    }
+    return h;
+}
+
+/* Caller holds the table lock. Doubles the table at load factor 1. */
+static void sni_insert(sni_table_t *t, sni_host_t *h) {
+    size_t i;
+    if (t->count >= t->bucket_count) {
+        size_t count = t->bucket_count * 2;
+        sni_host_t **buckets = (sni_host_t **)gumdrop_calloc(
+                count, sizeof(sni_host_t *));
+        if (buckets != NULL) {
+            for (i = 0; i < t->bucket_count; i++) {
+                sni_host_t *e = t->buckets[i];
+                while (e != NULL) {
+                    sni_host_t *next = e->next;
+                    size_t b = sni_hash(e->name) & (count - 1);
+                    e->next = buckets[b];
+                    buckets[b] = e;
+                    e = next;
+                }
+            }
+            gumdrop_free(t->buckets);
+            t->buckets = buckets;
+            t->bucket_count = count;
+        }
+    }
+    i = sni_hash(h->name) & (t->bucket_count - 1);
+    h->next = t->buckets[i];
+    t->buckets[i] = h;
+    t->count++;
+    if (h->state == SNI_MISSING) {
+        t->missing++;
+    }
+}
+
+/* Caller holds the table lock. Only misses are ever removed. */
+static void sni_remove_missing(sni_table_t *t, sni_host_t *h) {
+    sni_host_t **p = &t->buckets[sni_hash(h->name) & (t->bucket_count - 1)];
+    while (*p != h) {
+        p = &(*p)->next;
+    }
+    *p = h->next;
+    t->count--;
+    t->missing--;
+    sni_host_free(h);
+}
+
+/* Caller holds the table lock. Forgets misses that have expired. */
+static void sni_expire_missing(sni_table_t *t, time_t now) {
+    size_t i;
+    for (i = 0; i < t->bucket_count && t->missing > 0; i++) {
+        sni_host_t *h = t->buckets[i];
+        while (h != NULL) {
+            sni_host_t *next = h->next;
+            if (h->state == SNI_MISSING && h->expires <= now) {
+                sni_remove_missing(t, h);
+            }
+            h = next;
+        }
+    }
+}
+
+static time_t sni_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+/*
+ * Reads a PEM certificate chain and private key. The key is read from
+ * key_path if given, otherwise from the certificate file. Returns 1 on
+ * success.
+ */
+static int sni_load_files(const char *cert_path, const char *key_path,
+                          CRYPTO_BUFFER ***chain_out, size_t *chain_len_out,
+                          EVP_PKEY **pkey_out) {
+    CRYPTO_BUFFER **chain = NULL;
+    size_t chain_len = 0;
+    EVP_PKEY *pkey = NULL;
+    X509 *x509;
+    BIO *bio = BIO_new_file(cert_path, "r");
+    if (bio == NULL) {
+        ERR_clear_error();
+        return 0;
+    }
+    while ((x509 = PEM_read_bio_X509(bio, NULL, NULL, NULL)) != NULL) {
+        uint8_t *der = NULL;
+        int der_len = i2d_X509(x509, &der);
+        X509_free(x509);
+        CRYPTO_BUFFER **grown = (CRYPTO_BUFFER **)gumdrop_realloc(chain,
+                (chain_len + 1) * sizeof(CRYPTO_BUFFER *));
+        CRYPTO_BUFFER *buf = der_len > 0
+                ? CRYPTO_BUFFER_new(der, (size_t)der_len, NULL) : NULL;
+        OPENSSL_free(der);
+        if (grown == NULL || buf == NULL) {
+            gumdrop_free(grown != NULL ? grown : chain);
+            CRYPTO_BUFFER_free(buf);
+            BIO_free(bio);
+            ERR_clear_error();
+            return 0;
+        }
+        chain = grown;
+        chain[chain_len++] = buf;
+    }
+    if (key_path != NULL) {
+        BIO_free(bio);
+        bio = BIO_new_file(key_path, "r");
+    } else {
+        BIO_reset(bio);
+    }
+    if (bio != NULL) {
+        pkey = PEM_read_bio_PrivateKey(bio, NULL, NULL, NULL);
+        BIO_free(bio);
+    }
+    ERR_clear_error();
+    if (chain_len == 0 || pkey == NULL) {
+        sni_chain_free(chain, chain_len);
+        EVP_PKEY_free(pkey);
+        return 0;
+    }
+    *chain_out = chain;
+    *chain_len_out = chain_len;
+    *pkey_out = pkey;
+    return 1;
+}
+
+/*
+ * Normalises a server name to lower case without a trailing dot. Only
+ * letters, digits, hyphens and non-empty labels are accepted, since the
+ * name may become part of a file path. Returns 1 if the name is valid.
+ */
+static int sni_normalize(const char *in, char *out, int allow_wildcard) {
+    size_t len = strlen(in);
+    size_t i;
+    int label = 0;
+    if (len > 0 && in[len - 1] == '.') {
+        len--;
+    }
+    if (len == 0 || len > SNI_MAX_NAME) {
+        return 0;
+    }
+    i = 0;
+    if (allow_wildcard && len > 2 && in[0] == '*' && in[1] == '.') {
+        out[0] = '*';
+        out[1] = '.';
+        i = 2;
+    }
+    for (; i < len; i++) {
+        char c = in[i];
+        if (c >= 'A' && c <= 'Z') {
+            c = (char)(c - 'A' + 'a');
+        }
+        if (c == '.') {
+            if (label == 0) {
+                return 0;
+            }
+            label = 0;
+        } else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')
+                   || c == '-') {
+            label++;
+        } else {
+            return 0;
+        }
+        out[i] = c;
+    }
+    out[len] = '\0';
+    return label > 0;
+}
+
+/*
+ * Loads a host's chain and key. Returns the new entry, not yet in any
+ * table, or NULL if the files cannot be read.
+ */
+static sni_host_t *sni_load_host(const char *name, const char *cert_path,
+                                 const char *key_path) {
+    CRYPTO_BUFFER **chain;
+    size_t chain_len;
+    EVP_PKEY *pkey;
+    if (!sni_load_files(cert_path, key_path, &chain, &chain_len, &pkey)) {
+        return NULL;
+    }
+    sni_host_t *h = sni_host_new(name, cert_path, key_path);
+    if (h == NULL) {
+        sni_chain_free(chain, chain_len);
+        EVP_PKEY_free(pkey);
+        return NULL;
+    }
+    h->chain = chain;
+    h->chain_len = chain_len;
+    h->pkey = pkey;
+    h->state = SNI_LOADED;
+    return h;
+}
+
+/* Loads <dir>/<file_name>.pem, with <dir>/<file_name>-key.pem if present */
+static sni_host_t *sni_load_dir_host(const char *dir, const char *name,
+                                     const char *file_name) {
+    size_t len = strlen(dir) + strlen(file_name) + sizeof("/-key.pem");
+    char *cert_path = (char *)gumdrop_malloc(len);
+    char *key_path = (char *)gumdrop_malloc(len);
+    sni_host_t *h = NULL;
+    if (cert_path != NULL && key_path != NULL) {
+        snprintf(cert_path, len, "%s/%s.pem", dir, file_name);
+        snprintf(key_path, len, "%s/%s-key.pem", dir, file_name);
+        FILE *key_file = fopen(key_path, "r");
+        if (key_file != NULL) {
+            fclose(key_file);
+        }
+        h = sni_load_host(name, cert_path,
+                          key_file != NULL ? key_path : NULL);
+    }
+    gumdrop_free(cert_path);
+    gumdrop_free(key_path);
+    return h;
+}
+
+/*
+ * Returns the loaded entry for one candidate name ("host" or
+ * "*.parent"), or NULL if there is none. A name not in the table is
+ * looked for in the directory unless a recent lookup missed. Files are
+ * read without the table lock held.
+ */
+static sni_host_t *sni_resolve(sni_table_t *t, const char *name,
+                               const char *file_name) {
+    pthread_mutex_lock(&t->lock);
+    sni_host_t *h = sni_find(t, name);
+    if (h != NULL && h->state == SNI_LOADED) {
+        pthread_mutex_unlock(&t->lock);
+        return h;
+    }
+    time_t now = sni_now();
+    if (t->dir == NULL || (h != NULL && now < h->expires)) {
+        pthread_mutex_unlock(&t->lock);
+        return NULL;
+    }
+    if (h == NULL && t->missing >= SNI_MISSING_MAX) {
+        sni_expire_missing(t, now);
+        if (t->missing >= SNI_MISSING_MAX) {
+            pthread_mutex_unlock(&t->lock);
+            return NULL;
+        }
+    }
+    char *dir = gumdrop_strdup(t->dir);
+    pthread_mutex_unlock(&t->lock);
+
+    sni_host_t *loaded = dir != NULL
+            ? sni_load_dir_host(dir, name, file_name) : NULL;
+    gumdrop_free(dir);
+
+    pthread_mutex_lock(&t->lock);
+    h = sni_find(t, name);
+    if (h != NULL && h->state == SNI_LOADED) {
+        /* another thread loaded it first */
+    } else if (loaded != NULL) {
+        if (h != NULL) {
+            sni_remove_missing(t, h);
+        }
+        sni_insert(t, loaded);
+        h = loaded;
+        loaded = NULL;
+    } else if (h != NULL) {
+        h->expires = now + SNI_MISSING_TTL;
+    } else if (t->missing < SNI_MISSING_MAX) {
+        sni_host_t *miss = sni_host_new(name, NULL, NULL);
+        if (miss != NULL) {
+            miss->state = SNI_MISSING;
+            miss->expires = now + SNI_MISSING_TTL;
+            sni_insert(t, miss);
+        }
+    }
+    if (h != NULL && h->state != SNI_LOADED) {
+        h = NULL;
+    }
+    pthread_mutex_unlock(&t->lock);
+    if (loaded != NULL) {
+        sni_host_free(loaded);
+    }
+    return h;
+}
+
+/*
+ * Installs the certificate for the client's server name, if one is
+ * configured. Returns 0 on error.
+ */
+static int sni_select(SSL *ssl) {
+    SSL_CTX *ctx = SSL_get_SSL_CTX(ssl);
+    sni_table_t *t;
+    const char *server_name = SSL_get_servername(ssl,
+            TLSEXT_NAMETYPE_host_name);
+    char name[SNI_MAX_NAME + 1];
+    char candidate[SNI_MAX_NAME + sizeof("_wildcard")];
+    if (sni_ex_data_index < 0) {
+        return 1;
+    }
+    t = (sni_table_t *)SSL_CTX_get_ex_data(ctx, sni_ex_data_index);
+    if (t == NULL || server_name == NULL
+            || !sni_normalize(server_name, name, 0)) {
+        return 1;
+    }
+
+    sni_host_t *h = sni_resolve(t, name, name);
+    const char *parent = strchr(name, '.');
+    if (h == NULL && parent != NULL) {
+        char file_name[SNI_MAX_NAME + sizeof("_wildcard")];
+        snprintf(candidate, sizeof(candidate), "*%s", parent);
+        snprintf(file_name, sizeof(file_name), "_wildcard%s", parent);
+        h = sni_resolve(t, candidate, file_name);
+    }
+    if (h == NULL) {
+        return 1;
+    }
+
+    int async = async_key_ex_data_index >= 0
+            && SSL_CTX_get_ex_data(ctx, async_key_ex_data_index) != NULL;
+    if (!SSL_set_chain_and_key(ssl, h->chain, h->chain_len,
+                               async ? NULL : h->pkey,
+                               async ? &async_key_method : NULL)) {
+        return 0;
+    }
+    SSL_set_ex_data(ssl, sni_ssl_ex_data_index, h);
+    return 1;
+}
+
+static sni_host_t *sni_selected(SSL *ssl) {
+    if (sni_ssl_ex_data_index < 0) {
+        return NULL;
+    }
+    return (sni_host_t *)SSL_get_ex_data(ssl, sni_ssl_ex_data_index);
+}
+
+static cert_compression_cache_t *sni_compression_cache(SSL *ssl) {
+    sni_host_t *h = sni_selected(ssl);
+    return h != NULL ? &h->compression : NULL;
+}
+
+static EVP_PKEY *sni_private_key(SSL *ssl) {
+    sni_host_t *h = sni_selected(ssl);
+    return h != NULL ? h->pkey : NULL;
+}
+
+static int sni_enabled(SSL_CTX *ctx) {
+    return sni_ex_data_index >= 0
+            && SSL_CTX_get_ex_data(ctx, sni_ex_data_index) != NULL;
+}
+
+/* Returns the SSL_CTX's table, creating it and the callback if needed */
+static sni_table_t *sni_table(SSL_CTX *ctx) {
+    pthread_mutex_lock(&sni_init_lock);
+    if (sni_ex_data_index < 0) {
+        sni_ex_data_index = SSL_CTX_get_ex_new_index(
+                0, NULL, NULL, NULL, sni_table_free);
+        sni_ssl_ex_data_index = SSL_get_ex_new_index(
+                0, NULL, NULL, NULL, NULL);
+    }
+    pthread_mutex_unlock(&sni_init_lock);
+    sni_table_t *t = (sni_table_t *)SSL_CTX_get_ex_data(ctx,
+            sni_ex_data_index);
+    if (t != NULL) {
+        return t;
+    }
+    t = (sni_table_t *)gumdrop_calloc(1, sizeof(sni_table_t));
+    if (t == NULL) {
+        return NULL;
+    }
+    t->buckets = (sni_host_t **)gumdrop_calloc(SNI_INITIAL_BUCKETS,
+                                               sizeof(sni_host_t *));
+    if (t->buckets == NULL) {
+        gumdrop_free(t);
+        return NULL;
+    }
+    t->bucket_count = SNI_INITIAL_BUCKETS;
+    pthread_mutex_init(&t->lock, NULL);
+    SSL_CTX_set_ex_data(ctx, sni_ex_data_index, t);
+    SSL_CTX_set_cert_cb(ctx, cert_cb, NULL);
+    return t;
+}
+
+/*
+ * Registers the certificate for a server name, or "*.parent" for every
+ * name directly under parent, and loads it. key_path may be null if the
+ * certificate file also holds the key. Returns -1 if the name is invalid
+ * or already registered, -2 if the files cannot be read.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_ssl_1ctx_1add_1sni_1host(
+        JNIEnv *env, jclass cls, jlong ctx_ptr, jstring name,
+        jstring cert_path, jstring key_path) {
+    SSL_CTX *ctx = (SSL_CTX *)(intptr_t)ctx_ptr;
+    sni_table_t *t = sni_table(ctx);
+    char normalized[SNI_MAX_NAME + 1];
+    if (t == NULL) {
+        return -1;
+    }
+    const char *c_name = (*env)->GetStringUTFChars(env, name, NULL);
+    int valid = sni_normalize(c_name, normalized, 1);
+    (*env)->ReleaseStringUTFChars(env, name, c_name);
+    if (!valid) {
+        return -1;
+    }
+
+    const char *c_cert = (*env)->GetStringUTFChars(env, cert_path, NULL);
+    const char *c_key = key_path != NULL
+            ? (*env)->GetStringUTFChars(env, key_path, NULL) : NULL;
+    sni_host_t *h = sni_load_host(normalized, c_cert, c_key);
+    (*env)->ReleaseStringUTFChars(env, cert_path, c_cert);
+    if (c_key != NULL) {
+        (*env)->ReleaseStringUTFChars(env, key_path, c_key);
+    }
+    if (h == NULL) {
+        return -2;
+    }
+    pthread_mutex_lock(&t->lock);
+    int exists = sni_find(t, normalized) != NULL;
+    if (!exists) {
+        sni_insert(t, h);
+    }
+    pthread_mutex_unlock(&t->lock);
+    if (exists) {
+        sni_host_free(h);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Sets a directory of certificates for names that were not registered:
+ * <name>.pem holds the chain, and the key if <name>-key.pem does not
+ * exist. Every certificate already in the directory is loaded now;
+ * files that cannot be read are skipped.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_ssl_1ctx_1set_1sni_1directory(
+        JNIEnv *env, jclass cls, jlong ctx_ptr, jstring dir) {
+    SSL_CTX *ctx = (SSL_CTX *)(intptr_t)ctx_ptr;
+    sni_table_t *t = sni_table(ctx);
+    if (t == NULL) {
+        return -1;
+    }
+    const char *c_dir = (*env)->GetStringUTFChars(env, dir, NULL);
+    char *copy = gumdrop_strdup(c_dir);
+    (*env)->ReleaseStringUTFChars(env, dir, c_dir);
+    if (copy == NULL) {
+        return -1;
+    }
+    DIR *d = opendir(copy);
+    if (d == NULL) {
+        gumdrop_free(copy);
+        return -1;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        char file_name[SNI_MAX_NAME + sizeof("_wildcard")];
+        char name[SNI_MAX_NAME + 1];
+        size_t len = strlen(entry->d_name);
+        if (len <= 4 || len - 4 >= sizeof(file_name)
+                || strcmp(entry->d_name + len - 4, ".pem") != 0
+                || (len > 8
+                    && strcmp(entry->d_name + len - 8, "-key.pem") == 0)) {
+            continue;
+        }
+        memcpy(file_name, entry->d_name, len - 4);
+        file_name[len - 4] = '\0';
+        int valid;
+        if (strncmp(file_name, "_wildcard.", 10) == 0) {
+            char wildcard[SNI_MAX_NAME + sizeof("_wildcard")];
+            snprintf(wildcard, sizeof(wildcard), "*%s", file_name + 9);
+            valid = sni_normalize(wildcard, name, 1);
+        } else {
+            valid = sni_normalize(file_name, name, 0);
+        }
+        if (!valid) {
+            continue;
+        }
+        pthread_mutex_lock(&t->lock);
+        int exists = sni_find(t, name) != NULL;
+        pthread_mutex_unlock(&t->lock);
+        if (exists) {
+            continue;           /* registered names take precedence */
+        }
+        sni_host_t *h = sni_load_dir_host(copy, name, file_name);
+        if (h == NULL) {
+            continue;
+        }
+        pthread_mutex_lock(&t->lock);
+        exists = sni_find(t, name) != NULL;
+        if (!exists) {
+            sni_insert(t, h);
+        }
+        pthread_mutex_unlock(&t->lock);
+        if (exists) {
+            sni_host_free(h);
+        }
+    }
+    closedir(d);
+    pthread_mutex_lock(&t->lock);
+    gumdrop_free(t->dir);
+    t->dir = copy;
+    pthread_mutex_unlock(&t->lock);
+    return 0;
+}
+
+/* ── OCSP stapling (RFC 6066 section 8) ──
+ *
+ * Clients that check revocation would otherwise make their own OCSP
+ * request before trusting the handshake. The response for the SSL_CTX's
+ * own certificate is fetched and refreshed in Java and held here; the
+ * certificate callback attaches it with SSL_set_ocsp_response to each
+ * connection that presents that certificate. Unlike
+ * SSL_CTX_set_ocsp_response this never staples it next to an SNI host's
+ * certificate, and lets an expired response be withdrawn. BoringSSL only
+ * sends it to clients that asked with status_request.
+ *
+ * The slot and the certificate callback are installed while the SSL_CTX
+ * is built, before any thread can handshake on it; afterwards only the
+ * response is swapped, under the slot's lock.
+ */
+
+typedef struct {
+    pthread_mutex_t lock;
+    CRYPTO_BUFFER *response;    /* NULL: nothing to staple */
+} ocsp_staple_t;
+
+static int ocsp_ex_data_index = -1;
+static pthread_once_t ocsp_once = PTHREAD_ONCE_INIT;
+
+static void ocsp_staple_free(void *parent, void *ptr, CRYPTO_EX_DATA *ad,
+                             int index, long argl, void *argp) {
+    ocsp_staple_t *staple = (ocsp_staple_t *)ptr;
+    if (staple == NULL) {
+        return;
+    }
+    CRYPTO_BUFFER_free(staple->response);
+    pthread_mutex_destroy(&staple->lock);
+    gumdrop_free(staple);
+}
+
+static void ocsp_init(void) {
+    ocsp_ex_data_index = SSL_CTX_get_ex_new_index(
+            0, NULL, NULL, NULL, ocsp_staple_free);
+}
+
+static int ocsp_staple(SSL *ssl) {
+    ocsp_staple_t *staple;
+    CRYPTO_BUFFER *response = NULL;
+    if (ocsp_ex_data_index < 0) {
+        return 1;
+    }
+    staple = (ocsp_staple_t *)SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl),
+                                                  ocsp_ex_data_index);
+    if (staple == NULL) {
+        return 1;
+    }
+    pthread_mutex_lock(&staple->lock);
+    if (staple->response != NULL) {
+        response = staple->response;
+        CRYPTO_BUFFER_up_ref(response);
+    }
+    pthread_mutex_unlock(&staple->lock);
+    if (response == NULL) {
+        return 1;
+    }
+    int ok = SSL_set_ocsp_response(ssl, CRYPTO_BUFFER_data(response),
+                                   CRYPTO_BUFFER_len(response));
+    CRYPTO_BUFFER_free(response);
+    return ok;
+}
+
+static int cert_cb(SSL *ssl, void *arg) {
+    if (!sni_select(ssl)) {
+        return 0;
+    }
+    if (sni_selected(ssl) != NULL) {
+        return 1;
+    }
+    return ocsp_staple(ssl);
+}
+
+/*
+ * Prepares a server SSL_CTX, not yet in use, to staple OCSP responses.
+ * Nothing is stapled until a response is set.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_ssl_1ctx_1enable_1ocsp_1stapling(
+        JNIEnv *env, jclass cls, jlong ctx_ptr) {
+    SSL_CTX *ctx = (SSL_CTX *)(intptr_t)ctx_ptr;
+
+    pthread_once(&ocsp_once, ocsp_init);
+    if (ocsp_ex_data_index < 0) {
+        return -1;
+    }
+    if (SSL_CTX_get_ex_data(ctx, ocsp_ex_data_index) != NULL) {
+        return 0;
+    }
+    ocsp_staple_t *staple =
+            (ocsp_staple_t *)gumdrop_calloc(1, sizeof(ocsp_staple_t));
+    if (staple == NULL) {
+        return -1;
+    }
+    pthread_mutex_init(&staple->lock, NULL);
+    if (!SSL_CTX_set_ex_data(ctx, ocsp_ex_data_index, staple)) {
+        pthread_mutex_destroy(&staple->lock);
+        gumdrop_free(staple);
+        return -1;
+    }
+    SSL_CTX_set_cert_cb(ctx, cert_cb, NULL);
+    return 0;
+}
+
+/*
+ * Sets the DER OCSPResponse (RFC 6960 section 4.2.1) stapled with the
+ * SSL_CTX's certificate, or withdraws it if response is null. Stapling
+ * must have been enabled when the SSL_CTX was built.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_ssl_1ctx_1set_1ocsp_1response(
+        JNIEnv *env, jclass cls, jlong ctx_ptr, jbyteArray response) {
+    SSL_CTX *ctx = (SSL_CTX *)(intptr_t)ctx_ptr;
+    CRYPTO_BUFFER *buf = NULL;
+
+    if (ocsp_ex_data_index < 0) {
+        return -1;
+    }
+    ocsp_staple_t *staple = (ocsp_staple_t *)SSL_CTX_get_ex_data(ctx,
+            ocsp_ex_data_index);
+    if (staple == NULL) {
+        return -1;
+    }
+
+    if (response != NULL) {
+        jsize len = (*env)->GetArrayLength(env, response);
+        jbyte *der = (*env)->GetByteArrayElements(env, response, NULL);
+        if (der == NULL) {
+            return -1;
+        }
+        buf = CRYPTO_BUFFER_new((const uint8_t *)der, (size_t)len, NULL);
+        (*env)->ReleaseByteArrayElements(env, response, der, JNI_ABORT);
+        if (buf == NULL) {
+            return -1;
+        }
+    }
+    pthread_mutex_lock(&staple->lock);
+    CRYPTO_BUFFER *old = staple->response;
+    staple->response = buf;
+    pthread_mutex_unlock(&staple->lock);
+    CRYPTO_BUFFER_free(old);
+    return 0;
+}
+
+/* ── TLS over TCP (memory BIOs) ──
+ *
+ * An alternative to JSSE's SSLEngine for TCP listeners. Each connection
+ * is an SSL with a memory BIO on either side: ciphertext read from the
+ * socket into the endpoint's direct netIn buffer is fed into the read
+ * BIO, SSL_read decrypts straight into a direct application buffer, and
+ * SSL_write leaves records in the write BIO, which is drained into the
+ * direct netOut buffer for the selector to write. Every call works on a
+ * buffer address, so there is no copy through the Java heap and no
+ * per-record object allocation.
+ *
+ * The SSL_CTX is shared by all connections of a listener. Unlike the
+ * QUIC contexts it allows TLS 1.2, and its certificate and trust
+ * anchors come from the listener's keystore as DER.
+ *
+ * The result codes below are mirrored in GumdropNative. An SSL is not
+ * safe for concurrent use, so Java serialises every call on one
+ * connection.
+ */
+
+#define TLS_WANT_READ  -1   /* needs more ciphertext from the peer */
+#define TLS_CLOSED     -2   /* close_notify received */
+#define TLS_ERROR      -3   /* fatal alert or protocol error */
+
+static int tls_status(SSL *ssl, int ret) {
+    switch (SSL_get_error(ssl, ret)) {
+    case SSL_ERROR_WANT_READ:
+    case SSL_ERROR_WANT_WRITE:
+        return TLS_WANT_READ;
+    case SSL_ERROR_ZERO_RETURN:
+        return TLS_CLOSED;
+    default:
+        ERR_clear_error();
+        return TLS_ERROR;
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_ssl_1ctx_1set_1proto_1versions(
+        JNIEnv *env, jclass cls, jlong ctx_ptr, jint min, jint max) {
+    SSL_CTX *ctx = (SSL_CTX *)(intptr_t)ctx_ptr;
+    if (!SSL_CTX_set_min_proto_version(ctx, (uint16_t)min)
+            || !SSL_CTX_set_max_proto_version(ctx, (uint16_t)max)) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Installs a PKCS#8 private key and its DER certificate chain, leaf
+ * first, as the SSL_CTX's credentials.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_ssl_1ctx_1use_1key_1and_1chain(
+        JNIEnv *env, jclass cls, jlong ctx_ptr, jbyteArray key,
+        jobjectArray chain) {
+    SSL_CTX *ctx = (SSL_CTX *)(intptr_t)ctx_ptr;
+    jsize n = (*env)->GetArrayLength(env, chain);
+    if (n <= 0) {
+        return -1;
+    }
+
+    jsize key_len = (*env)->GetArrayLength(env, key);
+    jbyte *key_der = (*env)->GetByteArrayElements(env, key, NULL);
+    if (key_der == NULL) {
+        return -1;
+    }
+    CBS cbs;
+    CBS_init(&cbs, (const uint8_t *)key_der, (size_t)key_len);
+    EVP_PKEY *pkey = EVP_parse_private_key(&cbs);
+    (*env)->ReleaseByteArrayElements(env, key, key_der, JNI_ABORT);
+    if (pkey == NULL) {
+        ERR_clear_error();
+        return -1;
+    }
+
+    CRYPTO_BUFFER **certs =
+            (CRYPTO_BUFFER **)gumdrop_calloc((size_t)n,
+                                             sizeof(CRYPTO_BUFFER *));
+    int ret = -1;
+    jsize i;
+    if (certs == NULL) {
+        EVP_PKEY_free(pkey);
+        return -1;
+    }
+    for (i = 0; i < n; i++) {
+        jbyteArray cert = (jbyteArray)
+                (*env)->GetObjectArrayElement(env, chain, i);
+        jsize len = (*env)->GetArrayLength(env, cert);
+        jbyte *der = (*env)->GetByteArrayElements(env, cert, NULL);
+        if (der == NULL) {
+            goto done;
+        }
+        certs[i] = CRYPTO_BUFFER_new((const uint8_t *)der, (size_t)len,
+                                     NULL);
+        (*env)->ReleaseByteArrayElements(env, cert, der, JNI_ABORT);
+        (*env)->DeleteLocalRef(env, cert);
+        if (certs[i] == NULL) {
+            goto done;
+        }
+    }
+    if (SSL_CTX_set_chain_and_key(ctx, certs, (size_t)n, pkey, NULL)) {
+        ret = 0;
+    } else {
+        ERR_clear_error();
+    }
+
+done:
+    for (i = 0; i < n; i++) {
+        CRYPTO_BUFFER_free(certs[i]);
+    }
+    gumdrop_free(certs);
+    EVP_PKEY_free(pkey);
+    return ret;
+}
+
+/*
+ * Requests a client certificate that chains to one of the given DER
+ * trust anchors (RFC 8446 section 4.3.2). Unless require is set, a
+ * client that sends none is still accepted; one that sends a
+ * certificate that does not verify is not.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_ssl_1ctx_1set_1client_1auth(
+        JNIEnv *env, jclass cls, jlong ctx_ptr, jobjectArray anchors,
+        jboolean require) {
+    SSL_CTX *ctx = (SSL_CTX *)(intptr_t)ctx_ptr;
+    X509_STORE *store = SSL_CTX_get_cert_store(ctx);
+    jsize n = (*env)->GetArrayLength(env, anchors);
+    jsize i;
+
+    for (i = 0; i < n; i++) {
+        jbyteArray cert = (jbyteArray)
+                (*env)->GetObjectArrayElement(env, anchors, i);
+        jsize len = (*env)->GetArrayLength(env, cert);
+        jbyte *der = (*env)->GetByteArrayElements(env, cert, NULL);
+        if (der == NULL) {
+            return -1;
+        }
+        const uint8_t *p = (const uint8_t *)der;
+        X509 *x509 = d2i_X509(NULL, &p, (long)len);
+        (*env)->ReleaseByteArrayElements(env, cert, der, JNI_ABORT);
+        (*env)->DeleteLocalRef(env, cert);
+        if (x509 == NULL) {
+            ERR_clear_error();
+            return -1;
+        }
+        int ok = X509_STORE_add_cert(store, x509);
+        X509_free(x509);
+        if (!ok) {
+            /* a duplicate anchor is harmless */
+            ERR_clear_error();
+        }
+    }
+    SSL_CTX_set_verify(ctx, require
+                       ? SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT
+                       : SSL_VERIFY_PEER, NULL);
+    return 0;
+}
+
+/*
+ * Creates an SSL for one TCP connection, with empty memory BIOs, in
+ * the server or client state.
+ */
+JNIEXPORT jlong JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_tls_1new(
+        JNIEnv *env, jclass cls, jlong ctx_ptr, jboolean is_server) {
+    SSL_CTX *ctx = (SSL_CTX *)(intptr_t)ctx_ptr;
+    SSL *ssl = SSL_new(ctx);
+    if (ssl == NULL) {
+        return 0;
+    }
+    probe_ssl_new(ssl);
+    BIO *rbio = BIO_new(BIO_s_mem());
+    BIO *wbio = BIO_new(BIO_s_mem());
+    if (rbio == NULL || wbio == NULL) {
+        BIO_free(rbio);
+        BIO_free(wbio);
+        SSL_free(ssl);
+        return 0;
+    }
+    /* an empty read BIO means "wait for more", not end of stream */
+    BIO_set_mem_eof_return(rbio, -1);
+    SSL_set_bio(ssl, rbio, wbio);
+    if (is_server) {
+        SSL_set_accept_state(ssl);
+    } else {
+        SSL_set_connect_state(ssl);
+    }
+    return (jlong)(intptr_t)ssl;
+}
+
+/*
+ * Most ciphertext the read BIO holds: a few full records. What does not
+ * fit stays in the caller's buffer, whose growth the transport bounds.
+ */
+#define TLS_MAX_FEED (4 * (16384 + 256))
+
+/*
+ * Appends ciphertext from a direct buffer to the read BIO, as much as
+ * fits under TLS_MAX_FEED: bytes consumed, possibly 0, or TLS_ERROR.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_tls_1feed(
+        JNIEnv *env, jclass cls, jlong ssl_ptr, jobject buf, jint off,
+        jint len) {
+    SSL *ssl = (SSL *)(intptr_t)ssl_ptr;
+    uint8_t *data = (uint8_t *)(*env)->GetDirectBufferAddress(env, buf);
+    if (data == NULL) {
+        return TLS_ERROR;
+    }
+    size_t pending = BIO_pending(SSL_get_rbio(ssl));
+    if (pending >= TLS_MAX_FEED) {
+        return 0;
+    }
+    if ((size_t)len > TLS_MAX_FEED - pending) {
+        len = (jint)(TLS_MAX_FEED - pending);
+    }
+    if (len <= 0) {
+        return 0;
+    }
+    int n = BIO_write(SSL_get_rbio(ssl), data + off, len);
+    return n > 0 ? n : TLS_ERROR;
+}
+
+/* Advances the handshake: 0 once it is complete, else a TLS_ code. */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_tls_1handshake(
+        JNIEnv *env, jclass cls, jlong ssl_ptr) {
+    SSL *ssl = (SSL *)(intptr_t)ssl_ptr;
+    int ret = SSL_do_handshake(ssl);
+    return ret == 1 ? 0 : tls_status(ssl, ret);
+}
+
+/* Decrypts into a direct buffer: bytes read, or a TLS_ code. */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_tls_1read(
+        JNIEnv *env, jclass cls, jlong ssl_ptr, jobject buf, jint off,
+        jint len) {
+    SSL *ssl = (SSL *)(intptr_t)ssl_ptr;
+    uint8_t *data = (uint8_t *)(*env)->GetDirectBufferAddress(env, buf);
+    if (data == NULL || len <= 0) {
+        return TLS_ERROR;
+    }
+    int ret = SSL_read(ssl, data + off, len);
+    return ret > 0 ? ret : tls_status(ssl, ret);
+}
+
+/*
+ * Encrypts from a direct buffer into the write BIO. The BIO grows as
+ * needed, so a write is never partial: bytes written, or a TLS_ code.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_tls_1write(
+        JNIEnv *env, jclass cls, jlong ssl_ptr, jobject buf, jint off,
+        jint len) {
+    SSL *ssl = (SSL *)(intptr_t)ssl_ptr;
+    uint8_t *data = (uint8_t *)(*env)->GetDirectBufferAddress(env, buf);
+    if (data == NULL || len <= 0) {
+        return TLS_ERROR;
+    }
+    int ret = SSL_write(ssl, data + off, len);
+    return ret > 0 ? ret : tls_status(ssl, ret);
+}
+
+/* Returns the number of ciphertext bytes waiting in the write BIO. */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_tls_1pending_1output(
+        JNIEnv *env, jclass cls, jlong ssl_ptr) {
+    SSL *ssl = (SSL *)(intptr_t)ssl_ptr;
+    return (jint)BIO_pending(SSL_get_wbio(ssl));
+}
+
+/* Moves ciphertext from the write BIO into a direct buffer. */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_tls_1drain(
+        JNIEnv *env, jclass cls, jlong ssl_ptr, jobject buf, jint off,
+        jint len) {
+    SSL *ssl = (SSL *)(intptr_t)ssl_ptr;
+    uint8_t *data = (uint8_t *)(*env)->GetDirectBufferAddress(env, buf);
+    if (data == NULL || len <= 0) {
+        return 0;
+    }
+    int n = BIO_read(SSL_get_wbio(ssl), data + off, len);
+    return n > 0 ? n : 0;
+}
+
+/* Queues close_notify (RFC 8446 section 6.1) in the write BIO. */
+JNIEXPORT void JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_tls_1shutdown(
+        JNIEnv *env, jclass cls, jlong ssl_ptr) {
+    SSL *ssl = (SSL *)(intptr_t)ssl_ptr;
+    if (SSL_shutdown(ssl) < 0) {
+        ERR_clear_error();
+    }
+}
+
+JNIEXPORT jstring JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_tls_1get_1version(
+        JNIEnv *env, jclass cls, jlong ssl_ptr) {
+    SSL *ssl = (SSL *)(intptr_t)ssl_ptr;
+    return (*env)->NewStringUTF(env, SSL_get_version(ssl));
+}
+
+/* Returns the IANA name of the negotiated cipher suite. */
+JNIEXPORT jstring JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_tls_1get_1cipher_1suite(
+        JNIEnv *env, jclass cls, jlong ssl_ptr) {
+    SSL *ssl = (SSL *)(intptr_t)ssl_ptr;
+    const SSL_CIPHER *cipher = SSL_get_current_cipher(ssl);
+    if (cipher == NULL) {
+        return NULL;
+    }
+    return (*env)->NewStringUTF(env, SSL_CIPHER_standard_name(cipher));
+}
+
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_tls_1get_1cipher_1bits(
+        JNIEnv *env, jclass cls, jlong ssl_ptr) {
+    SSL *ssl = (SSL *)(intptr_t)ssl_ptr;
+    const SSL_CIPHER *cipher = SSL_get_current_cipher(ssl);
+    return cipher != NULL ? (jint)SSL_CIPHER_get_bits(cipher, NULL) : -1;
+}
+
+JNIEXPORT jstring JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_tls_1get_1alpn_1selected(
+        JNIEnv *env, jclass cls, jlong ssl_ptr) {
+    SSL *ssl = (SSL *)(intptr_t)ssl_ptr;
+    const uint8_t *proto = NULL;
+    unsigned len = 0;
+    char name[256];
+    SSL_get0_alpn_selected(ssl, &proto, &len);
+    if (proto == NULL || len == 0) {
+        return NULL;
+    }
+    memcpy(name, proto, len);
+    name[len] = '\0';
+    return (*env)->NewStringUTF(env, name);
+}
+
+/* Returns the peer's DER certificate chain, leaf first, or null. */
+JNIEXPORT jobjectArray JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_tls_1get_1peer_1certificates(
+        JNIEnv *env, jclass cls, jlong ssl_ptr) {
+    SSL *ssl = (SSL *)(intptr_t)ssl_ptr;
+    const STACK_OF(CRYPTO_BUFFER) *chain = SSL_get0_peer_certificates(ssl);
+    if (chain == NULL || sk_CRYPTO_BUFFER_num(chain) == 0) {
+        return NULL;
+    }
+    size_t n = sk_CRYPTO_BUFFER_num(chain);
+    jclass byte_array = (*env)->FindClass(env, "[B");
+    if (byte_array == NULL) {
+        return NULL;
+    }
+    jobjectArray result = (*env)->NewObjectArray(env, (jsize)n, byte_array,
+                                                 NULL);
+    if (result == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < n; i++) {
+        const CRYPTO_BUFFER *cert = sk_CRYPTO_BUFFER_value(chain, i);
+        jsize len = (jsize)CRYPTO_BUFFER_len(cert);
+        jbyteArray der = (*env)->NewByteArray(env, len);
+        if (der == NULL) {
+            return NULL;
+        }
+        (*env)->SetByteArrayRegion(env, der, 0, len,
+                                   (const jbyte *)CRYPTO_BUFFER_data(cert));
+        (*env)->SetObjectArrayElement(env, result, (jsize)i, der);
+        (*env)->DeleteLocalRef(env, der);
+    }
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_tls_1free(
+        JNIEnv *env, jclass cls, jlong ssl_ptr) {
+    SSL_free((SSL *)(intptr_t)ssl_ptr);
+}
+
+/* ── Kernel TLS transmit offload (Linux) ──
+ *
+ * Once the handshake is over, record encryption for outbound data can
+ * be handed to the kernel's TLS ULP. The socket then takes plaintext:
+ * write() and sendfile() are framed and sealed in the kernel, so a file
+ * goes from the page cache to the NIC without passing through user
+ * space at all.
+ *
+ * The write key is derived here from what BoringSSL exposes. For TLS
+ * 1.3 that is the application traffic secret, captured from the keylog
+ * callback and expanded with HKDF-Expand-Label (RFC 8446 section 7.3);
+ * for TLS 1.2 it is the key block (RFC 5246 section 6.3). The record
+ * sequence number is BoringSSL's, so the kernel continues exactly where
+ * the SSL stopped. Only TX is offloaded: received records are still
+ * opened by the SSL, which must therefore not write again afterwards.
+ * Java treats any later output (a KeyUpdate response, say) as fatal.
+ *
+ * Install only once the write BIO is empty and everything drained from
+ * it has been written to the socket.
+ */
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <linux/tls.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+
+#define KTLS_MAX_SECRET 48
+
+typedef struct {
+    size_t len;
+    uint8_t secret[KTLS_MAX_SECRET];
+} ktls_secret_t;
+
+static int ktls_ssl_ex_data_index = -1;
+static pthread_mutex_t ktls_init_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void ktls_secret_free(void *parent, void *ptr, CRYPTO_EX_DATA *ad,
+                             int index, long argl, void *argp) {
+    ktls_secret_t *s = (ktls_secret_t *)ptr;
+    if (s != NULL) {
+        OPENSSL_cleanse(s, sizeof(ktls_secret_t));
+        gumdrop_free(s);
+    }
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/*
+ * Keeps this side's first application traffic secret from a line of
+ * the form "SERVER_TRAFFIC_SECRET_0 <client random> <secret>".
+ */
+static void ktls_keylog_cb(const SSL *ssl, const char *line) {
+    const char *label = SSL_is_server(ssl)
+            ? "SERVER_TRAFFIC_SECRET_0 " : "CLIENT_TRAFFIC_SECRET_0 ";
+    size_t label_len = strlen(label);
+    if (strncmp(line, label, label_len) != 0) {
+        return;
+    }
+    const char *hex = strchr(line + label_len, ' ');
+    if (hex == NULL) {
+        return;
+    }
+    hex++;
+    size_t hex_len = strlen(hex);
+    if (hex_len % 2 != 0 || hex_len / 2 > KTLS_MAX_SECRET) {
+        return;
+    }
+    ktls_secret_t *s =
+            (ktls_secret_t *)gumdrop_calloc(1, sizeof(ktls_secret_t));
+    if (s == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < hex_len / 2; i++) {
+        int hi = hex_value(hex[2 * i]);
+        int lo = hex_value(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) {
+            ktls_secret_free(NULL, s, NULL, 0, 0, NULL);
+            return;
+        }
+        s->secret[i] = (uint8_t)((hi << 4) | lo);
+    }
+    s->len = hex_len / 2;
+    SSL *mut = (SSL *)ssl;
+    ktls_secret_free(NULL, SSL_get_ex_data(mut, ktls_ssl_ex_data_index),
+                     NULL, 0, 0, NULL);
+    SSL_set_ex_data(mut, ktls_ssl_ex_data_index, s);
+}
+
+/*
+ * Derives this side's write key and IV and fills in the kernel's crypto
+ * info for the negotiated AEAD. Returns the size of the structure
+ * written to out, or 0 if the cipher or version cannot be offloaded.
+ */
+static size_t ktls_crypto_info(SSL *ssl, void *out, size_t out_size) {
+    const SSL_CIPHER *cipher = SSL_get_current_cipher(ssl);
+    uint16_t version = SSL_version(ssl);
+    uint8_t key[32];
+    uint8_t iv[12];
+    uint8_t seq[8];
+    size_t key_len;
+    size_t salt_len;
+    size_t result = 0;
+    int cipher_type;
+
+    if (cipher == NULL) {
+        return 0;
+    }
+    switch (SSL_CIPHER_get_cipher_nid(cipher)) {
+    case NID_aes_128_gcm:
+        cipher_type = TLS_CIPHER_AES_GCM_128;
+        key_len = 16;
+        salt_len = 4;
+        break;
+    case NID_aes_256_gcm:
+        cipher_type = TLS_CIPHER_AES_GCM_256;
+        key_len = 32;
+        salt_len = 4;
+        break;
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+    case NID_chacha20_poly1305:
+        cipher_type = TLS_CIPHER_CHACHA20_POLY1305;
+        key_len = 32;
+        salt_len = 0;
+        break;
+#endif
+    default:
+        return 0;
+    }
+
+    put_u64_be(seq, SSL_get_write_sequence(ssl));
+    if (version == TLS1_3_VERSION) {
+        ktls_secret_t *s = (ktls_secret_t *)SSL_get_ex_data(ssl,
+                ktls_ssl_ex_data_index);
+        const EVP_MD *md = SSL_CIPHER_get_handshake_digest(cipher);
+        if (s == NULL || md == NULL
+                || !gumdrop_hkdf_expand_label(key, key_len, md, s->secret,
+                                              s->len, "key")
+                || !gumdrop_hkdf_expand_label(iv, sizeof(iv), md, s->secret,
+                                              s->len, "iv")) {
+            goto done;
+        }
+    } else if (version == TLS1_2_VERSION) {
+        /* client key, server key, client IV, server IV; AEADs have no
+         * MAC keys. For GCM the fixed IV is the 4-byte salt and the
+         * explicit nonce is the sequence number, as BoringSSL sends. */
+        uint8_t block[2 * (32 + 12)];
+        size_t block_len = SSL_get_key_block_len(ssl);
+        size_t fixed_iv_len = block_len / 2 - key_len;
+        int server = SSL_is_server(ssl);
+        if (block_len > sizeof(block)
+                || fixed_iv_len != (salt_len != 0 ? salt_len : sizeof(iv))
+                || !SSL_generate_key_block(ssl, block, block_len)) {
+            OPENSSL_cleanse(block, sizeof(block));
+            goto done;
+        }
+        memcpy(key, block + (server ? key_len : 0), key_len);
+        memcpy(iv, block + 2 * key_len + (server ? fixed_iv_len : 0),
+               fixed_iv_len);
+        if (salt_len != 0) {
+            memcpy(iv + salt_len, seq, sizeof(seq));
+        }
+        OPENSSL_cleanse(block, sizeof(block));
+    } else {
+        goto done;
+    }
+
+    switch (cipher_type) {
+    case TLS_CIPHER_AES_GCM_128: {
+        struct tls12_crypto_info_aes_gcm_128 *ci = out;
+        if (out_size < sizeof(*ci)) {
+            goto done;
+        }
+        memset(ci, 0, sizeof(*ci));
+        ci->info.version = version;
+        ci->info.cipher_type = cipher_type;
+        memcpy(ci->key, key, key_len);
+        memcpy(ci->salt, iv, salt_len);
+        memcpy(ci->iv, iv + salt_len, sizeof(ci->iv));
+        memcpy(ci->rec_seq, seq, sizeof(seq));
+        result = sizeof(*ci);
+        break;
+    }
+    case TLS_CIPHER_AES_GCM_256: {
+        struct tls12_crypto_info_aes_gcm_256 *ci = out;
+        if (out_size < sizeof(*ci)) {
+            goto done;
+        }
+        memset(ci, 0, sizeof(*ci));
+        ci->info.version = version;
+        ci->info.cipher_type = cipher_type;
+        memcpy(ci->key, key, key_len);
+        memcpy(ci->salt, iv, salt_len);
+        memcpy(ci->iv, iv + salt_len, sizeof(ci->iv));
+        memcpy(ci->rec_seq, seq, sizeof(seq));
+        result = sizeof(*ci);
+        break;
+    }
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+    case TLS_CIPHER_CHACHA20_POLY1305: {
+        struct tls12_crypto_info_chacha20_poly1305 *ci = out;
+        if (out_size < sizeof(*ci)) {
+            goto done;
+        }
+        memset(ci, 0, sizeof(*ci));
+        ci->info.version = version;
+        ci->info.cipher_type = cipher_type;
+        memcpy(ci->key, key, key_len);
+        memcpy(ci->iv, iv, sizeof(ci->iv));
+        memcpy(ci->rec_seq, seq, sizeof(seq));
+        result = sizeof(*ci);
+        break;
+    }
+#endif
+    }
+
+done:
+    OPENSSL_cleanse(key, sizeof(key));
+    OPENSSL_cleanse(iv, sizeof(iv));
+    return result;
+}
+
+#endif /* __linux__ */
+
+/*
+ * Prepares an SSL_CTX for kernel TLS: TLS 1.3 connections record their
+ * write secret as they handshake. Returns -1 where the platform has no
+ * kernel TLS.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_ssl_1ctx_1enable_1ktls(
+        JNIEnv *env, jclass cls, jlong ctx_ptr) {
+#ifdef __linux__
+    SSL_CTX *ctx = (SSL_CTX *)(intptr_t)ctx_ptr;
+    pthread_mutex_lock(&ktls_init_lock);
+    if (ktls_ssl_ex_data_index < 0) {
+        ktls_ssl_ex_data_index = SSL_get_ex_new_index(
+                0, NULL, NULL, NULL, ktls_secret_free);
+    }
+    pthread_mutex_unlock(&ktls_init_lock);
+    if (ktls_ssl_ex_data_index < 0) {
+        return -1;
+    }
+    SSL_CTX_set_keylog_callback(ctx, ktls_keylog_cb);
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+/*
+ * Moves record encryption for data written to the channel into the
+ * kernel. Returns 0 on success, or -1 if the cipher, version or kernel
+ * does not allow it; the SSL then remains usable for writing.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_tls_1ktls_1enable(
+        JNIEnv *env, jclass cls, jlong ssl_ptr, jobject channel) {
+#ifdef __linux__
+    SSL *ssl = (SSL *)(intptr_t)ssl_ptr;
+    union {
+        struct tls12_crypto_info_aes_gcm_128 aes128;
+        struct tls12_crypto_info_aes_gcm_256 aes256;
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+        struct tls12_crypto_info_chacha20_poly1305 chacha;
+#endif
+    } ci;
+    int fd = gumdrop_channel_fd(env, channel);
+    int rc = -1;
+    if (fd < 0 || BIO_pending(SSL_get_wbio(ssl)) > 0) {
+        return -1;
+    }
+    size_t len = ktls_crypto_info(ssl, &ci, sizeof(ci));
+    if (len != 0
+            && setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) == 0
+            && setsockopt(fd, SOL_TLS, TLS_TX, &ci, (socklen_t)len) == 0) {
+        rc = 0;
+    }
+    OPENSSL_cleanse(&ci, sizeof(ci));
+    if (ktls_ssl_ex_data_index >= 0) {
+        /* the secret is no longer needed either way */
+        ktls_secret_free(NULL, SSL_get_ex_data(ssl, ktls_ssl_ex_data_index),
+                         NULL, 0, 0, NULL);
+        SSL_set_ex_data(ssl, ktls_ssl_ex_data_index, NULL);
+    }
+    return rc;
+#else
+    return -1;
+#endif
+}
+
+/*
+ * Sends close_notify (RFC 8446 section 6.1) on a channel whose writes
+ * are encrypted by the kernel, as a record of type alert.
+ */
+JNIEXPORT jint JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_ktls_1send_1close_1notify(
+        JNIEnv *env, jclass cls, jobject channel) {
+#ifdef __linux__
+    uint8_t alert[2] = { 1, 0 };    /* warning, close_notify */
+    char control[CMSG_SPACE(sizeof(uint8_t))];
+    struct iovec iov;
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    int fd = gumdrop_channel_fd(env, channel);
+    if (fd < 0) {
+        return -1;
+    }
+    memset(&msg, 0, sizeof(msg));
+    memset(control, 0, sizeof(control));
+    iov.iov_base = alert;
+    iov.iov_len = sizeof(alert);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_TLS;
+    cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint8_t));
+    *CMSG_DATA(cmsg) = 21;          /* ContentType.alert */
+    return sendmsg(fd, &msg, MSG_DONTWAIT) == sizeof(alert) ? 0 : -1;
+#else
+    return -1;
+#endif
+}
+
+/* ── Per-connection session state ── */
+
+JNIEXPORT jboolean JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_ssl_1session_1reused(
+        JNIEnv *env, jclass cls, jlong ssl_ptr) {
+    SSL *ssl = (SSL *)(intptr_t)ssl_ptr;
+    return SSL_session_reused(ssl) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_ssl_1early_1data_1accepted(
+        JNIEnv *env, jclass cls, jlong ssl_ptr) {
+    SSL *ssl = (SSL *)(intptr_t)ssl_ptr;
+    return SSL_early_data_accepted(ssl) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jlong JNICALL
+Java_org_bluezoo_gumdrop_GumdropNative_ssl_1new(
+        JNIEnv *env, jclass cls, jlong ctx_ptr) {
+    SSL_CTX *ctx = (SSL_CTX *)(intptr_t)ctx_ptr;
+    SSL *ssl = SSL_new(ctx);
+    if (ssl != NULL) {
+        probe_ssl_new(ssl);
+    }
     return (jlong)(intptr_t)ssl;
 }
 
@@ -0,0 +1,186 @@
+/*
+ * CongestionProfile.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+import org.bluezoo.gumdrop.GumdropNative;
+
+/**
+ * A named set of congestion control settings for QUIC connections
+ * (RFC 9002 section 7).
+ *
+ * <p>Three profiles are built in:
+ * <dl>
+ * <dt>{@code bulk-bbr2}</dt>
+ * <dd>BBRv2 with pacing, for large downloads over lossy or
+ * bufferbloated paths, where a loss-based controller backs off too
+ * far.</dd>
+ * <dt>{@code interactive-cubic}</dt>
+ * <dd>CUBIC with HyStart++ (RFC 9406) and pacing, for request/response
+ * traffic: slow start ends before it overshoots the path, so short
+ * transfers see little queueing or loss.</dd>
+ * <dt>{@code datacenter}</dt>
+ * <dd>CUBIC with HyStart++ and an initial window of 32 packets rather
+ * than 10 (RFC 9002 section 7.2), for short, well provisioned paths
+ * where a transfer would otherwise spend most of its life in slow
+ * start. Pacing is off, since release times below a microsecond
+ * scale gain nothing at such round-trip times.</dd>
+ * </dl>
+ *
+ * <p>With pacing on, quiche gives each packet a release time, and the
+ * {@link QuicEngine} holds a packet due a millisecond or more ahead,
+ * with those after it, until a timer sends it: a congestion window is
+ * spread over the round trip rather than sent as one burst. The
+ * {@link #getMaxPacingRate maximum pacing rate} caps that rate.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ * @see QuicTransportFactory#setCongestionProfile(CongestionProfile)
+ * @see QuicTransportFactory#setCongestionProfileNetworks
+ */
+public final class CongestionProfile {
+
+    /** BBRv2 with pacing, for bulk transfer. */
+    public static final CongestionProfile BULK_BBR2 =
+            new CongestionProfile("bulk-bbr2", "bbr2", false, true, 0, 0);
+
+    /** CUBIC with HyStart++ and pacing, for interactive traffic. */
+    public static final CongestionProfile INTERACTIVE_CUBIC =
+            new CongestionProfile("interactive-cubic", "cubic", true, true,
+                    0, 0);
+
+    /** CUBIC with a 32-packet initial window, for datacenter paths. */
+    public static final CongestionProfile DATACENTER =
+            new CongestionProfile("datacenter", "cubic", true, false, 32, 0);
+
+    private final String name;
+    private final String algorithm;
+    private final boolean hystart;
+    private final boolean pacing;
+    private final int initialCongestionWindowPackets;
+    private final long maxPacingRate;
+
+    /**
+     * Creates a profile.
+     *
+     * @param name the profile name
+     * @param algorithm the quiche congestion control algorithm name:
+     *        {@code reno}, {@code cubic}, {@code bbr} or {@code bbr2}
+     * @param hystart whether to use HyStart++ (RFC 9406) in slow start
+     * @param pacing whether to pace packets
+     * @param initialCongestionWindowPackets the initial congestion
+     *        window in packets, or 0 for quiche's default of 10
+     * @param maxPacingRate the most bytes per second to pace at, or 0
+     *        for no limit
+     */
+    public CongestionProfile(String name, String algorithm, boolean hystart,
+                             boolean pacing,
+                             int initialCongestionWindowPackets,
+                             long maxPacingRate) {
+        if (name == null || algorithm == null) {
+            throw new NullPointerException();
+        }
+        if (initialCongestionWindowPackets < 0 || maxPacingRate < 0) {
+            throw new IllegalArgumentException(
+                    "negative congestion profile setting");
+        }
+        this.name = name;
+        this.algorithm = algorithm;
+        this.hystart = hystart;
+        this.pacing = pacing;
+        this.initialCongestionWindowPackets = initialCongestionWindowPackets;
+        this.maxPacingRate = maxPacingRate;
+    }
+
+    /**
+     * Returns the built-in profile with the given name.
+     *
+     * @param name {@code bulk-bbr2}, {@code interactive-cubic} or
+     *        {@code datacenter}
+     * @throws IllegalArgumentException if there is no such profile
+     */
+    public static CongestionProfile forName(String name) {
+        String key = name.trim();
+        if (BULK_BBR2.name.equals(key)) {
+            return BULK_BBR2;
+        }
+        if (INTERACTIVE_CUBIC.name.equals(key)) {
+            return INTERACTIVE_CUBIC;
+        }
+        if (DATACENTER.name.equals(key)) {
+            return DATACENTER;
+        }
+        throw new IllegalArgumentException(
+                "Unknown congestion profile: " + name);
+    }
+
+    public String getName() {
+        return name;
+    }
+
+    public String getAlgorithm() {
+        return algorithm;
+    }
+
+    public boolean isHystart() {
+        return hystart;
+    }
+
+    public boolean isPacing() {
+        return pacing;
+    }
+
+    public int getInitialCongestionWindowPackets() {
+        return initialCongestionWindowPackets;
+    }
+
+    public long getMaxPacingRate() {
+        return maxPacingRate;
+    }
+
+    /**
+     * Applies this profile to a quiche config.
+     *
+     * @return false if quiche does not know the algorithm
+     */
+    boolean apply(long config) {
+        if (GumdropNative.quiche_config_set_cc_algorithm_name(
+                config, algorithm) != 0) {
+            return false;
+        }
+        GumdropNative.quiche_config_enable_hystart(config, hystart);
+        GumdropNative.quiche_config_enable_pacing(config, pacing);
+        if (initialCongestionWindowPackets > 0) {
+            GumdropNative.quiche_config_set_initial_congestion_window_packets(
+                    config, initialCongestionWindowPackets);
+        }
+        if (maxPacingRate > 0) {
+            GumdropNative.quiche_config_set_max_pacing_rate(
+                    config, maxPacingRate);
+        }
+        return true;
+    }
+
+    @Override
+    public String toString() {
+        return name;
+    }
+
+}
@@ -0,0 +1,56 @@
+/*
+ * ConnectionIdGenerator.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+/**
+ * Generates the connection IDs a QUIC endpoint issues (RFC 9000 section
+ * 5.1): the source connection ID of each new connection, Retry source
+ * connection IDs, and the spare IDs offered in NEW_CONNECTION_ID frames.
+ *
+ * <p>By default these are 20 random bytes. A generator that encodes
+ * routing information, such as {@link QuicLbConnectionIdGenerator}, lets
+ * a stateless load balancer send every packet of a connection to the
+ * same server, even after the client migrates to a new address.
+ *
+ * <p>Short headers do not carry the length of the destination connection
+ * ID, so every ID a generator returns must have the same length.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ * @see QuicTransportFactory#setConnectionIdGenerator
+ */
+public interface ConnectionIdGenerator {
+
+    /**
+     * Returns the length of the connection IDs generated, from 1 to 20
+     * bytes.
+     */
+    int getLength();
+
+    /**
+     * Generates a new connection ID of {@link #getLength} bytes. Engines
+     * sharing the generator may call this concurrently.
+     *
+     * @return the connection ID
+     */
+    byte[] generate();
+
+}
@@ -0,0 +1,260 @@
+/*
+ * HandshakeAdmission.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+import java.net.InetAddress;
+import java.net.InetSocketAddress;
+import java.nio.ByteBuffer;
+import java.security.GeneralSecurityException;
+import java.security.MessageDigest;
+import java.security.SecureRandom;
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.IdentityHashMap;
+import java.util.Set;
+
+import javax.crypto.Mac;
+import javax.crypto.spec.SecretKeySpec;
+
+import org.bluezoo.gumdrop.ratelimit.ConnectionRateLimiter;
+
+/**
+ * Decides whether a server {@link QuicEngine} takes on a new handshake,
+ * before any SSL or quiche connection is allocated for it.
+ *
+ * <p>Three limits apply: the number of half-open connections (accepted
+ * but not yet established), a token bucket on the rate at which
+ * handshakes start, and optionally the per-address limits of a
+ * {@link ConnectionRateLimiter}. A client whose address has not been
+ * validated is sent a Retry (RFC 9000 section 8.1.2) once half of the
+ * half-open or rate budget is used, or when it would not fit, so a
+ * flood from spoofed addresses costs one stateless packet per Initial
+ * and leaves the rest of the budget for clients that can prove their
+ * address. A validated client that still does not fit is refused with
+ * CONNECTION_CLOSE.
+ *
+ * <p>Per-address limits are only meaningful for an address the client
+ * has shown it owns: when they are on, every unvalidated client is
+ * sent a Retry, and only validated addresses are counted against them.
+ *
+ * <p>Retry tokens are authenticated with a key private to this object
+ * and bind the client's address and port, the original and Retry
+ * connection IDs, and an expiry time.
+ *
+ * <p>Not thread-safe: used only from the engine's SelectorLoop.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ * @see QuicTransportFactory#setMaxHalfOpenHandshakes
+ * @see QuicTransportFactory#setHandshakeRate
+ */
+final class HandshakeAdmission {
+
+    enum Decision {
+        ACCEPT,
+        RETRY,
+        REFUSE
+    }
+
+    /** How long a client has to return a Retry token, in milliseconds. */
+    static final long RETRY_TOKEN_LIFETIME = 10000;
+
+    private static final int MAC_LEN = 16;
+    private static final int MAX_CONN_ID_LEN = 20;
+
+    private final int maxHalfOpen;
+    private final double tokensPerNano;
+    private final double burst;
+    private final ConnectionRateLimiter perSource;
+    private final Mac mac;
+
+    private final Set<Object> halfOpen =
+            Collections.newSetFromMap(new IdentityHashMap<Object, Boolean>());
+    private double tokens;
+    private long lastRefill;
+
+    /**
+     * @param maxHalfOpen the most connections that may be handshaking
+     *        at once, or 0 for no limit
+     * @param rate handshakes started per second, or 0 for no limit
+     * @param burst the most handshakes that may start at once when the
+     *        rate allows; at least 1
+     * @param perSource per-address limits, or null
+     */
+    HandshakeAdmission(int maxHalfOpen, int rate, int burst,
+                       ConnectionRateLimiter perSource) {
+        this.maxHalfOpen = maxHalfOpen;
+        this.tokensPerNano = rate / 1e9;
+        this.burst = Math.max(1, burst);
+        this.perSource = perSource;
+        this.tokens = this.burst;
+        this.lastRefill = System.nanoTime();
+        byte[] key = new byte[32];
+        new SecureRandom().nextBytes(key);
+        try {
+            mac = Mac.getInstance("HmacSHA256");
+            mac.init(new SecretKeySpec(key, "HmacSHA256"));
+        } catch (GeneralSecurityException e) {
+            // HmacSHA256 is required of every Java platform
+            throw new IllegalStateException(e);
+        }
+    }
+
+    // ── Budget ──
+
+    /**
+     * Decides what to do with an Initial from a client with no
+     * connection.
+     *
+     * @param source the client address
+     * @param validated true if the client returned a valid Retry token
+     */
+    Decision admit(InetAddress source, boolean validated) {
+        refill();
+        int count = halfOpen.size();
+        boolean fits = (maxHalfOpen <= 0 || count < maxHalfOpen)
+                && (tokensPerNano <= 0 || tokens >= 1);
+        if (validated) {
+            fits = fits
+                    && (perSource == null || perSource.allowConnection(source));
+            return fits ? Decision.ACCEPT : Decision.REFUSE;
+        }
+        if (perSource != null) {
+            // The source may be spoofed: do not charge it to anyone
+            return Decision.RETRY;
+        }
+        boolean pressed = (maxHalfOpen > 0 && count * 2 >= maxHalfOpen)
+                || (tokensPerNano > 0 && tokens * 2 < burst);
+        return (fits && !pressed) ? Decision.ACCEPT : Decision.RETRY;
+    }
+
+    /**
+     * Records that an admitted handshake has started.
+     *
+     * @param conn the connection, as later passed to
+     *        {@link #established} and {@link #closed}
+     * @param source the client address
+     */
+    void opened(Object conn, InetAddress source) {
+        halfOpen.add(conn);
+        if (tokensPerNano > 0) {
+            tokens -= 1;
+        }
+        if (perSource != null) {
+            perSource.connectionOpened(source);
+        }
+    }
+
+    /** Records that an admitted handshake has completed. */
+    void established(Object conn) {
+        halfOpen.remove(conn);
+    }
+
+    /**
+     * Records that an admitted connection has closed. It leaves the
+     * half-open count only if it has not already done so.
+     */
+    void closed(Object conn, InetAddress source) {
+        halfOpen.remove(conn);
+        if (perSource != null) {
+            perSource.connectionClosed(source);
+        }
+    }
+
+    /** Returns the number of handshakes in progress. */
+    int getHalfOpen() {
+        return halfOpen.size();
+    }
+
+    private void refill() {
+        if (tokensPerNano <= 0) {
+            return;
+        }
+        long now = System.nanoTime();
+        tokens = Math.min(burst, tokens + (now - lastRefill) * tokensPerNano);
+        lastRefill = now;
+    }
+
+    // ── Retry tokens ──
+
+    /**
+     * Creates the token for a Retry sent to a client.
+     *
+     * @param client the client's address
+     * @param odcid the Destination Connection ID of its first Initial
+     * @param retryScid the connection ID chosen in the Retry
+     */
+    byte[] retryToken(InetSocketAddress client, byte[] odcid,
+                      byte[] retryScid) {
+        int len = 8 + 1 + odcid.length;
+        byte[] token = new byte[len + MAC_LEN];
+        ByteBuffer buf = ByteBuffer.wrap(token);
+        buf.putLong(System.currentTimeMillis() + RETRY_TOKEN_LIFETIME);
+        buf.put((byte) odcid.length);
+        buf.put(odcid);
+        buf.put(tokenMac(token, len, client, retryScid), 0, MAC_LEN);
+        return token;
+    }
+
+    /**
+     * Checks a token returned in an Initial.
+     *
+     * @param token the token
+     * @param client the client's address
+     * @param dcid the Destination Connection ID of the Initial, which is
+     *        the connection ID chosen in the Retry
+     * @return the original Destination Connection ID, or null if the
+     *         token is not a current Retry token for this client
+     */
+    byte[] validateRetryToken(byte[] token, InetSocketAddress client,
+                              byte[] dcid) {
+        if (token.length < 8 + 1 + MAC_LEN) {
+            return null;
+        }
+        int odcidLen = token[8] & 0xff;
+        int len = 8 + 1 + odcidLen;
+        if (odcidLen > MAX_CONN_ID_LEN || token.length != len + MAC_LEN) {
+            return null;
+        }
+        byte[] expected = Arrays.copyOf(
+                tokenMac(token, len, client, dcid), MAC_LEN);
+        byte[] actual = Arrays.copyOfRange(token, len, token.length);
+        if (!MessageDigest.isEqual(expected, actual)) {
+            return null;
+        }
+        if (System.currentTimeMillis() > ByteBuffer.wrap(token).getLong(0)) {
+            return null;
+        }
+        return Arrays.copyOfRange(token, 9, len);
+    }
+
+    private byte[] tokenMac(byte[] token, int len, InetSocketAddress client,
+                            byte[] retryScid) {
+        int port = client.getPort();
+        mac.update(token, 0, len);
+        mac.update(client.getAddress().getAddress());
+        mac.update((byte) (port >> 8));
+        mac.update((byte) port);
+        mac.update(retryScid);
+        return mac.doFinal();
+    }
+
+}
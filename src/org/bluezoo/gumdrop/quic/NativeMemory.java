@@ -0,0 +1,303 @@
+/*
+ * NativeMemory.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+import org.bluezoo.gumdrop.Gumdrop;
+import org.bluezoo.gumdrop.GumdropNative;
+import org.bluezoo.gumdrop.telemetry.TelemetryConfig;
+import org.bluezoo.gumdrop.telemetry.metrics.Instrument;
+import org.bluezoo.gumdrop.telemetry.metrics.Meter;
+import org.bluezoo.gumdrop.telemetry.metrics.ObservableCallback;
+import org.bluezoo.gumdrop.telemetry.metrics.ObservableMeasurement;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.Executors;
+import java.util.concurrent.ScheduledExecutorService;
+import java.util.concurrent.TimeUnit;
+import java.util.logging.Level;
+import java.util.logging.Logger;
+
+/**
+ * Off-heap memory used by the native QUIC stack.
+ *
+ * <p>While any {@link QuicEngine} is open, this polls the native library
+ * once a second for three figures:
+ * <ul>
+ * <li>the bytes and blocks the JNI layer itself holds, which it counts
+ * exactly;</li>
+ * <li>the bytes in use on the process's native heap, which is where
+ * quiche and BoringSSL allocate (glibc 2.33 or later and macOS; elsewhere
+ * it is unknown);</li>
+ * <li>the bytes every connection has sent but not yet had acknowledged,
+ * which quiche buffers for retransmission.</li>
+ * </ul>
+ * The heap figure also covers anything else in the process that uses
+ * malloc, so the per-connection estimate is its growth over the level
+ * last seen with no connections open, divided among the connections open
+ * now.
+ *
+ * <p>{@link QuicTransportFactory#setNativeMemoryLimit} compares
+ * {@link #getUsage} with a ceiling to refuse or shrink new connections.
+ * Usage is the JNI layer's own bytes plus the heap's growth since the
+ * first engine opened, not counting the JNI layer's part of that growth
+ * twice. Memory the rest of the process had allocated by then (the JVM's
+ * own native memory, other JNI libraries) is left out; what it
+ * allocates afterwards cannot be told apart from quiche's and BoringSSL's
+ * and is counted too.
+ * Once {@link #registerMetrics registered}, the figures are also
+ * reported as {@code quic.native.*} gauges, which the telemetry JMX
+ * bridge publishes as MBean attributes.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ * @see QuicTransportFactory#setNativeMemoryLimit
+ */
+public final class NativeMemory {
+
+    private static final Logger LOGGER =
+            Logger.getLogger(NativeMemory.class.getName());
+
+    private static final String METER_NAME = "org.bluezoo.gumdrop.quic";
+
+    private static final long POLL_INTERVAL_MS = 1000;
+
+    // Open engines, whose connections are polled for bytes in flight
+    private static final List<QuicEngine> engines =
+            new ArrayList<QuicEngine>();
+    private static ScheduledExecutorService poller;
+
+    // Figures from the last poll
+    private static volatile long jniBytes;
+    private static volatile long jniAllocations;
+    private static volatile long heapInUse = -1;
+    private static volatile long bufferedBytes;
+    private static volatile int connections;
+    // Heap in use when last polled with no connections open
+    private static volatile long baseline = -1;
+    // Heap in use outside the JNI layer when the first engine opened
+    private static volatile long startBaseline = -1;
+
+    private NativeMemory() {
+    }
+
+    /** Returns the bytes currently allocated by the JNI layer. */
+    public static long getJniBytes() {
+        return jniBytes;
+    }
+
+    /** Returns the number of blocks currently allocated by the JNI layer. */
+    public static long getJniAllocations() {
+        return jniAllocations;
+    }
+
+    /**
+     * Returns the bytes in use on the process's native heap, including
+     * quiche and BoringSSL, or -1 if the allocator cannot report it.
+     */
+    public static long getHeapInUse() {
+        return heapInUse;
+    }
+
+    /**
+     * Returns the bytes all open connections have sent but that are
+     * neither acknowledged nor declared lost.
+     */
+    public static long getBufferedBytes() {
+        return bufferedBytes;
+    }
+
+    /** Returns the number of open connections at the last poll. */
+    public static int getConnectionCount() {
+        return connections;
+    }
+
+    /**
+     * Returns the native memory the QUIC stack is taken to be using.
+     * Where the heap can be measured, this is what the JNI layer holds
+     * plus the rest of the heap's growth since the first engine opened;
+     * otherwise it is what the JNI layer holds plus the bytes buffered
+     * for retransmission.
+     */
+    public static long getUsage() {
+        return usage(heapInUse, startBaseline, jniBytes, bufferedBytes);
+    }
+
+    static long usage(long heap, long start, long jni, long buffered) {
+        if (heap < 0 || start < 0) {
+            return jni + buffered;
+        }
+        return Math.max(jni, heap - start);
+    }
+
+    /**
+     * Returns an estimate of the native memory each open connection
+     * uses, or 0 if none is open.
+     */
+    public static long getConnectionEstimate() {
+        int count = connections;
+        if (count == 0) {
+            return 0;
+        }
+        long heap = heapInUse;
+        long base = baseline;
+        if (heap >= 0 && base >= 0) {
+            return Math.max(0, heap - base) / count;
+        }
+        return (jniBytes + bufferedBytes) / count;
+    }
+
+    // ── Telemetry ──
+
+    /**
+     * Reports the figures as gauges on the {@code org.bluezoo.gumdrop.quic}
+     * meter. Registering more than once has no further effect.
+     *
+     * @param config the telemetry configuration
+     */
+    public static synchronized void registerMetrics(TelemetryConfig config) {
+        Meter meter = config.getMeter(METER_NAME, Gumdrop.VERSION);
+        for (Instrument instrument : meter.getInstruments()) {
+            if (instrument.getName().startsWith("quic.native.")) {
+                return;
+            }
+        }
+        meter.gaugeBuilder("quic.native.heap")
+                .setDescription("Bytes in use on the native heap")
+                .setUnit("bytes")
+                .buildWithCallback(new ObservableCallback() {
+                    @Override
+                    public void observe(ObservableMeasurement m) {
+                        long heap = heapInUse;
+                        if (heap >= 0) {
+                            m.record(heap);
+                        }
+                    }
+                });
+        meter.gaugeBuilder("quic.native.jni.allocated")
+                .setDescription("Bytes allocated by the JNI layer")
+                .setUnit("bytes")
+                .buildWithCallback(new ObservableCallback() {
+                    @Override
+                    public void observe(ObservableMeasurement m) {
+                        m.record(jniBytes);
+                    }
+                });
+        meter.gaugeBuilder("quic.native.jni.allocations")
+                .setDescription("Blocks allocated by the JNI layer")
+                .setUnit("allocations")
+                .buildWithCallback(new ObservableCallback() {
+                    @Override
+                    public void observe(ObservableMeasurement m) {
+                        m.record(jniAllocations);
+                    }
+                });
+        meter.gaugeBuilder("quic.native.buffered")
+                .setDescription("Bytes in flight awaiting acknowledgement")
+                .setUnit("bytes")
+                .buildWithCallback(new ObservableCallback() {
+                    @Override
+                    public void observe(ObservableMeasurement m) {
+                        m.record(bufferedBytes);
+                    }
+                });
+        meter.gaugeBuilder("quic.native.connection.estimate")
+                .setDescription("Estimated native memory per connection")
+                .setUnit("bytes")
+                .buildWithCallback(new ObservableCallback() {
+                    @Override
+                    public void observe(ObservableMeasurement m) {
+                        m.record(getConnectionEstimate());
+                    }
+                });
+    }
+
+    // ── Polling ──
+
+    private static void poll() {
+        long[] stats = GumdropNative.native_memory_stats();
+        if (stats == null) {
+            return;
+        }
+        List<QuicEngine> list;
+        synchronized (NativeMemory.class) {
+            list = new ArrayList<QuicEngine>(engines);
+        }
+        long buffered = 0;
+        int count = 0;
+        for (final QuicEngine engine : list) {
+            buffered += engine.getBufferedBytes();
+            count += engine.getLiveConnectionCount();
+            // The sample for the next poll, taken on the engine's thread
+            if (engine.getSelectorLoop() != null) {
+                engine.execute(new Runnable() {
+                    @Override
+                    public void run() {
+                        engine.pollBufferedBytes();
+                    }
+                });
+            }
+        }
+        jniBytes = stats[0];
+        jniAllocations = stats[1];
+        heapInUse = stats[2];
+        bufferedBytes = buffered;
+        connections = count;
+        if (count == 0 && stats[2] >= 0) {
+            baseline = stats[2];
+        }
+        if (startBaseline < 0 && stats[2] >= 0) {
+            startBaseline = stats[2] - stats[0];
+        }
+    }
+
+    // ── Engine registry ──
+
+    static synchronized void engineOpened(QuicEngine engine) {
+        engines.add(engine);
+        if (poller == null) {
+            poller = Executors.newSingleThreadScheduledExecutor(
+                    new DaemonThreadFactory("quic-native-memory"));
+            poller.scheduleWithFixedDelay(new Runnable() {
+                @Override
+                public void run() {
+                    try {
+                        poll();
+                    } catch (RuntimeException e) {
+                        LOGGER.log(Level.WARNING,
+                                "Native memory poll failed", e);
+                    }
+                }
+            }, 0, POLL_INTERVAL_MS, TimeUnit.MILLISECONDS);
+        }
+    }
+
+    static synchronized void engineClosed(QuicEngine engine) {
+        engines.remove(engine);
+        if (engines.isEmpty() && poller != null) {
+            poller.shutdownNow();
+            poller = null;
+            // Measured again from the next engine
+            startBaseline = -1;
+        }
+    }
+
+}
@@ -0,0 +1,597 @@
+/*
+ * OCSPStapler.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+import org.bluezoo.gumdrop.Endpoint;
+import org.bluezoo.gumdrop.SecurityInfo;
+import org.bluezoo.gumdrop.http.client.DefaultHTTPResponseHandler;
+import org.bluezoo.gumdrop.http.client.HTTPClient;
+import org.bluezoo.gumdrop.http.client.HTTPClientHandler;
+import org.bluezoo.gumdrop.http.client.HTTPRequest;
+import org.bluezoo.gumdrop.http.client.HTTPResponse;
+
+import java.io.ByteArrayOutputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.InterruptedIOException;
+import java.net.URI;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.NoSuchFileException;
+import java.nio.file.Path;
+import java.nio.file.StandardCopyOption;
+import java.security.GeneralSecurityException;
+import java.security.MessageDigest;
+import java.security.cert.CertPath;
+import java.security.cert.CertPathValidator;
+import java.security.cert.CertPathValidatorException;
+import java.security.cert.Certificate;
+import java.security.cert.CertificateFactory;
+import java.security.cert.PKIXParameters;
+import java.security.cert.PKIXRevocationChecker;
+import java.security.cert.TrustAnchor;
+import java.security.cert.X509Certificate;
+import java.util.ArrayList;
+import java.util.Collection;
+import java.util.Collections;
+import java.util.EnumSet;
+import java.util.List;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.Executors;
+import java.util.concurrent.ScheduledExecutorService;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicInteger;
+import java.util.concurrent.atomic.AtomicReference;
+import java.util.logging.Level;
+import java.util.logging.Logger;
+
+/**
+ * Keeps an OCSP response (RFC 6960) for a server certificate fresh so
+ * that it can be stapled to handshakes (RFC 6066 section 8).
+ *
+ * <p>Responses are requested with {@link HTTPClient} from the responder
+ * named in the certificate's Authority Information Access extension
+ * (RFC 5280 section 4.2.2.1), or from a configured responder. Each one
+ * is checked against the issuing certificate with the JDK's PKIX
+ * revocation checker before it is handed to the {@link Listener}, and,
+ * if a cache directory is set, saved there so that a restarted server
+ * can staple from its first handshake. A response that no longer
+ * verifies, because it has expired or the certificate was revoked, is
+ * withdrawn rather than stapled.
+ *
+ * <p>Fetching and scheduling are package-private methods so that tests
+ * can stand in for the responder and the timer.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ * @see <a href="https://www.rfc-editor.org/rfc/rfc6960">RFC 6960</a>
+ */
+class OCSPStapler {
+
+    private static final Logger LOGGER =
+            Logger.getLogger(OCSPStapler.class.getName());
+
+    /** Delay before retrying a failed fetch. */
+    static final long RETRY_INTERVAL = 300000;
+
+    private static final long FETCH_TIMEOUT = 10000;
+    private static final int MAX_RESPONSE_SIZE = 65536;
+
+    // id-pe-authorityInfoAccess
+    private static final String AIA_OID = "1.3.6.1.5.5.7.1.1";
+    // id-ad-ocsp, content octets
+    private static final byte[] ID_AD_OCSP = {
+        0x2b, 0x06, 0x01, 0x05, 0x05, 0x07, 0x30, 0x01
+    };
+    // AlgorithmIdentifier for id-sha1 with NULL parameters
+    private static final byte[] SHA1_ALGORITHM = {
+        0x30, 0x09, 0x06, 0x05, 0x2b, 0x0e, 0x03, 0x02, 0x1a, 0x05, 0x00
+    };
+
+    /**
+     * Receives the response to staple, or null when there is none.
+     */
+    interface Listener {
+
+        void ocspResponseChanged(OCSPStapler source, byte[] response);
+    }
+
+    private final X509Certificate leaf;
+    private final X509Certificate issuer;
+    private final URI responder;
+    private final Path cacheFile;
+    private final long refreshInterval;
+    private final Listener listener;
+
+    private ScheduledExecutorService scheduler;
+    private boolean stopped;
+    private byte[] response;
+
+    /**
+     * Creates a stapler for the first certificate in a PEM chain file,
+     * which must also contain its issuer.
+     *
+     * @param certFile the certificate chain
+     * @param responder the responder URL, or null to use the one in the
+     *        certificate
+     * @param cacheDirectory the directory to save responses in, or null
+     * @param refreshInterval how often to fetch a new response, in
+     *        milliseconds
+     * @param listener receives each verified response
+     * @throws IOException if the chain cannot be read or names no
+     *         responder
+     * @throws GeneralSecurityException if the chain cannot be parsed
+     */
+    OCSPStapler(Path certFile, String responder, Path cacheDirectory,
+                long refreshInterval, Listener listener)
+            throws IOException, GeneralSecurityException {
+        List<X509Certificate> chain = new ArrayList<X509Certificate>();
+        CertificateFactory cf = CertificateFactory.getInstance("X.509");
+        try (InputStream in = Files.newInputStream(certFile)) {
+            Collection<? extends Certificate> certs =
+                    cf.generateCertificates(in);
+            for (Certificate cert : certs) {
+                chain.add((X509Certificate) cert);
+            }
+        }
+        if (chain.size() < 2) {
+            throw new IOException(certFile
+                    + " does not contain the issuer certificate");
+        }
+        this.leaf = chain.get(0);
+        this.issuer = chain.get(1);
+        this.responder = (responder != null)
+                ? URI.create(responder) : ocspResponder(leaf);
+        if (this.responder == null) {
+            throw new IOException(certFile + " names no OCSP responder");
+        }
+        this.cacheFile = (cacheDirectory != null)
+                ? cacheDirectory.resolve(hex(MessageDigest
+                        .getInstance("SHA-256").digest(leaf.getEncoded()))
+                        + ".der")
+                : null;
+        this.refreshInterval = refreshInterval;
+        this.listener = listener;
+    }
+
+    /**
+     * Returns the cached response for the certificate if there is one
+     * and it still verifies, and null otherwise.
+     */
+    synchronized byte[] loadCached() {
+        if (cacheFile == null) {
+            return null;
+        }
+        try {
+            byte[] der = Files.readAllBytes(cacheFile);
+            if (verify(der)) {
+                response = der;
+                return der;
+            }
+        } catch (NoSuchFileException e) {
+            // first start
+        } catch (IOException e) {
+            LOGGER.log(Level.WARNING, "Cannot read " + cacheFile, e);
+        }
+        return null;
+    }
+
+    /**
+     * Starts fetching responses. The first fetch is immediate unless a
+     * cached response was loaded. Does nothing once stopped.
+     */
+    synchronized void start() {
+        if (stopped || scheduler != null) {
+            return;
+        }
+        scheduler = Executors.newSingleThreadScheduledExecutor(
+                new DaemonThreadFactory("OCSPStapler"));
+        schedule((response != null) ? refreshInterval : 0);
+    }
+
+    /**
+     * Stops fetching responses, for good: a stapler that is stopped
+     * before it is started never starts.
+     */
+    synchronized void stop() {
+        stopped = true;
+        if (scheduler != null) {
+            scheduler.shutdownNow();
+            scheduler = null;
+        }
+    }
+
+    synchronized boolean isStarted() {
+        return scheduler != null;
+    }
+
+    synchronized void schedule(long delay) {
+        if (scheduler == null) {
+            return;
+        }
+        scheduler.schedule(new Runnable() {
+            @Override
+            public void run() {
+                refresh();
+            }
+        }, delay, TimeUnit.MILLISECONDS);
+    }
+
+    void refresh() {
+        byte[] der = null;
+        try {
+            der = fetch(encodeRequest());
+        } catch (InterruptedIOException e) {
+            return;
+        } catch (IOException e) {
+            LOGGER.log(Level.WARNING, "OCSP request to " + responder
+                    + " failed", e);
+        } catch (GeneralSecurityException e) {
+            LOGGER.log(Level.WARNING, "Cannot build OCSP request", e);
+        }
+        if (der != null && verify(der)) {
+            update(der);
+            save(der);
+            schedule(refreshInterval);
+            return;
+        }
+        byte[] current;
+        synchronized (this) {
+            current = response;
+        }
+        if (current != null && !verify(current)) {
+            LOGGER.warning("Withdrawing OCSP response for "
+                    + leaf.getSubjectX500Principal());
+            update(null);
+        }
+        schedule(RETRY_INTERVAL);
+    }
+
+    private void update(byte[] der) {
+        synchronized (this) {
+            response = der;
+        }
+        listener.ocspResponseChanged(this, der);
+        if (der != null && LOGGER.isLoggable(Level.FINE)) {
+            LOGGER.fine("Stapling new OCSP response for "
+                    + leaf.getSubjectX500Principal());
+        }
+    }
+
+    private void save(byte[] der) {
+        if (cacheFile == null) {
+            return;
+        }
+        try {
+            Files.createDirectories(cacheFile.getParent());
+            Path tmp = cacheFile.resolveSibling(
+                    cacheFile.getFileName() + ".tmp");
+            Files.write(tmp, der);
+            Files.move(tmp, cacheFile, StandardCopyOption.REPLACE_EXISTING,
+                    StandardCopyOption.ATOMIC_MOVE);
+        } catch (IOException e) {
+            LOGGER.log(Level.WARNING, "Cannot write " + cacheFile, e);
+        }
+    }
+
+    // ── Verification ──
+
+    /**
+     * Checks a response with the PKIX revocation checker: it must be
+     * signed by the issuer or a responder it delegated to, be current,
+     * and report the certificate as good.
+     */
+    boolean verify(byte[] der) {
+        try {
+            CertPathValidator validator =
+                    CertPathValidator.getInstance("PKIX");
+            PKIXRevocationChecker checker =
+                    (PKIXRevocationChecker) validator.getRevocationChecker();
+            checker.setOptions(EnumSet.of(
+                    PKIXRevocationChecker.Option.ONLY_END_ENTITY,
+                    PKIXRevocationChecker.Option.NO_FALLBACK));
+            checker.setOcspResponder(responder);
+            checker.setOcspResponses(
+                    Collections.<X509Certificate, byte[]>singletonMap(
+                            leaf, der));
+            PKIXParameters params = new PKIXParameters(
+                    Collections.singleton(new TrustAnchor(issuer, null)));
+            params.setRevocationEnabled(false);
+            params.addCertPathChecker(checker);
+            CertPath path = CertificateFactory.getInstance("X.509")
+                    .generateCertPath(
+                            Collections.<Certificate>singletonList(leaf));
+            validator.validate(path, params);
+            return true;
+        } catch (CertPathValidatorException e) {
+            if (e.getReason()
+                    == CertPathValidatorException.BasicReason.REVOKED) {
+                LOGGER.severe("Certificate "
+                        + leaf.getSubjectX500Principal()
+                        + " has been revoked");
+            } else if (LOGGER.isLoggable(Level.FINE)) {
+                LOGGER.log(Level.FINE, "Rejected OCSP response", e);
+            }
+            return false;
+        } catch (GeneralSecurityException e) {
+            LOGGER.log(Level.WARNING, "Cannot verify OCSP response", e);
+            return false;
+        }
+    }
+
+    // ── Fetch ──
+
+    /**
+     * POSTs a request to the responder (RFC 6960 appendix A.1) and
+     * returns the response body.
+     */
+    byte[] fetch(final byte[] request) throws IOException {
+        boolean secure = "https".equalsIgnoreCase(responder.getScheme());
+        int port = responder.getPort();
+        if (port < 0) {
+            port = secure ? 443 : 80;
+        }
+        String rawPath = responder.getRawPath();
+        if (rawPath == null || rawPath.isEmpty()) {
+            rawPath = "/";
+        }
+        if (responder.getRawQuery() != null) {
+            rawPath = rawPath + "?" + responder.getRawQuery();
+        }
+        final String path = rawPath;
+        final HTTPClient client = new HTTPClient(responder.getHost(), port);
+        client.setSecure(secure);
+        final CountDownLatch latch = new CountDownLatch(1);
+        final AtomicInteger status = new AtomicInteger();
+        final AtomicReference<Exception> error =
+                new AtomicReference<Exception>();
+        final ByteArrayOutputStream body = new ByteArrayOutputStream();
+        final DefaultHTTPResponseHandler responseHandler =
+                new DefaultHTTPResponseHandler() {
+
+            @Override
+            public void ok(HTTPResponse response) {
+                status.set(response.getStatus().code);
+            }
+
+            @Override
+            public void error(HTTPResponse response) {
+                status.set(response.getStatus().code);
+            }
+
+            @Override
+            public void responseBodyContent(ByteBuffer data) {
+                int len = data.remaining();
+                if (body.size() + len > MAX_RESPONSE_SIZE) {
+                    error.compareAndSet(null,
+                            new IOException("OCSP response too large"));
+                    data.position(data.limit());
+                    return;
+                }
+                byte[] buf = new byte[len];
+                data.get(buf);
+                body.write(buf, 0, len);
+            }
+
+            @Override
+            public void close() {
+                latch.countDown();
+            }
+
+            @Override
+            public void failed(Exception ex) {
+                error.compareAndSet(null, ex);
+                latch.countDown();
+            }
+        };
+        try {
+            client.connect(new HTTPClientHandler() {
+
+                @Override
+                public void onConnected(Endpoint endpoint) {
+                    HTTPRequest req = client.post(path);
+                    req.header("Content-Type", "application/ocsp-request");
+                    req.header("Accept", "application/ocsp-response");
+                    req.startRequestBody(responseHandler);
+                    req.requestBodyContent(ByteBuffer.wrap(request));
+                    req.endRequestBody();
+                }
+
+                @Override
+                public void onError(Exception cause) {
+                    error.compareAndSet(null, cause);
+                    latch.countDown();
+                }
+
+                @Override
+                public void onDisconnected() {
+                    latch.countDown();
+                }
+
+                @Override
+                public void onSecurityEstablished(SecurityInfo info) {
+                }
+            });
+            if (!latch.await(FETCH_TIMEOUT, TimeUnit.MILLISECONDS)) {
+                throw new IOException("Timed out");
+            }
+        } catch (InterruptedException e) {
+            Thread.currentThread().interrupt();
+            throw new InterruptedIOException();
+        } finally {
+            client.close();
+        }
+        Exception cause = error.get();
+        if (cause != null) {
+            throw (cause instanceof IOException)
+                    ? (IOException) cause : new IOException(cause);
+        }
+        if (status.get() != 200) {
+            throw new IOException("HTTP status " + status.get());
+        }
+        return body.toByteArray();
+    }
+
+    // ── DER ──
+
+    /**
+     * Encodes an OCSPRequest (RFC 6960 section 4.1.1) for the
+     * certificate, with a SHA-1 CertID as responders expect.
+     */
+    byte[] encodeRequest() throws GeneralSecurityException,
+            IOException {
+        MessageDigest sha1 = MessageDigest.getInstance("SHA-1");
+        byte[] nameHash = sha1.digest(
+                issuer.getSubjectX500Principal().getEncoded());
+        byte[] keyHash = sha1.digest(
+                subjectPublicKey(issuer.getPublicKey().getEncoded()));
+        byte[] certId = der(0x30, SHA1_ALGORITHM,
+                der(0x04, nameHash),
+                der(0x04, keyHash),
+                der(0x02, leaf.getSerialNumber().toByteArray()));
+        // OCSPRequest { TBSRequest { requestList { Request { CertID } } } }
+        return der(0x30, der(0x30, der(0x30, der(0x30, certId))));
+    }
+
+    /**
+     * Returns the bits of the subjectPublicKey BIT STRING in a
+     * SubjectPublicKeyInfo, which is what the CertID key hash covers.
+     */
+    private static byte[] subjectPublicKey(byte[] spki) throws IOException {
+        int[] seq = element(spki, 0);
+        int[] algorithm = element(spki, seq[1]);
+        int[] bits = element(spki, algorithm[1] + algorithm[2]);
+        if (bits[0] != 0x03 || bits[2] < 1) {
+            throw new IOException("Malformed SubjectPublicKeyInfo");
+        }
+        byte[] key = new byte[bits[2] - 1];
+        System.arraycopy(spki, bits[1] + 1, key, 0, key.length);
+        return key;
+    }
+
+    /**
+     * Returns the first OCSP URI in the certificate's Authority
+     * Information Access extension, or null.
+     */
+    static URI ocspResponder(X509Certificate cert) throws IOException {
+        byte[] ext = cert.getExtensionValue(AIA_OID);
+        if (ext == null) {
+            return null;
+        }
+        int[] octets = element(ext, 0);
+        int[] seq = element(ext, octets[1]);
+        int pos = seq[1];
+        int end = seq[1] + seq[2];
+        while (pos < end) {
+            // AccessDescription { accessMethod, accessLocation }
+            int[] ad = element(ext, pos);
+            int[] method = element(ext, ad[1]);
+            int[] location = element(ext, method[1] + method[2]);
+            // accessLocation [6] uniformResourceIdentifier
+            if (method[0] == 0x06 && location[0] == 0x86
+                    && equals(ext, method, ID_AD_OCSP)) {
+                return URI.create(new String(ext, location[1], location[2],
+                        StandardCharsets.US_ASCII));
+            }
+            pos = ad[1] + ad[2];
+        }
+        return null;
+    }
+
+    /**
+     * Returns the tag, content offset and content length of the DER
+     * element at the given offset.
+     */
+    private static int[] element(byte[] der, int off) throws IOException {
+        if (off + 2 > der.length) {
+            throw new IOException("Truncated DER");
+        }
+        int tag = der[off] & 0xff;
+        int len = der[off + 1] & 0xff;
+        int pos = off + 2;
+        if (len > 0x7f) {
+            int n = len & 0x7f;
+            if (n == 0 || n > 3 || pos + n > der.length) {
+                throw new IOException("Invalid DER length");
+            }
+            len = 0;
+            for (int i = 0; i < n; i++) {
+                len = (len << 8) | (der[pos++] & 0xff);
+            }
+        }
+        if (pos + len > der.length) {
+            throw new IOException("Truncated DER");
+        }
+        return new int[] { tag, pos, len };
+    }
+
+    private static boolean equals(byte[] der, int[] element, byte[] value) {
+        if (element[2] != value.length) {
+            return false;
+        }
+        for (int i = 0; i < value.length; i++) {
+            if (der[element[1] + i] != value[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** Encodes a DER element from its tag and concatenated contents. */
+    private static byte[] der(int tag, byte[]... contents) {
+        int len = 0;
+        for (byte[] content : contents) {
+            len += content.length;
+        }
+        ByteArrayOutputStream out = new ByteArrayOutputStream(len + 6);
+        out.write(tag);
+        if (len < 0x80) {
+            out.write(len);
+        } else if (len < 0x100) {
+            out.write(0x81);
+            out.write(len);
+        } else if (len < 0x10000) {
+            out.write(0x82);
+            out.write(len >> 8);
+            out.write(len);
+        } else {
+            out.write(0x83);
+            out.write(len >> 16);
+            out.write(len >> 8);
+            out.write(len);
+        }
+        for (byte[] content : contents) {
+            out.write(content, 0, content.length);
+        }
+        return out.toByteArray();
+    }
+
+    private static String hex(byte[] bytes) {
+        StringBuilder buf = new StringBuilder(bytes.length * 2);
+        for (byte b : bytes) {
+            buf.append(Character.forDigit((b >> 4) & 0xf, 16));
+            buf.append(Character.forDigit(b & 0xf, 16));
+        }
+        return buf.toString();
+    }
+
+}
@@ -29,7 +29,9 @@ import java.nio.ByteBuffer;
 import java.security.cert.Certificate;
 import java.security.cert.CertificateException;
 import java.security.cert.X509Certificate;
+import java.util.ArrayList;
 import java.util.HashMap;
+import java.util.List;
 import java.util.Map;
 import java.util.logging.Level;
 import java.util.logging.Logger;
@@ -65,12 +67,19 @@ public final class QuicConnection {
     private final long connPtr;
     private final long sslPtr;
     private final InetSocketAddress localAddress;
-    private final InetSocketAddress remoteAddress;
+    private final InetSocketAddress originalRemoteAddress;
     private final long handshakeStartTime;
 
+    // RFC 9000 section 9: the peer's address on the active path, which
+    // changes when it migrates
+    private volatile InetSocketAddress remoteAddress;
+
     private final Map<Long, QuicStreamEndpoint> streams =
             new HashMap<Long, QuicStreamEndpoint>();
 
+    // Connection IDs (hex) under which the engine routes to us
+    private final List<String> connectionIds = new ArrayList<String>(2);
+
     private StreamAcceptHandler streamAcceptHandler;
     private ConnectionReadyHandler connectionReadyHandler;
     private QuicEngine.ConnectionAcceptedHandler
@@ -78,8 +87,23 @@ public final class QuicConnection {
     private ProtocolHandler clientHandler;
     private SecurityInfo securityInfo;
     private TimerHandle timerHandle;
+
+    // RFC 9002 section 7.7: a packet the pacer has not yet released,
+    // and the timer that sends it. Packets after it wait their turn.
+    private ByteBuffer pacedPacket;
+    private byte[] pacedTo;
+    private TimerHandle pacingTimer;
+
     private boolean established;
-    private boolean closed;
+    private boolean earlyData;
+    private boolean draining;
+    private volatile boolean closed;
+
+    // RFC 9000 section 4.6: bidirectional streams the peer still lets us
+    // open. Refreshed on the SelectorLoop, so that other threads (such as
+    // a connection pool choosing a connection) can read it without
+    // touching the quiche_conn, which the loop may be using or freeing.
+    private volatile long peerStreamsLeftBidi;
 
     QuicConnection(QuicEngine engine, long connPtr, long sslPtr,
                    InetSocketAddress localAddress,
@@ -88,6 +112,7 @@ public final class QuicConnection {
         this.connPtr = connPtr;
         this.sslPtr = sslPtr;
         this.localAddress = localAddress;
+        this.originalRemoteAddress = remoteAddress;
         this.remoteAddress = remoteAddress;
         this.handshakeStartTime = System.currentTimeMillis();
     }
@@ -115,12 +140,34 @@ public final class QuicConnection {
     }
 
     /**
-     * Returns the remote address of this connection.
+     * Returns the remote address of this connection. This is the peer's
+     * address on the active path, which changes if the peer migrates
+     * (RFC 9000 section 9).
      */
     public SocketAddress getRemoteAddress() {
         return remoteAddress;
     }
 
+    /**
+     * Returns the address the connection was opened from, before any
+     * migration. Handshake admission accounts against this address.
+     */
+    InetSocketAddress getOriginalRemoteAddress() {
+        return originalRemoteAddress;
+    }
+
+    /**
+     * Called by the engine when quiche has moved the connection to a
+     * validated path with a new peer address.
+     */
+    void peerMigrated(InetSocketAddress address) {
+        if (LOGGER.isLoggable(Level.FINE)) {
+            LOGGER.fine("QUIC connection migrated from " + remoteAddress
+                    + " to " + address);
+        }
+        remoteAddress = address;
+    }
+
     /**
      * Returns security info for this connection.
      */
@@ -129,9 +176,77 @@ public final class QuicConnection {
             securityInfo = new QuicSecurityInfo(connPtr, sslPtr,
                     handshakeStartTime);
         }
+        if (securityInfo == null && earlyData) {
+            // Provisional: resumed parameters, handshake still running
+            return new QuicSecurityInfo(connPtr, sslPtr,
+                    handshakeStartTime);
+        }
         return securityInfo;
     }
 
+    void addConnectionId(String connKey) {
+        connectionIds.add(connKey);
+    }
+
+    void removeConnectionId(String connKey) {
+        connectionIds.remove(connKey);
+    }
+
+    List<String> getConnectionIds() {
+        return connectionIds;
+    }
+
+    /**
+     * Returns the number of bidirectional streams this endpoint may
+     * still open before reaching the peer's MAX_STREAMS limit
+     * (RFC 9000 section 4.6). Returns 0 once the connection is closed.
+     *
+     * <p>This is the value as of the last packet received or stream
+     * opened, so it may be read from any thread.
+     */
+    public long getPeerStreamsLeftBidi() {
+        return peerStreamsLeftBidi;
+    }
+
+    /**
+     * Reads the peer's stream credit from quiche into the value returned
+     * by {@link #getPeerStreamsLeftBidi}. Must be called on the
+     * connection's SelectorLoop thread, after opening a stream.
+     */
+    public void updatePeerStreamsLeftBidi() {
+        if (!closed) {
+            peerStreamsLeftBidi =
+                    GumdropNative.quiche_conn_peer_streams_left_bidi(connPtr);
+        }
+    }
+
+    /**
+     * Returns a snapshot of the active path's statistics, including the
+     * path MTU discovered so far, or null once the connection is closed.
+     * Must be called on the connection's SelectorLoop thread.
+     */
+    public QuicConnectionStats getStats() {
+        if (closed) {
+            return null;
+        }
+        long[] values = GumdropNative.quiche_conn_path_stats(connPtr);
+        return (values != null) ? newStats(values) : null;
+    }
+
+    private QuicConnectionStats newStats(long[] values) {
+        QuicTransportFactory factory = engine.getFactory();
+        return new QuicConnectionStats(values,
+                factory.getMaxConnectionWindow(),
+                factory.getMaxStreamWindow());
+    }
+
+    /**
+     * Returns whether the QUIC handshake has completed.
+     */
+    public boolean isEstablished() {
+        return established;
+    }
+
     void setStreamAcceptHandler(StreamAcceptHandler handler) {
         this.streamAcceptHandler = handler;
     }
@@ -174,6 +289,14 @@ public final class QuicConnection {
          * The handler should poll for application-level events.
          */
         void onConnectionReady();
+
+        /**
+         * Called when the server is going away and the connection should
+         * finish what it has in hand without starting anything new. It
+         * stays open until the peer closes it or it times out.
+         */
+        default void onDrain() {
+        }
     }
 
     /**
@@ -185,6 +308,27 @@ public final class QuicConnection {
         this.connectionReadyHandler = handler;
     }
 
+    /**
+     * Asks the connection to drain, for a graceful upgrade. A handler
+     * installed later should check {@link #isDraining}.
+     */
+    void drain() {
+        if (draining || closed) {
+            return;
+        }
+        draining = true;
+        if (connectionReadyHandler != null) {
+            connectionReadyHandler.onDrain();
+        }
+    }
+
+    /**
+     * Returns whether the server has asked this connection to drain.
+     */
+    public boolean isDraining() {
+        return draining;
+    }
+
     /**
      * Processes readable streams after a packet is fed to quiche.
      * Called by QuicEngine on the SelectorLoop thread.
@@ -207,6 +351,7 @@ public final class QuicConnection {
                     LOGGER.fine("QUIC connection established: "
                             + remoteAddress);
                 }
+                handshakeCompleted();
                 scheduleTimeout();
                 notifyClientHandshakeComplete();
                 if (connectionReadyHandler != null) {
@@ -217,13 +362,66 @@ public final class QuicConnection {
         }
     }
 
+    /**
+     * Checks whether a client connection resuming a session can already
+     * send application data. Per RFC 9001 section 4.6.1, 0-RTT keys are
+     * available as soon as the ClientHello carrying the ticket is sent,
+     * so the waiting handler is notified now rather than after the
+     * handshake; its first request then costs no round trip. Not done
+     * when the server certificate is pinned, since that is checked
+     * against the completed handshake.
+     */
+    void checkEarlyData() {
+        if (established || earlyData) {
+            return;
+        }
+        if (engine.getFactory().getPinnedCertFingerprint() != null) {
+            return;
+        }
+        if (GumdropNative.quiche_conn_is_in_early_data(connPtr)) {
+            earlyData = true;
+            if (LOGGER.isLoggable(Level.FINE)) {
+                LOGGER.fine("QUIC connection to " + remoteAddress
+                        + " in 0-RTT");
+            }
+            notifyClientHandshakeComplete();
+        }
+    }
+
+    /**
+     * Updates factory state when the handshake completes. RFC 8879:
+     * counts how the certificate of a full handshake was exchanged;
+     * resumed handshakes send no certificate.
+     */
+    private void handshakeCompleted() {
+        engine.connectionEstablished(this);
+        QuicTransportFactory factory = engine.getFactory();
+        factory.handshakeFinished(sslPtr);
+        if (!GumdropNative.ssl_session_reused(sslPtr)) {
+            factory.recordCertificateCompression(
+                    GumdropNative.ssl_get_cert_compression(sslPtr));
+        }
+    }
+
+    /**
+     * Returns whether this client connection sent application data in
+     * 0-RTT before the handshake completed. Whether the server accepted
+     * it is reported by {@link SecurityInfo#isEarlyDataAccepted()}.
+     */
+    public boolean isEarlyData() {
+        return earlyData;
+    }
+
     // RFC 9000 section 2.1 — bidirectional and unidirectional stream types
     void processReadableStreams(ByteBuffer streamBuf) {
+        // The packet may have carried MAX_STREAMS
+        updatePeerStreamsLeftBidi();
         if (!established) {
             boolean nowEstablished =
                     GumdropNative.quiche_conn_is_established(connPtr);
             if (nowEstablished) {
                 established = true;
+                handshakeCompleted();
                 scheduleTimeout();
                 notifyClientHandshakeComplete();
             }
@@ -285,6 +483,9 @@ public final class QuicConnection {
             return;
         }
 
+        // In 0-RTT the credit comes from the remembered transport
+        // parameters (RFC 9000 section 7.4.1)
+        updatePeerStreamsLeftBidi();
         if (clientConnectionAcceptedHandler != null) {
             QuicEngine.ConnectionAcceptedHandler ch =
                     clientConnectionAcceptedHandler;
@@ -431,6 +632,55 @@ public final class QuicConnection {
         }
     }
 
+    /**
+     * Holds a packet the pacer releases after delayMs, copied from buf,
+     * and schedules the flush that sends it.
+     */
+    void holdPacket(ByteBuffer buf, byte[] to, long delayMs) {
+        if (pacedPacket == null || pacedPacket.capacity() < buf.remaining()) {
+            pacedPacket = ByteBuffer.allocateDirect(buf.capacity());
+        }
+        pacedPacket.clear();
+        pacedPacket.put(buf);
+        pacedPacket.flip();
+        if (pacedTo == null) {
+            pacedTo = new byte[to.length];
+        }
+        System.arraycopy(to, 0, pacedTo, 0, to.length);
+        pacingTimer = engine.scheduleTimer(delayMs, new Runnable() {
+            @Override
+            public void run() {
+                pacingTimer = null;
+                if (!closed) {
+                    engine.releasePacket(QuicConnection.this);
+                }
+            }
+        });
+    }
+
+    /** Returns whether a paced packet is waiting for its release time. */
+    boolean isPacing() {
+        return pacingTimer != null;
+    }
+
+    /** Returns the held packet, or null, for the release flush. */
+    ByteBuffer getPacedPacket() {
+        return pacedPacket;
+    }
+
+    /** Returns the encoded address the held packet is sent to. */
+    byte[] getPacedDestination() {
+        return pacedTo;
+    }
+
+    /** Forgets the held packet once it has been sent or dropped. */
+    void clearPacedPacket() {
+        if (pacingTimer != null) {
+            pacingTimer.cancel();
+            pacingTimer = null;
+        }
+    }
+
     private void onTimeout() {
         if (closed) {
             return;
@@ -453,10 +703,14 @@ public final class QuicConnection {
             return;
         }
         closed = true;
+        peerStreamsLeftBidi = 0;
 
         if (timerHandle != null) {
             timerHandle.cancel();
         }
+        // The CONNECTION_CLOSE goes out now, unpaced
+        clearPacedPacket();
+        pacedPacket = null;
 
         // RFC 9000 section 10.2: send CONNECTION_CLOSE with appropriate
         // error code. Use H3_NO_ERROR (0x100) if an h3 handler is
@@ -475,10 +729,31 @@ public final class QuicConnection {
         }
         streams.clear();
 
+        if (LOGGER.isLoggable(Level.FINE)) {
+            long[] values = GumdropNative.quiche_conn_path_stats(connPtr);
+            if (values != null) {
+                LOGGER.fine("QUIC connection to " + remoteAddress
+                        + " closed: " + newStats(values));
+            }
+        }
+        engine.getFactory().handshakeFinished(sslPtr);
         GumdropNative.quiche_conn_free(connPtr);
+        engine.connectionClosed(this);
+
+        // Client handshake never completed
+        if (clientConnectionAcceptedHandler != null) {
+            QuicEngine.ConnectionAcceptedHandler ch =
+                    clientConnectionAcceptedHandler;
+            clientConnectionAcceptedHandler = null;
+            ch.connectionFailed(this);
+        }
     }
 
-    boolean isClosed() {
+    /**
+     * Returns whether this connection has been closed and its native
+     * state freed.
+     */
+    public boolean isClosed() {
         return closed;
     }
 }
@@ -0,0 +1,219 @@
+/*
+ * QuicConnectionStats.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+/**
+ * A snapshot of the statistics of a QUIC connection's active path, as
+ * reported by quiche.
+ *
+ * <p>{@link #getPmtu} is the path MTU confirmed by packetization layer
+ * path MTU discovery (RFC 8899), expressed as the largest UDP payload
+ * that has reached the peer; without discovery it stays at the initial
+ * 1200 bytes. {@link #getMaxSendUdpPayloadSize} is what the connection
+ * actually sends with, which also respects the peer's
+ * max_udp_payload_size transport parameter (RFC 9000 section 18.2).
+ *
+ * <p>quiche grows its receive windows while the application keeps up,
+ * up to the ceilings reported by {@link #getMaxConnectionWindow} and
+ * {@link #getMaxStreamWindow}, but does not report their current size;
+ * the send side is bounded by the peer's advertised initial limits
+ * (RFC 9000 section 4) and whatever MAX_DATA updates followed.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ * @see QuicConnection#getStats
+ */
+public final class QuicConnectionStats {
+
+    private final long rtt;
+    private final long minRtt;
+    private final long rttVar;
+    private final long congestionWindow;
+    private final long pmtu;
+    private final long deliveryRate;
+    private final long packetsSent;
+    private final long packetsReceived;
+    private final long packetsLost;
+    private final long packetsRetransmitted;
+    private final long bytesSent;
+    private final long bytesReceived;
+    private final long bytesLost;
+    private final long maxSendUdpPayloadSize;
+    private final long peerInitialMaxData;
+    private final long peerInitialMaxStreamDataBidiLocal;
+    private final long peerInitialMaxStreamDataBidiRemote;
+    private final long bytesInFlight;
+    private final long maxConnectionWindow;
+    private final long maxStreamWindow;
+
+    /**
+     * @param values the array from
+     *        {@link org.bluezoo.gumdrop.GumdropNative#quiche_conn_path_stats}
+     * @param maxConnectionWindow the connection receive window ceiling
+     * @param maxStreamWindow the stream receive window ceiling
+     */
+    QuicConnectionStats(long[] values, long maxConnectionWindow,
+                        long maxStreamWindow) {
+        rtt = values[0];
+        minRtt = values[1];
+        rttVar = values[2];
+        congestionWindow = values[3];
+        pmtu = values[4];
+        deliveryRate = values[5];
+        packetsSent = values[6];
+        packetsReceived = values[7];
+        packetsLost = values[8];
+        packetsRetransmitted = values[9];
+        bytesSent = values[10];
+        bytesReceived = values[11];
+        bytesLost = values[12];
+        maxSendUdpPayloadSize = values[13];
+        peerInitialMaxData = values[14];
+        peerInitialMaxStreamDataBidiLocal = values[15];
+        peerInitialMaxStreamDataBidiRemote = values[16];
+        bytesInFlight = values[17];
+        this.maxConnectionWindow = maxConnectionWindow;
+        this.maxStreamWindow = maxStreamWindow;
+    }
+
+    /** Returns the smoothed round-trip time in nanoseconds. */
+    public long getRtt() {
+        return rtt;
+    }
+
+    /** Returns the minimum round-trip time in nanoseconds. */
+    public long getMinRtt() {
+        return minRtt;
+    }
+
+    /** Returns the round-trip time variation in nanoseconds. */
+    public long getRttVar() {
+        return rttVar;
+    }
+
+    /** Returns the congestion window in bytes. */
+    public long getCongestionWindow() {
+        return congestionWindow;
+    }
+
+    /** Returns the path MTU in bytes, as a UDP payload size. */
+    public long getPmtu() {
+        return pmtu;
+    }
+
+    /** Returns the estimated delivery rate in bytes per second. */
+    public long getDeliveryRate() {
+        return deliveryRate;
+    }
+
+    /** Returns the number of QUIC packets sent. */
+    public long getPacketsSent() {
+        return packetsSent;
+    }
+
+    /** Returns the number of QUIC packets received. */
+    public long getPacketsReceived() {
+        return packetsReceived;
+    }
+
+    /** Returns the number of QUIC packets declared lost. */
+    public long getPacketsLost() {
+        return packetsLost;
+    }
+
+    /** Returns the number of packets carrying retransmitted data. */
+    public long getPacketsRetransmitted() {
+        return packetsRetransmitted;
+    }
+
+    /** Returns the number of bytes sent. */
+    public long getBytesSent() {
+        return bytesSent;
+    }
+
+    /** Returns the number of bytes received. */
+    public long getBytesReceived() {
+        return bytesReceived;
+    }
+
+    /** Returns the number of bytes declared lost. */
+    public long getBytesLost() {
+        return bytesLost;
+    }
+
+    /** Returns the largest UDP payload the connection currently sends. */
+    public long getMaxSendUdpPayloadSize() {
+        return maxSendUdpPayloadSize;
+    }
+
+    /**
+     * Returns the connection-level send limit the peer advertised in its
+     * transport parameters, or 0 if they have not arrived.
+     */
+    public long getPeerInitialMaxData() {
+        return peerInitialMaxData;
+    }
+
+    /**
+     * Returns the send limit the peer advertised for bidirectional
+     * streams it opens.
+     */
+    public long getPeerInitialMaxStreamDataBidiLocal() {
+        return peerInitialMaxStreamDataBidiLocal;
+    }
+
+    /**
+     * Returns the send limit the peer advertised for bidirectional
+     * streams this endpoint opens.
+     */
+    public long getPeerInitialMaxStreamDataBidiRemote() {
+        return peerInitialMaxStreamDataBidiRemote;
+    }
+
+    /**
+     * Returns the bytes sent but neither acknowledged nor declared lost,
+     * which quiche holds for retransmission.
+     */
+    public long getBytesInFlight() {
+        return bytesInFlight;
+    }
+
+    /** Returns the ceiling for the connection receive window. */
+    public long getMaxConnectionWindow() {
+        return maxConnectionWindow;
+    }
+
+    /** Returns the ceiling for each stream's receive window. */
+    public long getMaxStreamWindow() {
+        return maxStreamWindow;
+    }
+
+    @Override
+    public String toString() {
+        return "rtt=" + (rtt / 1000) + "us cwnd=" + congestionWindow
+                + " pmtu=" + pmtu
+                + " max_udp_payload=" + maxSendUdpPayloadSize
+                + " sent=" + packetsSent + " recv=" + packetsReceived
+                + " lost=" + packetsLost
+                + " peer_max_data=" + peerInitialMaxData;
+    }
+
+}
@@ -25,11 +25,14 @@ import org.bluezoo.gumdrop.GumdropNative;
 import org.bluezoo.util.ByteArrays;
 
 import java.io.IOException;
+import java.net.InetAddress;
 import java.net.InetSocketAddress;
+import java.net.UnknownHostException;
 import java.security.SecureRandom;
 import java.nio.ByteBuffer;
 import java.nio.channels.DatagramChannel;
 import java.nio.channels.SelectionKey;
+import java.util.ArrayList;
 import java.util.HashMap;
 import java.util.Iterator;
 import java.util.Map;
@@ -66,8 +69,11 @@ import org.bluezoo.gumdrop.telemetry.Trace;
  * connections.
  *
  * <p>Each QuicEngine has one underlying DatagramChannel (bound to a local
- * port for servers, or connected to a single remote for clients). Multiple
- * QUIC connections can be multiplexed over this single UDP socket.
+ * port for servers, or to an ephemeral port for clients). Multiple QUIC
+ * connections are multiplexed over this single UDP socket and
+ * demultiplexed by destination connection ID in both modes; a client
+ * engine may hold connections to any number of remote peers (see
+ * {@link #connect(InetSocketAddress, ConnectionAcceptedHandler, String)}).
  *
  * <p>QuicEngine also implements {@link MultiplexedEndpoint} by delegating
  * to a client-mode QuicConnection, allowing protocol handlers to open
@@ -88,10 +94,37 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
     /** Maximum QUIC connection ID length per RFC 9000 section 5.1. */
     private static final int MAX_CONN_ID_LEN = 20;
 
+    /** RFC 9000 section 14.1: smallest datagram carrying a client Initial. */
+    private static final int MIN_INITIAL_DATAGRAM_SIZE = 1200;
+
+    /** RFC 9000 section 20.1: CONNECTION_REFUSED transport error. */
+    private static final long CONNECTION_REFUSED = 0x02;
+
+    /** RFC 9000 section 10.3: length of a stateless reset token. */
+    private static final int RESET_TOKEN_LEN = 16;
+
+    /**
+     * RFC 9002 section 7.7: a packet due within this many nanoseconds
+     * is sent at once, since timers cannot release it more precisely.
+     */
+    private static final long PACING_GRANULARITY_NS = 1000000L;
+
+    /** Longest encoded address: family, port and an IPv6 address. */
+    private static final int MAX_ADDRESS_LEN = 19;
+
     private final QuicTransportFactory factory;
     private final boolean serverMode;
 
+    // Server-side: handshake budget, or null if unlimited
+    private final HandshakeAdmission admission;
+
+    // Source of the connection IDs we issue, or null for random IDs,
+    // and their length, which short headers do not carry
+    private final ConnectionIdGenerator connectionIdGenerator;
+    private final int connectionIdLength;
+
     private DatagramChannel channel;
+    private InetSocketAddress localAddress;
     private SelectionKey selectionKey;
     private SelectorLoop selectorLoop;
 
@@ -100,11 +133,26 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
     private ByteBuffer sendBuf;
     private ByteBuffer streamBuf;
 
+    // Reusable arrays for the path addresses quiche reports
+    private final byte[] sendTo = new byte[MAX_ADDRESS_LEN];
+    private final byte[] sendFrom = new byte[MAX_ADDRESS_LEN];
+    private final byte[] pathLocal = new byte[MAX_ADDRESS_LEN];
+    private final byte[] pathPeer = new byte[MAX_ADDRESS_LEN];
+
+    // Kernel receive timestamps: the sender and the delay of each read
+    private boolean receiveTimestamps;
+    private final byte[] recvFrom = new byte[MAX_ADDRESS_LEN];
+    private final long[] recvDelay = new long[1];
+
+    // Nanoseconds until the pacer releases the packet just written
+    private final long[] sendDelay = new long[1];
+
     // Connection map: connection ID (as hex string) -> QuicConnection
     private final Map<String, QuicConnection> connections =
             new HashMap<String, QuicConnection>();
 
-    // For client mode: the single outbound connection
+    // For client mode: the connection used by the MultiplexedEndpoint
+    // methods (the first one opened that is still live)
     private QuicConnection clientConnection;
 
     // Server-side: handler factory for new connections
@@ -113,6 +161,20 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
     // Connection-level accept handler (used by HTTP/3)
     private ConnectionAcceptedHandler connectionAcceptedHandler;
 
+    // Graceful upgrade. Once our socket is handed to a new process we
+    // read the packets it forwards from a loopback channel instead; in
+    // the new process, packets for connections the previous one still
+    // owns are forwarded to it until it exits
+    private DatagramChannel recvChannel;
+    private DatagramChannel forwardChannel;
+    private volatile InetSocketAddress forwardAddress;
+
+    // Read by QuicHandoff while the previous process drains
+    private volatile int liveConnections;
+
+    // Bytes in flight over all connections, sampled for NativeMemory
+    private volatile long bufferedBytes;
+
     private Trace trace;
     private boolean closing;
 
@@ -125,6 +187,10 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
     QuicEngine(QuicTransportFactory factory, boolean serverMode) {
         this.factory = factory;
         this.serverMode = serverMode;
+        this.admission = serverMode ? factory.newHandshakeAdmission() : null;
+        this.connectionIdGenerator = factory.getConnectionIdGenerator();
+        this.connectionIdLength = (connectionIdGenerator != null)
+                ? connectionIdGenerator.getLength() : MAX_CONN_ID_LEN;
     }
 
     QuicTransportFactory getFactory() {
@@ -138,11 +204,42 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
      * @param channel the datagram channel
      */
     void init(DatagramChannel channel) {
+        init(channel, null);
+    }
+
+    /**
+     * Initialises the engine with a channel whose local address the
+     * channel itself may not know, as when its socket was inherited from
+     * another process.
+     *
+     * @param channel the datagram channel
+     * @param localAddress the address the socket is bound to, or null to
+     *        ask the channel
+     */
+    void init(DatagramChannel channel, InetSocketAddress localAddress) {
         this.channel = channel;
-        int maxPayload = 1350;
+        this.recvChannel = channel;
+        if (localAddress == null) {
+            try {
+                localAddress = (InetSocketAddress) channel.getLocalAddress();
+            } catch (IOException e) {
+                localAddress = new InetSocketAddress("localhost", 0);
+            }
+        }
+        this.localAddress = localAddress;
+        if (factory.isReceiveTimestamps()) {
+            receiveTimestamps =
+                    GumdropNative.udp_enable_rx_timestamps(channel) == 0;
+            if (!receiveTimestamps && LOGGER.isLoggable(Level.FINE)) {
+                LOGGER.fine("Receive timestamps unsupported on "
+                        + localAddress);
+            }
+        }
         this.recvBuf = ByteBuffer.allocateDirect(65535);
-        this.sendBuf = ByteBuffer.allocateDirect(maxPayload);
+        this.sendBuf = ByteBuffer.allocateDirect(
+                factory.getMaxUdpPayloadSize());
         this.streamBuf = ByteBuffer.allocateDirect(65535);
+        NativeMemory.engineOpened(this);
     }
 
     // ── ChannelHandler implementation ──
@@ -183,7 +280,11 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
 
         InetSocketAddress source;
         try {
-            source = (InetSocketAddress) channel.receive(recvBuf);
+            if (receiveTimestamps && recvChannel == channel) {
+                source = receiveTimestamped();
+            } else {
+                source = (InetSocketAddress) recvChannel.receive(recvBuf);
+            }
         } catch (IOException e) {
             LOGGER.log(Level.WARNING, "Error receiving QUIC packet", e);
             return;
@@ -194,6 +295,13 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
         }
 
         recvBuf.flip();
+        if (recvChannel != channel) {
+            // Forwarded by the process our socket was handed to
+            source = unwrapForwarded(recvBuf);
+            if (source == null) {
+                return;
+            }
+        }
         int len = recvBuf.remaining();
 
         if (len == 0) {
@@ -208,7 +316,8 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
         }
 
         // Parse QUIC header to extract version, DCID, SCID, and token
-        byte[] headerInfo = GumdropNative.quiche_header_info(recvBuf, len);
+        byte[] headerInfo = GumdropNative.quiche_header_info(
+                recvBuf, len, connectionIdLength);
         if (headerInfo == null) {
             LOGGER.severe("Failed to parse QUIC header from " + source
                     + " (" + len + " bytes, "
@@ -239,8 +348,10 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
         System.arraycopy(headerInfo, off, peerScid, 0, scidLen);
         off += scidLen;
 
-        // token (not used yet, but parsed for completeness)
-        // int tokenLen = headerInfo[off] & 0xFF;
+        int tokenLen = headerInfo[off] & 0xFF;
+        off += 1;
+        byte[] token = new byte[tokenLen];
+        System.arraycopy(headerInfo, off, token, 0, tokenLen);
 
         if (LOGGER.isLoggable(Level.FINEST)) {
             LOGGER.finest("Parsed header: version=0x"
@@ -252,6 +363,22 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
         String connKey = ByteArrays.toHexString(dcid);
         QuicConnection conn = connections.get(connKey);
 
+        if (conn == null && forwardAddress != null
+                && !isInitial(recvBuf.get(0), version)) {
+            // Graceful upgrade: new connections are ours, anything else
+            // belongs to one the previous process is draining
+            forward(len, source);
+            return;
+        }
+
+        if (conn == null && recvChannel != channel) {
+            if (LOGGER.isLoggable(Level.FINE)) {
+                LOGGER.fine("Dropped forwarded datagram from " + source
+                        + " for unknown connection " + connKey);
+            }
+            return;
+        }
+
         if (conn == null && serverMode) {
             if (!factory.isVersionSupported(version)) {
                 if (LOGGER.isLoggable(Level.FINE)) {
@@ -264,12 +391,47 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
                 return;
             }
 
+            // RFC 9000 section 14.1: only an Initial in a full-sized
+            // datagram can open a connection
+            if (!isInitial(recvBuf.get(0), version)
+                    || len < MIN_INITIAL_DATAGRAM_SIZE) {
+                if (LOGGER.isLoggable(Level.FINE)) {
+                    LOGGER.fine("Dropped " + len + " byte datagram from "
+                            + source + " for unknown connection " + connKey);
+                }
+                return;
+            }
+
+            if (factory.isNativeMemoryExhausted()) {
+                sendRefusal(peerScid, dcid, version, source,
+                        "Native memory limit reached");
+                return;
+            }
+
+            byte[] odcid = null;
+            if (admission != null) {
+                if (tokenLen > 0) {
+                    odcid = admission.validateRetryToken(token, source, dcid);
+                }
+                switch (admission.admit(source.getAddress(), odcid != null)) {
+                    case RETRY:
+                        sendRetry(peerScid, dcid, version, source);
+                        return;
+                    case REFUSE:
+                        sendRefusal(peerScid, dcid, version, source,
+                                "Handshake budget exhausted");
+                        return;
+                    default:
+                        break;
+                }
+            }
+
             if (LOGGER.isLoggable(Level.FINE)) {
                 LOGGER.fine("Received QUIC Initial packet from " + source
                         + ", version=0x" + Integer.toHexString(version)
                         + ", attempting to accept connection");
             }
-            conn = acceptConnection(dcid, version, source);
+            conn = acceptConnection(dcid, odcid, version, source);
             if (conn == null) {
                 if (LOGGER.isLoggable(Level.WARNING)) {
                     LOGGER.warning("Failed to accept QUIC connection from "
@@ -311,6 +473,13 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
                     + " header, dcid=" + connKey);
         }
 
+        // RFC 9000 section 9: follow the peer to a new address, and
+        // keep it supplied with connection IDs to migrate with
+        processPathEvents(conn);
+        if (serverMode && conn.isEstablished()) {
+            updateConnectionIds(conn);
+        }
+
         // Process readable streams
         conn.processReadableStreams(streamBuf);
 
@@ -341,8 +510,88 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
         sendBuf.clear();
         int written = GumdropNative.quiche_negotiate_version(
                 peerScid, dcid, sendBuf, sendBuf.capacity());
+        sendStateless(written, dest, "Version Negotiation");
+    }
+
+    /**
+     * Asks a client to prove its address before it is given a
+     * connection (RFC 9000 section 8.1.2). The client repeats its
+     * Initial to a new connection ID, with a token that lets the
+     * connection be created without having kept any state.
+     */
+    private void sendRetry(byte[] peerScid, byte[] dcid, int version,
+                           InetSocketAddress dest) {
+        byte[] retryScid = generateConnectionId();
+        byte[] token = admission.retryToken(dest, dcid, retryScid);
+        sendBuf.clear();
+        int written = GumdropNative.quiche_retry(peerScid, dcid, retryScid,
+                token, version, sendBuf, sendBuf.capacity());
+        sendStateless(written, dest, "Retry");
+    }
+
+    /**
+     * Refuses a connection attempt that does not fit the handshake
+     * budget, or the native memory limit, with a stateless
+     * CONNECTION_CLOSE.
+     */
+    private void sendRefusal(byte[] peerScid, byte[] dcid, int version,
+                             InetSocketAddress dest, String reason) {
+        if (LOGGER.isLoggable(Level.FINE)) {
+            LOGGER.fine(reason + ", refusing " + dest);
+        }
+        sendBuf.clear();
+        int written = GumdropNative.quic_refuse_connection(peerScid, dcid,
+                version, CONNECTION_REFUSED, sendBuf, sendBuf.capacity());
+        sendStateless(written, dest, "CONNECTION_CLOSE");
+    }
+
+    /**
+     * Receives a datagram into recvBuf, as DatagramChannel.receive
+     * would, and reports how long it waited since the kernel stamped it.
+     *
+     * @return the sender, or null if no datagram was waiting
+     */
+    private InetSocketAddress receiveTimestamped() throws IOException {
+        int n = GumdropNative.udp_recv(channel, recvBuf, recvBuf.capacity(),
+                recvFrom, recvDelay);
+        if (n < 0) {
+            throw new IOException("recvmsg failed on " + localAddress);
+        }
+        if (n == 0) {
+            return null;
+        }
+        recvBuf.position(n);
+        ReceiveDelayListener listener = factory.getReceiveDelayListener();
+        if (listener != null && recvDelay[0] >= 0) {
+            listener.receiveDelay(recvDelay[0]);
+        }
+        return decodeAddress(recvFrom);
+    }
+
+    /**
+     * Forwards the datagram in recvBuf to the previous process, with the
+     * peer's address appended so that it can reply.
+     */
+    private void forward(int len, InetSocketAddress source) {
+        InetSocketAddress target = forwardAddress;
+        if (target == null || !appendSource(recvBuf, len,
+                encodeAddress(source))) {
+            return;
+        }
+        try {
+            forwardChannel.send(recvBuf, target);
+        } catch (IOException e) {
+            if (LOGGER.isLoggable(Level.FINE)) {
+                LOGGER.fine("Cannot forward datagram from " + source
+                        + " to " + target + ": " + e.getMessage());
+            }
+        }
+    }
+
+    private void sendStateless(int written, InetSocketAddress dest,
+                               String packet) {
         if (written < 0) {
-            LOGGER.warning("Failed to write Version Negotiation packet: "
+            LOGGER.warning("Failed to write " + packet + " packet: "
                     + written);
             return;
         }
@@ -352,8 +601,21 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
             channel.send(sendBuf, dest);
         } catch (IOException e) {
             LOGGER.log(Level.WARNING,
-                    "Error sending Version Negotiation to " + dest, e);
+                    "Error sending " + packet + " to " + dest, e);
+        }
+    }
+
+    /**
+     * Returns whether a packet's first byte marks a long-header Initial
+     * (RFC 9000 section 17.2.2; RFC 9369 section 3.2 for version 2).
+     */
+    private static boolean isInitial(byte firstByte, int version) {
+        if ((firstByte & 0x80) == 0) {
+            return false;
         }
+        int type = (firstByte & 0x30) >> 4;
+        return type == ((version == QuicTransportFactory
+                .QUICHE_PROTOCOL_VERSION_2) ? 1 : 0);
     }
 
     /**
@@ -361,26 +623,32 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
      * (handshake).
      *
      * @param dcid    the DCID from the client's Initial packet
+     * @param odcid   the DCID of the client's first Initial if it has
+     *                been sent a Retry, otherwise null
      * @param version the QUIC version from the packet header
      * @param source  the peer's socket address
      */
-    private QuicConnection acceptConnection(byte[] dcid, int version,
+    private QuicConnection acceptConnection(byte[] dcid, byte[] odcid,
+                                             int version,
                                              InetSocketAddress source) {
-        byte[] scid = generateConnectionId();
+        // After a Retry the client already uses the connection ID the
+        // Retry chose (RFC 9000 section 7.3)
+        byte[] scid = (odcid != null) ? dcid : generateConnectionId();
 
         InetSocketAddress local = getLocalSocketAddress();
         byte[] localAddr = encodeAddress(local);
         byte[] peerAddr = encodeAddress(source);
 
-        long ssl = GumdropNative.ssl_new(factory.getSslCtx());
+        long ssl = factory.newSsl();
         if (ssl == 0) {
             LOGGER.warning("Failed to create SSL for new QUIC connection");
             return null;
         }
 
         long connPtr = GumdropNative.quiche_conn_new_with_tls(
-                scid, null, localAddr, peerAddr,
-                factory.getQuicheConfig(version), ssl, true);
+                scid, odcid, localAddr, peerAddr,
+                factory.getQuicheConfig(version, source.getAddress()),
+                ssl, true);
 
         if (connPtr == 0) {
             LOGGER.warning(
@@ -390,6 +658,11 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
 
         QuicConnection conn = new QuicConnection(
                 this, connPtr, ssl, local, source);
+        liveConnections++;
+        factory.handshakeStarted(ssl, conn);
+        if (admission != null) {
+            admission.opened(conn, source.getAddress());
+        }
 
         if (connectionAcceptedHandler != null) {
             connectionAcceptedHandler.connectionAccepted(conn);
@@ -398,14 +671,14 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
         }
 
         String connKey = ByteArrays.toHexString(scid);
-        connections.put(connKey, conn);
+        registerConnectionId(connKey, conn);
 
         // Also map the original client DCID so that the first
         // packet (which created this connection) can be looked up
         // after quiche responds with the server SCID.
         String dcidKey = ByteArrays.toHexString(dcid);
         if (!dcidKey.equals(connKey)) {
-            connections.put(dcidKey, conn);
+            registerConnectionId(dcidKey, conn);
         }
 
         if (LOGGER.isLoggable(Level.FINE)) {
@@ -417,15 +690,27 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
     }
 
     /**
-     * Flushes outgoing QUIC packets for a connection.
+     * Flushes outgoing QUIC packets for a connection. A packet the
+     * pacer releases later (RFC 9002 section 7.7) is held, with the
+     * rest of the flush, until a timer sends it.
      */
     public void flushConnection(QuicConnection conn) {
+        if (conn.isPacing()) {
+            return;
+        }
         int packetCount = 0;
         int totalBytes = 0;
+        // RFC 9000 section 14: what this connection may send now, which
+        // grows with the peer's limit and any discovered path MTU
+        int maxLen = (int) Math.min(sendBuf.capacity(),
+                GumdropNative.quiche_conn_max_send_udp_payload_size(
+                        conn.getConnPtr()));
         while (true) {
             sendBuf.clear();
             int written = GumdropNative.quiche_conn_send(
-                    conn.getConnPtr(), sendBuf, sendBuf.capacity());
+                    conn.getConnPtr(), sendBuf, maxLen, sendTo,
+                    LOGGER.isLoggable(Level.FINEST) ? sendFrom : null,
+                    sendDelay);
 
             if (written == GumdropNative.QUICHE_ERR_DONE) {
                 break;
@@ -458,24 +743,30 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
                 }
                 LOGGER.finest("quiche_conn_send: " + written
                         + " bytes, " + hdrType
-                        + " [0x" + Integer.toHexString(firstByte) + "]");
+                        + " [0x" + Integer.toHexString(firstByte) + "] "
+                        + decodeAddress(sendFrom) + " -> "
+                        + decodeAddress(sendTo)
+                        + ", release in " + sendDelay[0] + "ns");
             }
 
-            InetSocketAddress dest =
-                    (InetSocketAddress) conn.getRemoteAddress();
+            // sendTo is the active path, or one quiche is probing or
+            // validating. A closing connection sends its
+            // CONNECTION_CLOSE at once.
+            if (sendDelay[0] >= PACING_GRANULARITY_NS && !conn.isClosed()) {
+                long delayMs = (sendDelay[0] + PACING_GRANULARITY_NS - 1)
+                        / PACING_GRANULARITY_NS;
+                conn.holdPacket(sendBuf, sendTo, delayMs);
+                break;
+            }
             try {
-                int sent = channel.send(sendBuf, dest);
-                if (sent != written) {
-                    LOGGER.warning("channel.send returned " + sent
-                            + " (expected " + written + ") to " + dest);
-                }
-                packetCount++;
-                totalBytes += written;
+                sendPacket(sendBuf, sendTo);
             } catch (IOException e) {
-                LOGGER.log(Level.WARNING,
-                        "Error sending QUIC packet to " + dest, e);
+                LOGGER.log(Level.WARNING, "Error sending QUIC packet to "
+                        + decodeAddress(sendTo), e);
                 break;
             }
+            packetCount++;
+            totalBytes += written;
         }
         if (packetCount > 0 && LOGGER.isLoggable(Level.FINEST)) {
             LOGGER.finest("Flushed " + packetCount + " QUIC packets ("
@@ -484,6 +775,127 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
         }
     }
 
+    /**
+     * Sends a packet the pacer held back once its release time has
+     * come, then flushes whatever quiche has to send after it.
+     */
+    void releasePacket(QuicConnection conn) {
+        ByteBuffer packet = conn.getPacedPacket();
+        byte[] to = conn.getPacedDestination();
+        conn.clearPacedPacket();
+        try {
+            sendPacket(packet, to);
+            flushConnection(conn);
+        } catch (IOException e) {
+            LOGGER.log(Level.WARNING, "Error sending QUIC packet to "
+                    + decodeAddress(to), e);
+        }
+        conn.checkEstablished();
+        conn.scheduleTimeout();
+    }
+
+    /**
+     * Sends one datagram, from position 0, to an encoded address. One
+     * larger than the local interface allows (EMSGSIZE) is dropped, as
+     * the path would drop it, so that a path MTU probe is declared lost
+     * (RFC 8899 section 4.4).
+     *
+     * @throws IOException on any other send error
+     */
+    private void sendPacket(ByteBuffer buf, byte[] to) throws IOException {
+        int len = buf.remaining();
+        int sent = GumdropNative.udp_send(channel, buf, len, to);
+        if (sent == GumdropNative.UDP_SEND_TOO_BIG) {
+            if (LOGGER.isLoggable(Level.FINE)) {
+                LOGGER.fine("Dropped " + len + "-byte QUIC packet to "
+                        + decodeAddress(to) + ": larger than the MTU");
+            }
+        } else if (sent < 0) {
+            throw new IOException("sendto failed on " + localAddress);
+        } else if (sent != len) {
+            LOGGER.warning("udp_send returned " + sent
+                    + " (expected " + len + ") to " + decodeAddress(to));
+        }
+    }
+
+    /**
+     * Handles the path events quiche has queued for a connection
+     * (RFC 9000 section 9). A client probes a new path so it can be
+     * validated; a server leaves validation of the path a migrating
+     * client uses to quiche (section 9.3). When the peer migrates to a
+     * validated path, the connection's remote address follows it.
+     */
+    private void processPathEvents(QuicConnection conn) {
+        long connPtr = conn.getConnPtr();
+        int type;
+        while ((type = GumdropNative.quiche_conn_path_event_next(
+                connPtr, pathLocal, pathPeer)) >= 0) {
+            switch (type) {
+                case GumdropNative.QUICHE_PATH_EVENT_NEW:
+                    if (serverMode) {
+                        if (LOGGER.isLoggable(Level.FINE)) {
+                            LOGGER.fine("New QUIC path from "
+                                    + decodeAddress(pathPeer));
+                        }
+                        break;
+                    }
+                    int rc = GumdropNative.quiche_conn_probe_path(
+                            connPtr, pathLocal, pathPeer);
+                    if (LOGGER.isLoggable(Level.FINE)) {
+                        LOGGER.fine("New QUIC path to "
+                                + decodeAddress(pathPeer)
+                                + (rc < 0 ? ", not probed: "
+                                        + GumdropNative.errorString(rc)
+                                        : ", probing"));
+                    }
+                    break;
+                case GumdropNative.QUICHE_PATH_EVENT_PEER_MIGRATED:
+                    conn.peerMigrated(decodeAddress(pathPeer));
+                    break;
+                default:
+                    if (LOGGER.isLoggable(Level.FINE)) {
+                        LOGGER.fine("QUIC path event " + type + " for "
+                                + decodeAddress(pathPeer));
+                    }
+                    break;
+            }
+        }
+    }
+
+    /**
+     * Stops routing the connection IDs the peer has retired and issues
+     * new ones up to its active_connection_id_limit (RFC 9000 section
+     * 5.1.1). A peer needs an unused connection ID to migrate
+     * deliberately (section 9.5); a NAT rebinding keeps the old one.
+     */
+    private void updateConnectionIds(QuicConnection conn) {
+        long connPtr = conn.getConnPtr();
+        byte[] retired;
+        while ((retired = GumdropNative.quiche_conn_retired_scid_next(
+                connPtr)) != null) {
+            String connKey = ByteArrays.toHexString(retired);
+            if (connections.get(connKey) == conn) {
+                connections.remove(connKey);
+            }
+            conn.removeConnectionId(connKey);
+        }
+        while (GumdropNative.quiche_conn_scids_left(connPtr) > 0) {
+            byte[] scid = generateConnectionId();
+            byte[] resetToken = new byte[RESET_TOKEN_LEN];
+            RANDOM.nextBytes(resetToken);
+            long seq = GumdropNative.quiche_conn_new_scid(
+                    connPtr, scid, resetToken);
+            if (seq < 0) {
+                if (LOGGER.isLoggable(Level.FINE)) {
+                    LOGGER.fine("Cannot issue QUIC connection ID: "
+                            + GumdropNative.errorString((int) seq));
+                }
+                break;
+            }
+            registerConnectionId(ByteArrays.toHexString(scid), conn);
+        }
+    }
+
     /**
      * Flushes a connection and then re-checks the established state.
      * After flushing, quiche may mark the connection as established
@@ -495,6 +907,24 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
         conn.checkEstablished();
     }
 
+    /**
+     * Continues a handshake that was waiting for an asynchronous private
+     * key operation. May be called from any thread: quiche_conn_send()
+     * re-enters the TLS handshake, which collects the signature and
+     * queues the rest of the server's flight.
+     */
+    void resumeHandshake(final QuicConnection conn) {
+        selectorLoop.invokeLater(new Runnable() {
+            @Override
+            public void run() {
+                if (!conn.isClosed()) {
+                    flushAndCheck(conn);
+                    conn.scheduleTimeout();
+                }
+            }
+        });
+    }
+
     /**
      * Called by QuicConnection when it has data to flush.
      */
@@ -522,6 +952,94 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
         }
     }
 
+    // ── Graceful upgrade ──
+
+    /**
+     * Hands this engine's socket over to a new process. The engine stops
+     * reading the socket, which the new process now reads, and receives
+     * instead the packets the new process forwards on the given loopback
+     * channel. It still sends on the socket, so peers see no change of
+     * address. Every connection is then asked to drain. May be called
+     * from any thread.
+     *
+     * @param forward a non-blocking channel connected to the new
+     *        process's forwarding socket
+     */
+    void handOff(final DatagramChannel forward) {
+        selectorLoop.invokeLater(new Runnable() {
+            @Override
+            public void run() {
+                if (closing) {
+                    closeChannel(forward);
+                    return;
+                }
+                if (selectionKey != null) {
+                    selectionKey.cancel();
+                }
+                recvChannel = forward;
+                selectorLoop.registerDatagram(forward, QuicEngine.this);
+                for (QuicConnection conn
+                        : new ArrayList<QuicConnection>(connections.values())) {
+                    conn.drain();
+                }
+            }
+        });
+    }
+
+    /**
+     * Forwards packets for unknown connections, other than Initials, to
+     * the process this engine's socket was inherited from.
+     *
+     * @param channel the channel to send them from
+     * @param target the previous process's forwarding socket
+     */
+    void forwardTo(DatagramChannel channel, InetSocketAddress target) {
+        this.forwardChannel = channel;
+        this.forwardAddress = target;
+    }
+
+    /**
+     * Stops forwarding packets once the previous process has exited.
+     */
+    void stopForwarding() {
+        forwardAddress = null;
+    }
+
+    /**
+     * Returns the number of connections not yet closed. Unlike
+     * {@link #getConnectionCount} this may be called from any thread.
+     */
+    int getLiveConnectionCount() {
+        return liveConnections;
+    }
+
+    /**
+     * Samples the bytes in flight over this engine's connections for
+     * {@link NativeMemory}. Must be called on the engine's SelectorLoop.
+     */
+    void pollBufferedBytes() {
+        long total = 0;
+        for (Map.Entry<String, QuicConnection> entry
+                : connections.entrySet()) {
+            // Once per connection, as in getConnectionCount
+            QuicConnection conn = entry.getValue();
+            if (!conn.isClosed() && entry.getKey().equals(
+                    conn.getConnectionIds().get(0))) {
+                total += GumdropNative.quiche_conn_bytes_in_flight(
+                        conn.getConnPtr());
+            }
+        }
+        bufferedBytes = total;
+    }
+
+    /**
+     * Returns the bytes in flight at the last {@link #pollBufferedBytes}.
+     * May be called from any thread.
+     */
+    long getBufferedBytes() {
+        return bufferedBytes;
+    }
+
     // ── MultiplexedEndpoint implementation ──
 
     @Override
@@ -557,6 +1075,17 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
          * @param connection the newly created connection
          */
         void connectionAccepted(QuicConnection connection);
+
+        /**
+         * Called in client mode when an outbound connection closes
+         * before its handshake completes (handshake failure, idle
+         * timeout, or certificate pin mismatch). The connection has
+         * already been freed.
+         *
+         * @param connection the failed connection
+         */
+        default void connectionFailed(QuicConnection connection) {
+        }
     }
 
     /**
@@ -610,17 +1139,28 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
         }
 
         if (channel != null) {
-            try {
-                channel.close();
-            } catch (IOException e) {
-                LOGGER.log(Level.WARNING,
-                        "Error closing QUIC DatagramChannel", e);
-            }
+            closeChannel(channel);
+        }
+        if (recvChannel != channel) {
+            closeChannel(recvChannel);
         }
 
         if (selectionKey != null) {
             selectionKey.cancel();
         }
+        if (serverMode) {
+            QuicHandoff.engineClosed(this);
+        }
+        NativeMemory.engineClosed(this);
+    }
+
+    private static void closeChannel(DatagramChannel channel) {
+        try {
+            channel.close();
+        } catch (IOException e) {
+            LOGGER.log(Level.WARNING,
+                    "Error closing QUIC DatagramChannel", e);
+        }
     }
 
     @Override
@@ -730,17 +1270,95 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
                    ProtocolHandler handler,
                    ConnectionAcceptedHandler connHandler,
                    String serverName) {
+        try {
+            QuicConnection conn = openClientConnection(remote, serverName);
+            if (connHandler != null) {
+                conn.setClientConnectionAcceptedHandler(connHandler);
+            }
+            if (handler != null) {
+                conn.setClientHandler(handler);
+            }
+            startClientHandshake(conn);
+        } catch (IOException e) {
+            if (handler != null) {
+                handler.error(e);
+            } else {
+                LOGGER.log(Level.WARNING, e.getMessage(), e);
+            }
+        }
+    }
+
+    /**
+     * Opens an additional client connection on this engine's socket.
+     *
+     * <p>A client engine can carry any number of outbound connections,
+     * to the same or different peers; incoming packets are routed to
+     * the right one by the connection ID chosen here, exactly as on the
+     * server. The handler is called on this engine's SelectorLoop when
+     * the handshake completes, or its
+     * {@link ConnectionAcceptedHandler#connectionFailed connectionFailed}
+     * method if the connection closes first.
+     *
+     * <p>Must be called on this engine's SelectorLoop thread.
+     *
+     * @param remote the remote address
+     * @param connHandler the connection-level handler
+     * @param serverName the TLS SNI hostname, or null
+     * @return the new connection, not yet established
+     * @throws IOException if the connection cannot be created
+     */
+    public QuicConnection connect(InetSocketAddress remote,
+                                  ConnectionAcceptedHandler connHandler,
+                                  String serverName)
+            throws IOException {
+        if (serverMode) {
+            throw new IllegalStateException("Server-mode engine");
+        }
+        if (closing) {
+            throw new IOException("QUIC engine is closed");
+        }
+        QuicConnection conn = openClientConnection(remote, serverName);
+        conn.setClientConnectionAcceptedHandler(connHandler);
+        startClientHandshake(conn);
+        return conn;
+    }
+
+    /**
+     * Returns the number of live connections on this engine.
+     */
+    public int getConnectionCount() {
+        int count = 0;
+        for (Map.Entry<String, QuicConnection> entry
+                : connections.entrySet()) {
+            // A connection may be mapped under more than one ID;
+            // count it once, under the first ID it was given
+            QuicConnection conn = entry.getValue();
+            if (!conn.isClosed() && entry.getKey().equals(
+                    conn.getConnectionIds().get(0))) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * Creates the quiche connection and registers it under its SCID.
+     * Per RFC 9000 section 7 (handshake), the caller must then flush
+     * to send the client Initial packet.
+     */
+    private QuicConnection openClientConnection(InetSocketAddress remote,
+                                                String serverName)
+            throws IOException {
         byte[] scid = generateConnectionId();
 
         InetSocketAddress local = getLocalSocketAddress();
         byte[] localAddr = encodeAddress(local);
         byte[] peerAddr = encodeAddress(remote);
 
-        long ssl = GumdropNative.ssl_new(factory.getSslCtx());
+        long ssl = factory.newClientSsl();
         if (ssl == 0) {
-            handler.error(new IOException(
-                    "Failed to create SSL for QUIC connection"));
-            return;
+            throw new IOException(
+                    "Failed to create SSL for QUIC connection");
         }
 
         if (serverName != null) {
@@ -752,32 +1370,47 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
                 factory.getQuicheConfig(), ssl, false);
 
         if (connPtr == 0) {
-            handler.error(new IOException(
-                    "Failed to create quiche connection to " + remote));
-            return;
+            throw new IOException(
+                    "Failed to create quiche connection to " + remote);
+        }
+
+        // RFC 8446 section 2.2: resume with a ticket from an earlier
+        // connection to this server, if we have one
+        if (serverName != null) {
+            byte[] session = factory.takeSession(serverName);
+            if (session != null) {
+                int rc = GumdropNative.quiche_conn_set_session(
+                        connPtr, session);
+                if (rc < 0 && LOGGER.isLoggable(Level.FINE)) {
+                    LOGGER.fine("Cached session for " + serverName
+                            + " rejected: " + GumdropNative.errorString(rc));
+                }
+            }
         }
 
         QuicConnection conn = new QuicConnection(
                 this, connPtr, ssl, local, remote);
-        if (connHandler != null) {
-            conn.setClientConnectionAcceptedHandler(connHandler);
-        }
-        if (handler != null) {
-            conn.setClientHandler(handler);
+        liveConnections++;
+        if (clientConnection == null || clientConnection.isClosed()) {
+            clientConnection = conn;
         }
-        clientConnection = conn;
 
         String connKey = ByteArrays.toHexString(scid);
-        connections.put(connKey, conn);
-
-        // Send initial QUIC handshake packet
-        flushConnection(conn);
-        conn.scheduleTimeout();
+        registerConnectionId(connKey, conn);
 
         if (LOGGER.isLoggable(Level.FINE)) {
             LOGGER.fine("Initiating QUIC connection to " + remote
                     + " [" + connKey + "]");
         }
+        return conn;
+    }
+
+    private void startClientHandshake(QuicConnection conn) {
+        // Send initial QUIC handshake packet
+        flushConnection(conn);
+        conn.scheduleTimeout();
+        // A resumed session may allow requests to go out in 0-RTT
+        conn.checkEarlyData();
     }
 
     // ── Internal helpers ──
@@ -791,16 +1424,60 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
         }
     }
 
-    private InetSocketAddress getLocalSocketAddress() {
-        try {
-            return (InetSocketAddress) channel.getLocalAddress();
-        } catch (IOException e) {
-            return new InetSocketAddress("localhost", 0);
+    private void registerConnectionId(String connKey,
+                                      QuicConnection conn) {
+        connections.put(connKey, conn);
+        conn.addConnectionId(connKey);
+    }
+
+    /**
+     * Called by QuicConnection when it closes, however that happens
+     * (idle timeout, peer CONNECTION_CLOSE, local close), so that its
+     * connection IDs stop routing to a freed connection.
+     */
+    void connectionClosed(QuicConnection conn) {
+        liveConnections--;
+        if (admission != null) {
+            // Accounted where it was admitted, even if it migrated since
+            InetSocketAddress remote = conn.getOriginalRemoteAddress();
+            admission.closed(conn, remote.getAddress());
+        }
+        if (closing) {
+            return; // close() is clearing the map itself
+        }
+        for (String connKey : conn.getConnectionIds()) {
+            if (connections.get(connKey) == conn) {
+                connections.remove(connKey);
+            }
+        }
+        if (clientConnection == conn) {
+            clientConnection = null;
         }
     }
 
+    /**
+     * Called by QuicConnection when its handshake completes.
+     */
+    void connectionEstablished(QuicConnection conn) {
+        if (admission != null) {
+            admission.established(conn);
+        }
+    }
+
+    InetSocketAddress getLocalSocketAddress() {
+        return localAddress;
+    }
+
+    DatagramChannel getChannel() {
+        return channel;
+    }
+
     // RFC 9000 section 5.1 — connection IDs up to MAX_CONN_ID_LEN bytes
-    private static byte[] generateConnectionId() {
+    // unless the factory has a generator, such as QUIC-LB
+    private byte[] generateConnectionId() {
+        if (connectionIdGenerator != null) {
+            return connectionIdGenerator.generate();
+        }
         byte[] id = new byte[MAX_CONN_ID_LEN];
         RANDOM.nextBytes(id);
         return id;
@@ -810,7 +1487,7 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
      * Encodes an InetSocketAddress as bytes for the JNI layer.
      * Format: [family (1)][port (2)][addr (4 or 16)]
      */
-    private static byte[] encodeAddress(InetSocketAddress addr) {
+    static byte[] encodeAddress(InetSocketAddress addr) {
         byte[] ipBytes = addr.getAddress().getAddress();
         int port = addr.getPort();
         boolean ipv6 = ipBytes.length == 16;
@@ -823,4 +1500,79 @@ public class QuicEngine implements ChannelHandler, MultiplexedEndpoint {
         return result;
     }
 
+    /**
+     * Decodes an address encoded by the JNI layer, or returns null if
+     * the family is unknown.
+     */
+    static InetSocketAddress decodeAddress(byte[] addr) {
+        int len = encodedAddressLength(addr);
+        if (len == 0) {
+            return null;
+        }
+        byte[] ipBytes = new byte[len - 3];
+        System.arraycopy(addr, 3, ipBytes, 0, ipBytes.length);
+        int port = ((addr[1] & 0xFF) << 8) | (addr[2] & 0xFF);
+        try {
+            return new InetSocketAddress(
+                    InetAddress.getByAddress(ipBytes), port);
+        } catch (UnknownHostException e) {
+            return null; // not reached: the length is 4 or 16
+        }
+    }
+
+    /**
+     * Appends the encoded source address of a datagram to be forwarded,
+     * followed by its length, and flips the buffer. The datagram stays at
+     * offset 0, where the native layer expects it.
+     *
+     * @return false if the datagram is too large to forward
+     */
+    static boolean appendSource(ByteBuffer buf, int len, byte[] addr) {
+        if (len + addr.length + 1 > buf.capacity()) {
+            return false;
+        }
+        buf.limit(buf.capacity());
+        buf.position(len);
+        buf.put(addr);
+        buf.put((byte) addr.length);
+        buf.flip();
+        return true;
+    }
+
+    /**
+     * Removes the source address appended by {@link #appendSource},
+     * leaving the datagram between 0 and the limit.
+     *
+     * @return the source address, or null if the trailer is malformed
+     */
+    static InetSocketAddress unwrapForwarded(ByteBuffer buf) {
+        int end = buf.limit();
+        if (end < 1) {
+            return null;
+        }
+        int addrLen = buf.get(end - 1) & 0xFF;
+        if (addrLen == 0 || addrLen > MAX_ADDRESS_LEN || end < addrLen + 1) {
+            return null;
+        }
+        int start = end - 1 - addrLen;
+        byte[] addr = new byte[addrLen];
+        buf.get(start, addr);
+        if (encodedAddressLength(addr) != addrLen) {
+            return null;
+        }
+        buf.limit(start);
+        return decodeAddress(addr);
+    }
+
+    static int encodedAddressLength(byte[] addr) {
+        switch (addr[0]) {
+            case 4:
+                return 7;
+            case 6:
+                return MAX_ADDRESS_LEN;
+            default:
+                return 0;
+        }
+    }
+
 }
@@ -0,0 +1,670 @@
+/*
+ * QuicHandoff.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+import org.bluezoo.gumdrop.GumdropNative;
+
+import java.io.Closeable;
+import java.io.IOException;
+import java.net.InetSocketAddress;
+import java.net.SocketOption;
+import java.net.SocketTimeoutException;
+import java.net.StandardProtocolFamily;
+import java.net.UnixDomainSocketAddress;
+import java.nio.ByteBuffer;
+import java.nio.channels.DatagramChannel;
+import java.nio.channels.SelectionKey;
+import java.nio.channels.Selector;
+import java.nio.channels.ServerSocketChannel;
+import java.nio.channels.SocketChannel;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.nio.file.StandardCopyOption;
+import java.nio.file.attribute.PosixFilePermissions;
+import java.nio.file.attribute.UserPrincipal;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.logging.Level;
+import java.util.logging.Logger;
+
+/**
+ * Zero-downtime restarts for QUIC listeners.
+ *
+ * <p>A running server {@link #listen listens} on a UNIX domain socket.
+ * Its replacement, started with the same configuration, connects to it
+ * before binding any listener and {@link #inherit inherits} the bound UDP
+ * socket of every QUIC server engine, passed as SCM_RIGHTS ancillary
+ * data. The sockets are never unbound, so no datagram is refused in
+ * between, and the replacement accepts every new connection from the
+ * moment its listeners start.
+ *
+ * <p>Once the replacement has started, the previous process stops
+ * reading the sockets, asks each of its connections to drain (HTTP/3
+ * sends GOAWAY, RFC 9114 section 5.2) and shuts down gracefully. Until
+ * it exits, the replacement forwards to it over loopback UDP every
+ * packet that is not an Initial and matches none of its own connection
+ * IDs, with the peer's address appended; the previous process replies
+ * through the shared socket, so peers see no change of address.
+ *
+ * <p>The exchange on the UNIX socket is:
+ * <ol>
+ * <li>replacement: {@code 'U'} and the port of its loopback forwarding
+ * socket (2 bytes)</li>
+ * <li>previous process: the number of sockets (1 byte), then for each
+ * its encoded local address and the port of the loopback socket that
+ * will receive forwarded packets, with the sockets attached</li>
+ * <li>replacement, once its listeners have started: {@code 'S'}</li>
+ * </ol>
+ * The connection then stays open until the previous process exits. A
+ * replacement that fails to start closes it without sending {@code 'S'}
+ * and the previous process carries on serving, as it does when a peer
+ * stalls in any step.
+ *
+ * <p>Whoever connects to the UNIX socket can take the sockets, so it is
+ * bound in a private directory and renamed into place once only its
+ * owner can connect, and the previous process hands over only to a peer
+ * running as the same user (SO_PEERCRED).
+ *
+ * <p>Only QUIC sockets are handed over. TCP listeners are bound afresh,
+ * which fails while the previous process still holds their ports, so
+ * upgrades suit processes that serve only HTTP/3 and DNS over QUIC.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ * @see org.bluezoo.gumdrop.Gumdrop
+ */
+public final class QuicHandoff {
+
+    private static final Logger LOGGER =
+            Logger.getLogger(QuicHandoff.class.getName());
+
+    private static final byte REQUEST = 'U';
+    private static final byte STARTED = 'S';
+
+    /** Most sockets passed in one message, as in the native layer. */
+    private static final int MAX_SOCKETS = 64;
+
+    /** Longest encoded address: family, port and an IPv6 address. */
+    private static final int MAX_ADDRESS_LEN = 19;
+
+    private static final int MAX_MESSAGE =
+            1 + MAX_SOCKETS * (MAX_ADDRESS_LEN + 2);
+
+    private static final String LOOPBACK = "127.0.0.1";
+
+    /** Longest wait for the replacement's request, in milliseconds. */
+    private static final long REQUEST_TIMEOUT = 5000L;
+
+    /** Longest wait for the sockets from the previous process. */
+    private static final long SOCKETS_TIMEOUT = 10000L;
+
+    /** Longest wait for the replacement to start its listeners. */
+    private static final long START_TIMEOUT = 120000L;
+
+    // Server engines of this process, which a replacement would inherit
+    private static final List<QuicEngine> engines =
+            new ArrayList<QuicEngine>();
+
+    // Previous process: where we listen, the replacement once it has
+    // taken our sockets, and the engines draining meanwhile
+    private static ServerSocketChannel server;
+    private static Path serverPath;
+    private static SocketChannel successor;
+    private static final List<QuicEngine> drainingEngines =
+            new ArrayList<QuicEngine>();
+
+    // Replacement: the previous process, the sockets it passed us keyed
+    // by local address, and the engines forwarding to it
+    private static SocketChannel predecessor;
+    private static DatagramChannel forwarder;
+    private static final Map<InetSocketAddress, Inherited> inherited =
+            new HashMap<InetSocketAddress, Inherited>();
+    private static final List<QuicEngine> forwardingEngines =
+            new ArrayList<QuicEngine>();
+
+    private QuicHandoff() {
+    }
+
+    // ── Replacement process ──
+
+    /**
+     * Takes over the QUIC sockets of the server listening on the given
+     * path, if there is one. Must be called before any QUIC listener is
+     * started; listeners bound to the same addresses then use the
+     * inherited sockets.
+     *
+     * @param path the UNIX domain socket of the running server
+     * @return whether there was a server to take sockets from
+     * @throws IOException if the exchange with the server fails
+     */
+    public static boolean inherit(Path path) throws IOException {
+        if (!Files.exists(path)) {
+            return false;
+        }
+        SocketChannel sc = SocketChannel.open(StandardProtocolFamily.UNIX);
+        try {
+            sc.connect(UnixDomainSocketAddress.of(path));
+        } catch (IOException e) {
+            // Left behind by a server that did not shut down cleanly
+            closeQuietly(sc);
+            if (LOGGER.isLoggable(Level.FINE)) {
+                LOGGER.fine("No server at " + path + ": " + e.getMessage());
+            }
+            return false;
+        }
+        // The exchange runs unlocked: in a test both ends share this class
+        DatagramChannel fw = DatagramChannel.open(StandardProtocolFamily.INET);
+        Map<InetSocketAddress, Inherited> sockets =
+                new HashMap<InetSocketAddress, Inherited>();
+        boolean ok = false;
+        try {
+            fw.bind(new InetSocketAddress(LOOPBACK, 0));
+            fw.configureBlocking(false);
+            int port = ((InetSocketAddress) fw.getLocalAddress()).getPort();
+            ByteBuffer request = ByteBuffer.allocate(3);
+            request.put(REQUEST).putShort((short) port).flip();
+            while (request.hasRemaining()) {
+                sc.write(request);
+            }
+
+            byte[] message = new byte[MAX_MESSAGE];
+            int[] fds = new int[MAX_SOCKETS];
+            awaitReadable(sc, SOCKETS_TIMEOUT);
+            int len = GumdropNative.handoff_recv(sc, message, fds);
+            if (len <= 0) {
+                throw new IOException("No sockets received from " + path);
+            }
+            if (!parseSockets(message, len, fds, sockets)) {
+                for (int fd : fds) {
+                    GumdropNative.fd_close(fd);
+                }
+                throw new IOException("Malformed socket handoff from "
+                        + path);
+            }
+            ok = true;
+        } finally {
+            if (!ok) {
+                closeQuietly(fw);
+                closeQuietly(sc);
+            }
+        }
+        synchronized (QuicHandoff.class) {
+            predecessor = sc;
+            forwarder = fw;
+            inherited.putAll(sockets);
+        }
+        if (LOGGER.isLoggable(Level.INFO)) {
+            LOGGER.info("Inherited " + sockets.size()
+                    + " QUIC socket(s) from " + path);
+        }
+        return true;
+    }
+
+    private static boolean parseSockets(byte[] message, int len, int[] fds,
+                                        Map<InetSocketAddress, Inherited>
+                                                sockets) {
+        int count = message[0] & 0xFF;
+        if (count > MAX_SOCKETS) {
+            return false;
+        }
+        int off = 1;
+        for (int i = 0; i < count; i++) {
+            if (off >= len || fds[i] < 0) {
+                return false;
+            }
+            byte[] addr = Arrays.copyOfRange(message, off,
+                    off + MAX_ADDRESS_LEN);
+            int addrLen = QuicEngine.encodedAddressLength(addr);
+            if (addrLen == 0 || off + addrLen + 2 > len) {
+                return false;
+            }
+            off += addrLen;
+            int port = ((message[off] & 0xFF) << 8) | (message[off + 1] & 0xFF);
+            off += 2;
+            sockets.put(QuicEngine.decodeAddress(addr), new Inherited(
+                    fds[i], new InetSocketAddress(LOOPBACK, port)));
+        }
+        return true;
+    }
+
+    /**
+     * Gives a new server engine the inherited socket bound to the given
+     * address, if there is one, and has it forward the previous process's
+     * packets.
+     *
+     * @param engine the engine, not yet initialised
+     * @param channel an open, unbound channel of the address's family
+     * @param address the address the engine is to be bound to
+     * @return false if no socket bound to the address was inherited
+     * @throws IOException if the socket cannot be adopted
+     */
+    static synchronized boolean adopt(QuicEngine engine,
+                                      DatagramChannel channel,
+                                      InetSocketAddress address)
+            throws IOException {
+        Inherited socket = inherited.remove(address);
+        if (socket == null) {
+            return false;
+        }
+        // The channel would otherwise bind itself on first use
+        channel.bind(null);
+        if (GumdropNative.datagram_channel_adopt(channel, socket.fd) != 0) {
+            throw new IOException("Cannot adopt inherited QUIC socket for "
+                    + address);
+        }
+        engine.init(channel, address);
+        engine.forwardTo(forwarder, socket.forwardAddress);
+        forwardingEngines.add(engine);
+        return true;
+    }
+
+    /**
+     * Tells the previous process that this one has started, closes any
+     * socket no listener took, and watches for the previous process to
+     * exit.
+     */
+    private static void started() throws IOException {
+        for (Inherited socket : inherited.values()) {
+            GumdropNative.fd_close(socket.fd);
+        }
+        inherited.clear();
+        ByteBuffer buf = ByteBuffer.wrap(new byte[] { STARTED });
+        while (buf.hasRemaining()) {
+            predecessor.write(buf);
+        }
+        final SocketChannel sc = predecessor;
+        Thread watcher = new Thread(new Runnable() {
+            @Override
+            public void run() {
+                awaitExit(sc);
+            }
+        }, "quic-handoff-forward");
+        watcher.setDaemon(true);
+        watcher.start();
+    }
+
+    private static void awaitExit(SocketChannel sc) {
+        ByteBuffer buf = ByteBuffer.allocate(1);
+        try {
+            while (sc.read(buf) >= 0) {
+                buf.clear();
+            }
+        } catch (IOException e) {
+            // gone
+        }
+        synchronized (QuicHandoff.class) {
+            for (QuicEngine engine : forwardingEngines) {
+                engine.stopForwarding();
+            }
+            forwardingEngines.clear();
+            closeQuietly(sc);
+            predecessor = null;
+        }
+        LOGGER.info("Previous process has exited;"
+                + " no longer forwarding QUIC packets");
+    }
+
+    // ── Previous process ──
+
+    /**
+     * Listens on the given path for a replacement process. When one has
+     * started on this process's QUIC sockets, onUpgrade is run on the
+     * listening thread to shut this process down gracefully; its QUIC
+     * connections drain meanwhile and
+     * {@link #getDrainingConnectionCount} counts those remaining.
+     *
+     * <p>If this process itself {@link #inherit inherited} its sockets,
+     * the previous process is first told that it has started.
+     *
+     * @param path the UNIX domain socket to listen on
+     * @param onUpgrade run once the sockets have been handed over
+     * @throws IOException if the socket cannot be bound
+     */
+    public static synchronized void listen(Path path,
+                                           final Runnable onUpgrade)
+            throws IOException {
+        if (predecessor != null) {
+            started();
+        }
+        final ServerSocketChannel ssc = bindPrivate(path);
+        final UserPrincipal owner;
+        try {
+            owner = Files.getOwner(path);
+        } catch (IOException e) {
+            closeQuietly(ssc);
+            throw e;
+        }
+        server = ssc;
+        serverPath = path;
+        Thread thread = new Thread(new Runnable() {
+            @Override
+            public void run() {
+                serve(ssc, owner, onUpgrade);
+            }
+        }, "quic-handoff");
+        thread.setDaemon(true);
+        thread.start();
+    }
+
+    /**
+     * Binds a UNIX domain socket at the given path that only this user
+     * can connect to. It is bound in a new directory of mode 0700, so it
+     * is never reachable with the permissions the umask gives it, and
+     * renamed into place, replacing any socket left there, once it is
+     * mode 0600.
+     */
+    private static ServerSocketChannel bindPrivate(Path path)
+            throws IOException {
+        Path parent = path.toAbsolutePath().getParent();
+        Path dir;
+        try {
+            dir = Files.createTempDirectory(parent, ".handoff",
+                    PosixFilePermissions.asFileAttribute(
+                            PosixFilePermissions.fromString("rwx------")));
+        } catch (UnsupportedOperationException e) {
+            // not a POSIX filesystem
+            dir = Files.createTempDirectory(parent, ".handoff");
+        }
+        Path tmp = dir.resolve("s");
+        ServerSocketChannel ssc =
+                ServerSocketChannel.open(StandardProtocolFamily.UNIX);
+        boolean ok = false;
+        try {
+            ssc.bind(UnixDomainSocketAddress.of(tmp));
+            try {
+                Files.setPosixFilePermissions(tmp,
+                        PosixFilePermissions.fromString("rw-------"));
+            } catch (UnsupportedOperationException e) {
+                // not a POSIX filesystem
+            }
+            Files.move(tmp, path, StandardCopyOption.ATOMIC_MOVE);
+            ok = true;
+        } finally {
+            if (!ok) {
+                closeQuietly(ssc);
+                Files.deleteIfExists(tmp);
+            }
+            Files.deleteIfExists(dir);
+        }
+        return ssc;
+    }
+
+    private static void serve(ServerSocketChannel ssc, UserPrincipal owner,
+                              Runnable onUpgrade) {
+        while (ssc.isOpen()) {
+            SocketChannel sc;
+            try {
+                sc = ssc.accept();
+            } catch (IOException e) {
+                return; // closed
+            }
+            try {
+                if (handOff(sc, owner)) {
+                    // The replacement listens at the same path now
+                    closeQuietly(ssc);
+                    onUpgrade.run();
+                    return;
+                }
+            } catch (IOException e) {
+                LOGGER.log(Level.WARNING, "QUIC socket handoff failed", e);
+            }
+            closeQuietly(sc);
+        }
+    }
+
+    /**
+     * Passes our sockets to a replacement and, once it has started,
+     * hands each engine over to it.
+     *
+     * @return false if the replacement did not start
+     */
+    private static boolean handOff(SocketChannel sc, UserPrincipal owner)
+            throws IOException {
+        UserPrincipal peer = peerUser(sc);
+        if (peer == null || !peer.equals(owner)) {
+            LOGGER.warning("Refusing QUIC socket handoff to a process"
+                    + " not running as " + owner.getName()
+                    + (peer == null ? "" : ": " + peer.getName()));
+            return false;
+        }
+        ByteBuffer request = ByteBuffer.allocate(3);
+        if (!readFully(sc, request, REQUEST_TIMEOUT)
+                || request.get(0) != REQUEST) {
+            return false;
+        }
+        InetSocketAddress replacement = new InetSocketAddress(LOOPBACK,
+                request.getShort(1) & 0xFFFF);
+
+        List<QuicEngine> list = new ArrayList<QuicEngine>();
+        synchronized (QuicHandoff.class) {
+            for (QuicEngine engine : engines) {
+                if (engine.isOpen()) {
+                    list.add(engine);
+                }
+            }
+        }
+        int count = list.size();
+        if (count > MAX_SOCKETS) {
+            throw new IOException("Too many QUIC sockets to hand off: "
+                    + count);
+        }
+        DatagramChannel[] sockets = new DatagramChannel[count];
+        DatagramChannel[] forwards = new DatagramChannel[count];
+        ByteBuffer message = ByteBuffer.allocate(MAX_MESSAGE);
+        message.put((byte) count);
+        boolean ok = false;
+        try {
+            for (int i = 0; i < count; i++) {
+                QuicEngine engine = list.get(i);
+                DatagramChannel fc =
+                        DatagramChannel.open(StandardProtocolFamily.INET);
+                forwards[i] = fc;
+                fc.bind(new InetSocketAddress(LOOPBACK, 0));
+                // Only the replacement may feed us packets
+                fc.connect(replacement);
+                fc.configureBlocking(false);
+                sockets[i] = engine.getChannel();
+                message.put(QuicEngine.encodeAddress(
+                        engine.getLocalSocketAddress()));
+                message.putShort((short) ((InetSocketAddress)
+                        fc.getLocalAddress()).getPort());
+            }
+            byte[] data = Arrays.copyOf(message.array(), message.position());
+            if (GumdropNative.handoff_send(sc, data, sockets) < 0) {
+                throw new IOException("Cannot send QUIC sockets");
+            }
+            ByteBuffer reply = ByteBuffer.allocate(1);
+            if (!readFully(sc, reply, START_TIMEOUT)
+                    || reply.get(0) != STARTED) {
+                LOGGER.warning("Replacement process did not start;"
+                        + " keeping QUIC sockets");
+                return false;
+            }
+            ok = true;
+        } finally {
+            if (!ok) {
+                for (DatagramChannel fc : forwards) {
+                    if (fc != null) {
+                        closeQuietly(fc);
+                    }
+                }
+            }
+        }
+
+        synchronized (QuicHandoff.class) {
+            for (int i = 0; i < count; i++) {
+                QuicEngine engine = list.get(i);
+                engine.handOff(forwards[i]);
+                drainingEngines.add(engine);
+            }
+            successor = sc;
+        }
+        if (LOGGER.isLoggable(Level.INFO)) {
+            LOGGER.info("Handed " + count + " QUIC socket(s) to"
+                    + " replacement process; draining");
+        }
+        return true;
+    }
+
+    /**
+     * Returns the number of QUIC connections this process is still
+     * draining after handing its sockets to a replacement.
+     */
+    public static synchronized int getDrainingConnectionCount() {
+        int count = 0;
+        for (QuicEngine engine : drainingEngines) {
+            count += engine.getLiveConnectionCount();
+        }
+        return count;
+    }
+
+    /**
+     * Stops listening for a replacement. The socket file is removed
+     * unless a replacement has taken it over. After a handoff this also
+     * closes the connection to the replacement, which then stops
+     * forwarding packets.
+     */
+    public static synchronized void close() {
+        if (server != null) {
+            closeQuietly(server);
+            if (successor == null) {
+                try {
+                    Files.deleteIfExists(serverPath);
+                } catch (IOException e) {
+                    LOGGER.log(Level.FINE, "Cannot remove " + serverPath, e);
+                }
+            }
+            server = null;
+            serverPath = null;
+        }
+        if (successor != null) {
+            closeQuietly(successor);
+            successor = null;
+        }
+        drainingEngines.clear();
+    }
+
+    // ── Engine registry ──
+
+    static synchronized void engineBound(QuicEngine engine) {
+        engines.add(engine);
+    }
+
+    static synchronized void engineClosed(QuicEngine engine) {
+        engines.remove(engine);
+        forwardingEngines.remove(engine);
+    }
+
+    // ── Helpers ──
+
+    /**
+     * Returns the user the peer of a UNIX domain socket runs as, or null
+     * if the platform cannot tell. jdk.net is reached by reflection, as
+     * it may be missing from the runtime.
+     */
+    private static UserPrincipal peerUser(SocketChannel sc)
+            throws IOException {
+        try {
+            Class<?> extOpts = Class.forName("jdk.net.ExtendedSocketOptions");
+            SocketOption<?> peerCred = (SocketOption<?>)
+                    extOpts.getField("SO_PEERCRED").get(null);
+            Object principal = sc.getOption(peerCred);
+            return (UserPrincipal)
+                    Class.forName("jdk.net.UnixDomainPrincipal")
+                            .getMethod("user").invoke(principal);
+        } catch (UnsupportedOperationException e) {
+            LOGGER.fine("SO_PEERCRED not supported on this platform");
+        } catch (ReflectiveOperationException e) {
+            LOGGER.log(Level.FINE, "Cannot read SO_PEERCRED", e);
+        }
+        return null;
+    }
+
+    /**
+     * Reads until the buffer is full, the stream ends or the timeout
+     * elapses.
+     *
+     * @return false at end of stream
+     * @throws SocketTimeoutException if the timeout elapses
+     */
+    private static boolean readFully(SocketChannel sc, ByteBuffer buf,
+                                     long timeout) throws IOException {
+        long deadline = System.nanoTime() + timeout * 1000000L;
+        while (buf.hasRemaining()) {
+            long remaining = (deadline - System.nanoTime()) / 1000000L;
+            awaitReadable(sc, remaining);
+            if (sc.read(buf) < 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Waits for a blocking channel to become readable, leaving it in
+     * blocking mode.
+     *
+     * @throws SocketTimeoutException if the timeout elapses first
+     */
+    private static void awaitReadable(SocketChannel sc, long timeout)
+            throws IOException {
+        if (timeout <= 0) {
+            throw new SocketTimeoutException("QUIC socket handoff timed out");
+        }
+        Selector selector = Selector.open();
+        try {
+            sc.configureBlocking(false);
+            sc.register(selector, SelectionKey.OP_READ);
+            if (selector.select(timeout) == 0) {
+                throw new SocketTimeoutException(
+                        "QUIC socket handoff timed out");
+            }
+        } finally {
+            // Deregisters the channel so it can block again
+            selector.close();
+            sc.configureBlocking(true);
+        }
+    }
+
+    private static void closeQuietly(Closeable c) {
+        try {
+            c.close();
+        } catch (IOException e) {
+            // ignore
+        }
+    }
+
+    /** A socket passed by the previous process. */
+    private static final class Inherited {
+
+        final int fd;
+        final InetSocketAddress forwardAddress;
+
+        Inherited(int fd, InetSocketAddress forwardAddress) {
+            this.fd = fd;
+            this.forwardAddress = forwardAddress;
+        }
+    }
+
+}
@@ -0,0 +1,191 @@
+/*
+ * QuicLbConnectionIdGenerator.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+import org.bluezoo.gumdrop.GumdropNative;
+import org.bluezoo.util.ByteArrays;
+
+import java.security.SecureRandom;
+
+/**
+ * Generates connection IDs that a QUIC-LB load balancer
+ * (draft-ietf-quic-load-balancers) can route without per-connection
+ * state.
+ *
+ * <p>Each ID is a first octet, holding the config rotation codepoint in
+ * its top three bits and the ID length minus one in the other five,
+ * followed by this server's ID and a random nonce. An ECMP or
+ * Katran-style balancer configured with the same server ID length,
+ * nonce length and key reads the server ID from any packet, so packets
+ * reach the right node even after the client migrates to a new address
+ * or switches to another of the connection's IDs.
+ *
+ * <p>Without a {@link #setKey key} the server ID is sent in the clear.
+ * With one, the server ID and nonce are encrypted with AES-128 in the
+ * native library, so that observers cannot tell which connections
+ * share a server.
+ *
+ * <p>Configure as a component and reference it from each QUIC listener
+ * on the node:
+ * <pre>
+ * &lt;component id="quicLb"
+ *     class="org.bluezoo.gumdrop.quic.QuicLbConnectionIdGenerator"&gt;
+ *   &lt;property name="server-id"&gt;0a01&lt;/property&gt;
+ *   &lt;property name="nonce-length"&gt;8&lt;/property&gt;
+ *   &lt;property name="key"&gt;8f95f09245765f80256934e50c66207f&lt;/property&gt;
+ * &lt;/component&gt;
+ * &lt;listener class="org.bluezoo.gumdrop.http.h3.HTTP3Listener"&gt;
+ *   &lt;property name="connection-id-generator" ref="#quicLb"/&gt;
+ * &lt;/listener&gt;
+ * </pre>
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ * @see QuicTransportFactory#setConnectionIdGenerator
+ */
+public class QuicLbConnectionIdGenerator implements ConnectionIdGenerator {
+
+    /** Config rotation codepoint 0b111 marks unroutable IDs. */
+    private static final int MAX_CONFIG_ID = 6;
+    private static final int MIN_SERVER_ID_LEN = 1;
+    private static final int MAX_SERVER_ID_LEN = 15;
+    private static final int MIN_NONCE_LEN = 4;
+    private static final int MAX_NONCE_LEN = 18;
+    /** Server ID and nonce together, after the first octet. */
+    private static final int MAX_PLAINTEXT_LEN = 19;
+    private static final int KEY_LEN = 16;
+
+    private final SecureRandom random = new SecureRandom();
+
+    private int configId;
+    private byte[] serverId;
+    private int nonceLength;
+    private byte[] key;
+
+    // ── Configuration ──
+
+    /**
+     * XML: {@code config-id}. The config rotation codepoint, 0 to 6,
+     * which lets a balancer tell IDs issued under an old configuration
+     * from new ones while the fleet changes over. Default: 0.
+     *
+     * @param configId the config rotation codepoint
+     */
+    public void setConfigId(int configId) {
+        if (configId < 0 || configId > MAX_CONFIG_ID) {
+            throw new IllegalArgumentException(
+                    "QUIC-LB config ID must be 0 to " + MAX_CONFIG_ID);
+        }
+        this.configId = configId;
+    }
+
+    /**
+     * XML: {@code server-id}. This node's server ID, in hexadecimal: 1 to
+     * 15 bytes, unique among the nodes behind the balancer.
+     *
+     * @param hex the server ID
+     */
+    public void setServerId(String hex) {
+        byte[] id = ByteArrays.toByteArray(hex.trim());
+        if (id.length < MIN_SERVER_ID_LEN || id.length > MAX_SERVER_ID_LEN) {
+            throw new IllegalArgumentException("QUIC-LB server ID must be "
+                    + MIN_SERVER_ID_LEN + " to " + MAX_SERVER_ID_LEN
+                    + " bytes");
+        }
+        this.serverId = id;
+    }
+
+    /**
+     * XML: {@code nonce-length}. The length of the random nonce after the
+     * server ID, 4 to 18 bytes. Default: the rest of a 20-byte ID.
+     *
+     * @param length the nonce length in bytes
+     */
+    public void setNonceLength(int length) {
+        if (length < MIN_NONCE_LEN || length > MAX_NONCE_LEN) {
+            throw new IllegalArgumentException("QUIC-LB nonce length must be "
+                    + MIN_NONCE_LEN + " to " + MAX_NONCE_LEN + " bytes");
+        }
+        this.nonceLength = length;
+    }
+
+    /**
+     * XML: {@code key}. The AES-128 key shared with the balancer, as 32
+     * hexadecimal digits. Unset, the server ID is not encrypted.
+     *
+     * @param hex the key
+     */
+    public void setKey(String hex) {
+        byte[] k;
+        try {
+            k = ByteArrays.toByteArray(hex.trim());
+        } catch (IllegalArgumentException e) {
+            // not e itself, whose message quotes the key
+            throw new IllegalArgumentException(
+                    "QUIC-LB key must be hexadecimal");
+        }
+        if (k.length != KEY_LEN) {
+            throw new IllegalArgumentException(
+                    "QUIC-LB key must be " + KEY_LEN + " bytes");
+        }
+        this.key = k;
+    }
+
+    // ── ConnectionIdGenerator ──
+
+    /**
+     * @throws IllegalStateException if no server ID is set, or the
+     *         server ID and nonce are longer than 19 bytes together
+     */
+    @Override
+    public int getLength() {
+        if (serverId == null) {
+            throw new IllegalStateException("QUIC-LB server ID not set");
+        }
+        int nonce = (nonceLength > 0)
+                ? nonceLength : MAX_PLAINTEXT_LEN - serverId.length;
+        if (nonce < MIN_NONCE_LEN
+                || serverId.length + nonce > MAX_PLAINTEXT_LEN) {
+            throw new IllegalStateException("QUIC-LB server ID ("
+                    + serverId.length + ") and nonce (" + nonce
+                    + ") lengths exceed " + MAX_PLAINTEXT_LEN + " bytes");
+        }
+        return 1 + serverId.length + nonce;
+    }
+
+    @Override
+    public byte[] generate() {
+        int length = getLength();
+        byte[] nonce = new byte[length - 1 - serverId.length];
+        random.nextBytes(nonce);
+
+        byte[] cid = new byte[length];
+        cid[0] = (byte) ((configId << 5) | (length - 1));
+        System.arraycopy(serverId, 0, cid, 1, serverId.length);
+        System.arraycopy(nonce, 0, cid, 1 + serverId.length, nonce.length);
+        if (key != null && GumdropNative.quic_lb_encrypt(key, cid) != 0) {
+            throw new IllegalStateException(
+                    "Cannot encrypt QUIC-LB connection ID");
+        }
+        return cid;
+    }
+
+}
@@ -45,6 +45,8 @@ final class QuicSecurityInfo implements SecurityInfo {
     private final String applicationProtocol;
     private final Certificate[] peerCertificates;
     private final long handshakeDurationMs;
+    private final boolean sessionResumed;
+    private final boolean earlyDataAccepted;
 
     /**
      * Creates a QuicSecurityInfo by reading state from a quiche connection.
@@ -60,6 +62,9 @@ final class QuicSecurityInfo implements SecurityInfo {
         this.peerCertificates = parsePeerCerts(connPtr);
         this.handshakeDurationMs =
                 System.currentTimeMillis() - handshakeStartTime;
+        this.sessionResumed = GumdropNative.ssl_session_reused(sslPtr);
+        this.earlyDataAccepted =
+                GumdropNative.ssl_early_data_accepted(sslPtr);
     }
 
     @Override
@@ -108,9 +113,12 @@ final class QuicSecurityInfo implements SecurityInfo {
 
     @Override
     public boolean isSessionResumed() {
-        // QUIC uses TLS 1.3 session tickets rather than traditional
-        // session resumption. This is not directly observable via quiche.
-        return false;
+        return sessionResumed;
+    }
+
+    @Override
+    public boolean isEarlyDataAccepted() {
+        return earlyDataAccepted;
     }
 
     private static Certificate[] parsePeerCerts(long connPtr) {
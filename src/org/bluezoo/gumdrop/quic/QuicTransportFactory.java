@@ -29,9 +29,19 @@ import java.net.InetAddress;
 import java.net.InetSocketAddress;
 import java.net.StandardProtocolFamily;
 import java.nio.channels.DatagramChannel;
+import java.nio.file.Files;
 import java.nio.file.Path;
+import java.security.GeneralSecurityException;
 import java.text.MessageFormat;
+import java.util.HashMap;
+import java.util.LinkedHashMap;
+import java.util.Map;
 import java.util.ResourceBundle;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.Executors;
+import java.util.concurrent.ScheduledExecutorService;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicLong;
 import java.util.logging.Level;
 import java.util.logging.Logger;
 
@@ -39,6 +49,8 @@ import org.bluezoo.gumdrop.ProtocolHandler;
 import org.bluezoo.gumdrop.SelectorLoop;
 import org.bluezoo.gumdrop.StreamAcceptHandler;
 import org.bluezoo.gumdrop.TransportFactory;
+import org.bluezoo.gumdrop.ratelimit.ConnectionRateLimiter;
+import org.bluezoo.gumdrop.util.CIDRNetwork;
 
 /**
  * Factory for QUIC endpoints, backed by quiche and BoringSSL via JNI.
@@ -89,8 +101,18 @@ public class QuicTransportFactory extends TransportFactory {
     private static final long DEFAULT_MAX_STREAM_DATA = 1_000_000;
     private static final long DEFAULT_MAX_STREAMS_BIDI = 100;
     private static final long DEFAULT_MAX_STREAMS_UNI = 100;
-    private static final long DEFAULT_MAX_RECV_PAYLOAD = 1350;
-    private static final long DEFAULT_MAX_SEND_PAYLOAD = 1350;
+    // Flow control auto-tuning ceilings (quiche's own defaults)
+    private static final long DEFAULT_MAX_CONNECTION_WINDOW = 24L << 20;
+    private static final long DEFAULT_MAX_STREAM_WINDOW = 16L << 20;
+    private static final int DEFAULT_MAX_UDP_PAYLOAD = 1350;
+    /** RFC 9000 section 14: the smallest datagram QUIC may assume. */
+    private static final int MIN_UDP_PAYLOAD = 1200;
+    private static final int DEFAULT_SESSION_CACHE_SIZE = 256;
+    // From this percentage of the native memory limit, new connections
+    // get their flow control limits shifted right by this much
+    private static final int CONSTRAINED_PERCENT = 80;
+    private static final int CONSTRAINED_WINDOW_SHIFT = 2;
+    private static final int DEFAULT_PRIVATE_KEY_THREADS = 0;
 
     // Congestion control algorithms (quiche enum values)
     /** Reno congestion control. */
@@ -99,14 +121,39 @@ public class QuicTransportFactory extends TransportFactory {
     public static final int CC_CUBIC = 1;
     /** BBR congestion control. */
     public static final int CC_BBR = 2;
+    /** BBRv2 congestion control. */
+    public static final int CC_BBR2 = 3;
 
-    // BoringSSL SSL_CTX handle (shared by all connections)
+    // RFC 8879 section 7.3: certificate compression algorithm IDs
+    static final int CERT_COMPRESSION_ZLIB = 1;
+    static final int CERT_COMPRESSION_BROTLI = 2;
+
+    // BoringSSL SSL_CTX handle for new connections; each SSL holds its
+    // own reference, so a replaced context lives until its last
+    // connection closes
     private long sslCtx;
+    private final Object sslCtxLock = new Object();
+
+    // SSL_CTX for client connections, built with the first client
+    // engine. It is kept apart so that the client session cache only
+    // ever holds sessions servers send us, never those we issue.
+    private long clientSslCtx;
 
     // quiche config handles (one per supported QUIC version)
     private long quicheConfigV1;
     private long quicheConfigV2;
 
+    // quiche config handles for profiles chosen by peer address,
+    // { v1, v2 } by profile
+    private final Map<CongestionProfile, long[]> profileConfigs =
+            new HashMap<CongestionProfile, long[]>();
+
+    // quiche config handles with reduced flow control limits, used near
+    // the native memory limit; { v1, v2 } by profile, null for the
+    // default
+    private final Map<CongestionProfile, long[]> constrainedConfigs =
+            new HashMap<CongestionProfile, long[]>();
+
     // QUIC-specific configuration
     private String applicationProtocols;
     private Path caFile;
@@ -120,7 +167,52 @@ public class QuicTransportFactory extends TransportFactory {
     private long maxStreamDataUni = DEFAULT_MAX_STREAM_DATA;
     private long maxStreamsBidi = DEFAULT_MAX_STREAMS_BIDI;
     private long maxStreamsUni = DEFAULT_MAX_STREAMS_UNI;
+    private long maxConnectionWindow = DEFAULT_MAX_CONNECTION_WINDOW;
+    private long maxStreamWindow = DEFAULT_MAX_STREAM_WINDOW;
     private int ccAlgorithm = CC_CUBIC;
+    private CongestionProfile congestionProfile;
+    private Map<CIDRNetwork, CongestionProfile> profileNetworks;
+    private int maxUdpPayloadSize = DEFAULT_MAX_UDP_PAYLOAD;
+    private boolean pmtuDiscovery;
+    private boolean receiveTimestamps;
+    private volatile ReceiveDelayListener receiveDelayListener;
+    private long nativeMemoryLimit;
+    private int sessionCacheSize = DEFAULT_SESSION_CACHE_SIZE;
+    private SessionTicketKeys sessionTicketKeys;
+    private ConnectionIdGenerator connectionIdGenerator;
+    private int certCompression = (1 << (CERT_COMPRESSION_ZLIB - 1))
+            | (1 << (CERT_COMPRESSION_BROTLI - 1));
+
+    private int privateKeyThreads = DEFAULT_PRIVATE_KEY_THREADS;
+    private volatile boolean asyncPrivateKey;
+    private boolean privateKeyPool; // guarded by this
+
+    // RFC 6066 section 3: certificates by server name
+    private Map<String, String> sniCertificates;
+    private Path sniCertificateDirectory;
+
+    // Certificate file watch
+    private long certificateCheckInterval;
+    private long certificateStamp;
+    private ScheduledExecutorService certificateWatcher;
+
+    // Server handshake budget, per engine
+    private int maxHalfOpenHandshakes;
+    private int handshakeRate;
+    private int handshakeBurst;
+    private ConnectionRateLimiter connectionRateLimiter;
+
+    // RFC 6066 section 8: fetches the response stapled by sslCtx
+    private OCSPStapler ocspStapler;
+
+    // Server handshakes that may be waiting for a signature, by SSL handle
+    private final Map<Long, QuicConnection> pendingHandshakes =
+            new ConcurrentHashMap<Long, QuicConnection>();
+
+    // Full handshakes by certificate compression algorithm
+    private final AtomicLong uncompressedHandshakes = new AtomicLong();
+    private final AtomicLong zlibHandshakes = new AtomicLong();
+    private final AtomicLong brotliHandshakes = new AtomicLong();
 
     public QuicTransportFactory() {
         // QUIC is always secure
@@ -163,6 +255,251 @@ public class QuicTransportFactory extends TransportFactory {
         return earlyDataEnabled;
     }
 
+    /**
+     * Sets how many servers' session tickets client connections
+     * remember for resumption (RFC 8446 section 2.2). A reconnection to
+     * a server with a cached ticket skips certificate exchange and,
+     * with {@link #setEarlyDataEnabled early data} enabled, can send
+     * its first request in 0-RTT. Set to 0 to disable.
+     *
+     * @param size the number of server names to cache
+     */
+    public void setSessionCacheSize(int size) {
+        this.sessionCacheSize = size;
+    }
+
+    /**
+     * Sets the keys used to encrypt and decrypt the session tickets this
+     * server issues. Factories sharing one {@link SessionTicketKeys}, in
+     * this process or across a cluster, accept each other's tickets for
+     * resumption and 0-RTT. Without it each factory uses a random key.
+     *
+     * @param keys the shared ticket keys, or null
+     */
+    public void setSessionTicketKeys(SessionTicketKeys keys) {
+        this.sessionTicketKeys = keys;
+    }
+
+    /**
+     * Sets the generator of the connection IDs this factory's engines
+     * issue, for example a {@link QuicLbConnectionIdGenerator} so that a
+     * stateless load balancer can route each connection's packets to
+     * this node. Without one, connection IDs are 20 random bytes.
+     *
+     * @param generator the connection ID generator, or null
+     */
+    public void setConnectionIdGenerator(ConnectionIdGenerator generator) {
+        this.connectionIdGenerator = generator;
+    }
+
+    ConnectionIdGenerator getConnectionIdGenerator() {
+        return connectionIdGenerator;
+    }
+
+    /**
+     * Sets the number of native threads that compute handshake
+     * signatures with the server's private key. Signing then happens
+     * off the SelectorLoop, so an RSA signature does not delay the
+     * other connections on the loop. The pool is shared by all
+     * factories, grows to the largest size any of them asks for, and is
+     * stopped when the last of them stops. Default: 0, which signs
+     * synchronously; about half the available processors suits
+     * listeners that see bursts of full handshakes.
+     *
+     * @param threads the number of signing threads
+     */
+    public void setPrivateKeyThreads(int threads) {
+        this.privateKeyThreads = threads;
+    }
+
+    /**
+     * Sets the certificate compression algorithms (RFC 8879) offered to
+     * and accepted from the peer: a comma-separated list of
+     * {@code brotli} and {@code zlib}, or {@code none}. Compressing the
+     * server certificate chain helps the first flight fit within the
+     * anti-amplification limit (RFC 9000 section 8.1), avoiding an extra
+     * round trip. Default: {@code brotli,zlib}.
+     *
+     * @param algorithms the algorithms
+     */
+    public void setCertificateCompression(String algorithms) {
+        int mask = 0;
+        for (String alg : algorithms.split(",")) {
+            alg = alg.trim();
+            if ("zlib".equalsIgnoreCase(alg)) {
+                mask |= 1 << (CERT_COMPRESSION_ZLIB - 1);
+            } else if ("brotli".equalsIgnoreCase(alg)) {
+                mask |= 1 << (CERT_COMPRESSION_BROTLI - 1);
+            } else if (!"none".equalsIgnoreCase(alg) && !alg.isEmpty()) {
+                throw new IllegalArgumentException(
+                        "Unknown certificate compression algorithm: "
+                        + alg);
+            }
+        }
+        this.certCompression = mask;
+    }
+
+    /**
+     * Returns the number of full handshakes whose certificate was sent
+     * or received uncompressed. Resumed handshakes carry no certificate
+     * and are not counted.
+     */
+    public long getUncompressedHandshakeCount() {
+        return uncompressedHandshakes.get();
+    }
+
+    /**
+     * Returns the number of full handshakes whose certificate was
+     * compressed with the given algorithm ({@code zlib} or
+     * {@code brotli}).
+     *
+     * @param algorithm the algorithm name
+     */
+    public long getCompressedHandshakeCount(String algorithm) {
+        if ("zlib".equalsIgnoreCase(algorithm)) {
+            return zlibHandshakes.get();
+        }
+        if ("brotli".equalsIgnoreCase(algorithm)) {
+            return brotliHandshakes.get();
+        }
+        return 0;
+    }
+
+    /**
+     * Counts a completed full handshake by certificate compression.
+     *
+     * @param algorithm the RFC 8879 algorithm ID, or 0 for none
+     */
+    void recordCertificateCompression(int algorithm) {
+        switch (algorithm) {
+            case CERT_COMPRESSION_ZLIB:
+                zlibHandshakes.incrementAndGet();
+                break;
+            case CERT_COMPRESSION_BROTLI:
+                brotliHandshakes.incrementAndGet();
+                break;
+            default:
+                uncompressedHandshakes.incrementAndGet();
+        }
+    }
+
+    /**
+     * Sets certificates to present by server name (RFC 6066 section 3),
+     * so that one listener can serve many domains. Keys are server
+     * names, or {@code *.example.com} for every name directly under
+     * {@code example.com}; exact names take precedence. Each value is a
+     * PEM file holding the certificate chain and private key, or the
+     * chain and key files separated by a comma. Files are loaded when
+     * the factory starts or reloads its certificates, not during
+     * handshakes. Clients that send no server name, or one with no
+     * certificate, get the {@link #setCertFile default certificate}.
+     *
+     * @param certificates the certificate files by server name
+     */
+    public void setSniCertificates(Map<String, String> certificates) {
+        this.sniCertificates = certificates;
+    }
+
+    /**
+     * Sets a directory of certificates for server names that were not
+     * given to {@link #setSniCertificates}, laid out as mkcert writes
+     * them: {@code example.com.pem} holds the chain, and the key unless
+     * {@code example.com-key.pem} exists; {@code _wildcard.example.com.pem}
+     * covers {@code *.example.com}. The directory's certificates are
+     * loaded when the factory starts or reloads its certificates. A name
+     * not found is looked for in the directory again during a handshake
+     * at most once a minute, so tenants can be added without
+     * reconfiguring the listener; with a
+     * {@link #setCertificateCheckInterval certificate check interval},
+     * adding a file reloads the certificates off the SelectorLoop.
+     *
+     * @param dir the certificate directory
+     */
+    public void setSniCertificateDirectory(Path dir) {
+        this.sniCertificateDirectory = dir;
+    }
+
+    public void setSniCertificateDirectory(String dir) {
+        this.sniCertificateDirectory = Path.of(dir);
+    }
+
+    /**
+     * Sets how often the certificate, key, CA and SNI files are checked
+     * for changes, in milliseconds. When any has been modified the
+     * certificates are {@link #reloadCertificates reloaded}. Set to 0
+     * (the default) to reload only on request.
+     *
+     * @param ms the check interval in milliseconds
+     */
+    public void setCertificateCheckInterval(long ms) {
+        this.certificateCheckInterval = ms;
+    }
+
+    /**
+     * Limits how many connections each server engine may have
+     * handshaking at once. Beyond half of this, clients must prove
+     * their address with a Retry first; beyond it, they are refused
+     * with CONNECTION_CLOSE. 0 (the default) sets no limit.
+     *
+     * @param max the most half-open connections per engine
+     */
+    public void setMaxHalfOpenHandshakes(int max) {
+        this.maxHalfOpenHandshakes = max;
+    }
+
+    /**
+     * Limits how many handshakes each server engine starts per second,
+     * so a burst of new clients cannot starve established connections
+     * of the SelectorLoop. 0 (the default) sets no limit.
+     *
+     * @param perSecond handshakes per second
+     * @see #setHandshakeBurst
+     */
+    public void setHandshakeRate(int perSecond) {
+        this.handshakeRate = perSecond;
+    }
+
+    /**
+     * Sets how many handshakes may start at once when the
+     * {@link #setHandshakeRate handshake rate} allows. Defaults to the
+     * rate, that is, one second's worth.
+     *
+     * @param burst the handshake burst size
+     */
+    public void setHandshakeBurst(int burst) {
+        this.handshakeBurst = burst;
+    }
+
+    /**
+     * Applies per-address connection limits to server handshakes. A
+     * client is only held to them once a Retry has proved its address,
+     * so that spoofed packets cannot use up another host's allowance.
+     *
+     * @param limiter the per-address limits, or null
+     */
+    public void setConnectionRateLimiter(ConnectionRateLimiter limiter) {
+        this.connectionRateLimiter = limiter;
+    }
+
+    /**
+     * Returns the handshake budget for a new server engine, or null if
+     * no limits are configured.
+     */
+    HandshakeAdmission newHandshakeAdmission() {
+        if (maxHalfOpenHandshakes <= 0 && handshakeRate <= 0
+                && connectionRateLimiter == null) {
+            return null;
+        }
+        int burst = (handshakeBurst > 0) ? handshakeBurst : handshakeRate;
+        return new HandshakeAdmission(maxHalfOpenHandshakes, handshakeRate,
+                burst, connectionRateLimiter);
+    }
+
+    private boolean hasSniCertificates() {
+        return (sniCertificates != null && !sniCertificates.isEmpty())
+                || sniCertificateDirectory != null;
+    }
+
     /**
      * Sets the CA certificate file for peer verification.
      *
@@ -257,10 +594,46 @@ public class QuicTransportFactory extends TransportFactory {
         this.maxStreamsUni = count;
     }
 
+    /**
+     * Sets how far quiche may grow the connection-level receive window
+     * beyond {@link #setMaxData max data}. The window doubles whenever
+     * the application reads a window's worth of data in less than two
+     * round trips, so the initial limits can stay small to bound memory
+     * per connection while a fast reader on a long path still reaches
+     * bandwidth times RTT (e.g. 125 MB for 10 Gbit/s at 100 ms).
+     * Default: 24 MB.
+     *
+     * @param bytes the window ceiling in bytes
+     */
+    public void setMaxConnectionWindow(long bytes) {
+        this.maxConnectionWindow = bytes;
+    }
+
+    /**
+     * Sets how far quiche may grow each stream's receive window beyond
+     * its initial limit, as for
+     * {@link #setMaxConnectionWindow the connection window}.
+     * Default: 16 MB.
+     *
+     * @param bytes the window ceiling in bytes
+     */
+    public void setMaxStreamWindow(long bytes) {
+        this.maxStreamWindow = bytes;
+    }
+
+    long getMaxConnectionWindow() {
+        return maxConnectionWindow;
+    }
+
+    long getMaxStreamWindow() {
+        return maxStreamWindow;
+    }
+
     /**
      * Sets the congestion control algorithm.
-     * Use {@link #CC_RENO}, {@link #CC_CUBIC}, or {@link #CC_BBR}.
-     * Default: {@link #CC_CUBIC}.
+     * Use {@link #CC_RENO}, {@link #CC_CUBIC}, {@link #CC_BBR} or
+     * {@link #CC_BBR2}. Default: {@link #CC_CUBIC}. A
+     * {@link #setCongestionProfile congestion profile} takes precedence.
      *
      * @param algorithm the congestion control algorithm
      */
@@ -268,10 +641,236 @@ public class QuicTransportFactory extends TransportFactory {
         this.ccAlgorithm = algorithm;
     }
 
+    /**
+     * Sets the congestion control profile for connections, in place of
+     * the {@link #setCongestionControl algorithm} alone.
+     *
+     * @param profile the profile, or null for quiche's defaults
+     */
+    public void setCongestionProfile(CongestionProfile profile) {
+        this.congestionProfile = profile;
+    }
+
+    /**
+     * Sets the congestion control profile for connections by name.
+     *
+     * @param name a built-in profile name
+     * @see CongestionProfile#forName
+     */
+    public void setCongestionProfile(String name) {
+        this.congestionProfile = CongestionProfile.forName(name);
+    }
+
+    /**
+     * Chooses a different congestion control profile for server
+     * connections from some client networks, for instance
+     * {@code datacenter} for peers in the same site. Keys are CIDR
+     * blocks and values built-in profile names; the first block that
+     * contains the client's address applies, and other clients get the
+     * {@link #setCongestionProfile default profile}.
+     *
+     * @param networks profile names by CIDR block, in order
+     */
+    public void setCongestionProfileNetworks(Map<String, String> networks) {
+        if (networks == null || networks.isEmpty()) {
+            this.profileNetworks = null;
+            return;
+        }
+        Map<CIDRNetwork, CongestionProfile> map =
+                new LinkedHashMap<CIDRNetwork, CongestionProfile>();
+        for (Map.Entry<String, String> entry : networks.entrySet()) {
+            map.put(new CIDRNetwork(entry.getKey().trim()),
+                    CongestionProfile.forName(entry.getValue()));
+        }
+        this.profileNetworks = map;
+    }
+
+    /**
+     * Returns the profile for a client, or null to use the default.
+     */
+    CongestionProfile congestionProfileFor(InetAddress peer) {
+        if (profileNetworks != null) {
+            for (Map.Entry<CIDRNetwork, CongestionProfile> entry
+                    : profileNetworks.entrySet()) {
+                if (entry.getKey().matches(peer)) {
+                    return entry.getValue();
+                }
+            }
+        }
+        return null;
+    }
+
+    /**
+     * Sets the largest UDP payload connections will send and receive,
+     * advertised to peers as the max_udp_payload_size transport
+     * parameter (RFC 9000 section 18.2). The default, 1350, fits
+     * Internet paths; on a network with jumbo frames set it to the
+     * link MTU less the IP and UDP headers (8972 for IPv4 or 8952 for
+     * IPv6 at MTU 9000). Without
+     * {@link #setPmtuDiscovery path MTU discovery} connections send
+     * datagrams of this size as soon as the handshake completes, so it
+     * must not exceed the smallest MTU on the path.
+     *
+     * @param size the payload size in bytes, at least 1200
+     */
+    public void setMaxUdpPayloadSize(int size) {
+        if (size < MIN_UDP_PAYLOAD || size > 65527) {
+            throw new IllegalArgumentException(
+                    "max UDP payload size out of range: " + size);
+        }
+        this.maxUdpPayloadSize = size;
+    }
+
+    /**
+     * Returns the largest UDP payload connections will send, which is
+     * also the size of each engine's send buffer.
+     */
+    public int getMaxUdpPayloadSize() {
+        return maxUdpPayloadSize;
+    }
+
+    /**
+     * Enables packetization layer path MTU discovery (RFC 8899): each
+     * connection starts at 1200 bytes and probes upwards to the
+     * {@link #setMaxUdpPayloadSize maximum UDP payload size}, so a
+     * large maximum is safe on paths that cannot carry it. On Linux
+     * the UDP sockets also send with Don't Fragment set so that probes
+     * too large for the path are lost rather than fragmented.
+     *
+     * @param enabled whether to discover the path MTU
+     */
+    public void setPmtuDiscovery(boolean enabled) {
+        this.pmtuDiscovery = enabled;
+    }
+
+    /**
+     * Has the kernel timestamp each datagram received on the engines'
+     * sockets (SO_TIMESTAMPING on Linux; ignored elsewhere), so that the
+     * time it waited before being read is reported to the
+     * {@link #setReceiveDelayListener receive delay listener}. quiche
+     * cannot be given the receive time, so its RTT samples still
+     * include that wait.
+     *
+     * @param enabled whether to timestamp received datagrams
+     */
+    public void setReceiveTimestamps(boolean enabled) {
+        this.receiveTimestamps = enabled;
+    }
+
+    boolean isReceiveTimestamps() {
+        return receiveTimestamps;
+    }
+
+    /**
+     * Sets the listener told how long each received datagram waited
+     * before being read, when {@link #setReceiveTimestamps receive
+     * timestamps} are enabled.
+     *
+     * @param listener the listener, or null
+     */
+    public void setReceiveDelayListener(ReceiveDelayListener listener) {
+        this.receiveDelayListener = listener;
+    }
+
+    ReceiveDelayListener getReceiveDelayListener() {
+        return receiveDelayListener;
+    }
+
+    /**
+     * Sets a ceiling on the native memory used by the QUIC stack, as
+     * measured by {@link NativeMemory#getUsage}. From 80% of it, new
+     * server connections get a quarter of the configured flow control
+     * limits and window ceilings, so that peers can buffer less in
+     * them; at the limit, new connections are refused with
+     * CONNECTION_REFUSED (RFC 9000 section 20.1) until usage falls.
+     * Connections already open keep their windows, which quiche cannot
+     * shrink. Usage is sampled once a second, so the limit should leave
+     * headroom below the point where the process would be killed.
+     * Native memory the process had already allocated when the first
+     * QUIC engine opened does not count towards it, but anything it
+     * allocates on the native heap afterwards does, whether or not it is
+     * for QUIC. Default: 0, no limit.
+     *
+     * @param bytes the limit in bytes, or 0
+     */
+    public void setNativeMemoryLimit(long bytes) {
+        this.nativeMemoryLimit = bytes;
+    }
+
+    long getNativeMemoryLimit() {
+        return nativeMemoryLimit;
+    }
+
+    /**
+     * Returns whether native memory usage has reached the limit, so
+     * that new connections should be refused.
+     */
+    boolean isNativeMemoryExhausted() {
+        return exceeds(getNativeMemoryUsage(), nativeMemoryLimit, 100);
+    }
+
+    /**
+     * Returns whether native memory usage is close enough to the limit
+     * that new connections should get reduced windows.
+     */
+    boolean isNativeMemoryConstrained() {
+        return exceeds(getNativeMemoryUsage(), nativeMemoryLimit,
+                CONSTRAINED_PERCENT);
+    }
+
+    /** Returns the usage compared with the native memory limit. */
+    long getNativeMemoryUsage() {
+        return NativeMemory.getUsage();
+    }
+
+    static boolean exceeds(long usage, long limit, int percent) {
+        if (limit <= 0) {
+            return false;
+        }
+        if (usage > Long.MAX_VALUE / 100 || limit > Long.MAX_VALUE / 100) {
+            return (double) usage * 100 >= (double) limit * percent;
+        }
+        return usage * 100 >= limit * percent;
+    }
+
     // ── Native handle accessors (package-private) ──
 
-    long getSslCtx() {
-        return sslCtx;
+    /**
+     * Creates the SSL for a new server connection from the current
+     * SSL_CTX.
+     *
+     * @return the SSL handle, or 0 on failure
+     */
+    long newSsl() {
+        synchronized (sslCtxLock) {
+            return (sslCtx != 0) ? GumdropNative.ssl_new(sslCtx) : 0;
+        }
+    }
+
+    /**
+     * Creates the SSL for a new client connection from the client
+     * SSL_CTX.
+     *
+     * @return the SSL handle, or 0 on failure
+     */
+    long newClientSsl() {
+        synchronized (sslCtxLock) {
+            return (clientSslCtx != 0)
+                    ? GumdropNative.ssl_new(clientSslCtx) : 0;
+        }
+    }
+
+    /**
+     * Removes and returns a cached session for a client connection to
+     * the given server, or null.
+     */
+    byte[] takeSession(String serverName) {
+        synchronized (sslCtxLock) {
+            return (clientSslCtx != 0 && sessionCacheSize > 0)
+                    ? GumdropNative.ssl_ctx_take_session(clientSslCtx,
+                            serverName)
+                    : null;
+        }
     }
 
     /**
@@ -298,6 +897,40 @@ public class QuicTransportFactory extends TransportFactory {
         return 0;
     }
 
+    /**
+     * Returns the quiche config for a new server connection from the
+     * given client, with the congestion profile chosen for its network.
+     *
+     * @param version the QUIC version from the incoming packet
+     * @param peer the client's address
+     * @return the config handle, or 0 if the version is not supported
+     */
+    long getQuicheConfig(int version, InetAddress peer) {
+        CongestionProfile profile = congestionProfileFor(peer);
+        if (profile != null && !profileConfigs.containsKey(profile)) {
+            profile = null;
+        }
+        if (!constrainedConfigs.isEmpty() && isNativeMemoryConstrained()) {
+            long config = versionConfig(constrainedConfigs.get(profile),
+                    version);
+            if (config != 0) {
+                return config;
+            }
+        }
+        long config = versionConfig(profileConfigs.get(profile), version);
+        return (config != 0) ? config : getQuicheConfig(version);
+    }
+
+    private static long versionConfig(long[] configs, int version) {
+        if (configs != null && version == QUICHE_PROTOCOL_VERSION_1) {
+            return configs[0];
+        }
+        if (configs != null && version == QUICHE_PROTOCOL_VERSION_2) {
+            return configs[1];
+        }
+        return 0;
+    }
+
     /**
      * Returns true if the given QUIC version is supported by this server.
      */
@@ -313,24 +946,70 @@ public class QuicTransportFactory extends TransportFactory {
 
         GumdropNative.quiche_enable_debug_logging();
 
-        initSslCtx();
+        if (connectionIdGenerator != null) {
+            // Fail now on an incomplete configuration, not per connection
+            connectionIdGenerator.getLength();
+        }
+        installSslCtx(false);
         initQuicheConfig();
+        if (certificateCheckInterval > 0) {
+            startCertificateWatcher();
+        }
 
         if (LOGGER.isLoggable(Level.INFO)) {
             LOGGER.info("QuicTransportFactory started: " + getDescription());
         }
     }
 
-    private void initSslCtx() {
-        sslCtx = GumdropNative.ssl_ctx_new(true);
-        if (sslCtx == 0) {
+    /**
+     * Builds an SSL_CTX from the current configuration.
+     *
+     * @param ocspResponse the OCSP response to staple, or null
+     * @throws RuntimeException if a file cannot be loaded or a setting
+     *         is rejected
+     */
+    private long createSslCtx(byte[] ocspResponse) {
+        return createSslCtx(ocspResponse, false);
+    }
+
+    /**
+     * Builds an SSL_CTX from the current configuration, for server or
+     * for client connections. Only client contexts cache sessions; only
+     * server contexts get SNI certificates, ticket keys and asynchronous
+     * signing.
+     */
+    private long createSslCtx(byte[] ocspResponse, boolean client) {
+        long ctx = GumdropNative.ssl_ctx_new(!client);
+        if (ctx == 0) {
             throw new RuntimeException("Failed to create BoringSSL SSL_CTX");
         }
+        try {
+            configureSslCtx(ctx, client);
+            // The stapler's responses are set on the published context
+            // later, which then only swaps the response
+            if (!client && ocspStapling && certFile != null
+                    && GumdropNative.ssl_ctx_enable_ocsp_stapling(ctx)
+                            != 0) {
+                throw new RuntimeException(
+                        "Failed to enable OCSP stapling");
+            }
+            if (ocspResponse != null
+                    && GumdropNative.ssl_ctx_set_ocsp_response(ctx,
+                            ocspResponse) != 0) {
+                LOGGER.warning("Failed to set OCSP response");
+            }
+        } catch (RuntimeException e) {
+            GumdropNative.ssl_ctx_free(ctx);
+            throw e;
+        }
+        return ctx;
+    }
 
+    private void configureSslCtx(long ctx, boolean client) {
         int rc;
 
         if (certFile != null) {
-            rc = GumdropNative.ssl_ctx_load_cert_chain(sslCtx,
+            rc = GumdropNative.ssl_ctx_load_cert_chain(ctx,
                     certFile.toString());
             if (rc != 0) {
                 throw new RuntimeException(
@@ -339,7 +1018,7 @@ public class QuicTransportFactory extends TransportFactory {
         }
 
         if (keyFile != null) {
-            rc = GumdropNative.ssl_ctx_load_priv_key(sslCtx,
+            rc = GumdropNative.ssl_ctx_load_priv_key(ctx,
                     keyFile.toString());
             if (rc != 0) {
                 throw new RuntimeException(
@@ -347,8 +1026,36 @@ public class QuicTransportFactory extends TransportFactory {
             }
         }
 
+        if (sniCertificates != null && !client) {
+            for (Map.Entry<String, String> entry
+                    : sniCertificates.entrySet()) {
+                String[] files = sniFiles(entry.getValue());
+                rc = GumdropNative.ssl_ctx_add_sni_host(ctx,
+                        entry.getKey(), files[0], files[1]);
+                if (rc == -2) {
+                    throw new RuntimeException(
+                            "Failed to load SNI certificate for "
+                            + entry.getKey() + ": " + entry.getValue());
+                } else if (rc != 0) {
+                    throw new RuntimeException(
+                            "Invalid or duplicate SNI server name: "
+                            + entry.getKey());
+                }
+            }
+        }
+
+        if (sniCertificateDirectory != null && !client) {
+            rc = GumdropNative.ssl_ctx_set_sni_directory(ctx,
+                    sniCertificateDirectory.toString());
+            if (rc != 0) {
+                throw new RuntimeException(
+                        "Failed to set SNI certificate directory: "
+                        + sniCertificateDirectory);
+            }
+        }
+
         if (caFile != null) {
-            rc = GumdropNative.ssl_ctx_load_verify_locations(sslCtx,
+            rc = GumdropNative.ssl_ctx_load_verify_locations(ctx,
                     caFile.toString());
             if (rc != 0) {
                 throw new RuntimeException(
@@ -358,7 +1065,7 @@ public class QuicTransportFactory extends TransportFactory {
 
         if (cipherSuites != null) {
             rc = GumdropNative.ssl_ctx_set_ciphersuites(
-                    sslCtx, cipherSuites);
+                    ctx, cipherSuites);
             if (rc != 0) {
                 throw new RuntimeException(
                         "Failed to set cipher suites: " + cipherSuites);
@@ -366,7 +1073,7 @@ public class QuicTransportFactory extends TransportFactory {
         }
 
         if (namedGroups != null) {
-            rc = GumdropNative.ssl_ctx_set_groups(sslCtx, namedGroups);
+            rc = GumdropNative.ssl_ctx_set_groups(ctx, namedGroups);
             if (rc != 0) {
                 throw new RuntimeException(
                         "Failed to set named groups: " + namedGroups);
@@ -375,7 +1082,7 @@ public class QuicTransportFactory extends TransportFactory {
 
         if (applicationProtocols != null) {
             byte[] alpn = encodeAlpnProtocols(applicationProtocols);
-            rc = GumdropNative.ssl_ctx_set_alpn_protos(sslCtx, alpn);
+            rc = GumdropNative.ssl_ctx_set_alpn_protos(ctx, alpn);
             if (rc != 0) {
                 throw new RuntimeException(
                         "Failed to set ALPN protocols: "
@@ -383,23 +1090,100 @@ public class QuicTransportFactory extends TransportFactory {
             }
         }
 
-        GumdropNative.ssl_ctx_set_verify_peer(sslCtx, verifyPeer);
+        GumdropNative.ssl_ctx_set_verify_peer(ctx, verifyPeer);
+
+        if (client && sessionCacheSize > 0) {
+            GumdropNative.ssl_ctx_enable_session_cache(ctx,
+                    sessionCacheSize);
+        }
+        // quiche_config_enable_early_data only affects quiche's own
+        // SSL_CTX; connections use this one
+        if (earlyDataEnabled) {
+            GumdropNative.ssl_ctx_set_early_data_enabled(ctx, true);
+        }
+        if (certCompression != 0) {
+            rc = GumdropNative.ssl_ctx_enable_cert_compression(ctx,
+                    certCompression);
+            if (rc != 0) {
+                throw new RuntimeException(
+                        "Failed to enable certificate compression");
+            }
+        }
+        if (client) {
+            return;
+        }
+        if (sessionTicketKeys != null) {
+            sessionTicketKeys.register(ctx);
+        }
+        if ((keyFile != null || hasSniCertificates())
+                && privateKeyThreads > 0) {
+            asyncPrivateKey = holdPrivateKeyPool()
+                    && GumdropNative.ssl_ctx_enable_async_private_key(ctx,
+                            new PrivateKeyCompletion()) == 0;
+            if (!asyncPrivateKey) {
+                LOGGER.warning("Asynchronous private key operations"
+                        + " unavailable; signing on the SelectorLoop");
+            }
+        }
     }
 
     private void initQuicheConfig() {
-        quicheConfigV1 = createQuicheConfig(QUICHE_PROTOCOL_VERSION_1);
+        quicheConfigV1 = createQuicheConfig(QUICHE_PROTOCOL_VERSION_1,
+                congestionProfile);
         if (quicheConfigV1 == 0) {
             throw new RuntimeException(
                     "Failed to create quiche config for QUIC v1");
         }
 
-        quicheConfigV2 = createQuicheConfig(QUICHE_PROTOCOL_VERSION_2);
+        quicheConfigV2 = createQuicheConfig(QUICHE_PROTOCOL_VERSION_2,
+                congestionProfile);
         if (quicheConfigV2 != 0) {
             LOGGER.info("QUIC v2 (RFC 9369) support enabled");
         }
+
+        if (profileNetworks != null) {
+            for (CongestionProfile profile : profileNetworks.values()) {
+                if (profile != congestionProfile
+                        && !profileConfigs.containsKey(profile)) {
+                    profileConfigs.put(profile, new long[] {
+                        createQuicheConfig(QUICHE_PROTOCOL_VERSION_1,
+                                profile),
+                        createQuicheConfig(QUICHE_PROTOCOL_VERSION_2,
+                                profile)
+                    });
+                }
+            }
+        }
+
+        if (nativeMemoryLimit > 0) {
+            constrainedConfigs.put(null, new long[] {
+                createQuicheConfig(QUICHE_PROTOCOL_VERSION_1,
+                        congestionProfile, true),
+                createQuicheConfig(QUICHE_PROTOCOL_VERSION_2,
+                        congestionProfile, true)
+            });
+            for (CongestionProfile profile : profileConfigs.keySet()) {
+                constrainedConfigs.put(profile, new long[] {
+                    createQuicheConfig(QUICHE_PROTOCOL_VERSION_1,
+                            profile, true),
+                    createQuicheConfig(QUICHE_PROTOCOL_VERSION_2,
+                            profile, true)
+                });
+            }
+        }
     }
 
-    private long createQuicheConfig(int version) {
+    private long createQuicheConfig(int version, CongestionProfile profile) {
+        return createQuicheConfig(version, profile, false);
+    }
+
+    /**
+     * @param constrained whether to reduce the flow control limits for
+     *        native memory pressure
+     */
+    private long createQuicheConfig(int version, CongestionProfile profile,
+                                    boolean constrained) {
+        int shift = constrained ? CONSTRAINED_WINDOW_SHIFT : 0;
         long config = GumdropNative.quiche_config_new(version);
         if (config == 0) {
             return 0;
@@ -413,23 +1197,37 @@ public class QuicTransportFactory extends TransportFactory {
         GumdropNative.quiche_config_set_max_idle_timeout(
                 config, maxIdleTimeout);
         GumdropNative.quiche_config_set_initial_max_data(
-                config, maxData);
+                config, maxData >> shift);
         GumdropNative.quiche_config_set_initial_max_stream_data_bidi_local(
-                config, maxStreamDataBidiLocal);
+                config, maxStreamDataBidiLocal >> shift);
         GumdropNative.quiche_config_set_initial_max_stream_data_bidi_remote(
-                config, maxStreamDataBidiRemote);
+                config, maxStreamDataBidiRemote >> shift);
         GumdropNative.quiche_config_set_initial_max_stream_data_uni(
-                config, maxStreamDataUni);
+                config, maxStreamDataUni >> shift);
         GumdropNative.quiche_config_set_initial_max_streams_bidi(
                 config, maxStreamsBidi);
         GumdropNative.quiche_config_set_initial_max_streams_uni(
                 config, maxStreamsUni);
-        GumdropNative.quiche_config_set_cc_algorithm(
-                config, ccAlgorithm);
+        GumdropNative.quiche_config_set_max_connection_window(
+                config, maxConnectionWindow >> shift);
+        GumdropNative.quiche_config_set_max_stream_window(
+                config, maxStreamWindow >> shift);
+        // RFC 9002 section 7: a profile replaces the bare algorithm
+        if (profile == null) {
+            GumdropNative.quiche_config_set_cc_algorithm(
+                    config, ccAlgorithm);
+        } else if (!profile.apply(config)) {
+            GumdropNative.quiche_config_free(config);
+            throw new RuntimeException("Congestion profile " + profile
+                    + ": quiche does not support algorithm "
+                    + profile.getAlgorithm());
+        }
         GumdropNative.quiche_config_set_max_recv_udp_payload_size(
-                config, DEFAULT_MAX_RECV_PAYLOAD);
+                config, maxUdpPayloadSize);
         GumdropNative.quiche_config_set_max_send_udp_payload_size(
-                config, DEFAULT_MAX_SEND_PAYLOAD);
+                config, maxUdpPayloadSize);
+        // RFC 8899: probe from 1200 bytes up to maxUdpPayloadSize
+        GumdropNative.quiche_config_discover_pmtu(config, pmtuDiscovery);
 
         // RFC 9250 section 4.5: enable 0-RTT early data for session resumption
         if (earlyDataEnabled) {
@@ -439,6 +1237,18 @@ public class QuicTransportFactory extends TransportFactory {
         return config;
     }
 
+    private static void freeQuicheConfigs(
+            Map<CongestionProfile, long[]> map) {
+        for (long[] configs : map.values()) {
+            for (int i = 0; i < configs.length; i++) {
+                if (configs[i] != 0) {
+                    GumdropNative.quiche_config_free(configs[i]);
+                }
+            }
+        }
+        map.clear();
+    }
+
     @Override
     protected void stop() {
         if (quicheConfigV1 != 0) {
@@ -449,13 +1259,348 @@ public class QuicTransportFactory extends TransportFactory {
             GumdropNative.quiche_config_free(quicheConfigV2);
             quicheConfigV2 = 0;
         }
-        if (sslCtx != 0) {
-            GumdropNative.ssl_ctx_free(sslCtx);
+        freeQuicheConfigs(profileConfigs);
+        freeQuicheConfigs(constrainedConfigs);
+        synchronized (this) {
+            if (certificateWatcher != null) {
+                certificateWatcher.shutdownNow();
+                certificateWatcher = null;
+            }
+        }
+        long ctx;
+        long clientCtx;
+        OCSPStapler stapler;
+        synchronized (sslCtxLock) {
+            ctx = sslCtx;
             sslCtx = 0;
+            clientCtx = clientSslCtx;
+            clientSslCtx = 0;
+            stapler = ocspStapler;
+            ocspStapler = null;
         }
+        if (stapler != null) {
+            stapler.stop();
+        }
+        releaseSslCtx(ctx);
+        if (clientCtx != 0) {
+            GumdropNative.ssl_ctx_free(clientCtx);
+        }
+        releasePrivateKeyPool();
         super.stop();
     }
 
+    /**
+     * Drops the factory's reference to an SSL_CTX. Connections created
+     * from it keep it alive until they close.
+     */
+    private void releaseSslCtx(long ctx) {
+        if (ctx != 0) {
+            if (sessionTicketKeys != null) {
+                sessionTicketKeys.unregister(ctx);
+            }
+            GumdropNative.ssl_ctx_free(ctx);
+        }
+    }
+
+    // ── Certificate reload ──
+
+    /**
+     * Rebuilds the SSL_CTX from the current configuration, re-reading
+     * the certificate, key, CA and SNI files, and gives it to new
+     * connections. Established connections and handshakes in progress
+     * keep the context they started with until they close, so renewing
+     * a certificate does not disconnect anyone. If the new files cannot
+     * be loaded the current certificates stay in use.
+     *
+     * <p>Client session tickets cached by the old context are dropped.
+     *
+     * @throws IllegalStateException if the factory is not started
+     * @throws RuntimeException if the new context cannot be built
+     */
+    public void reloadCertificates() {
+        synchronized (sslCtxLock) {
+            if (sslCtx == 0) {
+                throw new IllegalStateException(
+                        "QuicTransportFactory not started");
+            }
+        }
+        releaseSslCtx(installSslCtx(true));
+        reloadClientSslCtx();
+        if (LOGGER.isLoggable(Level.INFO)) {
+            LOGGER.info("Reloaded QUIC certificates: " + getDescription());
+        }
+    }
+
+    /**
+     * Builds an SSL_CTX, and an OCSP stapler for its certificate, and
+     * makes them current. The stapler's cached response, if any, is
+     * stapled from the start.
+     *
+     * @param reload true if replacing the current context
+     * @return the context no longer in use, or 0
+     */
+    private long installSslCtx(boolean reload) {
+        OCSPStapler stapler = createOcspStapler();
+        byte[] staple = (stapler != null) ? stapler.loadCached() : null;
+        long fresh;
+        try {
+            fresh = createSslCtx(staple);
+        } catch (RuntimeException e) {
+            if (stapler != null) {
+                stapler.stop();
+            }
+            throw e;
+        }
+        long old;
+        OCSPStapler oldStapler;
+        synchronized (sslCtxLock) {
+            if (reload && sslCtx == 0) {
+                // stopped while the new context was built
+                if (stapler != null) {
+                    stapler.stop();
+                }
+                return fresh;
+            }
+            old = sslCtx;
+            sslCtx = fresh;
+            oldStapler = ocspStapler;
+            ocspStapler = stapler;
+        }
+        if (oldStapler != null) {
+            oldStapler.stop();
+        }
+        if (stapler != null) {
+            stapler.start();
+        }
+        return old;
+    }
+
+    /**
+     * Builds the client SSL_CTX if no client engine has needed it yet.
+     */
+    private void ensureClientSslCtx() {
+        synchronized (sslCtxLock) {
+            if (clientSslCtx != 0 || sslCtx == 0) {
+                return;
+            }
+        }
+        // Loads files: built outside the lock
+        long fresh = createSslCtx(null, true);
+        synchronized (sslCtxLock) {
+            if (clientSslCtx == 0 && sslCtx != 0) {
+                clientSslCtx = fresh;
+                fresh = 0;
+            }
+        }
+        if (fresh != 0) {
+            GumdropNative.ssl_ctx_free(fresh);
+        }
+    }
+
+    /**
+     * Rebuilds the client SSL_CTX, if there is one, after the
+     * certificates have been reloaded.
+     */
+    private void reloadClientSslCtx() {
+        synchronized (sslCtxLock) {
+            if (clientSslCtx == 0) {
+                return;
+            }
+        }
+        long fresh = createSslCtx(null, true);
+        long old;
+        synchronized (sslCtxLock) {
+            if (clientSslCtx == 0) {
+                // stopped while the new context was built
+                old = fresh;
+            } else {
+                old = clientSslCtx;
+                clientSslCtx = fresh;
+            }
+        }
+        GumdropNative.ssl_ctx_free(old);
+    }
+
+    private OCSPStapler createOcspStapler() {
+        if (!ocspStapling || certFile == null) {
+            return null;
+        }
+        try {
+            return new OCSPStapler(certFile, ocspResponder,
+                    ocspCacheDirectory, ocspRefreshInterval,
+                    new OCSPUpdate());
+        } catch (IOException e) {
+            LOGGER.log(Level.WARNING, "OCSP stapling disabled", e);
+        } catch (GeneralSecurityException e) {
+            LOGGER.log(Level.WARNING, "OCSP stapling disabled", e);
+        }
+        return null;
+    }
+
+    /**
+     * Staples each new response from the current stapler. A stapler
+     * replaced by a reload may still complete a fetch; its response is
+     * for the old certificate and is ignored.
+     */
+    private class OCSPUpdate implements OCSPStapler.Listener {
+
+        @Override
+        public void ocspResponseChanged(OCSPStapler source,
+                                        byte[] response) {
+            synchronized (sslCtxLock) {
+                if (source == ocspStapler && sslCtx != 0
+                        && GumdropNative.ssl_ctx_set_ocsp_response(sslCtx,
+                                response) != 0) {
+                    LOGGER.warning("Failed to set OCSP response");
+                }
+            }
+        }
+    }
+
+    private synchronized void startCertificateWatcher() {
+        certificateStamp = certificateStamp();
+        certificateWatcher = Executors.newSingleThreadScheduledExecutor(
+                new DaemonThreadFactory("QuicCertificateWatcher"));
+        certificateWatcher.scheduleWithFixedDelay(new Runnable() {
+            @Override
+            public void run() {
+                checkCertificates();
+            }
+        }, certificateCheckInterval, certificateCheckInterval,
+                TimeUnit.MILLISECONDS);
+    }
+
+    private void checkCertificates() {
+        long stamp = certificateStamp();
+        if (stamp == certificateStamp) {
+            return;
+        }
+        // A renewal may replace the certificate and key one at a time;
+        // a mismatched pair fails here and is retried when the other
+        // file changes
+        certificateStamp = stamp;
+        try {
+            reloadCertificates();
+        } catch (RuntimeException e) {
+            LOGGER.log(Level.WARNING, "Certificate reload failed;"
+                    + " keeping the current certificates", e);
+        }
+    }
+
+    /**
+     * Combines the modification times of the certificate files. The SNI
+     * directory's own time changes when files are added, removed or
+     * atomically replaced in it.
+     */
+    private long certificateStamp() {
+        long stamp = 17;
+        stamp = 31 * stamp + lastModified(certFile);
+        stamp = 31 * stamp + lastModified(keyFile);
+        stamp = 31 * stamp + lastModified(caFile);
+        stamp = 31 * stamp + lastModified(sniCertificateDirectory);
+        if (sniCertificates != null) {
+            for (String value : sniCertificates.values()) {
+                String[] files = sniFiles(value);
+                stamp = 31 * stamp + lastModified(Path.of(files[0]));
+                if (files[1] != null) {
+                    stamp = 31 * stamp + lastModified(Path.of(files[1]));
+                }
+            }
+        }
+        return stamp;
+    }
+
+    private static long lastModified(Path path) {
+        if (path == null) {
+            return 0;
+        }
+        try {
+            return Files.getLastModifiedTime(path).toMillis();
+        } catch (IOException e) {
+            return -1;
+        }
+    }
+
+    /**
+     * Splits an SNI certificate value into the chain file and the key
+     * file, which is null if the chain file holds the key.
+     */
+    private static String[] sniFiles(String value) {
+        int comma = value.indexOf(',');
+        if (comma < 0) {
+            return new String[] { value.trim(), null };
+        }
+        return new String[] {
+            value.substring(0, comma).trim(),
+            value.substring(comma + 1).trim()
+        };
+    }
+
+    // ── Asynchronous private key operations ──
+
+    /**
+     * Takes this factory's hold on the shared signing pool, once.
+     */
+    private synchronized boolean holdPrivateKeyPool() {
+        if (!privateKeyPool) {
+            privateKeyPool =
+                    GumdropNative.private_key_pool_start(privateKeyThreads) > 0;
+        }
+        return privateKeyPool;
+    }
+
+    /**
+     * Releases the hold on the signing pool. If no other factory holds
+     * it, waits for the workers to finish their queued signatures and
+     * exit.
+     */
+    private void releasePrivateKeyPool() {
+        boolean held;
+        synchronized (this) {
+            held = privateKeyPool;
+            privateKeyPool = false;
+        }
+        asyncPrivateKey = false;
+        if (held) {
+            GumdropNative.private_key_pool_stop();
+        }
+    }
+
+    /**
+     * Tracks a server connection whose handshake may wait for an
+     * asynchronous signature.
+     */
+    void handshakeStarted(long ssl, QuicConnection conn) {
+        if (asyncPrivateKey) {
+            pendingHandshakes.put(Long.valueOf(ssl), conn);
+        }
+    }
+
+    /**
+     * Stops tracking a connection once its handshake has completed or
+     * it has closed.
+     */
+    void handshakeFinished(long ssl) {
+        pendingHandshakes.remove(Long.valueOf(ssl));
+    }
+
+    /**
+     * Resumes the handshake on the connection's SelectorLoop when its
+     * signature is ready.
+     */
+    private class PrivateKeyCompletion
+            implements GumdropNative.PrivateKeyListener {
+
+        @Override
+        public void privateKeyOperationComplete(long ssl) {
+            QuicConnection conn = pendingHandshakes.get(Long.valueOf(ssl));
+            if (conn != null) {
+                conn.getEngine().resumeHandshake(conn);
+            }
+        }
+
+    }
+
     // ── Engine creation ──
 
     /**
@@ -472,30 +1617,10 @@ public class QuicTransportFactory extends TransportFactory {
                                           StreamAcceptHandler acceptHandler,
                                           SelectorLoop loop)
             throws IOException {
-
-        StandardProtocolFamily family = (bindAddress instanceof Inet6Address)
-                ? StandardProtocolFamily.INET6
-                : StandardProtocolFamily.INET;
-        DatagramChannel dc = DatagramChannel.open(family);
-        dc.configureBlocking(false);
-
-        long t1 = System.currentTimeMillis();
-        dc.bind(new InetSocketAddress(bindAddress, port));
-        long t2 = System.currentTimeMillis();
-
-        QuicEngine engine = new QuicEngine(this, true);
-        engine.init(dc);
+        QuicEngine engine = bindServerEngine(bindAddress, port);
         engine.setStreamAcceptHandler(acceptHandler);
-
-        loop.registerDatagram(dc, engine);
-
-        if (LOGGER.isLoggable(Level.FINE)) {
-            String message = L10N.getString("info.bound_server");
-            message = MessageFormat.format(message,
-                    "QUIC", port, bindAddress, (t2 - t1));
-            LOGGER.fine(message);
-        }
-
+        loop.registerDatagram(engine.getChannel(), engine);
+        QuicHandoff.engineBound(engine);
         return engine;
     }
 
@@ -516,22 +1641,40 @@ public class QuicTransportFactory extends TransportFactory {
             InetAddress bindAddress, int port,
             QuicEngine.ConnectionAcceptedHandler handler,
             SelectorLoop loop) throws IOException {
+        QuicEngine engine = bindServerEngine(bindAddress, port);
+        engine.setConnectionAcceptedHandler(handler);
+        loop.registerDatagram(engine.getChannel(), engine);
+        QuicHandoff.engineBound(engine);
+        return engine;
+    }
 
+    /**
+     * Creates a server-mode QuicEngine on a socket bound to the given
+     * address, or on the socket a previous process bound to it if that
+     * was handed to us by {@link QuicHandoff}.
+     */
+    private QuicEngine bindServerEngine(InetAddress bindAddress, int port)
+            throws IOException {
         StandardProtocolFamily family = (bindAddress instanceof Inet6Address)
                 ? StandardProtocolFamily.INET6
                 : StandardProtocolFamily.INET;
         DatagramChannel dc = DatagramChannel.open(family);
         dc.configureBlocking(false);
+        QuicEngine engine = new QuicEngine(this, true);
+        InetSocketAddress address = new InetSocketAddress(bindAddress, port);
 
         long t1 = System.currentTimeMillis();
-        dc.bind(new InetSocketAddress(bindAddress, port));
+        if (QuicHandoff.adopt(engine, dc, address)) {
+            if (LOGGER.isLoggable(Level.FINE)) {
+                LOGGER.fine("QUIC socket " + address
+                        + " inherited from previous process");
+            }
+            return engine;
+        }
+        configurePmtuDiscovery(dc);
+        dc.bind(address);
         long t2 = System.currentTimeMillis();
-
-        QuicEngine engine = new QuicEngine(this, true);
         engine.init(dc);
-        engine.setConnectionAcceptedHandler(handler);
-
-        loop.registerDatagram(dc, engine);
 
         if (LOGGER.isLoggable(Level.FINE)) {
             String message = L10N.getString("info.bound_server");
@@ -539,7 +1682,6 @@ public class QuicTransportFactory extends TransportFactory {
                     "QUIC", port, bindAddress, (t2 - t1));
             LOGGER.fine(message);
         }
-
         return engine;
     }
 
@@ -560,17 +1702,8 @@ public class QuicTransportFactory extends TransportFactory {
                                String serverName)
             throws IOException {
 
-        StandardProtocolFamily family = (host instanceof Inet6Address)
-                ? StandardProtocolFamily.INET6
-                : StandardProtocolFamily.INET;
-        DatagramChannel dc = DatagramChannel.open(family);
-        dc.configureBlocking(false);
-        dc.bind(null);
-
-        QuicEngine engine = new QuicEngine(this, false);
-        engine.init(dc);
-
-        loop.registerDatagram(dc, engine);
+        QuicEngine engine = createClientEngine(
+                host instanceof Inet6Address, loop);
 
         InetSocketAddress remote = new InetSocketAddress(host, port);
         engine.connectTo(remote, handler, serverName);
@@ -599,11 +1732,41 @@ public class QuicTransportFactory extends TransportFactory {
                                String serverName)
             throws IOException {
 
-        StandardProtocolFamily family = (host instanceof Inet6Address)
+        QuicEngine engine = createClientEngine(
+                host instanceof Inet6Address, loop);
+
+        InetSocketAddress remote = new InetSocketAddress(host, port);
+        engine.connectTo(remote, null, connHandler, serverName);
+
+        return engine;
+    }
+
+    /**
+     * Creates a client-mode QuicEngine on an ephemeral UDP port without
+     * opening any connection. Connections to any number of peers of the
+     * given address family can then be opened on the shared socket with
+     * {@link QuicEngine#connect(InetSocketAddress,
+     * QuicEngine.ConnectionAcceptedHandler, String)}.
+     *
+     * @param ipv6 true for an IPv6 socket, false for IPv4
+     * @param loop the SelectorLoop to register with
+     * @return the created QuicEngine
+     * @throws IOException if the channel cannot be opened
+     */
+    public QuicEngine createClientEngine(boolean ipv6, SelectorLoop loop)
+            throws IOException {
+        try {
+            ensureClientSslCtx();
+        } catch (RuntimeException e) {
+            throw new IOException(e.getMessage(), e);
+        }
+
+        StandardProtocolFamily family = ipv6
                 ? StandardProtocolFamily.INET6
                 : StandardProtocolFamily.INET;
         DatagramChannel dc = DatagramChannel.open(family);
         dc.configureBlocking(false);
+        configurePmtuDiscovery(dc);
         dc.bind(null);
 
         QuicEngine engine = new QuicEngine(this, false);
@@ -611,12 +1774,23 @@ public class QuicTransportFactory extends TransportFactory {
 
         loop.registerDatagram(dc, engine);
 
-        InetSocketAddress remote = new InetSocketAddress(host, port);
-        engine.connectTo(remote, null, connHandler, serverName);
-
         return engine;
     }
 
+    /**
+     * Stops the kernel fragmenting or capping datagrams at its cached
+     * path MTU when path MTU discovery is enabled, so that quiche's
+     * probes measure the path itself.
+     */
+    private void configurePmtuDiscovery(DatagramChannel dc) {
+        if (pmtuDiscovery
+                && GumdropNative.udp_set_pmtud_probe(dc) != 0
+                && LOGGER.isLoggable(Level.FINE)) {
+            LOGGER.fine("Don't Fragment not available on UDP socket; "
+                    + "path MTU probes may be fragmented");
+        }
+    }
+
     @Override
     protected String getDescription() {
         StringBuilder sb = new StringBuilder("QUIC");
@@ -0,0 +1,47 @@
+/*
+ * ReceiveDelayListener.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+/**
+ * Receives, for each datagram a QUIC engine reads, how long it waited
+ * between the kernel receiving it and the engine reading it: time spent
+ * in the socket buffer while the SelectorLoop was busy. A delay that
+ * grows with load is a direct measure of event loop saturation, and is
+ * also hidden inside the RTT samples quiche takes when the packet is
+ * processed.
+ *
+ * <p>Called on the engine's SelectorLoop thread for every datagram, so
+ * implementations must be cheap.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ * @see QuicTransportFactory#setReceiveTimestamps
+ */
+public interface ReceiveDelayListener {
+
+    /**
+     * Records the delay of one datagram.
+     *
+     * @param nanos nanoseconds from the kernel timestamp to the read
+     */
+    void receiveDelay(long nanos);
+
+}
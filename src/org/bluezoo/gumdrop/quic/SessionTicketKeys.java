@@ -0,0 +1,545 @@
+/*
+ * SessionTicketKeys.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+import org.bluezoo.gumdrop.GumdropNative;
+
+import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.security.SecureRandom;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+import java.util.concurrent.Executors;
+import java.util.concurrent.ScheduledExecutorService;
+import java.util.concurrent.TimeUnit;
+import java.util.logging.Level;
+import java.util.logging.Logger;
+
+/**
+ * Session ticket keys shared by every QUIC server {@code SSL_CTX} in the
+ * process and, optionally, by every node in a cluster.
+ *
+ * <p>Each BoringSSL {@code SSL_CTX} otherwise encrypts its TLS 1.3
+ * session tickets (RFC 8446 section 4.6.1) under a random key of its
+ * own, so a client can only resume, or send 0-RTT data, if it reaches
+ * the same process again. Servers that share a SessionTicketKeys
+ * instance issue tickets that any of them can redeem.
+ *
+ * <p>Keys come from one of two sources:
+ * <ul>
+ *   <li>a {@link #setKeyFile key file} of one or more 80-byte keys, the
+ *       format used by nginx and HAProxy. The first key encrypts new
+ *       tickets; the others are only accepted. The file is re-read when
+ *       it changes, so an external tool can rotate it across a fleet.</li>
+ *   <li>otherwise, keys generated here and replaced every
+ *       {@link #setRotationInterval rotation interval}. A replaced key
+ *       stays valid for decryption for one more interval. When a
+ *       {@link KeyShare} is attached (the servlet cluster provides one)
+ *       new keys are published to the other nodes, and the nodes
+ *       converge on the oldest key generated for each interval; keys
+ *       that lose are still accepted, since tickets may already have
+ *       been issued under them.</li>
+ * </ul>
+ *
+ * <p>Configure as a component and reference it from each QUIC listener:
+ * <pre>
+ * &lt;component id="ticketKeys"
+ *     class="org.bluezoo.gumdrop.quic.SessionTicketKeys"&gt;
+ *   &lt;property name="rotation-interval"&gt;3600000&lt;/property&gt;
+ * &lt;/component&gt;
+ * &lt;listener class="org.bluezoo.gumdrop.http.h3.HTTP3Listener"&gt;
+ *   &lt;property name="session-ticket-keys" ref="#ticketKeys"/&gt;
+ * &lt;/listener&gt;
+ * </pre>
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ * @see QuicTransportFactory#setSessionTicketKeys
+ */
+public class SessionTicketKeys {
+
+    private static final Logger LOGGER =
+            Logger.getLogger(SessionTicketKeys.class.getName());
+
+    /** Key name (16) + HMAC-SHA256 key (32) + AES-256 key (32). */
+    static final int KEY_LENGTH = 80;
+    private static final int NAME_LENGTH = 16;
+    /** The most keys the native ring holds. */
+    static final int MAX_KEYS = 4;
+
+    private static final long DEFAULT_ROTATION_INTERVAL = 12 * 3600 * 1000L;
+    private static final long FILE_CHECK_INTERVAL = 60000L;
+
+    // Published entry: epoch(8) + created(8) + key(80)
+    private static final int ENTRY_LENGTH = 16 + KEY_LENGTH;
+
+    /**
+     * Carries generated keys to the other nodes of a cluster. Messages
+     * contain secret keys and must only travel over an authenticated,
+     * encrypted channel.
+     */
+    public interface KeyShare {
+
+        /**
+         * Sends a message to the other nodes, which pass it to their
+         * own {@link SessionTicketKeys#receive}.
+         *
+         * @param message the opaque key message
+         */
+        void publish(byte[] message);
+
+    }
+
+    private final SecureRandom random = new SecureRandom();
+    private final List<Long> sslCtxs = new ArrayList<Long>();
+
+    private Path keyFile;
+    private long keyFileModified = -1;
+    private long rotationInterval = DEFAULT_ROTATION_INTERVAL;
+    private KeyShare keyShare;
+
+    // File mode: the key file contents
+    private byte[] fileKeys;
+    // Generated mode: the encrypting key, and the decrypt-only keys of
+    // this and the previous interval, newest first
+    private TicketKey current;
+    private final List<TicketKey> retired = new ArrayList<TicketKey>();
+
+    private ScheduledExecutorService scheduler;
+
+    // ── Configuration ──
+
+    /**
+     * XML: {@code key-file}. Reads keys from a file of concatenated
+     * 80-byte keys instead of generating them.
+     *
+     * @param path the key file
+     */
+    public void setKeyFile(String path) {
+        this.keyFile = Path.of(path);
+    }
+
+    public void setKeyFile(Path path) {
+        this.keyFile = path;
+    }
+
+    /**
+     * XML: {@code rotation-interval} (milliseconds, default 12 hours).
+     * How long a generated key encrypts new tickets. Tickets remain
+     * redeemable for up to twice this interval.
+     *
+     * @param ms the interval in milliseconds
+     */
+    public void setRotationInterval(long ms) {
+        if (ms < 60000L) {
+            throw new IllegalArgumentException(
+                    "rotation interval must be at least one minute");
+        }
+        this.rotationInterval = ms;
+    }
+
+    /**
+     * Attaches the channel used to exchange generated keys with other
+     * nodes, or detaches it if null. Ignored when keys come from a file.
+     *
+     * @param share the key share
+     */
+    public void setKeyShare(KeyShare share) {
+        synchronized (this) {
+            this.keyShare = share;
+        }
+        if (share != null) {
+            publishAll();
+        }
+    }
+
+    // ── SSL_CTX registration ──
+
+    /**
+     * Applies these keys to a server SSL_CTX and keeps it updated until
+     * {@link #unregister unregistered}. Rotation starts with the first
+     * registration.
+     *
+     * @param sslCtx the SSL_CTX handle
+     */
+    void register(long sslCtx) {
+        byte[] ring;
+        synchronized (this) {
+            if (scheduler == null) {
+                start();
+            }
+            sslCtxs.add(Long.valueOf(sslCtx));
+            ring = ring();
+        }
+        if (ring == null
+                || GumdropNative.ssl_ctx_set_ticket_keys(sslCtx, ring) != 0) {
+            unregister(sslCtx);
+            throw new RuntimeException(
+                    "Failed to set session ticket keys"
+                    + (keyFile != null ? ": " + keyFile : ""));
+        }
+        Arrays.fill(ring, (byte) 0);
+    }
+
+    /**
+     * Stops updating an SSL_CTX, typically just before it is freed.
+     *
+     * @param sslCtx the SSL_CTX handle
+     */
+    synchronized void unregister(long sslCtx) {
+        sslCtxs.remove(Long.valueOf(sslCtx));
+        if (sslCtxs.isEmpty() && scheduler != null) {
+            scheduler.shutdownNow();
+            scheduler = null;
+        }
+    }
+
+    // Caller holds the lock
+    private void start() {
+        scheduler = Executors.newSingleThreadScheduledExecutor(
+                new DaemonThreadFactory("SessionTicketKeys"));
+        if (keyFile != null) {
+            loadKeyFile();
+            scheduler.scheduleWithFixedDelay(new Runnable() {
+                @Override
+                public void run() {
+                    reloadKeyFile();
+                }
+            }, FILE_CHECK_INTERVAL, FILE_CHECK_INTERVAL, TimeUnit.MILLISECONDS);
+        } else {
+            rotate();
+            scheduleRotation();
+        }
+    }
+
+    // ── Key file ──
+
+    // Caller holds the lock
+    private boolean loadKeyFile() {
+        try {
+            long modified = Files.getLastModifiedTime(keyFile).toMillis();
+            if (modified == keyFileModified) {
+                return false;
+            }
+            byte[] keys = Files.readAllBytes(keyFile);
+            int count = keys.length / KEY_LENGTH;
+            if (keys.length % KEY_LENGTH != 0 || count < 1
+                    || count > MAX_KEYS) {
+                LOGGER.warning("Session ticket key file " + keyFile
+                        + " must hold 1 to " + MAX_KEYS + " keys of "
+                        + KEY_LENGTH + " bytes");
+                Arrays.fill(keys, (byte) 0);
+                return false;
+            }
+            if (fileKeys != null) {
+                Arrays.fill(fileKeys, (byte) 0);
+            }
+            fileKeys = keys;
+            keyFileModified = modified;
+            if (LOGGER.isLoggable(Level.FINE)) {
+                LOGGER.fine("Loaded " + count
+                        + " session ticket keys from " + keyFile);
+            }
+            return true;
+        } catch (IOException e) {
+            LOGGER.log(Level.WARNING,
+                    "Cannot read session ticket key file " + keyFile, e);
+            return false;
+        }
+    }
+
+    private void reloadKeyFile() {
+        boolean changed;
+        synchronized (this) {
+            changed = loadKeyFile();
+        }
+        if (changed) {
+            applyKeys();
+        }
+    }
+
+    // ── Generated keys ──
+
+    private void scheduleRotation() {
+        // Align to interval boundaries so that every node rotates at
+        // about the same moment
+        long now = System.currentTimeMillis();
+        long delay = rotationInterval - (now % rotationInterval);
+        scheduler.schedule(new Runnable() {
+            @Override
+            public void run() {
+                rotate();
+                synchronized (SessionTicketKeys.this) {
+                    if (scheduler != null) {
+                        scheduleRotation();
+                    }
+                }
+            }
+        }, delay, TimeUnit.MILLISECONDS);
+    }
+
+    private void rotate() {
+        rotate(System.currentTimeMillis());
+    }
+
+    /**
+     * Starts a new key for the interval containing the given time unless
+     * one has already been generated or received from another node.
+     *
+     * @param now the time in milliseconds since the epoch
+     */
+    void rotate(long now) {
+        long epoch = now / rotationInterval;
+        TicketKey generated = null;
+        synchronized (this) {
+            if (current == null || current.epoch < epoch) {
+                byte[] key = new byte[KEY_LENGTH];
+                random.nextBytes(key);
+                generated = new TicketKey(epoch, now, key);
+                replaceCurrent(generated);
+            }
+        }
+        if (generated != null) {
+            if (LOGGER.isLoggable(Level.FINE)) {
+                LOGGER.fine("Generated session ticket key " + generated);
+            }
+            applyKeys();
+            publish(generated);
+        }
+    }
+
+    /**
+     * Merges keys published by another node. A key for a later interval
+     * replaces the current one; for the same interval the key generated
+     * first wins, so that nodes which rotated at the same moment
+     * converge. A replaced or losing key, and any key of the previous
+     * interval, is kept for decryption only. A node still using a losing
+     * key is sent ours.
+     *
+     * @param message the message passed to {@link KeyShare#publish}
+     */
+    public void receive(byte[] message) {
+        if (message.length % ENTRY_LENGTH != 0) {
+            return;
+        }
+        boolean changed = false;
+        boolean reply = false;
+        ByteBuffer buf = ByteBuffer.wrap(message);
+        synchronized (this) {
+            if (keyFile != null) {
+                return;
+            }
+            while (buf.remaining() >= ENTRY_LENGTH) {
+                long epoch = buf.getLong();
+                long created = buf.getLong();
+                byte[] key = new byte[KEY_LENGTH];
+                buf.get(key);
+                TicketKey k = new TicketKey(epoch, created, key);
+                if (current == null || k.epoch > current.epoch) {
+                    replaceCurrent(k);
+                    changed = true;
+                } else if (k.sameName(current) || isRetired(k)) {
+                    continue;
+                } else if (k.epoch == current.epoch
+                        && k.precedes(current)) {
+                    replaceCurrent(k);
+                    changed = true;
+                } else if (k.epoch >= current.epoch - 1) {
+                    if (k.epoch == current.epoch) {
+                        reply = true;
+                    }
+                    retire(k);
+                    changed = true;
+                }
+            }
+        }
+        if (changed) {
+            if (LOGGER.isLoggable(Level.FINE)) {
+                LOGGER.fine("Adopted session ticket key " + current);
+            }
+            applyKeys();
+        }
+        if (reply) {
+            publishAll();
+        }
+    }
+
+    // Caller holds the lock
+    private void replaceCurrent(TicketKey k) {
+        TicketKey old = current;
+        current = k;
+        if (old != null) {
+            retire(old);
+        }
+        // Drop keys that have outlived their interval
+        for (int i = retired.size() - 1; i >= 0; i--) {
+            if (retired.get(i).epoch < current.epoch - 1) {
+                retired.remove(i);
+            }
+        }
+    }
+
+    // Caller holds the lock
+    private void retire(TicketKey k) {
+        retired.add(0, k);
+        while (retired.size() > MAX_KEYS - 1) {
+            retired.remove(retired.size() - 1);
+        }
+    }
+
+    // Caller holds the lock
+    private boolean isRetired(TicketKey k) {
+        for (int i = 0; i < retired.size(); i++) {
+            if (k.sameName(retired.get(i))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Publishes the current and decrypt-only keys, for instance when a
+     * node joins the cluster.
+     */
+    public void publishAll() {
+        TicketKey[] keys;
+        synchronized (this) {
+            if (current == null) {
+                return;
+            }
+            keys = new TicketKey[1 + retired.size()];
+            keys[0] = current;
+            for (int i = 0; i < retired.size(); i++) {
+                keys[i + 1] = retired.get(i);
+            }
+        }
+        publish(keys);
+    }
+
+    private void publish(TicketKey... keys) {
+        KeyShare share;
+        synchronized (this) {
+            share = keyFile == null ? keyShare : null;
+        }
+        if (share == null) {
+            return;
+        }
+        ByteBuffer buf = ByteBuffer.allocate(keys.length * ENTRY_LENGTH);
+        for (TicketKey k : keys) {
+            buf.putLong(k.epoch);
+            buf.putLong(k.created);
+            buf.put(k.key);
+        }
+        try {
+            share.publish(buf.array());
+        } catch (RuntimeException e) {
+            LOGGER.log(Level.WARNING,
+                    "Failed to publish session ticket keys", e);
+        }
+    }
+
+    // ── Applying keys ──
+
+    /**
+     * Returns the native key ring, encrypting key first, or null if no
+     * key is available.
+     */
+    synchronized byte[] ring() {
+        if (keyFile != null) {
+            return fileKeys == null ? null : fileKeys.clone();
+        }
+        if (current == null) {
+            return null;
+        }
+        byte[] ring = new byte[KEY_LENGTH * (1 + retired.size())];
+        System.arraycopy(current.key, 0, ring, 0, KEY_LENGTH);
+        for (int i = 0; i < retired.size(); i++) {
+            System.arraycopy(retired.get(i).key, 0,
+                    ring, KEY_LENGTH * (i + 1), KEY_LENGTH);
+        }
+        return ring;
+    }
+
+    // Holds the lock while updating so that an SSL_CTX is never touched
+    // after unregister() returns and its owner frees it
+    private synchronized void applyKeys() {
+        byte[] ring = ring();
+        if (ring == null) {
+            return;
+        }
+        for (int i = 0; i < sslCtxs.size(); i++) {
+            long ctx = sslCtxs.get(i).longValue();
+            if (GumdropNative.ssl_ctx_set_ticket_keys(ctx, ring) != 0) {
+                LOGGER.warning("Failed to update session ticket keys");
+            }
+        }
+        Arrays.fill(ring, (byte) 0);
+    }
+
+    // ── Inner classes ──
+
+    /**
+     * A generated key and the rotation interval it belongs to.
+     */
+    private static final class TicketKey {
+
+        final long epoch;
+        final long created;
+        final byte[] key;
+
+        TicketKey(long epoch, long created, byte[] key) {
+            this.epoch = epoch;
+            this.created = created;
+            this.key = key;
+        }
+
+        boolean sameName(TicketKey other) {
+            return Arrays.equals(key, 0, NAME_LENGTH,
+                    other.key, 0, NAME_LENGTH);
+        }
+
+        /** Whether this key wins over another for the same interval. */
+        boolean precedes(TicketKey other) {
+            if (created != other.created) {
+                return created < other.created;
+            }
+            return Arrays.compareUnsigned(key, 0, NAME_LENGTH,
+                    other.key, 0, NAME_LENGTH) < 0;
+        }
+
+        @Override
+        public String toString() {
+            // The name is public (it is sent in every ticket)
+            StringBuilder sb = new StringBuilder();
+            for (int i = 0; i < NAME_LENGTH; i++) {
+                sb.append(Character.forDigit((key[i] >> 4) & 0xf, 16));
+                sb.append(Character.forDigit(key[i] & 0xf, 16));
+            }
+            sb.append(" (epoch ").append(epoch).append(')');
+            return sb.toString();
+        }
+
+    }
+
+}
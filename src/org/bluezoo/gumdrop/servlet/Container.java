@@ -22,6 +22,7 @@
 package org.bluezoo.gumdrop.servlet;
 
 import org.bluezoo.gumdrop.auth.Realm;
+import org.bluezoo.gumdrop.quic.SessionTicketKeys;
 import org.bluezoo.gumdrop.servlet.jndi.Resource;
 import org.bluezoo.gumdrop.servlet.jndi.ServletInitialContext;
 import org.bluezoo.gumdrop.servlet.jndi.ServletInitialContextFactory;
@@ -78,6 +79,7 @@ public class Container implements ManagerContainerService, ClusterContainer {
     int clusterPort = 8080;
     String clusterGroupAddress = "224.0.80.80";
     String replicationAllowedClasses;
+    SessionTicketKeys sessionTicketKeys;
     Cluster cluster;
 
     @Override public Collection<ManagerContextService> getContexts() {
@@ -152,6 +154,16 @@ public class Container implements ManagerContainerService, ClusterContainer {
     public void setReplicationAllowedClasses(String classNames) {
         this.replicationAllowedClasses = classNames;
     }
+
+    /**
+     * Sets QUIC session ticket keys to exchange over the cluster channel,
+     * so that every node accepts the tickets the others issue.
+     *
+     * @param keys the ticket keys shared with the QUIC listeners
+     */
+    public void setSessionTicketKeys(SessionTicketKeys keys) {
+        this.sessionTicketKeys = keys;
+    }
     
     /**
      * Called by DI framework after properties are set but before contexts are initialized.
@@ -234,6 +246,7 @@ public class Container implements ManagerContainerService, ClusterContainer {
                             cluster.setReplicationAllowedClasses(
                                     replicationAllowedClasses);
                         }
+                        cluster.setSessionTicketKeys(sessionTicketKeys);
                         cluster.open();
 
                         // Register each distributable context with the cluster
@@ -21,10 +21,12 @@
 
 package org.bluezoo.gumdrop.servlet;
 
+import java.io.File;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
 import java.net.URL;
+import java.net.URISyntaxException;
 import java.net.URLConnection;
 import java.util.ArrayDeque;
 import java.util.Deque;
@@ -153,6 +155,11 @@ public class DefaultServlet extends HttpServlet {
                     }
                 }
             }
+            // Plain files can be handed to the transport directly
+            if (sendFile(resource, response)) {
+                connection.getInputStream().close();
+                return;
+            }
             // Stream content
             InputStream in = connection.getInputStream();
             OutputStream out = response.getOutputStream();
@@ -183,6 +190,32 @@ public class DefaultServlet extends HttpServlet {
         return -1L;
     }*/
 
+    /**
+     * Hands a file: resource to the container response for zero-copy
+     * sending, if the transport supports it. A wrapped response is left
+     * to the stream path, so that filters see the body they wrapped it
+     * for.
+     *
+     * @return true if the body will be sent by the transport
+     */
+    private boolean sendFile(URL resource, HttpServletResponse response)
+            throws IOException {
+        if (!"file".equals(resource.getProtocol())
+                || !(response instanceof Response)) {
+            return false;
+        }
+        File file;
+        try {
+            file = new File(resource.toURI());
+        } catch (URISyntaxException | IllegalArgumentException e) {
+            return false;
+        }
+        if (!file.isFile()) {
+            return false;
+        }
+        return ((Response) response).sendFile(file.toPath(), file.length());
+    }
+
     /**
      * Returns the resource URL for the given request.
      */
@@ -32,8 +32,11 @@ import java.net.URLEncoder;
 import java.net.URI;
 import java.nio.ByteBuffer;
 import java.nio.CharBuffer;
+import java.nio.channels.FileChannel;
 import java.nio.charset.Charset;
 import java.nio.charset.StandardCharsets;
+import java.nio.file.Path;
+import java.nio.file.StandardOpenOption;
 import java.text.DateFormat;
 import java.time.ZoneId;
 import java.time.format.DateTimeFormatter;
@@ -381,6 +384,36 @@ class Response implements HttpServletResponse {
         handler.writeBody(buf);
     }
 
+    /**
+     * Sends a regular file as the complete response body, letting the
+     * transport stream it without copying it through Java buffers.
+     * Returns false, having done nothing, if the transport cannot do so
+     * or the body has already been started; the caller should then
+     * write the content through {@link #getOutputStream}.
+     *
+     * @param file the file to send
+     * @param length the file length
+     * @return true if the file will be sent as the response body
+     */
+    boolean sendFile(Path file, long length)
+            throws IOException {
+        if (committed || outputStream != null || writer != null
+                || length <= 0 || !handler.supportsFileBody()) {
+            return false;
+        }
+        // Opened here, on the servlet thread, as opening may block
+        FileChannel channel;
+        try {
+            channel = FileChannel.open(file, StandardOpenOption.READ);
+        } catch (IOException e) {
+            return false;
+        }
+        setContentLengthLong(length);
+        commit();
+        handler.writeBodyFile(file, channel, length);
+        return true;
+    }
+
     private boolean isCloseConnection() {
         return handler.isCloseConnection();
     }
@@ -28,10 +28,13 @@ import org.bluezoo.gumdrop.http.Headers;
 import org.bluezoo.gumdrop.http.HTTPResponseState;
 import org.bluezoo.gumdrop.http.HTTPStatus;
 
+import java.io.EOFException;
 import java.io.IOException;
 import java.io.PipedInputStream;
 import java.io.PipedOutputStream;
 import java.nio.ByteBuffer;
+import java.nio.channels.FileChannel;
+import java.nio.file.Path;
 import java.util.ArrayList;
 import java.util.Collections;
 import java.util.LinkedHashMap;
@@ -59,6 +62,9 @@ class ServletHandler extends DefaultHTTPRequestHandler {
 
     private static final Logger LOGGER = Logger.getLogger(ServletHandler.class.getName());
 
+    /** Read size when a file body has to be streamed. */
+    private static final int FILE_CHUNK_SIZE = 65536;
+
     private final ServletService service;
     private final Container container;
     private final int bufferSize;
@@ -84,6 +90,9 @@ class ServletHandler extends DefaultHTTPRequestHandler {
     private int statusCode;
     private Headers responseHeaders;
     private List<ByteBuffer> responseBody;
+    private Path responseFile;
+    private FileChannel responseFileChannel;
+    private long responseFileLength;
     private long contentLength;
     private boolean responseComplete;
     private Supplier<Map<String, String>> trailerFieldsSupplier;
@@ -292,6 +301,27 @@ class ServletHandler extends DefaultHTTPRequestHandler {
         contentLength += (long) length;
     }
 
+    /**
+     * Returns true if the transport can send a file body without it
+     * being buffered here first (HTTP/3, and HTTP/1.x over plaintext or
+     * kernel TLS).
+     */
+    boolean supportsFileBody() {
+        return state.isFileBodySupported();
+    }
+
+    /**
+     * Records a file as the whole response body, to be handed to
+     * {@link HTTPResponseState#responseBodyFile} on the SelectorLoop.
+     * The channel is opened by the caller, off the loop.
+     */
+    void writeBodyFile(Path file, FileChannel channel, long length) {
+        responseFile = file;
+        responseFileChannel = channel;
+        responseFileLength = length;
+        contentLength += length;
+    }
+
     void endResponse() {
         responseComplete = true;
         sendResponse();
@@ -357,16 +387,32 @@ class ServletHandler extends DefaultHTTPRequestHandler {
      * only ever called from their owning I/O thread.
      */
     private void sendResponse() {
+        final boolean[] streamFile = new boolean[1];
+        invokeAndWait(new Runnable() {
+            public void run() {
+                streamFile[0] = sendResponseDirect();
+            }
+        });
+        if (streamFile[0]) {
+            streamResponseFile();
+        }
+    }
+
+    /**
+     * Runs a task on the response state's SelectorLoop, if it has one,
+     * and waits for it to finish.
+     */
+    private void invokeAndWait(final Runnable task) {
         SelectorLoop loop = state.getSelectorLoop();
         if (loop == null) {
-            sendResponseDirect();
+            task.run();
             return;
         }
         final CountDownLatch latch = new CountDownLatch(1);
         loop.invokeLater(new Runnable() {
             public void run() {
                 try {
-                    sendResponseDirect();
+                    task.run();
                 } finally {
                     latch.countDown();
                 }
@@ -379,7 +425,62 @@ class ServletHandler extends DefaultHTTPRequestHandler {
         }
     }
 
-    private void sendResponseDirect() {
+    /**
+     * Sends the response file through {@link
+     * HTTPResponseState#responseBodyContent} when the transport declined
+     * to send it directly, the headers (with its Content-Length) having
+     * already gone out. The file is read here, on the servlet thread,
+     * and each chunk handed to the SelectorLoop before the next is read.
+     */
+    private void streamResponseFile() {
+        try (FileChannel channel = responseFileChannel) {
+            long position = 0L;
+            while (position < responseFileLength) {
+                final ByteBuffer buf = ByteBuffer.allocate((int) Math.min(
+                        responseFileLength - position, FILE_CHUNK_SIZE));
+                while (buf.hasRemaining()) {
+                    int n = channel.read(buf, position);
+                    if (n < 0) {
+                        throw new EOFException("File truncated: "
+                                + responseFile);
+                    }
+                    position += n;
+                }
+                buf.flip();
+                invokeAndWait(new Runnable() {
+                    public void run() {
+                        state.responseBodyContent(buf);
+                    }
+                });
+            }
+        } catch (IOException e) {
+            LOGGER.log(Level.SEVERE, "Error sending response", e);
+            invokeAndWait(new Runnable() {
+                public void run() {
+                    state.cancel();
+                }
+            });
+            return;
+        }
+        invokeAndWait(new Runnable() {
+            public void run() {
+                try {
+                    endResponseBody();
+                } catch (Exception e) {
+                    LOGGER.log(Level.SEVERE, "Error sending response", e);
+                    state.cancel();
+                }
+            }
+        });
+    }
+
+    /**
+     * Sends the response headers and body on the SelectorLoop.
+     *
+     * @return true if the transport declined the response file, which
+     *         the caller must then stream with {@link #streamResponseFile}
+     */
+    private boolean sendResponseDirect() {
         try {
             Headers headers = new Headers();
             headers.status(HTTPStatus.fromCode(statusCode));
@@ -389,41 +490,68 @@ class ServletHandler extends DefaultHTTPRequestHandler {
                 }
             }
 
-            boolean hasTrailerFields = false;
-            Map<String, String> trailerFields = null;
-            if (trailerFieldsSupplier != null) {
-                try {
-                    trailerFields = trailerFieldsSupplier.get();
-                    hasTrailerFields = (trailerFields != null && !trailerFields.isEmpty());
-                } catch (Exception e) {
-                    LOGGER.warning("Error getting trailer fields: " + e.getMessage());
-                }
-            }
-
             state.headers(headers);
 
-            if (responseBody != null && !responseBody.isEmpty()) {
+            boolean hasBody = responseFile != null
+                    || (responseBody != null && !responseBody.isEmpty());
+            if (hasBody) {
                 state.startResponseBody();
-                for (ByteBuffer buf : responseBody) {
-                    state.responseBodyContent(buf);
-                }
-                state.endResponseBody();
-
-                if (hasTrailerFields) {
-                    Headers trailers = new Headers();
-                    for (Map.Entry<String, String> entry : trailerFields.entrySet()) {
-                        trailers.add(entry.getKey(), entry.getValue());
+                if (responseFile != null) {
+                    if (!state.responseBodyFile(responseFileChannel, 0L,
+                            responseFileLength)) {
+                        return true;
+                    }
+                } else {
+                    for (ByteBuffer buf : responseBody) {
+                        state.responseBodyContent(buf);
                     }
-                    state.headers(trailers);
                 }
+                endResponseBody();
+            } else {
+                state.complete();
             }
 
-            state.complete();
-
         } catch (Exception e) {
             LOGGER.log(Level.SEVERE, "Error sending response", e);
             state.cancel();
         }
+        return false;
+    }
+
+    /**
+     * Returns the trailer fields to send, or null if there are none.
+     */
+    private Map<String, String> trailerFields() {
+        if (trailerFieldsSupplier != null) {
+            try {
+                Map<String, String> trailerFields = trailerFieldsSupplier.get();
+                if (trailerFields != null && !trailerFields.isEmpty()) {
+                    return trailerFields;
+                }
+            } catch (Exception e) {
+                LOGGER.warning("Error getting trailer fields: " + e.getMessage());
+            }
+        }
+        return null;
+    }
+
+    /**
+     * Ends the response body, sends any trailer fields and completes
+     * the response.
+     */
+    private void endResponseBody() {
+        state.endResponseBody();
+
+        Map<String, String> trailerFields = trailerFields();
+        if (trailerFields != null) {
+            Headers trailers = new Headers();
+            for (Map.Entry<String, String> entry : trailerFields.entrySet()) {
+                trailers.add(entry.getKey(), entry.getValue());
+            }
+            state.headers(trailers);
+        }
+
+        state.complete();
     }
 
 }
@@ -27,6 +27,7 @@ import org.bluezoo.gumdrop.ProtocolHandler;
 import org.bluezoo.gumdrop.SecurityInfo;
 import org.bluezoo.gumdrop.TimerHandle;
 import org.bluezoo.gumdrop.UDPTransportFactory;
+import org.bluezoo.gumdrop.quic.SessionTicketKeys;
 import org.bluezoo.gumdrop.telemetry.TelemetryConfig;
 
 import javax.crypto.Cipher;
@@ -46,6 +47,7 @@ import java.nio.channels.DatagramChannel;
 import java.security.GeneralSecurityException;
 import java.security.SecureRandom;
 import java.text.MessageFormat;
+import java.util.Arrays;
 import java.util.Collection;
 import java.util.Collections;
 import java.util.Enumeration;
@@ -108,6 +110,7 @@ public class Cluster {
     private static final byte EVENT_PING = 2;
     private static final byte EVENT_DELTA = 3;
     private static final byte EVENT_FRAGMENT = 4;
+    private static final byte EVENT_TICKET_KEYS = 5;
 
     // Fragment reassembly constants
     private static final int FRAGMENT_TIMEOUT_MS = 30000;
@@ -145,6 +148,7 @@ public class Cluster {
     private UDPEndpoint endpoint;
     private UDPTransportFactory transportFactory;
     private TelemetryConfig telemetryConfig;
+    private SessionTicketKeys ticketKeys;
 
     /**
      * Creates a new cluster instance for a container.
@@ -192,6 +196,17 @@ public class Cluster {
         this.telemetryConfig = config;
     }
 
+    /**
+     * Sets QUIC session ticket keys to share with the other nodes.
+     * Generated keys are published, encrypted like every other cluster
+     * message, and keys published by other nodes are merged in.
+     *
+     * @param keys the ticket keys, or null
+     */
+    public void setSessionTicketKeys(SessionTicketKeys keys) {
+        this.ticketKeys = keys;
+    }
+
     /**
      * Sets fully qualified class names that may be deserialized from
      * Java-serialized session attributes during replication, in addition
@@ -324,6 +339,19 @@ public class Cluster {
             LOGGER.info(message);
         }
         schedulePing();
+
+        if (ticketKeys != null) {
+            ticketKeys.setKeyShare(new SessionTicketKeys.KeyShare() {
+                @Override
+                public void publish(byte[] message) {
+                    try {
+                        sendTicketKeys(message);
+                    } catch (IOException e) {
+                        LOGGER.log(Level.WARNING, L10N.getString("err.cluster_message"), e);
+                    }
+                }
+            });
+        }
     }
 
     /**
@@ -336,6 +364,9 @@ public class Cluster {
     }
 
     public void close() {
+        if (ticketKeys != null) {
+            ticketKeys.setKeyShare(null);
+        }
         if (pingTimerHandle != null) {
             pingTimerHandle.cancel();
             pingTimerHandle = null;
@@ -443,6 +474,14 @@ public class Cluster {
                             receiveFragment(buf);
                         }
                         break;
+                    case EVENT_TICKET_KEYS:
+                        if (ticketKeys != null && buf.remaining() > 0) {
+                            byte[] message = new byte[buf.remaining()];
+                            buf.get(message);
+                            ticketKeys.receive(message);
+                            Arrays.fill(message, (byte) 0);
+                        }
+                        break;
                 }
 
                 // Track node and context
@@ -470,6 +509,9 @@ public class Cluster {
                         metrics.recordNodeJoined();
                     }
                     replicateAll();
+                    if (ticketKeys != null) {
+                        ticketKeys.publishAll();
+                    }
                 } else if (newContext) {
                     // Known node but new context - replicate just that context
                     replicateForRemoteContext(remoteContextUuid);
@@ -496,6 +538,7 @@ public class Cluster {
             case EVENT_PING: return "ping";
             case EVENT_DELTA: return "delta";
             case EVENT_FRAGMENT: return "fragment";
+            case EVENT_TICKET_KEYS: return "ticket-keys";
             default: return "unknown";
         }
     }
@@ -625,6 +668,16 @@ public class Cluster {
         }
     }
 
+    private void sendTicketKeys(byte[] message) throws IOException {
+        ByteBuffer buf = ByteBuffer.allocate(HEADER_SIZE + message.length);
+        writeHeader(buf, EVENT_TICKET_KEYS, new UUID(0, 0));
+        buf.put(message);
+        buf.flip();
+        sendToCluster(buf, true, "ticket-keys");
+        Arrays.fill(buf.array(), (byte) 0);
+        Arrays.fill(message, (byte) 0);
+    }
+
     /**
      * Passivates a session (removes from cluster).
      *
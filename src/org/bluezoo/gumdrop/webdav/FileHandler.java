@@ -42,6 +42,7 @@ import java.net.URLDecoder;
 import java.nio.ByteBuffer;
 import java.nio.channels.AsynchronousFileChannel;
 import java.nio.channels.CompletionHandler;
+import java.nio.channels.FileChannel;
 import java.nio.charset.StandardCharsets;
 import java.nio.file.FileVisitResult;
 import java.nio.file.Files;
@@ -425,14 +426,16 @@ class FileHandler extends DefaultHTTPRequestHandler {
         long size;              // file size
         String contentType;     // file content type
         AsynchronousFileChannel channel; // opened off-loop for GET body
+        FileChannel fileChannel; // instead, if the transport sends files
     }
 
     /** RFC 9110 §9.3.1 (GET), §9.3.2 (HEAD), §13.1.3 (If-Modified-Since). */
     private void handleGetOrHead(HTTPResponseState state) {
+        final boolean fileBody = state.isFileBodySupported();
         offload(state, new Callable<GetPlan>() {
             @Override
             public GetPlan call() throws IOException {
-                return computeGetPlan();
+                return computeGetPlan(fileBody);
             }
         }, new StorageExecutor.Callback<GetPlan>() {
             @Override
@@ -448,8 +451,12 @@ class FileHandler extends DefaultHTTPRequestHandler {
         });
     }
 
-    /** Gathers all metadata for a GET/HEAD off the loop (blocking). */
-    private GetPlan computeGetPlan() throws IOException {
+    /**
+     * Gathers all metadata for a GET/HEAD off the loop (blocking).
+     *
+     * @param fileBody whether the transport can send the file itself
+     */
+    private GetPlan computeGetPlan(boolean fileBody) throws IOException {
         GetPlan plan = new GetPlan();
         if (path == null || !bindCanonicalPath() || !Files.exists(path)
                 || DeadPropertyStore.isSidecarFile(path)) {
@@ -482,10 +489,15 @@ class FileHandler extends DefaultHTTPRequestHandler {
             plan.notModified = true;
             return plan;
         }
-        // AFC.open is blocking — must stay inside this offloaded plan.
+        // Opening is blocking — must stay inside this offloaded plan.
         if ("GET".equals(method) && plan.size > 0) {
-            plan.channel = AsynchronousFileChannel.open(target,
-                    StandardOpenOption.READ);
+            if (fileBody) {
+                plan.fileChannel = FileChannel.open(target,
+                        StandardOpenOption.READ);
+            } else {
+                plan.channel = AsynchronousFileChannel.open(target,
+                        StandardOpenOption.READ);
+            }
         }
         return plan;
     }
@@ -528,10 +540,26 @@ class FileHandler extends DefaultHTTPRequestHandler {
         state.headers(response);
 
         if ("GET".equals(method)) {
-            if (plan.size > 0 && plan.channel != null) {
+            if (plan.size > 0 && plan.fileChannel != null) {
+                state.startResponseBody();
+                // Transports that can send straight from the file
+                // (HTTP/3, HTTP/1.x via sendfile) take the whole range
+                // and the channel at once.
+                if (state.responseBodyFile(plan.fileChannel, 0, plan.size)) {
+                    state.endResponseBody();
+                    state.complete();
+                    return;
+                }
+                try {
+                    plan.fileChannel.close();
+                } catch (IOException e) {
+                    // ignore
+                }
+                streamFile(state, plan.file);
+            } else if (plan.size > 0 && plan.channel != null) {
+                state.startResponseBody();
                 asyncReadChannel = plan.channel;
                 readPosition = 0;
-                state.startResponseBody();
                 readNextChunk(state);
                 // endResponseBody()/complete() invoked from readNextChunk
             } else {
@@ -556,6 +584,34 @@ class FileHandler extends DefaultHTTPRequestHandler {
         }
     }
 
+    /**
+     * Streams the file in chunks after the transport has declined to
+     * send it itself, opening it for asynchronous reads off the loop.
+     */
+    private void streamFile(final HTTPResponseState state, final Path file) {
+        offload(state, new Callable<AsynchronousFileChannel>() {
+            @Override
+            public AsynchronousFileChannel call() throws IOException {
+                return AsynchronousFileChannel.open(file,
+                        StandardOpenOption.READ);
+            }
+        }, new StorageExecutor.Callback<AsynchronousFileChannel>() {
+            @Override
+            public void completed(AsynchronousFileChannel channel) {
+                asyncReadChannel = channel;
+                readPosition = 0;
+                readNextChunk(state);
+            }
+
+            @Override
+            public void failed(Throwable error) {
+                LOGGER.log(Level.SEVERE, "Error opening file", error);
+                // Headers (with Content-Length) are already out
+                state.cancel();
+            }
+        });
+    }
+
     private void readNextChunk(HTTPResponseState state) {
         ByteBuffer buf = ByteBufferPool.acquire(8192);
         long pos = readPosition;
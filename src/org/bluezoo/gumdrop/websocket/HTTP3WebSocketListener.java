@@ -136,10 +136,7 @@ public class HTTP3WebSocketListener extends HTTP3Listener {
 
     @Override
     public void connectionAccepted(QuicConnection connection) {
-        HTTP3ServerHandler handler = new HTTP3ServerHandler(
-                connection, getHandlerFactory(),
-                getAuthenticationProvider(), getMetrics(),
-                getTelemetryConfig(), getAddSecurityHeaders());
+        HTTP3ServerHandler handler = createServerHandler(connection);
         handler.setWebSocketMetrics(wsMetrics);
     }
 
@@ -0,0 +1,56 @@
+#!/bin/bash
+# Compares the QUIC congestion profiles (bulk-bbr2, interactive-cubic,
+# datacenter) over HTTP/3 on the loopback interface, under a set of
+# path conditions applied to lo with tc netem.
+#
+# Run from the project root as root (tc needs CAP_NET_ADMIN), after
+# 'ant native' with QUICHE_DIR set:
+#
+#   sudo test/integration/bench/quic-cc-profiles.sh [bulk-bytes [requests]]
+#
+# netem on lo shapes both directions, so each delay below is half the
+# round-trip time.
+
+set -e
+
+BULK_BYTES="${1:-33554432}"
+REQUESTS="${2:-50}"
+
+# name | netem arguments
+SCENARIOS=(
+    "lan|delay 0.1ms"
+    "metro|delay 5ms 1ms"
+    "wan|delay 25ms 5ms loss 0.1%"
+    "lossy|delay 25ms 5ms loss 1%"
+    "satellite|delay 300ms loss 0.5%"
+    "shallow-buffer|delay 10ms rate 100mbit limit 50"
+)
+
+if ! command -v tc > /dev/null; then
+    echo "Error: tc (iproute2) not found"
+    exit 1
+fi
+if [ "$(id -u)" -ne 0 ]; then
+    echo "Error: must run as root to shape lo with tc netem"
+    exit 1
+fi
+
+cleanup() {
+    tc qdisc del dev lo root 2> /dev/null || true
+}
+trap cleanup EXIT
+
+ant -q integration-build
+
+for scenario in "${SCENARIOS[@]}"; do
+    name="${scenario%%|*}"
+    netem="${scenario#*|}"
+    cleanup
+    # shellcheck disable=SC2086
+    tc qdisc add dev lo root netem $netem
+    echo
+    echo "== $name ($netem) =="
+    ant -q integration-bench-quic-cc \
+        -Dbench.bulk.bytes="$BULK_BYTES" \
+        -Dbench.requests="$REQUESTS" | grep -v '^\s*$' | grep -v '^BUILD'
+done
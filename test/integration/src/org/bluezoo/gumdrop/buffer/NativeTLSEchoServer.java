@@ -0,0 +1,58 @@
+/*
+ * NativeTLSEchoServer.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.buffer;
+
+import org.bluezoo.gumdrop.TransportFactory;
+
+/**
+ * TLS echo server whose transport validates client certificates against
+ * a truststore of the test's own CA rather than the JVM default.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ */
+public class NativeTLSEchoServer extends TLSEchoServer {
+
+    private String truststoreFile;
+    private String truststorePass;
+
+    public void setTruststoreFile(String file) {
+        this.truststoreFile = file;
+    }
+
+    public void setTruststorePass(String pass) {
+        this.truststorePass = pass;
+    }
+
+    @Override
+    protected void configureTransportFactory(TransportFactory factory) {
+        super.configureTransportFactory(factory);
+        if (truststoreFile != null) {
+            factory.setTruststoreFile(truststoreFile);
+            factory.setTruststorePass(truststorePass);
+        }
+    }
+
+    @Override
+    public String getDescription() {
+        return "NativeTLSEcho";
+    }
+}
@@ -0,0 +1,298 @@
+/*
+ * NativeTLSIntegrationTest.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.buffer;
+
+import org.bluezoo.gumdrop.AbstractServerIntegrationTest;
+import org.bluezoo.gumdrop.TCPListener;
+import org.bluezoo.gumdrop.TCPTransportFactory;
+import org.bluezoo.gumdrop.TestCertificateManager;
+import org.junit.Assume;
+import org.junit.Before;
+import org.junit.BeforeClass;
+import org.junit.Test;
+
+import java.io.File;
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.OutputStream;
+import java.net.Socket;
+import java.security.KeyStore;
+import java.security.Principal;
+import java.security.PrivateKey;
+import java.security.SecureRandom;
+import java.security.cert.X509Certificate;
+import java.util.Arrays;
+import java.util.Random;
+import java.util.concurrent.atomic.AtomicBoolean;
+
+import javax.net.ssl.KeyManager;
+import javax.net.ssl.KeyManagerFactory;
+import javax.net.ssl.SSLContext;
+import javax.net.ssl.SSLEngine;
+import javax.net.ssl.SSLSocket;
+import javax.net.ssl.TrustManagerFactory;
+import javax.net.ssl.X509ExtendedKeyManager;
+import javax.net.ssl.X509KeyManager;
+
+import static org.junit.Assert.*;
+
+/**
+ * Integration tests for the native (BoringSSL) TLS engine on TCP
+ * listeners: full handshakes with client certificates, required and
+ * optional, and echo round trips large enough to span many records, so
+ * ciphertext is fed to the SSL in bounded chunks.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ */
+public class NativeTLSIntegrationTest extends AbstractServerIntegrationTest {
+
+    private static final int NEED_PORT = 19446;
+    private static final int WANT_PORT = 19447;
+    private static final String PASSWORD = "testpass";
+    private static final int PAYLOAD = 256 * 1024;
+
+    private static X509Certificate caCertificate;
+    private static KeyStore clientKeyStore;
+
+    @Override
+    protected File getTestConfigFile() {
+        return new File("test/integration/config/native-tls-test.xml");
+    }
+
+    @BeforeClass
+    public static void generateCertificates() throws Exception {
+        File certsDir = new File("test/integration/certs");
+        certsDir.mkdirs();
+        new File(certsDir, "ca-keystore.p12").delete();
+        TestCertificateManager certManager =
+                new TestCertificateManager(certsDir);
+        certManager.generateCA("Test CA", 1);
+        certManager.generateServerCertificate("localhost", 1);
+        certManager.saveServerKeystore(
+                new File(certsDir, "native-tls-keystore.p12"), PASSWORD);
+        certManager.saveTrustStore(
+                new File(certsDir, "native-tls-truststore.p12"), PASSWORD);
+        caCertificate = certManager.getCACertificate();
+        clientKeyStore = certManager.generateClientCertificate(
+                "native@example.com", "Native Client", 1)
+                .toKeyStore(PASSWORD);
+    }
+
+    @Before
+    public void requireNativeEngine() {
+        for (TCPListener server : servers) {
+            Assume.assumeTrue("native TLS library (libgumdrop) not available",
+                    ((TCPTransportFactory) server.getTransportFactory())
+                            .isNativeTls());
+        }
+    }
+
+    @Test
+    public void testRoundTripWithClientCertificate() throws Exception {
+        AtomicBoolean asked = new AtomicBoolean();
+        SSLSocket socket = connect(NEED_PORT, true, asked);
+        try {
+            assertTrue("certificate requested", asked.get());
+            assertEchoed(socket);
+        } finally {
+            socket.close();
+        }
+    }
+
+    @Test
+    public void testRequiredCertificateMissing() throws Exception {
+        AtomicBoolean asked = new AtomicBoolean();
+        SSLSocket socket = null;
+        try {
+            // TLS 1.3 clients finish before the server checks, so the
+            // refusal may only show on the first read
+            socket = connect(NEED_PORT, false, asked);
+            OutputStream out = socket.getOutputStream();
+            out.write('x');
+            out.flush();
+            assertEquals("connection not refused",
+                    -1, socket.getInputStream().read());
+        } catch (IOException e) {
+            // handshake_failure or certificate_required alert
+        } finally {
+            if (socket != null) {
+                socket.close();
+            }
+        }
+        assertTrue("certificate requested", asked.get());
+    }
+
+    @Test
+    public void testOptionalCertificate() throws Exception {
+        AtomicBoolean asked = new AtomicBoolean();
+        SSLSocket socket = connect(WANT_PORT, false, asked);
+        try {
+            assertTrue("certificate requested", asked.get());
+            assertEchoed(socket);
+        } finally {
+            socket.close();
+        }
+
+        asked.set(false);
+        socket = connect(WANT_PORT, true, asked);
+        try {
+            assertTrue("certificate requested", asked.get());
+            assertEchoed(socket);
+        } finally {
+            socket.close();
+        }
+    }
+
+    // ── Helpers ──
+
+    /**
+     * Connects and completes the handshake, with or without the client
+     * certificate. asked is set if the server requests a certificate.
+     */
+    private static SSLSocket connect(int port, boolean withCertificate,
+                                     AtomicBoolean asked) throws Exception {
+        X509KeyManager delegate = null;
+        if (withCertificate) {
+            KeyManagerFactory kmf = KeyManagerFactory.getInstance(
+                    KeyManagerFactory.getDefaultAlgorithm());
+            kmf.init(clientKeyStore, PASSWORD.toCharArray());
+            delegate = (X509KeyManager) kmf.getKeyManagers()[0];
+        }
+        KeyStore trustStore = KeyStore.getInstance("PKCS12");
+        trustStore.load(null, null);
+        trustStore.setCertificateEntry("ca", caCertificate);
+        TrustManagerFactory tmf = TrustManagerFactory.getInstance(
+                TrustManagerFactory.getDefaultAlgorithm());
+        tmf.init(trustStore);
+        SSLContext context = SSLContext.getInstance("TLS");
+        context.init(new KeyManager[] { new RecordingKeyManager(delegate,
+                asked) }, tmf.getTrustManagers(), new SecureRandom());
+
+        SSLSocket socket = (SSLSocket) context.getSocketFactory()
+                .createSocket("127.0.0.1", port);
+        try {
+            socket.setSoTimeout(10000);
+            socket.startHandshake();
+        } catch (IOException e) {
+            socket.close();
+            throw e;
+        }
+        return socket;
+    }
+
+    /**
+     * Sends a payload of many records from another thread and checks that
+     * the same bytes come back.
+     */
+    private static void assertEchoed(SSLSocket socket) throws Exception {
+        final byte[] payload = new byte[PAYLOAD];
+        new Random(42).nextBytes(payload);
+        final OutputStream out = socket.getOutputStream();
+        final IOException[] failure = new IOException[1];
+        Thread writer = new Thread(new Runnable() {
+            @Override
+            public void run() {
+                try {
+                    out.write(payload);
+                    out.flush();
+                } catch (IOException e) {
+                    failure[0] = e;
+                }
+            }
+        }, "native-tls-writer");
+        writer.start();
+
+        byte[] echo = new byte[PAYLOAD];
+        InputStream in = socket.getInputStream();
+        int off = 0;
+        while (off < PAYLOAD) {
+            int n = in.read(echo, off, PAYLOAD - off);
+            if (n < 0) {
+                break;
+            }
+            off += n;
+        }
+        writer.join(10000);
+        assertNull(failure[0]);
+        assertEquals(PAYLOAD, off);
+        assertTrue("echo differs", Arrays.equals(payload, echo));
+    }
+
+    /**
+     * Records whether the server requested a client certificate, and
+     * offers the delegate's, if any.
+     */
+    static class RecordingKeyManager extends X509ExtendedKeyManager {
+
+        private final X509KeyManager delegate;
+        private final AtomicBoolean asked;
+
+        RecordingKeyManager(X509KeyManager delegate, AtomicBoolean asked) {
+            this.delegate = delegate;
+            this.asked = asked;
+        }
+
+        @Override
+        public String chooseClientAlias(String[] keyType, Principal[] issuers,
+                                        Socket socket) {
+            asked.set(true);
+            return delegate != null
+                    ? delegate.chooseClientAlias(keyType, issuers, socket)
+                    : null;
+        }
+
+        @Override
+        public String chooseEngineClientAlias(String[] keyType,
+                                              Principal[] issuers,
+                                              SSLEngine engine) {
+            return chooseClientAlias(keyType, issuers, null);
+        }
+
+        @Override
+        public String[] getClientAliases(String keyType, Principal[] issuers) {
+            return delegate != null
+                    ? delegate.getClientAliases(keyType, issuers) : null;
+        }
+
+        @Override
+        public String[] getServerAliases(String keyType, Principal[] issuers) {
+            return null;
+        }
+
+        @Override
+        public String chooseServerAlias(String keyType, Principal[] issuers,
+                                        Socket socket) {
+            return null;
+        }
+
+        @Override
+        public X509Certificate[] getCertificateChain(String alias) {
+            return delegate != null ? delegate.getCertificateChain(alias) : null;
+        }
+
+        @Override
+        public PrivateKey getPrivateKey(String alias) {
+            return delegate != null ? delegate.getPrivateKey(alias) : null;
+        }
+    }
+
+}
@@ -0,0 +1,297 @@
+/*
+ * CongestionProfileBenchmark.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.http.client;
+
+import org.bluezoo.gumdrop.Endpoint;
+import org.bluezoo.gumdrop.Gumdrop;
+import org.bluezoo.gumdrop.SecurityInfo;
+import org.bluezoo.gumdrop.TestCertificateManager;
+import org.bluezoo.gumdrop.http.DefaultHTTPRequestHandler;
+import org.bluezoo.gumdrop.http.Headers;
+import org.bluezoo.gumdrop.http.HTTPRequestHandler;
+import org.bluezoo.gumdrop.http.HTTPRequestHandlerFactory;
+import org.bluezoo.gumdrop.http.HTTPResponseState;
+import org.bluezoo.gumdrop.http.HTTPStatus;
+import org.bluezoo.gumdrop.http.h3.HTTP3Listener;
+
+import java.io.File;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.nio.ByteBuffer;
+import java.nio.channels.FileChannel;
+import java.nio.file.Path;
+import java.nio.file.StandardOpenOption;
+import java.util.Arrays;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicLong;
+import java.util.concurrent.atomic.AtomicReference;
+
+/**
+ * Compares the built-in QUIC congestion profiles over HTTP/3 on the
+ * loopback interface.
+ *
+ * <p>One {@link HTTP3Listener} is started per profile. For each, the
+ * benchmark times a bulk download and a series of small sequential
+ * requests on one connection, and prints throughput and request
+ * latency percentiles. On its own the loopback path has no delay or
+ * loss, so the profiles differ little; run it under
+ * {@code test/integration/bench/quic-cc-profiles.sh}, which shapes
+ * {@code lo} with {@code tc netem} for a set of path conditions.
+ *
+ * <p>Usage: {@code CongestionProfileBenchmark [bulk-bytes [requests]]}.
+ * Needs the native library ({@code ant native}) on
+ * {@code java.library.path}.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ */
+public class CongestionProfileBenchmark {
+
+    private static final String HOST = "127.0.0.1";
+    private static final int BASE_PORT = 18460;
+    private static final int SMALL_SIZE = 1024;
+    private static final long TIMEOUT_SECONDS = 300;
+
+    private static final String[] PROFILES = {
+        "bulk-bbr2", "interactive-cubic", "datacenter"
+    };
+
+    public static void main(String[] args) throws Exception {
+        long bulkBytes = (args.length > 0)
+                ? Long.parseLong(args[0]) : 32L * 1024 * 1024;
+        int requests = (args.length > 1) ? Integer.parseInt(args[1]) : 50;
+
+        File certsDir = new File("test/integration/certs");
+        certsDir.mkdirs();
+        // BoringSSL loads PEM files: mint a throwaway CA and server pair
+        new File(certsDir, "ca-keystore.p12").delete();
+        TestCertificateManager certManager =
+                new TestCertificateManager(certsDir);
+        certManager.generateCA("Benchmark CA", 1);
+        certManager.generateServerCertificate("localhost", 1);
+        File pemCert = new File(certsDir, "cc-bench-chain.pem");
+        File pemKey = new File(certsDir, "cc-bench-key.pem");
+        certManager.saveServerPem(pemCert, pemKey);
+
+        File body = File.createTempFile("cc-bench", ".bin");
+        body.deleteOnExit();
+        try (RandomAccessFile raf = new RandomAccessFile(body, "rw")) {
+            raf.setLength(bulkBytes);
+        }
+
+        Gumdrop gumdrop = Gumdrop.getInstance();
+        for (int i = 0; i < PROFILES.length; i++) {
+            HTTP3Listener listener = new HTTP3Listener();
+            listener.setPort(BASE_PORT + i);
+            listener.setAddresses(HOST);
+            listener.setCertFile(pemCert.getAbsolutePath());
+            listener.setKeyFile(pemKey.getAbsolutePath());
+            listener.setCongestionProfile(PROFILES[i]);
+            listener.setHandlerFactory(
+                    new BenchmarkHandlerFactory(body.toPath(), bulkBytes));
+            gumdrop.addListener(listener);
+        }
+        gumdrop.start();
+        Thread.sleep(1000);
+
+        System.out.println(String.format("%-18s %12s %10s %10s %10s",
+                "profile", "bulk MB/s", "p50 ms", "p90 ms", "p99 ms"));
+        try {
+            for (int i = 0; i < PROFILES.length; i++) {
+                HTTPClient client = connect(BASE_PORT + i);
+                try {
+                    long start = System.nanoTime();
+                    long received = fetch(client, "/bulk");
+                    double seconds = (System.nanoTime() - start) / 1e9;
+                    if (received != bulkBytes) {
+                        throw new IOException("Short bulk response: "
+                                + received + " of " + bulkBytes);
+                    }
+                    long[] latencies = new long[requests];
+                    for (int r = 0; r < requests; r++) {
+                        long t = System.nanoTime();
+                        fetch(client, "/small");
+                        latencies[r] = System.nanoTime() - t;
+                    }
+                    Arrays.sort(latencies);
+                    System.out.println(String.format(
+                            "%-18s %12.1f %10.2f %10.2f %10.2f",
+                            PROFILES[i], bulkBytes / seconds / 1e6,
+                            percentile(latencies, 50),
+                            percentile(latencies, 90),
+                            percentile(latencies, 99)));
+                } finally {
+                    client.close();
+                }
+            }
+        } finally {
+            gumdrop.shutdown();
+            gumdrop.join();
+        }
+    }
+
+    private static double percentile(long[] sorted, int p) {
+        int index = Math.min(sorted.length - 1,
+                (sorted.length * p + 99) / 100 - 1);
+        return sorted[Math.max(0, index)] / 1e6;
+    }
+
+    private static HTTPClient connect(int port) throws Exception {
+        HTTPClient client = new HTTPClient(HOST, port);
+        client.setH3Enabled(true);
+        client.setVerifyPeer(false);
+        client.setAltSvcEnabled(false);
+        final CountDownLatch connected = new CountDownLatch(1);
+        final AtomicReference<Exception> error =
+                new AtomicReference<Exception>();
+        client.connect(new HTTPClientHandler() {
+            @Override
+            public void onConnected(Endpoint endpoint) {
+            }
+
+            @Override
+            public void onSecurityEstablished(SecurityInfo info) {
+                connected.countDown();
+            }
+
+            @Override
+            public void onError(Exception cause) {
+                error.set(cause);
+                connected.countDown();
+            }
+
+            @Override
+            public void onDisconnected() {
+            }
+        });
+        if (!connected.await(TIMEOUT_SECONDS, TimeUnit.SECONDS)) {
+            throw new IOException("HTTP/3 connection to port " + port
+                    + " timed out");
+        }
+        if (error.get() != null) {
+            throw error.get();
+        }
+        return client;
+    }
+
+    /** Performs a GET and returns the number of body bytes received. */
+    private static long fetch(HTTPClient client, String path)
+            throws Exception {
+        final CountDownLatch done = new CountDownLatch(1);
+        final AtomicLong received = new AtomicLong();
+        final AtomicReference<Exception> error =
+                new AtomicReference<Exception>();
+        client.request("GET", path).send(new DefaultHTTPResponseHandler() {
+            @Override
+            public void responseBodyContent(ByteBuffer data) {
+                received.addAndGet(data.remaining());
+                data.position(data.limit());
+            }
+
+            @Override
+            public void close() {
+                done.countDown();
+            }
+
+            @Override
+            public void failed(Exception ex) {
+                error.set(ex);
+                done.countDown();
+            }
+        });
+        if (!done.await(TIMEOUT_SECONDS, TimeUnit.SECONDS)) {
+            throw new IOException("GET " + path + " timed out");
+        }
+        if (error.get() != null) {
+            throw error.get();
+        }
+        return received.get();
+    }
+
+    /**
+     * Serves {@code /bulk} from a sparse file of the benchmark size and
+     * anything else as a small fixed body.
+     */
+    private static class BenchmarkHandlerFactory
+            implements HTTPRequestHandlerFactory {
+
+        private final Path body;
+        private final long bulkBytes;
+
+        BenchmarkHandlerFactory(Path body, long bulkBytes) {
+            this.body = body;
+            this.bulkBytes = bulkBytes;
+        }
+
+        @Override
+        public HTTPRequestHandler createHandler(HTTPResponseState state,
+                                                Headers headers) {
+            return new DefaultHTTPRequestHandler() {
+                private boolean bulk;
+
+                @Override
+                public void headers(HTTPResponseState state,
+                                    Headers headers) {
+                    bulk = "/bulk".equals(headers.getPath());
+                }
+
+                @Override
+                public void requestComplete(HTTPResponseState state) {
+                    long length = bulk ? bulkBytes : SMALL_SIZE;
+                    Headers response = new Headers();
+                    response.status(HTTPStatus.OK);
+                    response.add("content-type", "application/octet-stream");
+                    response.add("content-length", String.valueOf(length));
+                    state.headers(response);
+                    state.startResponseBody();
+                    if (!bulk || !sendFile(state, length)) {
+                        state.responseBodyContent(
+                                ByteBuffer.wrap(new byte[(int) length]));
+                    }
+                    state.endResponseBody();
+                    state.complete();
+                }
+            };
+        }
+
+        // Opened on the loop: a benchmark's temporary file, not a
+        // pattern for handlers serving real files
+        private boolean sendFile(HTTPResponseState state, long length) {
+            FileChannel channel;
+            try {
+                channel = FileChannel.open(body, StandardOpenOption.READ);
+            } catch (IOException e) {
+                return false;
+            }
+            if (state.responseBodyFile(channel, 0, length)) {
+                return true;
+            }
+            try {
+                channel.close();
+            } catch (IOException e) {
+                // ignore
+            }
+            return false;
+        }
+    }
+
+}
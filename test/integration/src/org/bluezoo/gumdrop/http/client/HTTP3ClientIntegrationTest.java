@@ -26,9 +26,18 @@ import org.bluezoo.gumdrop.Gumdrop;
 import org.bluezoo.gumdrop.GumdropNative;
 import org.bluezoo.gumdrop.SecurityInfo;
 import org.bluezoo.gumdrop.TestCertificateManager;
+import org.bluezoo.gumdrop.TransportFactory;
+import org.bluezoo.gumdrop.http.DefaultHTTPRequestHandler;
+import org.bluezoo.gumdrop.http.Headers;
+import org.bluezoo.gumdrop.http.HTTPRequestHandler;
+import org.bluezoo.gumdrop.http.HTTPRequestHandlerFactory;
+import org.bluezoo.gumdrop.http.HTTPResponseState;
 import org.bluezoo.gumdrop.http.HTTPStatus;
 import org.bluezoo.gumdrop.http.HTTPVersion;
+import org.bluezoo.gumdrop.http.h3.HTTP3ClientHandler;
 import org.bluezoo.gumdrop.http.h3.HTTP3Listener;
+import org.bluezoo.gumdrop.quic.QuicConnection;
+import org.bluezoo.gumdrop.quic.QuicTransportFactory;
 import org.junit.AfterClass;
 import org.junit.Assume;
 import org.junit.BeforeClass;
@@ -38,8 +47,20 @@ import org.junit.rules.Timeout;
 
 import java.io.ByteArrayOutputStream;
 import java.io.File;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.lang.reflect.Method;
+import java.net.InetAddress;
 import java.nio.ByteBuffer;
+import java.nio.channels.FileChannel;
 import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.StandardCopyOption;
+import java.nio.file.StandardOpenOption;
+import java.security.cert.X509Certificate;
+import java.util.HashMap;
+import java.util.Map;
 import java.util.concurrent.CountDownLatch;
 import java.util.concurrent.TimeUnit;
 import java.util.concurrent.atomic.AtomicReference;
@@ -52,7 +73,8 @@ import static org.junit.Assert.*;
  * <p>Drives {@code HTTPClient} with {@link HTTPClient#setH3Enabled(boolean)}
  * against a real {@link HTTP3Listener} echo server over QUIC, asserting that
  * the negotiated version is {@link HTTPVersion#HTTP_3} and that GET/POST
- * request/response bodies round-trip.
+ * request/response bodies round-trip, including file bodies sent with
+ * {@link HTTPResponseState#responseBodyFile}.
  *
  * <h2>Native library requirement</h2>
  *
@@ -87,8 +109,19 @@ public class HTTP3ClientIntegrationTest {
             .withLookingForStuckThread(true)
             .build();
 
+    /** Larger than the initial stream window, so sending resumes. */
+    private static final int FILE_BODY_SIZE = 4 * 1024 * 1024;
+
     private static Gumdrop gumdrop;
     private static HTTP3Listener listener;
+    private static File fileBody;
+    private static File pemCert;
+    private static File pemKey;
+    private static File sniDir;
+    private static File lateCert;
+    private static File lateKey;
+    private static File reloadCert;
+    private static File reloadKey;
 
     /**
      * Returns whether the native QUIC library can be loaded. Touches a cheap
@@ -126,10 +159,41 @@ public class HTTP3ClientIntegrationTest {
         TestCertificateManager certManager = new TestCertificateManager(certsDir);
         certManager.generateCA("Test CA", 365);
         certManager.generateServerCertificate("localhost", 365);
-        File pemCert = new File(certsDir, "h3-server-chain.pem");
-        File pemKey = new File(certsDir, "h3-server-key.pem");
+        pemCert = new File(certsDir, "h3-server-chain.pem");
+        pemKey = new File(certsDir, "h3-server-key.pem");
         certManager.saveServerPem(pemCert, pemKey);
 
+        // RFC 6066 section 3: an exact name and a wildcard registered by
+        // file, and one name found in the certificate directory
+        Map<String, String> sni = new HashMap<String, String>();
+        certManager.generateServerCertificate("exact.sni.test", 365);
+        File exactCert = new File(certsDir, "exact-sni-chain.pem");
+        File exactKey = new File(certsDir, "exact-sni-key.pem");
+        certManager.saveServerPem(exactCert, exactKey);
+        sni.put("exact.sni.test", exactCert.getAbsolutePath() + ","
+                + exactKey.getAbsolutePath());
+        certManager.generateServerCertificate("*.sni.test", 365);
+        File wildcardCert = new File(certsDir, "wildcard-sni-chain.pem");
+        File wildcardKey = new File(certsDir, "wildcard-sni-key.pem");
+        certManager.saveServerPem(wildcardCert, wildcardKey);
+        sni.put("*.sni.test", wildcardCert.getAbsolutePath() + ","
+                + wildcardKey.getAbsolutePath());
+        sniDir = Files.createTempDirectory("h3-sni").toFile();
+        sniDir.deleteOnExit();
+        certManager.generateServerCertificate("dir.example.test", 365);
+        certManager.saveServerPem(new File(sniDir, "dir.example.test.pem"),
+                new File(sniDir, "dir.example.test-key.pem"));
+        // Copied into the directory by testSniMissRemembered
+        certManager.generateServerCertificate("late.example.test", 365);
+        lateCert = new File(certsDir, "late-sni-chain.pem");
+        lateKey = new File(certsDir, "late-sni-key.pem");
+        certManager.saveServerPem(lateCert, lateKey);
+        // Swapped in for the default certificate by testCertificateReload
+        certManager.generateServerCertificate("reloaded.test", 365);
+        reloadCert = new File(certsDir, "reloaded-chain.pem");
+        reloadKey = new File(certsDir, "reloaded-key.pem");
+        certManager.saveServerPem(reloadCert, reloadKey);
+
         System.setProperty("gumdrop.workers", "2");
 
         listener = new HTTP3Listener();
@@ -137,7 +201,22 @@ public class HTTP3ClientIntegrationTest {
         listener.setAddresses(TEST_HOST);
         listener.setCertFile(pemCert.getAbsolutePath());
         listener.setKeyFile(pemKey.getAbsolutePath());
-        listener.setHandlerFactory(new EchoHandlerFactory());
+        // Every handshake in this suite signs on the native worker pool
+        listener.setPrivateKeyThreads(2);
+        listener.setSniCertificates(sni);
+        listener.setSniCertificateDirectory(sniDir.toPath());
+        fileBody = File.createTempFile("h3-file-body", ".bin");
+        fileBody.deleteOnExit();
+        byte[] block = new byte[8192];
+        for (int i = 0; i < block.length; i++) {
+            block[i] = (byte) i;
+        }
+        try (FileOutputStream out = new FileOutputStream(fileBody)) {
+            for (int i = 0; i < FILE_BODY_SIZE / block.length; i++) {
+                out.write(block);
+            }
+        }
+        listener.setHandlerFactory(new FileBodyHandlerFactory());
 
         gumdrop = Gumdrop.getInstance();
         gumdrop.addListener(listener);
@@ -178,82 +257,447 @@ public class HTTP3ClientIntegrationTest {
                 r.body.contains(TEST_PAYLOAD));
     }
 
+    @Test
+    public void testHttp3FileBody() throws Exception {
+        Result r = exchange("GET", "/file", null);
+        assertEquals("Should return 200 OK", HTTPStatus.OK, r.status);
+        assertEquals(FILE_BODY_SIZE, r.bytes.length);
+        for (int i = 0; i < r.bytes.length; i++) {
+            if (r.bytes[i] != (byte) (i % 8192)) {
+                fail("File body differs at byte " + i);
+            }
+        }
+    }
+
+    /**
+     * Truncating the file while it is sent must end the response in
+     * error, never with a short body presented as complete (or SIGBUS).
+     */
+    @Test
+    public void testHttp3FileBodyTruncated() throws Exception {
+        Result r = send("GET", "/truncated", null);
+        assertFalse("Truncated file must not complete as a full body",
+                r.error == null && r.bytes.length == FILE_BODY_SIZE);
+        // The connection survives for further requests
+        assertEquals(HTTPStatus.OK, exchange("GET", "/test", null).status);
+    }
+
+    /**
+     * RFC 8446 section 2.2: a second connection from the same client
+     * transport resumes with the ticket the first one was given.
+     */
+    @Test
+    public void testHttp3SessionResumption() throws Exception {
+        QuicTransportFactory factory = new QuicTransportFactory();
+        factory.setApplicationProtocols("h3");
+        factory.setVerifyPeer(false);
+        factory.start();
+        try {
+            AtomicReference<SecurityInfo> security =
+                    new AtomicReference<SecurityInfo>();
+            HTTP3ConnectionPool pool = new HTTP3ConnectionPool(factory);
+            HTTPClient client = connect(pool, security);
+            try {
+                assertFalse("First connection must do a full handshake",
+                        security.get().isSessionResumed());
+                // The ticket arrives after the handshake
+                exchange(client, "GET", "/test");
+            } finally {
+                client.close();
+                pool.close();
+            }
+
+            pool = new HTTP3ConnectionPool(factory);
+            client = connect(pool, security);
+            try {
+                assertTrue("Second connection should resume the session",
+                        security.get().isSessionResumed());
+                exchange(client, "GET", "/test");
+            } finally {
+                client.close();
+                pool.close();
+            }
+        } finally {
+            stop(factory);
+        }
+    }
+
+    /**
+     * The listener signs on the native worker pool; handshakes that
+     * overlap must each be resumed on their own connection.
+     */
+    @Test
+    public void testHttp3ConcurrentAsyncSignedHandshakes() throws Exception {
+        final int count = 4;
+        final CountDownLatch done = new CountDownLatch(count);
+        final AtomicReference<Exception> error =
+                new AtomicReference<Exception>();
+        for (int i = 0; i < count; i++) {
+            new Thread(new Runnable() {
+                @Override
+                public void run() {
+                    try {
+                        HTTPClient client = connect();
+                        try {
+                            exchange(client, "GET", "/test");
+                        } finally {
+                            client.close();
+                        }
+                    } catch (Exception | AssertionError e) {
+                        error.compareAndSet(null,
+                                e instanceof Exception ? (Exception) e
+                                        : new Exception(e));
+                    } finally {
+                        done.countDown();
+                    }
+                }
+            }).start();
+        }
+        assertTrue("Handshakes did not complete in time",
+                done.await(ASYNC_TIMEOUT_SECONDS * 2L, TimeUnit.SECONDS));
+        if (error.get() != null) {
+            throw error.get();
+        }
+    }
+
+    /**
+     * Stopping a factory releases only its own hold on the shared
+     * signing pool: the listener, which still holds it, keeps signing
+     * asynchronously.
+     */
+    @Test
+    public void testPrivateKeyPoolHeldUntilLastStop() throws Exception {
+        QuicTransportFactory factory = new QuicTransportFactory();
+        factory.setApplicationProtocols("h3");
+        factory.setCertFile(pemCert.toPath());
+        factory.setKeyFile(pemKey.toPath());
+        factory.setPrivateKeyThreads(1);
+        factory.start();
+        stop(factory);
+
+        assertTrue(GumdropNative.private_key_pool_start(1) >= 2);
+        GumdropNative.private_key_pool_stop();
+
+        HTTPClient client = connect();
+        try {
+            exchange(client, "GET", "/test");
+        } finally {
+            client.close();
+        }
+    }
+
+    @Test
+    public void testSniExactName() throws Exception {
+        assertEquals("exact.sni.test", presentedName("exact.sni.test"));
+        assertEquals("Names are case-insensitive",
+                "exact.sni.test", presentedName("EXACT.sni.test"));
+    }
+
+    @Test
+    public void testSniWildcardFallback() throws Exception {
+        assertEquals("*.sni.test", presentedName("other.sni.test"));
+        assertEquals("A wildcard covers one label only",
+                "localhost", presentedName("a.b.sni.test"));
+    }
+
+    @Test
+    public void testSniDirectory() throws Exception {
+        assertEquals("dir.example.test", presentedName("dir.example.test"));
+        assertEquals("localhost", presentedName("unknown.example.test"));
+    }
+
+    /**
+     * A name missing from the directory is not looked for again until the
+     * miss expires, so a certificate added meanwhile is not yet served.
+     */
+    @Test
+    public void testSniMissRemembered() throws Exception {
+        assertEquals("localhost", presentedName("late.example.test"));
+        Files.copy(lateCert.toPath(),
+                new File(sniDir, "late.example.test.pem").toPath(),
+                StandardCopyOption.REPLACE_EXISTING);
+        Files.copy(lateKey.toPath(),
+                new File(sniDir, "late.example.test-key.pem").toPath(),
+                StandardCopyOption.REPLACE_EXISTING);
+        assertEquals("localhost", presentedName("late.example.test"));
+    }
+
+    /**
+     * Reloading replaces the default certificate for new handshakes
+     * without a restart, and keeps the SNI certificates.
+     */
+    @Test
+    public void testCertificateReload() throws Exception {
+        byte[] cert = Files.readAllBytes(pemCert.toPath());
+        byte[] key = Files.readAllBytes(pemKey.toPath());
+        try {
+            Files.copy(reloadCert.toPath(), pemCert.toPath(),
+                    StandardCopyOption.REPLACE_EXISTING);
+            Files.copy(reloadKey.toPath(), pemKey.toPath(),
+                    StandardCopyOption.REPLACE_EXISTING);
+            listener.reloadCertificates();
+            assertEquals("reloaded.test", presentedName("unknown.test"));
+            assertEquals("exact.sni.test", presentedName("exact.sni.test"));
+
+            HTTPClient client = connect();
+            try {
+                exchange(client, "GET", "/test");
+            } finally {
+                client.close();
+            }
+        } finally {
+            Files.write(pemCert.toPath(), cert);
+            Files.write(pemKey.toPath(), key);
+            listener.reloadCertificates();
+        }
+        assertEquals("localhost", presentedName("unknown.test"));
+    }
+
+    /**
+     * A stopped factory has no context to replace, so reloading it
+     * fails rather than building one that nothing would release.
+     */
+    @Test(expected = IllegalStateException.class)
+    public void testReloadAfterStopRejected() throws Exception {
+        QuicTransportFactory factory = new QuicTransportFactory();
+        factory.setApplicationProtocols("h3");
+        factory.setCertFile(pemCert.toPath());
+        factory.setKeyFile(pemKey.toPath());
+        factory.start();
+        factory.reloadCertificates();
+        stop(factory);
+        factory.reloadCertificates();
+    }
+
     // ─────────────────────────────────────────────────────────────────────────
     // Helpers
     // ─────────────────────────────────────────────────────────────────────────
 
+    /**
+     * Connects with the given TLS server name and returns the common name
+     * of the certificate the server presented.
+     */
+    private String presentedName(String serverName) throws Exception {
+        QuicTransportFactory factory = new QuicTransportFactory();
+        factory.setApplicationProtocols("h3");
+        factory.setVerifyPeer(false);
+        factory.start();
+        HTTP3ConnectionPool pool = new HTTP3ConnectionPool(factory);
+        try {
+            final CountDownLatch latch = new CountDownLatch(1);
+            final AtomicReference<Object> result =
+                    new AtomicReference<Object>();
+            pool.acquire(Gumdrop.getInstance().nextWorkerLoop(),
+                    InetAddress.getByName(TEST_HOST), H3_PORT, serverName,
+                    new HTTP3ConnectionPool.AcquireCallback() {
+                        @Override
+                        public void acquired(HTTP3ClientHandler handler,
+                                             QuicConnection connection) {
+                            result.set(connection.getSecurityInfo()
+                                    .getPeerCertificates()[0]);
+                            latch.countDown();
+                        }
+
+                        @Override
+                        public void failed(IOException cause) {
+                            result.set(cause);
+                            latch.countDown();
+                        }
+                    });
+            assertTrue("Handshake for " + serverName + " timed out",
+                    latch.await(ASYNC_TIMEOUT_SECONDS, TimeUnit.SECONDS));
+            if (result.get() instanceof IOException) {
+                throw (IOException) result.get();
+            }
+            X509Certificate cert = (X509Certificate) result.get();
+            String dn = cert.getSubjectX500Principal().getName();
+            for (String rdn : dn.split(",")) {
+                if (rdn.startsWith("CN=")) {
+                    return rdn.substring(3);
+                }
+            }
+            return dn;
+        } finally {
+            pool.close();
+            stop(factory);
+        }
+    }
+
+    /** Stops a factory the way its owning service would. */
+    private static void stop(QuicTransportFactory factory) throws Exception {
+        Method stop = TransportFactory.class.getDeclaredMethod("stop");
+        stop.setAccessible(true);
+        stop.invoke(factory);
+    }
+
+    /**
+     * Serves {@code /file} from {@link #fileBody} with
+     * {@code responseBodyFile}, {@code /truncated} from a copy that is
+     * truncated as soon as the transport has taken it, and echoes
+     * anything else.
+     */
+    private static final class FileBodyHandlerFactory
+            implements HTTPRequestHandlerFactory {
+
+        private final EchoHandlerFactory echo = new EchoHandlerFactory();
+
+        @Override
+        public HTTPRequestHandler createHandler(HTTPResponseState state,
+                                                Headers headers) {
+            final String path = headers.getPath();
+            if (!"/file".equals(path) && !"/truncated".equals(path)) {
+                return echo.createHandler(state, headers);
+            }
+            return new DefaultHTTPRequestHandler() {
+                @Override
+                public void requestComplete(HTTPResponseState state) {
+                    Headers response = new Headers();
+                    response.status(HTTPStatus.OK);
+                    response.add("content-length",
+                            String.valueOf(FILE_BODY_SIZE));
+                    state.headers(response);
+                    state.startResponseBody();
+                    try {
+                        File file = fileBody;
+                        if ("/truncated".equals(path)) {
+                            file = File.createTempFile("h3-truncated", ".bin");
+                            file.deleteOnExit();
+                            Files.copy(fileBody.toPath(), file.toPath(),
+                                    StandardCopyOption.REPLACE_EXISTING);
+                        }
+                        FileChannel channel = FileChannel.open(file.toPath(),
+                                StandardOpenOption.READ);
+                        if (!state.responseBodyFile(channel, 0,
+                                FILE_BODY_SIZE)) {
+                            channel.close();
+                            state.cancel();
+                            return;
+                        }
+                        if (file != fileBody) {
+                            try (RandomAccessFile raf =
+                                    new RandomAccessFile(file, "rw")) {
+                                raf.setLength(FILE_BODY_SIZE / 2);
+                            }
+                        }
+                    } catch (IOException e) {
+                        state.cancel();
+                        return;
+                    }
+                    state.endResponseBody();
+                    state.complete();
+                }
+            };
+        }
+    }
+
     private static final class Result {
         HTTPVersion version;
         HTTPStatus status;
         String body;
+        byte[] bytes;
+        Exception error;
     }
 
     private Result exchange(String method, String path, String payload) throws Exception {
+        Result result = send(method, path, payload);
+        assertNull(method + " " + path + " failed: " + result.error,
+                result.error);
+        return result;
+    }
+
+    private Result send(String method, String path, String payload) throws Exception {
         HTTPClient client = connect();
         try {
-            Result result = new Result();
-
-            final CountDownLatch latch = new CountDownLatch(1);
-            final AtomicReference<Exception> error = new AtomicReference<>();
-            final ByteArrayOutputStream bodyBuffer = new ByteArrayOutputStream();
+            return send(client, method, path, payload);
+        } finally {
+            client.close();
+        }
+    }
 
-            DefaultHTTPResponseHandler handler = new DefaultHTTPResponseHandler() {
-                @Override
-                public void ok(HTTPResponse response) {
-                    result.status = response.getStatus();
-                }
+    private void exchange(HTTPClient client, String method, String path)
+            throws Exception {
+        Result result = send(client, method, path, null);
+        assertNull(method + " " + path + " failed: " + result.error,
+                result.error);
+        assertEquals(HTTPStatus.OK, result.status);
+    }
 
-                @Override
-                public void error(HTTPResponse response) {
-                    result.status = response.getStatus();
-                }
+    private Result send(HTTPClient client, String method, String path,
+                        String payload) throws Exception {
+        Result result = new Result();
 
-                @Override
-                public void responseBodyContent(ByteBuffer data) {
-                    byte[] bytes = new byte[data.remaining()];
-                    data.get(bytes);
-                    bodyBuffer.write(bytes, 0, bytes.length);
-                }
+        final CountDownLatch latch = new CountDownLatch(1);
+        final AtomicReference<Exception> error = new AtomicReference<>();
+        final ByteArrayOutputStream bodyBuffer = new ByteArrayOutputStream();
 
-                @Override
-                public void close() {
-                    latch.countDown();
-                }
+        DefaultHTTPResponseHandler handler = new DefaultHTTPResponseHandler() {
+            @Override
+            public void ok(HTTPResponse response) {
+                result.status = response.getStatus();
+            }
 
-                @Override
-                public void failed(Exception ex) {
-                    error.set(ex);
-                    latch.countDown();
-                }
-            };
+            @Override
+            public void error(HTTPResponse response) {
+                result.status = response.getStatus();
+            }
 
-            HTTPRequest request = client.request(method, path);
-            if (payload != null) {
-                byte[] payloadBytes = payload.getBytes(StandardCharsets.UTF_8);
-                request.header("Content-Type", "text/plain; charset=UTF-8");
-                request.header("Content-Length", String.valueOf(payloadBytes.length));
-                request.startRequestBody(handler);
-                request.requestBodyContent(ByteBuffer.wrap(payloadBytes));
-                request.endRequestBody();
-            } else {
-                request.send(handler);
+            @Override
+            public void responseBodyContent(ByteBuffer data) {
+                byte[] bytes = new byte[data.remaining()];
+                data.get(bytes);
+                bodyBuffer.write(bytes, 0, bytes.length);
             }
 
-            assertTrue(method + " " + path + " did not complete in time",
-                    latch.await(ASYNC_TIMEOUT_SECONDS, TimeUnit.SECONDS));
-            assertNull(method + " " + path + " failed: " + error.get(), error.get());
+            @Override
+            public void close() {
+                latch.countDown();
+            }
 
-            result.version = client.getVersion();
-            result.body = new String(bodyBuffer.toByteArray(), StandardCharsets.UTF_8);
-            return result;
-        } finally {
-            client.close();
+            @Override
+            public void failed(Exception ex) {
+                error.set(ex);
+                latch.countDown();
+            }
+        };
+
+        HTTPRequest request = client.request(method, path);
+        if (payload != null) {
+            byte[] payloadBytes = payload.getBytes(StandardCharsets.UTF_8);
+            request.header("Content-Type", "text/plain; charset=UTF-8");
+            request.header("Content-Length", String.valueOf(payloadBytes.length));
+            request.startRequestBody(handler);
+            request.requestBodyContent(ByteBuffer.wrap(payloadBytes));
+            request.endRequestBody();
+        } else {
+            request.send(handler);
         }
+
+        assertTrue(method + " " + path + " did not complete in time",
+                latch.await(ASYNC_TIMEOUT_SECONDS, TimeUnit.SECONDS));
+
+        result.error = error.get();
+        result.version = client.getVersion();
+        result.bytes = bodyBuffer.toByteArray();
+        result.body = new String(result.bytes, StandardCharsets.UTF_8);
+        return result;
     }
 
     private HTTPClient connect() throws Exception {
+        return connect(null, new AtomicReference<SecurityInfo>());
+    }
+
+    /**
+     * Connects over HTTP/3, through the given pool if not null, and
+     * records the connection's security information.
+     */
+    private HTTPClient connect(HTTP3ConnectionPool pool,
+                               final AtomicReference<SecurityInfo> security)
+            throws Exception {
         HTTPClient client = new HTTPClient(TEST_HOST, H3_PORT);
         client.setH3Enabled(true);
+        if (pool != null) {
+            client.setH3ConnectionPool(pool);
+        }
         // The test server presents a certificate signed by our throwaway test
         // CA; BoringSSL has no way to trust it, so disable peer verification.
         client.setVerifyPeer(false);
@@ -268,6 +712,7 @@ public class HTTP3ClientIntegrationTest {
 
             @Override
             public void onSecurityEstablished(SecurityInfo info) {
+                security.set(info);
                 connected.countDown();
             }
 
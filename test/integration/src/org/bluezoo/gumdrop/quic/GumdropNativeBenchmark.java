@@ -0,0 +1,822 @@
+/*
+ * GumdropNativeBenchmark.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+import org.bluezoo.gumdrop.GumdropNative;
+import org.bluezoo.gumdrop.TestCertificateManager;
+import org.bluezoo.json.JSONDefaultHandler;
+import org.bluezoo.json.JSONException;
+import org.bluezoo.json.JSONParser;
+import org.bluezoo.json.JSONWriter;
+
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.net.InetSocketAddress;
+import java.nio.ByteBuffer;
+import java.security.SecureRandom;
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+
+/**
+ * Measures the cost of each class of {@link GumdropNative} call on the
+ * QUIC and HTTP/3 paths.
+ *
+ * <p>A client and a server quiche connection are created in-process and
+ * joined through memory: each packet written by one side's
+ * {@code quiche_conn_send} is passed straight to the other's
+ * {@code quiche_conn_recv} in the same direct buffer, with no sockets.
+ * The benchmarks are:
+ * <ul>
+ * <li>quiche config setters, with a primitive and with an array
+ * argument;</li>
+ * <li>{@code quiche_conn_send} and {@code quiche_h3_conn_poll} with
+ * nothing to do, the bare cost of a call on a connection;</li>
+ * <li>a 1 KB stream write carried to the server in one packet, timing
+ * {@code quiche_conn_stream_send}, {@code quiche_conn_send},
+ * {@code quiche_conn_recv} and {@code quiche_conn_stream_recv};</li>
+ * <li>HTTP/3 requests and responses with 10, 30 and 100 header fields,
+ * timing on the server {@code quiche_h3_conn_poll} for each event,
+ * {@code quiche_h3_event_headers} and {@code quiche_h3_send_response}.</li>
+ * </ul>
+ * Calls that do nothing are run in batches and timed together. The
+ * others change the connections' state, so each is timed on its own and
+ * the cost of reading the clock, measured at startup, is subtracted.
+ *
+ * <p>As with JMH, each benchmark runs warmup iterations and then
+ * measured iterations of one second, and its score is the mean time per
+ * call with a 99.9% confidence interval. Results are printed as a table
+ * and written in JMH's JSON format. Given the JSON of an earlier run,
+ * the change in each score is shown too, and the run fails if any call
+ * has become more than 10% slower with confidence intervals that do not
+ * overlap.
+ *
+ * <p>Usage: {@code GumdropNativeBenchmark [output.json [baseline.json]]}.
+ * Needs the native library ({@code ant native}) on
+ * {@code java.library.path}.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ */
+public class GumdropNativeBenchmark {
+
+    private static final int WARMUP_ITERATIONS = 5;
+    private static final int MEASUREMENT_ITERATIONS = 10;
+    private static final long ITERATION_NANOS = 1_000_000_000L;
+    /** Student's t for a two-sided 99.9% interval, 9 degrees of freedom. */
+    private static final double T_999 = 4.781;
+    private static final int REGRESSION_PERCENT = 10;
+
+    /** Calls per timing of a batched benchmark. */
+    private static final int BATCH = 1024;
+    private static final int STREAM_CHUNK = 1024;
+    private static final long STREAM_ID = 0;
+    private static final int[] HEADER_COUNTS = { 10, 30, 100 };
+    private static final int MAX_HANDSHAKE_ROUNDS = 100;
+    private static final int CONN_ID_LEN = 20;
+
+    private static final int H3_EVENT_HEADERS = 0;
+    private static final int H3_EVENT_FINISHED = 2;
+
+    private static final String PREFIX = "org.bluezoo.gumdrop.GumdropNative.";
+
+    private final InetSocketAddress clientAddress =
+            new InetSocketAddress("127.0.0.1", 40000);
+    private final InetSocketAddress serverAddress =
+            new InetSocketAddress("127.0.0.1", 4433);
+    private final byte[] alpn = QuicTransportFactory.encodeAlpnProtocols("h3");
+
+    // Packets pass between the connections in this buffer, with the
+    // path addresses quiche_conn_send reports
+    private final ByteBuffer buf = ByteBuffer.allocateDirect(65535);
+    private final byte[] sendTo = new byte[19];
+    private final byte[] sendFrom = new byte[19];
+
+    private long serverCtx;
+    private long clientCtx;
+    private long config;
+    private long h3Config;
+    private long client;
+    private long server;
+    private long clientH3;
+    private long serverH3;
+
+    private long clockOverhead;
+    private final List<Probe> probes = new ArrayList<Probe>();
+
+    public static void main(String[] args) throws Exception {
+        File output = new File((args.length > 0 && !args[0].isEmpty())
+                ? args[0] : "jni-boundary.json");
+        File baseline = (args.length > 1 && !args[1].isEmpty())
+                ? new File(args[1]) : null;
+
+        File certsDir = new File("test/integration/certs");
+        certsDir.mkdirs();
+        // BoringSSL loads PEM files: mint a throwaway CA and server pair
+        new File(certsDir, "ca-keystore.p12").delete();
+        TestCertificateManager certManager =
+                new TestCertificateManager(certsDir);
+        certManager.generateCA("Benchmark CA", 1);
+        certManager.generateServerCertificate("localhost", 1);
+        File pemCert = new File(certsDir, "jni-bench-chain.pem");
+        File pemKey = new File(certsDir, "jni-bench-key.pem");
+        certManager.saveServerPem(pemCert, pemKey);
+
+        GumdropNativeBenchmark bench = new GumdropNativeBenchmark();
+        try {
+            bench.connect(pemCert, pemKey);
+            bench.runAll();
+        } finally {
+            bench.close();
+        }
+        bench.write(output);
+        Map<String, double[]> previous = (baseline != null)
+                ? readBaseline(baseline) : null;
+        if (!bench.report(previous)) {
+            System.exit(1);
+        }
+    }
+
+    // ── Benchmarks ──
+
+    private void runAll() throws IOException {
+        clockOverhead = measureClockOverhead();
+
+        final long scratch = newConfig();
+        try {
+            final Probe maxData = probe(
+                    "quiche_config_set_initial_max_data", null, null);
+            run(new Benchmark(maxData) {
+                @Override
+                void op() {
+                    long t = System.nanoTime();
+                    for (int i = 0; i < BATCH; i++) {
+                        GumdropNative.quiche_config_set_initial_max_data(
+                                scratch, 1_000_000 + i);
+                    }
+                    maxData.record(System.nanoTime() - t, BATCH);
+                }
+            });
+            final Probe protos = probe(
+                    "quiche_config_set_application_protos", null, null);
+            run(new Benchmark(protos) {
+                @Override
+                void op() {
+                    long t = System.nanoTime();
+                    for (int i = 0; i < BATCH; i++) {
+                        GumdropNative.quiche_config_set_application_protos(
+                                scratch, alpn);
+                    }
+                    protos.record(System.nanoTime() - t, BATCH);
+                }
+            });
+        } finally {
+            GumdropNative.quiche_config_free(scratch);
+        }
+
+        final Probe idleSend = probe("quiche_conn_send", "state", "idle");
+        run(new Benchmark(idleSend) {
+            @Override
+            void op() throws IOException {
+                long t = System.nanoTime();
+                for (int i = 0; i < BATCH; i++) {
+                    int len = GumdropNative.quiche_conn_send(client, buf,
+                            buf.capacity(), sendTo, sendFrom, null);
+                    if (len > 0) {
+                        // Rare (a late ACK): keep the peer in step
+                        GumdropNative.quiche_conn_recv(server, buf, len,
+                                sendFrom, sendTo);
+                    }
+                }
+                idleSend.record(System.nanoTime() - t, BATCH);
+            }
+        });
+
+        runStream();
+
+        final Probe idlePoll = probe("quiche_h3_conn_poll", "state", "idle");
+        run(new Benchmark(idlePoll) {
+            @Override
+            void op() throws IOException {
+                long t = System.nanoTime();
+                for (int i = 0; i < BATCH; i++) {
+                    if (GumdropNative.quiche_h3_conn_poll(serverH3,
+                            server) != null) {
+                        throw new IOException("Unexpected HTTP/3 event");
+                    }
+                }
+                idlePoll.record(System.nanoTime() - t, BATCH);
+            }
+        });
+
+        for (int count : HEADER_COUNTS) {
+            runHeaders(count);
+        }
+    }
+
+    /**
+     * Writes 1 KB on a stream, carries it to the server in one packet and
+     * reads it there; the server's acknowledgements are returned untimed.
+     */
+    private void runStream() throws IOException {
+        final ByteBuffer chunk = ByteBuffer.allocateDirect(STREAM_CHUNK);
+        final ByteBuffer in = ByteBuffer.allocateDirect(65535);
+        final boolean[] fin = new boolean[1];
+        String bytes = String.valueOf(STREAM_CHUNK);
+        final Probe streamSend = probe("quiche_conn_stream_send",
+                "bytes", bytes);
+        final Probe send = probe("quiche_conn_send", "state", "packet");
+        final Probe recv = probe("quiche_conn_recv", "state", "packet");
+        final Probe streamRecv = probe("quiche_conn_stream_recv",
+                "bytes", bytes);
+        run(new Benchmark(streamSend, send, recv, streamRecv) {
+            @Override
+            void op() throws IOException {
+                long t = System.nanoTime();
+                int n = GumdropNative.quiche_conn_stream_send(client,
+                        STREAM_ID, chunk, STREAM_CHUNK, false);
+                streamSend.record(System.nanoTime() - t, 1);
+                if (n < 0 && n != GumdropNative.QUICHE_ERR_DONE) {
+                    throw new IOException("quiche_conn_stream_send: " + n);
+                }
+                while (true) {
+                    t = System.nanoTime();
+                    int len = GumdropNative.quiche_conn_send(client, buf,
+                            buf.capacity(), sendTo, sendFrom, null);
+                    long elapsed = System.nanoTime() - t;
+                    if (len == GumdropNative.QUICHE_ERR_DONE) {
+                        break;
+                    }
+                    check("quiche_conn_send", len);
+                    send.record(elapsed, 1);
+                    t = System.nanoTime();
+                    int rc = GumdropNative.quiche_conn_recv(server, buf,
+                            len, sendFrom, sendTo);
+                    recv.record(System.nanoTime() - t, 1);
+                    check("quiche_conn_recv", rc);
+                }
+                while (true) {
+                    t = System.nanoTime();
+                    int len = GumdropNative.quiche_conn_stream_recv(server,
+                            STREAM_ID, in, in.capacity(), fin);
+                    long elapsed = System.nanoTime() - t;
+                    if (len == GumdropNative.QUICHE_ERR_DONE) {
+                        break;
+                    }
+                    check("quiche_conn_stream_recv", len);
+                    streamRecv.record(elapsed, 1);
+                }
+                flush(server, client);
+            }
+        });
+    }
+
+    /**
+     * Sends a request with the given number of header fields and answers
+     * it with as many, timing the server's side.
+     */
+    private void runHeaders(final int count) throws IOException {
+        final String[] request = headers(count, ":method", "GET",
+                ":scheme", "https", ":authority", "localhost",
+                ":path", "/bench");
+        final String[] response = headers(count, ":status", "200");
+        String n = String.valueOf(count);
+        final Probe poll = probe("quiche_h3_conn_poll", "headers", n);
+        final Probe eventHeaders = probe("quiche_h3_event_headers",
+                "headers", n);
+        final Probe sendResponse = probe("quiche_h3_send_response",
+                "headers", n);
+        run(new Benchmark(poll, eventHeaders, sendResponse) {
+            @Override
+            void op() throws IOException {
+                long stream = GumdropNative.quiche_h3_send_request(clientH3,
+                        client, request, true);
+                if (stream < 0) {
+                    // Wait for the server to raise the stream limit
+                    flush(client, server);
+                    flush(server, client);
+                    stream = GumdropNative.quiche_h3_send_request(clientH3,
+                            client, request, true);
+                    check("quiche_h3_send_request", stream);
+                }
+                flush(client, server);
+                while (true) {
+                    long t = System.nanoTime();
+                    long[] event = GumdropNative.quiche_h3_conn_poll(
+                            serverH3, server);
+                    long elapsed = System.nanoTime() - t;
+                    if (event == null) {
+                        break;
+                    }
+                    poll.record(elapsed, 1);
+                    if (event[1] == H3_EVENT_HEADERS) {
+                        t = System.nanoTime();
+                        String[] fields = GumdropNative
+                                .quiche_h3_event_headers(serverH3);
+                        eventHeaders.record(System.nanoTime() - t, 1);
+                        if (fields == null || fields.length != count * 2) {
+                            throw new IOException("Expected " + count
+                                    + " header fields");
+                        }
+                    } else if (event[1] == H3_EVENT_FINISHED) {
+                        t = System.nanoTime();
+                        int rc = GumdropNative.quiche_h3_send_response(
+                                serverH3, server, event[0], response, true);
+                        sendResponse.record(System.nanoTime() - t, 1);
+                        check("quiche_h3_send_response", rc);
+                    }
+                }
+                flush(server, client);
+                while (GumdropNative.quiche_h3_conn_poll(clientH3,
+                        client) != null) {
+                    // the response's HEADERS and FINISHED
+                }
+                flush(client, server);
+            }
+        });
+    }
+
+    /**
+     * Returns the given header fields padded with {@code x-bench-N}
+     * fields to count fields, as a flat name/value array.
+     */
+    private static String[] headers(int count, String... fields) {
+        String[] result = new String[count * 2];
+        System.arraycopy(fields, 0, result, 0, fields.length);
+        for (int i = fields.length / 2; i < count; i++) {
+            result[i * 2] = "x-bench-" + i;
+            result[i * 2 + 1] = "value-" + i + "-abcdefghijklmnopqrstuvwxyz";
+        }
+        return result;
+    }
+
+    // ── Harness ──
+
+    /** One benchmark operation, which times its calls into probes. */
+    private abstract static class Benchmark {
+
+        final Probe[] probes;
+
+        Benchmark(Probe... probes) {
+            this.probes = probes;
+        }
+
+        abstract void op() throws IOException;
+    }
+
+    /** The accumulated time of one call site, for one benchmark result. */
+    private static final class Probe {
+
+        final String name;
+        final String param;
+        final String value;
+        final double[] scores = new double[MEASUREMENT_ITERATIONS];
+        long nanos;
+        long calls;
+        long timings;
+
+        Probe(String name, String param, String value) {
+            this.name = name;
+            this.param = param;
+            this.value = value;
+        }
+
+        void record(long elapsed, int count) {
+            nanos += elapsed;
+            calls += count;
+            timings++;
+        }
+
+        void reset() {
+            nanos = 0;
+            calls = 0;
+            timings = 0;
+        }
+
+        /** Returns the mean nanoseconds per call, less the clock's cost. */
+        double score(long overhead) {
+            if (calls == 0) {
+                return 0;
+            }
+            return Math.max(0, (double) (nanos - timings * overhead) / calls);
+        }
+
+        double mean() {
+            double sum = 0;
+            for (double score : scores) {
+                sum += score;
+            }
+            return sum / scores.length;
+        }
+
+        /** Returns the half-width of the 99.9% confidence interval. */
+        double error() {
+            double mean = mean();
+            double sum = 0;
+            for (double score : scores) {
+                sum += (score - mean) * (score - mean);
+            }
+            double stddev = Math.sqrt(sum / (scores.length - 1));
+            return T_999 * stddev / Math.sqrt(scores.length);
+        }
+
+        String key() {
+            return (param != null) ? name + "," + param + "=" + value : name;
+        }
+
+        String label() {
+            return (param != null) ? name + " (" + param + "=" + value + ")"
+                    : name;
+        }
+    }
+
+    private Probe probe(String name, String param, String value) {
+        Probe probe = new Probe(name, param, value);
+        probes.add(probe);
+        return probe;
+    }
+
+    private void run(Benchmark benchmark) throws IOException {
+        for (int i = 0; i < WARMUP_ITERATIONS + MEASUREMENT_ITERATIONS; i++) {
+            for (Probe probe : benchmark.probes) {
+                probe.reset();
+            }
+            long deadline = System.nanoTime() + ITERATION_NANOS;
+            do {
+                benchmark.op();
+            } while (System.nanoTime() < deadline);
+            if (i >= WARMUP_ITERATIONS) {
+                for (Probe probe : benchmark.probes) {
+                    probe.scores[i - WARMUP_ITERATIONS] =
+                            probe.score(clockOverhead);
+                }
+            }
+        }
+    }
+
+    /** Returns the nanoseconds taken by a pair of clock reads. */
+    private static long measureClockOverhead() {
+        long sum = 0;
+        int n = 10_000_000;
+        for (int i = 0; i < n; i++) {
+            long t = System.nanoTime();
+            sum += System.nanoTime() - t;
+        }
+        return sum / n;
+    }
+
+    private static void check(String call, long rc) throws IOException {
+        if (rc < 0) {
+            throw new IOException(call + " failed: " + rc);
+        }
+    }
+
+    // ── In-process connection pair ──
+
+    private long newConfig() throws IOException {
+        long c = GumdropNative.quiche_config_new(
+                QuicTransportFactory.QUICHE_PROTOCOL_VERSION_1);
+        if (c == 0) {
+            throw new IOException("quiche_config_new failed");
+        }
+        GumdropNative.quiche_config_set_application_protos(c, alpn);
+        // No idle timeout: the pair sits idle between benchmarks
+        GumdropNative.quiche_config_set_max_idle_timeout(c, 0);
+        GumdropNative.quiche_config_set_initial_max_data(c, 16L << 20);
+        GumdropNative.quiche_config_set_initial_max_stream_data_bidi_local(
+                c, 1L << 20);
+        GumdropNative.quiche_config_set_initial_max_stream_data_bidi_remote(
+                c, 1L << 20);
+        GumdropNative.quiche_config_set_initial_max_stream_data_uni(
+                c, 1L << 20);
+        GumdropNative.quiche_config_set_initial_max_streams_bidi(c, 100);
+        GumdropNative.quiche_config_set_initial_max_streams_uni(c, 100);
+        GumdropNative.quiche_config_set_max_recv_udp_payload_size(c, 1350);
+        GumdropNative.quiche_config_set_max_send_udp_payload_size(c, 1350);
+        return c;
+    }
+
+    /**
+     * Creates the client and server connections, completes the handshake
+     * and opens HTTP/3 on both.
+     */
+    private void connect(File cert, File key) throws IOException {
+        serverCtx = GumdropNative.ssl_ctx_new(true);
+        if (serverCtx == 0
+                || GumdropNative.ssl_ctx_load_cert_chain(serverCtx,
+                        cert.getPath()) != 0
+                || GumdropNative.ssl_ctx_load_priv_key(serverCtx,
+                        key.getPath()) != 0
+                || GumdropNative.ssl_ctx_set_alpn_protos(serverCtx,
+                        alpn) != 0) {
+            throw new IOException("Cannot configure server SSL_CTX");
+        }
+        clientCtx = GumdropNative.ssl_ctx_new(false);
+        if (clientCtx == 0
+                || GumdropNative.ssl_ctx_set_alpn_protos(clientCtx,
+                        alpn) != 0) {
+            throw new IOException("Cannot configure client SSL_CTX");
+        }
+        GumdropNative.ssl_ctx_set_verify_peer(clientCtx, false);
+        config = newConfig();
+
+        byte[] clientAddr = QuicEngine.encodeAddress(clientAddress);
+        byte[] serverAddr = QuicEngine.encodeAddress(serverAddress);
+        long ssl = GumdropNative.ssl_new(clientCtx);
+        GumdropNative.ssl_set_hostname(ssl, "localhost");
+        client = GumdropNative.quiche_conn_new_with_tls(connectionId(), null,
+                clientAddr, serverAddr, config, ssl, false);
+        // As QuicEngine accepts a client's first Initial
+        ssl = GumdropNative.ssl_new(serverCtx);
+        server = GumdropNative.quiche_conn_new_with_tls(connectionId(), null,
+                serverAddr, clientAddr, config, ssl, true);
+        if (client == 0 || server == 0) {
+            throw new IOException("Cannot create quiche connections");
+        }
+        for (int i = 0; !isEstablished(); i++) {
+            if (i == MAX_HANDSHAKE_ROUNDS) {
+                throw new IOException("Handshake did not complete");
+            }
+            flush(client, server);
+            flush(server, client);
+        }
+
+        h3Config = GumdropNative.quiche_h3_config_new();
+        clientH3 = GumdropNative.quiche_h3_conn_new_with_transport(client,
+                h3Config);
+        serverH3 = GumdropNative.quiche_h3_conn_new_with_transport(server,
+                h3Config);
+        if (clientH3 == 0 || serverH3 == 0) {
+            throw new IOException("Cannot create HTTP/3 connections");
+        }
+        // Exchange SETTINGS and open the control and QPACK streams
+        flush(client, server);
+        flush(server, client);
+        while (GumdropNative.quiche_h3_conn_poll(serverH3, server) != null) {
+        }
+        while (GumdropNative.quiche_h3_conn_poll(clientH3, client) != null) {
+        }
+        flush(client, server);
+        flush(server, client);
+    }
+
+    private boolean isEstablished() {
+        return GumdropNative.quiche_conn_is_established(client)
+                && GumdropNative.quiche_conn_is_established(server);
+    }
+
+    private static byte[] connectionId() {
+        byte[] id = new byte[CONN_ID_LEN];
+        new SecureRandom().nextBytes(id);
+        return id;
+    }
+
+    /** Passes every packet one connection has to send to the other. */
+    private void flush(long from, long to) throws IOException {
+        while (true) {
+            int len = GumdropNative.quiche_conn_send(from, buf,
+                    buf.capacity(), sendTo, sendFrom, null);
+            if (len == GumdropNative.QUICHE_ERR_DONE) {
+                return;
+            }
+            check("quiche_conn_send", len);
+            check("quiche_conn_recv", GumdropNative.quiche_conn_recv(to,
+                    buf, len, sendFrom, sendTo));
+        }
+    }
+
+    private void close() {
+        if (clientH3 != 0) {
+            GumdropNative.quiche_h3_conn_free(clientH3);
+        }
+        if (serverH3 != 0) {
+            GumdropNative.quiche_h3_conn_free(serverH3);
+        }
+        if (h3Config != 0) {
+            GumdropNative.quiche_h3_config_free(h3Config);
+        }
+        // Each connection frees its SSL
+        if (client != 0) {
+            GumdropNative.quiche_conn_free(client);
+        }
+        if (server != 0) {
+            GumdropNative.quiche_conn_free(server);
+        }
+        if (config != 0) {
+            GumdropNative.quiche_config_free(config);
+        }
+        if (clientCtx != 0) {
+            GumdropNative.ssl_ctx_free(clientCtx);
+        }
+        if (serverCtx != 0) {
+            GumdropNative.ssl_ctx_free(serverCtx);
+        }
+    }
+
+    // ── Results ──
+
+    /**
+     * Writes the results as JMH does with {@code -rf json}, so that
+     * tools that read JMH results can compare runs.
+     */
+    private void write(File file) throws IOException {
+        File dir = file.getAbsoluteFile().getParentFile();
+        if (dir != null) {
+            dir.mkdirs();
+        }
+        try (FileOutputStream out = new FileOutputStream(file)) {
+            JSONWriter w = new JSONWriter(out.getChannel());
+            w.writeStartArray();
+            for (Probe probe : probes) {
+                writeResult(w, probe);
+            }
+            w.writeEndArray();
+            w.close();
+        }
+    }
+
+    private void writeResult(JSONWriter w, Probe probe) throws IOException {
+        double mean = probe.mean();
+        double error = probe.error();
+        w.writeStartObject();
+        w.writeKey("benchmark");
+        w.writeString(PREFIX + probe.name);
+        w.writeKey("mode");
+        w.writeString("avgt");
+        w.writeKey("threads");
+        w.writeNumber(Integer.valueOf(1));
+        w.writeKey("forks");
+        w.writeNumber(Integer.valueOf(1));
+        w.writeKey("jdkVersion");
+        w.writeString(System.getProperty("java.version"));
+        w.writeKey("vmName");
+        w.writeString(System.getProperty("java.vm.name"));
+        w.writeKey("vmVersion");
+        w.writeString(System.getProperty("java.vm.version"));
+        w.writeKey("warmupIterations");
+        w.writeNumber(Integer.valueOf(WARMUP_ITERATIONS));
+        w.writeKey("warmupTime");
+        w.writeString("1 s");
+        w.writeKey("measurementIterations");
+        w.writeNumber(Integer.valueOf(MEASUREMENT_ITERATIONS));
+        w.writeKey("measurementTime");
+        w.writeString("1 s");
+        if (probe.param != null) {
+            w.writeKey("params");
+            w.writeStartObject();
+            w.writeKey(probe.param);
+            w.writeString(probe.value);
+            w.writeEndObject();
+        }
+        w.writeKey("primaryMetric");
+        w.writeStartObject();
+        w.writeKey("score");
+        w.writeNumber(Double.valueOf(mean));
+        w.writeKey("scoreError");
+        w.writeNumber(Double.valueOf(error));
+        w.writeKey("scoreConfidence");
+        w.writeStartArray();
+        w.writeNumber(Double.valueOf(mean - error));
+        w.writeNumber(Double.valueOf(mean + error));
+        w.writeEndArray();
+        w.writeKey("scoreUnit");
+        w.writeString("ns/op");
+        w.writeKey("rawData");
+        w.writeStartArray();
+        w.writeStartArray();
+        for (double score : probe.scores) {
+            w.writeNumber(Double.valueOf(score));
+        }
+        w.writeEndArray();
+        w.writeEndArray();
+        w.writeEndObject();
+        w.writeEndObject();
+    }
+
+    /**
+     * Prints the results, with the change from the baseline if given.
+     *
+     * @return false if a call has regressed
+     */
+    private boolean report(Map<String, double[]> baseline) {
+        System.out.println("clock overhead: " + clockOverhead + " ns");
+        System.out.println(String.format("%-52s %12s %10s %10s",
+                "call", "ns/op", "error", "change"));
+        boolean ok = true;
+        for (Probe probe : probes) {
+            double mean = probe.mean();
+            double error = probe.error();
+            String change = "";
+            double[] previous = (baseline != null)
+                    ? baseline.get(probe.key()) : null;
+            if (previous != null && previous[0] > 0) {
+                double percent = (mean - previous[0]) * 100 / previous[0];
+                change = String.format("%+.1f%%", percent);
+                if (percent > REGRESSION_PERCENT
+                        && mean - error > previous[0] + previous[1]) {
+                    change += " !";
+                    ok = false;
+                }
+            }
+            System.out.println(String.format("%-52s %12.1f %10.1f %10s",
+                    probe.label(), mean, error, change));
+        }
+        if (!ok) {
+            System.out.println("Calls marked ! are more than "
+                    + REGRESSION_PERCENT + "% slower than the baseline");
+        }
+        return ok;
+    }
+
+    /**
+     * Reads the score and error of each result in a JSON file written by
+     * an earlier run, keyed as by {@link Probe#key}.
+     */
+    private static Map<String, double[]> readBaseline(File file)
+            throws IOException, JSONException {
+        final Map<String, double[]> results = new HashMap<String, double[]>();
+        JSONParser parser = new JSONParser();
+        parser.setContentHandler(new JSONDefaultHandler() {
+            private int depth;
+            private String key;
+            private boolean inParams;
+            private String benchmark;
+            private String params;
+            private double score;
+            private double error;
+
+            @Override
+            public void startObject() throws JSONException {
+                depth++;
+                inParams = "params".equals(key);
+            }
+
+            @Override
+            public void endObject() throws JSONException {
+                if (inParams) {
+                    inParams = false;
+                } else if (depth == 1 && benchmark != null) {
+                    String name = benchmark.startsWith(PREFIX)
+                            ? benchmark.substring(PREFIX.length())
+                            : benchmark;
+                    String k = (params != null) ? name + "," + params : name;
+                    results.put(k, new double[] { score, error });
+                    benchmark = null;
+                    params = null;
+                }
+                depth--;
+                key = null;
+            }
+
+            @Override
+            public void key(String key) throws JSONException {
+                this.key = key;
+            }
+
+            @Override
+            public void stringValue(String value) throws JSONException {
+                if (inParams) {
+                    params = key + "=" + value;
+                } else if (depth == 1 && "benchmark".equals(key)) {
+                    benchmark = value;
+                }
+            }
+
+            @Override
+            public void numberValue(Number value) throws JSONException {
+                if ("score".equals(key)) {
+                    score = value.doubleValue();
+                } else if ("scoreError".equals(key)) {
+                    error = value.doubleValue();
+                }
+            }
+        });
+        try (InputStream in = new FileInputStream(file)) {
+            parser.parse(in);
+        }
+        return results;
+    }
+
+}
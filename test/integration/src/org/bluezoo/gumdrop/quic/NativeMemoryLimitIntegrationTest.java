@@ -0,0 +1,221 @@
+/*
+ * NativeMemoryLimitIntegrationTest.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+import org.bluezoo.gumdrop.GumdropNative;
+import org.bluezoo.gumdrop.SelectorLoop;
+import org.bluezoo.gumdrop.TestCertificateManager;
+import org.junit.AfterClass;
+import org.junit.Assume;
+import org.junit.BeforeClass;
+import org.junit.Test;
+
+import java.io.File;
+import java.net.InetAddress;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicInteger;
+
+import static org.junit.Assert.*;
+
+/**
+ * Integration tests for {@link QuicTransportFactory#setNativeMemoryLimit}
+ * with the native QUIC stack: new connections get the constrained
+ * quiche config from 80% of the limit, and their Initials are refused
+ * at the limit. The usage the factory sees is set by the test.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ */
+public class NativeMemoryLimitIntegrationTest {
+
+    private static final int PORT = 18447;
+    private static final long LIMIT = 1000000L;
+    private static final int TIMEOUT_SECONDS = 10;
+
+    private static File pemCert;
+    private static File pemKey;
+    private static SelectorLoop loop;
+
+    static boolean quicNativeAvailable() {
+        try {
+            GumdropNative.quiche_version_is_supported(1);
+            return true;
+        } catch (LinkageError e) {
+            return false;
+        }
+    }
+
+    @BeforeClass
+    public static void setUp() throws Exception {
+        Assume.assumeTrue(
+                "native QUIC library (libgumdrop) not available",
+                quicNativeAvailable());
+        File certsDir = new File("test/integration/certs");
+        certsDir.mkdirs();
+        new File(certsDir, "ca-keystore.p12").delete();
+        TestCertificateManager certManager =
+                new TestCertificateManager(certsDir);
+        certManager.generateCA("Test CA", 1);
+        certManager.generateServerCertificate("localhost", 1);
+        pemCert = new File(certsDir, "native-memory-chain.pem");
+        pemKey = new File(certsDir, "native-memory-key.pem");
+        certManager.saveServerPem(pemCert, pemKey);
+        loop = new SelectorLoop(0);
+        loop.start();
+    }
+
+    @AfterClass
+    public static void tearDown() {
+        if (loop != null) {
+            loop.shutdown();
+        }
+    }
+
+    @Test
+    public void testConstrainedConfigFromThreshold() throws Exception {
+        LimitedFactory factory = serverFactory();
+        factory.start();
+        try {
+            InetAddress peer = InetAddress.getLoopbackAddress();
+            int v1 = QuicTransportFactory.QUICHE_PROTOCOL_VERSION_1;
+            long normal = factory.getQuicheConfig(v1);
+            assertEquals(normal, factory.getQuicheConfig(v1, peer));
+            factory.usage = LIMIT / 100 * 80 - 1;
+            assertEquals(normal, factory.getQuicheConfig(v1, peer));
+
+            factory.usage = LIMIT / 100 * 80;
+            long constrained = factory.getQuicheConfig(v1, peer);
+            assertTrue(constrained != 0);
+            assertTrue("reduced windows from 80%", constrained != normal);
+            factory.usage = LIMIT - 1;
+            assertEquals(constrained, factory.getQuicheConfig(v1, peer));
+
+            factory.usage = 0;
+            assertEquals(normal, factory.getQuicheConfig(v1, peer));
+        } finally {
+            factory.stop();
+        }
+    }
+
+    /**
+     * At the limit an Initial is answered with CONNECTION_REFUSED before
+     * any connection state is allocated; once usage falls, the same
+     * client connects.
+     */
+    @Test
+    public void testInitialRefusedAtLimit() throws Exception {
+        LimitedFactory server = serverFactory();
+        server.start();
+        QuicTransportFactory client = new QuicTransportFactory();
+        client.setApplicationProtocols("h3");
+        client.setVerifyPeer(false);
+        client.start();
+        final AtomicInteger accepted = new AtomicInteger();
+        QuicEngine engine = server.createServerEngine(
+                InetAddress.getLoopbackAddress(), PORT,
+                new QuicEngine.ConnectionAcceptedHandler() {
+                    @Override
+                    public void connectionAccepted(QuicConnection c) {
+                        accepted.incrementAndGet();
+                    }
+                }, loop);
+        try {
+            server.usage = LIMIT;
+            assertFalse("refused at the limit", connect(client));
+            assertEquals(0, accepted.get());
+
+            server.usage = LIMIT / 2;
+            assertTrue("accepted below the limit", connect(client));
+            assertEquals(1, accepted.get());
+        } finally {
+            close(engine);
+            server.stop();
+            client.stop();
+        }
+    }
+
+    // ── Helpers ──
+
+    private static LimitedFactory serverFactory() {
+        LimitedFactory factory = new LimitedFactory();
+        factory.setApplicationProtocols("h3");
+        factory.setCertFile(pemCert.toPath());
+        factory.setKeyFile(pemKey.toPath());
+        factory.setNativeMemoryLimit(LIMIT);
+        return factory;
+    }
+
+    /**
+     * Connects to the server and returns whether the handshake
+     * completed.
+     */
+    private static boolean connect(QuicTransportFactory client)
+            throws Exception {
+        final CountDownLatch latch = new CountDownLatch(1);
+        final boolean[] established = new boolean[1];
+        QuicEngine engine = client.connect(InetAddress.getLoopbackAddress(),
+                PORT, new QuicEngine.ConnectionAcceptedHandler() {
+                    @Override
+                    public void connectionAccepted(QuicConnection c) {
+                        established[0] = true;
+                        latch.countDown();
+                    }
+
+                    @Override
+                    public void connectionFailed(QuicConnection c) {
+                        latch.countDown();
+                    }
+                }, loop, "localhost");
+        try {
+            assertTrue("no outcome",
+                    latch.await(TIMEOUT_SECONDS, TimeUnit.SECONDS));
+            return established[0];
+        } finally {
+            close(engine);
+        }
+    }
+
+    /** Closes an engine on its SelectorLoop, which owns its state. */
+    private static void close(final QuicEngine engine) throws Exception {
+        final CountDownLatch closed = new CountDownLatch(1);
+        loop.invokeLater(new Runnable() {
+            @Override
+            public void run() {
+                engine.close();
+                closed.countDown();
+            }
+        });
+        assertTrue(closed.await(TIMEOUT_SECONDS, TimeUnit.SECONDS));
+    }
+
+    /** A factory whose native memory usage is set by the test. */
+    static class LimitedFactory extends QuicTransportFactory {
+
+        volatile long usage;
+
+        @Override
+        long getNativeMemoryUsage() {
+            return usage;
+        }
+    }
+
+}
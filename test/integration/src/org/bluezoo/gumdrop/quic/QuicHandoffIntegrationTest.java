@@ -0,0 +1,250 @@
+/*
+ * QuicHandoffIntegrationTest.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+import org.bluezoo.gumdrop.GumdropNative;
+import org.bluezoo.gumdrop.SelectorLoop;
+import org.bluezoo.gumdrop.TestCertificateManager;
+import org.junit.AfterClass;
+import org.junit.Assume;
+import org.junit.BeforeClass;
+import org.junit.Test;
+
+import java.io.File;
+import java.net.InetAddress;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.nio.file.attribute.PosixFilePermissions;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicInteger;
+import java.util.stream.Stream;
+
+import static org.junit.Assert.*;
+
+/**
+ * Integration test for {@link QuicHandoff} with the native QUIC stack.
+ * Two server engines in this JVM stand in for the previous and the
+ * replacement process: the replacement inherits the previous engine's
+ * socket over the UNIX socket, new connections reach the replacement,
+ * and packets of the previous engine's connection are forwarded to it
+ * while it drains.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ */
+public class QuicHandoffIntegrationTest {
+
+    private static final int PORT = 18448;
+    private static final int TIMEOUT_SECONDS = 10;
+
+    private static File pemCert;
+    private static File pemKey;
+    private static SelectorLoop loop;
+
+    static boolean quicNativeAvailable() {
+        try {
+            GumdropNative.quiche_version_is_supported(1);
+            return true;
+        } catch (LinkageError e) {
+            return false;
+        }
+    }
+
+    @BeforeClass
+    public static void setUp() throws Exception {
+        Assume.assumeTrue(
+                "native QUIC library (libgumdrop) not available",
+                quicNativeAvailable());
+        File certsDir = new File("test/integration/certs");
+        certsDir.mkdirs();
+        new File(certsDir, "ca-keystore.p12").delete();
+        TestCertificateManager certManager =
+                new TestCertificateManager(certsDir);
+        certManager.generateCA("Test CA", 1);
+        certManager.generateServerCertificate("localhost", 1);
+        pemCert = new File(certsDir, "handoff-chain.pem");
+        pemKey = new File(certsDir, "handoff-key.pem");
+        certManager.saveServerPem(pemCert, pemKey);
+        loop = new SelectorLoop(0);
+        loop.start();
+    }
+
+    @AfterClass
+    public static void tearDown() {
+        if (loop != null) {
+            loop.shutdown();
+        }
+    }
+
+    @Test
+    public void testHandoffBetweenEngines() throws Exception {
+        Path dir = Files.createTempDirectory("gumdrop-handoff");
+        Path socket = dir.resolve("upgrade.sock");
+        QuicTransportFactory previous = serverFactory();
+        QuicTransportFactory replacement = serverFactory();
+        QuicTransportFactory client = new QuicTransportFactory();
+        client.setApplicationProtocols("h3");
+        client.setVerifyPeer(false);
+        previous.start();
+        replacement.start();
+        client.start();
+        InetAddress localhost = InetAddress.getLoopbackAddress();
+        AcceptCounter oldAccepted = new AcceptCounter();
+        AcceptCounter newAccepted = new AcceptCounter();
+        QuicEngine oldEngine = previous.createServerEngine(localhost, PORT,
+                oldAccepted, loop);
+        QuicEngine newEngine = null;
+        QuicEngine first = null;
+        QuicEngine second = null;
+        try {
+            first = connect(client);
+            assertEquals(1, oldAccepted.count.get());
+
+            final CountDownLatch upgraded = new CountDownLatch(1);
+            QuicHandoff.listen(socket, new Runnable() {
+                @Override
+                public void run() {
+                    upgraded.countDown();
+                }
+            });
+            assertEquals(PosixFilePermissions.fromString("rw-------"),
+                    Files.getPosixFilePermissions(socket));
+            assertEquals("bound in a private directory, then moved",
+                    1, count(dir));
+
+            assertTrue(QuicHandoff.inherit(socket));
+            newEngine = replacement.createServerEngine(localhost, PORT,
+                    newAccepted, loop);
+            QuicHandoff.listen(socket, new Runnable() {
+                @Override
+                public void run() {
+                }
+            });
+            assertTrue("previous engine not told of the upgrade",
+                    upgraded.await(TIMEOUT_SECONDS, TimeUnit.SECONDS));
+            assertEquals(1, QuicHandoff.getDrainingConnectionCount());
+
+            second = connect(client);
+            assertEquals("new connection reached the replacement",
+                    1, newAccepted.count.get());
+            assertEquals(1, oldAccepted.count.get());
+
+            // The CONNECTION_CLOSE arrives at the replacement, which
+            // forwards it to the previous engine
+            close(first);
+            first = null;
+            long deadline = System.currentTimeMillis()
+                    + TIMEOUT_SECONDS * 1000L;
+            while (QuicHandoff.getDrainingConnectionCount() > 0
+                    && System.currentTimeMillis() < deadline) {
+                Thread.sleep(50);
+            }
+            assertEquals("forwarded close not seen by previous engine",
+                    0, QuicHandoff.getDrainingConnectionCount());
+        } finally {
+            QuicHandoff.close();
+            for (QuicEngine engine : new QuicEngine[] {
+                    first, second, newEngine, oldEngine }) {
+                if (engine != null) {
+                    close(engine);
+                }
+            }
+            previous.stop();
+            replacement.stop();
+            client.stop();
+            Files.deleteIfExists(socket);
+            Files.deleteIfExists(dir);
+        }
+    }
+
+    // ── Helpers ──
+
+    private static QuicTransportFactory serverFactory() {
+        QuicTransportFactory factory = new QuicTransportFactory();
+        factory.setApplicationProtocols("h3");
+        factory.setCertFile(pemCert.toPath());
+        factory.setKeyFile(pemKey.toPath());
+        return factory;
+    }
+
+    /**
+     * Connects to the server and returns the client engine once the
+     * handshake has completed.
+     */
+    private static QuicEngine connect(QuicTransportFactory client)
+            throws Exception {
+        final CountDownLatch latch = new CountDownLatch(1);
+        final boolean[] established = new boolean[1];
+        QuicEngine engine = client.connect(InetAddress.getLoopbackAddress(),
+                PORT, new QuicEngine.ConnectionAcceptedHandler() {
+                    @Override
+                    public void connectionAccepted(QuicConnection c) {
+                        established[0] = true;
+                        latch.countDown();
+                    }
+
+                    @Override
+                    public void connectionFailed(QuicConnection c) {
+                        latch.countDown();
+                    }
+                }, loop, "localhost");
+        assertTrue("no outcome",
+                latch.await(TIMEOUT_SECONDS, TimeUnit.SECONDS));
+        if (!established[0]) {
+            close(engine);
+            fail("handshake failed");
+        }
+        return engine;
+    }
+
+    /** Closes an engine on its SelectorLoop, which owns its state. */
+    private static void close(final QuicEngine engine) throws Exception {
+        final CountDownLatch closed = new CountDownLatch(1);
+        loop.invokeLater(new Runnable() {
+            @Override
+            public void run() {
+                engine.close();
+                closed.countDown();
+            }
+        });
+        assertTrue(closed.await(TIMEOUT_SECONDS, TimeUnit.SECONDS));
+    }
+
+    private static long count(Path dir) throws Exception {
+        try (Stream<Path> entries = Files.list(dir)) {
+            return entries.count();
+        }
+    }
+
+    /** Counts the connections a server engine accepts. */
+    static class AcceptCounter
+            implements QuicEngine.ConnectionAcceptedHandler {
+
+        final AtomicInteger count = new AtomicInteger();
+
+        @Override
+        public void connectionAccepted(QuicConnection c) {
+            count.incrementAndGet();
+        }
+    }
+
+}
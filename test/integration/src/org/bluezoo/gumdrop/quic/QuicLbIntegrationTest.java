@@ -0,0 +1,138 @@
+/*
+ * QuicLbIntegrationTest.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+import org.bluezoo.gumdrop.GumdropNative;
+import org.bluezoo.util.ByteArrays;
+import org.junit.Assume;
+import org.junit.BeforeClass;
+import org.junit.Test;
+
+import java.util.Arrays;
+import java.util.Random;
+
+import static org.junit.Assert.*;
+
+/**
+ * Integration tests for the native QUIC-LB connection ID encryption
+ * against the encrypted test vectors of draft-ietf-quic-load-balancers
+ * (appendix B), and for decryption as a load balancer would do it.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ */
+public class QuicLbIntegrationTest {
+
+    private static final String KEY = "8f95f09245765f80256934e50c66207f";
+
+    @BeforeClass
+    public static void requireNative() {
+        Assume.assumeTrue(
+                "native QUIC library (libgumdrop) not available",
+                NativeMemoryLimitIntegrationTest.quicNativeAvailable());
+    }
+
+    /** 16 bytes of server ID and nonce: one AES-128-ECB block. */
+    @Test
+    public void testSinglePassVector() {
+        assertVector("50", "ed793a51d49b8f5f", "ee080dbf48c0d1e5",
+                "504dd2d05a7b0de9b2b9907afb5ecf8cc3");
+    }
+
+    @Test
+    public void testFourPassVectors() {
+        assertVector("07", "ed793a", "ee080dbf",
+                "0720b1d07b359d3c");
+        assertVector("2f", "ed793a51d49b8f5fab65", "ee080dbf48",
+                "2fcc381bc74cb4fbad2823a3d1f8fed2");
+    }
+
+    /** An odd plaintext length splits the middle byte between halves. */
+    @Test
+    public void testFourPassVectorOddLength() {
+        assertVector("12", "ed793a51d49b8f5fab", "ee080dbf48c0d1e55d",
+                "125779c9cc86beb3a3a4a3ca96fce4bfe0cdbc");
+    }
+
+    @Test
+    public void testDecryptRoundTrip() {
+        byte[] key = hex(KEY);
+        Random random = new Random(42);
+        for (int len = 6; len <= 20; len++) {
+            for (int i = 0; i < 100; i++) {
+                byte[] plaintext = new byte[len];
+                random.nextBytes(plaintext);
+                byte[] cid = plaintext.clone();
+                assertEquals(0, GumdropNative.quic_lb_encrypt(key, cid));
+                assertEquals("first octet in the clear",
+                        plaintext[0], cid[0]);
+                assertFalse(Arrays.equals(plaintext, cid));
+                assertEquals(0, GumdropNative.quic_lb_decrypt(key, cid));
+                assertArrayEquals("length " + len, plaintext, cid);
+            }
+        }
+    }
+
+    /** A load balancer recovers the server ID from a generated ID. */
+    @Test
+    public void testGeneratorServerIdRecovered() {
+        QuicLbConnectionIdGenerator generator =
+                new QuicLbConnectionIdGenerator();
+        generator.setConfigId(1);
+        generator.setServerId("0a0b0c");
+        generator.setNonceLength(7);
+        generator.setKey(KEY);
+        byte[] cid = generator.generate();
+        assertEquals(11, cid.length);
+        assertEquals(0, GumdropNative.quic_lb_decrypt(hex(KEY), cid));
+        assertEquals((1 << 5) | 10, cid[0] & 0xff);
+        assertEquals(0x0a, cid[1]);
+        assertEquals(0x0b, cid[2]);
+        assertEquals(0x0c, cid[3]);
+    }
+
+    @Test
+    public void testInvalidLengths() {
+        byte[] key = hex(KEY);
+        assertEquals(-1, GumdropNative.quic_lb_encrypt(key, new byte[5]));
+        assertEquals(-1, GumdropNative.quic_lb_encrypt(key, new byte[21]));
+        assertEquals(-1, GumdropNative.quic_lb_decrypt(new byte[15],
+                new byte[8]));
+    }
+
+    // ── Helpers ──
+
+    private static void assertVector(String firstOctet, String serverId,
+                                     String nonce, String expected) {
+        byte[] key = hex(KEY);
+        byte[] plaintext = hex(firstOctet + serverId + nonce);
+        byte[] cid = plaintext.clone();
+        assertEquals(0, GumdropNative.quic_lb_encrypt(key, cid));
+        assertArrayEquals(hex(expected), cid);
+        assertEquals(0, GumdropNative.quic_lb_decrypt(key, cid));
+        assertArrayEquals(plaintext, cid);
+    }
+
+    private static byte[] hex(String s) {
+        return ByteArrays.toByteArray(s);
+    }
+
+}
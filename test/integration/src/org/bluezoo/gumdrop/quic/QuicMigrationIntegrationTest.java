@@ -0,0 +1,406 @@
+/*
+ * QuicMigrationIntegrationTest.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+import org.bluezoo.gumdrop.Endpoint;
+import org.bluezoo.gumdrop.ProtocolHandler;
+import org.bluezoo.gumdrop.SecurityInfo;
+import org.bluezoo.gumdrop.SelectorLoop;
+import org.bluezoo.gumdrop.StreamAcceptHandler;
+import org.bluezoo.gumdrop.TestCertificateManager;
+import org.junit.AfterClass;
+import org.junit.Assume;
+import org.junit.BeforeClass;
+import org.junit.Test;
+
+import java.io.File;
+import java.io.IOException;
+import java.net.InetAddress;
+import java.net.InetSocketAddress;
+import java.net.SocketAddress;
+import java.nio.ByteBuffer;
+import java.nio.channels.DatagramChannel;
+import java.nio.channels.SelectionKey;
+import java.nio.channels.Selector;
+import java.nio.charset.StandardCharsets;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+
+import static org.junit.Assert.*;
+
+/**
+ * Integration test for QUIC connection migration (RFC 9000 section 9)
+ * with the native QUIC stack. A UDP relay between client and server
+ * stands in for a NAT: when it rebinds to a new port mid-connection,
+ * the server validates the new path itself, without probing it, and
+ * the connection follows the client there and goes on echoing.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ */
+public class QuicMigrationIntegrationTest {
+
+    private static final int PORT = 18450;
+    private static final int TIMEOUT_SECONDS = 10;
+
+    private static File pemCert;
+    private static File pemKey;
+    private static SelectorLoop loop;
+
+    @BeforeClass
+    public static void setUp() throws Exception {
+        Assume.assumeTrue(
+                "native QUIC library (libgumdrop) not available",
+                NativeMemoryLimitIntegrationTest.quicNativeAvailable());
+        File certsDir = new File("test/integration/certs");
+        certsDir.mkdirs();
+        new File(certsDir, "ca-keystore.p12").delete();
+        TestCertificateManager certManager =
+                new TestCertificateManager(certsDir);
+        certManager.generateCA("Test CA", 1);
+        certManager.generateServerCertificate("localhost", 1);
+        pemCert = new File(certsDir, "migration-chain.pem");
+        pemKey = new File(certsDir, "migration-key.pem");
+        certManager.saveServerPem(pemCert, pemKey);
+        loop = new SelectorLoop(0);
+        loop.start();
+    }
+
+    @AfterClass
+    public static void tearDown() {
+        if (loop != null) {
+            loop.shutdown();
+        }
+    }
+
+    @Test
+    public void testServerFollowsRebindingClient() throws Exception {
+        QuicTransportFactory server = new QuicTransportFactory();
+        server.setApplicationProtocols("h3");
+        server.setCertFile(pemCert.toPath());
+        server.setKeyFile(pemKey.toPath());
+        QuicTransportFactory client = new QuicTransportFactory();
+        client.setApplicationProtocols("h3");
+        client.setVerifyPeer(false);
+        server.start();
+        client.start();
+        InetAddress localhost = InetAddress.getLoopbackAddress();
+        final QuicConnection[] accepted = new QuicConnection[1];
+        QuicEngine serverEngine = server.createServerEngine(localhost, PORT,
+                new QuicEngine.ConnectionAcceptedHandler() {
+                    @Override
+                    public void connectionAccepted(QuicConnection c) {
+                        accepted[0] = c;
+                    }
+                }, loop);
+        serverEngine.setStreamAcceptHandler(new StreamAcceptHandler() {
+            @Override
+            public ProtocolHandler acceptStream(Endpoint stream) {
+                return new Echo();
+            }
+        });
+        Relay relay = new Relay(new InetSocketAddress(localhost, PORT));
+        relay.start();
+        QuicEngine clientEngine = null;
+        try {
+            final CountDownLatch latch = new CountDownLatch(1);
+            final QuicConnection[] connection = new QuicConnection[1];
+            clientEngine = client.connect(localhost, relay.getPort(),
+                    new QuicEngine.ConnectionAcceptedHandler() {
+                        @Override
+                        public void connectionAccepted(QuicConnection c) {
+                            connection[0] = c;
+                            latch.countDown();
+                        }
+
+                        @Override
+                        public void connectionFailed(QuicConnection c) {
+                            latch.countDown();
+                        }
+                    }, loop, "localhost");
+            assertTrue("no outcome",
+                    latch.await(TIMEOUT_SECONDS, TimeUnit.SECONDS));
+            assertNotNull("handshake failed", connection[0]);
+            assertNotNull(accepted[0]);
+
+            Collector collector = new Collector();
+            final Endpoint stream = openStream(connection[0], collector);
+            send(stream, "before");
+            collector.await("before");
+            SocketAddress first = relay.getOutboundAddress();
+            assertEquals(first, accepted[0].getRemoteAddress());
+
+            relay.rebind();
+            SocketAddress second = relay.getOutboundAddress();
+            assertFalse(first.equals(second));
+            send(stream, "after");
+            collector.await("before" + "after");
+
+            long deadline = System.currentTimeMillis()
+                    + TIMEOUT_SECONDS * 1000L;
+            while (!second.equals(accepted[0].getRemoteAddress())
+                    && System.currentTimeMillis() < deadline) {
+                Thread.sleep(50);
+            }
+            assertEquals("server did not follow the client",
+                    second, accepted[0].getRemoteAddress());
+            assertFalse(connection[0].isClosed());
+            assertFalse(accepted[0].isClosed());
+            assertEquals("handshake admission keeps the original address",
+                    first, accepted[0].getOriginalRemoteAddress());
+        } finally {
+            if (clientEngine != null) {
+                close(clientEngine);
+            }
+            close(serverEngine);
+            relay.close();
+            server.stop();
+            client.stop();
+        }
+    }
+
+    // ── Helpers ──
+
+    /** Opens a client stream on the connection's SelectorLoop. */
+    private static Endpoint openStream(final QuicConnection c,
+                                       final ProtocolHandler handler)
+            throws Exception {
+        final CountDownLatch done = new CountDownLatch(1);
+        final Endpoint[] stream = new Endpoint[1];
+        loop.invokeLater(new Runnable() {
+            @Override
+            public void run() {
+                stream[0] = c.openStream(handler);
+                done.countDown();
+            }
+        });
+        assertTrue(done.await(TIMEOUT_SECONDS, TimeUnit.SECONDS));
+        return stream[0];
+    }
+
+    private static void send(final Endpoint stream, String text) {
+        final ByteBuffer data = ByteBuffer.wrap(
+                text.getBytes(StandardCharsets.US_ASCII));
+        loop.invokeLater(new Runnable() {
+            @Override
+            public void run() {
+                stream.send(data);
+            }
+        });
+    }
+
+    /** Closes an engine on its SelectorLoop, which owns its state. */
+    private static void close(final QuicEngine engine) throws Exception {
+        final CountDownLatch closed = new CountDownLatch(1);
+        loop.invokeLater(new Runnable() {
+            @Override
+            public void run() {
+                engine.close();
+                closed.countDown();
+            }
+        });
+        assertTrue(closed.await(TIMEOUT_SECONDS, TimeUnit.SECONDS));
+    }
+
+    /** Server stream handler that sends back what it receives. */
+    static class Echo implements ProtocolHandler {
+
+        private Endpoint endpoint;
+
+        @Override
+        public void connected(Endpoint endpoint) {
+            this.endpoint = endpoint;
+        }
+
+        @Override
+        public void receive(ByteBuffer data) {
+            ByteBuffer copy = ByteBuffer.allocate(data.remaining());
+            copy.put(data);
+            copy.flip();
+            endpoint.send(copy);
+        }
+
+        @Override
+        public void disconnected() {
+        }
+
+        @Override
+        public void securityEstablished(SecurityInfo info) {
+        }
+
+        @Override
+        public void error(Exception cause) {
+        }
+    }
+
+    /** Client stream handler that collects the echoed text. */
+    static class Collector implements ProtocolHandler {
+
+        private final StringBuilder received = new StringBuilder();
+
+        @Override
+        public void connected(Endpoint endpoint) {
+        }
+
+        @Override
+        public void receive(ByteBuffer data) {
+            byte[] bytes = new byte[data.remaining()];
+            data.get(bytes);
+            synchronized (received) {
+                received.append(new String(bytes,
+                        StandardCharsets.US_ASCII));
+                received.notifyAll();
+            }
+        }
+
+        void await(String expected) throws InterruptedException {
+            long deadline = System.currentTimeMillis()
+                    + TIMEOUT_SECONDS * 1000L;
+            synchronized (received) {
+                while (!received.toString().equals(expected)) {
+                    long wait = deadline - System.currentTimeMillis();
+                    if (wait <= 0) {
+                        fail("echoed \"" + received + "\", expected \""
+                                + expected + "\"");
+                    }
+                    received.wait(wait);
+                }
+            }
+        }
+
+        @Override
+        public void disconnected() {
+        }
+
+        @Override
+        public void securityEstablished(SecurityInfo info) {
+        }
+
+        @Override
+        public void error(Exception cause) {
+        }
+    }
+
+    /**
+     * Forwards datagrams between one client and the server, from an
+     * outbound socket whose port changes on {@link #rebind}, as a NAT
+     * rebinding would.
+     */
+    static class Relay extends Thread {
+
+        private final InetSocketAddress server;
+        private final DatagramChannel inbound;
+        private final Selector selector;
+        private volatile DatagramChannel outbound;
+        private volatile SocketAddress client;
+        private volatile boolean running = true;
+
+        Relay(InetSocketAddress server) throws IOException {
+            super("quic-migration-relay");
+            setDaemon(true);
+            this.server = server;
+            selector = Selector.open();
+            inbound = open();
+            inbound.register(selector, SelectionKey.OP_READ);
+            outbound = open();
+            outbound.register(selector, SelectionKey.OP_READ);
+        }
+
+        int getPort() throws IOException {
+            return ((InetSocketAddress) inbound.getLocalAddress()).getPort();
+        }
+
+        SocketAddress getOutboundAddress() throws IOException {
+            return outbound.getLocalAddress();
+        }
+
+        /** Moves to a new outbound port; the old one is closed. */
+        void rebind() throws IOException {
+            DatagramChannel old = outbound;
+            DatagramChannel next = open();
+            synchronized (this) {
+                outbound = next;
+                selector.wakeup();
+                next.register(selector, SelectionKey.OP_READ);
+            }
+            old.close();
+        }
+
+        @Override
+        public void run() {
+            ByteBuffer buf = ByteBuffer.allocate(65535);
+            try {
+                while (running) {
+                    synchronized (this) {
+                        // lets rebind register while the selector is idle
+                    }
+                    selector.select(100);
+                    for (SelectionKey key : selector.selectedKeys()) {
+                        if (!key.isValid()) {
+                            continue;
+                        }
+                        DatagramChannel channel =
+                                (DatagramChannel) key.channel();
+                        buf.clear();
+                        SocketAddress from = channel.receive(buf);
+                        if (from == null) {
+                            continue;
+                        }
+                        buf.flip();
+                        if (channel == inbound) {
+                            client = from;
+                            outbound.send(buf, server);
+                        } else if (client != null) {
+                            inbound.send(buf, client);
+                        }
+                    }
+                    selector.selectedKeys().clear();
+                }
+            } catch (IOException e) {
+                if (running) {
+                    e.printStackTrace();
+                }
+            }
+        }
+
+        void close() throws IOException {
+            running = false;
+            selector.wakeup();
+            try {
+                join(1000);
+            } catch (InterruptedException e) {
+                Thread.currentThread().interrupt();
+            }
+            selector.close();
+            inbound.close();
+            outbound.close();
+        }
+
+        private static DatagramChannel open() throws IOException {
+            DatagramChannel channel = DatagramChannel.open();
+            channel.configureBlocking(false);
+            channel.bind(new InetSocketAddress(
+                    InetAddress.getLoopbackAddress(), 0));
+            return channel;
+        }
+    }
+
+}
@@ -0,0 +1,247 @@
+/*
+ * QuicPmtuIntegrationTest.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+import org.bluezoo.gumdrop.GumdropNative;
+import org.bluezoo.gumdrop.SelectorLoop;
+import org.bluezoo.gumdrop.TestCertificateManager;
+import org.junit.AfterClass;
+import org.junit.Assume;
+import org.junit.BeforeClass;
+import org.junit.Test;
+
+import java.io.File;
+import java.net.InetAddress;
+import java.net.InetSocketAddress;
+import java.nio.ByteBuffer;
+import java.nio.channels.DatagramChannel;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+
+import static org.junit.Assert.*;
+
+/**
+ * Integration tests for how the QUIC engine sends datagrams: a datagram
+ * larger than the interface allows (EMSGSIZE) is reported apart from
+ * other send errors, and path MTU probes above the loopback limit are
+ * lost without disturbing the connection (RFC 8899 section 4.4).
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ */
+public class QuicPmtuIntegrationTest {
+
+    private static final int PORT = 18449;
+    private static final int TIMEOUT_SECONDS = 10;
+
+    /** Largest UDP payload IPv4 can carry (65535 less IP and UDP). */
+    private static final int MAX_IPV4_UDP_PAYLOAD = 65507;
+
+    private static File pemCert;
+    private static File pemKey;
+    private static SelectorLoop loop;
+
+    @BeforeClass
+    public static void setUp() throws Exception {
+        Assume.assumeTrue(
+                "native QUIC library (libgumdrop) not available",
+                NativeMemoryLimitIntegrationTest.quicNativeAvailable());
+        File certsDir = new File("test/integration/certs");
+        certsDir.mkdirs();
+        new File(certsDir, "ca-keystore.p12").delete();
+        TestCertificateManager certManager =
+                new TestCertificateManager(certsDir);
+        certManager.generateCA("Test CA", 1);
+        certManager.generateServerCertificate("localhost", 1);
+        pemCert = new File(certsDir, "pmtu-chain.pem");
+        pemKey = new File(certsDir, "pmtu-key.pem");
+        certManager.saveServerPem(pemCert, pemKey);
+        loop = new SelectorLoop(0);
+        loop.start();
+    }
+
+    @AfterClass
+    public static void tearDown() {
+        if (loop != null) {
+            loop.shutdown();
+        }
+    }
+
+    @Test
+    public void testSendDelivers() throws Exception {
+        DatagramChannel sender = open();
+        DatagramChannel receiver = open();
+        try {
+            ByteBuffer buf = ByteBuffer.allocateDirect(100);
+            buf.put(0, (byte) 0x42);
+            byte[] to = QuicEngine.encodeAddress(
+                    (InetSocketAddress) receiver.getLocalAddress());
+            assertEquals(100, GumdropNative.udp_send(sender, buf, 100, to));
+
+            ByteBuffer in = ByteBuffer.allocate(200);
+            long deadline = System.currentTimeMillis() + 5000;
+            while (receiver.receive(in) == null
+                    && System.currentTimeMillis() < deadline) {
+                Thread.sleep(10);
+            }
+            assertEquals(100, in.position());
+            assertEquals(0x42, in.get(0));
+        } finally {
+            sender.close();
+            receiver.close();
+        }
+    }
+
+    @Test
+    public void testTooBigIsDistinct() throws Exception {
+        DatagramChannel channel = open();
+        try {
+            int len = MAX_IPV4_UDP_PAYLOAD + 1;
+            ByteBuffer buf = ByteBuffer.allocateDirect(len);
+            byte[] to = QuicEngine.encodeAddress(
+                    (InetSocketAddress) channel.getLocalAddress());
+            assertEquals(GumdropNative.UDP_SEND_TOO_BIG,
+                    GumdropNative.udp_send(channel, buf, len, to));
+        } finally {
+            channel.close();
+        }
+    }
+
+    /** Broadcast without SO_BROADCAST fails, and not with EMSGSIZE. */
+    @Test
+    public void testOtherErrorsAreNotTooBig() throws Exception {
+        DatagramChannel channel = DatagramChannel.open();
+        try {
+            channel.configureBlocking(false);
+            channel.bind(new InetSocketAddress(0));
+            ByteBuffer buf = ByteBuffer.allocateDirect(100);
+            byte[] to = QuicEngine.encodeAddress(new InetSocketAddress(
+                    InetAddress.getByName("255.255.255.255"), 9));
+            assertEquals(-1, GumdropNative.udp_send(channel, buf, 100, to));
+        } finally {
+            channel.close();
+        }
+    }
+
+    /**
+     * With PMTU discovery up to 65527 bytes, probes above the IPv4 limit
+     * fail with EMSGSIZE on loopback. They count as lost, so the
+     * connection settles below the limit instead of failing.
+     */
+    @Test
+    public void testProbesAboveLoopbackLimit() throws Exception {
+        QuicTransportFactory server = new QuicTransportFactory();
+        server.setApplicationProtocols("h3");
+        server.setCertFile(pemCert.toPath());
+        server.setKeyFile(pemKey.toPath());
+        server.setMaxUdpPayloadSize(65527);
+        server.setPmtuDiscovery(true);
+        QuicTransportFactory client = new QuicTransportFactory();
+        client.setApplicationProtocols("h3");
+        client.setVerifyPeer(false);
+        client.setMaxUdpPayloadSize(65527);
+        client.setPmtuDiscovery(true);
+        server.start();
+        client.start();
+        QuicEngine serverEngine = server.createServerEngine(
+                InetAddress.getLoopbackAddress(), PORT,
+                new QuicEngine.ConnectionAcceptedHandler() {
+                    @Override
+                    public void connectionAccepted(QuicConnection c) {
+                    }
+                }, loop);
+        QuicEngine clientEngine = null;
+        try {
+            final CountDownLatch latch = new CountDownLatch(1);
+            final QuicConnection[] connection = new QuicConnection[1];
+            clientEngine = client.connect(InetAddress.getLoopbackAddress(),
+                    PORT, new QuicEngine.ConnectionAcceptedHandler() {
+                        @Override
+                        public void connectionAccepted(QuicConnection c) {
+                            connection[0] = c;
+                            latch.countDown();
+                        }
+
+                        @Override
+                        public void connectionFailed(QuicConnection c) {
+                            latch.countDown();
+                        }
+                    }, loop, "localhost");
+            assertTrue("no outcome",
+                    latch.await(TIMEOUT_SECONDS, TimeUnit.SECONDS));
+            assertNotNull("handshake failed", connection[0]);
+
+            // Give discovery time to probe past the limit
+            Thread.sleep(2000);
+            QuicConnectionStats stats = stats(connection[0]);
+            assertNotNull("connection closed", stats);
+            assertTrue("sends " + stats.getMaxSendUdpPayloadSize(),
+                    stats.getMaxSendUdpPayloadSize() <= MAX_IPV4_UDP_PAYLOAD);
+        } finally {
+            if (clientEngine != null) {
+                close(clientEngine);
+            }
+            close(serverEngine);
+            server.stop();
+            client.stop();
+        }
+    }
+
+    // ── Helpers ──
+
+    private static DatagramChannel open() throws Exception {
+        DatagramChannel channel = DatagramChannel.open();
+        channel.configureBlocking(false);
+        channel.bind(new InetSocketAddress(
+                InetAddress.getLoopbackAddress(), 0));
+        return channel;
+    }
+
+    /** Reads a connection's stats on its SelectorLoop. */
+    private static QuicConnectionStats stats(final QuicConnection c)
+            throws Exception {
+        final CountDownLatch done = new CountDownLatch(1);
+        final QuicConnectionStats[] stats = new QuicConnectionStats[1];
+        loop.invokeLater(new Runnable() {
+            @Override
+            public void run() {
+                stats[0] = c.getStats();
+                done.countDown();
+            }
+        });
+        assertTrue(done.await(TIMEOUT_SECONDS, TimeUnit.SECONDS));
+        return stats[0];
+    }
+
+    /** Closes an engine on its SelectorLoop, which owns its state. */
+    private static void close(final QuicEngine engine) throws Exception {
+        final CountDownLatch closed = new CountDownLatch(1);
+        loop.invokeLater(new Runnable() {
+            @Override
+            public void run() {
+                engine.close();
+                closed.countDown();
+            }
+        });
+        assertTrue(closed.await(TIMEOUT_SECONDS, TimeUnit.SECONDS));
+    }
+
+}
@@ -0,0 +1,161 @@
+/*
+ * TCPEndpointSendFileTest.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop;
+
+import java.io.ByteArrayOutputStream;
+import java.net.InetAddress;
+import java.net.InetSocketAddress;
+import java.nio.ByteBuffer;
+import java.nio.channels.FileChannel;
+import java.nio.channels.ServerSocketChannel;
+import java.nio.channels.SocketChannel;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.nio.file.StandardOpenOption;
+
+import org.junit.After;
+import org.junit.Before;
+import org.junit.Test;
+
+import static org.junit.Assert.*;
+
+/**
+ * Unit tests for {@link TCPEndpoint#sendFile}: ordering of file ranges
+ * against data sent before and after them on a plaintext connection.
+ * The SelectorLoop's write path is driven by hand.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ */
+public class TCPEndpointSendFileTest {
+
+    private ServerSocketChannel server;
+    private SocketChannel client;
+    private SocketChannel accepted;
+    private Path file;
+
+    @Before
+    public void setUp() throws Exception {
+        server = ServerSocketChannel.open();
+        server.bind(new InetSocketAddress(InetAddress.getLoopbackAddress(), 0));
+        client = SocketChannel.open(server.getLocalAddress());
+        client.configureBlocking(false);
+        accepted = server.accept();
+        accepted.configureBlocking(false);
+        file = Files.createTempFile("sendfile", ".txt");
+        Files.write(file, "0123456789".getBytes(StandardCharsets.US_ASCII));
+    }
+
+    @After
+    public void tearDown() throws Exception {
+        client.close();
+        accepted.close();
+        server.close();
+        Files.deleteIfExists(file);
+    }
+
+    @Test
+    public void testNoChannel() throws Exception {
+        TCPEndpoint endpoint = new TCPEndpoint(new NullHandler());
+        assertFalse(endpoint.canSendFile());
+        try (FileChannel fc = FileChannel.open(file, StandardOpenOption.READ)) {
+            assertFalse(endpoint.sendFile(fc, 0, 10));
+            // Refused: the channel is still the caller's
+            assertTrue(fc.isOpen());
+        }
+    }
+
+    @Test
+    public void testRangeOrderedBetweenSends() throws Exception {
+        TCPEndpoint endpoint = new TCPEndpoint(new NullHandler());
+        endpoint.setChannel(accepted);
+        endpoint.init();
+        assertTrue(endpoint.canSendFile());
+
+        FileChannel fc = FileChannel.open(file, StandardOpenOption.READ);
+        endpoint.send(ascii("head:"));
+        assertTrue(endpoint.sendFile(fc, 2, 5));
+        endpoint.send(ascii(":tail"));
+        assertTrue(endpoint.hasDeferredOutput());
+
+        String expected = "head:23456:tail";
+        assertEquals(expected, drain(endpoint, expected.length()));
+        assertFalse(endpoint.hasDeferredOutput());
+        // The endpoint closes the channel once the range is written
+        assertFalse(fc.isOpen());
+        endpoint.doClose();
+    }
+
+    /** Performs the SelectorLoop's write steps until nothing is left. */
+    private String drain(TCPEndpoint endpoint, int expected)
+            throws Exception {
+        ByteArrayOutputStream received = new ByteArrayOutputStream();
+        ByteBuffer in = ByteBuffer.allocate(64);
+        for (int i = 0; i < 1000 && received.size() < expected; i++) {
+            synchronized (endpoint.netOutLock) {
+                ByteBuffer netOut = endpoint.getNetOut();
+                netOut.flip();
+                accepted.write(netOut);
+                netOut.compact();
+                if (netOut.position() == 0) {
+                    endpoint.writeDeferred(accepted);
+                }
+            }
+            in.clear();
+            int n = client.read(in);
+            if (n > 0) {
+                received.write(in.array(), 0, n);
+            } else {
+                Thread.sleep(1);
+            }
+        }
+        return new String(received.toByteArray(), StandardCharsets.US_ASCII);
+    }
+
+    private static ByteBuffer ascii(String s) {
+        return ByteBuffer.wrap(s.getBytes(StandardCharsets.US_ASCII));
+    }
+
+    private static class NullHandler implements ProtocolHandler {
+
+        @Override
+        public void receive(ByteBuffer data) {
+        }
+
+        @Override
+        public void connected(Endpoint endpoint) {
+        }
+
+        @Override
+        public void disconnected() {
+        }
+
+        @Override
+        public void securityEstablished(SecurityInfo info) {
+        }
+
+        @Override
+        public void error(Exception cause) {
+        }
+    }
+
+}
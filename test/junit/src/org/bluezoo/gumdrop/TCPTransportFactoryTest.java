@@ -56,6 +56,42 @@ public class TCPTransportFactoryTest {
         assertFalse(factory.isTcpFastOpen());
     }
 
+    @Test
+    public void testTlsEngineDefaultsToJsse() {
+        TCPTransportFactory factory = new TCPTransportFactory();
+        assertFalse(factory.isNativeTls());
+    }
+
+    /**
+     * The native engine is only in use once start() has built its
+     * SSL_CTX; selecting it does not by itself change anything.
+     */
+    @Test
+    public void testTlsEngineNativeBeforeStart() {
+        TCPTransportFactory factory = new TCPTransportFactory();
+        factory.setTlsEngine("native");
+        assertFalse(factory.isNativeTls());
+        factory.setTlsEngine("JSSE");
+        assertFalse(factory.isNativeTls());
+    }
+
+    @Test(expected = IllegalArgumentException.class)
+    public void testTlsEngineUnknown() {
+        new TCPTransportFactory().setTlsEngine("openssl");
+    }
+
+    /**
+     * Kernel TLS is only in use once the native engine's SSL_CTX has
+     * been prepared for it.
+     */
+    @Test
+    public void testKernelTlsBeforeStart() {
+        TCPTransportFactory factory = new TCPTransportFactory();
+        assertFalse(factory.isKernelTls());
+        factory.setKernelTls(true);
+        assertFalse(factory.isKernelTls());
+    }
+
     /**
      * RFC 5077 / RFC 7858 section 3.4: TLS session cache is configured
      * when an SSLContext is initialised (integration-level; here we
@@ -0,0 +1,298 @@
+/*
+ * HTTP3ConnectionPoolTest.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.http.client;
+
+import java.io.IOException;
+import java.net.InetAddress;
+import java.util.ArrayList;
+import java.util.List;
+
+import org.bluezoo.gumdrop.SelectorLoop;
+import org.bluezoo.gumdrop.http.h3.HTTP3ClientHandler;
+import org.bluezoo.gumdrop.quic.QuicConnection;
+
+import org.junit.Before;
+import org.junit.Test;
+
+import static org.junit.Assert.*;
+
+/**
+ * Unit tests for {@link HTTP3ConnectionPool} connection selection,
+ * saturation and eviction. Connections are stubs whose handshake
+ * completion, stream credit and GOAWAY state the tests set directly, so
+ * no QUIC stack is needed. The SelectorLoop is never started: tasks the
+ * pool hands to it (opening a connection) are simply not run.
+ */
+public class HTTP3ConnectionPoolTest {
+
+    private TestPool pool;
+    private SelectorLoop loop;
+    private InetAddress address;
+    private HTTP3ConnectionPool.Target target;
+
+    @Before
+    public void setUp() throws Exception {
+        pool = new TestPool();
+        loop = new SelectorLoop(0);
+        address = InetAddress.getByName("192.0.2.1");
+        target = new HTTP3ConnectionPool.Target(loop, address, 443,
+                "example.com");
+    }
+
+    @Test
+    public void testFirstAcquireOpensConnection() {
+        RecordingCallback cb = acquire();
+        assertEquals(1, pool.created.size());
+        assertEquals(1, pool.getConnectionCount(target));
+        assertEquals(0, cb.acquired);
+
+        StubConnection c = pool.created.get(0);
+        c.credit = 100;
+        pool.established(c);
+        assertEquals(1, cb.acquired);
+        assertSame(c, pool.select(target));
+    }
+
+    @Test
+    public void testAcquireJoinsHandshakeInProgress() {
+        RecordingCallback cb1 = acquire();
+        RecordingCallback cb2 = acquire();
+        assertEquals("second caller must not open another connection",
+                1, pool.created.size());
+
+        StubConnection c = pool.created.get(0);
+        c.credit = 100;
+        pool.established(c);
+        assertEquals(1, cb1.acquired);
+        assertEquals(1, cb2.acquired);
+    }
+
+    @Test
+    public void testWarmConnectionReused() {
+        acquire();
+        StubConnection c = pool.created.get(0);
+        c.credit = 100;
+        pool.established(c);
+
+        RecordingCallback cb = acquire();
+        assertEquals(1, pool.created.size());
+        assertEquals(0, cb.failed);
+    }
+
+    @Test
+    public void testSelectNeverOpens() {
+        assertNull(pool.select(target));
+        assertNull(pool.select(loop, address, 443, "example.com"));
+        assertEquals(0, pool.created.size());
+        assertEquals(0, pool.getConnectionCount(target));
+    }
+
+    @Test
+    public void testSelectIgnoresHandshakeInProgress() {
+        acquire();
+        pool.created.get(0).credit = 100;
+        assertNull(pool.select(target));
+    }
+
+    @Test
+    public void testSaturatedConnectionOpensAnother() {
+        StubConnection c1 = establish(0);
+        acquire();
+        assertEquals(2, pool.created.size());
+        assertNull("saturated connection must not be selected",
+                pool.select(target));
+
+        StubConnection c2 = pool.created.get(1);
+        c2.credit = 5;
+        pool.established(c2);
+        assertSame(c2, pool.select(target));
+
+        // MAX_STREAMS raised on the first connection
+        c1.credit = 10;
+        assertSame("most stream credit wins", c1, pool.select(target));
+    }
+
+    @Test
+    public void testSaturatedAtLimitFails() {
+        pool.setMaxConnectionsPerTarget(2);
+        establish(0);
+        acquire();
+        pool.established(pool.created.get(1));
+
+        RecordingCallback cb = acquire();
+        assertEquals(1, cb.failed);
+        assertEquals(0, cb.acquired);
+        assertEquals(2, pool.created.size());
+    }
+
+    @Test
+    public void testClosedConnectionEvicted() {
+        StubConnection c = establish(100);
+        c.closed = true;
+        assertNull(pool.select(target));
+        assertEquals(0, pool.getConnectionCount(target));
+
+        // A replacement is opened for the next caller
+        acquire();
+        assertEquals(2, pool.created.size());
+    }
+
+    @Test
+    public void testGoawayConnectionEvictedWhenIdle() {
+        StubConnection c = establish(100);
+        c.goaway = true;
+        c.active = 2;
+        assertNull(pool.select(target));
+        assertEquals("kept while requests are in flight",
+                1, pool.getConnectionCount(target));
+
+        c.active = 0;
+        assertNull(pool.select(target));
+        assertEquals(0, pool.getConnectionCount(target));
+    }
+
+    @Test
+    public void testHandshakeFailureFailsWaiters() {
+        RecordingCallback cb1 = acquire();
+        RecordingCallback cb2 = acquire();
+        pool.failed(pool.created.get(0), new IOException("handshake"));
+        assertEquals(1, cb1.failed);
+        assertEquals(1, cb2.failed);
+        assertEquals(0, pool.getConnectionCount(target));
+    }
+
+    @Test
+    public void testTargetsAreSeparate() throws Exception {
+        establish(100);
+        HTTP3ConnectionPool.Target other = new HTTP3ConnectionPool.Target(
+                new SelectorLoop(1), address, 443, "example.com");
+        assertNull("each loop has its own connections", pool.select(other));
+        other = new HTTP3ConnectionPool.Target(loop, address, 443,
+                "example.org");
+        assertNull(pool.select(other));
+    }
+
+    @Test
+    public void testClosedPoolFailsAcquire() {
+        RecordingCallback pending = acquire();
+        pool.close();
+        assertEquals(1, pending.failed);
+
+        RecordingCallback cb = acquire();
+        assertEquals(1, cb.failed);
+        assertEquals(1, pool.created.size());
+        assertEquals("closed pool must stay empty", 0, pool.getTargetCount());
+    }
+
+    // ── Helpers ──
+
+    private RecordingCallback acquire() {
+        RecordingCallback cb = new RecordingCallback();
+        pool.acquire(loop, address, 443, "example.com", cb);
+        return cb;
+    }
+
+    /**
+     * Opens and establishes a connection with the given stream credit.
+     */
+    private StubConnection establish(long credit) {
+        acquire();
+        StubConnection c = pool.created.get(pool.created.size() - 1);
+        c.credit = credit;
+        pool.established(c);
+        return c;
+    }
+
+    private static class TestPool extends HTTP3ConnectionPool {
+
+        final List<StubConnection> created = new ArrayList<StubConnection>();
+
+        TestPool() {
+            super(null);
+        }
+
+        @Override
+        PooledConnection newConnection(Target target) {
+            StubConnection c = new StubConnection(target);
+            created.add(c);
+            return c;
+        }
+    }
+
+    private static class StubConnection
+            extends HTTP3ConnectionPool.PooledConnection {
+
+        boolean established;
+        boolean closed;
+        boolean goaway;
+        int active;
+        long credit;
+
+        StubConnection(HTTP3ConnectionPool.Target target) {
+            super(target);
+        }
+
+        @Override
+        void establish() {
+            established = true;
+        }
+
+        @Override
+        boolean isEstablished() {
+            return established;
+        }
+
+        @Override
+        boolean isDead() {
+            return closed || (goaway && active == 0);
+        }
+
+        @Override
+        boolean canSendRequest() {
+            return !goaway && credit > 0;
+        }
+
+        @Override
+        long getStreamCredit() {
+            return credit;
+        }
+    }
+
+    private static class RecordingCallback
+            implements HTTP3ConnectionPool.AcquireCallback {
+
+        int acquired;
+        int failed;
+
+        @Override
+        public void acquired(HTTP3ClientHandler handler,
+                             QuicConnection connection) {
+            acquired++;
+        }
+
+        @Override
+        public void failed(IOException cause) {
+            failed++;
+        }
+    }
+
+}
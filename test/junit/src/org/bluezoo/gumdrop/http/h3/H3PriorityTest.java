@@ -0,0 +1,91 @@
+/*
+ * H3PriorityTest.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * Tests for Priority Field Value parsing (RFC 9218).
+ */
+
+package org.bluezoo.gumdrop.http.h3;
+
+import org.junit.Test;
+import static org.junit.Assert.*;
+
+public class H3PriorityTest {
+
+    @Test
+    public void testNullIsDefault() {
+        H3Priority p = H3Priority.parse(null);
+        assertEquals(3, p.urgency);
+        assertFalse(p.incremental);
+    }
+
+    @Test
+    public void testUrgencyOnly() {
+        H3Priority p = H3Priority.parse("u=1");
+        assertEquals(1, p.urgency);
+        assertFalse(p.incremental);
+    }
+
+    /**
+     * RFC 9218 section 4.2: a bare "i" is the boolean true.
+     */
+    @Test
+    public void testBareIncremental() {
+        H3Priority p = H3Priority.parse("u=5, i");
+        assertEquals(5, p.urgency);
+        assertTrue(p.incremental);
+    }
+
+    @Test
+    public void testExplicitBooleans() {
+        assertTrue(H3Priority.parse("i=?1").incremental);
+        assertFalse(H3Priority.parse("i=?0").incremental);
+    }
+
+    /**
+     * RFC 9218 section 4.1: out-of-range urgency is ignored.
+     */
+    @Test
+    public void testOutOfRangeUrgencyIgnored() {
+        assertEquals(3, H3Priority.parse("u=8").urgency);
+        assertEquals(3, H3Priority.parse("u=-1").urgency);
+        assertEquals(3, H3Priority.parse("u=abc").urgency);
+    }
+
+    /**
+     * RFC 8941 section 3.3.1: an sf-integer has no plus sign, and is
+     * limited to 15 digits.
+     */
+    @Test
+    public void testMalformedUrgencyIgnored() {
+        assertEquals(3, H3Priority.parse("u=+1").urgency);
+        assertEquals(3, H3Priority.parse("u=1.0").urgency);
+        assertEquals(3, H3Priority.parse("u=").urgency);
+        assertEquals(3, H3Priority.parse("u=0000000000000001").urgency);
+        assertEquals(1, H3Priority.parse("u=000000000000001").urgency);
+        assertEquals(3, H3Priority.parse("u=99999999999").urgency);
+    }
+
+    /**
+     * RFC 9218 section 4: unknown parameters are ignored.
+     */
+    @Test
+    public void testUnknownParametersIgnored() {
+        H3Priority p = H3Priority.parse("x=1, u=0;foo, y");
+        assertEquals(0, p.urgency);
+        assertFalse(p.incremental);
+    }
+
+    @Test
+    public void testToString() {
+        assertEquals("", H3Priority.DEFAULT.toString());
+        assertEquals("u=1, i", new H3Priority(1, true).toString());
+        assertEquals("i", new H3Priority(3, true).toString());
+    }
+
+    @Test(expected = IllegalArgumentException.class)
+    public void testInvalidUrgencyRejected() {
+        new H3Priority(8, false);
+    }
+
+}
@@ -77,6 +77,25 @@ public class HTTP3ListenerTest {
         assertEquals(64L, getField(listener, "quicMaxStreamsUni"));
     }
 
+    @Test
+    public void testDefaultH3Settings() throws Exception {
+        HTTP3Listener listener = new HTTP3Listener();
+        assertEquals(0L, getField(listener, "qpackMaxTableCapacity"));
+        assertEquals(0L, getField(listener, "qpackBlockedStreams"));
+        assertEquals(16384L, getField(listener, "maxFieldSectionSize"));
+    }
+
+    @Test
+    public void testSetH3Settings() throws Exception {
+        HTTP3Listener listener = new HTTP3Listener();
+        listener.setQpackMaxTableCapacity(4096);
+        listener.setQpackBlockedStreams(16);
+        listener.setMaxFieldSectionSize(65536);
+        assertEquals(4096L, getField(listener, "qpackMaxTableCapacity"));
+        assertEquals(16L, getField(listener, "qpackBlockedStreams"));
+        assertEquals(65536L, getField(listener, "maxFieldSectionSize"));
+    }
+
     @Test
     public void testDefaultPort() {
         HTTP3Listener listener = new HTTP3Listener();
@@ -0,0 +1,77 @@
+/*
+ * QPACKFieldSizeTest.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * Tests for QPACK field section size accounting (RFC 9204).
+ */
+
+package org.bluezoo.gumdrop.http.h3;
+
+import org.junit.Test;
+import static org.junit.Assert.*;
+
+public class QPACKFieldSizeTest {
+
+    @Test
+    public void testDecodedSize() {
+        String[] headers = { ":status", "200", "content-type", "text/css" };
+        assertEquals(7 + 3 + 12 + 8, QPACKFieldSize.decodedSize(headers));
+    }
+
+    /**
+     * RFC 9204 section 4.5.2: exact static matches are one byte each
+     * (indices below 63), after the two-byte section prefix.
+     */
+    @Test
+    public void testIndexedStatic() {
+        String[] headers = { ":status", "200", "content-type", "text/css" };
+        assertEquals(2 + 1 + 1, QPACKFieldSize.encodedSize(headers));
+    }
+
+    /**
+     * Index 98 (x-frame-options: sameorigin) needs a second byte with a
+     * 6-bit prefix.
+     */
+    @Test
+    public void testIndexedStaticHighIndex() {
+        String[] headers = { "X-Frame-Options", "sameorigin" };
+        assertEquals(2 + 2, QPACKFieldSize.encodedSize(headers));
+    }
+
+    /**
+     * RFC 9204 section 4.5.4: static name reference plus value literal.
+     * ":status 201" uses name index 24 (2 bytes with a 4-bit prefix) and
+     * "201" Huffman-codes to 2 bytes, plus a 1-byte length.
+     */
+    @Test
+    public void testLiteralWithNameReference() {
+        String[] headers = { ":status", "201" };
+        assertEquals(2 + 2 + 1 + 2, QPACKFieldSize.encodedSize(headers));
+    }
+
+    /**
+     * Encoded size never exceeds decoded size plus framing overhead, and
+     * repeated common fields compress well.
+     */
+    @Test
+    public void testCompressesTypicalResponse() {
+        String[] headers = {
+            ":status", "200",
+            "content-type", "application/json",
+            "cache-control", "no-cache",
+            "vary", "accept-encoding",
+            "x-request-id", "4bf92f3577b34da6a3ce929d0e0e4736",
+        };
+        assertTrue(QPACKFieldSize.encodedSize(headers)
+                < QPACKFieldSize.decodedSize(headers) / 2);
+    }
+
+    @Test
+    public void testIntegerSize() {
+        assertEquals(1, QPACKFieldSize.integerSize(62, 6));
+        assertEquals(2, QPACKFieldSize.integerSize(63, 6));
+        assertEquals(2, QPACKFieldSize.integerSize(63 + 127, 6));
+        assertEquals(3, QPACKFieldSize.integerSize(63 + 128, 6));
+    }
+
+}
@@ -0,0 +1,190 @@
+/*
+ * HandshakeAdmissionTest.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+import java.net.InetAddress;
+import java.net.InetSocketAddress;
+
+import org.bluezoo.gumdrop.ratelimit.ConnectionRateLimiter;
+import org.junit.Test;
+
+import static org.junit.Assert.*;
+
+/**
+ * Unit tests for {@link HandshakeAdmission}: the half-open and rate
+ * budgets, and Retry tokens (RFC 9000 section 8.1).
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ */
+public class HandshakeAdmissionTest {
+
+    private static final InetSocketAddress CLIENT =
+            new InetSocketAddress(InetAddress.getLoopbackAddress(), 40000);
+    private static final byte[] ODCID = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    private static final byte[] RETRY_SCID = {
+        9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9
+    };
+
+    @Test
+    public void testRetryTokenRoundTrip() {
+        HandshakeAdmission admission = new HandshakeAdmission(10, 0, 0, null);
+        byte[] token = admission.retryToken(CLIENT, ODCID, RETRY_SCID);
+        assertArrayEquals(ODCID,
+                admission.validateRetryToken(token, CLIENT, RETRY_SCID));
+    }
+
+    @Test
+    public void testRetryTokenBoundToClient() {
+        HandshakeAdmission admission = new HandshakeAdmission(10, 0, 0, null);
+        byte[] token = admission.retryToken(CLIENT, ODCID, RETRY_SCID);
+        InetSocketAddress other = new InetSocketAddress(
+                CLIENT.getAddress(), CLIENT.getPort() + 1);
+        assertNull(admission.validateRetryToken(token, other, RETRY_SCID));
+        assertNull(admission.validateRetryToken(token, CLIENT, ODCID));
+        token[3] ^= 1;
+        assertNull(admission.validateRetryToken(token, CLIENT, RETRY_SCID));
+    }
+
+    @Test
+    public void testRetryTokenFromAnotherEngineRejected() {
+        HandshakeAdmission a = new HandshakeAdmission(10, 0, 0, null);
+        HandshakeAdmission b = new HandshakeAdmission(10, 0, 0, null);
+        byte[] token = a.retryToken(CLIENT, ODCID, RETRY_SCID);
+        assertNull(b.validateRetryToken(token, CLIENT, RETRY_SCID));
+        assertNull(b.validateRetryToken(new byte[3], CLIENT, RETRY_SCID));
+    }
+
+    /**
+     * Unvalidated clients are retried from half the half-open budget;
+     * validated ones are refused only when it is full.
+     */
+    @Test
+    public void testHalfOpenBudget() {
+        InetAddress ip = CLIENT.getAddress();
+        HandshakeAdmission admission = new HandshakeAdmission(4, 0, 0, null);
+        Object[] conns = { new Object(), new Object(), new Object(),
+                new Object() };
+        assertEquals(HandshakeAdmission.Decision.ACCEPT,
+                admission.admit(ip, false));
+        admission.opened(conns[0], ip);
+        admission.opened(conns[1], ip);
+        assertEquals(HandshakeAdmission.Decision.RETRY,
+                admission.admit(ip, false));
+        assertEquals(HandshakeAdmission.Decision.ACCEPT,
+                admission.admit(ip, true));
+        admission.opened(conns[2], ip);
+        admission.opened(conns[3], ip);
+        assertEquals(HandshakeAdmission.Decision.REFUSE,
+                admission.admit(ip, true));
+        admission.established(conns[0]);
+        assertEquals(3, admission.getHalfOpen());
+        assertEquals(HandshakeAdmission.Decision.ACCEPT,
+                admission.admit(ip, true));
+    }
+
+    /**
+     * A connection that closes after its handshake completed leaves the
+     * half-open count once, whichever of established and closed the
+     * engine reports first, and however often.
+     */
+    @Test
+    public void testHalfOpenCountedOnce() {
+        InetAddress ip = CLIENT.getAddress();
+        HandshakeAdmission admission = new HandshakeAdmission(4, 0, 0, null);
+        Object a = new Object();
+        Object b = new Object();
+        Object c = new Object();
+        admission.opened(a, ip);
+        admission.opened(b, ip);
+        admission.opened(c, ip);
+        admission.established(a);
+        admission.closed(a, ip);
+        assertEquals(2, admission.getHalfOpen());
+        admission.closed(b, ip);
+        admission.established(b);
+        admission.closed(b, ip);
+        assertEquals(1, admission.getHalfOpen());
+        admission.closed(new Object(), ip);
+        assertEquals("never admitted", 1, admission.getHalfOpen());
+        admission.closed(c, ip);
+        assertEquals(0, admission.getHalfOpen());
+    }
+
+    @Test
+    public void testHandshakeRate() {
+        InetAddress ip = CLIENT.getAddress();
+        HandshakeAdmission admission = new HandshakeAdmission(0, 1, 2, null);
+        assertEquals(HandshakeAdmission.Decision.ACCEPT,
+                admission.admit(ip, true));
+        admission.opened(new Object(), ip);
+        assertEquals(HandshakeAdmission.Decision.ACCEPT,
+                admission.admit(ip, true));
+        admission.opened(new Object(), ip);
+        assertEquals(HandshakeAdmission.Decision.REFUSE,
+                admission.admit(ip, true));
+        assertEquals(HandshakeAdmission.Decision.RETRY,
+                admission.admit(ip, false));
+    }
+
+    @Test
+    public void testPerSourceLimit() {
+        InetAddress ip = CLIENT.getAddress();
+        ConnectionRateLimiter limiter = new ConnectionRateLimiter();
+        limiter.setMaxConcurrentPerIP(1);
+        HandshakeAdmission admission =
+                new HandshakeAdmission(0, 0, 0, limiter);
+        Object conn = new Object();
+        assertEquals(HandshakeAdmission.Decision.ACCEPT,
+                admission.admit(ip, true));
+        admission.opened(conn, ip);
+        assertEquals(HandshakeAdmission.Decision.REFUSE,
+                admission.admit(ip, true));
+        assertEquals(HandshakeAdmission.Decision.RETRY,
+                admission.admit(ip, false));
+        admission.closed(conn, ip);
+        assertEquals(HandshakeAdmission.Decision.ACCEPT,
+                admission.admit(ip, true));
+    }
+
+    /**
+     * With per-address limits on, an unvalidated client is always sent
+     * a Retry, and its claimed address is not charged: a flood spoofing
+     * a victim's address cannot use up the victim's allowance.
+     */
+    @Test
+    public void testPerSourceLimitRetriesUnvalidated() {
+        InetAddress ip = CLIENT.getAddress();
+        ConnectionRateLimiter limiter = new ConnectionRateLimiter();
+        limiter.setMaxConcurrentPerIP(1);
+        limiter.setConnectionRate(2, 60000L);
+        HandshakeAdmission admission =
+                new HandshakeAdmission(0, 0, 0, limiter);
+        for (int i = 0; i < 10; i++) {
+            assertEquals(HandshakeAdmission.Decision.RETRY,
+                    admission.admit(ip, false));
+        }
+        assertEquals(0, admission.getHalfOpen());
+        assertEquals(HandshakeAdmission.Decision.ACCEPT,
+                admission.admit(ip, true));
+    }
+
+}
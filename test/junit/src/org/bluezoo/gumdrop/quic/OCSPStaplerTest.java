@@ -0,0 +1,540 @@
+/*
+ * OCSPStaplerTest.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+import java.io.ByteArrayOutputStream;
+import java.io.File;
+import java.io.IOException;
+import java.io.InputStream;
+import java.net.URI;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.security.KeyStore;
+import java.security.MessageDigest;
+import java.security.PrivateKey;
+import java.security.Signature;
+import java.security.cert.Certificate;
+import java.security.cert.CertificateFactory;
+import java.security.cert.X509Certificate;
+import java.text.SimpleDateFormat;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Date;
+import java.util.List;
+import java.util.TimeZone;
+
+import org.junit.AfterClass;
+import org.junit.BeforeClass;
+import org.junit.Test;
+
+import static org.junit.Assert.*;
+
+/**
+ * Unit tests for {@link OCSPStapler}: request encoding, responder
+ * discovery, response verification, refresh scheduling and lifecycle.
+ * The certificate chain is made with keytool: a CA and a leaf it signed
+ * whose Authority Information Access extension names a responder that
+ * is never contacted. Responses are built and signed here, and handed
+ * over by a stapler whose fetch and timer are replaced.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ */
+public class OCSPStaplerTest {
+
+    static final String RESPONDER = "http://127.0.0.1:9/ocsp";
+    static final String PASSWORD = "changeit";
+    static final long INTERVAL = 3600000L;
+    static final long DAY = 86400000L;
+
+    // AlgorithmIdentifier for id-sha1 with NULL parameters
+    static final byte[] SHA1 = {
+        0x06, 0x05, 0x2b, 0x0e, 0x03, 0x02, 0x1a, 0x05, 0x00
+    };
+    // ecdsa-with-SHA256
+    static final byte[] ECDSA_SHA256 = {
+        0x2a, (byte) 0x86, 0x48, (byte) 0xce, 0x3d, 0x04, 0x03, 0x02
+    };
+    // id-pkix-ocsp-basic
+    static final byte[] OCSP_BASIC = {
+        0x2b, 0x06, 0x01, 0x05, 0x05, 0x07, 0x30, 0x01, 0x01
+    };
+
+    static Path dir;
+    static Path keystore;
+    static Path chain;
+    static X509Certificate leafCert;
+    static X509Certificate caCert;
+    static PrivateKey caKey;
+    static PrivateKey leafKey;
+
+    @BeforeClass
+    public static void createChain() throws Exception {
+        dir = Files.createTempDirectory("ocsp-test");
+        keystore = dir.resolve("keys.p12");
+        keytool("-genkeypair", "-alias", "ca", "-keyalg", "EC",
+                "-groupname", "secp256r1", "-validity", "2",
+                "-dname", "CN=Test CA", "-ext", "bc:c");
+        keytool("-genkeypair", "-alias", "leaf", "-keyalg", "EC",
+                "-groupname", "secp256r1", "-validity", "2",
+                "-dname", "CN=leaf.test");
+        Path csr = dir.resolve("leaf.csr");
+        Path leaf = dir.resolve("leaf.pem");
+        Path ca = dir.resolve("ca.pem");
+        keytool("-certreq", "-alias", "leaf", "-file", csr.toString());
+        keytool("-gencert", "-alias", "ca", "-infile", csr.toString(),
+                "-outfile", leaf.toString(), "-rfc", "-validity", "2",
+                "-ext", "AIA=ocsp:uri:" + RESPONDER);
+        keytool("-exportcert", "-alias", "ca", "-rfc",
+                "-file", ca.toString());
+        chain = dir.resolve("chain.pem");
+        List<String> lines = new ArrayList<String>();
+        lines.addAll(Files.readAllLines(leaf));
+        lines.addAll(Files.readAllLines(ca));
+        Files.write(chain, lines);
+
+        CertificateFactory cf = CertificateFactory.getInstance("X.509");
+        try (InputStream in = Files.newInputStream(chain)) {
+            List<Certificate> certs =
+                    new ArrayList<Certificate>(cf.generateCertificates(in));
+            leafCert = (X509Certificate) certs.get(0);
+            caCert = (X509Certificate) certs.get(1);
+        }
+        KeyStore ks = KeyStore.getInstance("PKCS12");
+        try (InputStream in = Files.newInputStream(keystore)) {
+            ks.load(in, PASSWORD.toCharArray());
+        }
+        caKey = (PrivateKey) ks.getKey("ca", PASSWORD.toCharArray());
+        leafKey = (PrivateKey) ks.getKey("leaf", PASSWORD.toCharArray());
+    }
+
+    @AfterClass
+    public static void deleteChain() {
+        if (dir != null) {
+            delete(dir.toFile());
+        }
+    }
+
+    // ── Request ──
+
+    /**
+     * RFC 6960 section 4.1.1: one Request whose CertID hashes the
+     * issuer's name and key with SHA-1 and carries the leaf's serial.
+     */
+    @Test
+    public void testRequestEncoding() throws Exception {
+        byte[] expected = der(0x30, der(0x30, der(0x30, der(0x30,
+                certId()))));
+        assertArrayEquals(expected, newStapler().encodeRequest());
+    }
+
+    @Test
+    public void testResponderFromCertificate() throws Exception {
+        assertEquals(URI.create(RESPONDER),
+                OCSPStapler.ocspResponder(leafCert));
+        assertNull("no Authority Information Access",
+                OCSPStapler.ocspResponder(caCert));
+    }
+
+    @Test
+    public void testRefreshSendsRequest() throws Exception {
+        TestStapler stapler = new TestStapler(null);
+        stapler.next = goodResponse();
+        stapler.refresh();
+        assertEquals(1, stapler.requests.size());
+        assertArrayEquals(stapler.encodeRequest(),
+                stapler.requests.get(0));
+    }
+
+    // ── Verification ──
+
+    @Test
+    public void testGoodResponseVerifies() throws Exception {
+        assertTrue(newStapler().verify(goodResponse()));
+    }
+
+    @Test
+    public void testRevokedResponseRejected() throws Exception {
+        long now = System.currentTimeMillis();
+        byte[] revoked = der(0xa1, der(0x18, time(now - DAY)));
+        assertFalse(newStapler().verify(
+                response(revoked, now - 60000, now + DAY, caKey)));
+    }
+
+    @Test
+    public void testExpiredResponseRejected() throws Exception {
+        long now = System.currentTimeMillis();
+        assertFalse(newStapler().verify(
+                response(GOOD, now - 3 * DAY, now - 2 * DAY, caKey)));
+    }
+
+    @Test
+    public void testWrongSignerRejected() throws Exception {
+        long now = System.currentTimeMillis();
+        assertFalse(newStapler().verify(
+                response(GOOD, now - 60000, now + DAY, leafKey)));
+    }
+
+    @Test
+    public void testMalformedResponseRejected() throws Exception {
+        OCSPStapler stapler = newStapler();
+        assertFalse(stapler.verify(new byte[0]));
+        assertFalse(stapler.verify(new byte[] { 0x30, 0x00 }));
+        byte[] good = goodResponse();
+        assertFalse(stapler.verify(Arrays.copyOf(good, good.length / 2)));
+    }
+
+    // ── Scheduling ──
+
+    @Test
+    public void testFirstFetchImmediate() throws Exception {
+        TestStapler stapler = new TestStapler(null);
+        stapler.start();
+        try {
+            assertEquals(Arrays.asList(0L), stapler.delays);
+        } finally {
+            stapler.stop();
+        }
+    }
+
+    @Test
+    public void testVerifiedResponseStapledAndRefreshed() throws Exception {
+        TestStapler stapler = new TestStapler(null);
+        byte[] good = goodResponse();
+        stapler.next = good;
+        stapler.refresh();
+        assertEquals(1, stapler.recorder.responses.size());
+        assertArrayEquals(good, stapler.recorder.responses.get(0));
+        assertEquals(Arrays.asList(INTERVAL), stapler.delays);
+    }
+
+    @Test
+    public void testFailedFetchRetried() throws Exception {
+        TestStapler stapler = new TestStapler(null);
+        stapler.next = new IOException("connection refused");
+        stapler.refresh();
+        assertTrue(stapler.recorder.responses.isEmpty());
+        assertEquals(Arrays.asList(OCSPStapler.RETRY_INTERVAL),
+                stapler.delays);
+    }
+
+    @Test
+    public void testRejectedResponseKeepsCurrent() throws Exception {
+        TestStapler stapler = new TestStapler(null);
+        stapler.next = goodResponse();
+        stapler.refresh();
+        long now = System.currentTimeMillis();
+        stapler.next = response(GOOD, now - 60000, now + DAY, leafKey);
+        stapler.refresh();
+        assertEquals("current response still verifies",
+                1, stapler.recorder.responses.size());
+        assertEquals(Arrays.asList(INTERVAL, OCSPStapler.RETRY_INTERVAL),
+                stapler.delays);
+    }
+
+    @Test
+    public void testExpiredResponseWithdrawn() throws Exception {
+        TestStapler stapler = new TestStapler(null);
+        stapler.next = goodResponse();
+        stapler.refresh();
+        stapler.expired = true;
+        stapler.next = new IOException("connection refused");
+        stapler.refresh();
+        assertEquals(2, stapler.recorder.responses.size());
+        assertNull(stapler.recorder.responses.get(1));
+        assertEquals(Arrays.asList(INTERVAL, OCSPStapler.RETRY_INTERVAL),
+                stapler.delays);
+    }
+
+    @Test
+    public void testCachedResponseDelaysFirstFetch() throws Exception {
+        Path cache = dir.resolve("cache");
+        TestStapler first = new TestStapler(cache);
+        byte[] good = goodResponse();
+        first.next = good;
+        first.refresh();
+
+        TestStapler second = new TestStapler(cache);
+        assertArrayEquals(good, second.loadCached());
+        second.start();
+        try {
+            assertEquals(Arrays.asList(INTERVAL), second.delays);
+        } finally {
+            second.stop();
+        }
+    }
+
+    @Test
+    public void testExpiredCachedResponseIgnored() throws Exception {
+        Path cache = dir.resolve("expired-cache");
+        Files.createDirectories(cache);
+        long now = System.currentTimeMillis();
+        byte[] expired = response(GOOD, now - 3 * DAY, now - 2 * DAY, caKey);
+        Files.write(cache.resolve(hex(MessageDigest.getInstance("SHA-256")
+                .digest(leafCert.getEncoded())) + ".der"), expired);
+        TestStapler stapler = new TestStapler(cache);
+        assertNull(stapler.loadCached());
+        stapler.start();
+        try {
+            assertEquals(Arrays.asList(0L), stapler.delays);
+        } finally {
+            stapler.stop();
+        }
+    }
+
+    // ── Lifecycle ──
+
+    @Test
+    public void testStartAndStop() throws Exception {
+        OCSPStapler stapler = newStapler();
+        assertFalse(stapler.isStarted());
+        stapler.start();
+        assertTrue(stapler.isStarted());
+        stapler.stop();
+        assertFalse(stapler.isStarted());
+    }
+
+    /**
+     * A reload that loses to stop() stops its new stapler, possibly
+     * before the reload gets round to starting it: it must stay stopped.
+     */
+    @Test
+    public void testStartAfterStopIgnored() throws Exception {
+        OCSPStapler stapler = newStapler();
+        stapler.stop();
+        stapler.start();
+        assertFalse(stapler.isStarted());
+    }
+
+    @Test
+    public void testStopIdempotent() throws Exception {
+        OCSPStapler stapler = newStapler();
+        stapler.start();
+        stapler.stop();
+        stapler.stop();
+        stapler.start();
+        assertFalse(stapler.isStarted());
+    }
+
+    @Test(expected = IOException.class)
+    public void testChainWithoutIssuerRejected() throws Exception {
+        Path single = dir.resolve("single.pem");
+        List<String> lines = Files.readAllLines(chain);
+        int end = lines.indexOf("-----END CERTIFICATE-----");
+        Files.write(single, lines.subList(0, end + 1));
+        new OCSPStapler(single, null, null, 60000L, new Recorder());
+    }
+
+    // ── Helpers ──
+
+    static final byte[] GOOD = { (byte) 0x80, 0x00 };
+
+    static OCSPStapler newStapler() throws Exception {
+        return new OCSPStapler(chain, null, null, 60000L, new Recorder());
+    }
+
+    static byte[] goodResponse() throws Exception {
+        long now = System.currentTimeMillis();
+        return response(GOOD, now - 60000, now + DAY, caKey);
+    }
+
+    /**
+     * Builds a successful OCSPResponse (RFC 6960 section 4.2.1) with one
+     * SingleResponse for the leaf, signed by the given key on behalf of
+     * the CA.
+     */
+    static byte[] response(byte[] certStatus, long thisUpdate,
+                           long nextUpdate, PrivateKey signer)
+            throws Exception {
+        byte[] single = der(0x30, certId(), certStatus,
+                der(0x18, time(thisUpdate)),
+                der(0xa0, der(0x18, time(nextUpdate))));
+        byte[] responseData = der(0x30,
+                der(0xa1, caCert.getSubjectX500Principal().getEncoded()),
+                der(0x18, time(System.currentTimeMillis())),
+                der(0x30, single));
+        Signature sig = Signature.getInstance("SHA256withECDSA");
+        sig.initSign(signer);
+        sig.update(responseData);
+        byte[] signature = sig.sign();
+        byte[] bits = new byte[signature.length + 1];
+        System.arraycopy(signature, 0, bits, 1, signature.length);
+        byte[] basic = der(0x30, responseData,
+                der(0x30, der(0x06, ECDSA_SHA256)),
+                der(0x03, bits));
+        return der(0x30, der(0x0a, new byte[] { 0 }),
+                der(0xa0, der(0x30, der(0x06, OCSP_BASIC),
+                        der(0x04, basic))));
+    }
+
+    static byte[] certId() throws Exception {
+        MessageDigest sha1 = MessageDigest.getInstance("SHA-1");
+        byte[] nameHash = sha1.digest(
+                caCert.getSubjectX500Principal().getEncoded());
+        // SubjectPublicKeyInfo { algorithm, subjectPublicKey BIT STRING }
+        byte[] spki = caCert.getPublicKey().getEncoded();
+        int[] seq = element(spki, 0);
+        int[] algorithm = element(spki, seq[1]);
+        int[] bits = element(spki, algorithm[1] + algorithm[2]);
+        byte[] keyHash = sha1.digest(Arrays.copyOfRange(spki,
+                bits[1] + 1, bits[1] + bits[2]));
+        return der(0x30, der(0x30, SHA1),
+                der(0x04, nameHash),
+                der(0x04, keyHash),
+                der(0x02, leafCert.getSerialNumber().toByteArray()));
+    }
+
+    static byte[] time(long millis) {
+        SimpleDateFormat format = new SimpleDateFormat("yyyyMMddHHmmss'Z'");
+        format.setTimeZone(TimeZone.getTimeZone("UTC"));
+        return format.format(new Date(millis)).getBytes();
+    }
+
+    /** Returns the tag, content offset and content length. */
+    static int[] element(byte[] der, int off) {
+        int len = der[off + 1] & 0xff;
+        int pos = off + 2;
+        if (len > 0x7f) {
+            int n = len & 0x7f;
+            len = 0;
+            for (int i = 0; i < n; i++) {
+                len = (len << 8) | (der[pos++] & 0xff);
+            }
+        }
+        return new int[] { der[off] & 0xff, pos, len };
+    }
+
+    static byte[] der(int tag, byte[]... contents) {
+        ByteArrayOutputStream body = new ByteArrayOutputStream();
+        for (byte[] content : contents) {
+            body.write(content, 0, content.length);
+        }
+        int len = body.size();
+        ByteArrayOutputStream out = new ByteArrayOutputStream();
+        out.write(tag);
+        if (len < 0x80) {
+            out.write(len);
+        } else if (len < 0x100) {
+            out.write(0x81);
+            out.write(len);
+        } else {
+            out.write(0x82);
+            out.write(len >> 8);
+            out.write(len);
+        }
+        byte[] bytes = body.toByteArray();
+        out.write(bytes, 0, bytes.length);
+        return out.toByteArray();
+    }
+
+    static void delete(File file) {
+        File[] files = file.listFiles();
+        if (files != null) {
+            for (File child : files) {
+                delete(child);
+            }
+        }
+        file.delete();
+    }
+
+    static String hex(byte[] bytes) {
+        StringBuilder buf = new StringBuilder(bytes.length * 2);
+        for (byte b : bytes) {
+            buf.append(Character.forDigit((b >> 4) & 0xf, 16));
+            buf.append(Character.forDigit(b & 0xf, 16));
+        }
+        return buf.toString();
+    }
+
+    /**
+     * A stapler whose responder returns {@link #next} and whose timer
+     * only records the delays asked for.
+     */
+    static class TestStapler extends OCSPStapler {
+
+        final Recorder recorder;
+        final List<Long> delays = new ArrayList<Long>();
+        final List<byte[]> requests = new ArrayList<byte[]>();
+        Object next;
+        boolean expired;
+
+        TestStapler(Path cacheDirectory) throws Exception {
+            this(cacheDirectory, new Recorder());
+        }
+
+        private TestStapler(Path cacheDirectory, Recorder recorder)
+                throws Exception {
+            super(chain, "http://127.0.0.1:9/override", cacheDirectory,
+                    INTERVAL, recorder);
+            this.recorder = recorder;
+        }
+
+        @Override
+        synchronized void schedule(long delay) {
+            delays.add(delay);
+        }
+
+        @Override
+        byte[] fetch(byte[] request) throws IOException {
+            requests.add(request);
+            if (next instanceof IOException) {
+                throw (IOException) next;
+            }
+            return (byte[]) next;
+        }
+
+        @Override
+        boolean verify(byte[] der) {
+            return !expired && super.verify(der);
+        }
+    }
+
+    static void keytool(String... args) throws Exception {
+        List<String> command = new ArrayList<String>();
+        command.add("keytool");
+        command.addAll(Arrays.asList(args));
+        command.addAll(Arrays.asList("-storetype", "PKCS12",
+                "-keystore", keystore.toString(),
+                "-storepass", PASSWORD, "-noprompt"));
+        ProcessBuilder pb = new ProcessBuilder(command);
+        pb.redirectErrorStream(true);
+        Process proc = pb.start();
+        byte[] output = proc.getInputStream().readAllBytes();
+        int exit = proc.waitFor();
+        if (exit != 0) {
+            throw new RuntimeException("keytool " + args[0]
+                    + " failed with exit " + exit + ": "
+                    + new String(output));
+        }
+    }
+
+    static class Recorder implements OCSPStapler.Listener {
+
+        final List<byte[]> responses = new ArrayList<byte[]>();
+
+        @Override
+        public synchronized void ocspResponseChanged(OCSPStapler source,
+                                                     byte[] response) {
+            responses.add(response);
+        }
+    }
+
+}
@@ -0,0 +1,115 @@
+/*
+ * QuicEngineTest.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+import java.net.InetAddress;
+import java.net.InetSocketAddress;
+import java.nio.ByteBuffer;
+
+import org.junit.Test;
+
+import static org.junit.Assert.*;
+
+/**
+ * Unit tests for the {@link QuicEngine} address encoding shared with the
+ * JNI layer, through which quiche reports the path of each packet
+ * (RFC 9000 section 9), and for the framing of packets forwarded to a
+ * previous process during a graceful upgrade.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ */
+public class QuicEngineTest {
+
+    @Test
+    public void testIPv4AddressRoundTrip() throws Exception {
+        InetSocketAddress addr = new InetSocketAddress(
+                InetAddress.getByName("192.0.2.7"), 40443);
+        byte[] encoded = QuicEngine.encodeAddress(addr);
+        assertEquals(7, encoded.length);
+        assertEquals(addr, QuicEngine.decodeAddress(encoded));
+    }
+
+    @Test
+    public void testIPv6AddressRoundTrip() throws Exception {
+        InetSocketAddress addr = new InetSocketAddress(
+                InetAddress.getByName("2001:db8::7"), 443);
+        byte[] encoded = QuicEngine.encodeAddress(addr);
+        assertEquals(19, encoded.length);
+        assertEquals(addr, QuicEngine.decodeAddress(encoded));
+    }
+
+    @Test
+    public void testDecodeIgnoresTrailingBytes() throws Exception {
+        InetSocketAddress addr = new InetSocketAddress(
+                InetAddress.getByName("192.0.2.7"), 40443);
+        byte[] scratch = new byte[19];
+        byte[] encoded = QuicEngine.encodeAddress(addr);
+        System.arraycopy(encoded, 0, scratch, 0, encoded.length);
+        scratch[18] = 42; // left over from an earlier IPv6 address
+        assertEquals(addr, QuicEngine.decodeAddress(scratch));
+    }
+
+    @Test
+    public void testUnknownFamily() {
+        assertNull(QuicEngine.decodeAddress(new byte[19]));
+    }
+
+    @Test
+    public void testForwardedDatagramRoundTrip() throws Exception {
+        InetSocketAddress source = new InetSocketAddress(
+                InetAddress.getByName("2001:db8::7"), 50001);
+        ByteBuffer buf = ByteBuffer.allocate(64);
+        for (int i = 0; i < 10; i++) {
+            buf.put((byte) (0x40 + i));
+        }
+        assertTrue(QuicEngine.appendSource(buf, 10,
+                QuicEngine.encodeAddress(source)));
+        assertEquals(0, buf.position());
+        assertEquals(10 + 19 + 1, buf.limit());
+
+        assertEquals(source, QuicEngine.unwrapForwarded(buf));
+        // The packet is left where the native layer reads it
+        assertEquals(0, buf.position());
+        assertEquals(10, buf.limit());
+        assertEquals(0x40, buf.get(0));
+        assertEquals(0x49, buf.get(9));
+    }
+
+    @Test
+    public void testForwardedDatagramTooLarge() throws Exception {
+        byte[] addr = QuicEngine.encodeAddress(new InetSocketAddress(
+                InetAddress.getByName("192.0.2.7"), 40443));
+        ByteBuffer buf = ByteBuffer.allocate(16);
+        assertFalse(QuicEngine.appendSource(buf, 9, addr));
+        assertTrue(QuicEngine.appendSource(buf, 8, addr));
+    }
+
+    @Test
+    public void testMalformedForwardedDatagram() {
+        ByteBuffer buf = ByteBuffer.allocate(8);
+        buf.put(new byte[] { 0x40, 0x41, 0x42, 4, 0, 1, 127, 7 }).flip();
+        // Length byte claims 7 bytes, but they are not an IPv4 address
+        assertNull(QuicEngine.unwrapForwarded(buf));
+        assertNull(QuicEngine.unwrapForwarded(ByteBuffer.allocate(0)));
+    }
+
+}
@@ -0,0 +1,103 @@
+/*
+ * QuicLbConnectionIdGeneratorTest.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+import java.util.Arrays;
+
+import org.junit.Test;
+
+import static org.junit.Assert.*;
+
+/**
+ * Unit tests for {@link QuicLbConnectionIdGenerator} with the server ID
+ * in the clear; encryption needs the native library.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ */
+public class QuicLbConnectionIdGeneratorTest {
+
+    @Test
+    public void testLayout() {
+        QuicLbConnectionIdGenerator generator =
+                new QuicLbConnectionIdGenerator();
+        generator.setConfigId(2);
+        generator.setServerId("0a0b0c");
+        generator.setNonceLength(6);
+        assertEquals(10, generator.getLength());
+
+        byte[] cid = generator.generate();
+        assertEquals(10, cid.length);
+        // config rotation bits, then the length minus one
+        assertEquals((2 << 5) | 9, cid[0] & 0xff);
+        assertEquals(0x0a, cid[1]);
+        assertEquals(0x0b, cid[2]);
+        assertEquals(0x0c, cid[3]);
+    }
+
+    @Test
+    public void testDefaultNonceFillsTwentyBytes() {
+        QuicLbConnectionIdGenerator generator =
+                new QuicLbConnectionIdGenerator();
+        generator.setServerId("01");
+        assertEquals(20, generator.getLength());
+        assertEquals(20, generator.generate().length);
+    }
+
+    @Test
+    public void testNoncesDiffer() {
+        QuicLbConnectionIdGenerator generator =
+                new QuicLbConnectionIdGenerator();
+        generator.setServerId("0102");
+        assertFalse(Arrays.equals(generator.generate(),
+                generator.generate()));
+    }
+
+    @Test(expected = IllegalStateException.class)
+    public void testServerIdRequired() {
+        new QuicLbConnectionIdGenerator().getLength();
+    }
+
+    @Test(expected = IllegalStateException.class)
+    public void testTooLong() {
+        QuicLbConnectionIdGenerator generator =
+                new QuicLbConnectionIdGenerator();
+        generator.setServerId("0102030405060708090a0b0c0d0e0f");
+        generator.setNonceLength(5);
+        generator.getLength();
+    }
+
+    @Test(expected = IllegalArgumentException.class)
+    public void testUnroutableConfigIdRejected() {
+        new QuicLbConnectionIdGenerator().setConfigId(7);
+    }
+
+    @Test(expected = IllegalArgumentException.class)
+    public void testShortNonceRejected() {
+        new QuicLbConnectionIdGenerator().setNonceLength(3);
+    }
+
+    @Test(expected = IllegalArgumentException.class)
+    public void testKeyLengthChecked() {
+        new QuicLbConnectionIdGenerator().setKey("0011");
+    }
+
+}
@@ -21,6 +21,10 @@
 
 package org.bluezoo.gumdrop.quic;
 
+import java.net.InetAddress;
+import java.util.LinkedHashMap;
+import java.util.Map;
+
 import org.junit.Test;
 
 import static org.junit.Assert.*;
@@ -56,4 +60,153 @@ public class QuicTransportFactoryTest {
         assertFalse("0-RTT should be disabled after toggle",
                 factory.isEarlyDataEnabled());
     }
+
+    /**
+     * RFC 8879 section 7.3: full handshakes are counted by algorithm ID.
+     */
+    @Test
+    public void testCertificateCompressionCounts() {
+        QuicTransportFactory factory = new QuicTransportFactory();
+        factory.recordCertificateCompression(0);
+        factory.recordCertificateCompression(
+                QuicTransportFactory.CERT_COMPRESSION_BROTLI);
+        factory.recordCertificateCompression(
+                QuicTransportFactory.CERT_COMPRESSION_BROTLI);
+        factory.recordCertificateCompression(
+                QuicTransportFactory.CERT_COMPRESSION_ZLIB);
+        assertEquals(1, factory.getUncompressedHandshakeCount());
+        assertEquals(2, factory.getCompressedHandshakeCount("brotli"));
+        assertEquals(1, factory.getCompressedHandshakeCount("zlib"));
+        assertEquals(0, factory.getCompressedHandshakeCount("zstd"));
+    }
+
+    @Test(expected = IllegalArgumentException.class)
+    public void testUnknownCertificateCompressionRejected() {
+        new QuicTransportFactory().setCertificateCompression("brotli,zstd");
+    }
+
+    @Test
+    public void testMaxUdpPayloadSize() {
+        QuicTransportFactory factory = new QuicTransportFactory();
+        assertEquals(1350, factory.getMaxUdpPayloadSize());
+        factory.setMaxUdpPayloadSize(8952);
+        assertEquals(8952, factory.getMaxUdpPayloadSize());
+    }
+
+    @Test(expected = IllegalArgumentException.class)
+    public void testMaxUdpPayloadSizeBelowQuicMinimumRejected() {
+        new QuicTransportFactory().setMaxUdpPayloadSize(1199);
+    }
+
+    @Test
+    public void testFlowControlWindowCeilings() {
+        QuicTransportFactory factory = new QuicTransportFactory();
+        assertEquals(24L << 20, factory.getMaxConnectionWindow());
+        assertEquals(16L << 20, factory.getMaxStreamWindow());
+        factory.setMaxConnectionWindow(64L << 20);
+        factory.setMaxStreamWindow(32L << 20);
+        assertEquals(64L << 20, factory.getMaxConnectionWindow());
+        assertEquals(32L << 20, factory.getMaxStreamWindow());
+    }
+
+    @Test
+    public void testReceiveTimestampsOffByDefault() {
+        QuicTransportFactory factory = new QuicTransportFactory();
+        assertFalse(factory.isReceiveTimestamps());
+        assertNull(factory.getReceiveDelayListener());
+        ReceiveDelayListener listener = new ReceiveDelayListener() {
+            @Override
+            public void receiveDelay(long nanos) {
+            }
+        };
+        factory.setReceiveTimestamps(true);
+        factory.setReceiveDelayListener(listener);
+        assertTrue(factory.isReceiveTimestamps());
+        assertSame(listener, factory.getReceiveDelayListener());
+    }
+
+    @Test
+    public void testNativeMemoryLimit() {
+        QuicTransportFactory factory = new QuicTransportFactory();
+        assertEquals(0, factory.getNativeMemoryLimit());
+        assertFalse(factory.isNativeMemoryExhausted());
+        assertFalse(QuicTransportFactory.exceeds(Long.MAX_VALUE, 0, 100));
+        assertFalse(QuicTransportFactory.exceeds(799, 1000, 80));
+        assertTrue(QuicTransportFactory.exceeds(800, 1000, 80));
+        assertFalse(QuicTransportFactory.exceeds(999, 1000, 100));
+        assertTrue(QuicTransportFactory.exceeds(1000, 1000, 100));
+    }
+
+    /**
+     * Limits below 100 bytes must not round the threshold down to 0, and
+     * limits near Long.MAX_VALUE must not overflow.
+     */
+    @Test
+    public void testNativeMemoryThresholdPrecision() {
+        assertFalse(QuicTransportFactory.exceeds(0, 50, 80));
+        assertFalse(QuicTransportFactory.exceeds(39, 50, 80));
+        assertTrue(QuicTransportFactory.exceeds(40, 50, 80));
+        assertFalse(QuicTransportFactory.exceeds(49, 50, 100));
+        assertTrue(QuicTransportFactory.exceeds(50, 50, 100));
+        long big = Long.MAX_VALUE - 1;
+        assertFalse(QuicTransportFactory.exceeds(big / 2, big, 80));
+        assertTrue(QuicTransportFactory.exceeds(big / 10 * 9, big, 80));
+        assertTrue(QuicTransportFactory.exceeds(Long.MAX_VALUE, big, 100));
+    }
+
+    @Test
+    public void testNativeMemoryUsageExcludesStartingHeap() {
+        // 40 MB of heap, 1 MB of it the JNI layer's, when the engine opened
+        long start = 40000000L - 1000000L;
+        assertEquals(1000000L,
+                NativeMemory.usage(40000000L, start, 1000000L, 0));
+        assertEquals(6000000L,
+                NativeMemory.usage(45000000L, start, 2000000L, 0));
+        assertEquals("heap unknown", 3000L,
+                NativeMemory.usage(-1, -1, 1000L, 2000L));
+        assertEquals("heap shrank below the start", 5000L,
+                NativeMemory.usage(30000000L, start, 5000L, 0));
+    }
+
+    /**
+     * The usage seen by the factory is what the thresholds apply to.
+     */
+    @Test
+    public void testNativeMemoryThresholds() {
+        final long[] usage = new long[1];
+        QuicTransportFactory factory = new QuicTransportFactory() {
+            @Override
+            long getNativeMemoryUsage() {
+                return usage[0];
+            }
+        };
+        factory.setNativeMemoryLimit(1000);
+        usage[0] = 799;
+        assertFalse(factory.isNativeMemoryConstrained());
+        usage[0] = 800;
+        assertTrue(factory.isNativeMemoryConstrained());
+        assertFalse(factory.isNativeMemoryExhausted());
+        usage[0] = 1000;
+        assertTrue(factory.isNativeMemoryExhausted());
+    }
+
+    @Test
+    public void testCongestionProfileByNetwork() throws Exception {
+        QuicTransportFactory factory = new QuicTransportFactory();
+        Map<String, String> networks = new LinkedHashMap<String, String>();
+        networks.put("10.1.0.0/16", "bulk-bbr2");
+        networks.put("10.0.0.0/8", "datacenter");
+        factory.setCongestionProfileNetworks(networks);
+        assertSame(CongestionProfile.BULK_BBR2, factory.congestionProfileFor(
+                InetAddress.getByName("10.1.2.3")));
+        assertSame(CongestionProfile.DATACENTER, factory.congestionProfileFor(
+                InetAddress.getByName("10.2.0.1")));
+        assertNull(factory.congestionProfileFor(
+                InetAddress.getByName("192.0.2.1")));
+    }
+
+    @Test(expected = IllegalArgumentException.class)
+    public void testUnknownCongestionProfileRejected() {
+        new QuicTransportFactory().setCongestionProfile("bulk-vegas");
+    }
 }
@@ -0,0 +1,223 @@
+/*
+ * SessionTicketKeysTest.java
+ * Copyright (C) 2026 Chris Burdess
+ *
+ * This file is part of gumdrop, a multipurpose Java server.
+ * For more information please visit https://www.nongnu.org/gumdrop/
+ *
+ * gumdrop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gumdrop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with gumdrop.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+package org.bluezoo.gumdrop.quic;
+
+import java.nio.ByteBuffer;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+
+import org.junit.Before;
+import org.junit.Test;
+
+import static org.junit.Assert.*;
+
+/**
+ * Unit tests for {@link SessionTicketKeys} rotation and the merging of
+ * keys published by other nodes. No SSL_CTX is registered, so the key
+ * ring is inspected directly and no native code runs.
+ *
+ * @author <a href='mailto:dog@gnu.org'>Chris Burdess</a>
+ */
+public class SessionTicketKeysTest {
+
+    private static final long INTERVAL = 60000L;
+    private static final long T0 = 1000 * INTERVAL;
+    private static final int KEY = SessionTicketKeys.KEY_LENGTH;
+
+    private SessionTicketKeys keys;
+    private List<byte[]> published;
+
+    @Before
+    public void setUp() {
+        keys = new SessionTicketKeys();
+        keys.setRotationInterval(INTERVAL);
+        published = new ArrayList<byte[]>();
+        keys.setKeyShare(new SessionTicketKeys.KeyShare() {
+            @Override
+            public void publish(byte[] message) {
+                published.add(message);
+            }
+        });
+    }
+
+    @Test
+    public void testRotationKeepsPreviousKey() {
+        keys.rotate(T0);
+        byte[] first = key(keys.ring(), 0);
+        assertEquals(1, count(keys.ring()));
+
+        keys.rotate(T0 + INTERVAL);
+        byte[] ring = keys.ring();
+        assertEquals(2, count(ring));
+        assertFalse(Arrays.equals(first, key(ring, 0)));
+        assertArrayEquals("replaced key stays valid for decryption",
+                first, key(ring, 1));
+    }
+
+    @Test
+    public void testRotationWithinIntervalKeepsKey() {
+        keys.rotate(T0);
+        byte[] ring = keys.ring();
+        keys.rotate(T0 + INTERVAL / 2);
+        assertArrayEquals(ring, keys.ring());
+        assertEquals(1, published.size());
+    }
+
+    @Test
+    public void testExpiredKeysDropped() {
+        keys.rotate(T0);
+        byte[] first = key(keys.ring(), 0);
+        keys.rotate(T0 + INTERVAL);
+        keys.rotate(T0 + 2 * INTERVAL);
+        byte[] ring = keys.ring();
+        assertEquals(2, count(ring));
+        assertFalse(indexOf(ring, first) >= 0);
+    }
+
+    @Test
+    public void testEarlierRemoteKeyKeepsLocalForDecryption() {
+        keys.rotate(T0 + 100);
+        byte[] local = key(keys.ring(), 0);
+        byte[] remote = newKey(1);
+
+        keys.receive(entry(T0 / INTERVAL, T0, remote));
+        byte[] ring = keys.ring();
+        assertArrayEquals("earlier key wins the interval",
+                remote, key(ring, 0));
+        assertArrayEquals("tickets issued under the local key still redeem",
+                local, key(ring, 1));
+    }
+
+    @Test
+    public void testLaterRemoteKeyRetainedForDecryption() {
+        keys.rotate(T0);
+        byte[] local = key(keys.ring(), 0);
+        int before = published.size();
+
+        byte[] remote = newKey(2);
+        keys.receive(entry(T0 / INTERVAL, T0 + 100, remote));
+        byte[] ring = keys.ring();
+        assertArrayEquals("local key still encrypts", local, key(ring, 0));
+        assertTrue(indexOf(ring, remote) > 0);
+        assertEquals("losing node is sent our key",
+                before + 1, published.size());
+    }
+
+    @Test
+    public void testNextIntervalRemoteKeyAdopted() {
+        keys.rotate(T0);
+        byte[] local = key(keys.ring(), 0);
+        byte[] remote = newKey(3);
+
+        keys.receive(entry(T0 / INTERVAL + 1, T0 + INTERVAL, remote));
+        byte[] ring = keys.ring();
+        assertArrayEquals(remote, key(ring, 0));
+        assertArrayEquals(local, key(ring, 1));
+    }
+
+    @Test
+    public void testKnownKeyIgnored() {
+        keys.rotate(T0);
+        byte[] remote = newKey(4);
+        byte[] message = entry(T0 / INTERVAL, T0 + 100, remote);
+        keys.receive(message);
+        byte[] ring = keys.ring();
+        int before = published.size();
+
+        keys.receive(message);
+        assertArrayEquals(ring, keys.ring());
+        assertEquals("no reply for a key already held",
+                before, published.size());
+    }
+
+    @Test
+    public void testStaleRemoteKeyIgnored() {
+        keys.rotate(T0 + 2 * INTERVAL);
+        byte[] ring = keys.ring();
+        keys.receive(entry(T0 / INTERVAL, T0, newKey(5)));
+        assertArrayEquals(ring, keys.ring());
+    }
+
+    @Test
+    public void testRingBounded() {
+        keys.rotate(T0 + INTERVAL / 2);
+        for (int i = 0; i < 10; i++) {
+            keys.receive(entry(T0 / INTERVAL, T0 + INTERVAL - i,
+                    newKey(10 + i)));
+        }
+        assertEquals(SessionTicketKeys.MAX_KEYS, count(keys.ring()));
+    }
+
+    @Test
+    public void testMalformedMessageIgnored() {
+        keys.rotate(T0);
+        byte[] ring = keys.ring();
+        keys.receive(new byte[KEY + 3]);
+        assertArrayEquals(ring, keys.ring());
+    }
+
+    @Test
+    public void testPublishAllIncludesRetiredKeys() {
+        keys.rotate(T0);
+        keys.rotate(T0 + INTERVAL);
+        published.clear();
+        keys.publishAll();
+        assertEquals(1, published.size());
+        assertEquals(2 * (16 + KEY), published.get(0).length);
+    }
+
+    // ── Helpers ──
+
+    private static byte[] newKey(int seed) {
+        byte[] key = new byte[KEY];
+        Arrays.fill(key, (byte) seed);
+        return key;
+    }
+
+    private static byte[] entry(long epoch, long created, byte[] key) {
+        ByteBuffer buf = ByteBuffer.allocate(16 + KEY);
+        buf.putLong(epoch);
+        buf.putLong(created);
+        buf.put(key);
+        return buf.array();
+    }
+
+    private static int count(byte[] ring) {
+        assertEquals(0, ring.length % KEY);
+        return ring.length / KEY;
+    }
+
+    private static byte[] key(byte[] ring, int index) {
+        return Arrays.copyOfRange(ring, index * KEY, (index + 1) * KEY);
+    }
+
+    private static int indexOf(byte[] ring, byte[] key) {
+        for (int i = 0; i < count(ring); i++) {
+            if (Arrays.equals(key, key(ring, i))) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+}
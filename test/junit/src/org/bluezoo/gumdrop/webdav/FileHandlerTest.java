@@ -37,6 +37,7 @@ import static org.junit.Assert.*;
 import java.io.ByteArrayOutputStream;
 import java.net.SocketAddress;
 import java.nio.ByteBuffer;
+import java.nio.channels.FileChannel;
 import java.nio.charset.StandardCharsets;
 import java.nio.file.Files;
 import java.nio.file.Path;
@@ -114,6 +115,12 @@ public class FileHandlerTest {
 
     private RecordingState dispatch(FileHandler h, String method, String path,
             Map<String, String> extraHeaders) throws Exception {
+        return dispatch(h, method, path, extraHeaders, new RecordingState());
+    }
+
+    private RecordingState dispatch(FileHandler h, String method, String path,
+            Map<String, String> extraHeaders, RecordingState st)
+            throws Exception {
         Headers req = new Headers();
         req.add(":method", method);
         req.add(":path", path);
@@ -122,7 +129,6 @@ public class FileHandlerTest {
                 req.add(e.getKey(), e.getValue());
             }
         }
-        RecordingState st = new RecordingState();
         h.headers(st, req);
         assertTrue("Response did not complete within timeout for "
                 + method + " " + path, st.await(5, TimeUnit.SECONDS));
@@ -162,6 +168,38 @@ public class FileHandlerTest {
         assertEquals(HELLO, new String(st.body(), StandardCharsets.UTF_8));
     }
 
+    @Test
+    public void testGetFileBodyHandedToTransport() throws Exception {
+        RecordingState st = dispatch(newHandler(true), "GET", "/hello.txt",
+                null, new RecordingState(true, true));
+        assertEquals(HTTPStatus.OK.code, st.status());
+        assertNotNull("file should be offered to the transport",
+                st.offeredFile);
+        assertEquals(0L, st.offeredPosition);
+        assertEquals(HELLO.length(), st.offeredCount);
+        assertEquals(HELLO, new String(st.body(), StandardCharsets.UTF_8));
+    }
+
+    @Test
+    public void testGetFileBodyDeclinedIsStreamed() throws Exception {
+        RecordingState st = dispatch(newHandler(true), "GET", "/hello.txt",
+                null, new RecordingState(true, false));
+        assertEquals(HTTPStatus.OK.code, st.status());
+        assertNotNull(st.offeredFile);
+        assertFalse("declined channel should be closed by the handler",
+                st.offeredFile.isOpen());
+        assertEquals(HELLO, new String(st.body(), StandardCharsets.UTF_8));
+    }
+
+    @Test
+    public void testHeadFileNotOffered() throws Exception {
+        RecordingState st = dispatch(newHandler(true), "HEAD", "/hello.txt",
+                null, new RecordingState(true, true));
+        assertEquals(HTTPStatus.OK.code, st.status());
+        assertNull(st.offeredFile);
+        assertEquals(0, st.body().length);
+    }
+
     @Test
     public void testGetDirectoryListing() throws Exception {
         RecordingState st = dispatch(newHandler(true), "GET", "/", null);
@@ -303,6 +341,25 @@ public class FileHandlerTest {
         private final CountDownLatch done = new CountDownLatch(1);
         private Headers responseHeaders;
         private int statusCode = -1;
+        private final boolean fileBodySupported;
+        private final boolean acceptFileBody;
+        volatile FileChannel offeredFile;
+        volatile long offeredPosition = -1;
+        volatile long offeredCount = -1;
+
+        RecordingState() {
+            this(false, false);
+        }
+
+        /**
+         * @param fileBodySupported what isFileBodySupported() reports
+         * @param acceptFileBody whether responseBodyFile() accepts the
+         *        range, reading it into the body as a transport would
+         */
+        RecordingState(boolean fileBodySupported, boolean acceptFileBody) {
+            this.fileBodySupported = fileBodySupported;
+            this.acceptFileBody = acceptFileBody;
+        }
 
         boolean await(long t, TimeUnit u) throws InterruptedException {
             return done.await(t, u);
@@ -354,6 +411,34 @@ public class FileHandlerTest {
             }
         }
 
+        @Override
+        public boolean isFileBodySupported() {
+            return fileBodySupported;
+        }
+
+        @Override
+        public boolean responseBodyFile(FileChannel file, long position,
+                long count) {
+            offeredFile = file;
+            offeredPosition = position;
+            offeredCount = count;
+            if (!acceptFileBody) {
+                return false;
+            }
+            try {
+                ByteBuffer buf = ByteBuffer.allocate((int) count);
+                while (buf.hasRemaining()
+                        && file.read(buf, position + buf.position()) > 0) {
+                }
+                buf.flip();
+                responseBodyContent(buf);
+                file.close();
+            } catch (java.io.IOException e) {
+                throw new AssertionError(e);
+            }
+            return true;
+        }
+
         @Override
         public void endResponseBody() {
         }